@@ -0,0 +1,23 @@
+/*
+BenchHelpers.cpp
+
+Author:			Chris Serson
+Last Edited:	October 19, 2026
+
+Description:	Helpers shared by the benchmarks that time reading files.
+*/
+#include "BenchHelpers.h"
+#include <fstream>
+
+// Returns the value at fraction p of the sorted list, or 0 if it is empty.
+double CalcPercentile(const std::vector<double>& sorted, double p) {
+	if (sorted.empty()) return 0.0;
+	return sorted[(size_t)(p * (sorted.size() - 1) + 0.5)];
+}
+
+// Read all of fn once so every page of it is cached.
+void WarmPageCache(const char* fn) {
+	std::ifstream file(fn, std::ios::binary);
+	std::vector<char> buffer(1 << 20);
+	while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {}
+}
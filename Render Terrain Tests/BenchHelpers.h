@@ -0,0 +1,19 @@
+/*
+BenchHelpers.h
+
+Author:			Chris Serson
+Last Edited:	October 19, 2026
+
+Description:	Helpers shared by the benchmarks that time reading files.
+
+Usage:			- CalcPercentile() picks a percentile out of a sorted list of timings.
+				- WarmPageCache() reads a whole file once so it is timed from a warm page cache.
+*/
+#pragma once
+
+#include <vector>
+
+// Returns the value at fraction p of the sorted list, or 0 if it is empty.
+double CalcPercentile(const std::vector<double>& sorted, double p);
+// Read all of fn once so every page of it is cached.
+void WarmPageCache(const char* fn);
@@ -0,0 +1,228 @@
+/*
+CollisionMeshTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests collision chunks against a line by line transcription of RenderTerrainTessDS.hlsl, and the
+				chunks CollisionMeshCache keeps around moving bodies.
+*/
+#include "Test.h"
+#include "CollisionMesh.h"
+#include "SyntheticTerrain.h"
+#include <cstring>
+
+// A texture and the address mode of the sampler reading it, as in the shader.
+struct ShaderTexture {
+	const unsigned char*	data;
+	unsigned int			width;
+	unsigned int			height;
+	unsigned int			channel;		// x = 0, w = 3.
+	bool					isWrap;			// D3D12_TEXTURE_ADDRESS_MODE_WRAP, otherwise CLAMP.
+};
+
+// Returns texel (x, y) of tex after applying its address mode.
+static float LoadTexel(const ShaderTexture& tex, int x, int y) {
+	int w = (int)tex.width, h = (int)tex.height;
+	if (tex.isWrap) {
+		x = ((x % w) + w) % w;
+		y = ((y % h) + h) % h;
+	} else {
+		x = x < 0 ? 0 : x >= w ? w - 1 : x;
+		y = y < 0 ? 0 : y >= h ? h - 1 : y;
+	}
+	return tex.data[((size_t)y * w + x) * 4 + tex.channel] / 255.0f;
+}
+
+// Texture2D.SampleLevel() with a linear filter at mip 0.
+static float SampleLevel(const ShaderTexture& tex, float u, float v) {
+	float tx = u * tex.width - 0.5f;
+	float ty = v * tex.height - 0.5f;
+	int x = (int)floorf(tx), y = (int)floorf(ty);
+	float fx = tx - floorf(tx), fy = ty - floorf(ty);
+	float top = LoadTexel(tex, x, y) * (1.0f - fx) + LoadTexel(tex, x + 1, y) * fx;
+	float bottom = LoadTexel(tex, x, y + 1) * (1.0f - fx) + LoadTexel(tex, x + 1, y + 1) * fx;
+	return top * (1.0f - fy) + bottom * fy;
+}
+
+// estimateNormal() from RenderTerrainTessDS.hlsl. width and depth are the heightmap's.
+static XMFLOAT3 EstimateNormalShader(const ShaderTexture& heightmap, float scale, float u, float v) {
+	float width = (float)heightmap.width;
+	float depth = (float)heightmap.height;
+	float zb = SampleLevel(heightmap, u + 0.0f, v - 0.3f / depth) * scale;
+	float zc = SampleLevel(heightmap, u + 0.3f / width, v - 0.3f / depth) * scale;
+	float zd = SampleLevel(heightmap, u + 0.3f / width, v + 0.0f) * scale;
+	float ze = SampleLevel(heightmap, u + 0.3f / width, v + 0.3f / depth) * scale;
+	float zf = SampleLevel(heightmap, u + 0.0f, v + 0.3f / depth) * scale;
+	float zg = SampleLevel(heightmap, u - 0.3f / width, v + 0.3f / depth) * scale;
+	float zh = SampleLevel(heightmap, u - 0.3f / width, v + 0.0f) * scale;
+	float zi = SampleLevel(heightmap, u - 0.3f / width, v - 0.3f / depth) * scale;
+
+	float x = zg + 2 * zh + zi - zc - 2 * zd - ze;
+	float y = 2 * zb + zc + zi - ze - 2 * zf - zg;
+	float z = 8.0f;
+	float len = sqrtf(x * x + y * y + z * z);
+	return XMFLOAT3(x / len, y / len, z / len);
+}
+
+// The domain shader's worldpos for the point (x, y) on an inner patch, which isn't part of a skirt.
+static XMFLOAT3 DisplaceShader(const ShaderTexture& heightmap, const ShaderTexture& displacementmap, float scale, float x, float y) {
+	XMFLOAT3 worldpos(x, y, 0.0f);
+	float u = worldpos.x / heightmap.width;
+	float v = worldpos.y / heightmap.width;
+	worldpos.z = SampleLevel(heightmap, u, v) * scale;
+
+	XMFLOAT3 norm = EstimateNormalShader(heightmap, scale, u, v);
+	float d = 0.5f * (2.0f * SampleLevel(displacementmap, worldpos.x / 32, worldpos.y / 32) - 1.0f);
+	return XMFLOAT3(worldpos.x + norm.x * d, worldpos.y + norm.y * d, worldpos.z + norm.z * d);
+}
+
+// A wide heightmap, so mixing up the width and depth in the shader's sums shows, and a displacement map.
+struct TestTerrain {
+	std::vector<unsigned char>	heightmap;
+	std::vector<unsigned char>	displacementmap;
+	float						scale;
+
+	TestTerrain() {
+		BuildRollingHills(256, 3, heightmap);
+		heightmap.resize(256 * 128 * 4);
+		BuildNoiseDisplacement(64, displacementmap);
+		scale = 32.0f;
+	}
+};
+
+TEST(CollisionMesh, MatchesShader) {
+	TestTerrain terrain;
+	TerrainSurface surface(terrain.heightmap.data(), 256, 128, terrain.scale, terrain.displacementmap.data(), 64, 64);
+	ShaderTexture heightmap = { terrain.heightmap.data(), 256, 128, 0, false };
+	ShaderTexture displacementmap = { terrain.displacementmap.data(), 64, 64, 3, true };
+
+	int numX, numY;
+	CalcCollisionChunkCount(&surface, numX, numY);
+	CHECK(numX == 8 && numY == 4);
+
+	// an inner chunk and the corner chunk, which is cut short by the edge of the terrain, at every LOD.
+	for (unsigned int lod = 0; lod <= COLLISION_MAX_LOD; ++lod) {
+		CollisionChunk chunks[2];
+		chunks[0].x = 2;
+		chunks[0].y = 1;
+		chunks[1].x = numX - 1;
+		chunks[1].y = numY - 1;
+		chunks[0].lod = chunks[1].lod = lod;
+		BuildCollisionChunks(&surface, chunks, 2, 2);
+
+		float spacing = CalcCollisionSpacing(lod);
+		float errMax = 0.0f;
+		for (auto& chunk : chunks) {
+			int vertsX = (int)(fminf(COLLISION_CHUNK_SIZE, 248.0f - chunk.x * COLLISION_CHUNK_SIZE) / spacing + 0.5f) + 1;
+			int vertsY = (int)(fminf(COLLISION_CHUNK_SIZE, 120.0f - chunk.y * COLLISION_CHUNK_SIZE) / spacing + 0.5f) + 1;
+			REQUIRE(chunk.listVertices.size() == (size_t)vertsX * vertsY);
+			CHECK(chunk.listIndices.size() == (size_t)(vertsX - 1) * (vertsY - 1) * 6);
+
+			for (int row = 0; row < vertsY; ++row) {
+				for (int col = 0; col < vertsX; ++col) {
+					XMFLOAT3 expected = DisplaceShader(heightmap, displacementmap, terrain.scale, chunk.x * COLLISION_CHUNK_SIZE + col * spacing,
+						chunk.y * COLLISION_CHUNK_SIZE + row * spacing);
+					const XMFLOAT3& v = chunk.listVertices[(size_t)row * vertsX + col];
+					errMax = fmaxf(errMax, fmaxf(fabsf(v.x - expected.x), fmaxf(fabsf(v.y - expected.y), fabsf(v.z - expected.z))));
+					CHECK(v.x >= chunk.aabbmin.x && v.y >= chunk.aabbmin.y && v.z >= chunk.aabbmin.z);
+					CHECK(v.x <= chunk.aabbmax.x && v.y <= chunk.aabbmax.y && v.z <= chunk.aabbmax.z);
+				}
+			}
+		}
+		// only float rounding apart.
+		CHECK(errMax < 2e-4f);
+	}
+}
+
+TEST(CollisionMesh, TrianglesFaceUp) {
+	TestTerrain terrain;
+	TerrainSurface surface(terrain.heightmap.data(), 256, 128, terrain.scale, nullptr, 0, 0);
+
+	CollisionChunk chunk = {};
+	chunk.x = 3;
+	chunk.y = 2;
+	chunk.lod = 2;
+	BuildCollisionChunks(&surface, &chunk, 1, 1);
+
+	// counter-clockwise seen from above, so every triangle's normal points up.
+	unsigned int numDown = 0;
+	for (size_t i = 0; i + 2 < chunk.listIndices.size(); i += 3) {
+		const XMFLOAT3& a = chunk.listVertices[chunk.listIndices[i]];
+		const XMFLOAT3& b = chunk.listVertices[chunk.listIndices[i + 1]];
+		const XMFLOAT3& c = chunk.listVertices[chunk.listIndices[i + 2]];
+		float nz = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+		if (nz <= 0.0f) ++numDown;
+	}
+	CHECK(numDown == 0);
+}
+
+TEST(CollisionMesh, NeighboursShareEdges) {
+	TestTerrain terrain;
+	TerrainSurface surface(terrain.heightmap.data(), 256, 128, terrain.scale, terrain.displacementmap.data(), 64, 64);
+
+	// chunks built on one thread and on several, side by side and one above the other.
+	CollisionChunk chunks[3], chunksSerial[3];
+	int xy[3][2] = { { 1, 1 }, { 2, 1 }, { 1, 2 } };
+	for (int i = 0; i < 3; ++i) {
+		chunks[i].x = chunksSerial[i].x = xy[i][0];
+		chunks[i].y = chunksSerial[i].y = xy[i][1];
+		chunks[i].lod = chunksSerial[i].lod = 1;
+	}
+	BuildCollisionChunks(&surface, chunks, 3, 4);
+	BuildCollisionChunks(&surface, chunksSerial, 3, 1);
+	for (int i = 0; i < 3; ++i) {
+		REQUIRE(chunks[i].listVertices.size() == chunksSerial[i].listVertices.size());
+		CHECK(memcmp(chunks[i].listVertices.data(), chunksSerial[i].listVertices.data(), chunks[i].listVertices.size() * sizeof(XMFLOAT3)) == 0);
+		CHECK(chunks[i].listIndices == chunksSerial[i].listIndices);
+	}
+
+	// the right edge of chunk 0 is the left edge of chunk 1, and its top edge the bottom edge of chunk 2, exactly.
+	int n = (int)(COLLISION_CHUNK_SIZE / CalcCollisionSpacing(1) + 0.5f) + 1;
+	unsigned int numDifferent = 0;
+	for (int i = 0; i < n; ++i) {
+		const XMFLOAT3& right = chunks[0].listVertices[i * n + n - 1];
+		const XMFLOAT3& left = chunks[1].listVertices[i * n];
+		const XMFLOAT3& top = chunks[0].listVertices[(n - 1) * n + i];
+		const XMFLOAT3& bottom = chunks[2].listVertices[i];
+		if (right.x != left.x || right.y != left.y || right.z != left.z) ++numDifferent;
+		if (top.x != bottom.x || top.y != bottom.y || top.z != bottom.z) ++numDifferent;
+	}
+	CHECK(numDifferent == 0);
+}
+
+TEST(CollisionMesh, CacheFollowsBodies) {
+	TestTerrain terrain;
+	TerrainSurface surface(terrain.heightmap.data(), 256, 128, terrain.scale, nullptr, 0, 0);
+	CollisionMeshCache cache(&surface, 3, 1);
+
+	// a body in the middle of chunk (1, 1) with a reach of half a chunk only needs that chunk.
+	XMFLOAT3 body(1.5f * COLLISION_CHUNK_SIZE, 1.5f * COLLISION_CHUNK_SIZE, 0.0f);
+	cache.Update(&body, 1, 0.25f * COLLISION_CHUNK_SIZE);
+	CHECK(cache.GetNumChunks() == 1 && cache.GetChunk(1, 1));
+
+	// near a corner, it needs the four chunks around it.
+	body = XMFLOAT3(2.0f * COLLISION_CHUNK_SIZE - 1.0f, 2.0f * COLLISION_CHUNK_SIZE - 1.0f, 0.0f);
+	cache.Update(&body, 1, 0.25f * COLLISION_CHUNK_SIZE);
+	CHECK(cache.GetChunk(1, 1) && cache.GetChunk(2, 1) && cache.GetChunk(1, 2) && cache.GetChunk(2, 2));
+	CHECK(cache.GetStats().numBuilt == 4);
+
+	// moving on a chunk keeps the chunks within a chunk of its reach and drops the rest.
+	body = XMFLOAT3(0.5f * COLLISION_CHUNK_SIZE, 2.5f * COLLISION_CHUNK_SIZE, 0.0f);
+	cache.Update(&body, 1, 0.25f * COLLISION_CHUNK_SIZE);
+	CHECK(cache.GetChunk(0, 2) && cache.GetChunk(1, 1) && cache.GetChunk(1, 2));
+	CHECK(!cache.GetChunk(2, 1) && !cache.GetChunk(2, 2));
+
+	// moving far away drops them.
+	body = XMFLOAT3(7.5f * COLLISION_CHUNK_SIZE, 0.5f * COLLISION_CHUNK_SIZE, 0.0f);
+	cache.Update(&body, 1, 0.25f * COLLISION_CHUNK_SIZE);
+	CHECK(cache.GetNumChunks() == 1 && cache.GetChunk(7, 0));
+	CHECK(cache.GetStats().numDropped == 5);
+
+	// an edit drops the chunks it touches, and the next Update() builds them again.
+	cache.Invalidate(7.2f * COLLISION_CHUNK_SIZE, 0.2f * COLLISION_CHUNK_SIZE, 7.4f * COLLISION_CHUNK_SIZE, 0.4f * COLLISION_CHUNK_SIZE);
+	CHECK(cache.GetNumChunks() == 0);
+	cache.Update(&body, 1, 0.25f * COLLISION_CHUNK_SIZE);
+	CHECK(cache.GetChunk(7, 0));
+	CHECK(cache.GetStats().numBuilt == 7);
+}
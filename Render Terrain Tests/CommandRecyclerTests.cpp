@@ -0,0 +1,170 @@
+/*
+CommandRecyclerTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests CommandRecycler against a made up fence in place of a queue's ID3D12Fence.
+*/
+#include "Test.h"
+#include "CommandRecycler.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static const unsigned int TYPE_DIRECT = 0;
+static const unsigned int TYPE_COMPUTE = 1;
+
+// Stands in for a queue's fence. Signal() hands out the value the queue will reach once the work submitted so far is done,
+// and Complete() moves the GPU on to a value. Like a real fence, the completed value never goes back.
+struct FakeFence {
+	std::atomic<unsigned long long> valNext;
+	std::atomic<unsigned long long> valCompleted;
+
+	FakeFence() : valNext(0), valCompleted(0) {}
+	unsigned long long Signal() { return ++valNext; }
+	void Complete(unsigned long long val) {
+		unsigned long long valOld = valCompleted;
+		while (valOld < val && !valCompleted.compare_exchange_weak(valOld, val)) {}
+	}
+	unsigned long long GetCompletedValue() { return valCompleted; }
+};
+
+TEST(CommandRecycler, RecyclesOnceFencePasses) {
+	CommandRecycler recycler(2, 1);
+	FakeFence fence;
+
+	bool isNew;
+	unsigned int entry = recycler.Acquire(TYPE_DIRECT, 0, fence.GetCompletedValue(), isNew);
+	REQUIRE(entry != COMMAND_NO_ENTRY);
+	CHECK(isNew);
+	CHECK(recycler.GetState(entry) == COMMAND_ENTRY_RECORDING);
+
+	unsigned long long valFence = fence.Signal();
+	REQUIRE(recycler.Submit(entry, valFence));
+	CHECK(recycler.GetState(entry) == COMMAND_ENTRY_IN_FLIGHT);
+	CHECK(recycler.GetFenceValue(entry) == valFence);
+	CHECK(!recycler.Submit(entry, valFence));
+
+	// one short of the fence value, the entry is still in use, so a second one is created.
+	fence.Complete(valFence - 1);
+	unsigned int entry2 = recycler.Acquire(TYPE_DIRECT, 0, fence.GetCompletedValue(), isNew);
+	CHECK(entry2 != entry && isNew);
+	CHECK(recycler.GetState(entry) == COMMAND_ENTRY_IN_FLIGHT);
+	REQUIRE(recycler.Submit(entry2, fence.Signal()));
+
+	// at the fence value it comes back, and the later one stays in flight.
+	fence.Complete(valFence);
+	unsigned int entry3 = recycler.Acquire(TYPE_DIRECT, 0, fence.GetCompletedValue(), isNew);
+	CHECK(entry3 == entry && !isNew);
+	CHECK(recycler.GetState(entry2) == COMMAND_ENTRY_IN_FLIGHT);
+
+	// Recycle() frees the rest without acquiring.
+	REQUIRE(recycler.Submit(entry3, fence.Signal()));
+	CHECK(recycler.Recycle(TYPE_DIRECT, valFence) == 0);
+	fence.Complete(fence.valNext);
+	CHECK(recycler.Recycle(TYPE_DIRECT, fence.GetCompletedValue()) == 2);
+	CHECK(recycler.GetState(entry) == COMMAND_ENTRY_FREE && recycler.GetState(entry2) == COMMAND_ENTRY_FREE);
+
+	CommandRecyclerStats stats = recycler.GetStats();
+	CHECK(stats.numAcquired == 3 && stats.numRecycled == 1 && stats.numSubmitted == 3);
+	CHECK(stats.numEntries == 2 && stats.numInFlight == 0 && stats.numInFlightHighWater == 2);
+}
+
+TEST(CommandRecycler, DiscardFreesRightAway) {
+	CommandRecycler recycler(1, 1);
+	FakeFence fence;
+
+	bool isNew;
+	unsigned int entry = recycler.Acquire(TYPE_DIRECT, 0, fence.GetCompletedValue(), isNew);
+	REQUIRE(recycler.Discard(entry));
+	CHECK(recycler.GetState(entry) == COMMAND_ENTRY_FREE);
+	CHECK(!recycler.Discard(entry));
+	CHECK(!recycler.Submit(entry, fence.Signal()));
+
+	// a discarded entry never waits on the fence.
+	CHECK(recycler.Acquire(TYPE_DIRECT, 0, fence.GetCompletedValue(), isNew) == entry);
+	CHECK(!isNew);
+
+	// in flight entries can't be discarded.
+	REQUIRE(recycler.Submit(entry, fence.Signal()));
+	CHECK(!recycler.Discard(entry));
+	CHECK(!recycler.Discard(entry + 1));
+
+	CommandRecyclerStats stats = recycler.GetStats();
+	CHECK(stats.numDiscarded == 1 && stats.numEntries == 1);
+}
+
+TEST(CommandRecycler, KeepsThreadsAndTypesApart) {
+	CommandRecycler recycler(2, 3);
+	FakeFence fenceDirect, fenceCompute;
+
+	// one entry per type and thread, all done by the GPU.
+	unsigned int entries[2][3];
+	bool isNew;
+	for (unsigned int type = 0; type < 2; ++type) {
+		FakeFence& fence = type == TYPE_DIRECT ? fenceDirect : fenceCompute;
+		for (unsigned int thread = 0; thread < 3; ++thread) {
+			entries[type][thread] = recycler.Acquire(type, thread, fence.GetCompletedValue(), isNew);
+			CHECK(recycler.GetType(entries[type][thread]) == type && recycler.GetThread(entries[type][thread]) == thread);
+			REQUIRE(recycler.Submit(entries[type][thread], fence.Signal()));
+		}
+		fence.Complete(fence.valNext);
+	}
+
+	// every type and thread gets its own entry back, never another's.
+	for (unsigned int type = 0; type < 2; ++type) {
+		FakeFence& fence = type == TYPE_DIRECT ? fenceDirect : fenceCompute;
+		for (unsigned int thread = 0; thread < 3; ++thread) {
+			CHECK(recycler.Acquire(type, thread, fence.GetCompletedValue(), isNew) == entries[type][thread]);
+			CHECK(!isNew);
+		}
+	}
+
+	// a free entry on another thread isn't handed out.
+	REQUIRE(recycler.Discard(entries[TYPE_DIRECT][1]));
+	unsigned int entry = recycler.Acquire(TYPE_DIRECT, 0, fenceDirect.GetCompletedValue(), isNew);
+	CHECK(isNew && recycler.GetThread(entry) == 0);
+
+	CHECK(recycler.Acquire(2, 0, 0, isNew) == COMMAND_NO_ENTRY);
+	CHECK(recycler.Acquire(TYPE_COMPUTE, 3, 0, isNew) == COMMAND_NO_ENTRY);
+	CHECK(recycler.Recycle(2, ~0ull) == 0);
+}
+
+TEST(CommandRecycler, ManyRecordingThreads) {
+	static const unsigned int NUM_THREADS = 4;
+	static const unsigned int NUM_FRAMES = 2000;
+	static const unsigned long long FRAMES_IN_FLIGHT = 3;
+	CommandRecycler recycler(1, NUM_THREADS);
+	FakeFence fence;
+	std::atomic<unsigned int> numWrongThread(0);
+	std::atomic<unsigned int> numFailed(0);
+
+	// every thread records a list a frame, while the GPU falls up to FRAMES_IN_FLIGHT frames behind.
+	std::vector<std::thread> threads;
+	for (unsigned int t = 0; t < NUM_THREADS; ++t) {
+		threads.push_back(std::thread([&, t]() {
+			for (unsigned int f = 0; f < NUM_FRAMES; ++f) {
+				bool isNew;
+				unsigned int entry = recycler.Acquire(TYPE_DIRECT, t, fence.GetCompletedValue(), isNew);
+				if (recycler.GetThread(entry) != t) ++numWrongThread;
+				if (!recycler.Submit(entry, fence.Signal())) ++numFailed;
+				unsigned long long valNext = fence.valNext;
+				if (valNext > FRAMES_IN_FLIGHT * NUM_THREADS) fence.Complete(valNext - FRAMES_IN_FLIGHT * NUM_THREADS);
+			}
+		}));
+	}
+	for (auto& t : threads) t.join();
+
+	CHECK(numWrongThread == 0);
+	CHECK(numFailed == 0);
+
+	// once the GPU is done, everything comes back.
+	recycler.Recycle(TYPE_DIRECT, fence.valNext);
+	CommandRecyclerStats stats = recycler.GetStats();
+	CHECK(stats.numAcquired == NUM_THREADS * NUM_FRAMES && stats.numSubmitted == NUM_THREADS * NUM_FRAMES);
+	CHECK(stats.numInFlight == 0);
+	CHECK(stats.numRecycled + stats.numEntries == stats.numAcquired);
+	// each thread only ever needs enough entries to cover the frames the GPU is behind, and then some for the race.
+	CHECK(stats.numEntries < NUM_THREADS * NUM_FRAMES / 10);
+}
@@ -0,0 +1,67 @@
+/*
+HeightfieldRayCastBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Times casting batches of rays against a synthetic heightmap one at a time, in packets, on every
+				hardware thread, and with displacement, against marching them.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+// Returns how many of n rays a second were cast between t0 and t1.
+static double CalcRaysPerSecond(unsigned int n, TimePoint t0, TimePoint t1) {
+	double seconds = std::chrono::duration<double>(t1 - t0).count();
+	return seconds > 0.0 ? (double)n / seconds : 0.0;
+}
+
+// --size=<texels> sets the size of the heightmap and --rays=<count> the size of the batch.
+BENCHMARK(HeightfieldRayCast, CastRays) {
+	unsigned int size = GetTestOption("size") ? (unsigned int)atoi(GetTestOption("size")) : 2048;
+	unsigned int numRays = GetTestOption("rays") ? (unsigned int)atoi(GetTestOption("rays")) : 1 << 16;
+	unsigned int numThreads = std::thread::hardware_concurrency();
+
+	std::vector<unsigned char> heightmap, displacementmap;
+	BuildRollingHills(size, 0, heightmap);
+	BuildNoiseDisplacement(64, displacementmap);
+	float scale = (float)size / 16.0f;
+	TerrainSurface surface(heightmap.data(), size, size, scale, displacementmap.data(), 64, 64);
+	HeightfieldRayCaster caster(&surface);
+
+	std::vector<HeightfieldRay> rays;
+	BuildTerrainRays(surface, size, scale, numRays, rays);
+
+	std::vector<HeightfieldHit> hits(numRays);
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < numRays; ++i) {
+		caster.CastRay(rays[i], false, hits[i]);
+	}
+	auto tSingle = std::chrono::high_resolution_clock::now();
+	caster.CastRays(rays.data(), numRays, false, 1, hits.data());
+	auto tPacket = std::chrono::high_resolution_clock::now();
+	caster.CastRays(rays.data(), numRays, false, numThreads, hits.data());
+	auto tParallel = std::chrono::high_resolution_clock::now();
+	caster.CastRays(rays.data(), numRays, true, numThreads, hits.data());
+	auto tDisplaced = std::chrono::high_resolution_clock::now();
+
+	// marching is far too slow for the whole batch, so only time an even spread of it.
+	unsigned int numMarched = 0;
+	for (unsigned int i = 0; i < numRays; i += numRays / 256 + 1, ++numMarched) {
+		HeightfieldHit hit;
+		caster.MarchRay(rays[i], false, 0.02f, hit);
+	}
+	auto tMarch = std::chrono::high_resolution_clock::now();
+
+	printf("  %u rays against %u x %u, %u threads.\n", numRays, size, size, numThreads);
+	printf("  single rays      %12.0f rays/s\n", CalcRaysPerSecond(numRays, tStart, tSingle));
+	printf("  packets          %12.0f rays/s\n", CalcRaysPerSecond(numRays, tSingle, tPacket));
+	printf("  packets, threads %12.0f rays/s\n", CalcRaysPerSecond(numRays, tPacket, tParallel));
+	printf("  displaced        %12.0f rays/s\n", CalcRaysPerSecond(numRays, tParallel, tDisplaced));
+	printf("  marching         %12.0f rays/s\n", CalcRaysPerSecond(numMarched, tDisplaced, tMarch));
+}
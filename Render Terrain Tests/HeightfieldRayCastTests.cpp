@@ -0,0 +1,131 @@
+/*
+HeightfieldRayCastTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests HeightfieldRayCaster against marching every ray in small steps, with and without displacement,
+				and packets of rays against single rays.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+
+static const unsigned int TEST_SIZE = 256;
+// marching steps in world units, and how far apart marched and cast hits may be.
+static const float MARCH_STEP = 0.02f;
+static const float MARCH_TOLERANCE = 0.05f;
+
+// Returns true if a and b both miss, or both hit within MARCH_TOLERANCE world units of each other.
+static bool IsMatch(const HeightfieldRay& ray, const HeightfieldHit& a, const HeightfieldHit& b) {
+	if (a.isHit != b.isHit) return false;
+	float len = sqrtf(ray.direction.x * ray.direction.x + ray.direction.y * ray.direction.y + ray.direction.z * ray.direction.z);
+	return !a.isHit || fabsf(a.t - b.t) * len <= MARCH_TOLERANCE;
+}
+
+// Cast rays through the pyramid and march them, and check they agree for all but one in maxMismatched of them.
+// Marching can step over the tip of a bump a ray only grazes, and so can the pyramid's own steps over the displaced
+// surface, but a cast ray must never stop in front of the surface marching finds.
+static void CheckAgainstMarching(const HeightfieldRayCaster& caster, const std::vector<HeightfieldRay>& rays, bool useDisplacement,
+	unsigned int maxMismatched) {
+	unsigned int numMismatched = 0;
+	unsigned int numEarly = 0;
+	unsigned int numHits = 0;
+	for (auto& ray : rays) {
+		HeightfieldHit hitCast, hitMarch;
+		caster.CastRay(ray, useDisplacement, hitCast);
+		caster.MarchRay(ray, useDisplacement, MARCH_STEP, hitMarch);
+		if (!IsMatch(ray, hitCast, hitMarch)) {
+			++numMismatched;
+			if (hitCast.isHit && (!hitMarch.isHit || hitCast.t < hitMarch.t)) ++numEarly;
+		}
+		if (hitCast.isHit) ++numHits;
+	}
+
+	CHECK(numMismatched * maxMismatched <= rays.size());
+	CHECK(numEarly == 0);
+	// both hits and misses are covered.
+	CHECK(numHits > rays.size() / 4 && numHits < rays.size());
+}
+
+TEST(HeightfieldRayCast, MatchesMarching) {
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(TEST_SIZE, 0, heightmap);
+	float scale = (float)TEST_SIZE / 16.0f;
+	TerrainSurface surface(heightmap.data(), TEST_SIZE, TEST_SIZE, scale, nullptr, 0, 0);
+	HeightfieldRayCaster caster(&surface);
+
+	std::vector<HeightfieldRay> rays;
+	BuildTerrainRays(surface, TEST_SIZE, scale, 512, rays);
+	CheckAgainstMarching(caster, rays, false, 50);
+}
+
+TEST(HeightfieldRayCast, MatchesMarchingDisplaced) {
+	std::vector<unsigned char> heightmap, displacementmap;
+	BuildRollingHills(TEST_SIZE, 0, heightmap);
+	BuildNoiseDisplacement(64, displacementmap);
+	float scale = (float)TEST_SIZE / 16.0f;
+	TerrainSurface surface(heightmap.data(), TEST_SIZE, TEST_SIZE, scale, displacementmap.data(), 64, 64);
+	HeightfieldRayCaster caster(&surface);
+
+	std::vector<HeightfieldRay> rays;
+	BuildTerrainRays(surface, TEST_SIZE, scale, 256, rays);
+	CheckAgainstMarching(caster, rays, true, 20);
+}
+
+TEST(HeightfieldRayCast, PacketsMatchSingleRays) {
+	std::vector<unsigned char> heightmap, displacementmap;
+	BuildRollingHills(TEST_SIZE, 0, heightmap);
+	BuildNoiseDisplacement(64, displacementmap);
+	float scale = (float)TEST_SIZE / 16.0f;
+	TerrainSurface surface(heightmap.data(), TEST_SIZE, TEST_SIZE, scale, displacementmap.data(), 64, 64);
+	HeightfieldRayCaster caster(&surface);
+
+	// an odd count, so the last packet isn't full.
+	std::vector<HeightfieldRay> rays;
+	BuildTerrainRays(surface, TEST_SIZE, scale, 4099, rays);
+
+	for (bool useDisplacement : { false, true }) {
+		std::vector<HeightfieldHit> hitsPacket(rays.size()), hitsParallel(rays.size());
+		caster.CastRays(rays.data(), (unsigned int)rays.size(), useDisplacement, 1, hitsPacket.data());
+		caster.CastRays(rays.data(), (unsigned int)rays.size(), useDisplacement, 4, hitsParallel.data());
+
+		unsigned int numDifferent = 0;
+		for (unsigned int i = 0; i < rays.size(); ++i) {
+			HeightfieldHit hit;
+			caster.CastRay(rays[i], useDisplacement, hit);
+			if (hit.isHit != hitsPacket[i].isHit || hit.t != hitsPacket[i].t) ++numDifferent;
+			if (hit.isHit != hitsParallel[i].isHit || hit.t != hitsParallel[i].t) ++numDifferent;
+		}
+		CHECK(numDifferent == 0);
+	}
+}
+
+TEST(HeightfieldRayCast, UpdateRegionMatchesRebuild) {
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(TEST_SIZE, 0, heightmap);
+	float scale = (float)TEST_SIZE / 16.0f;
+	TerrainSurface surface(heightmap.data(), TEST_SIZE, TEST_SIZE, scale, nullptr, 0, 0);
+	HeightfieldRayCaster caster(&surface);
+
+	// raise a block in the middle and dig a pit at the edge, then update only those texels.
+	for (unsigned int y = 100; y < 140; ++y) {
+		for (unsigned int x = 90; x < 170; ++x) heightmap[((size_t)y * TEST_SIZE + x) * 4] = 255;
+	}
+	for (unsigned int y = 0; y < 20; ++y) {
+		for (unsigned int x = 230; x < TEST_SIZE; ++x) heightmap[((size_t)y * TEST_SIZE + x) * 4] = 0;
+	}
+	caster.UpdateRegion(90, 100, 170, 140);
+	caster.UpdateRegion(230, 0, TEST_SIZE, 20);
+	HeightfieldRayCaster casterRebuilt(&surface);
+
+	std::vector<HeightfieldRay> rays;
+	BuildTerrainRays(surface, TEST_SIZE, scale, 2048, rays);
+	unsigned int numDifferent = 0;
+	for (auto& ray : rays) {
+		HeightfieldHit hitUpdated, hitRebuilt;
+		caster.CastRay(ray, false, hitUpdated);
+		casterRebuilt.CastRay(ray, false, hitRebuilt);
+		if (hitUpdated.isHit != hitRebuilt.isHit || hitUpdated.t != hitRebuilt.t) ++numDifferent;
+	}
+	CHECK(numDifferent == 0);
+}
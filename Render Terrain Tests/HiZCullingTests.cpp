@@ -0,0 +1,157 @@
+/*
+HiZCullingTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests the Hi-Z pyramid layout and SoftwareHiZ occlusion against a synthetic occluder.
+*/
+#include "Test.h"
+#include "HiZCulling.h"
+#include <algorithm>
+#include <random>
+
+static const unsigned int DEPTH_WIDTH = 320;
+static const unsigned int DEPTH_HEIGHT = 180;
+
+// Returns the view projection of a camera at the origin looking along +y with z up.
+static XMMATRIX CalcViewProj() {
+	XMMATRIX V = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
+	XMMATRIX P = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), (float)DEPTH_WIDTH / (float)DEPTH_HEIGHT, 0.1f, 1000.0f);
+	return V * P;
+}
+
+// Rasterize a wall facing the camera, y units away and halfSize units to either side of the view direction.
+// Both windings are drawn, so whichever one faces the camera is kept.
+static void DrawWall(SoftwareHiZ& hiz, float y, float halfSize, FXMMATRIX viewProj) {
+	XMFLOAT3 a(-halfSize, y, -halfSize), b(halfSize, y, -halfSize), c(halfSize, y, halfSize), d(-halfSize, y, halfSize);
+	hiz.RasterizeTriangle(a, b, c, viewProj);
+	hiz.RasterizeTriangle(a, c, d, viewProj);
+	hiz.RasterizeTriangle(a, c, b, viewProj);
+	hiz.RasterizeTriangle(a, d, c, viewProj);
+}
+
+// Returns true if box is behind every pixel of the depth buffer it covers on screen, ie truly occluded, or false if
+// any covered pixel is further away. Boxes crossing the near plane are never occluded.
+static bool IsBoxOccludedBruteForce(SoftwareHiZ& hiz, XMFLOAT3 min, XMFLOAT3 max, FXMMATRIX viewProj) {
+	float xMin = 1e9f, xMax = -1e9f, yMin = 1e9f, yMax = -1e9f, zMin = 1e9f;
+	for (int i = 0; i < 8; ++i) {
+		XMFLOAT4 p;
+		XMStoreFloat4(&p, XMVector4Transform(XMVectorSet(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f), viewProj));
+		if (p.w <= 0.0f) return false;
+		xMin = std::min(xMin, (p.x / p.w * 0.5f + 0.5f) * DEPTH_WIDTH);
+		xMax = std::max(xMax, (p.x / p.w * 0.5f + 0.5f) * DEPTH_WIDTH);
+		yMin = std::min(yMin, (-p.y / p.w * 0.5f + 0.5f) * DEPTH_HEIGHT);
+		yMax = std::max(yMax, (-p.y / p.w * 0.5f + 0.5f) * DEPTH_HEIGHT);
+		zMin = std::min(zMin, p.z / p.w);
+	}
+
+	int x0 = std::max((int)floorf(xMin), 0), x1 = std::min((int)ceilf(xMax), (int)DEPTH_WIDTH - 1);
+	int y0 = std::max((int)floorf(yMin), 0), y1 = std::min((int)ceilf(yMax), (int)DEPTH_HEIGHT - 1);
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			if (hiz.GetDepth(x, y) >= zMin) return false;
+		}
+	}
+	return true;
+}
+
+TEST(HiZCulling, PyramidSize) {
+	unsigned int w, h;
+	CalcHiZSize(1920, 1080, w, h);
+	CHECK(w == 1024 && h == 1024);
+	CHECK(CalcHiZMipCount(w, h) == 11);
+
+	CalcHiZSize(1280, 720, w, h);
+	CHECK(w == 1024 && h == 512);
+	CHECK(CalcHiZMipCount(w, h) == 11);
+
+	CHECK(CalcHiZMipCount(1, 1) == 1);
+	CHECK(CalcHiZMipCount(8, 1) == 4);
+}
+
+TEST(HiZCulling, PyramidKeepsFurthestDepth) {
+	SoftwareHiZ hiz(DEPTH_WIDTH, DEPTH_HEIGHT);
+	XMMATRIX viewProj = CalcViewProj();
+	DrawWall(hiz, 50.0f, 20.0f, viewProj);
+	DrawWall(hiz, 10.0f, 2.0f, viewProj);
+	hiz.BuildPyramid();
+
+	// every texel of every mip is at least as far as the texels it covers in the mip below.
+	unsigned int w, h;
+	CalcHiZSize(DEPTH_WIDTH, DEPTH_HEIGHT, w, h);
+	for (unsigned int m = 1; m < hiz.GetNumMips(); ++m) {
+		unsigned int wDst = std::max(w >> m, 1u), hDst = std::max(h >> m, 1u);
+		unsigned int wSrc = std::max(w >> (m - 1), 1u), hSrc = std::max(h >> (m - 1), 1u);
+		for (unsigned int y = 0; y < hDst; ++y) {
+			for (unsigned int x = 0; x < wDst; ++x) {
+				float depth = hiz.GetHiZ(m, x, y);
+				for (unsigned int sy = y * hSrc / hDst; sy < (y + 1) * hSrc / hDst; ++sy) {
+					for (unsigned int sx = x * wSrc / wDst; sx < (x + 1) * wSrc / wDst; ++sx) {
+						CHECK(depth >= hiz.GetHiZ(m - 1, sx, sy));
+					}
+				}
+			}
+		}
+	}
+
+	// the wall doesn't fill the screen, so the top of the pyramid is the far plane.
+	CHECK(hiz.GetHiZ(hiz.GetNumMips() - 1, 0, 0) == 1.0f);
+}
+
+TEST(HiZCulling, WallOccludes) {
+	SoftwareHiZ hiz(DEPTH_WIDTH, DEPTH_HEIGHT);
+	XMMATRIX viewProj = CalcViewProj();
+	DrawWall(hiz, 50.0f, 40.0f, viewProj);
+	hiz.BuildPyramid();
+
+	// the middle of the screen was drawn.
+	CHECK(hiz.GetDepth(DEPTH_WIDTH / 2, DEPTH_HEIGHT / 2) < 1.0f);
+
+	// behind the wall.
+	CHECK(hiz.IsBoxOccluded(XMFLOAT3(-5.0f, 80.0f, -5.0f), XMFLOAT3(5.0f, 90.0f, 5.0f), viewProj));
+	CHECK(hiz.IsBoxOccluded(XMFLOAT3(-20.0f, 200.0f, -20.0f), XMFLOAT3(20.0f, 300.0f, 10.0f), viewProj));
+	// in front of the wall.
+	CHECK(!hiz.IsBoxOccluded(XMFLOAT3(-5.0f, 20.0f, -5.0f), XMFLOAT3(5.0f, 30.0f, 5.0f), viewProj));
+	// through the wall.
+	CHECK(!hiz.IsBoxOccluded(XMFLOAT3(-5.0f, 45.0f, -5.0f), XMFLOAT3(5.0f, 55.0f, 5.0f), viewProj));
+	// behind the wall but off to the side of it.
+	CHECK(!hiz.IsBoxOccluded(XMFLOAT3(90.0f, 100.0f, -5.0f), XMFLOAT3(110.0f, 110.0f, 5.0f), viewProj));
+	// partly behind the edge of the wall.
+	CHECK(!hiz.IsBoxOccluded(XMFLOAT3(60.0f, 100.0f, -5.0f), XMFLOAT3(100.0f, 110.0f, 5.0f), viewProj));
+	// around the camera.
+	CHECK(!hiz.IsBoxOccluded(XMFLOAT3(-5.0f, -5.0f, -5.0f), XMFLOAT3(5.0f, 5.0f, 5.0f), viewProj));
+
+	// nothing is occluded once the buffer is cleared.
+	hiz.Clear();
+	hiz.BuildPyramid();
+	CHECK(!hiz.IsBoxOccluded(XMFLOAT3(-5.0f, 80.0f, -5.0f), XMFLOAT3(5.0f, 90.0f, 5.0f), viewProj));
+}
+
+TEST(HiZCulling, NeverOccludesVisibleBoxes) {
+	SoftwareHiZ hiz(DEPTH_WIDTH, DEPTH_HEIGHT);
+	XMMATRIX viewProj = CalcViewProj();
+	DrawWall(hiz, 40.0f, 25.0f, viewProj);
+	hiz.BuildPyramid();
+
+	// the pyramid may keep boxes that are hidden, but must never drop one that isn't.
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> pos(-80.0f, 80.0f);
+	std::uniform_real_distribution<float> dist(5.0f, 300.0f);
+	std::uniform_real_distribution<float> extent(0.5f, 15.0f);
+	unsigned int numOccluded = 0;
+	unsigned int numHidden = 0;
+	for (int i = 0; i < 5000; ++i) {
+		XMFLOAT3 min(pos(rng), dist(rng), pos(rng) * 0.5f);
+		XMFLOAT3 max(min.x + extent(rng), min.y + extent(rng), min.z + extent(rng));
+		bool isHidden = IsBoxOccludedBruteForce(hiz, min, max, viewProj);
+		bool isOccluded = hiz.IsBoxOccluded(min, max, viewProj);
+		CHECK(!isOccluded || isHidden);
+		if (isOccluded) ++numOccluded;
+		if (isHidden) ++numHidden;
+	}
+
+	// and it should catch most of the hidden ones.
+	CHECK(numHidden > 500);
+	CHECK(numOccluded * 2 > numHidden);
+}
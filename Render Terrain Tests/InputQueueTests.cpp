@@ -0,0 +1,107 @@
+/*
+InputQueueTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests InputQueue on one thread, and with a producer and a consumer thread hammering it at once.
+*/
+#include "Test.h"
+#include "InputQueue.h"
+#include <atomic>
+#include <thread>
+
+// Returns a mouse move carrying sequence number i.
+static InputEvent MakeEvent(unsigned int i) {
+	InputEvent e = { INPUT_MOUSE_MOVE, 0, (int)i, -(int)i };
+	return e;
+}
+
+TEST(InputQueue, FillsToCapacity) {
+	InputQueue queue(100);
+	CHECK(queue.GetSize() == 128);
+
+	// wrap around the end a few times.
+	for (unsigned int round = 0; round < 3; ++round) {
+		for (unsigned int i = 0; i < 128; ++i) {
+			CHECK(queue.Push(MakeEvent(i)));
+		}
+		CHECK(!queue.Push(MakeEvent(128)));
+		CHECK(queue.GetNumDropped() == round + 1);
+
+		InputEvent e;
+		for (unsigned int i = 0; i < 128; ++i) {
+			REQUIRE(queue.Pop(e));
+			CHECK(e.x == (int)i && e.y == -(int)i);
+		}
+		CHECK(!queue.Pop(e));
+	}
+}
+
+TEST(InputQueue, NoLossBelowCapacity) {
+	static const unsigned int NUM_BURSTS = 2000;
+	InputQueue queue(64);
+	std::atomic<unsigned int> numPopped(0);
+
+	// the producer never gets more than a queue's worth ahead of the consumer, so nothing should be dropped.
+	std::thread producer([&]() {
+		unsigned int i = 0;
+		for (unsigned int burst = 0; burst < NUM_BURSTS; ++burst) {
+			unsigned int sizeBurst = 1 + burst % queue.GetSize();
+			while (i + sizeBurst - numPopped.load() > queue.GetSize()) std::this_thread::yield();
+			for (unsigned int n = 0; n < sizeBurst; ++n, ++i) {
+				queue.Push(MakeEvent(i));
+			}
+		}
+	});
+
+	unsigned int numExpected = 0;
+	for (unsigned int burst = 0; burst < NUM_BURSTS; ++burst) numExpected += 1 + burst % queue.GetSize();
+
+	unsigned int numOutOfOrder = 0;
+	InputEvent e;
+	while (numPopped.load() < numExpected && queue.GetNumDropped() == 0) {
+		if (!queue.Pop(e)) continue;
+		if (e.x != (int)numPopped.load() || e.y != -e.x) ++numOutOfOrder;
+		numPopped.fetch_add(1);
+	}
+	producer.join();
+
+	CHECK(queue.GetNumDropped() == 0);
+	CHECK(numPopped == numExpected);
+	CHECK(numOutOfOrder == 0);
+	CHECK(!queue.Pop(e));
+}
+
+TEST(InputQueue, CountsDrops) {
+	static const unsigned int NUM_EVENTS = 1000000;
+	InputQueue queue(256);
+	std::atomic<bool> isDone(false);
+
+	// the producer pushes as fast as it can, so some events are dropped, but those that get through arrive in order.
+	std::thread producer([&]() {
+		for (unsigned int i = 0; i < NUM_EVENTS; ++i) {
+			queue.Push(MakeEvent(i));
+		}
+		isDone = true;
+	});
+
+	unsigned int numPopped = 0;
+	unsigned int numOutOfOrder = 0;
+	int prev = -1;
+	InputEvent e;
+	for (;;) {
+		bool wasDone = isDone.load();
+		if (queue.Pop(e)) {
+			if (e.x <= prev || e.y != -e.x) ++numOutOfOrder;
+			prev = e.x;
+			++numPopped;
+		} else if (wasDone) {
+			break;
+		}
+	}
+	producer.join();
+
+	CHECK(numOutOfOrder == 0);
+	CHECK(numPopped + queue.GetNumDropped() == NUM_EVENTS);
+}
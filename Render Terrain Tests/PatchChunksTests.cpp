@@ -0,0 +1,91 @@
+/*
+PatchChunksTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests that the chunks from BuildPatchChunks() draw every terrain patch exactly once, with the
+				vertices PatchGrid.h gives it and local indices that fit in 16 bits.
+*/
+#include "Test.h"
+#include "PatchChunks.h"
+#include "PatchGrid.h"
+#include <vector>
+
+// Build the chunks of a numX x numY grid and check them against the patch grid.
+static void CheckChunks(unsigned int numX, unsigned int numY, unsigned int sizeChunk) {
+	std::vector<PatchChunk> chunks;
+	std::vector<unsigned short> indices;
+	REQUIRE(BuildPatchChunks(numX, numY, sizeChunk, chunks, indices));
+
+	unsigned int numPatchesX = numX - 1;
+	unsigned int numPatchesY = numY - 1;
+	std::vector<unsigned int> numDrawn(numPatchesX * numPatchesY, 0);
+	unsigned int nextIndex = 0;
+	unsigned int numBadIndices = 0;
+	for (auto& c : chunks) {
+		// chunks follow each other in the index list and stay within sizeChunk patches.
+		CHECK(c.firstIndex == nextIndex);
+		CHECK(c.numIndices == c.numPatchesX * c.numPatchesY * 4);
+		CHECK(c.numPatchesX >= 1 && c.numPatchesX <= sizeChunk);
+		CHECK(c.numPatchesY >= 1 && c.numPatchesY <= sizeChunk);
+		CHECK(c.x + c.numPatchesX <= numPatchesX && c.y + c.numPatchesY <= numPatchesY);
+		nextIndex = c.firstIndex + c.numIndices;
+
+		// the chunk's patches come row by row. The vertex shader draws baseVertex + local index.
+		unsigned int i = c.firstIndex;
+		for (unsigned int py = c.y; py < c.y + c.numPatchesY; ++py) {
+			for (unsigned int px = c.x; px < c.x + c.numPatchesX; ++px) {
+				unsigned int patch = py * numPatchesX + px;
+				++numDrawn[patch];
+				for (unsigned int corner = 0; corner < 4; ++corner, ++i) {
+					if (indices[i] > MAX_CHUNK_INDEX) ++numBadIndices;
+					if (c.baseVertex + indices[i] != CalcPatchControlPoint(numX, numY, patch, corner)) ++numBadIndices;
+				}
+			}
+		}
+	}
+	CHECK(nextIndex == indices.size());
+	CHECK(numBadIndices == 0);
+
+	// every terrain patch is drawn exactly once.
+	unsigned int numWrong = 0;
+	for (auto n : numDrawn) {
+		if (n != 1) ++numWrong;
+	}
+	CHECK(numWrong == 0);
+}
+
+TEST(PatchChunks, SquareGrids) {
+	CheckChunks(9, 9, PATCH_CHUNK_SIZE);
+	CheckChunks(65, 65, PATCH_CHUNK_SIZE);
+	CheckChunks(129, 129, PATCH_CHUNK_SIZE);
+	CheckChunks(513, 513, PATCH_CHUNK_SIZE);
+}
+
+TEST(PatchChunks, UnevenGrids) {
+	CheckChunks(130, 67, PATCH_CHUNK_SIZE);
+	CheckChunks(200, 300, PATCH_CHUNK_SIZE);
+	CheckChunks(2, 2, PATCH_CHUNK_SIZE);
+	CheckChunks(100, 101, 17);
+}
+
+TEST(PatchChunks, WideGrids) {
+	// wide grids only fit a few rows of patches per chunk.
+	CHECK(CalcChunkRows(4000, PATCH_CHUNK_SIZE) == 16);
+	CheckChunks(4000, 40, PATCH_CHUNK_SIZE);
+
+	// a single row still fits.
+	unsigned int numX = MAX_CHUNK_INDEX - PATCH_CHUNK_SIZE;
+	CHECK(CalcChunkRows(numX, PATCH_CHUNK_SIZE) == 1);
+	CheckChunks(numX, 3, PATCH_CHUNK_SIZE);
+}
+
+TEST(PatchChunks, TooWide) {
+	CHECK(CalcChunkRows(70000, PATCH_CHUNK_SIZE) == 0);
+
+	std::vector<PatchChunk> chunks;
+	std::vector<unsigned short> indices;
+	CHECK(!BuildPatchChunks(70000, 3, PATCH_CHUNK_SIZE, chunks, indices));
+	CHECK(chunks.empty());
+}
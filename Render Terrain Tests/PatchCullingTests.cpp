@@ -0,0 +1,179 @@
+/*
+PatchCullingTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests CullPatchesCPU() against a brute force test of every corner of every patch against every
+				plane of every view.
+*/
+#include "Test.h"
+#include "PatchCulling.h"
+#include <random>
+
+static const unsigned int GRID_SIZE = 64;		// patches along each side of the test terrain.
+static const float PATCH_SIZE = 8.0f;			// world units along each side of a patch.
+
+// Build a GRID_SIZE x GRID_SIZE grid of patches with random height ranges.
+static void BuildPatches(std::mt19937& rng, std::vector<PatchCullData>& patches) {
+	std::uniform_real_distribution<float> height(0.0f, 40.0f);
+	for (unsigned int y = 0; y < GRID_SIZE; ++y) {
+		for (unsigned int x = 0; x < GRID_SIZE; ++x) {
+			float a = height(rng), b = height(rng);
+			PatchCullData p;
+			p.aabbmin = XMFLOAT3(x * PATCH_SIZE, y * PATCH_SIZE, fminf(a, b));
+			p.aabbmax = XMFLOAT3((x + 1) * PATCH_SIZE, (y + 1) * PATCH_SIZE, fmaxf(a, b));
+			p.indices[0] = p.indices[1] = p.indices[2] = p.indices[3] = 0;
+			patches.push_back(p);
+		}
+	}
+}
+
+// Write the planes of a random view to planes. Perspective slices looking over the terrain if isPerspective, otherwise
+// tilted boxes like the cascades' orthographic projections.
+static void BuildView(std::mt19937& rng, bool isPerspective, XMFLOAT4 planes[NUM_CULL_PLANES]) {
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float size = GRID_SIZE * PATCH_SIZE;
+	XMVECTOR eye = XMVectorSet(unit(rng) * size, unit(rng) * size, 30.0f + 60.0f * unit(rng), 0.0f);
+	float yaw = unit(rng) * XM_2PI;
+	float pitch = isPerspective ? -0.6f * unit(rng) : -0.3f - 1.2f * unit(rng);
+	XMVECTOR look = XMVectorSet(cosf(yaw) * cosf(pitch), sinf(yaw) * cosf(pitch), sinf(pitch), 0.0f);
+	XMVECTOR right = XMVector3Normalize(XMVector3Cross(look, XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)));
+	XMVECTOR up = XMVector3Cross(right, look);
+
+	float zNear = isPerspective ? 0.1f : -200.0f * unit(rng);
+	float zFar = isPerspective ? 50.0f + 300.0f * unit(rng) : 100.0f + 300.0f * unit(rng);
+	float halfWidth = 20.0f + 100.0f * unit(rng);
+	XMFLOAT3 corners[8];
+	for (int i = 0; i < 8; ++i) {
+		float d = (i & 4) ? zFar : zNear;
+		float w = isPerspective ? d * 0.8f : halfWidth;
+		float h = isPerspective ? d * 0.45f : halfWidth;
+		XMStoreFloat3(&corners[i], eye + look * d + right * ((i & 1) ? w : -w) + up * ((i & 2) ? h : -h));
+	}
+	CalcSlicePlanes(corners, planes);
+}
+
+// Returns the largest distance of any corner of the box in front of the plane.
+static float CalcMaxDistance(const PatchCullData& p, const XMFLOAT4& plane) {
+	float dMax = -1e30f;
+	for (int i = 0; i < 8; ++i) {
+		float x = (i & 1) ? p.aabbmax.x : p.aabbmin.x;
+		float y = (i & 2) ? p.aabbmax.y : p.aabbmin.y;
+		float z = (i & 4) ? p.aabbmax.z : p.aabbmin.z;
+		dMax = fmaxf(dMax, plane.x * x + plane.y * y + plane.z * z + plane.w);
+	}
+	return dMax;
+}
+
+// The patch is outside of the view (-1) if every corner is behind one of its planes, inside (1) if some corner is in
+// front of every plane, and too close to call (0) if a plane's deciding corner is within rounding error of it.
+static int ClassifyBruteForce(const PatchCullData& p, const XMFLOAT4 planes[NUM_CULL_PLANES]) {
+	bool isClose = false;
+	for (unsigned int i = 0; i < NUM_CULL_PLANES; ++i) {
+		float d = CalcMaxDistance(p, planes[i]);
+		if (d < -1e-3f) return -1;
+		if (d < 1e-3f) isClose = true;
+	}
+	return isClose ? 0 : 1;
+}
+
+TEST(PatchCulling, MatchesBruteForce) {
+	std::mt19937 rng(7);
+	std::vector<PatchCullData> patches;
+	BuildPatches(rng, patches);
+
+	for (unsigned int trial = 0; trial < 20; ++trial) {
+		CullViewConstants views = {};
+		for (unsigned int v = 0; v < MAX_CULL_VIEWS; ++v) {
+			BuildView(rng, v == 0, views.planes[v]);
+		}
+		unsigned int numViews = 1 + trial % MAX_CULL_VIEWS;
+		unsigned int firstUnionView = 1;
+
+		std::vector<unsigned int> lists[NUM_CULL_LISTS];
+		CullStats stats = CullPatchesCPU(patches.data(), (unsigned int)patches.size(), views, numViews, firstUnionView, lists);
+
+		// walk every patch in order alongside each list, which are written in patch order.
+		size_t next[NUM_CULL_LISTS] = {};
+		unsigned int numVisible = 0;
+		for (unsigned int p = 0; p < patches.size(); ++p) {
+			bool isInUnion = false;
+			bool isUnionClose = false;
+			for (unsigned int v = 0; v < MAX_CULL_VIEWS; ++v) {
+				bool isListed = next[v] < lists[v].size() && lists[v][next[v]] == p;
+				if (isListed) ++next[v];
+				if (v >= numViews) {
+					CHECK(!isListed);
+					continue;
+				}
+
+				int expected = ClassifyBruteForce(patches[p], views.planes[v]);
+				if (expected != 0) CHECK(isListed == (expected > 0));
+				if (v >= firstUnionView) {
+					isInUnion = isInUnion || isListed;
+					isUnionClose = isUnionClose || expected == 0;
+				}
+				if (v == 0 && isListed) ++numVisible;
+			}
+
+			bool isInUnionList = next[MAX_CULL_VIEWS] < lists[MAX_CULL_VIEWS].size() && lists[MAX_CULL_VIEWS][next[MAX_CULL_VIEWS]] == p;
+			if (isInUnionList) ++next[MAX_CULL_VIEWS];
+			if (!isUnionClose) CHECK(isInUnionList == isInUnion);
+		}
+
+		// every list was written in patch order with nothing left over.
+		for (unsigned int i = 0; i < NUM_CULL_LISTS; ++i) {
+			CHECK(next[i] == lists[i].size());
+		}
+		CHECK(stats.numInFrustum == numVisible);
+		CHECK(stats.numOccluded == 0);
+	}
+}
+
+TEST(PatchCulling, FullViewKeepsEverything) {
+	std::mt19937 rng(11);
+	std::vector<PatchCullData> patches;
+	BuildPatches(rng, patches);
+
+	// planes with no normal that are always in front cull nothing, as used to pad views with fewer planes.
+	CullViewConstants views = {};
+	for (unsigned int v = 0; v < MAX_CULL_VIEWS; ++v) {
+		for (unsigned int i = 0; i < NUM_CULL_PLANES; ++i) {
+			views.planes[v][i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	std::vector<unsigned int> lists[NUM_CULL_LISTS];
+	CullStats stats = CullPatchesCPU(patches.data(), (unsigned int)patches.size(), views, MAX_CULL_VIEWS, 1, lists);
+
+	for (unsigned int i = 0; i < NUM_CULL_LISTS; ++i) {
+		CHECK(lists[i].size() == patches.size());
+	}
+	CHECK(stats.numInFrustum == patches.size());
+}
+
+TEST(PatchCulling, UnionSkipsEarlierViews) {
+	std::mt19937 rng(3);
+	std::vector<PatchCullData> patches;
+	BuildPatches(rng, patches);
+
+	// view 0 sees everything, views 1 and 2 see nothing, so the union from view 1 on is empty.
+	CullViewConstants views = {};
+	for (unsigned int i = 0; i < NUM_CULL_PLANES; ++i) {
+		views.planes[0][i] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+		views.planes[1][i] = XMFLOAT4(0.0f, 0.0f, 1.0f, -1000.0f);
+		views.planes[2][i] = XMFLOAT4(0.0f, 0.0f, -1.0f, -1000.0f);
+	}
+
+	std::vector<unsigned int> lists[NUM_CULL_LISTS];
+	CullPatchesCPU(patches.data(), (unsigned int)patches.size(), views, 3, 1, lists);
+	CHECK(lists[0].size() == patches.size());
+	CHECK(lists[1].empty());
+	CHECK(lists[2].empty());
+	CHECK(lists[MAX_CULL_VIEWS].empty());
+
+	// from view 0 on, the union is everything.
+	CullPatchesCPU(patches.data(), (unsigned int)patches.size(), views, 3, 0, lists);
+	CHECK(lists[MAX_CULL_VIEWS].size() == patches.size());
+}
@@ -0,0 +1,118 @@
+/*
+PrefetchReplay.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Replays camera paths against a RegionPrefetcher and a made up loader.
+*/
+#include "PrefetchReplay.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Replay path with prefetcher over a loader with up to maxInFlight loads in flight, each taking msLatency plus its transfer
+// of bytesPerRegion at mbPerSecond over a link they share. Loads are started in priority order, as TileStreamer does.
+PrefetchRun ReplayPrefetch(const std::vector<CameraSample>& path, RegionPrefetcher& prefetcher, unsigned int maxInFlight,
+	unsigned int bytesPerRegion, double msLatency, double mbPerSecond) {
+	struct Load {
+		unsigned int	region;
+		float			priority;
+		double			tDone;
+	};
+	std::vector<Load> listPending, listInFlight;
+	std::vector<PrefetchRequest> listRequests;
+	std::vector<unsigned int> listCancels, listEvicted;
+	double secondsTransfer = bytesPerRegion / (mbPerSecond * 1024.0 * 1024.0);
+	double tLinkFree = 0.0;
+	double msUpdate = 0.0;
+	unsigned int numFramesMissed = 0;
+	PrefetchRun run = {};
+
+	// start the most urgent pending loads at time t.
+	auto startLoads = [&](double t) {
+		std::stable_sort(listPending.begin(), listPending.end(), [](const Load& a, const Load& b) { return a.priority > b.priority; });
+		unsigned int num = 0;
+		while (num < listPending.size() && listInFlight.size() < maxInFlight) {
+			Load load = listPending[num++];
+			double tTransfer = std::max(t + msLatency / 1000.0, tLinkFree);
+			tLinkFree = tTransfer + secondsTransfer;
+			load.tDone = tLinkFree;
+			listInFlight.push_back(load);
+		}
+		listPending.erase(listPending.begin(), listPending.begin() + num);
+		run.maxInFlight = std::max(run.maxInFlight, (unsigned int)listInFlight.size());
+	};
+
+	for (auto& s : path) {
+		// finish every load done by now, each freeing its slot for the next when it finished.
+		for (;;) {
+			auto next = std::min_element(listInFlight.begin(), listInFlight.end(), [](const Load& a, const Load& b) { return a.tDone < b.tDone; });
+			if (next == listInFlight.end() || next->tDone > s.t) break;
+
+			double tDone = next->tDone;
+			prefetcher.SetLoaded(next->region, listEvicted);
+			listInFlight.erase(next);
+			startLoads(tDone);
+		}
+
+		listRequests.clear();
+		listCancels.clear();
+		auto tStart = std::chrono::high_resolution_clock::now();
+		prefetcher.Update(s, listRequests, listCancels);
+		msUpdate += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+		// a cancel only catches loads that haven't started.
+		for (auto r : listCancels) {
+			for (unsigned int i = 0; i < listPending.size(); ++i) {
+				if (listPending[i].region == r) {
+					listPending.erase(listPending.begin() + i);
+					break;
+				}
+			}
+		}
+		for (auto& request : listRequests) {
+			listPending.push_back({ request.region, request.priority, 0.0 });
+		}
+		startLoads(s.t);
+
+		if (prefetcher.CheckNeeded(s) > 0) ++numFramesMissed;
+		run.maxResident = std::max(run.maxResident, prefetcher.GetStats().numResident);
+	}
+
+	run.stats = prefetcher.GetStats();
+	run.missRate = run.stats.numNeeded > 0 ? (double)run.stats.numMisses / (double)run.stats.numNeeded : 0.0;
+	run.frameMissRate = path.empty() ? 0.0 : (double)numFramesMissed / (double)path.size();
+	run.accuracy = run.stats.numLoaded > 0 ? (double)run.stats.numUsed / (double)run.stats.numLoaded : 0.0;
+	run.mbLoaded = run.stats.numLoaded * (double)bytesPerRegion / (1024.0 * 1024.0);
+	run.msUpdate = path.empty() ? 0.0 : msUpdate / path.size();
+
+	return run;
+}
+
+// Returns the mean distance between where a CameraPredictor fed path forecast the eye lookAhead seconds on and where it was.
+// distance receives how far the camera moved along the path.
+float CalcPredictionError(const std::vector<CameraSample>& path, float lookAhead, float& distance) {
+	CameraPredictor predictor;
+	double sumError = 0.0;
+	unsigned int numErrors = 0;
+	unsigned int j = 0;
+	distance = 0.0f;
+	for (unsigned int i = 0; i < path.size(); ++i) {
+		if (i > 0) {
+			float dx = path[i].eye.x - path[i - 1].eye.x, dy = path[i].eye.y - path[i - 1].eye.y, dz = path[i].eye.z - path[i - 1].eye.z;
+			distance += sqrtf(dx * dx + dy * dy + dz * dz);
+		}
+
+		predictor.AddSample(path[i]);
+		while (j < path.size() && path[j].t < path[i].t + lookAhead) ++j;
+		if (j == path.size()) continue;
+
+		CameraSample forecast = predictor.Predict(path[j].t - path[i].t);
+		float dx = forecast.eye.x - path[j].eye.x, dy = forecast.eye.y - path[j].eye.y, dz = forecast.eye.z - path[j].eye.z;
+		sumError += sqrtf(dx * dx + dy * dy + dz * dz);
+		++numErrors;
+	}
+
+	return numErrors > 0 ? (float)(sumError / numErrors) : 0.0f;
+}
@@ -0,0 +1,43 @@
+/*
+PrefetchReplay.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Replays camera paths against a RegionPrefetcher and a made up loader of fixed latency and bandwidth,
+				shared by the TerrainPrefetch tests and benchmark.
+
+Usage:			- ReplayPrefetch() feeds a path to a prefetcher a sample per frame, loads what it asks for, and
+					measures how often the renderer found a region missing and how many loaded regions were used.
+				- CalcPredictionError() measures how far a CameraPredictor's forecasts land from where the camera went.
+*/
+#pragma once
+
+#include "TerrainPrefetch.h"
+
+// the world and loader prefetching is measured on.
+static const unsigned int NUM_REGIONS_SIDE = 32;		// regions along each side of the world.
+static const float REGION_SIZE = 256.0f;				// world units along each side of a region.
+static const unsigned int BYTES_PER_REGION = 1 << 20;
+static const double LOAD_LATENCY_MS = 40.0;				// before a load's transfer starts.
+static const double LOAD_MB_PER_SECOND = 200.0;			// shared by every load in flight.
+
+// The results of replaying a path with one RegionPrefetcher.
+struct PrefetchRun {
+	PrefetchStats	stats;
+	double			missRate;			// numMisses / numNeeded.
+	double			frameMissRate;		// frames with at least one miss.
+	double			accuracy;			// numUsed / numLoaded. Regions still resident at the end count as used if they were.
+	double			mbLoaded;
+	double			msUpdate;			// Update() per frame, on average.
+	unsigned int	maxResident;		// the most regions resident at the end of any frame.
+	unsigned int	maxInFlight;		// the most loads in flight at once.
+};
+
+// Replay path with prefetcher over a loader with up to maxInFlight loads in flight, each taking msLatency plus its transfer
+// of bytesPerRegion at mbPerSecond over a link they share.
+PrefetchRun ReplayPrefetch(const std::vector<CameraSample>& path, RegionPrefetcher& prefetcher, unsigned int maxInFlight,
+	unsigned int bytesPerRegion, double msLatency, double mbPerSecond);
+// Returns the mean distance between where a CameraPredictor fed path forecast the eye lookAhead seconds on and where it was.
+// distance receives how far the camera moved along the path.
+float CalcPredictionError(const std::vector<CameraSample>& path, float lookAhead, float& distance);
@@ -0,0 +1,239 @@
+/*
+RenderGraphTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests RenderGraph pass culling, the placement of split barriers, which resource an aliasing barrier
+				comes from, and reusing the placement of transient resources in later graphs.
+*/
+#include "Test.h"
+#include "RenderGraph.h"
+#include <string>
+#include <vector>
+
+// Returns the description of an imported resource that starts and ends the graph in state.
+static RenderGraphResourceDesc MakeImported(const char* name, unsigned int state) {
+	RenderGraphResourceDesc desc = {};
+	desc.name = name;
+	desc.initialState = state;
+	desc.finalState = state;
+	return desc;
+}
+
+// Returns the description of a transient resource of size bytes.
+static RenderGraphResourceDesc MakeTransient(const char* name, unsigned long long size) {
+	RenderGraphResourceDesc desc = {};
+	desc.name = name;
+	desc.size = size;
+	desc.alignment = 64;
+	desc.initialState = RG_STATE_COMMON;
+	desc.isTransient = true;
+	return desc;
+}
+
+// Returns the number of barriers of type and split on resource in batch i.
+static unsigned int CountBarriers(RenderGraph& graph, unsigned int i, unsigned int resource, RenderGraphBarrierType type,
+	RenderGraphBarrierSplit split) {
+	unsigned int num = 0;
+	for (auto& b : graph.GetBarriers(i)) {
+		if (b.resource == resource && b.type == type && b.split == split) ++num;
+	}
+	return num;
+}
+
+TEST(RenderGraph, CullsUnusedPasses) {
+	RenderGraph graph;
+	unsigned int backBuffer = graph.AddResource(MakeImported("back buffer", RG_STATE_PRESENT));
+	unsigned int unread = graph.AddResource(MakeTransient("unread", 1024));
+	unsigned int feedsUnread = graph.AddResource(MakeTransient("feeds unread", 1024));
+	unsigned int shadow = graph.AddResource(MakeTransient("shadow", 1024));
+
+	// a chain ending in a transient resource nobody reads is culled from the end back.
+	unsigned int passFeed = graph.AddPass("feed", nullptr);
+	graph.Write(passFeed, feedsUnread, RG_STATE_RENDER_TARGET);
+	unsigned int passUnread = graph.AddPass("unread", nullptr);
+	graph.Read(passUnread, feedsUnread, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(passUnread, unread, RG_STATE_RENDER_TARGET);
+
+	// a transient resource that feeds the back buffer keeps its writer.
+	unsigned int passShadow = graph.AddPass("shadow", nullptr);
+	graph.Write(passShadow, shadow, RG_STATE_DEPTH_WRITE);
+	unsigned int passMain = graph.AddPass("main", nullptr);
+	graph.Read(passMain, shadow, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(passMain, backBuffer, RG_STATE_RENDER_TARGET);
+
+	// a pass that writes nothing has side effects and always runs.
+	unsigned int passReadback = graph.AddPass("readback", nullptr);
+	graph.Read(passReadback, backBuffer, RG_STATE_COPY_SOURCE);
+
+	REQUIRE(graph.Compile());
+	std::vector<unsigned int> expected = { passShadow, passMain, passReadback };
+	CHECK(graph.GetPassOrder() == expected);
+	CHECK(graph.GetStats().numPasses == 3 && graph.GetStats().numPassesCulled == 2);
+
+	// reading a transient resource before anything writes it is an error.
+	RenderGraph graphBad;
+	unsigned int tex = graphBad.AddResource(MakeTransient("tex", 1024));
+	unsigned int target = graphBad.AddResource(MakeImported("target", RG_STATE_RENDER_TARGET));
+	unsigned int pass = graphBad.AddPass("bad", nullptr);
+	graphBad.Read(pass, tex, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graphBad.Write(pass, target, RG_STATE_RENDER_TARGET);
+	CHECK(!graphBad.Compile());
+	CHECK(!graphBad.GetError().empty());
+}
+
+TEST(RenderGraph, SplitsDistantBarriers) {
+	RenderGraph graph;
+	unsigned int shadow = graph.AddResource(MakeImported("shadow", RG_STATE_PIXEL_SHADER_RESOURCE));
+	unsigned int target = graph.AddResource(MakeImported("target", RG_STATE_PRESENT));
+
+	std::vector<std::string> log;
+	unsigned int passShadow = graph.AddPass("shadow", [&log]() { log.push_back("shadow"); });
+	graph.Write(passShadow, shadow, RG_STATE_DEPTH_WRITE);
+	graph.AddPass("other", [&log]() { log.push_back("other"); });
+	unsigned int passSky = graph.AddPass("sky", [&log]() { log.push_back("sky"); });
+	graph.Write(passSky, target, RG_STATE_RENDER_TARGET);
+	unsigned int passMain = graph.AddPass("main", [&log]() { log.push_back("main"); });
+	graph.Read(passMain, shadow, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(passMain, target, RG_STATE_RENDER_TARGET);
+
+	REQUIRE(graph.Compile());
+	REQUIRE(graph.GetPassOrder().size() == 4);
+
+	// shadow is written by pass 0 and read by pass 3, so its transition begins right after pass 0 and ends right before pass 3.
+	CHECK(CountBarriers(graph, 0, shadow, RG_BARRIER_TRANSITION, RG_SPLIT_NONE) == 1);
+	CHECK(CountBarriers(graph, 1, shadow, RG_BARRIER_TRANSITION, RG_SPLIT_BEGIN) == 1);
+	CHECK(CountBarriers(graph, 2, shadow, RG_BARRIER_TRANSITION, RG_SPLIT_NONE) == 0);
+	CHECK(CountBarriers(graph, 3, shadow, RG_BARRIER_TRANSITION, RG_SPLIT_END) == 1);
+	for (auto& b : graph.GetBarriers(1)) {
+		if (b.resource == shadow) CHECK(b.stateBefore == RG_STATE_DEPTH_WRITE && b.stateAfter == RG_STATE_PIXEL_SHADER_RESOURCE);
+	}
+
+	// target isn't used until pass 2, so its transition from present is split across the first three passes too.
+	// Passes 2 and 3 use it back to back, and it goes back to present right after pass 3.
+	CHECK(CountBarriers(graph, 0, target, RG_BARRIER_TRANSITION, RG_SPLIT_BEGIN) == 1);
+	CHECK(CountBarriers(graph, 2, target, RG_BARRIER_TRANSITION, RG_SPLIT_END) == 1);
+	CHECK(CountBarriers(graph, 3, target, RG_BARRIER_TRANSITION, RG_SPLIT_NONE) == 0);
+	CHECK(CountBarriers(graph, 4, target, RG_BARRIER_TRANSITION, RG_SPLIT_NONE) == 1);
+	CHECK(graph.GetStats().numSplitBarriers == 2);
+
+	// Execute() issues each batch ahead of its pass and the last one after every pass, as GetBarriers() lists them.
+	unsigned int batch = 0;
+	graph.Execute([&log, &graph, &batch](const RenderGraphBarrier* barriers, unsigned int num) {
+		log.push_back("barriers " + std::to_string(num));
+		const std::vector<RenderGraphBarrier>& expected = graph.GetBarriers(batch++);
+		CHECK(num == expected.size());
+		for (unsigned int i = 0; i < num && i < expected.size(); ++i) {
+			CHECK(barriers[i].type == expected[i].type && barriers[i].split == expected[i].split);
+			CHECK(barriers[i].resource == expected[i].resource && barriers[i].resourceBefore == expected[i].resourceBefore);
+			CHECK(barriers[i].stateBefore == expected[i].stateBefore && barriers[i].stateAfter == expected[i].stateAfter);
+		}
+	});
+	CHECK(batch == 5);
+	std::vector<std::string> expected = { "barriers 2", "shadow", "barriers 1", "other", "barriers 1", "sky", "barriers 1", "main",
+		"barriers 1" };
+	CHECK(log == expected);
+
+	// shadow ends the graph where it started, so the next graph starts it from there.
+	graph.ResetPasses();
+	unsigned int passRead = graph.AddPass("read", nullptr);
+	graph.Read(passRead, shadow, RG_STATE_PIXEL_SHADER_RESOURCE);
+	REQUIRE(graph.Compile());
+	CHECK(graph.GetStats().numBarriers == 0);
+}
+
+TEST(RenderGraph, AliasingComesFromLastUser) {
+	RenderGraph graph;
+	unsigned int target = graph.AddResource(MakeImported("target", RG_STATE_RENDER_TARGET));
+	unsigned int a = graph.AddResource(MakeTransient("a", 4096));
+	unsigned int b = graph.AddResource(MakeTransient("b", 4096));
+	unsigned int c = graph.AddResource(MakeTransient("c", 4096));
+
+	// a, b and c are each written by one pass and read by the next, so they are never live together.
+	unsigned int res[] = { a, b, c };
+	for (unsigned int r : res) {
+		unsigned int passWrite = graph.AddPass("write", nullptr);
+		graph.Write(passWrite, r, RG_STATE_RENDER_TARGET);
+		unsigned int passRead = graph.AddPass("read", nullptr);
+		graph.Read(passRead, r, RG_STATE_PIXEL_SHADER_RESOURCE);
+		graph.Write(passRead, target, RG_STATE_RENDER_TARGET);
+	}
+
+	REQUIRE(graph.Compile());
+	CHECK(graph.GetResourceOffset(a) == 0 && graph.GetResourceOffset(b) == 0 && graph.GetResourceOffset(c) == 0);
+	CHECK(graph.GetHeapSize() == 4096);
+	CHECK(graph.GetStats().sizeTransient == 3 * 4096 && graph.GetStats().sizeHeap == 4096);
+	CHECK(graph.GetStats().numAliasingBarriers == 3);
+
+	// each one takes the memory over from the one used most recently before it, first in its batch, and its first
+	// transition isn't split, as it can't start before the aliasing barrier.
+	unsigned int before[] = { RG_NO_RESOURCE, a, b };
+	for (unsigned int i = 0; i < 3; ++i) {
+		auto& batch = graph.GetBarriers(i * 2);
+		REQUIRE(!batch.empty());
+		CHECK(batch[0].type == RG_BARRIER_ALIASING);
+		CHECK(batch[0].resource == res[i] && batch[0].resourceBefore == before[i]);
+		CHECK(CountBarriers(graph, i * 2, res[i], RG_BARRIER_TRANSITION, RG_SPLIT_NONE) == 1);
+	}
+	CHECK(graph.GetStats().numSplitBarriers == 0);
+}
+
+TEST(RenderGraph, ReusesPlacement) {
+	RenderGraph graph;
+	unsigned int target = graph.AddResource(MakeImported("target", RG_STATE_RENDER_TARGET));
+	unsigned int big = graph.AddResource(MakeTransient("big", 8192));
+	unsigned int small = graph.AddResource(MakeTransient("small", 1000));
+	unsigned int other = graph.AddResource(MakeTransient("other", 2000));
+	unsigned int unused = graph.AddResource(MakeTransient("unused", 500));
+
+	// big and small are live together, other comes after both.
+	unsigned int pass0 = graph.AddPass("0", nullptr);
+	graph.Write(pass0, big, RG_STATE_RENDER_TARGET);
+	graph.Write(pass0, small, RG_STATE_RENDER_TARGET);
+	unsigned int pass1 = graph.AddPass("1", nullptr);
+	graph.Read(pass1, big, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Read(pass1, small, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(pass1, target, RG_STATE_RENDER_TARGET);
+	unsigned int pass2 = graph.AddPass("2", nullptr);
+	graph.Write(pass2, other, RG_STATE_RENDER_TARGET);
+	unsigned int pass3 = graph.AddPass("3", nullptr);
+	graph.Read(pass3, other, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(pass3, target, RG_STATE_RENDER_TARGET);
+
+	REQUIRE(graph.Compile());
+	unsigned long long offsets[] = { graph.GetResourceOffset(big), graph.GetResourceOffset(small), graph.GetResourceOffset(other),
+		graph.GetResourceOffset(unused) };
+	unsigned long long sizeHeap = graph.GetHeapSize();
+
+	// biggest first. other reuses big's memory, small goes after big, and unused gets memory of its own after small, aligned.
+	CHECK(offsets[0] == 0);
+	CHECK(offsets[1] == 8192);
+	CHECK(offsets[2] == 0);
+	CHECK(offsets[3] == 9216);
+	CHECK(sizeHeap == 9216 + 500);
+
+	// a later graph with fewer passes keeps the placement.
+	graph.ResetPasses();
+	pass0 = graph.AddPass("0", nullptr);
+	graph.Write(pass0, other, RG_STATE_RENDER_TARGET);
+	pass1 = graph.AddPass("1", nullptr);
+	graph.Read(pass1, other, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(pass1, target, RG_STATE_RENDER_TARGET);
+	REQUIRE(graph.Compile());
+	CHECK(graph.GetResourceOffset(big) == offsets[0] && graph.GetResourceOffset(small) == offsets[1]);
+	CHECK(graph.GetResourceOffset(other) == offsets[2] && graph.GetResourceOffset(unused) == offsets[3]);
+	CHECK(graph.GetHeapSize() == sizeHeap);
+
+	// one that keeps big alive alongside other, which shares its memory, can't use it.
+	graph.ResetPasses();
+	pass0 = graph.AddPass("0", nullptr);
+	graph.Write(pass0, big, RG_STATE_RENDER_TARGET);
+	graph.Write(pass0, other, RG_STATE_RENDER_TARGET);
+	pass1 = graph.AddPass("1", nullptr);
+	graph.Read(pass1, big, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Read(pass1, other, RG_STATE_PIXEL_SHADER_RESOURCE);
+	graph.Write(pass1, target, RG_STATE_RENDER_TARGET);
+	CHECK(!graph.Compile());
+	CHECK(graph.GetError().find("share memory") != std::string::npos);
+}
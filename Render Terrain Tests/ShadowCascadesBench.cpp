@@ -0,0 +1,130 @@
+/*
+ShadowCascadesBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Replays camera paths over a synthetic terrain and compares the texel density of the cascades
+				FitCascadeToBlocks() fits with what a padded bounding sphere around each slice would give.
+*/
+#include "Test.h"
+#include "ShadowCascades.h"
+#include "TerrainPrefetch.h"
+#include <vector>
+
+static const float WORLD_SIZE = 4096.0f;				// world units along each side of the synthetic terrain.
+static const float BLOCK_SIZE = 64.0f;					// world units along each side of a block.
+static const unsigned int NUM_SPLIT_CASCADES = 3;		// as the Scene, which splits 3 of its 4 cascades.
+static const unsigned int CASCADE_SIZE = 2048;			// texels along each side of a cascade in the Scene's 4096 atlas.
+static const float FOV_VERTICAL = 60.0f;				// as the Camera, over a 1920 x 1080 window.
+static const float ASPECT = 1920.0f / 1080.0f;
+
+// Returns the height of the synthetic terrain at (x, y). Rolling hills with a few ridges, under the paths' 60 units.
+static float CalcHeight(float x, float y) {
+	float h = 12.0f * sinf(x * 0.004f) * cosf(y * 0.0031f) + 6.0f * sinf((x + y) * 0.011f) + 2.0f * cosf(x * 0.037f - y * 0.029f);
+	return 22.0f + h + 10.0f * fmaxf(0.0f, sinf(y * 0.0017f + 1.3f));
+}
+
+// Build the blocks of the synthetic terrain, as Terrain::GetBlockBounds() would, and the box around all of them.
+static void BuildBlocks(std::vector<AxisAlignedBoundingBox>& blocks, AxisAlignedBoundingBox& bbScene) {
+	unsigned int numBlocks = (unsigned int)(WORLD_SIZE / BLOCK_SIZE);
+	float zMin = 1e9f, zMax = -1e9f;
+	for (unsigned int by = 0; by < numBlocks; ++by) {
+		for (unsigned int bx = 0; bx < numBlocks; ++bx) {
+			float x0 = bx * BLOCK_SIZE, y0 = by * BLOCK_SIZE;
+			float lo = 1e9f, hi = -1e9f;
+			for (float y = y0; y <= y0 + BLOCK_SIZE; y += 2.0f) {
+				for (float x = x0; x <= x0 + BLOCK_SIZE; x += 2.0f) {
+					float h = CalcHeight(x, y);
+					lo = fminf(lo, h);
+					hi = fmaxf(hi, h);
+				}
+			}
+			blocks.push_back(AxisAlignedBoundingBox(XMFLOAT3(x0, y0, lo), XMFLOAT3(x0 + BLOCK_SIZE, y0 + BLOCK_SIZE, hi)));
+			zMin = fminf(zMin, lo);
+			zMax = fmaxf(zMax, hi);
+		}
+	}
+	bbScene = AxisAlignedBoundingBox(XMFLOAT3(0.0f, 0.0f, zMin), XMFLOAT3(WORLD_SIZE, WORLD_SIZE, zMax));
+}
+
+// Write the corners of the slice of s's view frustum from zNear to zFar, ordered as Camera::CalculateFrustumByNearFar() orders them.
+static void CalcSliceCorners(const CameraSample& s, float zNear, float zFar, XMFLOAT3 corners[8]) {
+	XMVECTOR eye = XMLoadFloat3(&s.eye);
+	XMVECTOR look = XMVector3Normalize(XMLoadFloat3(&s.look));
+	XMVECTOR right = XMVector3Normalize(XMVector3Cross(look, XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)));
+	XMVECTOR up = XMVector3Cross(right, look);
+	float tanHalfV = tanf(XMConvertToRadians(FOV_VERTICAL) / 2.0f);
+	float tanHalfH = tanHalfV * ASPECT;
+
+	for (int i = 0; i < 8; ++i) {
+		float d = (i & 4) ? zFar : zNear;
+		float x = ((i & 1) ? d : -d) * tanHalfH;
+		float y = ((i & 2) ? d : -d) * tanHalfV;
+		XMStoreFloat3(&corners[i], eye + look * d + right * x + up * y);
+	}
+}
+
+// Replay path with the sun at sunAngle degrees from the horizon and print the mean density of each split cascade.
+static void ReplayDensity(const char* name, const std::vector<CameraSample>& path, float sunAngle,
+	std::vector<AxisAlignedBoundingBox>& blocks, AxisAlignedBoundingBox& bbScene) {
+	float a = XMConvertToRadians(sunAngle);
+	XMVECTOR lightdir = XMVector3Normalize(XMVectorSet(0.3f * cosf(a), cosf(a), -sinf(a), 0.0f));
+	XMMATRIX V = CalcLightView(bbScene, lightdir);
+
+	float splits[MAX_SHADOW_CASCADES + 1];
+	CalcCascadeSplits(CASCADE_NEAR_PLANE, CASCADE_FAR_PLANE, NUM_SPLIT_CASCADES, 0.5f, splits);
+
+	double sumFit[MAX_SHADOW_CASCADES] = {};
+	double sumSphere[MAX_SHADOW_CASCADES] = {};
+	for (auto& s : path) {
+		for (unsigned int i = 0; i < NUM_SPLIT_CASCADES; ++i) {
+			XMFLOAT3 corners[8];
+			CalcSliceCorners(s, splits[i], splits[i + 1], corners);
+			CascadeBox box = FitCascadeToBlocks(corners, blocks.data(), (unsigned int)blocks.size(), bbScene, V, CASCADE_SIZE);
+			BoundingSphere bs = FindBoundingSphere(corners[0], corners[4], corners[7]);
+
+			sumFit[i] += CalcTexelDensity(box, CASCADE_SIZE);
+			sumSphere[i] += CalcSphereTexelDensity(bs.GetRadius(), CASCADE_SIZE);
+		}
+	}
+
+	printf("  %-10s sun %4.0f:", name, sunAngle);
+	for (unsigned int i = 0; i < NUM_SPLIT_CASCADES; ++i) {
+		double fit = sumFit[i] / path.size();
+		double sphere = sumSphere[i] / path.size();
+		printf("  [%u] %7.2f / %7.2f = %5.2fx", i, fit, sphere, fit / sphere);
+	}
+	printf("\n");
+}
+
+// Pass --path=<file> to replay a path recorded with SIM_CAMERA_PATH_FILE instead of the built ones.
+BENCHMARK(ShadowCascades, DensityReplay) {
+	std::vector<AxisAlignedBoundingBox> blocks;
+	AxisAlignedBoundingBox bbScene;
+	BuildBlocks(blocks, bbScene);
+
+	std::vector<std::vector<CameraSample>> paths;
+	std::vector<const char*> names;
+	const char* fn = GetTestOption("path");
+	if (fn) {
+		paths.emplace_back();
+		REQUIRE(LoadCameraPath(fn, paths.back()) && !paths.back().empty());
+		names.push_back("recorded");
+	}
+	else {
+		const char* kinds[] = { "fly", "walk", "look" };
+		for (unsigned int kind = 0; kind < 3; ++kind) {
+			paths.emplace_back();
+			BuildCameraPath(kind, WORLD_SIZE, 30.0, 30.0, paths.back());
+			names.push_back(kinds[kind]);
+		}
+	}
+
+	printf("  texels per world unit, fitted to blocks / sphere = ratio, per split cascade:\n");
+	for (size_t p = 0; p < paths.size(); ++p) {
+		for (float sunAngle : { 20.0f, 45.0f, 80.0f }) {
+			ReplayDensity(names[p], paths[p], sunAngle, blocks, bbScene);
+		}
+	}
+}
@@ -0,0 +1,183 @@
+/*
+ShadowCascadesTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests of the cascade splits, snapping and slice clipping in ShadowCascades.
+*/
+#include "Test.h"
+#include "ShadowCascades.h"
+
+// Write the corners of a box shaped slice, ordered as for ClipSliceToHeightRange(). The slice looks along y, so bit 1
+// of the index picks the bottom (z = zBottom) or top (z = zTop) of the slice.
+static void MakeBoxSlice(float zBottom, float zTop, XMFLOAT3 corners[8]) {
+	for (int i = 0; i < 8; ++i) {
+		corners[i] = XMFLOAT3((i & 1) ? 10.0f : 0.0f, (i & 4) ? 20.0f : 0.0f, (i & 2) ? zTop : zBottom);
+	}
+}
+
+TEST(ShadowCascades, SplitsUniform) {
+	float splits[MAX_SHADOW_CASCADES + 1];
+	CalcCascadeSplits(1.0f, 1001.0f, 4, 0.0f, splits);
+
+	CHECK(splits[0] == 1.0f);
+	CHECK_NEAR(splits[1], 251.0f, 1e-3);
+	CHECK_NEAR(splits[2], 501.0f, 1e-3);
+	CHECK_NEAR(splits[3], 751.0f, 1e-3);
+	CHECK(splits[4] == 1001.0f);
+}
+
+TEST(ShadowCascades, SplitsLogarithmic) {
+	float splits[MAX_SHADOW_CASCADES + 1];
+	CalcCascadeSplits(1.0f, 10000.0f, 4, 1.0f, splits);
+
+	// each cascade covers the same ratio of distances.
+	CHECK(splits[0] == 1.0f);
+	CHECK_NEAR(splits[1], 10.0f, 1e-3);
+	CHECK_NEAR(splits[2], 100.0f, 1e-2);
+	CHECK_NEAR(splits[3], 1000.0f, 1e-1);
+	CHECK(splits[4] == 10000.0f);
+}
+
+TEST(ShadowCascades, SplitsBlended) {
+	float splitsUniform[MAX_SHADOW_CASCADES + 1];
+	float splitsLog[MAX_SHADOW_CASCADES + 1];
+	float splits[MAX_SHADOW_CASCADES + 1];
+	CalcCascadeSplits(0.1f, 3000.0f, 4, 0.0f, splitsUniform);
+	CalcCascadeSplits(0.1f, 3000.0f, 4, 1.0f, splitsLog);
+	CalcCascadeSplits(0.1f, 3000.0f, 4, 0.5f, splits);
+
+	CHECK(splits[0] == 0.1f);
+	CHECK(splits[4] == 3000.0f);
+	for (int i = 1; i < 4; ++i) {
+		CHECK_NEAR(splits[i], (splitsUniform[i] + splitsLog[i]) / 2.0f, 1e-2);
+		CHECK(splits[i] > splits[i - 1]);
+	}
+}
+
+TEST(ShadowCascades, SplitsSingleCascade) {
+	float splits[2];
+	CalcCascadeSplits(0.5f, 100.0f, 1, 0.5f, splits);
+
+	CHECK(splits[0] == 0.5f);
+	CHECK(splits[1] == 100.0f);
+}
+
+TEST(ShadowCascades, SnapIsSquareAndCovers) {
+	CascadeBox box = { XMFLOAT3(-13.3f, 7.1f, -40.0f), XMFLOAT3(51.7f, 29.9f, 113.0f) };
+	CascadeBox snapped = SnapCascadeBox(box, 1024);
+
+	CHECK_NEAR(snapped.max.x - snapped.min.x, snapped.max.y - snapped.min.y, 1e-4);
+	CHECK(snapped.min.x <= box.min.x && snapped.max.x >= box.max.x);
+	CHECK(snapped.min.y <= box.min.y && snapped.max.y >= box.max.y);
+	// depth is rounded out to whole steps.
+	CHECK(snapped.min.z == -48.0f);
+	CHECK(snapped.max.z == 128.0f);
+}
+
+TEST(ShadowCascades, SnapIsTexelStable) {
+	const unsigned int size = 2048;
+	CascadeBox box = { XMFLOAT3(100.0f, -50.0f, 0.0f), XMFLOAT3(400.0f, 230.0f, 64.0f) };
+	CascadeBox first = SnapCascadeBox(box, size);
+	float extent = first.max.x - first.min.x;
+	float texel = extent / (float)size;
+
+	// slide the box and grow it a little, as a rotating camera would. The width mustn't change, and the box must only
+	// ever move by whole texels.
+	for (int i = 0; i < 200; ++i) {
+		float dx = 0.37f * (float)i;
+		float dy = -0.21f * (float)i;
+		float grow = 0.01f * (float)(i % 7);
+		CascadeBox moved = { XMFLOAT3(box.min.x + dx, box.min.y + dy, box.min.z), XMFLOAT3(box.max.x + dx + grow, box.max.y + dy, box.max.z) };
+		CascadeBox snapped = SnapCascadeBox(moved, size);
+
+		CHECK(snapped.max.x - snapped.min.x == extent);
+		float tx = (snapped.min.x - first.min.x) / texel;
+		float ty = (snapped.min.y - first.min.y) / texel;
+		CHECK_NEAR(tx, roundf(tx), 1e-3);
+		CHECK_NEAR(ty, roundf(ty), 1e-3);
+	}
+
+	// the same box always snaps to exactly the same box, so cached cascades can be compared by value.
+	CascadeBox again = SnapCascadeBox(box, size);
+	CHECK(again.min.x == first.min.x && again.min.y == first.min.y && again.max.x == first.max.x && again.max.y == first.max.y);
+}
+
+TEST(ShadowCascades, ClipInsideRange) {
+	XMFLOAT3 corners[8];
+	XMFLOAT3 points[MAX_CLIPPED_SLICE_POINTS];
+	MakeBoxSlice(0.0f, 10.0f, corners);
+
+	CHECK(ClipSliceToHeightRange(corners, -1.0f, 11.0f, points) == 8);
+	CHECK(ClipSliceToHeightRange(corners, 20.0f, 30.0f, points) == 0);
+	CHECK(ClipSliceToHeightRange(corners, -30.0f, -20.0f, points) == 0);
+}
+
+TEST(ShadowCascades, ClipAcrossRange) {
+	XMFLOAT3 corners[8];
+	XMFLOAT3 points[MAX_CLIPPED_SLICE_POINTS];
+	MakeBoxSlice(0.0f, 10.0f, corners);
+
+	// both planes cut the 4 vertical edges and no corner is left.
+	unsigned int numPoints = ClipSliceToHeightRange(corners, 2.0f, 5.0f, points);
+	REQUIRE(numPoints == 8);
+	unsigned int numLow = 0;
+	for (unsigned int i = 0; i < numPoints; ++i) {
+		CHECK(points[i].z == 2.0f || points[i].z == 5.0f);
+		if (points[i].z == 2.0f) ++numLow;
+		CHECK(points[i].x == 0.0f || points[i].x == 10.0f);
+		CHECK(points[i].y == 0.0f || points[i].y == 20.0f);
+	}
+	CHECK(numLow == 4);
+
+	// the top plane cuts the vertical edges and the bottom corners are kept.
+	numPoints = ClipSliceToHeightRange(corners, -5.0f, 5.0f, points);
+	REQUIRE(numPoints == 8);
+	for (unsigned int i = 0; i < numPoints; ++i) {
+		CHECK(points[i].z == 0.0f || points[i].z == 5.0f);
+	}
+}
+
+TEST(ShadowCascades, ClipTiltedSlice) {
+	// a frustum slice looking down at 45 degrees, wider at the far end.
+	XMFLOAT3 corners[8];
+	for (int i = 0; i < 8; ++i) {
+		float d = (i & 4) ? 100.0f : 10.0f;
+		float side = ((i & 1) ? 1.0f : -1.0f) * d * 0.5f;
+		float up = ((i & 2) ? 1.0f : -1.0f) * d * 0.3f;
+		corners[i] = XMFLOAT3(side, (d + up) * 0.7071f, 50.0f + (up - d) * 0.7071f);
+	}
+
+	XMFLOAT3 points[MAX_CLIPPED_SLICE_POINTS];
+	unsigned int numPoints = ClipSliceToHeightRange(corners, -10.0f, 30.0f, points);
+	REQUIRE(numPoints >= 4 && numPoints <= MAX_CLIPPED_SLICE_POINTS);
+
+	// every point is within the range and within the bounds of the slice.
+	XMFLOAT3 lo = corners[0], hi = corners[0];
+	for (int i = 1; i < 8; ++i) {
+		lo = XMFLOAT3(fminf(lo.x, corners[i].x), fminf(lo.y, corners[i].y), fminf(lo.z, corners[i].z));
+		hi = XMFLOAT3(fmaxf(hi.x, corners[i].x), fmaxf(hi.y, corners[i].y), fmaxf(hi.z, corners[i].z));
+	}
+	for (unsigned int i = 0; i < numPoints; ++i) {
+		CHECK(points[i].z >= -10.0f - 1e-4f && points[i].z <= 30.0f + 1e-4f);
+		CHECK(points[i].x >= lo.x - 1e-4f && points[i].x <= hi.x + 1e-4f);
+		CHECK(points[i].y >= lo.y - 1e-4f && points[i].y <= hi.y + 1e-4f);
+	}
+}
+
+// Decoding the cascadeMap as RenderShadowMapVS.hlsl does gives back every instance's cascade, for any subset of the cascades.
+TEST(ShadowCascades, CascadeMapRoundTrips) {
+	unsigned int cascades[MAX_SHADOW_CASCADES];
+	for (unsigned int subset = 1; subset < (1u << MAX_SHADOW_CASCADES); ++subset) {
+		unsigned int num = 0;
+		for (unsigned int c = 0; c < MAX_SHADOW_CASCADES; ++c) {
+			if (subset & (1u << c)) cascades[num++] = c;
+		}
+
+		unsigned int cascadeMap = PackCascadeMap(cascades, num);
+		for (unsigned int instance = 0; instance < num; ++instance) {
+			CHECK(((cascadeMap >> (instance * SHADOW_CASCADE_MAP_BITS)) & ((1u << SHADOW_CASCADE_MAP_BITS) - 1)) == cascades[instance]);
+		}
+	}
+}
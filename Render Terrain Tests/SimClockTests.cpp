@@ -0,0 +1,157 @@
+/*
+SimClockTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 19, 2026
+
+Description:	Tests the fixed step and scripted clocks, the time of day curve, and that the DayNightCycle driven
+				by them repeats a run exactly.
+*/
+#include "Test.h"
+#include "SimClock.h"
+#include "DayNightCycle.h"
+#include <cstring>
+
+TEST(SimClock, FixedStep) {
+	FixedStepClock clock(16.0);
+	CHECK(clock.GetTime() == 0.0);
+	for (int i = 0; i < 1000; ++i) {
+		CHECK(clock.Tick() == 16.0);
+	}
+	CHECK(clock.GetTime() == 16000.0);
+}
+
+TEST(SimClock, ScriptedSteps) {
+	const double steps[] = { 10.0, 20.0, 30.0 };
+
+	// a looping script starts over once it runs out.
+	ScriptedClock looping(steps, 3, true);
+	const double expectLooping[] = { 10.0, 20.0, 30.0, 10.0, 20.0, 30.0, 10.0 };
+	for (double step : expectLooping) {
+		CHECK(looping.Tick() == step);
+	}
+	CHECK(looping.GetTime() == 130.0);
+
+	// otherwise it keeps repeating the last step.
+	ScriptedClock once(steps, 3, false);
+	const double expectOnce[] = { 10.0, 20.0, 30.0, 30.0, 30.0, 30.0 };
+	for (double step : expectOnce) {
+		CHECK(once.Tick() == step);
+	}
+	CHECK(once.GetTime() == 150.0);
+
+	// the clock keeps its own copy of the steps.
+	double temp[] = { 5.0 };
+	ScriptedClock copy(temp, 1, false);
+	temp[0] = 50.0;
+	CHECK(copy.Tick() == 5.0);
+
+	ScriptedClock empty(steps, 0, true);
+	CHECK(empty.Tick() == 0.0);
+	CHECK(empty.GetTime() == 0.0);
+}
+
+TEST(SimClock, CurveWrapsAroundMidnight) {
+	TimeOfDayCurve curve;
+	CHECK(curve.Evaluate(100.0) == 0.0f);
+	CHECK(curve.AddKey(0.0, 350.0f));
+	CHECK(curve.AddKey(1000.0, 10.0f));
+	CHECK(curve.AddKey(2000.0, 90.0f));
+	CHECK(!curve.AddKey(1500.0, 180.0f));
+	CHECK(curve.GetNumKeys() == 3);
+
+	// from 350 to 10 through 0, not back through 180.
+	CHECK_NEAR(curve.Evaluate(250.0), 355.0f, 1e-3f);
+	CHECK_NEAR(curve.Evaluate(500.0), 0.0f, 1e-3f);
+	CHECK_NEAR(curve.Evaluate(750.0), 5.0f, 1e-3f);
+	CHECK_NEAR(curve.Evaluate(1000.0), 10.0f, 1e-3f);
+	CHECK_NEAR(curve.Evaluate(1500.0), 50.0f, 1e-3f);
+
+	// flat either side of the keys.
+	CHECK_NEAR(curve.Evaluate(-500.0), 350.0f, 1e-3f);
+	CHECK_NEAR(curve.Evaluate(5000.0), 90.0f, 1e-3f);
+
+	// and back the other way, from 10 to 340 through 0.
+	TimeOfDayCurve back;
+	back.AddKey(0.0, 10.0f);
+	back.AddKey(300.0, 340.0f);
+	CHECK_NEAR(back.Evaluate(100.0), 0.0f, 1e-3f);
+	CHECK_NEAR(back.Evaluate(200.0), 350.0f, 1e-3f);
+
+	// every angle is in [0, 360).
+	for (double t = -100.0; t < 2100.0; t += 7.0) {
+		float a = curve.Evaluate(t);
+		CHECK(a >= 0.0f && a < 360.0f);
+	}
+}
+
+TEST(SimClock, CurveWithOneKey) {
+	TimeOfDayCurve curve;
+	curve.AddKey(500.0, 90.0f);
+	CHECK(curve.Evaluate(0.0) == 90.0f);
+	CHECK(curve.Evaluate(500.0) == 90.0f);
+	CHECK(curve.Evaluate(1e9) == 90.0f);
+
+	// angles outside [0, 360) are wrapped into it.
+	TimeOfDayCurve outside;
+	outside.AddKey(0.0, -30.0f);
+	CHECK_NEAR(outside.Evaluate(10.0), 330.0f, 1e-3f);
+	outside = TimeOfDayCurve();
+	outside.AddKey(0.0, 370.0f);
+	CHECK_NEAR(outside.Evaluate(10.0), 10.0f, 1e-3f);
+}
+
+// Run a DayNightCycle for numTicks ticks of clock, following curve if not null, and write the sun angle and every cascade's
+// matrix after each tick to angles and matrices.
+static void RunCycle(SimClock& clock, TimeOfDayCurve* curve, unsigned int numTicks, std::vector<float>& angles,
+	std::vector<XMFLOAT4X4>& matrices) {
+	DayNightCycle dnc(6000, 2048, MAX_SHADOW_CASCADES);
+	dnc.SetClock(&clock);
+	dnc.SetTimeOfDayCurve(curve);
+	Camera cam(1080, 1920);
+	cam.LockPosition(XMFLOAT4(512.0f, 400.0f, 80.0f, 1.0f));
+	AxisAlignedBoundingBox bbScene(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1024.0f, 1024.0f, 64.0f));
+
+	for (unsigned int i = 0; i < numTicks; ++i) {
+		// turn the camera a little each tick, so the split cascades move too.
+		cam.Yaw(0.01f);
+		dnc.Update(bbScene, &cam);
+		angles.push_back(dnc.GetSunAngle());
+		for (unsigned int c = 0; c < dnc.GetNumCascades(); ++c) {
+			matrices.push_back(dnc.GetShadowViewProjMatrix(c));
+		}
+	}
+}
+
+// Two runs of the same clock give the same sun and cascades, bit for bit, with the sun moving with time or following a curve.
+TEST(SimClock, DayNightCycleRepeats) {
+	TimeOfDayCurve curve;
+	curve.AddKey(0.0, 60.0f);
+	curve.AddKey(4000.0, 120.0f);
+	curve.AddKey(8000.0, 300.0f);
+
+	for (TimeOfDayCurve* pCurve : { (TimeOfDayCurve*)nullptr, &curve }) {
+		std::vector<float> angles[2];
+		std::vector<XMFLOAT4X4> matrices[2];
+		for (int run = 0; run < 2; ++run) {
+			FixedStepClock clock(1000.0 / 60.0);
+			RunCycle(clock, pCurve, 600, angles[run], matrices[run]);
+		}
+
+		REQUIRE(angles[0].size() == angles[1].size() && matrices[0].size() == matrices[1].size());
+		CHECK(memcmp(angles[0].data(), angles[1].data(), angles[0].size() * sizeof(float)) == 0);
+		CHECK(memcmp(matrices[0].data(), matrices[1].data(), matrices[0].size() * sizeof(XMFLOAT4X4)) == 0);
+
+		// 10 s of 60 Hz ticks moves the sun 6000 times as far as the time passed, or to the end of the curve.
+		float expected = pCurve ? curve.Evaluate(10000.0) : (float)(10000.0 * 6000.0 * DEG_PER_MILLI);
+		CHECK_NEAR(angles[0].back(), expected, 0.01f);
+	}
+
+	// a scripted clock that adds up to the same time puts the sun in the same place at the end.
+	const double steps[] = { 10.0, 30.0, 20.0 };
+	ScriptedClock scripted(steps, 3, true);
+	std::vector<float> angles;
+	std::vector<XMFLOAT4X4> matrices;
+	RunCycle(scripted, &curve, 498, angles, matrices);
+	CHECK_NEAR(angles.back(), curve.Evaluate(9960.0), 1e-3f);
+}
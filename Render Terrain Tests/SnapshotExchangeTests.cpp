@@ -0,0 +1,76 @@
+/*
+SnapshotExchangeTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests that SnapshotExchange hands the reader whole snapshots, newest first, while the writer keeps publishing.
+*/
+#include "Test.h"
+#include "SnapshotExchange.h"
+#include <thread>
+
+// A snapshot big enough to take a while to copy, with the same value in every element, so a copy caught half
+// written shows up as elements that disagree.
+struct TestSnapshot {
+	unsigned long long values[256];
+};
+
+TEST(SnapshotExchange, NewestWins) {
+	TestSnapshot initial = {};
+	SnapshotExchange<TestSnapshot> exchange(initial);
+
+	CHECK(!exchange.Acquire());
+	CHECK(exchange.GetReadSlot().values[0] == 0);
+
+	// snapshots the reader doesn't get to are skipped.
+	for (unsigned long long i = 1; i <= 3; ++i) {
+		exchange.GetWriteSlot().values[0] = i;
+		exchange.Publish();
+	}
+	CHECK(exchange.Acquire());
+	CHECK(exchange.GetReadSlot().values[0] == 3);
+	CHECK(!exchange.Acquire());
+	CHECK(exchange.GetReadSlot().values[0] == 3);
+}
+
+TEST(SnapshotExchange, NeverTorn) {
+	static const unsigned long long NUM_SNAPSHOTS = 200000;
+	TestSnapshot initial = {};
+	SnapshotExchange<TestSnapshot> exchange(initial);
+
+	std::thread writer([&]() {
+		for (unsigned long long i = 1; i <= NUM_SNAPSHOTS; ++i) {
+			TestSnapshot& snap = exchange.GetWriteSlot();
+			for (auto& v : snap.values) v = i;
+			exchange.Publish();
+		}
+	});
+
+	// every snapshot the reader gets is whole and newer than the last.
+	unsigned int numTorn = 0;
+	unsigned int numStale = 0;
+	unsigned int numAcquired = 0;
+	unsigned long long prev = 0;
+	while (prev < NUM_SNAPSHOTS) {
+		if (!exchange.Acquire()) continue;
+		++numAcquired;
+
+		const TestSnapshot& snap = exchange.GetReadSlot();
+		unsigned long long value = snap.values[0];
+		for (auto v : snap.values) {
+			if (v != value) {
+				++numTorn;
+				break;
+			}
+		}
+		if (value <= prev) ++numStale;
+		prev = value;
+	}
+	writer.join();
+
+	CHECK(numTorn == 0);
+	CHECK(numStale == 0);
+	CHECK(numAcquired > 0);
+	CHECK(!exchange.Acquire());
+}
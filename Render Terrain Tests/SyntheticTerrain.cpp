@@ -0,0 +1,64 @@
+/*
+SyntheticTerrain.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Made up heightmaps, displacement maps and rays for the tests and benchmarks.
+*/
+#include "SyntheticTerrain.h"
+#include <cmath>
+
+// Fill heightmap with a size x size heightmap of rolling hills, 4 bytes per texel with the height in the first.
+// tile shifts the hills and noise so that tiles of a world don't match.
+void BuildRollingHills(unsigned int size, unsigned int tile, std::vector<unsigned char>& heightmap) {
+	heightmap.assign((size_t)size * size * 4, 0);
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			unsigned int hash = (x * 73856093u) ^ (y * 19349663u) ^ (tile * 83492791u);
+			float h = 0.5f + 0.35f * sinf((float)x * 0.0031f + (float)tile) * cosf((float)y * 0.0023f + 0.7f * (float)tile) +
+				(float)(hash % 17) / 255.0f;
+			heightmap[((size_t)y * size + x) * 4] = (unsigned char)(fminf(fmaxf(h, 0.0f), 1.0f) * 255.0f);
+		}
+	}
+}
+
+// Fill displacementmap with a size x size displacement map of noise, 4 bytes per texel with the displacement in the fourth.
+void BuildNoiseDisplacement(unsigned int size, std::vector<unsigned char>& displacementmap) {
+	displacementmap.assign((size_t)size * size * 4, 0);
+	for (unsigned int i = 0; i < size * size; ++i) {
+		displacementmap[i * 4 + 3] = (unsigned char)((i * 2654435761u) >> 24);
+	}
+}
+
+// Fill rays with numRays rays against a size x size heightmap scaled by scale. The first half are picking rays for a
+// block of pixels from a camera in one corner looking across the terrain, a row of pixels after another, so packets hold
+// neighbouring pixels. The second half are line of sight tests between random points a little above the terrain.
+void BuildTerrainRays(const TerrainSurface& surface, unsigned int size, float scale, unsigned int numRays, std::vector<HeightfieldRay>& rays) {
+	rays.resize(numRays);
+	unsigned int numCamera = numRays / 2;
+	// a square block of pixels, so any number of rays covers the whole view.
+	unsigned int wView = (unsigned int)sqrtf((float)numCamera);
+	if (wView == 0) wView = 1;
+	XMFLOAT3 eye(size * 0.05f, size * 0.05f, scale * 1.5f);
+	for (unsigned int i = 0; i < numCamera; ++i) {
+		float px = (float)(i % wView) / wView - 0.5f;
+		float py = (float)(i / wView % wView) / wView - 0.5f;
+		XMFLOAT3 dir(0.7071f - px * 0.7071f, 0.7071f + px * 0.7071f, -0.35f - py * 0.7f);
+		float len = sqrtf(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
+		rays[i] = { eye, XMFLOAT3(dir.x / len, dir.y / len, dir.z / len), (float)size * 2.0f };
+	}
+
+	unsigned int seed = 12345;
+	auto random = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / (float)(1 << 24);
+	};
+	for (unsigned int i = numCamera; i < numRays; ++i) {
+		XMFLOAT3 a(random() * size, random() * size, 0.0f);
+		XMFLOAT3 b(random() * size, random() * size, 0.0f);
+		a.z = surface.GetHeight(a.x, a.y) + 1.0f + random() * 20.0f;
+		b.z = surface.GetHeight(b.x, b.y) + 1.0f + random() * 20.0f;
+		rays[i] = { a, XMFLOAT3(b.x - a.x, b.y - a.y, b.z - a.z), 1.0f };
+	}
+}
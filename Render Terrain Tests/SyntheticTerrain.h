@@ -0,0 +1,30 @@
+/*
+SyntheticTerrain.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Made up heightmaps, displacement maps and rays shared by the tests and benchmarks, so they don't
+				need the PNG files the renderer loads.
+
+Usage:			- BuildRollingHills() fills a heightmap with rolling hills and some high frequency noise on top,
+					so patches have a spread of errors. Give each tile of a world its own index and no two
+					tiles meet to begin with.
+				- BuildNoiseDisplacement() fills a displacement map with noise.
+				- BuildTerrainRays() makes picking rays from a camera over the terrain and line of sight rays
+					between random points above it.
+*/
+#pragma once
+
+#include "HeightfieldRayCast.h"
+#include <vector>
+
+// Fill heightmap with a size x size heightmap of rolling hills, 4 bytes per texel with the height in the first.
+// tile shifts the hills and noise so that tiles of a world don't match.
+void BuildRollingHills(unsigned int size, unsigned int tile, std::vector<unsigned char>& heightmap);
+// Fill displacementmap with a size x size displacement map of noise, 4 bytes per texel with the displacement in the fourth.
+void BuildNoiseDisplacement(unsigned int size, std::vector<unsigned char>& displacementmap);
+// Fill rays with numRays rays against a size x size heightmap scaled by scale. The first half are picking rays for a
+// block of pixels from a camera in one corner looking across the terrain, a row of pixels after another, so packets hold
+// neighbouring pixels. The second half are line of sight tests between random points a little above the terrain.
+void BuildTerrainRays(const TerrainSurface& surface, unsigned int size, float scale, unsigned int numRays, std::vector<HeightfieldRay>& rays);
@@ -0,0 +1,87 @@
+/*
+TerrainEditBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Times brush strokes on a synthetic heightmap, along with the incremental updates of the mesh and
+				the pyramid they need, against rebuilding them from scratch.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "TerrainEdit.h"
+#include "TerrainMesh.h"
+#include <chrono>
+#include <cstdlib>
+
+typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+// Returns the milliseconds between t0 and t1.
+static double CalcMs(TimePoint t0, TimePoint t1) {
+	return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// --size=<texels> sets the size of the heightmap and --strokes=<count> the strokes per brush radius.
+BENCHMARK(TerrainEdit, Strokes) {
+	unsigned int size = GetTestOption("size") ? (unsigned int)atoi(GetTestOption("size")) : 2048;
+	unsigned int numStrokes = GetTestOption("strokes") ? (unsigned int)atoi(GetTestOption("strokes")) : 256;
+
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(size, 0, heightmap);
+	float scale = (float)size / 16.0f;
+	TerrainMeshInfo info = CalcTerrainMeshInfo(size, size);
+	std::vector<Vertex> vertices(info.numVertices);
+	std::vector<unsigned int> indices(info.numIndices);
+	BuildTerrainMesh(heightmap.data(), size, size, scale, 0, info, vertices.data(), indices.data());
+	TerrainSurface surface(heightmap.data(), size, size, scale, nullptr, 0, 0);
+	HeightfieldRayCaster caster(&surface);
+
+	printf("  %u strokes per radius on %u x %u, in ms per stroke.\n", numStrokes, size, size);
+	printf("  radius    texels     brush      mesh   pyramid     worst\n");
+	unsigned int seed = 12345;
+	for (float radius : { 8.0f, 32.0f, 128.0f }) {
+		double msBrush = 0.0, msMesh = 0.0, msPyramid = 0.0, msWorst = 0.0;
+		unsigned long long numTexels = 0;
+		for (unsigned int s = 0; s < numStrokes; ++s) {
+			TerrainBrush brush;
+			brush.mode = (TerrainBrushMode)(s % 4);
+			seed = seed * 1664525u + 1013904223u;
+			brush.x = (float)(seed >> 8) / 16777216.0f * (float)size;
+			seed = seed * 1664525u + 1013904223u;
+			brush.y = (float)(seed >> 8) / 16777216.0f * (float)size;
+			brush.radius = radius;
+			brush.strength = 0.05f * scale;
+			brush.height = 0.5f * scale;
+
+			TexelRect dirty;
+			auto tStart = std::chrono::high_resolution_clock::now();
+			bool isChanged = ApplyTerrainBrush(heightmap.data(), size, size, scale, brush, dirty);
+			auto tBrush = std::chrono::high_resolution_clock::now();
+			if (isChanged) {
+				TerrainMeshRegion changed;
+				UpdateTerrainMeshRegion(heightmap.data(), size, size, scale, info, dirty.x0, dirty.y0, dirty.x1, dirty.y1, vertices.data(), changed);
+			}
+			auto tMesh = std::chrono::high_resolution_clock::now();
+			if (isChanged) {
+				caster.UpdateRegion(dirty.x0, dirty.y0, dirty.x1, dirty.y1);
+				numTexels += (unsigned long long)(dirty.x1 - dirty.x0) * (dirty.y1 - dirty.y0);
+			}
+			auto tPyramid = std::chrono::high_resolution_clock::now();
+
+			msBrush += CalcMs(tStart, tBrush);
+			msMesh += CalcMs(tBrush, tMesh);
+			msPyramid += CalcMs(tMesh, tPyramid);
+			msWorst = fmax(msWorst, CalcMs(tStart, tPyramid));
+		}
+		printf("  %6.0f %9.0f %9.3f %9.3f %9.3f %9.3f\n", radius, (double)numTexels / numStrokes, msBrush / numStrokes,
+			msMesh / numStrokes, msPyramid / numStrokes, msWorst);
+	}
+
+	// rebuilding both from scratch, for comparison.
+	auto tStart = std::chrono::high_resolution_clock::now();
+	BuildTerrainMesh(heightmap.data(), size, size, scale, 1, info, vertices.data(), indices.data());
+	auto tMesh = std::chrono::high_resolution_clock::now();
+	HeightfieldRayCaster casterRebuilt(&surface);
+	auto tPyramid = std::chrono::high_resolution_clock::now();
+	printf("  rebuild mesh on one thread %9.3f ms, pyramid %9.3f ms\n", CalcMs(tStart, tMesh), CalcMs(tMesh, tPyramid));
+}
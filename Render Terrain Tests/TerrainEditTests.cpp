@@ -0,0 +1,175 @@
+/*
+TerrainEditTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests the terrain brushes, and the incremental mesh and pyramid updates after strokes against
+				rebuilding them from scratch.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "TerrainEdit.h"
+#include "TerrainMesh.h"
+#include <cstring>
+
+static const unsigned int SIZE_TERRAIN = 256;
+
+// Returns a brush of mode at (x, y), with the strength and flatten height scaled to the terrain.
+static TerrainBrush MakeBrush(TerrainBrushMode mode, float x, float y, float radius, float scale) {
+	TerrainBrush brush;
+	brush.mode = mode;
+	brush.x = x;
+	brush.y = y;
+	brush.radius = radius;
+	brush.strength = 0.05f * scale;
+	brush.height = 0.5f * scale;
+	return brush;
+}
+
+TEST(TerrainEdit, RaiseAndLower) {
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(SIZE_TERRAIN, 0, heightmap);
+	std::vector<unsigned char> original = heightmap;
+	float scale = (float)SIZE_TERRAIN / 16.0f;
+
+	TexelRect dirty;
+	REQUIRE(ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, MakeBrush(BRUSH_RAISE, 100.0f, 80.0f, 12.0f, scale), dirty));
+	CHECK(!dirty.IsEmpty());
+
+	// nothing moves down, nothing outside of dirty moves, and only the height byte is touched.
+	unsigned int numRaised = 0, numWrong = 0;
+	for (unsigned int y = 0; y < SIZE_TERRAIN; ++y) {
+		for (unsigned int x = 0; x < SIZE_TERRAIN; ++x) {
+			size_t i = ((size_t)y * SIZE_TERRAIN + x) * 4;
+			bool isInside = x >= dirty.x0 && x < dirty.x1 && y >= dirty.y0 && y < dirty.y1;
+			if (heightmap[i] < original[i]) ++numWrong;
+			if (heightmap[i] != original[i] && !isInside) ++numWrong;
+			if (memcmp(&heightmap[i + 1], &original[i + 1], 3) != 0) ++numWrong;
+			if (heightmap[i] > original[i]) ++numRaised;
+		}
+	}
+	CHECK(numWrong == 0);
+	CHECK(numRaised > 0);
+
+	// the brush reaches no further than its radius.
+	CHECK(dirty.x0 >= 100 - 12 - 1 && dirty.x1 <= 100 + 12 + 1);
+	CHECK(dirty.y0 >= 80 - 12 - 1 && dirty.y1 <= 80 + 12 + 1);
+
+	// lowering the same spot never goes above the raised terrain.
+	std::vector<unsigned char> raised = heightmap;
+	REQUIRE(ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, MakeBrush(BRUSH_LOWER, 100.0f, 80.0f, 12.0f, scale), dirty));
+	numWrong = 0;
+	for (size_t i = 0; i < heightmap.size(); i += 4) {
+		if (heightmap[i] > raised[i]) ++numWrong;
+	}
+	CHECK(numWrong == 0);
+}
+
+TEST(TerrainEdit, StrokesOffTheMap) {
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(SIZE_TERRAIN, 0, heightmap);
+	std::vector<unsigned char> original = heightmap;
+	float scale = (float)SIZE_TERRAIN / 16.0f;
+
+	// strokes that miss the terrain, or have no radius or strength, change nothing.
+	TexelRect dirty;
+	CHECK(!ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, MakeBrush(BRUSH_RAISE, -50.0f, 10.0f, 20.0f, scale), dirty));
+	CHECK(dirty.IsEmpty());
+	CHECK(!ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, MakeBrush(BRUSH_RAISE, 10.0f, 400.0f, 20.0f, scale), dirty));
+	CHECK(!ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, MakeBrush(BRUSH_RAISE, 10.0f, 10.0f, 0.0f, scale), dirty));
+	TerrainBrush weak = MakeBrush(BRUSH_RAISE, 10.0f, 10.0f, 20.0f, scale);
+	weak.strength = 0.0f;
+	CHECK(!ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, weak, dirty));
+	CHECK(heightmap == original);
+
+	// a stroke over the corner stays on the map.
+	REQUIRE(ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, MakeBrush(BRUSH_RAISE, 0.0f, 0.0f, 20.0f, scale), dirty));
+	CHECK(dirty.x0 == 0 && dirty.y0 == 0);
+	CHECK(dirty.x1 <= SIZE_TERRAIN && dirty.y1 <= SIZE_TERRAIN);
+}
+
+TEST(TerrainEdit, FlattenAndSmooth) {
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(SIZE_TERRAIN, 0, heightmap);
+	float scale = (float)SIZE_TERRAIN / 16.0f;
+
+	// enough flattening strokes bring the centre to the flatten height.
+	TexelRect dirty;
+	TerrainBrush flatten = MakeBrush(BRUSH_FLATTEN, 128.0f, 128.0f, 16.0f, scale);
+	for (int i = 0; i < 100; ++i) {
+		ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, flatten, dirty);
+	}
+	float h = (float)heightmap[((size_t)128 * SIZE_TERRAIN + 128) * 4] / 255.0f * scale;
+	CHECK_NEAR(h, flatten.height, scale / 255.0f);
+
+	// smoothing a lone spike brings it down towards its neighbours.
+	std::vector<unsigned char> spike((size_t)SIZE_TERRAIN * SIZE_TERRAIN * 4, 0);
+	spike[((size_t)64 * SIZE_TERRAIN + 64) * 4] = 255;
+	TerrainBrush smooth = MakeBrush(BRUSH_SMOOTH, 64.5f, 64.5f, 4.0f, scale);
+	REQUIRE(ApplyTerrainBrush(spike.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, smooth, dirty));
+	CHECK(spike[((size_t)64 * SIZE_TERRAIN + 64) * 4] < 255);
+}
+
+// The mesh and pyramid updated after each stroke have to come out the same as rebuilding them from the edited heightmap.
+TEST(TerrainEdit, IncrementalUpdatesMatchRebuild) {
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(SIZE_TERRAIN, 0, heightmap);
+	float scale = (float)SIZE_TERRAIN / 16.0f;
+
+	TerrainMeshInfo info = CalcTerrainMeshInfo(SIZE_TERRAIN, SIZE_TERRAIN);
+	std::vector<Vertex> vertices(info.numVertices);
+	std::vector<unsigned int> indices(info.numIndices);
+	BuildTerrainMesh(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, 1, info, vertices.data(), indices.data());
+	TerrainSurface surface(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, nullptr, 0, 0);
+	HeightfieldRayCaster caster(&surface);
+
+	// strokes land all over the terrain, edges included, cycling through the modes.
+	unsigned int seed = 12345;
+	unsigned int numChanged = 0;
+	for (unsigned int s = 0; s < 200; ++s) {
+		seed = seed * 1664525u + 1013904223u;
+		float x = (float)(seed >> 8) / 16777216.0f * (float)SIZE_TERRAIN;
+		seed = seed * 1664525u + 1013904223u;
+		float y = (float)(seed >> 8) / 16777216.0f * (float)SIZE_TERRAIN;
+		TerrainBrush brush = MakeBrush((TerrainBrushMode)(s % 4), x, y, 4.0f + (float)(s % 5) * 6.0f, scale);
+
+		TexelRect dirty;
+		if (!ApplyTerrainBrush(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, brush, dirty)) continue;
+		++numChanged;
+		TerrainMeshRegion changed;
+		UpdateTerrainMeshRegion(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, info, dirty.x0, dirty.y0, dirty.x1, dirty.y1,
+			vertices.data(), changed);
+		caster.UpdateRegion(dirty.x0, dirty.y0, dirty.x1, dirty.y1);
+	}
+	CHECK(numChanged > 100);
+
+	TerrainMeshInfo infoRebuilt = CalcTerrainMeshInfo(SIZE_TERRAIN, SIZE_TERRAIN);
+	std::vector<Vertex> verticesRebuilt(infoRebuilt.numVertices);
+	BuildTerrainMesh(heightmap.data(), SIZE_TERRAIN, SIZE_TERRAIN, scale, 1, infoRebuilt, verticesRebuilt.data(), indices.data());
+	HeightfieldRayCaster casterRebuilt(&surface);
+
+	// the control points have to match exactly. The skirts keep their old base, so only the tops of their bounds are compared.
+	unsigned long numVertsInTerrain = info.numX * info.numY;
+	CHECK(memcmp(vertices.data(), verticesRebuilt.data(), numVertsInTerrain * sizeof(Vertex)) == 0);
+	unsigned int numSkirtMismatches = 0;
+	for (unsigned long i = numVertsInTerrain; i < info.numVertices; ++i) {
+		if (vertices[i].skirt == 0) continue;
+		if (memcmp(&vertices[i].aabbmax, &verticesRebuilt[i].aabbmax, sizeof(XMFLOAT3)) != 0) ++numSkirtMismatches;
+	}
+	CHECK(numSkirtMismatches == 0);
+
+	// pyramids with the same bounds give exactly the same hits.
+	std::vector<HeightfieldRay> rays;
+	BuildTerrainRays(surface, SIZE_TERRAIN, scale, 4096, rays);
+	unsigned int numHits = 0, numMismatches = 0;
+	for (auto& ray : rays) {
+		HeightfieldHit hit, hitRebuilt;
+		caster.CastRay(ray, false, hit);
+		casterRebuilt.CastRay(ray, false, hitRebuilt);
+		if (hit.isHit != hitRebuilt.isHit || (hit.isHit && hit.t != hitRebuilt.t)) ++numMismatches;
+		if (hit.isHit) ++numHits;
+	}
+	CHECK(numMismatches == 0);
+	CHECK(numHits > 0);
+}
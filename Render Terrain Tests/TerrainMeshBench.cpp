@@ -0,0 +1,48 @@
+/*
+TerrainMeshBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Times building the terrain mesh for a synthetic heightmap on one thread and on every hardware thread,
+				up to the 16k x 16k heightmap startup is measured on.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "TerrainMesh.h"
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// --size=<texels> builds only a heightmap of that size instead of 1k, 4k and 16k.
+BENCHMARK(TerrainMesh, Build) {
+	unsigned int numThreads = std::thread::hardware_concurrency();
+	std::vector<unsigned int> listSizes = { 1024, 4096, 16384 };
+	if (GetTestOption("size")) listSizes = { (unsigned int)atoi(GetTestOption("size")) };
+	for (unsigned int size : listSizes) {
+		std::vector<unsigned char> heightmap;
+		BuildRollingHills(size, 0, heightmap);
+
+		float scale = (float)size / 16.0f;
+		TerrainMeshInfo infoSerial = CalcTerrainMeshInfo(size, size);
+		TerrainMeshInfo infoParallel = infoSerial;
+		std::vector<Vertex> verticesSerial(infoSerial.numVertices), verticesParallel(infoSerial.numVertices);
+		std::vector<unsigned int> indicesSerial(infoSerial.numIndices), indicesParallel(infoSerial.numIndices);
+
+		auto tStart = std::chrono::high_resolution_clock::now();
+		BuildTerrainMesh(heightmap.data(), size, size, scale, 1, infoSerial, verticesSerial.data(), indicesSerial.data());
+		auto tSerial = std::chrono::high_resolution_clock::now();
+		BuildTerrainMesh(heightmap.data(), size, size, scale, numThreads, infoParallel, verticesParallel.data(), indicesParallel.data());
+		auto tParallel = std::chrono::high_resolution_clock::now();
+
+		double msSerial = std::chrono::duration<double, std::milli>(tSerial - tStart).count();
+		double msParallel = std::chrono::duration<double, std::milli>(tParallel - tSerial).count();
+		printf("  %5u x %5u: %8.2f ms on 1 thread, %8.2f ms on %u threads, %.2fx.\n", size, size, msSerial, msParallel, numThreads,
+			msSerial / msParallel);
+
+		CHECK(memcmp(verticesSerial.data(), verticesParallel.data(), verticesSerial.size() * sizeof(Vertex)) == 0);
+		CHECK(indicesSerial == indicesParallel);
+	}
+}
@@ -0,0 +1,72 @@
+/*
+TerrainMeshTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests the terrain mesh against the patch enumeration in PatchGrid.h.
+*/
+#include "Test.h"
+#include "TerrainMesh.h"
+#include "PatchGrid.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Fill a w x h heightmap of 4 bytes per texel with random heights.
+static void BuildHeightMap(unsigned int w, unsigned int h, unsigned int seed, std::vector<unsigned char>& heightmap) {
+	std::mt19937 rng(seed);
+	heightmap.assign((size_t)w * h * 4, 0);
+	for (size_t i = 0; i < (size_t)w * h; ++i) {
+		heightmap[i * 4] = (unsigned char)(rng() % 256);
+	}
+}
+
+// The procedural vertex shader and PatchGrid.h have to enumerate exactly the same patches as the index buffer.
+TEST(TerrainMesh, IndicesMatchPatchGrid) {
+	unsigned int sizes[][2] = { { 64, 64 }, { 256, 128 }, { 520, 264 }, { 96, 1000 }, { 1024, 1024 } };
+	for (auto& size : sizes) {
+		std::vector<unsigned char> heightmap;
+		BuildHeightMap(size[0], size[1], size[0] + size[1], heightmap);
+
+		TerrainMeshInfo info = CalcTerrainMeshInfo(size[0], size[1]);
+		REQUIRE(CalcNumGridPatches(info.numX, info.numY) * 4 == info.numIndices);
+
+		std::vector<Vertex> vertices(info.numVertices);
+		std::vector<unsigned int> indices(info.numIndices);
+		BuildTerrainMesh(heightmap.data(), size[0], size[1], (float)size[0] / 16.0f, 2, info, vertices.data(), indices.data());
+
+		std::vector<unsigned int> grid(info.numIndices);
+		WritePatchGridIndices(info.numX, info.numY, grid.data());
+		unsigned long numMismatches = 0;
+		for (unsigned long i = 0; i < info.numIndices; ++i) {
+			if (indices[i] != grid[i]) ++numMismatches;
+			if (indices[i] != CalcPatchControlPoint(info.numX, info.numY, i / 4, i % 4)) ++numMismatches;
+			if (indices[i] >= info.numVertices) ++numMismatches;
+		}
+		CHECK(numMismatches == 0);
+	}
+}
+
+// The mesh is built in bands of rows on worker threads, and must come out the same however many there are.
+TEST(TerrainMesh, SameOnAnyThreadCount) {
+	std::vector<unsigned char> heightmap;
+	BuildHeightMap(520, 264, 9, heightmap);
+
+	TerrainMeshInfo infoSerial = CalcTerrainMeshInfo(520, 264);
+	std::vector<Vertex> verticesSerial(infoSerial.numVertices);
+	std::vector<unsigned int> indicesSerial(infoSerial.numIndices);
+	BuildTerrainMesh(heightmap.data(), 520, 264, 32.0f, 1, infoSerial, verticesSerial.data(), indicesSerial.data());
+
+	for (unsigned int numThreads : { 2u, 3u, 8u, 64u }) {
+		TerrainMeshInfo info = CalcTerrainMeshInfo(520, 264);
+		std::vector<Vertex> vertices(info.numVertices);
+		std::vector<unsigned int> indices(info.numIndices);
+		BuildTerrainMesh(heightmap.data(), 520, 264, 32.0f, numThreads, info, vertices.data(), indices.data());
+
+		CHECK(memcmp(vertices.data(), verticesSerial.data(), vertices.size() * sizeof(Vertex)) == 0);
+		CHECK(indices == indicesSerial);
+		CHECK(info.zBounds.x == infoSerial.zBounds.x && info.zBounds.y == infoSerial.zBounds.y);
+		CHECK(info.hBase == infoSerial.hBase);
+	}
+}
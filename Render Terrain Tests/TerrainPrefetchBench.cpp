@@ -0,0 +1,58 @@
+/*
+TerrainPrefetchBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Replays camera paths against a loader of fixed latency and bandwidth, with and without prediction,
+				and measures the miss rate and accuracy of each.
+*/
+#include "Test.h"
+#include "PrefetchReplay.h"
+#include <cstdio>
+#include <cstdlib>
+
+// Print a run's results.
+static void PrintRun(const char* name, const PrefetchRun& run) {
+	printf("    %-10s miss %6.2f%%  frames with a miss %6.2f%%  accuracy %5.1f%%  %8.0f MB loaded  Update() %.3f ms\n", name,
+		run.missRate * 100.0, run.frameMissRate * 100.0, run.accuracy * 100.0, run.mbLoaded, run.msUpdate);
+}
+
+// Pass --path=<file> to replay a path recorded with SIM_CAMERA_PATH_FILE instead of the built ones. --latency=<ms> and
+// --bandwidth=<MB/s> set the loader's speed.
+BENCHMARK(TerrainPrefetch, Replay) {
+	double msLatency = GetTestOption("latency") ? atof(GetTestOption("latency")) : LOAD_LATENCY_MS;
+	double mbPerSecond = GetTestOption("bandwidth") ? atof(GetTestOption("bandwidth")) : LOAD_MB_PER_SECOND;
+	PrefetchParams params = GetDefaultPrefetchParams(REGION_SIZE);
+
+	std::vector<std::vector<CameraSample>> paths;
+	std::vector<const char*> names;
+	const char* fn = GetTestOption("path");
+	if (fn) {
+		paths.emplace_back();
+		REQUIRE(LoadCameraPath(fn, paths.back()) && !paths.back().empty());
+		names.push_back("recorded");
+	}
+	else {
+		const char* kinds[] = { "fly", "walk", "look" };
+		for (unsigned int kind = 0; kind < 3; ++kind) {
+			paths.emplace_back();
+			BuildCameraPath(kind, NUM_REGIONS_SIDE * REGION_SIZE, 120.0, 60.0, paths.back());
+			names.push_back(kinds[kind]);
+		}
+	}
+
+	printf("  %u x %u regions of %.0f, %u KB each, %.0f ms latency, %.0f MB/s shared, %u in flight.\n", NUM_REGIONS_SIDE,
+		NUM_REGIONS_SIDE, REGION_SIZE, BYTES_PER_REGION / 1024, msLatency, mbPerSecond, params.maxInFlight);
+	for (size_t p = 0; p < paths.size(); ++p) {
+		float distance;
+		float error = CalcPredictionError(paths[p], params.lookAhead, distance);
+		printf("  %s: %.0f s, %.0f units, forecasts %.1f units out %.1f s ahead.\n", names[p], paths[p].back().t - paths[p].front().t,
+			distance, error, params.lookAhead);
+
+		RegionPrefetcher reactive(NUM_REGIONS_SIDE, NUM_REGIONS_SIDE, REGION_SIZE, params, false);
+		PrintRun("reactive", ReplayPrefetch(paths[p], reactive, params.maxInFlight, BYTES_PER_REGION, msLatency, mbPerSecond));
+		RegionPrefetcher predictive(NUM_REGIONS_SIDE, NUM_REGIONS_SIDE, REGION_SIZE, params, true);
+		PrintRun("predictive", ReplayPrefetch(paths[p], predictive, params.maxInFlight, BYTES_PER_REGION, msLatency, mbPerSecond));
+	}
+}
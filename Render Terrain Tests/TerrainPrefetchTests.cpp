@@ -0,0 +1,101 @@
+/*
+TerrainPrefetchTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests the camera forecasts, recorded paths, and that prefetching along the forecast path misses
+				fewer regions than loading what is in view, within its budgets.
+*/
+#include "Test.h"
+#include "PrefetchReplay.h"
+#include <cmath>
+#include <cstdio>
+
+TEST(TerrainPrefetch, PredictsSteadyMotion) {
+	// a camera flying in a straight line, then one turning at a steady rate on the spot.
+	CameraPredictor straight, turning;
+	for (int i = 0; i <= 60; ++i) {
+		double t = i / 60.0;
+		straight.AddSample({ t, XMFLOAT3(100.0f + 50.0f * (float)t, 200.0f - 20.0f * (float)t, 60.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) });
+		float yaw = 0.8f * (float)t;
+		turning.AddSample({ t, XMFLOAT3(10.0f, 10.0f, 60.0f), XMFLOAT3(cosf(yaw), sinf(yaw), 0.0f) });
+	}
+
+	CameraSample s = straight.Predict(1.0);
+	CHECK_NEAR(s.t, 2.0, 1e-6);
+	CHECK_NEAR(s.eye.x, 200.0f, 0.1f);
+	CHECK_NEAR(s.eye.y, 160.0f, 0.1f);
+	CHECK_NEAR(s.eye.z, 60.0f, 0.1f);
+
+	s = turning.Predict(0.5);
+	CHECK_NEAR(s.eye.x, 10.0f, 0.1f);
+	CHECK_NEAR(s.look.x, cosf(1.2f), 0.01f);
+	CHECK_NEAR(s.look.y, sinf(1.2f), 0.01f);
+}
+
+TEST(TerrainPrefetch, PathsRoundTrip) {
+	std::vector<CameraSample> path, loaded;
+	BuildCameraPath(1, NUM_REGIONS_SIDE * REGION_SIZE, 5.0, 30.0, path);
+	REQUIRE(path.size() >= 150);
+	REQUIRE(SaveCameraPath("TerrainPrefetchTests.path", path));
+	REQUIRE(LoadCameraPath("TerrainPrefetchTests.path", loaded));
+	std::remove("TerrainPrefetchTests.path");
+
+	REQUIRE(loaded.size() == path.size());
+	float maxError = 0.0f;
+	for (size_t i = 0; i < path.size(); ++i) {
+		maxError = fmaxf(maxError, (float)fabs(loaded[i].t - path[i].t));
+		maxError = fmaxf(maxError, fabsf(loaded[i].eye.x - path[i].eye.x) + fabsf(loaded[i].eye.y - path[i].eye.y) + fabsf(loaded[i].eye.z - path[i].eye.z));
+		maxError = fmaxf(maxError, fabsf(loaded[i].look.x - path[i].look.x) + fabsf(loaded[i].look.y - path[i].look.y) + fabsf(loaded[i].look.z - path[i].look.z));
+	}
+	CHECK(maxError < 1e-3f);
+	CHECK(!LoadCameraPath("TerrainPrefetchTests.missing", loaded));
+}
+
+// On every kind of path, prediction misses fewer regions than loading only what is in view, and stays within its budgets.
+TEST(TerrainPrefetch, PredictionMissesLess) {
+	PrefetchParams params = GetDefaultPrefetchParams(REGION_SIZE);
+	for (unsigned int kind = 0; kind < 3; ++kind) {
+		std::vector<CameraSample> path;
+		BuildCameraPath(kind, NUM_REGIONS_SIDE * REGION_SIZE, 30.0, 60.0, path);
+
+		RegionPrefetcher reactive(NUM_REGIONS_SIDE, NUM_REGIONS_SIDE, REGION_SIZE, params, false);
+		PrefetchRun runReactive = ReplayPrefetch(path, reactive, params.maxInFlight, BYTES_PER_REGION, LOAD_LATENCY_MS, LOAD_MB_PER_SECOND);
+		RegionPrefetcher predictive(NUM_REGIONS_SIDE, NUM_REGIONS_SIDE, REGION_SIZE, params, true);
+		PrefetchRun runPredictive = ReplayPrefetch(path, predictive, params.maxInFlight, BYTES_PER_REGION, LOAD_LATENCY_MS, LOAD_MB_PER_SECOND);
+
+		CHECK(runReactive.stats.numNeeded > 0);
+		CHECK(runPredictive.missRate < runReactive.missRate);
+		CHECK(runPredictive.frameMissRate < runReactive.frameMissRate);
+		CHECK(runPredictive.accuracy > 0.7);
+		for (auto* run : { &runReactive, &runPredictive }) {
+			CHECK(run->maxInFlight <= params.maxInFlight);
+			CHECK(run->maxResident <= params.maxResident);
+			CHECK(run->stats.numLoaded == run->stats.numResident + run->stats.numEvicted);
+		}
+	}
+}
+
+// Once the camera stops, everything it needs gets loaded and nothing more is asked for.
+TEST(TerrainPrefetch, SettlesWhenStill) {
+	PrefetchParams params = GetDefaultPrefetchParams(REGION_SIZE);
+	std::vector<CameraSample> path;
+	for (int i = 0; i < 300; ++i) {
+		path.push_back({ i / 60.0, XMFLOAT3(4000.0f, 4000.0f, 60.0f), XMFLOAT3(0.6f, 0.8f, 0.0f) });
+	}
+
+	RegionPrefetcher prefetcher(NUM_REGIONS_SIDE, NUM_REGIONS_SIDE, REGION_SIZE, params, true);
+	PrefetchRun run = ReplayPrefetch(path, prefetcher, params.maxInFlight, BYTES_PER_REGION, LOAD_LATENCY_MS, LOAD_MB_PER_SECOND);
+	CHECK(run.stats.numInFlight == 0);
+	CHECK(prefetcher.CheckNeeded(path.back()) == 0);
+	CHECK(run.stats.numEvicted == 0);
+	CHECK(run.accuracy == 1.0);
+
+	std::vector<PrefetchRequest> requests;
+	std::vector<unsigned int> cancels;
+	CameraSample s = path.back();
+	s.t += 1.0 / 60.0;
+	prefetcher.Update(s, requests, cancels);
+	CHECK(requests.empty() && cancels.empty());
+}
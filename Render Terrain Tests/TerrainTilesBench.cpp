@@ -0,0 +1,79 @@
+/*
+TerrainTilesBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Times matching the seams of a world of synthetic tiles and culling the tiles.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "TerrainTiles.h"
+#include <chrono>
+#include <cstdlib>
+
+// --size=<texels> sets the size of each tile's heightmap and --tiles=<count> the tiles along each side of the world.
+BENCHMARK(TerrainTiles, MatchAndCull) {
+	unsigned int size = GetTestOption("size") ? (unsigned int)atoi(GetTestOption("size")) : 1024;
+	unsigned int numTilesSide = GetTestOption("tiles") ? (unsigned int)atoi(GetTestOption("tiles")) : 4;
+
+	TerrainTileGrid grid(numTilesSide, numTilesSide, size, size);
+	unsigned int numTiles = grid.GetNumTiles();
+	std::vector<std::vector<unsigned char>> listData(numTiles);
+	std::vector<unsigned char*> listHeightMaps(numTiles);
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		BuildRollingHills(size, t, listData[t]);
+		listHeightMaps[t] = listData[t].data();
+	}
+
+	auto tStart = std::chrono::high_resolution_clock::now();
+	TileEdgeStats stats = MatchTileEdges(listHeightMaps.data(), grid, TERRAIN_TILE_BLEND_BAND);
+	double msMatch = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	float scale = (float)size / 16.0f;
+	TerrainMeshInfo info = CalcTerrainMeshInfo(size, size);
+	std::vector<Vertex> vertices(info.numVertices);
+	std::vector<unsigned int> indices(info.numIndices);
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		TerrainMeshInfo infoTile = info;
+		BuildTerrainMesh(listHeightMaps[t], size, size, scale, 0, infoTile, vertices.data(), indices.data());
+		grid.SetBounds(t, XMFLOAT3(0.0f, 0.0f, infoTile.hBase), XMFLOAT3((float)size, (float)size, infoTile.zBounds.y));
+	}
+
+	// views from all over the world, looking every which way, with a 90 degree field of view out to a couple of tiles.
+	XMFLOAT3 worldMin, worldMax;
+	grid.GetWorldBounds(worldMin, worldMax);
+	std::vector<unsigned int> visible(numTiles);
+	unsigned long long numVisible = 0;
+	const unsigned int numViews = 4096;
+	unsigned int seed = 12345;
+	auto tCull = std::chrono::high_resolution_clock::now();
+	for (unsigned int v = 0; v < numViews; ++v) {
+		seed = seed * 1664525u + 1013904223u;
+		float ex = worldMin.x + (float)(seed >> 8) / 16777216.0f * (worldMax.x - worldMin.x);
+		seed = seed * 1664525u + 1013904223u;
+		float ey = worldMin.y + (float)(seed >> 8) / 16777216.0f * (worldMax.y - worldMin.y);
+		seed = seed * 1664525u + 1013904223u;
+		float angle = (float)(seed >> 8) / 16777216.0f * XM_2PI;
+		XMFLOAT3 eye(ex, ey, worldMax.z);
+		float dx = cosf(angle), dy = sinf(angle);
+
+		XMFLOAT4 planes[3];
+		const float side = 0.70710678f;
+		planes[0] = XMFLOAT4(side * (dx - dy), side * (dy + dx), 0.0f, 0.0f);
+		planes[1] = XMFLOAT4(side * (dx + dy), side * (dy - dx), 0.0f, 0.0f);
+		planes[2] = XMFLOAT4(-dx, -dy, 0.0f, 0.0f);
+		for (int p = 0; p < 3; ++p) {
+			planes[p].w = -(planes[p].x * eye.x + planes[p].y * eye.y);
+		}
+		planes[2].w += 2.0f * (float)size;
+
+		numVisible += grid.Cull(planes, 3, 1, eye, visible.data());
+	}
+	double usCull = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - tCull).count() / numViews;
+
+	printf("  %u x %u tiles of %u x %u.\n", numTilesSide, numTilesSide, size, size);
+	printf("  match edges %9.3f ms, %u seams, %llu texels changed, largest step %u\n", msMatch, stats.numEdges,
+		stats.numTexelsChanged, stats.maxStep);
+	printf("  cull        %9.3f us, %.1f tiles in view on average\n", usCull, (double)numVisible / numViews);
+}
@@ -0,0 +1,293 @@
+/*
+TerrainTilesTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests the layout of a world of synthetic tiles, that their seams meet once matched and stay matched
+				after brush strokes, and culling the tiles.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "TerrainTiles.h"
+#include "BoundingVolume.h"
+#include <algorithm>
+
+static const unsigned int SIZE_TILE = 256;
+
+// A numX x numY world of synthetic tiles with their edges matched and their meshes built.
+struct TestWorld {
+	TerrainTileGrid								grid;
+	TerrainMeshInfo								info;
+	float										scale;
+	std::vector<std::vector<unsigned char>>		listHeightMaps;
+	std::vector<std::vector<Vertex>>			listVertices;
+	TileEdgeStats								edges;
+
+	TestWorld(unsigned int numX, unsigned int numY) : grid(numX, numY, SIZE_TILE, SIZE_TILE) {
+		scale = (float)SIZE_TILE / 16.0f;
+		unsigned int numTiles = grid.GetNumTiles();
+		listHeightMaps.resize(numTiles);
+		std::vector<unsigned char*> listData(numTiles);
+		for (unsigned int t = 0; t < numTiles; ++t) {
+			BuildRollingHills(SIZE_TILE, t, listHeightMaps[t]);
+			listData[t] = listHeightMaps[t].data();
+		}
+		edges = MatchTileEdges(listData.data(), grid, TERRAIN_TILE_BLEND_BAND);
+
+		info = CalcTerrainMeshInfo(SIZE_TILE, SIZE_TILE);
+		std::vector<unsigned int> indices(info.numIndices);
+		listVertices.resize(numTiles);
+		for (unsigned int t = 0; t < numTiles; ++t) {
+			TerrainMeshInfo infoTile = info;
+			listVertices[t].resize(info.numVertices);
+			BuildTerrainMesh(listHeightMaps[t].data(), SIZE_TILE, SIZE_TILE, scale, 1, infoTile, listVertices[t].data(), indices.data());
+			grid.SetBounds(t, XMFLOAT3(0.0f, 0.0f, infoTile.hBase), XMFLOAT3((float)SIZE_TILE, (float)SIZE_TILE, infoTile.zBounds.y));
+		}
+		for (unsigned int t = 0; t < numTiles; ++t) {
+			MatchErrors(t);
+		}
+	}
+
+	// Match the errors of tile t's control points with every neighbour's, as TerrainWorld::Edit() does.
+	void MatchErrors(unsigned int t) {
+		unsigned int numX = grid.GetNumTilesX();
+		unsigned int x = t % numX;
+		unsigned int y = t / numX;
+		if (x > 0) MatchTileEdgeErrors(listVertices[t - 1].data(), listVertices[t].data(), info, true);
+		if (x + 1 < numX) MatchTileEdgeErrors(listVertices[t].data(), listVertices[t + 1].data(), info, true);
+		if (y > 0) MatchTileEdgeErrors(listVertices[t - numX].data(), listVertices[t].data(), info, false);
+		if (y + 1 < grid.GetNumTilesY()) MatchTileEdgeErrors(listVertices[t].data(), listVertices[t + numX].data(), info, false);
+	}
+
+	// Returns the number of control points along the seams whose heights or errors differ from the neighbour's.
+	unsigned int CountSeamMismatches() {
+		unsigned int numX = grid.GetNumTilesX();
+		unsigned int numTiles = grid.GetNumTiles();
+		unsigned int numMismatches = 0;
+		for (unsigned int t = 0; t < numTiles; ++t) {
+			for (int isAlongX = 1; isAlongX >= 0; --isAlongX) {
+				unsigned int n = isAlongX ? t + 1 : t + numX;
+				if (isAlongX ? (t % numX + 1 == numX) : (n >= numTiles)) continue;
+
+				int num = isAlongX ? info.numY : info.numX;
+				for (int i = 0; i < num; ++i) {
+					Vertex& va = isAlongX ? listVertices[t][i * info.numX + info.numX - 1] : listVertices[t][(info.numY - 1) * info.numX + i];
+					Vertex& vb = isAlongX ? listVertices[n][i * info.numX] : listVertices[n][i];
+					if (va.position.z != vb.position.z || va.error != vb.error) ++numMismatches;
+				}
+			}
+		}
+		return numMismatches;
+	}
+};
+
+TEST(TerrainTiles, Layout) {
+	TerrainTileGrid grid(3, 2, SIZE_TILE, SIZE_TILE);
+	CHECK(grid.GetNumTiles() == 6);
+	CHECK(grid.GetStrideX() == (float)(SIZE_TILE - TERRAIN_GRID_SPACING));
+
+	// each tile starts on the last control point of the one before.
+	XMFLOAT2 origin = grid.GetOrigin(4);
+	CHECK(origin.x == grid.GetStrideX() && origin.y == grid.GetStrideY());
+	CHECK(grid.FindTile(origin.x + 1.0f, origin.y + 1.0f) == 4);
+	CHECK(grid.FindTile(0.0f, 0.0f) == 0);
+	CHECK(grid.FindTile(3.0f * grid.GetStrideX(), 2.0f * grid.GetStrideY()) == 5);
+	CHECK(grid.FindTile(-1.0f, 10.0f) == -1);
+	CHECK(grid.FindTile(10.0f, 2.0f * grid.GetStrideY() + 1.0f) == -1);
+
+	// only the sides along the edge of the world have skirts.
+	CHECK(grid.GetExposedSkirts(0) == (TERRAIN_SKIRT_X0 | TERRAIN_SKIRT_Y0));
+	CHECK(grid.GetExposedSkirts(1) == TERRAIN_SKIRT_Y0);
+	CHECK(grid.GetExposedSkirts(5) == (TERRAIN_SKIRT_X1 | TERRAIN_SKIRT_Y1));
+	TerrainTileGrid single(1, 1, SIZE_TILE, SIZE_TILE);
+	CHECK(single.GetExposedSkirts(0) == TERRAIN_SKIRT_ALL);
+}
+
+// Once matched, the control points and errors along every seam agree, and the displaced surfaces either side meet.
+TEST(TerrainTiles, SeamsMeet) {
+	TestWorld world(3, 2);
+	CHECK(world.edges.numEdges == 7);
+	CHECK(world.edges.maxStep > 0);
+	CHECK(world.CountSeamMismatches() == 0);
+
+	std::vector<unsigned char> displacement;
+	BuildNoiseDisplacement(64, displacement);
+	std::vector<TerrainSurface> listSurfaces;
+	for (unsigned int t = 0; t < world.grid.GetNumTiles(); ++t) {
+		listSurfaces.push_back(TerrainSurface(world.listHeightMaps[t].data(), SIZE_TILE, SIZE_TILE, world.scale, displacement.data(), 64, 64));
+		XMFLOAT2 origin = world.grid.GetOrigin(t);
+		listSurfaces[t].SetOrigin(origin.x, origin.y);
+	}
+
+	// points along each seam, between the control points as well as on them.
+	unsigned int numX = world.grid.GetNumTilesX();
+	float maxGap = 0.0f;
+	for (unsigned int t = 0; t < world.grid.GetNumTiles(); ++t) {
+		for (int isAlongX = 1; isAlongX >= 0; --isAlongX) {
+			unsigned int n = isAlongX ? t + 1 : t + numX;
+			if (isAlongX ? (t % numX + 1 == numX) : (n >= world.grid.GetNumTiles())) continue;
+
+			XMFLOAT2 origin = world.grid.GetOrigin(n);
+			float length = isAlongX ? world.grid.GetStrideY() : world.grid.GetStrideX();
+			for (unsigned int s = 0; s <= 256; ++s) {
+				float along = length * (float)s / 256.0f;
+				float x = isAlongX ? origin.x : origin.x + along;
+				float y = isAlongX ? origin.y + along : origin.y;
+				XMFLOAT3 pa = listSurfaces[t].GetDisplacedPosition(x, y);
+				XMFLOAT3 pb = listSurfaces[n].GetDisplacedPosition(x, y);
+				float gap = sqrtf((pa.x - pb.x) * (pa.x - pb.x) + (pa.y - pb.y) * (pa.y - pb.y) + (pa.z - pb.z) * (pa.z - pb.z));
+				maxGap = fmaxf(maxGap, gap);
+			}
+		}
+	}
+	CHECK(maxGap < 1e-3f);
+}
+
+TEST(TerrainTiles, BrushKeepsOffSeams) {
+	TerrainTileGrid grid(2, 2, SIZE_TILE, SIZE_TILE);
+	TerrainBrush brush = { BRUSH_RAISE, 100.0f, 100.0f, 20.0f, 1.0f, 0.0f };
+
+	// well inside a tile, the stroke is left alone.
+	CHECK(ClampTileBrush(brush, grid, 0).radius == 20.0f);
+	CHECK(ClampTileBrush(brush, grid, 3).radius == 20.0f);
+
+	// towards a seam, it shrinks to stop short of the texels matched along it.
+	brush.x = grid.GetStrideX() - 10.0f;
+	CHECK_NEAR(ClampTileBrush(brush, grid, 0).radius, 8.5f, 1e-4f);
+	brush.x = 10.0f;
+	CHECK(ClampTileBrush(brush, grid, 0).radius == 20.0f);
+	CHECK_NEAR(ClampTileBrush(brush, grid, 1).radius, 7.5f, 1e-4f);
+
+	// on a seam, or past it, there's nothing left. The edge of the world isn't a seam.
+	brush.x = grid.GetStrideX();
+	CHECK(ClampTileBrush(brush, grid, 0).radius == 0.0f);
+	brush.x = 0.0f;
+	CHECK(ClampTileBrush(brush, grid, 1).radius == 0.0f);
+	CHECK(ClampTileBrush(brush, grid, 0).radius == 20.0f);
+	brush.x = 100.0f;
+	brush.y = -30.0f;
+	CHECK(ClampTileBrush(brush, grid, 2).radius == 0.0f);
+	CHECK(ClampTileBrush(brush, grid, 0).radius == 20.0f);
+}
+
+// Strokes all over every tile, seams included, leave the seams matched once the errors are matched again.
+TEST(TerrainTiles, EditsKeepSeams) {
+	TestWorld world(2, 2);
+	std::vector<std::vector<unsigned char>> listBefore = world.listHeightMaps;
+
+	unsigned int seed = 777;
+	unsigned int numClamped = 0, numChanged = 0;
+	for (unsigned int s = 0; s < 400; ++s) {
+		unsigned int t = s % world.grid.GetNumTiles();
+		TerrainBrush brush;
+		brush.mode = (TerrainBrushMode)(s % 4);
+		seed = seed * 1664525u + 1013904223u;
+		brush.x = (float)(seed >> 8) / 16777216.0f * (float)SIZE_TILE;
+		seed = seed * 1664525u + 1013904223u;
+		brush.y = (float)(seed >> 8) / 16777216.0f * (float)SIZE_TILE;
+		brush.radius = 30.0f;
+		brush.strength = 0.1f * world.scale;
+		brush.height = 0.5f * world.scale;
+
+		TerrainBrush clamped = ClampTileBrush(brush, world.grid, t);
+		if (clamped.radius < brush.radius) ++numClamped;
+		TexelRect dirty;
+		if (!ApplyTerrainBrush(world.listHeightMaps[t].data(), SIZE_TILE, SIZE_TILE, world.scale, clamped, dirty)) continue;
+		++numChanged;
+		TerrainMeshRegion changed;
+		UpdateTerrainMeshRegion(world.listHeightMaps[t].data(), SIZE_TILE, SIZE_TILE, world.scale, world.info, dirty.x0, dirty.y0,
+			dirty.x1, dirty.y1, world.listVertices[t].data(), changed);
+		world.MatchErrors(t);
+	}
+	CHECK(numClamped > 50);
+	CHECK(numChanged > 200);
+	CHECK(world.CountSeamMismatches() == 0);
+
+	// the texels MatchTileEdges() set along the inner seams were never touched.
+	unsigned int stride = (unsigned int)world.grid.GetStrideX();
+	unsigned int numSeamTexelsChanged = 0;
+	for (unsigned int t = 0; t < world.grid.GetNumTiles(); ++t) {
+		bool isLastX = t % 2 == 1, isLastY = t / 2 == 1;
+		for (unsigned int y = 0; y < SIZE_TILE; ++y) {
+			for (unsigned int x = 0; x < SIZE_TILE; ++x) {
+				bool isSeam = (isLastX ? x < 3 : x >= stride - 2) || (isLastY ? y < 3 : y >= stride - 2);
+				size_t i = ((size_t)y * SIZE_TILE + x) * 4;
+				if (isSeam && world.listHeightMaps[t][i] != listBefore[t][i]) ++numSeamTexelsChanged;
+			}
+		}
+	}
+	CHECK(numSeamTexelsChanged == 0);
+
+	// the errors along a seam never drop below what either tile needs on its own.
+	std::vector<unsigned int> indices(world.info.numIndices);
+	unsigned int numTooLow = 0;
+	for (unsigned int t = 0; t < world.grid.GetNumTiles(); ++t) {
+		TerrainMeshInfo infoRebuilt = world.info;
+		std::vector<Vertex> vertices(world.info.numVertices);
+		BuildTerrainMesh(world.listHeightMaps[t].data(), SIZE_TILE, SIZE_TILE, world.scale, 1, infoRebuilt, vertices.data(), indices.data());
+		for (unsigned long i = 0; i < (unsigned long)world.info.numX * world.info.numY; ++i) {
+			if (world.listVertices[t][i].error < vertices[i].error) ++numTooLow;
+		}
+	}
+	CHECK(numTooLow == 0);
+}
+
+// Cull() finds exactly the tiles a brute force test does, nearest first.
+TEST(TerrainTiles, CullNearestFirst) {
+	TestWorld world(4, 3);
+	XMFLOAT3 worldMin, worldMax;
+	world.grid.GetWorldBounds(worldMin, worldMax);
+	std::vector<unsigned int> visible(world.grid.GetNumTiles());
+
+	unsigned int seed = 12345;
+	unsigned int numSeen = 0;
+	for (unsigned int v = 0; v < 256; ++v) {
+		seed = seed * 1664525u + 1013904223u;
+		float ex = worldMin.x + (float)(seed >> 8) / 16777216.0f * (worldMax.x - worldMin.x);
+		seed = seed * 1664525u + 1013904223u;
+		float ey = worldMin.y + (float)(seed >> 8) / 16777216.0f * (worldMax.y - worldMin.y);
+		seed = seed * 1664525u + 1013904223u;
+		float angle = (float)(seed >> 8) / 16777216.0f * XM_2PI;
+		XMFLOAT3 eye(ex, ey, worldMax.z);
+		float dx = cosf(angle), dy = sinf(angle);
+
+		// a 90 degree field of view out to a couple of tiles. Inward facing planes: the two sides, then the far plane.
+		XMFLOAT4 planes[3];
+		const float side = 0.70710678f;
+		planes[0] = XMFLOAT4(side * (dx - dy), side * (dy + dx), 0.0f, 0.0f);
+		planes[1] = XMFLOAT4(side * (dx + dy), side * (dy - dx), 0.0f, 0.0f);
+		planes[2] = XMFLOAT4(-dx, -dy, 0.0f, 0.0f);
+		for (int p = 0; p < 3; ++p) {
+			planes[p].w = -(planes[p].x * eye.x + planes[p].y * eye.y);
+		}
+		planes[2].w += 2.0f * (float)SIZE_TILE;
+
+		unsigned int num = world.grid.Cull(planes, 3, 1, eye, visible.data());
+		numSeen += num;
+		unsigned int numExpected = 0;
+		for (unsigned int t = 0; t < world.grid.GetNumTiles(); ++t) {
+			XMFLOAT3 min, max;
+			world.grid.GetBounds(t, min, max);
+			bool isExpected = AABBIntersectsPlanes(min, max, planes, 3);
+			bool isFound = std::find(visible.begin(), visible.begin() + num, t) != visible.begin() + num;
+			CHECK(isExpected == isFound);
+			if (isExpected) ++numExpected;
+		}
+		CHECK(num == numExpected);
+
+		// nearest first, measured to the nearest point of each box.
+		float dLast = 0.0f;
+		for (unsigned int i = 0; i < num; ++i) {
+			XMFLOAT3 min, max;
+			world.grid.GetBounds(visible[i], min, max);
+			float bx = fmaxf(fmaxf(min.x - eye.x, eye.x - max.x), 0.0f);
+			float by = fmaxf(fmaxf(min.y - eye.y, eye.y - max.y), 0.0f);
+			float bz = fmaxf(fmaxf(min.z - eye.z, eye.z - max.z), 0.0f);
+			float d = bx * bx + by * by + bz * bz;
+			CHECK(d >= dLast);
+			dLast = d;
+		}
+	}
+	CHECK(numSeen > 256);
+}
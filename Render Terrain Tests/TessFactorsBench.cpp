@@ -0,0 +1,111 @@
+/*
+TessFactorsBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 19, 2026
+
+Description:	Estimates the triangles the tessellator makes of a synthetic terrain from views over it with the
+				screen space error factors at a few target errors, and with the old distance ramp.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "ShadowCascades.h"
+#include "TerrainMesh.h"
+#include "BoundingVolume.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static const float FOV_VERTICAL = 60.0f;				// as the Camera, over a 1920 x 1080 window.
+static const float SCREEN_HEIGHT = 1080.0f;
+static const float ASPECT = 1920.0f / 1080.0f;
+static const float FAR_PLANE = 3000.0f;
+
+// Write the 6 planes of a view from eye towards look.
+static void CalcViewPlanes(XMFLOAT3 eye, XMFLOAT3 look, XMFLOAT4 planes[6]) {
+	XMVECTOR e = XMLoadFloat3(&eye);
+	XMVECTOR l = XMVector3Normalize(XMLoadFloat3(&look));
+	XMVECTOR right = XMVector3Normalize(XMVector3Cross(l, XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f)));
+	XMVECTOR up = XMVector3Cross(right, l);
+	float tanHalfV = tanf(XMConvertToRadians(FOV_VERTICAL) / 2.0f);
+	float tanHalfH = tanHalfV * ASPECT;
+
+	XMFLOAT3 corners[8];
+	for (int i = 0; i < 8; ++i) {
+		float d = (i & 4) ? FAR_PLANE : 0.1f;
+		float x = ((i & 1) ? d : -d) * tanHalfH;
+		float y = ((i & 2) ? d : -d) * tanHalfV;
+		XMStoreFloat3(&corners[i], e + l * d + right * x + up * y);
+	}
+	CalcSlicePlanes(corners, planes);
+}
+
+// --size=<texels> sets the size of the heightmap and --views=<count> how many views over it are averaged.
+BENCHMARK(TessFactors, TriangleCount) {
+	unsigned int size = GetTestOption("size") ? (unsigned int)atoi(GetTestOption("size")) : 1024;
+	unsigned int numViews = GetTestOption("views") ? (unsigned int)atoi(GetTestOption("views")) : 64;
+
+	// the terrain as Terrain builds it, one world unit per texel and a sixteenth of its width high.
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(size, 0, heightmap);
+	float scale = (float)size / 16.0f;
+	TerrainMeshInfo info = CalcTerrainMeshInfo(size, size);
+	std::vector<Vertex> vertices(info.numVertices);
+	std::vector<unsigned int> indices(info.numIndices);
+	BuildTerrainMesh(heightmap.data(), size, size, scale, 0, info, vertices.data(), indices.data());
+
+	const float targets[] = { 0.5f, 1.0f, 2.0f, 4.0f };
+	const unsigned int numTargets = sizeof(targets) / sizeof(targets[0]);
+	double sumError[numTargets] = {};
+	double sumDistance = 0.0;
+	unsigned long long maxError[numTargets] = {};
+	unsigned long long maxDistance = 0;
+
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float pixelsPerUnit = SCREEN_HEIGHT / (2.0f * tanf(XMConvertToRadians(FOV_VERTICAL) * 0.5f));
+	for (unsigned int view = 0; view < numViews; ++view) {
+		// a camera a little above the ground, looking along it and slightly down.
+		float x = (0.1f + 0.8f * unit(rng)) * size, y = (0.1f + 0.8f * unit(rng)) * size;
+		float ground = heightmap[((unsigned int)y * size + (unsigned int)x) * 4] / 255.0f * scale;
+		XMFLOAT3 eye(x, y, ground + 2.0f + 30.0f * unit(rng) * unit(rng));
+		float yaw = XM_2PI * unit(rng), pitch = -0.4f * unit(rng);
+		XMFLOAT3 look(cosf(yaw) * cosf(pitch), sinf(yaw) * cosf(pitch), sinf(pitch));
+		XMFLOAT4 planes[6];
+		CalcViewPlanes(eye, look, planes);
+
+		unsigned long long num[numTargets] = {};
+		unsigned long long numDistance = 0;
+		for (unsigned long p = 0; p < info.numIndices / 4; ++p) {
+			// the bounds of each patch are stored in its first control point.
+			const Vertex& v = vertices[indices[p * 4]];
+			if (!AABBIntersectsPlanes(v.aabbmin, v.aabbmax, planes, 6)) continue;
+
+			XMFLOAT3 corners[4];
+			float errors[4];
+			for (int c = 0; c < 4; ++c) {
+				corners[c] = vertices[indices[p * 4 + c]].position;
+				errors[c] = vertices[indices[p * 4 + c]].error;
+			}
+			for (unsigned int t = 0; t < numTargets; ++t) {
+				TessFactorParams params = { eye, pixelsPerUnit, targets[t], TESS_MAX_FACTOR };
+				num[t] += CalcTessTriangleCount(CalcPatchTessFactors(corners, errors, v.skirt, params));
+			}
+			numDistance += CalcTessTriangleCount(CalcPatchDistanceTessFactors(corners, v.skirt, eye));
+		}
+
+		for (unsigned int t = 0; t < numTargets; ++t) {
+			sumError[t] += (double)num[t];
+			maxError[t] = num[t] > maxError[t] ? num[t] : maxError[t];
+		}
+		sumDistance += (double)numDistance;
+		maxDistance = numDistance > maxDistance ? numDistance : maxDistance;
+	}
+
+	printf("  %u x %u heightmap, %u views at %.0f pixels high. Triangles in view:\n", size, size, numViews, SCREEN_HEIGHT);
+	printf("    distance ramp      mean %10.0f  max %10llu\n", sumDistance / numViews, maxDistance);
+	for (unsigned int t = 0; t < numTargets; ++t) {
+		printf("    %.1f pixel error    mean %10.0f  max %10llu  %.2fx the ramp\n", targets[t], sumError[t] / numViews, maxError[t],
+			sumDistance > 0.0 ? sumError[t] / sumDistance : 0.0);
+	}
+}
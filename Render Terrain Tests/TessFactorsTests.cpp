@@ -0,0 +1,192 @@
+/*
+TessFactorsTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 19, 2026
+
+Description:	Tests the CPU tessellation factors against a transcription of the patch constant function in
+				RenderTerrainTessHS.hlsl, their clamps, and that the patches either side of an edge agree on it.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "TerrainMesh.h"
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+// CalcTessFactor() in RenderTerrainTessHS.hlsl. tessparams is x = pixels per unit, y = target error, z = max factor.
+static float ShaderTessFactor(XMFLOAT3 p, float error, XMFLOAT3 eye, XMFLOAT3 tessparams) {
+	float dx = p.x - eye.x, dy = p.y - eye.y, dz = p.z - eye.z;
+	float d = fmaxf(sqrtf(dx * dx + dy * dy + dz * dz), 1.0f);
+
+	return fminf(fmaxf(error * tessparams.x / (d * tessparams.y), 1.0f), tessparams.z);
+}
+
+// CalcHSPatchConstants() in RenderTerrainTessHS.hlsl for a patch in the frustum.
+static PatchTessFactors ShaderPatchTessFactors(const XMFLOAT3 ip[4], const float error[4], unsigned int skirt, XMFLOAT3 eye,
+	XMFLOAT3 tessparams) {
+	PatchTessFactors output = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f } };
+	auto mid = [](XMFLOAT3 a, XMFLOAT3 b) { return XMFLOAT3(0.5f * (a.x + b.x), 0.5f * (a.y + b.y), 0.5f * (a.z + b.z)); };
+	if (skirt == 0) return output;
+	if (skirt < 5) {
+		output.edges[3] = ShaderTessFactor(mid(ip[2], ip[3]), fmaxf(error[2], error[3]), eye, tessparams);
+		return output;
+	}
+
+	XMFLOAT3 c = mid(mid(ip[0], ip[1]), mid(ip[2], ip[3]));
+	output.edges[0] = ShaderTessFactor(mid(ip[0], ip[2]), fmaxf(error[0], error[2]), eye, tessparams);
+	output.edges[1] = ShaderTessFactor(mid(ip[0], ip[1]), fmaxf(error[0], error[1]), eye, tessparams);
+	output.edges[2] = ShaderTessFactor(mid(ip[1], ip[3]), fmaxf(error[1], error[3]), eye, tessparams);
+	output.edges[3] = ShaderTessFactor(mid(ip[2], ip[3]), fmaxf(error[2], error[3]), eye, tessparams);
+	output.inside[0] = ShaderTessFactor(c, fmaxf(fmaxf(error[0], error[1]), fmaxf(error[2], error[3])), eye, tessparams);
+	output.inside[1] = output.inside[0];
+
+	return output;
+}
+
+// Random patches of every kind, seen from random places, get the factors the hull shader gives them.
+TEST(TessFactors, MatchesShader) {
+	std::mt19937 rng(11);
+	std::uniform_real_distribution<float> pos(-500.0f, 500.0f), unit(0.0f, 1.0f);
+	for (int i = 0; i < 10000; ++i) {
+		TessFactorParams params = { XMFLOAT3(pos(rng), pos(rng), pos(rng) * 0.1f), 200.0f + 1000.0f * unit(rng),
+			0.25f + 4.0f * unit(rng), unit(rng) < 0.5f ? TESS_MAX_FACTOR : 16.0f };
+		XMFLOAT3 tessparams(params.pixelsPerUnit, params.targetPixelError, params.maxFactor);
+
+		XMFLOAT3 corners[4];
+		float errors[4];
+		float x = pos(rng), y = pos(rng), size = 1.0f + 16.0f * unit(rng);
+		for (int c = 0; c < 4; ++c) {
+			corners[c] = XMFLOAT3(x + ((c & 1) ? size : 0.0f), y + ((c & 2) ? size : 0.0f), 40.0f * unit(rng));
+			errors[c] = unit(rng) < 0.1f ? 0.0f : 8.0f * unit(rng) * unit(rng);
+		}
+		unsigned int skirt = (unsigned int)(rng() % 6);
+
+		PatchTessFactors cpu = CalcPatchTessFactors(corners, errors, skirt, params);
+		PatchTessFactors gpu = ShaderPatchTessFactors(corners, errors, skirt, params.eye, tessparams);
+		for (int e = 0; e < 4; ++e) {
+			CHECK_NEAR(cpu.edges[e], gpu.edges[e], 1e-4f * gpu.edges[e]);
+		}
+		CHECK_NEAR(cpu.inside[0], gpu.inside[0], 1e-4f * gpu.inside[0]);
+		CHECK(cpu.inside[1] == cpu.inside[0]);
+	}
+}
+
+// Up close the factor stops at the maximum, and distances under a unit count as one so the eye on a patch doesn't divide by 0.
+TEST(TessFactors, NearClamp) {
+	TessFactorParams params = { XMFLOAT3(0.0f, 0.0f, 0.0f), 935.0f, 1.0f, TESS_MAX_FACTOR };
+	CHECK(CalcTessFactor(1.0f, 0.0f, params) == TESS_MAX_FACTOR);
+	CHECK(CalcTessFactor(1.0f, 5.0f, params) == TESS_MAX_FACTOR);
+	CHECK(CalcTessFactor(0.01f, 0.0f, params) == CalcTessFactor(0.01f, 1.0f, params));
+	CHECK(CalcTessFactor(0.01f, 0.5f, params) == CalcTessFactor(0.01f, 1.0f, params));
+	CHECK_NEAR(CalcTessFactor(0.01f, 1.0f, params), 9.35f, 1e-4f);
+
+	params.maxFactor = 16.0f;
+	CHECK(CalcTessFactor(1.0f, 5.0f, params) == 16.0f);
+
+	// a patch with the eye right on it.
+	XMFLOAT3 corners[4] = { XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(8.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 8.0f, 0.0f), XMFLOAT3(8.0f, 8.0f, 0.0f) };
+	float errors[4] = { 2.0f, 2.0f, 2.0f, 2.0f };
+	params.eye = XMFLOAT3(4.0f, 4.0f, 0.0f);
+	PatchTessFactors factors = CalcPatchTessFactors(corners, errors, 5, params);
+	for (int e = 0; e < 4; ++e) {
+		CHECK(factors.edges[e] == 16.0f);
+	}
+	CHECK(factors.inside[0] == 16.0f);
+}
+
+// Far off, or with no error at all, a patch isn't split, and the factor falls off as the inverse of the distance in between.
+TEST(TessFactors, FarClamp) {
+	TessFactorParams params = { XMFLOAT3(0.0f, 0.0f, 0.0f), 935.0f, 1.0f, TESS_MAX_FACTOR };
+	CHECK(CalcTessFactor(1.0f, 1e6f, params) == 1.0f);
+	CHECK(CalcTessFactor(1.0f, 935.0f, params) == 1.0f);
+	CHECK(CalcTessFactor(0.0f, 10.0f, params) == 1.0f);
+	CHECK_NEAR(CalcTessFactor(1.0f, 100.0f, params), 9.35f, 1e-4f);
+	CHECK_NEAR(CalcTessFactor(1.0f, 200.0f, params), 4.675f, 1e-4f);
+
+	// a bigger target error brings the far clamp closer.
+	params.targetPixelError = 4.0f;
+	CHECK(CalcTessFactor(1.0f, 300.0f, params) == 1.0f);
+
+	// the skirts only tessellate their top edge, and the bottom plane not at all.
+	XMFLOAT3 corners[4] = { XMFLOAT3(0.0f, 0.0f, -20.0f), XMFLOAT3(8.0f, 0.0f, -20.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(8.0f, 0.0f, 0.0f) };
+	float errors[4] = { 0.0f, 0.0f, 4.0f, 4.0f };
+	params.eye = XMFLOAT3(4.0f, -2.0f, 1.0f);
+	for (unsigned int skirt = 0; skirt < 5; ++skirt) {
+		PatchTessFactors factors = CalcPatchTessFactors(corners, errors, skirt, params);
+		CHECK(factors.edges[0] == 1.0f && factors.edges[1] == 1.0f && factors.edges[2] == 1.0f);
+		CHECK(factors.inside[0] == 1.0f && factors.inside[1] == 1.0f);
+		CHECK(factors.edges[3] == (skirt == 0 ? 1.0f : TESS_MAX_FACTOR));
+	}
+}
+
+// Every edge shared by two patches of a mesh, terrain or skirt, gets exactly the same factor from both, or the tessellated
+// surface cracks along it.
+TEST(TessFactors, SharedEdgesAgree) {
+	const unsigned int size = 256;
+	std::vector<unsigned char> heightmap;
+	BuildRollingHills(size, 0, heightmap);
+	TerrainMeshInfo info = CalcTerrainMeshInfo(size, size);
+	std::vector<Vertex> vertices(info.numVertices);
+	std::vector<unsigned int> indices(info.numIndices);
+	BuildTerrainMesh(heightmap.data(), size, size, (float)size / 16.0f, 1, info, vertices.data(), indices.data());
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> pos(-32.0f, size + 32.0f);
+	unsigned int numShared = 0;
+	for (int view = 0; view < 16; ++view) {
+		TessFactorParams params = { XMFLOAT3(pos(rng), pos(rng), 20.0f + 0.5f * pos(rng)), 935.0f, 1.0f, TESS_MAX_FACTOR };
+
+		// the factor each edge, keyed by its two control points, got from the first patch seen with it.
+		std::map<std::pair<unsigned int, unsigned int>, float> edges;
+		numShared = 0;
+		for (unsigned long p = 0; p < info.numIndices / 4; ++p) {
+			const unsigned int* ip = &indices[p * 4];
+			unsigned int skirt = vertices[ip[0]].skirt;
+			XMFLOAT3 corners[4];
+			float errors[4];
+			for (int c = 0; c < 4; ++c) {
+				corners[c] = vertices[ip[c]].position;
+				errors[c] = vertices[ip[c]].error;
+			}
+			PatchTessFactors factors = CalcPatchTessFactors(corners, errors, skirt, params);
+
+			// the edges in SV_TessFactor order, of which only the top of a skirt touches the terrain.
+			static const int EDGES[4][2] = { { 0, 2 }, { 0, 1 }, { 1, 3 }, { 2, 3 } };
+			for (int e = (skirt == 5 ? 0 : 3); e < 4 && skirt > 0; ++e) {
+				unsigned int a = ip[EDGES[e][0]], b = ip[EDGES[e][1]];
+				auto key = std::make_pair(a < b ? a : b, a < b ? b : a);
+				auto it = edges.find(key);
+				if (it == edges.end()) {
+					edges[key] = factors.edges[e];
+				} else {
+					CHECK(it->second == factors.edges[e]);
+					++numShared;
+				}
+			}
+		}
+	}
+
+	// every inner edge of the grid, and every edge along its border shared with a skirt.
+	unsigned int numX = info.numX - 1, numY = info.numY - 1;
+	CHECK(numShared == (numX - 1) * numY + numX * (numY - 1) + 2 * numX + 2 * numY);
+}
+
+// A plane has no error and the bilinear surface between the corners of a patch is exact for it.
+TEST(TessFactors, HeightError) {
+	const unsigned int size = 64;
+	std::vector<unsigned char> heightmap(size * size * 4, 0);
+	for (unsigned int y = 0; y < size; ++y) {
+		for (unsigned int x = 0; x < size; ++x) {
+			heightmap[(y * size + x) * 4] = (unsigned char)(2 * x + y);
+		}
+	}
+	CHECK_NEAR(CalcPatchHeightError(heightmap.data(), size, size, 8, 16, 8, 255.0f), 0.0f, 1e-3f);
+
+	// one raised texel in the middle of the patch is the whole error.
+	heightmap[(20 * size + 12) * 4] += 10;
+	CHECK_NEAR(CalcPatchHeightError(heightmap.data(), size, size, 8, 16, 8, 255.0f), 10.0f, 1e-3f);
+	CHECK_NEAR(CalcPatchHeightError(heightmap.data(), size, size, 8, 16, 8, 25.5f), 1.0f, 1e-4f);
+	CHECK_NEAR(CalcPatchHeightError(heightmap.data(), size, size, 24, 16, 8, 255.0f), 0.0f, 1e-3f);
+}
@@ -0,0 +1,46 @@
+/*
+Test.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	A minimal test runner for the parts of the renderer that only depend on the standard library and
+				DirectXMath, so they can be checked and timed without a Direct3D 12 device.
+
+Usage:			- Write TEST(Suite, Name) { ... } in a <Module>Tests.cpp and use CHECK(), CHECK_NEAR() and REQUIRE() in it.
+					CHECK() records a failure and carries on. REQUIRE() records a failure and leaves the test.
+				- Write BENCHMARK(Suite, Name) { ... } in a <Module>Bench.cpp for timings. Benchmarks only run when
+					--bench is passed, and print what they measure.
+				- Run Render Terrain Tests with a suite name to only run that suite. Returns the number of failed tests.
+				- Options given as --name=value are passed on to the tests and benchmarks through GetTestOption().
+
+Future Work:	- Run the tests on more than one thread.
+*/
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+typedef void(*TestFunc)();
+
+// Adds a test to the list the runner goes through. Used by TEST() and BENCHMARK().
+struct TestRegistrar {
+	TestRegistrar(const char* suite, const char* name, TestFunc f, bool isBenchmark);
+};
+
+// Returns the value of --name=value on the command line, or nullptr if it wasn't given.
+const char* GetTestOption(const char* name);
+// Record that expr failed at file:line in the running test.
+void ReportFailure(const char* file, int line, const char* expr);
+
+#define TEST_REGISTER(suite, name, isBenchmark) \
+	static void suite##_##name(); \
+	static TestRegistrar suite##_##name##_registrar(#suite, #name, suite##_##name, isBenchmark); \
+	static void suite##_##name()
+
+#define TEST(suite, name) TEST_REGISTER(suite, name, false)
+#define BENCHMARK(suite, name) TEST_REGISTER(suite, name, true)
+
+#define CHECK(expr) do { if (!(expr)) ReportFailure(__FILE__, __LINE__, #expr); } while (0)
+#define CHECK_NEAR(a, b, eps) CHECK(fabs((double)(a) - (double)(b)) <= (double)(eps))
+#define REQUIRE(expr) do { if (!(expr)) { ReportFailure(__FILE__, __LINE__, #expr); return; } } while (0)
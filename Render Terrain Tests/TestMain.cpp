@@ -0,0 +1,86 @@
+/*
+TestMain.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Runs the tests and benchmarks registered with TEST() and BENCHMARK().
+*/
+#include "Test.h"
+#include <cstring>
+#include <vector>
+
+struct TestCase {
+	const char*	suite;
+	const char*	name;
+	TestFunc	f;
+	bool		isBenchmark;
+};
+
+// the registered tests. A function so it is built before the first TestRegistrar uses it.
+static std::vector<TestCase>& GetTests() {
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+static unsigned int g_numFailures = 0;	// failures in the running test.
+static std::vector<const char*> g_listOptions;	// every --name=value on the command line.
+
+// Adds a test to the list the runner goes through. Used by TEST() and BENCHMARK().
+TestRegistrar::TestRegistrar(const char* suite, const char* name, TestFunc f, bool isBenchmark) {
+	GetTests().push_back({ suite, name, f, isBenchmark });
+}
+
+// Returns the value of --name=value on the command line, or nullptr if it wasn't given.
+const char* GetTestOption(const char* name) {
+	size_t len = strlen(name);
+	for (auto option : g_listOptions) {
+		if (strncmp(option + 2, name, len) == 0 && option[2 + len] == '=') return option + 3 + len;
+	}
+
+	return nullptr;
+}
+
+// Record that expr failed at file:line in the running test.
+void ReportFailure(const char* file, int line, const char* expr) {
+	printf("  %s(%d): failed: %s\n", file, line, expr);
+	++g_numFailures;
+}
+
+// Render Terrain Tests [--bench] [--name=value ...] [suite]
+int main(int argc, char** argv) {
+	bool isBench = false;
+	const char* suite = nullptr;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--bench") == 0) {
+			isBench = true;
+		}
+		else if (strncmp(argv[i], "--", 2) == 0) {
+			g_listOptions.push_back(argv[i]);
+		}
+		else {
+			suite = argv[i];
+		}
+	}
+
+	unsigned int numRun = 0;
+	unsigned int numFailed = 0;
+	for (auto& t : GetTests()) {
+		if (t.isBenchmark != isBench) continue;
+		if (suite && strcmp(suite, t.suite) != 0) continue;
+
+		printf("%s.%s\n", t.suite, t.name);
+		g_numFailures = 0;
+		t.f();
+		++numRun;
+		if (g_numFailures) ++numFailed;
+	}
+
+	printf("%u of %u %s passed.\n", numRun - numFailed, numRun, isBench ? "benchmarks" : "tests");
+	if (numRun == 0) {
+		printf("Nothing matched %s.\n", suite ? suite : "");
+		return 1;
+	}
+
+	return (int)numFailed;
+}
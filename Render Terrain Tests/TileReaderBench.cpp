@@ -0,0 +1,112 @@
+/*
+TileReaderBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Measures the throughput and latency of each TileReader backend reading blocks from random
+				places in a file, from a cold and a warm page cache.
+*/
+#include "Test.h"
+#include "BenchHelpers.h"
+#include "TileReader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+// Read every block of fn once in a random order with backend, keeping queueDepth reads in flight, from a cold page cache
+// if isCold, and print how long it took.
+static void TimeReads(const char* fn, unsigned int numBlocks, unsigned int sizeBlock, TileReaderBackend backend, unsigned int queueDepth,
+	bool isCold) {
+	TileReader reader(backend, queueDepth, queueDepth);
+	int iFile = reader.Open(fn);
+	if (iFile < 0) return;
+	if (isCold) {
+		isCold = reader.DropPageCache((unsigned int)iFile);
+	} else {
+		WarmPageCache(fn);
+	}
+
+	// the same order every run, so backends can be compared.
+	std::vector<unsigned int> listOrder(numBlocks);
+	for (unsigned int b = 0; b < numBlocks; ++b) {
+		listOrder[b] = b;
+	}
+	std::shuffle(listOrder.begin(), listOrder.end(), std::mt19937(1234));
+
+	// one buffer per slot. A block's buffer is free again once its read completes.
+	unsigned int depth = reader.GetQueueDepth();
+	std::vector<unsigned char> listBuffers((size_t)depth * sizeBlock);
+	std::vector<unsigned int> listFree;
+	for (unsigned int i = 0; i < depth; ++i) {
+		listFree.push_back(i);
+	}
+	std::vector<TileReadRequest> listRequests;
+	std::vector<TileReadCompletion> listCompleted(depth);
+	std::vector<double> listLatency;
+	listLatency.reserve(numBlocks);
+	unsigned int numFailed = 0;
+
+	auto tStart = std::chrono::high_resolution_clock::now();
+	unsigned int next = 0;
+	while (listLatency.size() < numBlocks) {
+		listRequests.clear();
+		for (; next < numBlocks && !listFree.empty(); ++next) {
+			unsigned int i = listFree.back();
+			listFree.pop_back();
+			listRequests.push_back({ i, (unsigned int)iFile, (unsigned long long)listOrder[next] * sizeBlock, sizeBlock,
+				&listBuffers[(size_t)i * sizeBlock] });
+		}
+		if (!listRequests.empty()) {
+			reader.Submit(listRequests.data(), (unsigned int)listRequests.size());
+		}
+
+		unsigned int num = reader.Poll(listCompleted.data(), depth, true);
+		for (unsigned int c = 0; c < num; ++c) {
+			if (listCompleted[c].result != (int)sizeBlock) ++numFailed;
+			listLatency.push_back(listCompleted[c].msLatency);
+			listFree.push_back(listCompleted[c].id);
+		}
+	}
+	double msTotal = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	std::sort(listLatency.begin(), listLatency.end());
+	double mbRead = (double)numBlocks * sizeBlock / (1024.0 * 1024.0);
+	printf("  %-11s %-4s %10.0f %9.1f %8.3f %8.3f %8.3f %8.3f %10llu%s\n", reader.GetBackend() == TILE_READER_IO_URING ? "io_uring" : "thread pool",
+		isCold ? "cold" : "warm", msTotal > 0.0 ? numBlocks * 1000.0 / msTotal : 0.0, msTotal > 0.0 ? mbRead * 1000.0 / msTotal : 0.0,
+		CalcPercentile(listLatency, 0.5), CalcPercentile(listLatency, 0.99), CalcPercentile(listLatency, 0.999), listLatency.back(),
+		reader.GetStats().numSystemCalls, numFailed ? " FAILED" : "");
+}
+
+// --file=<path> sets where the file is written, ie on the drive to measure, --blocks=<count> and --block=<bytes> its size,
+// and --depth=<reads> the reads kept in flight.
+BENCHMARK(TileReader, RandomReads) {
+	const char* fn = GetTestOption("file") ? GetTestOption("file") : "TileReaderBench.bin";
+	unsigned int numBlocks = GetTestOption("blocks") ? (unsigned int)atoi(GetTestOption("blocks")) : 4096;
+	unsigned int sizeBlock = GetTestOption("block") ? (unsigned int)atoi(GetTestOption("block")) : 64 * 1024;
+	unsigned int queueDepth = GetTestOption("depth") ? (unsigned int)atoi(GetTestOption("depth")) : TILE_READER_QUEUE_DEPTH;
+
+	{
+		std::vector<char> block(sizeBlock);
+		std::ofstream file(fn, std::ios::binary | std::ios::trunc);
+		std::mt19937 rng(5);
+		for (unsigned int b = 0; b < numBlocks; ++b) {
+			for (auto& c : block) c = (char)rng();
+			file.write(block.data(), sizeBlock);
+		}
+		if (!file.good()) {
+			printf("  couldn't write %s.\n", fn);
+			return;
+		}
+	}
+
+	printf("  %u blocks of %u bytes, %u in flight. Latency in ms.\n", numBlocks, sizeBlock, queueDepth);
+	printf("  backend     cache   reads/s      MB/s      p50      p99    p99.9      max   syscalls\n");
+	for (TileReaderBackend backend : { TILE_READER_IO_URING, TILE_READER_THREAD_POOL }) {
+		TimeReads(fn, numBlocks, sizeBlock, backend, queueDepth, true);
+		TimeReads(fn, numBlocks, sizeBlock, backend, queueDepth, false);
+	}
+	std::remove(fn);
+}
@@ -0,0 +1,163 @@
+/*
+TileReaderTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests that both TileReader backends read back what was written, whatever order the reads
+				complete in, including short reads at the end of a file and a full queue.
+*/
+#include "Test.h"
+#include "TileReader.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+
+static const char* FILE_TEST = "TileReaderTests.bin";
+
+// Returns the byte written at offset of the test file.
+static unsigned char CalcByte(unsigned long long offset) {
+	return (unsigned char)((offset * 2654435761ull) >> 13);
+}
+
+// Write size bytes to the test file. Returns false if it couldn't.
+static bool WriteTestFile(unsigned long long size) {
+	std::vector<char> data((size_t)size);
+	for (unsigned long long i = 0; i < size; ++i) {
+		data[(size_t)i] = (char)CalcByte(i);
+	}
+	std::ofstream file(FILE_TEST, std::ios::binary | std::ios::trunc);
+	file.write(data.data(), data.size());
+	return file.good();
+}
+
+// Returns true if size bytes of data match the test file from offset on.
+static bool IsMatch(const unsigned char* data, unsigned long long offset, unsigned int size) {
+	for (unsigned int i = 0; i < size; ++i) {
+		if (data[i] != CalcByte(offset + i)) return false;
+	}
+	return true;
+}
+
+// Every block of the file read once, in a random order, with more blocks than fit in the queue.
+TEST(TileReader, ReadsEveryBlock) {
+	// an odd block size, so a read from the wrong block can't line up by chance.
+	const unsigned int numBlocks = 300;
+	const unsigned int sizeBlock = 3001;
+	REQUIRE(WriteTestFile((unsigned long long)numBlocks * sizeBlock));
+
+	for (TileReaderBackend backend : { TILE_READER_AUTO, TILE_READER_THREAD_POOL }) {
+		TileReader reader(backend, 8, 3);
+		int iFile = reader.Open(FILE_TEST);
+		REQUIRE(iFile >= 0);
+
+		std::vector<unsigned int> listOrder(numBlocks);
+		for (unsigned int b = 0; b < numBlocks; ++b) {
+			listOrder[b] = b;
+		}
+		std::shuffle(listOrder.begin(), listOrder.end(), std::mt19937(99));
+
+		// a buffer per block, so nothing is reused before it's checked.
+		std::vector<unsigned char> data((size_t)numBlocks * sizeBlock, 0);
+		std::vector<unsigned int> numCompleted(numBlocks, 0);
+		std::vector<TileReadCompletion> listCompleted(reader.GetQueueDepth());
+		unsigned int next = 0, numDone = 0, numWrong = 0;
+		while (numDone < numBlocks) {
+			while (next < numBlocks) {
+				unsigned int b = listOrder[next];
+				TileReadRequest r = { b, (unsigned int)iFile, (unsigned long long)b * sizeBlock, sizeBlock, &data[(size_t)b * sizeBlock] };
+				if (reader.Submit(&r, 1) == 0) break;
+				++next;
+			}
+			CHECK(reader.GetNumInFlight() <= reader.GetQueueDepth());
+
+			unsigned int num = reader.Poll(listCompleted.data(), (unsigned int)listCompleted.size(), true);
+			REQUIRE(num > 0);
+			for (unsigned int c = 0; c < num; ++c) {
+				unsigned int b = listCompleted[c].id;
+				++numCompleted[b];
+				if (listCompleted[c].result != (int)sizeBlock) ++numWrong;
+				if (!IsMatch(&data[(size_t)b * sizeBlock], (unsigned long long)b * sizeBlock, sizeBlock)) ++numWrong;
+			}
+			numDone += num;
+		}
+		CHECK(numWrong == 0);
+		CHECK(std::count(numCompleted.begin(), numCompleted.end(), 1u) == (long)numBlocks);
+		CHECK(reader.GetNumInFlight() == 0);
+
+		TileReaderStats stats = reader.GetStats();
+		CHECK(stats.numSubmitted == numBlocks && stats.numCompleted == numBlocks);
+		CHECK(stats.numFailed == 0);
+		CHECK(stats.numBytesRead == (unsigned long long)numBlocks * sizeBlock);
+	}
+	std::remove(FILE_TEST);
+}
+
+TEST(TileReader, ShortReadsAtTheEnd) {
+	REQUIRE(WriteTestFile(10000));
+
+	for (TileReaderBackend backend : { TILE_READER_AUTO, TILE_READER_THREAD_POOL }) {
+		TileReader reader(backend, 4, 2);
+		int iFile = reader.Open(FILE_TEST);
+		REQUIRE(iFile >= 0);
+
+		// a read over the end of the file returns what there is, and one past the end returns nothing.
+		std::vector<unsigned char> a(4096), b(4096);
+		TileReadRequest requests[2] = {
+			{ 0, (unsigned int)iFile, 8000, 4096, a.data() },
+			{ 1, (unsigned int)iFile, 20000, 4096, b.data() },
+		};
+		REQUIRE(reader.Submit(requests, 2) == 2);
+
+		TileReadCompletion completions[2];
+		unsigned int num = 0;
+		while (num < 2) {
+			num += reader.Poll(&completions[num], 2 - num, true);
+		}
+		for (auto& c : completions) {
+			if (c.id == 0) {
+				CHECK(c.result == 2000);
+				CHECK(IsMatch(a.data(), 8000, 2000));
+			} else {
+				CHECK(c.result == 0);
+			}
+		}
+	}
+	std::remove(FILE_TEST);
+}
+
+TEST(TileReader, QueueFills) {
+	REQUIRE(WriteTestFile(65536));
+
+	TileReader reader(TILE_READER_THREAD_POOL, 4, 1);
+	int iFile = reader.Open(FILE_TEST);
+	REQUIRE(iFile >= 0);
+	CHECK(reader.GetBackend() == TILE_READER_THREAD_POOL);
+
+	// only as many reads as the queue holds are taken. The rest are taken once those complete.
+	std::vector<unsigned char> data(65536);
+	std::vector<TileReadRequest> listRequests;
+	for (unsigned int i = 0; i < 16; ++i) {
+		listRequests.push_back({ i, (unsigned int)iFile, (unsigned long long)i * 4096, 4096, &data[(size_t)i * 4096] });
+	}
+	unsigned int numTaken = reader.Submit(listRequests.data(), 16);
+	CHECK(numTaken == reader.GetQueueDepth());
+
+	std::vector<TileReadCompletion> listCompleted(16);
+	unsigned int numDone = 0;
+	while (numDone < 16) {
+		numTaken += reader.Submit(&listRequests[numTaken], 16 - numTaken);
+		numDone += reader.Poll(&listCompleted[numDone], 16 - numDone, true);
+	}
+	CHECK(IsMatch(data.data(), 0, 65536));
+
+	// with nothing in flight, waiting returns right away.
+	CHECK(reader.Poll(listCompleted.data(), 16, true) == 0);
+	std::remove(FILE_TEST);
+}
+
+TEST(TileReader, MissingFile) {
+	TileReader reader;
+	CHECK(reader.Open("TileReaderTests.missing") == -1);
+}
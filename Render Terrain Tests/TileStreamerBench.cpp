@@ -0,0 +1,87 @@
+/*
+TileStreamerBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Measures the throughput and latency of streaming and decoding a pack of synthetic tiles with
+				each TileReader backend, from a cold and a warm page cache.
+*/
+#include "Test.h"
+#include "BenchHelpers.h"
+#include "SyntheticTerrain.h"
+#include "TileStreamer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+// Stream all of the pack fn with backend, from a cold page cache if isCold, and print how long it took.
+static void TimeStreaming(const char* fn, TileReaderBackend backend, unsigned int queueDepth, bool isCold) {
+	TileStreamer streamer(fn, backend, queueDepth, std::thread::hardware_concurrency());
+	if (!streamer.IsOpen()) return;
+	if (isCold) {
+		isCold = streamer.DropPageCache();
+	} else {
+		WarmPageCache(fn);
+	}
+
+	unsigned int numTiles = streamer.GetNumTiles();
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		streamer.Request(t);
+	}
+	std::vector<StreamedTile> listReady;
+	while (listReady.size() < numTiles) {
+		streamer.WaitIdle();
+		streamer.TakeReady(listReady);
+	}
+	double msTotal = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	double mbRead = 0.0;
+	unsigned int numFailed = 0;
+	std::vector<double> listRead, listTotal;
+	for (auto& tile : listReady) {
+		if (!tile.isValid) ++numFailed;
+		mbRead += streamer.GetEntry(tile.tile).size / (1024.0 * 1024.0);
+		listRead.push_back(tile.msRead);
+		listTotal.push_back(tile.msTotal);
+	}
+	std::sort(listRead.begin(), listRead.end());
+	std::sort(listTotal.begin(), listTotal.end());
+
+	printf("  %-11s %-4s %9.0f %8.1f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %9llu%s\n",
+		streamer.GetBackend() == TILE_READER_IO_URING ? "io_uring" : "thread pool", isCold ? "cold" : "warm",
+		msTotal > 0.0 ? numTiles * 1000.0 / msTotal : 0.0, msTotal > 0.0 ? mbRead * 1000.0 / msTotal : 0.0,
+		CalcPercentile(listRead, 0.5), CalcPercentile(listRead, 0.99), listRead.back(), CalcPercentile(listTotal, 0.5),
+		CalcPercentile(listTotal, 0.99), listTotal.back(), streamer.GetStats().reader.numSystemCalls, numFailed ? " FAILED" : "");
+}
+
+// --file=<path> sets where the pack is written, ie on the drive to measure, --tiles=<count> and --size=<texels> its tiles,
+// and --depth=<reads> the reads kept in flight.
+BENCHMARK(TileStreamer, StreamPack) {
+	const char* fn = GetTestOption("file") ? GetTestOption("file") : "TileStreamerBench.pack";
+	unsigned int numTiles = GetTestOption("tiles") ? (unsigned int)atoi(GetTestOption("tiles")) : 64;
+	unsigned int size = GetTestOption("size") ? (unsigned int)atoi(GetTestOption("size")) : 512;
+	unsigned int queueDepth = GetTestOption("depth") ? (unsigned int)atoi(GetTestOption("depth")) : 16;
+
+	{
+		std::vector<std::vector<unsigned char>> listTiles(numTiles);
+		std::vector<const unsigned char*> listPtrs(numTiles);
+		for (unsigned int t = 0; t < numTiles; ++t) {
+			BuildRollingHills(size, t, listTiles[t]);
+			listPtrs[t] = listTiles[t].data();
+		}
+		if (!WriteTilePack(fn, listPtrs.data(), numTiles, size, size)) {
+			printf("  couldn't write %s.\n", fn);
+			return;
+		}
+	}
+
+	printf("  %u tiles of %u x %u, %u reads in flight. Latency in ms, reading and from request to decoded.\n", numTiles, size, size, queueDepth);
+	printf("  backend     cache   tiles/s     MB/s   rd p50   rd p99   rd max  tot p50  tot p99  tot max  syscalls\n");
+	for (TileReaderBackend backend : { TILE_READER_IO_URING, TILE_READER_THREAD_POOL }) {
+		TimeStreaming(fn, backend, queueDepth, true);
+		TimeStreaming(fn, backend, queueDepth, false);
+	}
+	std::remove(fn);
+}
@@ -0,0 +1,136 @@
+/*
+TileStreamerTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests that tile packs stream back what was written, and that repeated and cancelled requests
+				are each handed over at most once.
+*/
+#include "Test.h"
+#include "SyntheticTerrain.h"
+#include "TileStreamer.h"
+#include <cstdio>
+
+static const char* FILE_PACK = "TileStreamerTests.pack";
+static const unsigned int SIZE_TILE = 64;
+
+// Write a pack of numTiles synthetic tiles to FILE_PACK, keeping their texels in listTiles.
+static bool WriteTestPack(unsigned int numTiles, std::vector<std::vector<unsigned char>>& listTiles) {
+	listTiles.resize(numTiles);
+	std::vector<const unsigned char*> listPtrs(numTiles);
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		BuildRollingHills(SIZE_TILE, t, listTiles[t]);
+		listPtrs[t] = listTiles[t].data();
+	}
+	return WriteTilePack(FILE_PACK, listPtrs.data(), numTiles, SIZE_TILE, SIZE_TILE);
+}
+
+TEST(TileStreamer, StreamsEveryTile) {
+	std::vector<std::vector<unsigned char>> listTiles;
+	REQUIRE(WriteTestPack(24, listTiles));
+
+	std::vector<TilePackEntry> listEntries;
+	REQUIRE(ReadTilePackIndex(FILE_PACK, listEntries));
+	CHECK(listEntries.size() == 24);
+
+	for (TileReaderBackend backend : { TILE_READER_AUTO, TILE_READER_THREAD_POOL }) {
+		// a queue shallower than the pack, so jobs are reused.
+		TileStreamer streamer(FILE_PACK, backend, 4, 3);
+		REQUIRE(streamer.IsOpen());
+		CHECK(streamer.GetNumTiles() == 24);
+
+		for (unsigned int t = 0; t < 24; ++t) {
+			streamer.Request(t, (float)t);
+		}
+		std::vector<StreamedTile> listReady;
+		while (listReady.size() < 24) {
+			streamer.WaitIdle();
+			streamer.TakeReady(listReady);
+		}
+		CHECK(listReady.size() == 24);
+
+		std::vector<unsigned int> numSeen(24, 0);
+		unsigned int numWrong = 0;
+		for (auto& tile : listReady) {
+			REQUIRE(tile.tile < 24);
+			++numSeen[tile.tile];
+			if (!tile.isValid || tile.width != SIZE_TILE || tile.height != SIZE_TILE || tile.texels != listTiles[tile.tile]) ++numWrong;
+		}
+		CHECK(numWrong == 0);
+		for (auto n : numSeen) {
+			CHECK(n == 1);
+		}
+
+		TileStreamStats stats = streamer.GetStats();
+		CHECK(stats.numRequested == 24 && stats.numReady == 24);
+		CHECK(stats.numFailed == 0);
+	}
+	std::remove(FILE_PACK);
+}
+
+// A tile requested again before it's taken is only handed over once. Once taken, it can be requested again.
+TEST(TileStreamer, RequestsOnce) {
+	std::vector<std::vector<unsigned char>> listTiles;
+	REQUIRE(WriteTestPack(4, listTiles));
+
+	TileStreamer streamer(FILE_PACK, TILE_READER_AUTO, 4, 2);
+	REQUIRE(streamer.IsOpen());
+	for (int i = 0; i < 5; ++i) {
+		streamer.Request(2, (float)i);
+	}
+	streamer.Request(9);
+	streamer.WaitIdle();
+	std::vector<StreamedTile> listReady;
+	streamer.TakeReady(listReady);
+	REQUIRE(listReady.size() == 1);
+	CHECK(listReady[0].tile == 2 && listReady[0].isValid);
+
+	streamer.Request(2);
+	streamer.WaitIdle();
+	streamer.TakeReady(listReady);
+	CHECK(listReady.size() == 2);
+	CHECK(streamer.GetStats().numRequested == 2);
+	std::remove(FILE_PACK);
+}
+
+// Cancelled tiles are never handed over, and the rest are.
+TEST(TileStreamer, CancelDrops) {
+	std::vector<std::vector<unsigned char>> listTiles;
+	REQUIRE(WriteTestPack(32, listTiles));
+
+	TileStreamer streamer(FILE_PACK, TILE_READER_AUTO, 2, 1);
+	REQUIRE(streamer.IsOpen());
+	for (unsigned int t = 0; t < 32; ++t) {
+		streamer.Request(t);
+	}
+	std::vector<bool> listCancelled(32, false);
+	unsigned int numCancelled = 0;
+	for (unsigned int t = 0; t < 32; t += 2) {
+		listCancelled[t] = streamer.Cancel(t);
+		if (listCancelled[t]) ++numCancelled;
+	}
+	CHECK(!streamer.Cancel(40));
+
+	streamer.WaitIdle();
+	std::vector<StreamedTile> listReady;
+	streamer.TakeReady(listReady);
+	CHECK(listReady.size() + numCancelled == 32);
+	for (auto& tile : listReady) {
+		CHECK(!listCancelled[tile.tile]);
+		CHECK(tile.isValid);
+	}
+	CHECK(streamer.GetStats().numCancelled == numCancelled);
+	std::remove(FILE_PACK);
+}
+
+TEST(TileStreamer, NotAPack) {
+	std::vector<TilePackEntry> listEntries;
+	CHECK(!ReadTilePackIndex("TileStreamerTests.missing", listEntries));
+
+	TileStreamer streamer("TileStreamerTests.missing", TILE_READER_AUTO, 4, 1);
+	CHECK(!streamer.IsOpen());
+	CHECK(streamer.GetNumTiles() == 0);
+	streamer.Request(0);
+	streamer.WaitIdle();
+}
@@ -0,0 +1,169 @@
+/*
+UploadPlacementBench.cpp
+
+Author:			Chris Serson
+Last Edited:	October 19, 2026
+
+Description:	Replays the uploads the Scene makes loading its world, then editing it, through an UploadRing, and
+				compares how much of the upload buffer they take with rounding each one up to a power of 2.
+*/
+#include "Test.h"
+#include "UploadPlacement.h"
+#include "PatchChunks.h"
+#include "TerrainMesh.h"
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// DEFAULT_UPLOAD_BUFFER_SIZE in ResourceManager.h.
+static const unsigned long long UPLOAD_BUFFER_SIZE = 100000000;
+
+// One upload, as ResourceManager would size it.
+struct BenchUpload {
+	UploadTextureDesc	desc;
+	unsigned int		numSubresources;
+	bool				isEdit;			// made while editing rather than loading.
+};
+
+// Returns an RGBA8 texture of width x height texels and arraySize slices.
+static UploadTextureDesc MakeRGBA(unsigned int width, unsigned int height, unsigned int arraySize) {
+	UploadTextureDesc desc = {};
+	desc.width = width;
+	desc.height = height;
+	desc.depthOrArraySize = arraySize;
+	desc.mipLevels = 1;
+	desc.bytesPerBlock = 4;
+	desc.blockDim = 1;
+	return desc;
+}
+
+// Returns a buffer of size bytes.
+static UploadTextureDesc MakeBuffer(unsigned long long size) {
+	UploadTextureDesc desc = {};
+	desc.width = (unsigned int)size;
+	desc.height = 1;
+	desc.depthOrArraySize = 1;
+	desc.mipLevels = 1;
+	desc.bytesPerBlock = 1;
+	desc.blockDim = 1;
+	desc.isBuffer = true;
+	return desc;
+}
+
+// Fill uploads with what the Scene uploads for a world of numTiles tiles of size x size heightmaps, in the order it does,
+// followed by numStrokes brush strokes on the first tile.
+static void BuildUploads(unsigned int size, unsigned int numTiles, unsigned int numStrokes, std::vector<BenchUpload>& uploads) {
+	// the material: normals and diffuse of 4 materials in one 8 slice array of 1024 x 1024.
+	uploads.push_back({ MakeRGBA(1024, 1024, 8), 8, false });
+
+	TerrainMeshInfo info = CalcTerrainMeshInfo(size, size);
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		uploads.push_back({ MakeRGBA(size, size, 1), 1, false });
+		// the first tile creates the 512 x 512 displacement map and the index buffers the rest share.
+		if (t == 0) uploads.push_back({ MakeRGBA(512, 512, 1), 1, false });
+		// PackedVertex is 8 bytes.
+		uploads.push_back({ MakeBuffer((unsigned long long)info.numVertices * 8), 1, false });
+		if (t == 0) {
+			std::vector<PatchChunk> chunks;
+			std::vector<unsigned short> indices;
+			BuildPatchChunks(info.numX, info.numY, PATCH_CHUNK_SIZE, chunks, indices);
+			uploads.push_back({ MakeBuffer(indices.size() * sizeof(unsigned short)), 1, false });
+			unsigned long numSkirtIndices = info.numIndices - (info.numX - 1) * (info.numY - 1) * 4;
+			uploads.push_back({ MakeBuffer(numSkirtIndices * sizeof(unsigned int)), 1, false });
+		}
+		// TerrainShaderConstants.
+		uploads.push_back({ MakeBuffer(48), 1, false });
+	}
+
+	// each stroke uploads the heightmap texels it touched, a texel further out on each side, and the rows of control points over them.
+	std::mt19937 rng(7);
+	for (unsigned int s = 0; s < numStrokes; ++s) {
+		unsigned int side = 2 * (4 + rng() % 29) + 3;
+		uploads.push_back({ MakeRGBA(side, side, 1), 1, true });
+		unsigned int rows = side / TERRAIN_GRID_SPACING + 2;
+		uploads.push_back({ MakeBuffer((unsigned long long)rows * info.numX * 8), 1, true });
+	}
+}
+
+// How a way of placing uploads used the upload buffer.
+struct PlacementResult {
+	unsigned long long	bytesRequested;
+	unsigned long long	bytesPadding;		// alignment, or rounding up to a power of 2.
+	unsigned long long	bytesHighWater;
+	unsigned long long	numResets;
+	unsigned long long	numTooLarge;		// uploads that needed a temporary buffer of their own, and a stall.
+};
+
+// Place uploads through an UploadRing the way ResourceManager::PlaceUpload() does.
+static PlacementResult PlaceExact(const std::vector<BenchUpload>& uploads, unsigned long long sizeRing) {
+	UploadRing ring(sizeRing);
+	for (auto& upload : uploads) {
+		unsigned long long size = CalcUploadFootprints(upload.desc, 0, upload.numSubresources, 0, nullptr);
+		unsigned long long offset;
+		if (!ring.Allocate(size, UPLOAD_PLACEMENT_ALIGNMENT, offset) && ring.Fits(size)) {
+			ring.Reset();
+			ring.Allocate(size, UPLOAD_PLACEMENT_ALIGNMENT, offset);
+		}
+	}
+
+	UploadRingStats stats = ring.GetStats();
+	return { stats.bytesRequested, stats.bytesPadding, stats.bytesHighWater, stats.numResets, stats.numTooLarge };
+}
+
+// Place uploads the way UploadToBuffer() used to, with every upload rounded up to the next power of 2 and placed right
+// after the last.
+static PlacementResult PlacePow2(const std::vector<BenchUpload>& uploads, unsigned long long sizeRing) {
+	PlacementResult result = {};
+	unsigned long long iFree = 0;
+	for (auto& upload : uploads) {
+		unsigned long long size = CalcUploadFootprints(upload.desc, 0, upload.numSubresources, 0, nullptr);
+		unsigned long long sizePow2 = 1;
+		while (sizePow2 < size) sizePow2 <<= 1;
+		if (sizePow2 > sizeRing) {
+			++result.numTooLarge;
+			continue;
+		}
+		if (sizePow2 > sizeRing - iFree) {
+			iFree = 0;
+			++result.numResets;
+		}
+
+		result.bytesRequested += size;
+		result.bytesPadding += sizePow2 - size;
+		iFree += sizePow2;
+		if (iFree > result.bytesHighWater) result.bytesHighWater = iFree;
+	}
+
+	return result;
+}
+
+// Print how a way of placing uploads did.
+static void PrintResult(const char* name, const PlacementResult& result) {
+	printf("    %-14s %10.2f %12.2f %10.2f %7llu %10llu\n", name, (double)result.bytesRequested / 1048576.0,
+		(double)result.bytesPadding / 1024.0, (double)result.bytesHighWater / 1048576.0, result.numResets, result.numTooLarge);
+}
+
+// --size=<texels> sets the size of each tile's heightmap, --tiles=<count> the number of tiles, --strokes=<count> the brush
+// strokes after loading, and --ring=<MB> the size of the upload buffer.
+BENCHMARK(UploadPlacement, SceneUploads) {
+	unsigned int size = GetTestOption("size") ? (unsigned int)atoi(GetTestOption("size")) : 2048;
+	unsigned int numTiles = GetTestOption("tiles") ? (unsigned int)atoi(GetTestOption("tiles")) : 4;
+	unsigned int numStrokes = GetTestOption("strokes") ? (unsigned int)atoi(GetTestOption("strokes")) : 256;
+	unsigned long long sizeRing = GetTestOption("ring") ? (unsigned long long)(atof(GetTestOption("ring")) * 1048576.0) : UPLOAD_BUFFER_SIZE;
+
+	std::vector<BenchUpload> uploads, loads;
+	BuildUploads(size, numTiles, numStrokes, uploads);
+	for (auto& upload : uploads) {
+		if (!upload.isEdit) loads.push_back(upload);
+	}
+
+	printf("  %u tiles of %u x %u, %u brush strokes, %.2f MB upload buffer.\n", numTiles, size, size, numStrokes,
+		(double)sizeRing / 1048576.0);
+	printf("    %-14s %10s %12s %10s %7s %10s\n", "", "asked MB", "padding KB", "high MB", "resets", "too large");
+	printf("  loading, %u uploads:\n", (unsigned int)loads.size());
+	PrintResult("exact", PlaceExact(loads, sizeRing));
+	PrintResult("power of 2", PlacePow2(loads, sizeRing));
+	printf("  loading and editing, %u uploads:\n", (unsigned int)uploads.size());
+	PrintResult("exact", PlaceExact(uploads, sizeRing));
+	PrintResult("power of 2", PlacePow2(uploads, sizeRing));
+}
@@ -0,0 +1,144 @@
+/*
+UploadPlacementTests.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Tests CalcUploadFootprints() against the layout rules of GetCopyableFootprints() on odd sized
+				textures, and the space UploadRing hands out.
+*/
+#include "Test.h"
+#include "UploadPlacement.h"
+#include <vector>
+
+// Returns a 2D texture description with bytesPerTexel bytes per texel.
+static UploadTextureDesc MakeTexture(unsigned int width, unsigned int height, unsigned int mipLevels, unsigned int bytesPerTexel) {
+	UploadTextureDesc desc = {};
+	desc.width = width;
+	desc.height = height;
+	desc.depthOrArraySize = 1;
+	desc.mipLevels = mipLevels;
+	desc.bytesPerBlock = bytesPerTexel;
+	desc.blockDim = 1;
+	return desc;
+}
+
+// Check every footprint of desc: each mip halves and rounds down to no less than 1, starts on a 512 byte boundary right
+// after the one before, and has rows 256 bytes apart. Returns the size the upload should take.
+static unsigned long long CheckFootprints(const UploadTextureDesc& desc, unsigned long long baseOffset) {
+	std::vector<UploadFootprint> footprints(desc.mipLevels);
+	unsigned long long size = CalcUploadFootprints(desc, 0, desc.mipLevels, baseOffset, footprints.data());
+
+	unsigned long long end = 0;
+	unsigned int width = desc.width, height = desc.height;
+	for (unsigned int m = 0; m < desc.mipLevels; ++m) {
+		const UploadFootprint& fp = footprints[m];
+		CHECK(fp.width == width && fp.height == height && fp.depth == 1);
+		CHECK(fp.numRows == height);
+		CHECK(fp.rowSizeInBytes == (unsigned long long)width * desc.bytesPerBlock);
+		CHECK(fp.rowPitch % UPLOAD_ROW_PITCH_ALIGNMENT == 0);
+		CHECK(fp.rowPitch >= fp.rowSizeInBytes && fp.rowPitch < fp.rowSizeInBytes + UPLOAD_ROW_PITCH_ALIGNMENT);
+		CHECK((fp.offset - baseOffset) % UPLOAD_PLACEMENT_ALIGNMENT == 0);
+		CHECK(fp.offset - baseOffset >= end && fp.offset - baseOffset < end + UPLOAD_PLACEMENT_ALIGNMENT);
+
+		// the last row of the last mip isn't padded.
+		end = fp.offset - baseOffset + (unsigned long long)fp.rowPitch * fp.numRows;
+		if (m == desc.mipLevels - 1) end -= fp.rowPitch - fp.rowSizeInBytes;
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	CHECK(size == end);
+	return size;
+}
+
+TEST(UploadPlacement, SingleTexel) {
+	CHECK(CheckFootprints(MakeTexture(1, 1, 1, 4), 0) == 4);
+	CHECK(CheckFootprints(MakeTexture(1, 1, 1, 2), 0) == 2);
+	CHECK(CheckFootprints(MakeTexture(1, 1, 1, 4), 1024) == 4);
+}
+
+TEST(UploadPlacement, OddWidth) {
+	// RGBA8: 1028 byte rows padded to 1280. R16: 514 byte rows padded to 768.
+	CHECK(CheckFootprints(MakeTexture(257, 3, 1, 4), 0) == 1280 * 2 + 1028);
+	CHECK(CheckFootprints(MakeTexture(257, 3, 1, 2), 0) == 768 * 2 + 514);
+
+	// the mips of a 257 x 3 texture are 128 x 1 and on down to 1 x 1.
+	CheckFootprints(MakeTexture(257, 3, 9, 4), 0);
+	CheckFootprints(MakeTexture(257, 3, 9, 2), 512);
+}
+
+TEST(UploadPlacement, OddSizeWithMips) {
+	// 1023 x 1023 has 10 mips, 511 x 511 down to 1 x 1.
+	UploadTextureDesc rgba8 = MakeTexture(1023, 1023, 10, 4);
+	UploadTextureDesc r16 = MakeTexture(1023, 1023, 10, 2);
+	unsigned long long sizeRGBA8 = CheckFootprints(rgba8, 0);
+	unsigned long long sizeR16 = CheckFootprints(r16, 0);
+
+	UploadFootprint fp[10];
+	CalcUploadFootprints(rgba8, 0, 10, 0, fp);
+	CHECK(fp[0].rowPitch == 4096 && fp[1].offset == 4096ull * 1023);
+	CHECK(fp[9].width == 1 && fp[9].height == 1);
+	CalcUploadFootprints(r16, 0, 10, 0, fp);
+	CHECK(fp[0].rowPitch == 2048 && fp[1].offset == AlignUploadOffset(2048ull * 1023, UPLOAD_PLACEMENT_ALIGNMENT));
+
+	// halving the texel size only halves the rows that are already a multiple of 256 bytes.
+	CHECK(sizeR16 > sizeRGBA8 / 2 && sizeR16 < sizeRGBA8);
+
+	// placing a run of mips on its own gives the same footprints, moved to the start.
+	UploadFootprint tail[4];
+	unsigned long long sizeTail = CalcUploadFootprints(rgba8, 6, 4, 0, tail);
+	CalcUploadFootprints(rgba8, 0, 10, 0, fp);
+	for (int i = 0; i < 4; ++i) {
+		CHECK(tail[i].offset == fp[6 + i].offset - fp[6].offset);
+		CHECK(tail[i].rowPitch == fp[6 + i].rowPitch);
+	}
+	CHECK(sizeTail == sizeRGBA8 - fp[6].offset);
+}
+
+TEST(UploadPlacement, BuffersAndInvalid) {
+	UploadTextureDesc buffer = MakeTexture(1001, 1, 1, 1);
+	buffer.isBuffer = true;
+	UploadFootprint fp;
+	CHECK(CalcUploadFootprints(buffer, 0, 1, 0, &fp) == 1001);
+	CHECK(fp.rowPitch == 1001 && fp.offset == 0);
+
+	CHECK(CalcUploadFootprints(MakeTexture(0, 1, 1, 4), 0, 1, 0, nullptr) == 0);
+	CHECK(CalcUploadFootprints(MakeTexture(16, 16, 5, 4), 3, 3, 0, nullptr) == 0);
+}
+
+TEST(UploadPlacement, RingPlacesUploads) {
+	UploadTextureDesc r16 = MakeTexture(257, 3, 1, 2);
+	UploadTextureDesc rgba8 = MakeTexture(1023, 1023, 10, 4);
+	unsigned long long sizeR16 = CalcUploadFootprints(r16, 0, 1, 0, nullptr);
+	unsigned long long sizeRGBA8 = CalcUploadFootprints(rgba8, 0, 10, 0, nullptr);
+
+	UploadRing ring(sizeRGBA8 + 4096);
+	unsigned long long offset;
+	REQUIRE(ring.Allocate(sizeR16, UPLOAD_PLACEMENT_ALIGNMENT, offset));
+	CHECK(offset == 0);
+	REQUIRE(ring.Allocate(1, 1, offset));
+	CHECK(offset == sizeR16);
+
+	// the next upload starts on the next 512 byte boundary.
+	REQUIRE(ring.Allocate(sizeR16, UPLOAD_PLACEMENT_ALIGNMENT, offset));
+	CHECK(offset == 2560 && ring.GetUsed() == 2560 + sizeR16);
+
+	// the big texture doesn't fit behind them until the ring is reset.
+	CHECK(!ring.Allocate(sizeRGBA8, UPLOAD_PLACEMENT_ALIGNMENT, offset));
+	ring.Reset();
+	REQUIRE(ring.Allocate(sizeRGBA8, UPLOAD_PLACEMENT_ALIGNMENT, offset));
+	CHECK(offset == 0);
+
+	// and something bigger than the ring never fits.
+	CHECK(!ring.Fits(ring.GetSize() + 1));
+	CHECK(!ring.Allocate(ring.GetSize() + 1, 1, offset));
+
+	UploadRingStats stats = ring.GetStats();
+	CHECK(stats.numAllocations == 4);
+	CHECK(stats.bytesRequested == sizeR16 * 2 + 1 + sizeRGBA8);
+	CHECK(stats.bytesPadding == 2560 - sizeR16 - 1);
+	CHECK(stats.bytesHighWater == sizeRGBA8);
+	CHECK(stats.numResets == 1);
+	CHECK(stats.numTooLarge == 1);
+}
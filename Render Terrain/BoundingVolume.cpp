@@ -49,4 +49,38 @@ BoundingSphere FindBoundingSphere(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c) {
 	XMStoreFloat(&radius, r);
 	XMStoreFloat3(&center, Circumcenter);
 	return BoundingSphere(radius, center);
-}
\ No newline at end of file
+}
+
+// Returns false if the box from min to max is completely behind any of the numPlanes inward facing planes.
+// This is the same test the hull shaders and CullPatchesCS use, so CPU and GPU culling agree.
+bool AABBIntersectsPlanes(XMFLOAT3 min, XMFLOAT3 max, const XMFLOAT4* planes, unsigned int numPlanes) {
+	XMFLOAT3 center(0.5f * (min.x + max.x), 0.5f * (min.y + max.y), 0.5f * (min.z + max.z));
+	XMFLOAT3 extents(0.5f * (max.x - min.x), 0.5f * (max.y - min.y), 0.5f * (max.z - min.z));
+
+	for (unsigned int i = 0; i < numPlanes; ++i) {
+		const XMFLOAT4& plane = planes[i];
+		float e = extents.x * fabsf(plane.x) + extents.y * fabsf(plane.y) + extents.z * fabsf(plane.z);
+		float d = center.x * plane.x + center.y * plane.y + center.z * plane.z + plane.w;
+		// the box is completely behind the plane.
+		if (d + e < 0.0f) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Returns the distance from the center to a corner, ie the radius of the sphere bounding the box.
+float AxisAlignedBoundingBox::GetRadius() {
+	XMVECTOR extents = (XMLoadFloat3(&m_vMax) - XMLoadFloat3(&m_vMin)) * 0.5f;
+	return XMVectorGetX(XMVector3Length(extents));
+}
+
+// Write the 8 corners of the box to corners.
+void AxisAlignedBoundingBox::GetCorners(XMFLOAT3 corners[8]) {
+	for (int i = 0; i < 8; ++i) {
+		corners[i].x = (i & 1) ? m_vMax.x : m_vMin.x;
+		corners[i].y = (i & 2) ? m_vMax.y : m_vMin.y;
+		corners[i].z = (i & 4) ? m_vMax.z : m_vMin.z;
+	}
+}
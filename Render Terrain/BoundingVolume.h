@@ -4,12 +4,11 @@ BoundingVolume.h
 Author:			Chris Serson
 Last Edited:	October 14, 2016
 
-Description:	Classes and methods defining bounding volumes. Currently only BoundingSphere.
+Description:	Classes and methods defining bounding volumes. Currently BoundingSphere and AxisAlignedBoundingBox.
 
 Usage:			- Proper shutdown is handled by the destructor.
 
 Future Work:	- Add collision detection to Bounding Sphere.
-				- Add Axis Aligned Bounding Box.
 				- Add Object Oriented Bounding Box.
 				- Add K-DOP.
 */
@@ -22,6 +21,9 @@ class BoundingSphere;
 
 // Find a bounding sphere by finding the circumcenter of 3 points and the distance from the points to the circumcenter
 BoundingSphere FindBoundingSphere(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c);
+// Returns false if the box from min to max is completely behind any of the numPlanes inward facing planes.
+// This is the same test the hull shaders and CullPatchesCS use, so CPU and GPU culling agree.
+bool AABBIntersectsPlanes(XMFLOAT3 min, XMFLOAT3 max, const XMFLOAT4* planes, unsigned int numPlanes);
 
 class BoundingSphere {
 public:
@@ -40,3 +42,24 @@ private:
 	XMFLOAT3	m_vCenter;
 };
 
+class AxisAlignedBoundingBox {
+public:
+	AxisAlignedBoundingBox(XMFLOAT3 min = XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3 max = XMFLOAT3(0.0f, 0.0f, 0.0f)) : m_vMin(min), m_vMax(max) {}
+	~AxisAlignedBoundingBox() {}
+
+	XMFLOAT3 GetMin() { return m_vMin; }
+	void SetMin(XMFLOAT3 min) { m_vMin = min; }
+
+	XMFLOAT3 GetMax() { return m_vMax; }
+	void SetMax(XMFLOAT3 max) { m_vMax = max; }
+
+	XMFLOAT3 GetCenter() { return XMFLOAT3((m_vMin.x + m_vMax.x) / 2.0f, (m_vMin.y + m_vMax.y) / 2.0f, (m_vMin.z + m_vMax.z) / 2.0f); }
+	// Returns the distance from the center to a corner, ie the radius of the sphere bounding the box.
+	float GetRadius();
+	// Write the 8 corners of the box to corners.
+	void GetCorners(XMFLOAT3 corners[8]);
+
+private:
+	XMFLOAT3	m_vMin;
+	XMFLOAT3	m_vMax;
+};
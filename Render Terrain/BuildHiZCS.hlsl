@@ -0,0 +1,31 @@
+// must match HIZ_GROUP_SIZE in HiZPyramid.h.
+#define HIZ_GROUP_SIZE 8
+
+cbuffer HiZConstants : register(b0)
+{
+	uint2 srcSize;
+	uint2 dstSize;
+}
+
+Texture2D<float> src : register(t0);	// the depth buffer for mip 0, the previous mip otherwise.
+RWTexture2D<float> dst : register(u0);
+
+[numthreads(HIZ_GROUP_SIZE, HIZ_GROUP_SIZE, 1)]
+void main(uint3 DTid : SV_DispatchThreadID)
+{
+	if (DTid.x >= dstSize.x || DTid.y >= dstSize.y) return;
+
+	// every source texel the destination texel overlaps, even partially. Mip 0 is a power of two that fits inside
+	// the depth buffer, so its texels can cover up to 3x3 depth pixels. Every later mip is an exact 2x2 reduction.
+	uint2 first = (DTid.xy * srcSize) / dstSize;
+	uint2 last = ((DTid.xy + 1) * srcSize + dstSize - 1) / dstSize;
+
+	float depth = 0.0f;
+	for (uint y = first.y; y < last.y; ++y) {
+		for (uint x = first.x; x < last.x; ++x) {
+			depth = max(depth, src.Load(int3(x, y, 0)));
+		}
+	}
+
+	dst[DTid.xy] = depth;
+}
@@ -23,9 +23,9 @@ Camera::Camera(int h, int w) {
 
 	// set starting camera state
 	m_vPos = XMFLOAT4(0.0f, 0.0f, 150.0f, 0.0f);
-	XMVECTOR look = XMVector3Normalize(XMLoadFloat4(&XMFLOAT4(1.0f, 1.0f, 0.0f, 0.0f)));
+	XMVECTOR look = XMVector3Normalize(XMVectorSet(1.0f, 1.0f, 0.0f, 0.0f));
 	XMStoreFloat4(&m_vStartLook, look);
-	XMVECTOR left = XMVector3Cross(look, XMLoadFloat4(&XMFLOAT4(0.0f, 0.0f, 1.0f, 0.0f)));
+	XMVECTOR left = XMVector3Cross(look, XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f));
 	XMStoreFloat4(&m_vStartLeft, left);
 	XMVECTOR up = XMVector3Cross(left, look);
 	XMStoreFloat4(&m_vStartUp, up);
@@ -46,6 +46,11 @@ XMFLOAT4X4 Camera::GetViewProjectionMatrixTransposed() {
 	return final;
 }
 
+// Returns the height in pixels of one world unit seen from a distance of one unit.
+float Camera::GetPixelsPerUnit() {
+	return (float)m_hScreen / (2.0f * tanf(XMConvertToRadians(m_fovVertical) * 0.5f));
+}
+
 // Return the 6 planes forming the view frustum. Stored in the array planes.
 void Camera::GetViewFrustum(XMFLOAT4 planes[6]) {
 	XMMATRIX view = XMLoadFloat4x4(&m_mView);
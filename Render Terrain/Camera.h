@@ -46,6 +46,10 @@ public:
 	XMFLOAT4X4 GetViewProjectionMatrixTransposed();
 	// returns m_vPos;
 	XMFLOAT4 GetEyePosition() { return m_vPos; }
+	// returns m_vCurLook, the unit vector the camera is looking along.
+	XMFLOAT4 GetLookDirection() { return m_vCurLook; }
+	// Returns the height in pixels of one world unit seen from a distance of one unit.
+	float GetPixelsPerUnit();
 	// Return the 6 planes forming the view frustum. Stored in the array planes.
 	void GetViewFrustum(XMFLOAT4 planes[6]);
 	// Move the camera along its 3 axis: m_vStartLook (forward/backward), m_vStartLeft (left/right), m_vStartUp (up/down)
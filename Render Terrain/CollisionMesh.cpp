@@ -0,0 +1,210 @@
+/*
+CollisionMesh.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Builds triangle meshes of the displaced terrain for physics and caches them around moving bodies.
+*/
+#include "CollisionMesh.h"
+#include "ParallelFor.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Returns the distance between neighbouring vertices of a chunk at lod.
+float CalcCollisionSpacing(unsigned int lod) {
+	if (lod > COLLISION_MAX_LOD) lod = COLLISION_MAX_LOD;
+	return (float)TERRAIN_GRID_SPACING / TESS_MAX_FACTOR * (float)(1 << lod);
+}
+
+// Returns the world units along x and y the terrain mesh covers. Its last control point is a grid step short of the edge.
+static void CalcCollisionExtent(const TerrainSurface* surface, float& extentX, float& extentY) {
+	extentX = (float)((surface->GetWidth() / TERRAIN_GRID_SPACING - 1) * TERRAIN_GRID_SPACING);
+	extentY = (float)((surface->GetDepth() / TERRAIN_GRID_SPACING - 1) * TERRAIN_GRID_SPACING);
+}
+
+// Returns the number of chunks needed along each side of the terrain.
+void CalcCollisionChunkCount(const TerrainSurface* surface, int& numX, int& numY) {
+	float extentX, extentY;
+	CalcCollisionExtent(surface, extentX, extentY);
+	numX = (int)ceilf(extentX / COLLISION_CHUNK_SIZE);
+	numY = (int)ceilf(extentY / COLLISION_CHUNK_SIZE);
+}
+
+// Build the vertices, indices and bounds of num chunks, which must have x, y and lod filled in.
+// Runs on numThreads threads, or one per hardware thread if 0.
+void BuildCollisionChunks(const TerrainSurface* surface, CollisionChunk* chunks, unsigned int num, unsigned int numThreads) {
+	if (numThreads == 0) {
+		numThreads = std::thread::hardware_concurrency();
+	}
+
+	float extentX, extentY;
+	CalcCollisionExtent(surface, extentX, extentY);
+
+	// size every chunk first, so the rows of all of them can be handed out as one list.
+	std::vector<int> listVertsX(num), listVertsY(num), listFirstRow(num + 1, 0);
+	for (unsigned int c = 0; c < num; ++c) {
+		float spacing = CalcCollisionSpacing(chunks[c].lod);
+		float x0 = chunks[c].x * COLLISION_CHUNK_SIZE;
+		float y0 = chunks[c].y * COLLISION_CHUNK_SIZE;
+		float x1 = fminf(x0 + COLLISION_CHUNK_SIZE, extentX);
+		float y1 = fminf(y0 + COLLISION_CHUNK_SIZE, extentY);
+		// the chunk edges are whole patches and the spacing divides a patch, so these are whole numbers.
+		listVertsX[c] = x1 > x0 ? (int)((x1 - x0) / spacing + 0.5f) + 1 : 0;
+		listVertsY[c] = y1 > y0 ? (int)((y1 - y0) / spacing + 0.5f) + 1 : 0;
+		chunks[c].listVertices.resize((size_t)listVertsX[c] * listVertsY[c]);
+		listFirstRow[c + 1] = listFirstRow[c] + listVertsY[c];
+	}
+
+	// each vertex is where the domain shader puts the tessellated vertex at the same point, displacement and all.
+	ParallelForBands(listFirstRow[num], numThreads, [&](int r0, int r1) {
+		unsigned int c = 0;
+		for (int r = r0; r < r1; ++r) {
+			while (listFirstRow[c + 1] <= r) ++c;
+
+			float spacing = CalcCollisionSpacing(chunks[c].lod);
+			int row = r - listFirstRow[c];
+			float y = chunks[c].y * COLLISION_CHUNK_SIZE + row * spacing;
+			XMFLOAT3* dst = &chunks[c].listVertices[(size_t)row * listVertsX[c]];
+			for (int col = 0; col < listVertsX[c]; ++col) {
+				dst[col] = surface->GetDisplacedPosition(chunks[c].x * COLLISION_CHUNK_SIZE + col * spacing, y);
+			}
+		}
+	});
+
+	ParallelForBands((int)num, numThreads, [&](int c0, int c1) {
+		for (int c = c0; c < c1; ++c) {
+			CollisionChunk& chunk = chunks[c];
+			int numX = listVertsX[c];
+			int numY = listVertsY[c];
+
+			chunk.listIndices.clear();
+			if (numX > 1 && numY > 1) chunk.listIndices.reserve((size_t)(numX - 1) * (numY - 1) * 6);
+			for (int y = 0; y < numY - 1; ++y) {
+				for (int x = 0; x < numX - 1; ++x) {
+					unsigned int i00 = y * numX + x;
+					unsigned int i10 = i00 + 1;
+					unsigned int i01 = i00 + numX;
+					unsigned int i11 = i01 + 1;
+					chunk.listIndices.push_back(i00);
+					chunk.listIndices.push_back(i10);
+					chunk.listIndices.push_back(i11);
+					chunk.listIndices.push_back(i00);
+					chunk.listIndices.push_back(i11);
+					chunk.listIndices.push_back(i01);
+				}
+			}
+
+			chunk.aabbmin = XMFLOAT3(1e30f, 1e30f, 1e30f);
+			chunk.aabbmax = XMFLOAT3(-1e30f, -1e30f, -1e30f);
+			for (auto& v : chunk.listVertices) {
+				chunk.aabbmin = XMFLOAT3(fminf(chunk.aabbmin.x, v.x), fminf(chunk.aabbmin.y, v.y), fminf(chunk.aabbmin.z, v.z));
+				chunk.aabbmax = XMFLOAT3(fmaxf(chunk.aabbmax.x, v.x), fmaxf(chunk.aabbmax.y, v.y), fmaxf(chunk.aabbmax.z, v.z));
+			}
+		}
+	});
+}
+
+CollisionMeshCache::CollisionMeshCache(const TerrainSurface* surface, unsigned int lod, unsigned int numThreads) : m_pSurface(surface),
+	m_Stats(), m_lod(lod > COLLISION_MAX_LOD ? COLLISION_MAX_LOD : lod), m_numThreads(numThreads) {
+	CalcCollisionChunkCount(m_pSurface, m_numChunksX, m_numChunksY);
+}
+
+// Returns true if chunk (x, y) is within distance of any of the bodies, in x and y only.
+bool CollisionMeshCache::IsNearBody(int x, int y, const XMFLOAT3* bodies, unsigned int numBodies, float distance) const {
+	float x0 = x * COLLISION_CHUNK_SIZE;
+	float y0 = y * COLLISION_CHUNK_SIZE;
+	for (unsigned int b = 0; b < numBodies; ++b) {
+		// distance from the body to the nearest point of the chunk.
+		float dx = fmaxf(fmaxf(x0 - bodies[b].x, bodies[b].x - (x0 + COLLISION_CHUNK_SIZE)), 0.0f);
+		float dy = fmaxf(fmaxf(y0 - bodies[b].y, bodies[b].y - (y0 + COLLISION_CHUNK_SIZE)), 0.0f);
+		if (dx * dx + dy * dy <= distance * distance) return true;
+	}
+
+	return false;
+}
+
+// Build the chunks within radius of the numBodies positions in bodies and drop the ones a chunk further away.
+void CollisionMeshCache::Update(const XMFLOAT3* bodies, unsigned int numBodies, float radius) {
+	// drop what has been left behind, keeping a chunk's worth of slack.
+	unsigned int numKept = 0;
+	for (unsigned int i = 0; i < m_listChunks.size(); ++i) {
+		if (IsNearBody(m_listChunks[i].x, m_listChunks[i].y, bodies, numBodies, radius + COLLISION_CHUNK_SIZE)) {
+			if (numKept != i) m_listChunks[numKept] = std::move(m_listChunks[i]);
+			++numKept;
+		} else {
+			++m_Stats.numDropped;
+		}
+	}
+	m_listChunks.resize(numKept);
+
+	// find what's missing. Only the chunks under the bodies' reach need checking.
+	std::vector<CollisionChunk> listNew;
+	int reach = (int)ceilf(radius / COLLISION_CHUNK_SIZE);
+	for (unsigned int b = 0; b < numBodies; ++b) {
+		int bx = (int)floorf(bodies[b].x / COLLISION_CHUNK_SIZE);
+		int by = (int)floorf(bodies[b].y / COLLISION_CHUNK_SIZE);
+		for (int y = by - reach; y <= by + reach; ++y) {
+			for (int x = bx - reach; x <= bx + reach; ++x) {
+				if (x < 0 || y < 0 || x >= m_numChunksX || y >= m_numChunksY) continue;
+				if (!IsNearBody(x, y, &bodies[b], 1, radius) || GetChunk(x, y)) continue;
+
+				bool isQueued = false;
+				for (auto& chunk : listNew) {
+					isQueued = isQueued || (chunk.x == x && chunk.y == y);
+				}
+				if (isQueued) continue;
+
+				CollisionChunk chunk = {};
+				chunk.x = x;
+				chunk.y = y;
+				chunk.lod = m_lod;
+				listNew.push_back(std::move(chunk));
+			}
+		}
+	}
+
+	if (!listNew.empty()) {
+		auto tStart = std::chrono::high_resolution_clock::now();
+		BuildCollisionChunks(m_pSurface, listNew.data(), (unsigned int)listNew.size(), m_numThreads);
+		m_Stats.msLastBuild = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+		m_Stats.numBuilt += listNew.size();
+		for (auto& chunk : listNew) {
+			m_listChunks.push_back(std::move(chunk));
+		}
+	}
+
+	m_Stats.numChunks = (unsigned int)m_listChunks.size();
+	m_Stats.numTriangles = 0;
+	for (auto& chunk : m_listChunks) {
+		m_Stats.numTriangles += chunk.listIndices.size() / 3;
+	}
+}
+
+// Drop the chunks overlapping the world space rectangle from (x0, y0) to (x1, y1), so the next Update() rebuilds them.
+void CollisionMeshCache::Invalidate(float x0, float y0, float x1, float y1) {
+	unsigned int numKept = 0;
+	for (unsigned int i = 0; i < m_listChunks.size(); ++i) {
+		float cx0 = m_listChunks[i].x * COLLISION_CHUNK_SIZE;
+		float cy0 = m_listChunks[i].y * COLLISION_CHUNK_SIZE;
+		if (cx0 > x1 || cy0 > y1 || cx0 + COLLISION_CHUNK_SIZE < x0 || cy0 + COLLISION_CHUNK_SIZE < y0) {
+			if (numKept != i) m_listChunks[numKept] = std::move(m_listChunks[i]);
+			++numKept;
+		} else {
+			++m_Stats.numDropped;
+		}
+	}
+	m_listChunks.resize(numKept);
+	m_Stats.numChunks = numKept;
+}
+
+// Returns chunk (x, y), or nullptr if it isn't cached.
+const CollisionChunk* CollisionMeshCache::GetChunk(int x, int y) const {
+	// there are rarely more than a few dozen chunks cached, so a linear search does.
+	for (auto& chunk : m_listChunks) {
+		if (chunk.x == x && chunk.y == y) return &chunk;
+	}
+
+	return nullptr;
+}
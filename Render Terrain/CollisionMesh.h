@@ -0,0 +1,97 @@
+/*
+CollisionMesh.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Builds triangle meshes of the displaced terrain for physics, a square chunk at a time, and keeps
+				the chunks around moving bodies cached. Every vertex is put where RenderTerrainTessDS.hlsl puts
+				the tessellated vertex at the same point of the patch, using TerrainSurface. Only depends on
+				DirectXMath, so meshes can be built and checked without a Direct3D 12 device.
+
+Usage:			- Chunks are COLLISION_CHUNK_SIZE world units square. Chunk (x, y) starts at world (x, y) * COLLISION_CHUNK_SIZE.
+					Chunks only cover the part of the heightmap the terrain mesh covers, so those along the far
+					edges may be smaller.
+				- LOD 0 has a vertex everywhere the tessellator puts one at its highest factor, which is
+					TERRAIN_GRID_SPACING / TESS_MAX_FACTOR apart. Each LOD up doubles the spacing, up to
+					COLLISION_MAX_LOD, which only has the corners of the patches.
+				- Call BuildCollisionChunks() with chunks whose x, y and lod are filled in. The vertex rows of
+					all of them are shared between numThreads threads, or one per hardware thread if 0.
+				- Triangles are 3 indices each and wind counter-clockwise seen from above.
+				- The CollisionMesh tests in Render Terrain Tests check the vertices against a transcription of the
+					domain shader, so change both when either changes.
+				- CollisionMeshCache builds chunks at a single LOD. Call Update() with the positions of the bodies
+					that need collision. It builds the chunks within radius of any body that aren't cached and drops
+					the ones more than radius + COLLISION_CHUNK_SIZE from every body, so a body moving back and forth
+					over the edge of a chunk doesn't keep rebuilding it.
+				- When the terrain is edited, call Invalidate() with the part of it that changed. The chunks there are
+					dropped, and rebuilt by the next Update() if they are still near a body.
+				- GetChunk() returns nullptr for chunks that aren't cached. Pointers stay valid until the next Update().
+
+Future Work:	- Build missing chunks on a background thread rather than in Update().
+				- Stitch together neighbouring chunks of different LODs.
+*/
+#pragma once
+
+#include "TerrainSurface.h"
+#include "TerrainMesh.h"
+#include <vector>
+
+// world units along each side of a chunk. A whole number of patches.
+static const float COLLISION_CHUNK_SIZE = 4.0f * TERRAIN_GRID_SPACING;
+// the coarsest LOD. Its vertices are TERRAIN_GRID_SPACING apart.
+static const unsigned int COLLISION_MAX_LOD = 6;
+
+struct CollisionChunk {
+	int							x;
+	int							y;
+	unsigned int				lod;
+	XMFLOAT3					aabbmin;
+	XMFLOAT3					aabbmax;
+	std::vector<XMFLOAT3>		listVertices;	// row by row, starting at the chunk's lowest corner.
+	std::vector<unsigned int>	listIndices;	// 3 per triangle.
+};
+
+// What a CollisionMeshCache has done so far.
+struct CollisionCacheStats {
+	unsigned int		numChunks;			// chunks cached now.
+	unsigned long long	numTriangles;		// triangles in the cached chunks.
+	unsigned long long	numBuilt;			// chunks built since the cache was created.
+	unsigned long long	numDropped;			// chunks dropped since the cache was created.
+	double				msLastBuild;		// time the last Update() that built anything spent building.
+};
+
+// Returns the distance between neighbouring vertices of a chunk at lod.
+float CalcCollisionSpacing(unsigned int lod);
+// Returns the number of chunks needed along each side of the terrain.
+void CalcCollisionChunkCount(const TerrainSurface* surface, int& numX, int& numY);
+// Build the vertices, indices and bounds of num chunks, which must have x, y and lod filled in.
+// Runs on numThreads threads, or one per hardware thread if 0.
+void BuildCollisionChunks(const TerrainSurface* surface, CollisionChunk* chunks, unsigned int num, unsigned int numThreads);
+
+class CollisionMeshCache {
+public:
+	// surface must outlive the cache. Chunks are built at lod on numThreads threads, or one per hardware thread if 0.
+	CollisionMeshCache(const TerrainSurface* surface, unsigned int lod, unsigned int numThreads);
+
+	// Build the chunks within radius of the numBodies positions in bodies and drop the ones a chunk further away.
+	void Update(const XMFLOAT3* bodies, unsigned int numBodies, float radius);
+	// Drop the chunks overlapping the world space rectangle from (x0, y0) to (x1, y1), so the next Update() rebuilds them.
+	void Invalidate(float x0, float y0, float x1, float y1);
+	// Returns chunk (x, y), or nullptr if it isn't cached.
+	const CollisionChunk* GetChunk(int x, int y) const;
+	unsigned int GetNumChunks() const { return (unsigned int)m_listChunks.size(); }
+	CollisionCacheStats GetStats() const { return m_Stats; }
+
+private:
+	// Returns true if chunk (x, y) is within distance of any of the bodies, in x and y only.
+	bool IsNearBody(int x, int y, const XMFLOAT3* bodies, unsigned int numBodies, float distance) const;
+
+	const TerrainSurface*		m_pSurface;
+	std::vector<CollisionChunk>	m_listChunks;
+	CollisionCacheStats			m_Stats;
+	unsigned int				m_lod;
+	unsigned int				m_numThreads;
+	int							m_numChunksX;
+	int							m_numChunksY;
+};
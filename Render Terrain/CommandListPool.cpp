@@ -0,0 +1,172 @@
+/*
+CommandListPool.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	A pool of command allocator and command list pairs, recycled once the GPU is done with them.
+*/
+#include "CommandListPool.h"
+#include <string>
+
+CommandListPool::CommandListPool(Device* dev, unsigned int numThreads) : m_pDev(dev), m_Recycler(NUM_COMMAND_LIST_TYPES, numThreads) {
+	m_pFence = nullptr;
+	m_valFence = 0;
+	m_numWaits = 0;
+
+	m_pDev->CreateFence(m_valFence, D3D12_FENCE_FLAG_NONE, m_pFence);
+	m_hdlFenceEvent = CreateEvent(NULL, false, false, NULL);
+	if (!m_hdlFenceEvent) {
+		throw GFX_Exception("CommandListPool::CommandListPool: Create Fence Event failed on init.");
+	}
+}
+
+CommandListPool::~CommandListPool() {
+	// the allocators can't be released while the GPU is still using them.
+	if (m_pFence) {
+		WaitForIdle();
+	}
+
+	for (unsigned int i = 0; i < m_listCmdLists.size(); ++i) {
+		if (m_listCmdLists[i]) {
+			m_listCmdLists[i]->Release();
+			m_listCmdLists[i] = nullptr;
+		}
+		if (m_listAllocators[i]) {
+			m_listAllocators[i]->Release();
+			m_listAllocators[i] = nullptr;
+		}
+	}
+
+	CloseHandle(m_hdlFenceEvent);
+
+	if (m_pFence) {
+		m_pFence->Release();
+		m_pFence = nullptr;
+	}
+
+	m_pDev = nullptr;
+}
+
+// Returns the entry of a command list of type, reset and ready to be recorded on thread.
+// A recycled allocator is reset here, which is only safe because the fence says the GPU is done with it.
+unsigned int CommandListPool::Acquire(D3D12_COMMAND_LIST_TYPE type, unsigned int thread) {
+	bool isNew;
+	unsigned int entry = m_Recycler.Acquire(type, thread, m_pFence->GetCompletedValue(), isNew);
+	if (entry == COMMAND_NO_ENTRY) {
+		std::string msg = "CommandListPool::Acquire: no command lists of type " + std::to_string(type) + " for thread " + std::to_string(thread) + ".";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	if (isNew) {
+		// a new list is created open, ready to record.
+		ID3D12CommandAllocator* alloc = nullptr;
+		ID3D12GraphicsCommandList* list = nullptr;
+		m_pDev->CreateCommandAllocator(type, alloc);
+		m_pDev->CreateGraphicsCommandList(type, alloc, list);
+		alloc->SetName((L"Pooled Command Allocator " + std::to_wstring(entry)).c_str());
+		list->SetName((L"Pooled Command List " + std::to_wstring(entry)).c_str());
+
+		std::lock_guard<std::mutex> lock(m_mutexLists);
+		if (m_listCmdLists.size() <= entry) {
+			m_listAllocators.resize(entry + 1, nullptr);
+			m_listCmdLists.resize(entry + 1, nullptr);
+		}
+		m_listAllocators[entry] = alloc;
+		m_listCmdLists[entry] = list;
+		return entry;
+	}
+
+	ID3D12CommandAllocator* alloc;
+	ID3D12GraphicsCommandList* list;
+	{
+		std::lock_guard<std::mutex> lock(m_mutexLists);
+		alloc = m_listAllocators[entry];
+		list = m_listCmdLists[entry];
+	}
+	if (FAILED(alloc->Reset())) {
+		throw GFX_Exception("CommandListPool::Acquire: CommandAllocator Reset failed.");
+	}
+	if (FAILED(list->Reset(alloc, NULL))) {
+		throw GFX_Exception("CommandListPool::Acquire: CommandList Reset failed.");
+	}
+
+	return entry;
+}
+
+// Returns the command list of entry.
+ID3D12GraphicsCommandList* CommandListPool::GetList(unsigned int entry) {
+	std::lock_guard<std::mutex> lock(m_mutexLists);
+	if (entry >= m_listCmdLists.size()) {
+		std::string msg = "CommandListPool::GetList failed due to entry " + std::to_string(entry) + " out of bounds.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	return m_listCmdLists[entry];
+}
+
+// Close the command lists of num entries and execute them in order. Returns the fence value that marks them done.
+unsigned long long CommandListPool::Execute(const unsigned int* entries, unsigned int num) {
+	std::vector<ID3D12CommandList*> lCmds(num);
+	for (unsigned int i = 0; i < num; ++i) {
+		if (m_Recycler.GetType(entries[i]) != D3D12_COMMAND_LIST_TYPE_DIRECT) {
+			throw GFX_Exception("CommandListPool::Execute: only direct command lists can be executed.");
+		}
+
+		ID3D12GraphicsCommandList* list = GetList(entries[i]);
+		if (FAILED(list->Close())) {
+			throw GFX_Exception("CommandListPool::Execute: CommandList Close failed.");
+		}
+		lCmds[i] = list;
+	}
+
+	// the fence value and the submission have to go out together, or a later value could be signalled first.
+	std::lock_guard<std::mutex> lock(m_mutexSubmit);
+	m_pDev->ExecuteCommandLists(lCmds.data(), num);
+	unsigned long long val = m_valFence + 1;
+	m_pDev->SetFence(m_pFence, val);
+	m_valFence = val;
+
+	for (unsigned int i = 0; i < num; ++i) {
+		m_Recycler.Submit(entries[i], val);
+	}
+
+	return val;
+}
+
+// Close the command list of entry and give it back without executing it.
+void CommandListPool::Discard(unsigned int entry) {
+	if (FAILED(GetList(entry)->Close())) {
+		throw GFX_Exception("CommandListPool::Discard: CommandList Close failed.");
+	}
+
+	m_Recycler.Discard(entry);
+}
+
+// Returns true if the GPU has finished everything submitted with a fence value of val or less.
+bool CommandListPool::IsComplete(unsigned long long val) {
+	return m_pFence->GetCompletedValue() >= val;
+}
+
+// Block until the GPU has finished everything submitted with a fence value of val or less.
+void CommandListPool::WaitForFence(unsigned long long val) {
+	if (IsComplete(val)) return;
+
+	std::lock_guard<std::mutex> lock(m_mutexWait);
+	if (FAILED(m_pFence->SetEventOnCompletion(val, m_hdlFenceEvent))) {
+		throw GFX_Exception("CommandListPool::WaitForFence failed to SetEventOnCompletion.");
+	}
+
+	WaitForSingleObject(m_hdlFenceEvent, INFINITE);
+	++m_numWaits;
+}
+
+// write how many pairs have been created and how often they were reused to the debug output.
+void CommandListPool::ReportUsage() {
+	auto stats = m_Recycler.GetStats();
+	char msg[512];
+	sprintf_s(msg, "CommandListPool: %u command allocator and list pairs for %llu acquires, %llu recycled, %llu discarded. "
+		"Up to %u in flight at once. %llu waits on the GPU.\n",
+		stats.numEntries, stats.numAcquired, stats.numRecycled, stats.numDiscarded, stats.numInFlightHighWater, m_numWaits);
+	OutputDebugStringA(msg);
+}
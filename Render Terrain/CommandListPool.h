@@ -0,0 +1,76 @@
+/*
+CommandListPool.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	A pool of command allocator and command list pairs. Each pair is handed out to one queue
+				type and recording thread, tagged with the fence value of the submission it went out in,
+				and reset for reuse once the GPU has passed that value. See CommandRecycler.h for the
+				bookkeeping.
+
+Usage:			- Proper shutdown is handled by the destructor. It waits for the GPU to finish with every pair first.
+				- Requires a pointer to a Device and the number of threads that will record command lists.
+				- Call Acquire() for a command list that is reset and ready to record. Pass the entry it returns
+					to GetList() for the list itself and to Execute() to submit it. Execute() closes the lists.
+				- Execute() returns the fence value the GPU will have reached once the lists have run. Pass it to
+					IsComplete() or WaitForFence() to find out when the GPU is done with whatever they used.
+				- Call Discard() for a list that won't be submitted.
+				- Acquire() and Execute() can be called from any thread, but an entry must only be recorded by the
+					thread it was acquired for.
+
+Future Work:	- Only the Device's direct queue exists, so only direct command lists can be executed.
+					Add a fence per queue type along with the copy and compute queues.
+				- Record passes on worker threads.
+*/
+#pragma once
+
+#include "Graphics.h"
+#include "CommandRecycler.h"
+#include <mutex>
+#include <vector>
+
+using namespace graphics;
+
+// the thread index for command lists recorded on the main thread.
+static const unsigned int COMMAND_THREAD_MAIN = 0;
+// D3D12_COMMAND_LIST_TYPE_DIRECT, BUNDLE, COMPUTE and COPY.
+static const unsigned int NUM_COMMAND_LIST_TYPES = 4;
+
+class CommandListPool {
+public:
+	CommandListPool(Device* dev, unsigned int numThreads);
+	~CommandListPool();
+
+	// Returns the entry of a command list of type, reset and ready to be recorded on thread.
+	unsigned int Acquire(D3D12_COMMAND_LIST_TYPE type, unsigned int thread);
+	// Returns the command list of entry.
+	ID3D12GraphicsCommandList* GetList(unsigned int entry);
+	// Close the command lists of num entries and execute them in order. Returns the fence value that marks them done.
+	unsigned long long Execute(const unsigned int* entries, unsigned int num);
+	// Close the command list of entry and give it back without executing it.
+	void Discard(unsigned int entry);
+
+	// Returns true if the GPU has finished everything submitted with a fence value of val or less.
+	bool IsComplete(unsigned long long val);
+	// Block until the GPU has finished everything submitted with a fence value of val or less.
+	void WaitForFence(unsigned long long val);
+	// Block until the GPU has finished everything submitted so far.
+	void WaitForIdle() { WaitForFence(m_valFence); }
+
+	// write how many pairs have been created and how often they were reused to the debug output.
+	void ReportUsage();
+
+private:
+	Device*									m_pDev;
+	CommandRecycler							m_Recycler;
+	ID3D12Fence*							m_pFence;
+	HANDLE									m_hdlFenceEvent;
+	std::vector<ID3D12CommandAllocator*>	m_listAllocators;		// indexed by the recycler's entries.
+	std::vector<ID3D12GraphicsCommandList*>	m_listCmdLists;
+	std::mutex								m_mutexLists;			// guards growing the lists above.
+	std::mutex								m_mutexSubmit;			// keeps the fence values in submission order.
+	std::mutex								m_mutexWait;			// guards the fence event.
+	unsigned long long						m_valFence;				// the last value signalled.
+	unsigned long long						m_numWaits;				// calls to WaitForFence() that had to block.
+};
@@ -0,0 +1,133 @@
+/*
+CommandRecycler.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Keeps track of which command allocator and command list pairs are free, being recorded,
+				or waiting on the GPU, and hands the free ones back out.
+*/
+#include "CommandRecycler.h"
+
+CommandRecycler::CommandRecycler(unsigned int numTypes, unsigned int numThreads) : m_numTypes(numTypes), m_numThreads(numThreads) {
+	m_stats = {};
+	m_listFree.resize(m_numTypes * m_numThreads);
+	m_listInFlight.resize(m_numTypes * m_numThreads);
+}
+
+// Returns a free entry of type for thread, recycling any whose fence value valCompleted has reached.
+// isNew is true if the entry was just created. Returns COMMAND_NO_ENTRY if type or thread is out of range.
+unsigned int CommandRecycler::Acquire(unsigned int type, unsigned int thread, unsigned long long valCompleted, bool& isNew) {
+	isNew = false;
+	if (type >= m_numTypes || thread >= m_numThreads) return COMMAND_NO_ENTRY;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	unsigned int b = type * m_numThreads + thread;
+	RecycleBucket(b, valCompleted);
+
+	unsigned int entry;
+	if (!m_listFree[b].empty()) {
+		// the most recently freed entry is the most likely to still be in the cache.
+		entry = m_listFree[b].back();
+		m_listFree[b].pop_back();
+		++m_stats.numRecycled;
+	} else {
+		entry = (unsigned int)m_listEntries.size();
+		Entry e = { type, thread, COMMAND_ENTRY_FREE, 0 };
+		m_listEntries.push_back(e);
+		m_stats.numEntries = (unsigned int)m_listEntries.size();
+		isNew = true;
+	}
+
+	m_listEntries[entry].state = COMMAND_ENTRY_RECORDING;
+	++m_stats.numAcquired;
+	return entry;
+}
+
+// Mark a recording entry as waiting on the GPU until the fence reaches valFence. Returns false if it wasn't recording.
+bool CommandRecycler::Submit(unsigned int entry, unsigned long long valFence) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (entry >= m_listEntries.size() || m_listEntries[entry].state != COMMAND_ENTRY_RECORDING) return false;
+
+	Entry& e = m_listEntries[entry];
+	e.state = COMMAND_ENTRY_IN_FLIGHT;
+	e.valFence = valFence;
+	m_listInFlight[e.type * m_numThreads + e.thread].push_back(entry);
+
+	++m_stats.numSubmitted;
+	++m_stats.numInFlight;
+	if (m_stats.numInFlight > m_stats.numInFlightHighWater) m_stats.numInFlightHighWater = m_stats.numInFlight;
+	return true;
+}
+
+// Return a recording entry that won't be submitted. Returns false if it wasn't recording.
+bool CommandRecycler::Discard(unsigned int entry) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (entry >= m_listEntries.size() || m_listEntries[entry].state != COMMAND_ENTRY_RECORDING) return false;
+
+	Entry& e = m_listEntries[entry];
+	e.state = COMMAND_ENTRY_FREE;
+	m_listFree[e.type * m_numThreads + e.thread].push_back(entry);
+	++m_stats.numDiscarded;
+	return true;
+}
+
+// Move the in flight entries of type whose fence value valCompleted has reached to the free lists. Returns the number moved.
+unsigned int CommandRecycler::Recycle(unsigned int type, unsigned long long valCompleted) {
+	if (type >= m_numTypes) return 0;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	unsigned int num = 0;
+	for (unsigned int t = 0; t < m_numThreads; ++t) {
+		num += RecycleBucket(type * m_numThreads + t, valCompleted);
+	}
+
+	return num;
+}
+
+// Move the in flight entries of bucket b whose fence value valCompleted has reached to its free list. m_mutex must be held.
+// Entries are submitted in fence order, so the first one still waiting means the rest are too.
+unsigned int CommandRecycler::RecycleBucket(unsigned int b, unsigned long long valCompleted) {
+	unsigned int num = 0;
+	while (!m_listInFlight[b].empty() && m_listEntries[m_listInFlight[b].front()].valFence <= valCompleted) {
+		unsigned int entry = m_listInFlight[b].front();
+		m_listInFlight[b].pop_front();
+		m_listEntries[entry].state = COMMAND_ENTRY_FREE;
+		m_listFree[b].push_back(entry);
+		--m_stats.numInFlight;
+		++num;
+	}
+
+	return num;
+}
+
+unsigned int CommandRecycler::GetNumEntries() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (unsigned int)m_listEntries.size();
+}
+
+CommandEntryState CommandRecycler::GetState(unsigned int entry) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_listEntries[entry].state;
+}
+
+unsigned int CommandRecycler::GetType(unsigned int entry) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_listEntries[entry].type;
+}
+
+unsigned int CommandRecycler::GetThread(unsigned int entry) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_listEntries[entry].thread;
+}
+
+// Returns the fence value entry was last submitted with.
+unsigned long long CommandRecycler::GetFenceValue(unsigned int entry) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_listEntries[entry].valFence;
+}
+
+CommandRecyclerStats CommandRecycler::GetStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
@@ -0,0 +1,85 @@
+/*
+CommandRecycler.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Keeps track of which command allocator and command list pairs are free, being recorded,
+				or waiting on the GPU, and hands the free ones back out. Plain C++ so it can be used and
+				checked with a made up fence value instead of a Direct3D 12 device. See CommandListPool.h
+				for the Direct3D 12 side.
+
+Usage:			- Create a CommandRecycler with the number of queue types and recording threads it serves.
+					Each type and thread pair has its own free and in flight lists.
+				- Call Acquire() with the fence value the queue of that type has completed. It recycles every
+					in flight entry the fence has passed and returns a free entry, or a new one when there are none.
+					isNew says whether the caller needs to create the allocator and list for it.
+				- Call Submit() with the fence value the queue will signal once the entry's commands have run.
+					Entries of one type and thread must be submitted in fence order.
+				- Call Discard() to give back an entry that was never submitted.
+				- Safe to call from several threads at once.
+
+Future Work:	- Let go of entries that haven't been needed for a while.
+*/
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// returned by Acquire() when the type or thread is out of range.
+static const unsigned int COMMAND_NO_ENTRY = 0xffffffff;
+
+enum CommandEntryState { COMMAND_ENTRY_FREE = 0, COMMAND_ENTRY_RECORDING, COMMAND_ENTRY_IN_FLIGHT };
+
+struct CommandRecyclerStats {
+	unsigned long long	numAcquired;
+	unsigned long long	numRecycled;		// acquires served by an entry the GPU was done with.
+	unsigned long long	numSubmitted;
+	unsigned long long	numDiscarded;
+	unsigned int		numEntries;			// entries ever created. Each is an allocator and a list.
+	unsigned int		numInFlight;
+	unsigned int		numInFlightHighWater;
+};
+
+class CommandRecycler {
+public:
+	CommandRecycler(unsigned int numTypes, unsigned int numThreads);
+
+	// Returns a free entry of type for thread, recycling any whose fence value valCompleted has reached.
+	// isNew is true if the entry was just created. Returns COMMAND_NO_ENTRY if type or thread is out of range.
+	unsigned int Acquire(unsigned int type, unsigned int thread, unsigned long long valCompleted, bool& isNew);
+	// Mark a recording entry as waiting on the GPU until the fence reaches valFence. Returns false if it wasn't recording.
+	bool Submit(unsigned int entry, unsigned long long valFence);
+	// Return a recording entry that won't be submitted. Returns false if it wasn't recording.
+	bool Discard(unsigned int entry);
+	// Move the in flight entries of type whose fence value valCompleted has reached to the free lists. Returns the number moved.
+	unsigned int Recycle(unsigned int type, unsigned long long valCompleted);
+
+	unsigned int GetNumEntries();
+	CommandEntryState GetState(unsigned int entry);
+	unsigned int GetType(unsigned int entry);
+	unsigned int GetThread(unsigned int entry);
+	// Returns the fence value entry was last submitted with.
+	unsigned long long GetFenceValue(unsigned int entry);
+	CommandRecyclerStats GetStats();
+
+private:
+	struct Entry {
+		unsigned int		type;
+		unsigned int		thread;
+		CommandEntryState	state;
+		unsigned long long	valFence;
+	};
+
+	// Move the in flight entries of bucket b whose fence value valCompleted has reached to its free list. m_mutex must be held.
+	unsigned int RecycleBucket(unsigned int b, unsigned long long valCompleted);
+
+	std::vector<Entry>						m_listEntries;
+	std::vector<std::vector<unsigned int>>	m_listFree;			// one per type and thread, indexed type * m_numThreads + thread.
+	std::vector<std::deque<unsigned int>>	m_listInFlight;		// same, in the order they were submitted.
+	std::mutex								m_mutex;
+	CommandRecyclerStats					m_stats;
+	unsigned int							m_numTypes;
+	unsigned int							m_numThreads;
+};
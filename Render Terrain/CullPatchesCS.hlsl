@@ -0,0 +1,144 @@
+// must match MAX_CULL_VIEWS and CULL_GROUP_SIZE in PatchCuller.h.
+#define MAX_CULL_VIEWS 5
+#define NUM_CULL_PLANES 6
+#define CULL_GROUP_SIZE 64
+// size in bytes of D3D12_DRAW_INDEXED_ARGUMENTS.
+#define DRAW_ARGS_STRIDE 20
+// the statistics follow the draw arguments of every list.
+#define STATS_OFFSET ((MAX_CULL_VIEWS + 1) * DRAW_ARGS_STRIDE)
+
+cbuffer CullConstants : register(b0)
+{
+	uint numPatches;
+	uint numViews;
+	uint firstUnionView;	// patches visible to any view from here on are also appended to the union list.
+	uint maxIndicesPerList;
+}
+
+cbuffer CullViews : register(b1)
+{
+	float4 planes[MAX_CULL_VIEWS * NUM_CULL_PLANES];
+	float4x4 occlusionviewproj;		// view projection the Hi-Z pyramid's depth buffer was rendered with.
+	float4 hizsize;					// x, y = size of mip 0, z = number of mips, w = 1 to occlusion cull the first view.
+}
+
+struct PatchCullData
+{
+	float3 aabbmin;
+	float3 aabbmax;
+	uint4 indices;
+};
+
+StructuredBuffer<PatchCullData> patches : register(t0);
+Texture2D<float> hiz : register(t1);
+RWByteAddressBuffer args : register(u0);	// one D3D12_DRAW_INDEXED_ARGUMENTS per view, plus the union list at MAX_CULL_VIEWS.
+RWByteAddressBuffer lists : register(u1);	// maxIndicesPerList indices per list.
+
+groupshared uint numInFrustum;
+groupshared uint numOccluded;
+
+// returns true if the box is completely behind one of the view's planes. Same test as the hull shaders.
+bool aabbOutsideView(float3 center, float3 extents, uint view) {
+	[unroll]
+	for (uint i = 0; i < NUM_CULL_PLANES; ++i) {
+		float4 plane = planes[view * NUM_CULL_PLANES + i];
+		float e = dot(extents, abs(plane.xyz));
+		float s = dot(float4(center, 1.0f), plane);
+		if (s + e < 0.0f) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// returns true if the box is completely behind the depth stored in the Hi-Z pyramid. Matches SoftwareHiZ::IsBoxOccluded().
+bool aabbOccluded(float3 bmin, float3 bmax) {
+	float3 ndcMin = float3(1.0f, 1.0f, 1.0f);
+	float3 ndcMax = float3(-1.0f, -1.0f, -1.0f);
+	[unroll]
+	for (uint i = 0; i < 8; ++i) {
+		float3 corner = float3(i & 1 ? bmax.x : bmin.x, i & 2 ? bmax.y : bmin.y, i & 4 ? bmax.z : bmin.z);
+		float4 p = mul(float4(corner, 1.0f), occlusionviewproj);
+		// part of the box is behind the camera, so it can't be behind anything else.
+		if (p.w <= 0.0f) return false;
+
+		ndcMin = min(ndcMin, p.xyz / p.w);
+		ndcMax = max(ndcMax, p.xyz / p.w);
+	}
+
+	// the rectangle the box covers in texture space. NDC y points up and texture v down.
+	float2 uvMin = saturate(float2(ndcMin.x, -ndcMax.y) * 0.5f + 0.5f);
+	float2 uvMax = saturate(float2(ndcMax.x, -ndcMin.y) * 0.5f + 0.5f);
+
+	// pick the mip where the rectangle is at most a texel across, so it touches no more than 2x2 texels.
+	float2 size = (uvMax - uvMin) * hizsize.xy;
+	uint mip = (uint)min(ceil(log2(max(max(size.x, size.y), 1.0f))), hizsize.z - 1.0f);
+	uint2 mipSize = max((uint2)hizsize.xy >> mip, 1);
+
+	uint2 first = min((uint2)(uvMin * mipSize), mipSize - 1);
+	uint2 last = min((uint2)(uvMax * mipSize), mipSize - 1);
+
+	float depth = 0.0f;
+	for (uint y = first.y; y <= last.y; ++y) {
+		for (uint x = first.x; x <= last.x; ++x) {
+			depth = max(depth, hiz.Load(int3(x, y, mip)));
+		}
+	}
+
+	return ndcMin.z > depth;
+}
+
+// reserve room for one patch at the end of list and write its control point indices there.
+void appendPatch(uint list, uint4 indices) {
+	uint count;
+	// IndexCountPerInstance is the first member of the draw arguments.
+	args.InterlockedAdd(list * DRAW_ARGS_STRIDE, 4, count);
+	lists.Store4((list * maxIndicesPerList + count) * 4, indices);
+}
+
+[numthreads(CULL_GROUP_SIZE, 1, 1)]
+void main(uint3 DTid : SV_DispatchThreadID, uint GI : SV_GroupIndex)
+{
+	if (GI == 0) {
+		numInFrustum = 0;
+		numOccluded = 0;
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	// threads past the end still have to reach the barrier below.
+	if (DTid.x < numPatches) {
+		PatchCullData patch = patches[DTid.x];
+		float3 center = (patch.aabbmin + patch.aabbmax) * 0.5f;
+		float3 extents = (patch.aabbmax - patch.aabbmin) * 0.5f;
+
+		bool isInUnion = false;
+		for (uint view = 0; view < numViews; ++view) {
+			if (aabbOutsideView(center, extents, view)) continue;
+
+			// only the first view has a depth buffer to be occluded by.
+			if (view == 0) {
+				uint ignored;
+				InterlockedAdd(numInFrustum, 1, ignored);
+				if (hizsize.w != 0.0f && aabbOccluded(patch.aabbmin, patch.aabbmax)) {
+					InterlockedAdd(numOccluded, 1, ignored);
+					continue;
+				}
+			}
+
+			appendPatch(view, patch.indices);
+			isInUnion = isInUnion || view >= firstUnionView;
+		}
+
+		if (isInUnion) {
+			appendPatch(MAX_CULL_VIEWS, patch.indices);
+		}
+	}
+	GroupMemoryBarrierWithGroupSync();
+
+	// one global atomic per group rather than per patch.
+	if (GI == 0) {
+		args.InterlockedAdd(STATS_OFFSET, numInFrustum);
+		args.InterlockedAdd(STATS_OFFSET + 4, numOccluded);
+	}
+}
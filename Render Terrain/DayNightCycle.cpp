@@ -18,223 +18,110 @@ XMFLOAT4 ColorLerp(XMFLOAT4 color1, XMFLOAT4 color2, float interpolator) {
 	return newcolor;
 }
 
-DayNightCycle::DayNightCycle(UINT period, UINT shadowSize) : m_dlSun(XMFLOAT4(0.3f, 0.3f, 0.3f, 1.0f), SUN_DIFFUSE_COLORS[0], SUN_SPECULAR_COLORS[0], XMFLOAT3(0.0f, 0.0f, 1.0f)),
+DayNightCycle::DayNightCycle(unsigned int period, unsigned int shadowSize, unsigned int numCascades, float lambda) : m_Period(period),
+								m_dlSun(XMFLOAT4(0.3f, 0.3f, 0.3f, 1.0f), SUN_DIFFUSE_COLORS[0], SUN_SPECULAR_COLORS[0], XMFLOAT3(0.0f, 0.0f, 1.0f)),
 								m_dlMoon(XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f), XMFLOAT4(0.4f, 0.4f, 0.4f, 1.0f), XMFLOAT4(0.6f, 0.6f, 0.6f, 1.0f), XMFLOAT3(0.0f, 0.0f, -1.0f)),
-								m_Period(period), m_sizeShadowMap(shadowSize) {
-	m_tLast = system_clock::now();
+								m_sizeShadowMap(shadowSize), m_lambdaSplit(lambda) {
+	// the shaders can't handle more than MAX_SHADOW_CASCADES, and we always need at least the one covering the whole scene.
+	m_numCascades = numCascades < 1 ? 1 : (numCascades > MAX_SHADOW_CASCADES ? MAX_SHADOW_CASCADES : numCascades);
+	for (unsigned int i = 0; i <= MAX_SHADOW_CASCADES; ++i) {
+		m_aSplits[i] = CASCADE_NEAR_PLANE;
+	}
+	for (unsigned int i = 0; i < MAX_SHADOW_CASCADES; ++i) {
+		m_aTexelDensity[i] = 0.0f;
+		m_aTexelDensitySphere[i] = 0.0f;
+	}
 }
 
 DayNightCycle::~DayNightCycle() {
 }
 
-void DayNightCycle::Update(BoundingSphere& bsScene, Camera* cam) {
-	time_point<system_clock> now = system_clock::now();
+void DayNightCycle::Update(AxisAlignedBoundingBox& bbScene, Camera* cam) {
+	// the clock moves on even while paused, so a curve picks up where the clock is once unpaused.
+	SimClock* clock = m_pClock ? m_pClock : &m_clockDefault;
+	double elapsed = clock->Tick();
 
 	if (!m_isPaused) {
-		// get the amount of time in ms since the last time we updated.
-		milliseconds elapsed = duration_cast<milliseconds>(now - m_tLast);
-
-		// calculate how far to rotate.
-		double angletorotate = elapsed.count() * m_Period * DEG_PER_MILLI;
-		float angleinrads = XMConvertToRadians((float)angletorotate);
-
-		// rotate the sun's direction vector.
-		XMFLOAT3 tmp = m_dlSun.GetLight().direction;
-		XMVECTOR dir = XMLoadFloat3(&tmp);
-		XMVECTOR rot = XMQuaternionRotationRollPitchYaw(0.0f, -(float)angleinrads, 0.0f);
-		dir = XMVector3Normalize(XMVector3Rotate(dir, rot));
-		XMStoreFloat3(&tmp, dir);
-		m_dlSun.SetLightDirection(tmp);
-
-		// use the angletorotate to calculate what the current colour of the Sun should be.
-		float newangle = fmod(m_angleSun + (float)angletorotate, 360.0f);
-		int iColor1, iColor2; // color indices to get colors to interpolate between
-		float iInterpolator; // amount to interpolate by
-		if (newangle >= 330.0f) {
-			iColor1 = 11;
-			iColor2 = 0;
-			iInterpolator = (newangle - 330.0f) / 30.0f;
-		} else if (newangle >= 300.0f) {
-			iColor1 = 10;
-			iColor2 = 11;
-			iInterpolator = (newangle - 300.0f) / 30.0f;
-		} else if (newangle >= 270.0f) {
-			iColor1 = 9;
-			iColor2 = 10;
-			iInterpolator = (newangle - 270.0f) / 30.0f;
-		} else if (newangle >= 240.0f) {
-			iColor1 = 8;
-			iColor2 = 9;
-			iInterpolator = (newangle - 240.0f) / 30.0f;
-		} else if (newangle >= 210.0f) {
-			iColor1 = 7;
-			iColor2 = 8;
-			iInterpolator = (newangle - 210.0f) / 30.0f;
-		} else if (newangle >= 180.0f) {
-			iColor1 = 6;
-			iColor2 = 7;
-			iInterpolator = (newangle - 180.0f) / 30.0f;
-		} else if (newangle >= 150.0f) {
-			iColor1 = 5;
-			iColor2 = 6;
-			iInterpolator = (newangle - 150.0f) / 30.0f;
-		} else if (newangle >= 120.0f) {
-			iColor1 = 4;
-			iColor2 = 5;
-			iInterpolator = (newangle - 120.0f) / 30.0f;
-		} else if (newangle >= 90.0f) {
-			iColor1 = 3;
-			iColor2 = 4;
-			iInterpolator = (newangle - 90.0f) / 30.0f;
-		} else if (newangle >= 60.0f) {
-			iColor1 = 2;
-			iColor2 = 3;
-			iInterpolator = (newangle - 60.0f) / 30.0f;
-		} else if (newangle >= 30.0f) {
-			iColor1 = 1;
-			iColor2 = 2;
-			iInterpolator = (newangle - 30.0f) / 30.0f;
-		} else if (newangle >= 0.0f) {
-			iColor1 = 0;
-			iColor2 = 1;
-			iInterpolator = newangle / 30.0f;
+		if (m_pCurve && m_pCurve->GetNumKeys() > 0) {
+			SetSunAngle(m_pCurve->Evaluate(clock->GetTime()));
+		} else {
+			// calculate how far to rotate.
+			double angletorotate = elapsed * m_Period * DEG_PER_MILLI;
+			SetSunAngle((float)fmod((double)m_angleSun + angletorotate, 360.0));
 		}
-		
-		m_dlSun.SetDiffuseColor(ColorLerp(SUN_DIFFUSE_COLORS[iColor1], SUN_DIFFUSE_COLORS[iColor2], iInterpolator));
-		m_dlSun.SetSpecularColor(ColorLerp(SUN_SPECULAR_COLORS[iColor1], SUN_SPECULAR_COLORS[iColor2], iInterpolator));
-
-		m_angleSun = newangle;
 	}
 
-	// update the time for the next pass.
-	m_tLast = now;
+	CalculateShadowMatrices(bbScene, cam);
+}
 
-	CalculateShadowMatrices(bsScene, cam);
+// Point the sun at angle degrees around the sky and set its colours to match.
+// The direction is rotated from midnight in one go rather than a little more every update, so it never drifts.
+void DayNightCycle::SetSunAngle(float angle) {
+	// rotate the sun's midnight direction vector.
+	XMVECTOR dir = XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f);
+	XMVECTOR rot = XMQuaternionRotationRollPitchYaw(0.0f, -XMConvertToRadians(angle), 0.0f);
+	dir = XMVector3Normalize(XMVector3Rotate(dir, rot));
+	XMFLOAT3 tmp;
+	XMStoreFloat3(&tmp, dir);
+	m_dlSun.SetLightDirection(tmp);
+
+	// the colours are given every 30 degrees. Interpolate between the two either side of angle.
+	int iColor1 = (int)(angle / 30.0f);
+	iColor1 = iColor1 < 0 ? 0 : (iColor1 > 11 ? 11 : iColor1);
+	int iColor2 = (iColor1 + 1) % 12;
+	float iInterpolator = (angle - 30.0f * iColor1) / 30.0f;
+
+	m_dlSun.SetDiffuseColor(ColorLerp(SUN_DIFFUSE_COLORS[iColor1], SUN_DIFFUSE_COLORS[iColor2], iInterpolator));
+	m_dlSun.SetSpecularColor(ColorLerp(SUN_SPECULAR_COLORS[iColor1], SUN_SPECULAR_COLORS[iColor2], iInterpolator));
+
+	m_angleSun = angle;
 }
 
-void DayNightCycle::CalculateShadowMatrices(BoundingSphere& bsScene, Camera* cam) {
+void DayNightCycle::CalculateShadowMatrices(AxisAlignedBoundingBox& bbScene, Camera* cam) {
 	LightSource light = m_dlSun.GetLight();
 	XMVECTOR lightdir = XMLoadFloat3(&light.direction);
-	XMFLOAT3 vCenterScene = bsScene.GetCenter();
-	XMVECTOR targetpos = XMLoadFloat3(&vCenterScene);
-	
-	float offset = (float)(m_sizeShadowMap + 8) / (float)m_sizeShadowMap; // add padding to projection for rounding and for pcf.
-	float radiusScene = ceilf(bsScene.GetRadius()) * offset;
-
-	XMVECTOR lightpos = targetpos - 2.0f * radiusScene * lightdir;
-	XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
-	up = XMVector3Cross(up, lightdir);
+	float radiusScene = ceilf(bbScene.GetRadius());
 
-	XMMATRIX V = XMMatrixLookAtLH(lightpos, targetpos, up); // light space view matrix transform bounding sphere to light space
-	XMFLOAT4 spherecenterls;
+	XMMATRIX V = CalcLightView(bbScene, lightdir); // light space view matrix
 
-	// create the cascades.
-	for (int i = 0; i < 3; ++i) {
-		Frustum fCascade = cam->CalculateFrustumByNearFar(CASCADE_PLANES[i], CASCADE_PLANES[i + 1]);
-		float radius = ceilf(fCascade.bs.GetRadius());
-		radius *= offset;
-		XMVECTOR c = XMLoadFloat3(&fCascade.bs.GetCenter());
-		XMStoreFloat4(&spherecenterls, XMVector3TransformCoord(c, V));
-		XMVECTOR sc = XMLoadFloat3(&vCenterScene);
-		XMFLOAT4 cbs;
-		XMStoreFloat4(&cbs, XMVector3TransformCoord(sc, V));
+	// split the near part of the view frustum between every cascade but the last.
+	// The last cascade always covers the whole scene, so distant terrain is never left unshadowed.
+	unsigned int numSplitCascades = m_numCascades - 1;
+	if (numSplitCascades > 0) {
+		CalcCascadeSplits(CASCADE_NEAR_PLANE, CASCADE_FAR_PLANE, numSplitCascades, m_lambdaSplit, m_aSplits);
+	}
 
-		// orthographic frustum
-		float l = spherecenterls.x - radius;
-		float b = spherecenterls.y - radius;
-		float n = spherecenterls.z - cbs.z - radiusScene;
-		float r = spherecenterls.x + radius;
-		float t = spherecenterls.y + radius;
-		float f = spherecenterls.z + cbs.z + radiusScene;
-		
-		XMMATRIX P = XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f);
+	for (unsigned int i = 0; i < m_numCascades; ++i) {
+		CascadeBox box;
+		float radius;
+		if (i < numSplitCascades) {
+			// fit tightly around the part of the slice the terrain can actually occupy, rather than a sphere around the whole slice.
+			Frustum fCascade = cam->CalculateFrustumByNearFar(m_aSplits[i], m_aSplits[i + 1]);
+			XMFLOAT3 corners[8] = { fCascade.nlb, fCascade.nrb, fCascade.nlt, fCascade.nrt, fCascade.flb, fCascade.frb, fCascade.flt, fCascade.frt };
+			if (m_pSceneBlocks) {
+				box = FitCascadeToBlocks(corners, m_pSceneBlocks, m_numSceneBlocks, bbScene, V, m_sizeShadowMap);
+			} else {
+				box = FitCascadeToSlice(corners, bbScene, V, m_sizeShadowMap);
+			}
+			radius = fCascade.bs.GetRadius();
+		} else {
+			box = FitCascadeToBox(bbScene, V, m_sizeShadowMap);
+			radius = radiusScene;
+		}
 
-		XMMATRIX S = V * P;
+		// keep track of how well the fit is doing compared to a padded bounding sphere.
+		m_aTexelDensity[i] = CalcTexelDensity(box, m_sizeShadowMap);
+		m_aTexelDensitySphere[i] = CalcSphereTexelDensity(radius, m_sizeShadowMap);
 
-		// add rounding to update shadowmap by texel-sized increments.
-		XMVECTOR shadowOrigin = XMVector3Transform(XMVectorZero(), S);
-		shadowOrigin *= ((float)(m_sizeShadowMap + offset) / 4.0f);
-		XMFLOAT2 so;
-		XMStoreFloat2(&so, shadowOrigin);
-		XMVECTOR roundedOrigin = XMLoadFloat2(&XMFLOAT2(round(so.x), round(so.y)));
-		XMVECTOR rounding = roundedOrigin - shadowOrigin;
-		rounding /= ((m_sizeShadowMap + offset) / 4.0f);
-		XMStoreFloat2(&so, rounding);
-		XMMATRIX roundMatrix = XMMatrixTranslation(so.x, so.y, 0.0f);
-		S *= roundMatrix;
+		// the box is already snapped to the cascade's texel grid, so the shadow map moves in texel sized increments.
+		XMMATRIX S = V * CalcCascadeProjection(box);
 
 		// Calculate the frustum planes for this view projection matrix.
 		CalculateShadowFrustum(i, S);
-		
-		XMStoreFloat4x4(&m_amShadowViewProjs[i], XMMatrixTranspose(S));
-
-		// transform NDC space [-1, +1]^2 to texture space [0, 1]^2
-		float x, y;
-		if (i == 0) {
-			x = 0.25f;
-			y = 0.25f;
-		} else if (i == 1) {
-			x = 0.25f;
-			y = 0.75f;
-		} else if (i == 2) {
-			x = 0.75f;
-			y = 0.25f;
-		} else {
-			x = 0.75f;
-			y = 0.75f;
-		}
-				
-		XMMATRIX T(0.25f, 0.0f, 0.0f, 0.0f,
-			0.0f, -0.25f, 0.0f, 0.0f,
-			0.0f, 0.0f, 1.0f, 0.0f,
-			x, y, 0.0f, 1.0f);
 
-		S *= T;
-
-		XMStoreFloat4x4(&m_amShadowViewProjTexs[i], XMMatrixTranspose(S));
+		// the shadow atlas works out where in the atlas the cascade lives and builds the matching texture matrix.
+		XMStoreFloat4x4(&m_amShadowViewProjs[i], XMMatrixTranspose(S));
 	}
-
-	XMVECTOR c = XMLoadFloat3(&vCenterScene);
-	XMStoreFloat4(&spherecenterls, XMVector3TransformCoord(c, V));
-
-	// orthographic frustum
-	float l = spherecenterls.x - radiusScene;
-	float b = spherecenterls.y - radiusScene;
-	float n = spherecenterls.z - radiusScene;
-	float r = spherecenterls.x + radiusScene;
-	float t = spherecenterls.y + radiusScene;
-	float f = spherecenterls.z + radiusScene;
-
-	XMMATRIX P = XMMatrixOrthographicOffCenterLH(l, r, b, t, n, f);
-
-	XMMATRIX S = V * P;
-
-	// add rounding to update shadowmap by texel-sized increments.
-	XMVECTOR shadowOrigin = XMVector3Transform(XMVectorZero(), S);
-	shadowOrigin *= ((float)(m_sizeShadowMap + offset) / 4.0f);
-	XMFLOAT2 so;
-	XMStoreFloat2(&so, shadowOrigin);
-	XMVECTOR roundedOrigin = XMLoadFloat2(&XMFLOAT2(round(so.x), round(so.y)));
-	XMVECTOR rounding = roundedOrigin - shadowOrigin;
-	rounding /= ((m_sizeShadowMap + offset) / 4.0f);
-	XMStoreFloat2(&so, rounding);
-	XMMATRIX roundMatrix = XMMatrixTranslation(so.x, so.y, 0.0f);
-	S *= roundMatrix;
-
-	// Calculate the frustum planes for this view projection matrix.
-	CalculateShadowFrustum(3, S);
-
-	XMStoreFloat4x4(&m_amShadowViewProjs[3], XMMatrixTranspose(S));
-
-	// transform NDC space [-1, +1]^2 to texture space [0, 1]^2
-	XMMATRIX T(0.25f, 0.0f, 0.0f, 0.0f,
-		0.0f, -0.25f, 0.0f, 0.0f,
-		0.0f, 0.0f, 1.0f, 0.0f,
-		0.75f, 0.75f, 0.0f, 1.0f);
-
-	S *= T;
-
-	XMStoreFloat4x4(&m_amShadowViewProjTexs[3], XMMatrixTranspose(S));
 }
 
 void DayNightCycle::CalculateShadowFrustum(int i, XMMATRIX VP) {
@@ -10,10 +10,20 @@ Usage:			- Calling the constructor, either through DayNightCycle D(...);
 				or DayNightCycle* D; D = new DayNightCycle(...);, will initialize
 				the object.
 				- Proper shutdown is handled by the destructor.
-				- Call Update() to move time forward. Moves forward by real time passed * m_Period.
+				- Call Update() to move time forward. Moves forward by the time the clock says passed * m_Period.
+					The clock is real time unless SetClock() provides another, ie a FixedStepClock for runs that repeat exactly.
+				- SetTimeOfDayCurve() makes the sun follow a fixed curve over the clock's time instead.
+				- The sun's direction and colours are worked out from its angle alone, so the same times always give the same sun.
 				- Currently only works for Sun, aligned with y axis.
 				- Time currently starts at midnight
 				- Diffuse and Specular light intensities for the Sun now interpolated based on angle/position of Sun.
+				- Calculates the view projection matrices for numCascades shadow cascades. All but the last are
+					split between CASCADE_NEAR_PLANE and CASCADE_FAR_PLANE as per the split lambda, and the last
+					covers the whole scene. See ShadowCascades.h for the math.
+				- Call SetSceneBlocks() to fit the split cascades to the height bounds of the blocks of the
+					scene in view instead of the height range of the whole scene.
+				- GetCascadeTexelDensity() returns the shadow texels per world unit each cascade achieved,
+					and GetCascadeSphereTexelDensity() what a bounding sphere fit would have achieved.
 
 Future Work:	- Add support for both Sun and Moon at arbitrary locations.
 				- Add support for animated sky box depicting time of day.
@@ -22,6 +32,8 @@ Future Work:	- Add support for both Sun and Moon at arbitrary locations.
 
 #include "DirectionalLight.h"
 #include "Camera.h"
+#include "ShadowCascades.h"
+#include "SimClock.h"
 #include <chrono>
 
 using namespace std::chrono;
@@ -55,34 +67,65 @@ static const XMFLOAT4 SUN_SPECULAR_COLORS[] = {
 	{ 0.0f, 0.0f, 0.0f, 1.0f },
 	{ 0.0f, 0.0f, 0.0f, 1.0f }
 };
-static const float CASCADE_PLANES[] = { 0.1f, 64.0f, 128.0f, 256.0f, 1200.0f };
+static const float CASCADE_SPLIT_LAMBDA = 0.5f;		// default blend between uniform (0) and logarithmic (1) splits.
 
 class DayNightCycle {
 public:
-	DayNightCycle(UINT period, UINT shadowSize);
+	// shadowSize is the size in texels of a single shadow cascade.
+	// numCascades is clamped to [1, MAX_SHADOW_CASCADES]. lambda sets how the view frustum is split between them.
+	DayNightCycle(unsigned int period, unsigned int shadowSize, unsigned int numCascades = MAX_SHADOW_CASCADES, float lambda = CASCADE_SPLIT_LAMBDA);
 	~DayNightCycle();
 
-	void Update(BoundingSphere& bsScene, Camera* cam);
+	// bbScene bounds everything that casts or receives shadows. Cascades are fitted to its height range.
+	void Update(AxisAlignedBoundingBox& bbScene, Camera* cam);
 	void TogglePause() { m_isPaused = !m_isPaused; }
+	// Use clock to move time forward instead of real time. The clock must outlive this object and every copy of it.
+	// nullptr goes back to real time.
+	void SetClock(SimClock* clock) { m_pClock = clock; }
+	// Put the sun where curve says for the clock's time instead of moving it with the time passed. nullptr stops following it.
+	// The curve must outlive this object and every copy of it.
+	void SetTimeOfDayCurve(TimeOfDayCurve* curve) { m_pCurve = curve; }
+	// Returns the sun's angle in degrees. 0 is midnight.
+	float GetSunAngle() { return m_angleSun; }
+	// Change how the view frustum is split between the cascades. Takes effect on the next Update().
+	void SetCascadeSplitLambda(float lambda) { m_lambdaSplit = lambda; }
+	// Provide boxes bounding blocks of the scene. The array must outlive this object or be replaced with another call.
+	void SetSceneBlocks(AxisAlignedBoundingBox* blocks, unsigned int numBlocks) { m_pSceneBlocks = blocks; m_numSceneBlocks = numBlocks; }
 
 	LightSource GetLight() { return m_dlSun.GetLight(); }
 	XMFLOAT4X4 GetShadowViewProjMatrix(int i) { return m_amShadowViewProjs[i]; }
-	XMFLOAT4X4 GetShadowViewProjTexMatrix(int i) { return m_amShadowViewProjTexs[i]; }
+	unsigned int GetNumCascades() { return m_numCascades; }
+	// Returns the view distance split i is at. Only valid for i < GetNumCascades().
+	float GetCascadeSplit(int i) { return m_aSplits[i]; }
+	// Returns the shadow map texels per world unit of cascade i.
+	float GetCascadeTexelDensity(int i) { return m_aTexelDensity[i]; }
+	// Returns the shadow map texels per world unit cascade i would have if fitted to a sphere around its slice.
+	float GetCascadeSphereTexelDensity(int i) { return m_aTexelDensitySphere[i]; }
 	void GetShadowFrustum(int i, XMFLOAT4 planes[6]);
 
 private:
-	void CalculateShadowMatrices(BoundingSphere& bsScene, Camera* cam);
+	// Point the sun at angle degrees around the sky and set its colours to match.
+	void SetSunAngle(float angle);
+	void CalculateShadowMatrices(AxisAlignedBoundingBox& bbScene, Camera* cam);
 	void CalculateShadowFrustum(int i, XMMATRIX VP);
 		
-	UINT						m_Period;	// the number of game milliseconds that each real time millisecond should count as.
+	unsigned int				m_Period;	// the number of game milliseconds that each real time millisecond should count as.
 	DirectionalLight			m_dlSun;		// light source representing the sun. 
 	DirectionalLight			m_dlMoon;	// light source representing the moon.
-	time_point<system_clock>	m_tLast;		// the last point in time that we updated our cycle.
+	RealTimeClock				m_clockDefault;	// used when no clock has been set.
+	SimClock*					m_pClock = nullptr;
+	TimeOfDayCurve*				m_pCurve = nullptr;
 	float						m_angleSun = 0.0f;
 	bool						m_isPaused = false;
-	UINT						m_sizeShadowMap;
-	XMFLOAT4X4					m_amShadowViewProjs[4];
-	XMFLOAT4X4					m_amShadowViewProjTexs[4];
-	XMFLOAT4					m_aShadowFrustums[4][4];
+	unsigned int				m_sizeShadowMap;	// size in texels of a single cascade.
+	unsigned int				m_numCascades;
+	float						m_lambdaSplit;	// blend between uniform (0) and logarithmic (1) splits.
+	float						m_aSplits[MAX_SHADOW_CASCADES + 1];
+	float						m_aTexelDensity[MAX_SHADOW_CASCADES];
+	float						m_aTexelDensitySphere[MAX_SHADOW_CASCADES];
+	AxisAlignedBoundingBox*		m_pSceneBlocks = nullptr;
+	unsigned int				m_numSceneBlocks = 0;
+	XMFLOAT4X4					m_amShadowViewProjs[MAX_SHADOW_CASCADES];
+	XMFLOAT4					m_aShadowFrustums[MAX_SHADOW_CASCADES][4];
 };
 
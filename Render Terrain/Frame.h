@@ -10,6 +10,8 @@ Usage:			- Frame F(...);
 				- Frame* F; F = new Frame(...);
 				- Proper shutdown is handled by the destructor.
 				- Create a Frame object for each frame, ie 3 for triple buffering.
+				- Command lists come from the CommandListPool. Pass the fence value a frame's commands were
+					submitted with to SetFenceValue() so Reset() knows what to wait for.
 
 Future Work:	- Add support for multi-threading.
 */
@@ -17,14 +19,18 @@ Future Work:	- Add support for multi-threading.
 
 #include "ResourceManager.h"
 #include "Light.h"
+#include "ShadowCascades.h"
 
 using namespace graphics;
 
 struct PerFrameConstantBuffer {
 	XMFLOAT4X4	viewproj;
-	XMFLOAT4X4	shadowtexmatrices[4];
+	XMFLOAT4X4	shadowtexmatrices[MAX_SHADOW_CASCADES];
+	XMFLOAT4	shadowcascaderects[MAX_SHADOW_CASCADES];	// region of the atlas each cascade may be sampled from.
+	XMFLOAT4	shadowatlassize;		// x = size in texels, y = size of a texel, z = number of cascades.
 	XMFLOAT4	eye;
 	XMFLOAT4	frustum[6];
+	XMFLOAT4	tessparams;				// x = pixels per world unit at a distance of 1, y = target error in pixels, z = max tess factor.
 	LightSource light;
 	BOOL		useTextures;
 };
@@ -37,74 +43,56 @@ struct ShadowMapShaderConstants {
 
 class Frame {
 public:
-	Frame(unsigned int indexFrame, Device* dev, ResourceManager* rm, unsigned int h, unsigned int w, 
-		unsigned int dimShadowAtlas = 4096);
+	Frame(unsigned int indexFrame, Device* dev, ResourceManager* rm, CommandListPool* pool, unsigned int h, unsigned int w);
 	~Frame();
 
-	ID3D12CommandAllocator* GetAllocator() { return m_pCmdAllocator; }
+	// Returns this frame's back buffer, for the scene's render graph to move between the present and render target states.
+	ID3D12Resource* GetBackBuffer() { return m_pBackBuffer; }
 
-	// Confirm the previous GPU activity on this frame is completed and reset the command allocator for the next run.
+	// Confirm the previous GPU activity on this frame is completed.
 	void Reset();
-	// Resets a command list for use with this frame.
-	void AttachCommandList(ID3D12GraphicsCommandList* cmdList);
+	// Record the fence value of the pool the frame's commands were last submitted with.
+	void SetFenceValue(unsigned long long val) { m_valFence = val; }
 
 	// Set the Frame Constant buffer.
 	void SetFrameConstants(PerFrameConstantBuffer frameConstants);
 	// Set the Shadow Constant buffer. i refers to which shadow map you're setting the constants for.
 	void SetShadowConstants(ShadowMapShaderConstants shadowConstants, unsigned int i);
 
-	// Call at the start of rendering the shadow passes to switch the shadow atlas to write mode.
-	void BeginShadowPass(ID3D12GraphicsCommandList* cmdList);
-	// Call at the end of rendering the shadow passes to switch the shadow atlas to read mode.
-	void EndShadowPass(ID3D12GraphicsCommandList* cmdList);
-	// Sets the back buffer for rendering and makes it the render target. Clears to clearColor.
-	void BeginRenderPass(ID3D12GraphicsCommandList* cmdList, const float clearColor[4]);
-	// Sets the back buffer to present.
-	void EndRenderPass(ID3D12GraphicsCommandList* cmdList);
-	// Attach the shadow pass resources to the provided command list for shadow pass i.
-	// Requires the index into the root descriptor table to attach the shadow constant buffer to.
-	void AttachShadowPassResources(unsigned int i, ID3D12GraphicsCommandList* cmdList, 
-		unsigned int cbvDescTableIndex);
+	// Makes the back buffer and the provided depth buffer the render targets and clears them. The back buffer is cleared to clearColor.
+	// The back buffer must already be in the render target state.
+	void BeginRenderPass(ID3D12GraphicsCommandList* cmdList, const float clearColor[4], D3D12_CPU_DESCRIPTOR_HANDLE hdlDSV);
+	// Attach the shadow pass resources to the provided command list. The constants for all cascades share one bind.
+	// Requires the index of the root CBV to attach the shadow constant buffer to.
+	void AttachShadowPassResources(ID3D12GraphicsCommandList* cmdList, unsigned int cbvRootIndex);
 	// Attach the frame resources needed for the normal render pass.
-	// Requires the indices into the root descriptor table to attach the shadow srv and shadow constant buffer to.
-	void AttachFrameResources(ID3D12GraphicsCommandList* cmdList, unsigned int srvDescTableIndex, 
-		unsigned int cbvDescTableIndex);
+	// Requires the index of the root CBV to attach the frame constant buffer to.
+	void AttachFrameResources(ID3D12GraphicsCommandList* cmdList, unsigned int cbvRootIndex);
+	// Create an upload buffer large enough for maxIndices patch indices. Used to draw only the visible shadow patches.
+	void InitShadowPatchBuffer(unsigned int maxIndices);
+	// Returns the mapped memory of the shadow patch index buffer for the CPU to write this frame's patch list to.
+	UINT* GetShadowPatchIndices() { return m_pShadowPatchIndicesMapped; }
+	// Returns a view of the shadow patch index buffer.
+	D3D12_INDEX_BUFFER_VIEW* GetShadowPatchIndexView() { return &m_viewShadowPatchIndices; }
 	
 private:
-	void InitShadowAtlas();
 	void InitConstantBuffers();
 
-	// Wait for GPU to signal it has completed with the previous iteration of this frame.
-	void WaitForGPU();
-
 	Device*						m_pDev;
 	ResourceManager*			m_pResMgr;
-	ID3D12CommandAllocator*		m_pCmdAllocator;
+	CommandListPool*			m_pCmdPool;
 	ID3D12Resource*				m_pBackBuffer;
-	ID3D12Resource*				m_pDepthStencilBuffer;
-	ID3D12Resource*				m_pShadowAtlas;
 	ID3D12Resource*				m_pFrameConstants;
-	ID3D12Resource*				m_pShadowConstants[4];
-	ID3D12Fence*				m_pFence;
-	HANDLE						m_hdlFenceEvent;
+	ID3D12Resource*				m_pShadowConstants;				// one buffer holding the constants for all cascades.
+	ID3D12Resource*				m_pShadowPatchIndices;			// indices of the patches visible to the shadow cascades this frame.
 	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlBackBuffer;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlDSV;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlShadowAtlasDSV;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlShadowAtlasSRV_CPU;
-	D3D12_GPU_DESCRIPTOR_HANDLE m_hdlShadowAtlasSRV_GPU;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlFrameConstantsCBV_CPU;
-	D3D12_GPU_DESCRIPTOR_HANDLE m_hdlFrameConstantsCBV_GPU;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlShadowConstantsCBV_CPU[4];
-	D3D12_GPU_DESCRIPTOR_HANDLE m_hdlShadowConstantsCBV_GPU[4];
-	D3D12_VIEWPORT				m_vpShadowAtlas[4];
-	D3D12_RECT					m_srShadowAtlas[4];
 	PerFrameConstantBuffer*		m_pFrameConstantsMapped;
-	ShadowMapShaderConstants*	m_pShadowConstantsMapped[4];
-	unsigned long long			m_valFence;						// Value to check fence against to confirm GPU is done.
+	ShadowMapShaderConstants*	m_pShadowConstantsMapped;		// array of MAX_SHADOW_CASCADES, one per cascade.
+	UINT*						m_pShadowPatchIndicesMapped;
+	D3D12_INDEX_BUFFER_VIEW		m_viewShadowPatchIndices;
+	unsigned long long			m_valFence;						// the pool's fence value of this frame's last submission.
 	unsigned int				m_iFrame;						// Which frame number is this frame?
 	unsigned int				m_wScreen;
 	unsigned int				m_hScreen;
-	unsigned int				m_wShadowAtlas;
-	unsigned int				m_hShadowAtlas;
 };
 
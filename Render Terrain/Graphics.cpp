@@ -30,13 +30,17 @@ namespace graphics {
 		case DOMAIN_SHADER:
 			version = "ds_5_0";
 			break;
+		case COMPUTE_SHADER:
+			version = "cs_5_0";
+			break;
 		default:
 			version = ""; // will break on attempting to compile as not valid.
 		}
 
 		ID3DBlob* shader;
 		ID3DBlob* err;
-		if (FAILED(D3DCompileFromFile(fn, NULL, NULL, "main", version, D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &shader, &err))) {
+		// use the standard include handler so shaders can #include shared code relative to their own file.
+		if (FAILED(D3DCompileFromFile(fn, NULL, D3D_COMPILE_STANDARD_FILE_INCLUDE, "main", version, D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION, 0, &shader, &err))) {
 			if (shader) shader->Release();
 			if (err) {
 				std::string msg((char *)err->GetBufferPointer());
@@ -163,7 +167,7 @@ namespace graphics {
 	// Create and return a pointer to a Command Allocator
 	void Device::CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE clt, ID3D12CommandAllocator*& allocator) {
 		// attempt to create a command allocator.
-		if (FAILED(m_pDev->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator)))) {
+		if (FAILED(m_pDev->CreateCommandAllocator(clt, IID_PPV_ARGS(&allocator)))) {
 			throw GFX_Exception("Device::CreateCommandAllocator failed.");
 		}
 	}
@@ -207,6 +211,30 @@ namespace graphics {
 		}
 	}
 
+	// Create and return a pointer to a new compute Pipeline State Object matching the provided description.
+	void Device::CreateComputePSO(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc, ID3D12PipelineState*& pso) {
+		if (FAILED(m_pDev->CreateComputePipelineState(desc, IID_PPV_ARGS(&pso)))) {
+			throw GFX_Exception("Device::CreateComputePSO failed.");
+		}
+	}
+
+	// Create and return a pointer to a new command signature for ExecuteIndirect. root may be null if the signature doesn't change root arguments.
+	void Device::CreateCommandSignature(D3D12_COMMAND_SIGNATURE_DESC* desc, ID3D12RootSignature* root, ID3D12CommandSignature*& sig) {
+		if (FAILED(m_pDev->CreateCommandSignature(desc, root, IID_PPV_ARGS(&sig)))) {
+			throw GFX_Exception("Device::CreateCommandSignature failed.");
+		}
+	}
+
+	// Returns true if shaders other than the geometry shader can write SV_ViewportArrayIndex without GS emulation.
+	bool Device::SupportsViewportIndexFromAnyShader() {
+		D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+		if (FAILED(m_pDev->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)))) {
+			return false;
+		}
+
+		return options.VPAndRTArrayIndexFromAnyShaderFeedingRasterizerSupportedWithoutGSEmulation != FALSE;
+	}
+
 	// Create and return a pointer to a Descriptor Heap.
 	void Device::CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_DESC* desc, ID3D12DescriptorHeap*& heap) {
 		if FAILED(m_pDev->CreateDescriptorHeap(desc, IID_PPV_ARGS(&heap))) {
@@ -219,6 +247,11 @@ namespace graphics {
 		m_pDev->CreateShaderResourceView(tex, desc, handle);
 	}
 
+	// Create an Unordered Access view for the supplied resource.
+	void Device::CreateUAV(ID3D12Resource*& tex, D3D12_UNORDERED_ACCESS_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE handle) {
+		m_pDev->CreateUnorderedAccessView(tex, nullptr, desc, handle);
+	}
+
 	// Create a constant buffer view
 	void Device::CreateCBV(D3D12_CONSTANT_BUFFER_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE handle) {
 		m_pDev->CreateConstantBufferView(desc, handle);
@@ -255,6 +288,11 @@ namespace graphics {
 		}
 	}
 
+	// Return the number of bytes of video memory a resource matching the description would take up.
+	unsigned long long Device::GetResourceAllocationSize(D3D12_RESOURCE_DESC* desc) {
+		return m_pDev->GetResourceAllocationInfo(0, 1, desc).SizeInBytes;
+	}
+
 	// Create a commited resource. 
 	void Device::CreateCommittedResource(ID3D12Resource*& heap, D3D12_RESOURCE_DESC* desc,
 		D3D12_HEAP_PROPERTIES* props, D3D12_HEAP_FLAGS flags, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clear) {
@@ -268,6 +306,21 @@ namespace graphics {
 		}
 	}
 		
+	// Create a heap for placed resources.
+	void Device::CreateHeap(D3D12_HEAP_DESC* desc, ID3D12Heap*& heap) {
+		if (FAILED(m_pDev->CreateHeap(desc, IID_PPV_ARGS(&heap)))) {
+			throw GFX_Exception("Device::CreateHeap failed.");
+		}
+	}
+
+	// Create a resource at offset bytes into heap. Resources placed in the same memory need aliasing barriers between their uses.
+	void Device::CreatePlacedResource(ID3D12Heap* heap, unsigned long long offset, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state,
+		D3D12_CLEAR_VALUE* clear, ID3D12Resource*& resource) {
+		if (FAILED(m_pDev->CreatePlacedResource(heap, offset, desc, state, clear, IID_PPV_ARGS(&resource)))) {
+			throw GFX_Exception("Device::CreatePlacedResource failed.");
+		}
+	}
+
 	// Signal Command Queue with provided fence value.
 	void Device::SetFence(ID3D12Fence* fence, unsigned long long val) {
 		// Add Signal command to set fence to the fence value that indicates the GPU is done with that buffer. 
@@ -20,9 +20,9 @@ Usage:			- Calling the constructor, either through Device DEV(...);
 				when to swap the buffers (SetBackBufferRender(), SetBackBufferPresent(), 
 				and when to actually execute the command list (Render()).
 
-Future Work:	- Add support for compute shaders.
+Future Work:	- Add support for an async compute queue.
 				- Add support for bundles.
-				- Add support for reserved and placed resources.
+				- Add support for reserved resources.
 */
 #pragma once
 
@@ -46,7 +46,7 @@ namespace graphics {
 	static const DXGI_FORMAT DESIRED_FORMAT = DXGI_FORMAT_R8G8B8A8_UNORM;
 	static const D3D_FEATURE_LEVEL	FEATURE_LEVEL = D3D_FEATURE_LEVEL_11_0; // minimum feature level necessary for DirectX 12 compatibility.
 																			// this is all my current card supports.
-	enum ShaderType { PIXEL_SHADER, VERTEX_SHADER, GEOMETRY_SHADER, HULL_SHADER, DOMAIN_SHADER };
+	enum ShaderType { PIXEL_SHADER, VERTEX_SHADER, GEOMETRY_SHADER, HULL_SHADER, DOMAIN_SHADER, COMPUTE_SHADER };
 
 	class GFX_Exception : public std::runtime_error {
 	public:
@@ -77,11 +77,19 @@ namespace graphics {
 		void CreateRootSig(CD3DX12_ROOT_SIGNATURE_DESC* desc, ID3D12RootSignature*& root);
 		// Create and return a pointer to a new Pipeline State Object matching the provided description.
 		void CreatePSO(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc, ID3D12PipelineState*& pso);
+		// Create and return a pointer to a new compute Pipeline State Object matching the provided description.
+		void CreateComputePSO(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc, ID3D12PipelineState*& pso);
+		// Create and return a pointer to a new command signature for ExecuteIndirect. root may be null if the signature doesn't change root arguments.
+		void CreateCommandSignature(D3D12_COMMAND_SIGNATURE_DESC* desc, ID3D12RootSignature* root, ID3D12CommandSignature*& sig);
+		// Returns true if shaders other than the geometry shader can write SV_ViewportArrayIndex without GS emulation.
+		bool SupportsViewportIndexFromAnyShader();
 		
 		// Create and return a pointer to a Descriptor Heap.
 		void CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_DESC* desc, ID3D12DescriptorHeap*& heap);
 		// Create a Shader Resource view for the supplied resource.
 		void CreateSRV(ID3D12Resource*& tex, D3D12_SHADER_RESOURCE_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE handle);
+		// Create an Unordered Access view for the supplied resource.
+		void CreateUAV(ID3D12Resource*& tex, D3D12_UNORDERED_ACCESS_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE handle);
 		// Create a constant buffer view
 		void CreateCBV(D3D12_CONSTANT_BUFFER_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE handle);
 		// Create a depth/stencil buffer view
@@ -96,9 +104,16 @@ namespace graphics {
 		void CreateGraphicsCommandList(D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator* alloc, ID3D12GraphicsCommandList*& list,
 			unsigned int mask = 0, ID3D12PipelineState* psoInit = nullptr);
 
+		// Return the number of bytes of video memory a resource matching the description would take up.
+		unsigned long long GetResourceAllocationSize(D3D12_RESOURCE_DESC* desc);
 		// Create a commited resource. 
 		void CreateCommittedResource(ID3D12Resource*& heap, D3D12_RESOURCE_DESC* desc, D3D12_HEAP_PROPERTIES* props, D3D12_HEAP_FLAGS flags,
 			D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clear);
+		// Create a heap for placed resources.
+		void CreateHeap(D3D12_HEAP_DESC* desc, ID3D12Heap*& heap);
+		// Create a resource at offset bytes into heap. Resources placed in the same memory need aliasing barriers between their uses.
+		void CreatePlacedResource(ID3D12Heap* heap, unsigned long long offset, D3D12_RESOURCE_DESC* desc, D3D12_RESOURCE_STATES state,
+			D3D12_CLEAR_VALUE* clear, ID3D12Resource*& resource);
 
 		// Run the submitted array of commands
 		void ExecuteCommandLists(ID3D12CommandList* lCmds[], unsigned int numCommands);
@@ -0,0 +1,411 @@
+/*
+HeightfieldRayCast.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Casts rays against the terrain's heightfield through a pyramid of min/max heights.
+*/
+#include "HeightfieldRayCast.h"
+#include "ParallelFor.h"
+#include <cmath>
+#include <thread>
+#include <xmmintrin.h>
+
+// iterations used to narrow down a hit found by marching. Each halves the distance to the surface.
+static const unsigned int MARCH_REFINE_STEPS = 16;
+// deepest the node stack can get. Each level adds at most 3 nodes to it.
+static const unsigned int RAY_STACK_SIZE = 128;
+
+// a block of cells in the pyramid.
+struct PyramidNode {
+	unsigned int level;
+	unsigned int x;
+	unsigned int y;
+};
+
+// Returns 1 / d, or a very large number with the same sign if d is so close to 0 that 1 / d would overflow.
+static float SafeInverse(float d) {
+	if (fabsf(d) < 1e-20f) return d < 0.0f ? -1e30f : 1e30f;
+	return 1.0f / d;
+}
+
+HeightfieldRayCaster::HeightfieldRayCaster(const TerrainSurface* surface) : m_pSurface(surface) {
+	unsigned int w = m_pSurface->GetWidth();
+	unsigned int h = m_pSurface->GetDepth();
+
+	// with an extra texel on each side copied from the edge, bilinear interpolation between neighbouring heights
+	// gives exactly what the clamping sampler does, right up to the edge of the terrain.
+	m_numHeightsX = w + 2;
+	m_numHeightsY = h + 2;
+	m_listHeights.resize((size_t)m_numHeightsX * m_numHeightsY);
+	// the domain shader divides y by the width, not the depth, before sampling.
+	m_scaleY = (float)h / (float)w;
+
+	// level 0 has a cell per 4 neighbouring heights, and each level above merges blocks of 2 x 2 from the one below,
+	// until a single block covers the terrain.
+	Level level;
+	level.numX = m_numHeightsX - 1;
+	level.numY = m_numHeightsY - 1;
+	while (true) {
+		level.listBounds.resize((size_t)level.numX * level.numY);
+		m_listLevels.push_back(level);
+		if (level.numX == 1 && level.numY == 1) break;
+		level.numX = (level.numX + 1) / 2;
+		level.numY = (level.numY + 1) / 2;
+	}
+	UpdateRegion(0, 0, w, h);
+
+	// half a displacement texel is enough to see every bump in the displacement map, and a quarter of a world unit
+	// enough to see every bump in the heightmap.
+	m_stepDisplaced = fminf(0.5f * m_pSurface->GetDisplacementTexelSize(), 0.25f);
+}
+
+// Reload heightmap texels [x0, x1) x [y0, y1) from the surface and update the pyramid above them.
+void HeightfieldRayCaster::UpdateRegion(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1) {
+	unsigned int w = m_pSurface->GetWidth();
+	unsigned int h = m_pSurface->GetDepth();
+	const unsigned char* heightmap = m_pSurface->GetHeightMap();
+	float scale = m_pSurface->GetScale();
+	if (x1 > w) x1 = w;
+	if (y1 > h) y1 = h;
+	if (x0 >= x1 || y0 >= y1) return;
+
+	// texel t is height t + 1. The texels along the edges are copied into the extra row beyond them as well.
+	unsigned int lx0 = x0 == 0 ? 0 : x0 + 1;
+	unsigned int ly0 = y0 == 0 ? 0 : y0 + 1;
+	unsigned int lx1 = x1 == w ? m_numHeightsX : x1 + 1;
+	unsigned int ly1 = y1 == h ? m_numHeightsY : y1 + 1;
+	for (unsigned int y = ly0; y < ly1; ++y) {
+		unsigned int ty = y == 0 ? 0 : y > h ? h - 1 : y - 1;
+		for (unsigned int x = lx0; x < lx1; ++x) {
+			unsigned int tx = x == 0 ? 0 : x > w ? w - 1 : x - 1;
+			m_listHeights[(size_t)y * m_numHeightsX + x] = ((float)heightmap[((size_t)ty * w + tx) * 4] / 255.0f) * scale;
+		}
+	}
+
+	// a bilinear cell is never higher or lower than its corners. Cell (i, j) has heights (i, j) to (i + 1, j + 1).
+	Level& level0 = m_listLevels[0];
+	unsigned int cx0 = lx0 == 0 ? 0 : lx0 - 1;
+	unsigned int cy0 = ly0 == 0 ? 0 : ly0 - 1;
+	unsigned int cx1 = lx1 < level0.numX ? lx1 : level0.numX;
+	unsigned int cy1 = ly1 < level0.numY ? ly1 : level0.numY;
+	for (unsigned int y = cy0; y < cy1; ++y) {
+		for (unsigned int x = cx0; x < cx1; ++x) {
+			const float* row0 = &m_listHeights[(size_t)y * m_numHeightsX + x];
+			const float* row1 = row0 + m_numHeightsX;
+			float zmin = fminf(fminf(row0[0], row0[1]), fminf(row1[0], row1[1]));
+			float zmax = fmaxf(fmaxf(row0[0], row0[1]), fmaxf(row1[0], row1[1]));
+			level0.listBounds[(size_t)y * level0.numX + x] = XMFLOAT2(zmin, zmax);
+		}
+	}
+
+	// only the blocks above the changed cells need merging again.
+	for (unsigned int l = 1; l < m_listLevels.size(); ++l) {
+		const Level& below = m_listLevels[l - 1];
+		Level& above = m_listLevels[l];
+		cx0 /= 2;
+		cy0 /= 2;
+		cx1 = (cx1 + 1) / 2;
+		cy1 = (cy1 + 1) / 2;
+		for (unsigned int y = cy0; y < cy1; ++y) {
+			for (unsigned int x = cx0; x < cx1; ++x) {
+				XMFLOAT2 bounds(1e30f, -1e30f);
+				for (unsigned int cy = 2 * y; cy < 2 * y + 2 && cy < below.numY; ++cy) {
+					for (unsigned int cx = 2 * x; cx < 2 * x + 2 && cx < below.numX; ++cx) {
+						const XMFLOAT2& b = below.listBounds[(size_t)cy * below.numX + cx];
+						bounds.x = fminf(bounds.x, b.x);
+						bounds.y = fmaxf(bounds.y, b.y);
+					}
+				}
+				above.listBounds[(size_t)y * above.numX + x] = bounds;
+			}
+		}
+	}
+}
+
+// Move ray into the space of the pyramid and clip it to the terrain. Returns false if it misses the terrain entirely.
+bool HeightfieldRayCaster::MakeLocalRay(const HeightfieldRay& ray, LocalRay& local) const {
+	// height (i, j) of m_listHeights sits at (i, j), so the texel centre at world x = 0.5 is at 1.
+	local.origin[0] = ray.origin.x + 0.5f;
+	local.origin[1] = ray.origin.y * m_scaleY + 0.5f;
+	local.origin[2] = ray.origin.z;
+	local.direction[0] = ray.direction.x;
+	local.direction[1] = ray.direction.y * m_scaleY;
+	local.direction[2] = ray.direction.z;
+	for (int i = 0; i < 3; ++i) {
+		local.invDirection[i] = SafeInverse(local.direction[i]);
+	}
+
+	// the terrain covers world [0, width] along each side. The pyramid reaches half a texel past it.
+	float lo[2] = { 0.5f, 0.5f };
+	float hi[2] = { (float)m_numHeightsX - 1.5f, (float)m_numHeightsY - 1.5f };
+	local.tMin = 0.0f;
+	local.tMax = ray.tMax;
+	for (int i = 0; i < 2; ++i) {
+		float t0 = (lo[i] - local.origin[i]) * local.invDirection[i];
+		float t1 = (hi[i] - local.origin[i]) * local.invDirection[i];
+		local.tMin = fmaxf(local.tMin, fminf(t0, t1));
+		local.tMax = fminf(local.tMax, fmaxf(t0, t1));
+	}
+
+	return local.tMin <= local.tMax;
+}
+
+// Returns the first t in [t0, t1] where the ray reaches the surface in cell (i, j), or a negative value if it doesn't.
+float HeightfieldRayCaster::IntersectCell(const HeightfieldRay& ray, const LocalRay& local, unsigned int i, unsigned int j,
+	float t0, float t1, bool useDisplacement) const {
+	if (useDisplacement) return MarchSegment(ray, t0, t1, m_stepDisplaced, true);
+
+	const float* row0 = &m_listHeights[(size_t)j * m_numHeightsX + i];
+	const float* row1 = row0 + m_numHeightsX;
+	float h00 = row0[0];
+	float a = row0[1] - h00;
+	float b = row1[0] - h00;
+	float e = h00 - row0[1] - row1[0] + row1[1];
+
+	// with the ray at (u0 + s * du, v0 + s * dv, z0 + s * dz) from where it enters the cell, its height above the
+	// bilinear surface h00 + a * u + b * v + e * u * v is the quadratic A * s^2 + B * s + C.
+	float du = local.direction[0];
+	float dv = local.direction[1];
+	float u0 = local.origin[0] + t0 * du - (float)i;
+	float v0 = local.origin[1] + t0 * dv - (float)j;
+	float z0 = local.origin[2] + t0 * local.direction[2];
+	float A = -e * du * dv;
+	float B = local.direction[2] - (a * du + b * dv + e * (u0 * dv + v0 * du));
+	float C = z0 - (h00 + a * u0 + b * v0 + e * u0 * v0);
+
+	// already under the surface where it enters the cell. The surface is continuous, so this only happens to rays
+	// starting under the terrain or to a hit right on the edge of the cell before.
+	if (C <= 0.0f) return t0;
+
+	float L = t1 - t0;
+	float disc = B * B - 4.0f * A * C;
+	if (disc < 0.0f) return -1.0f;
+
+	// the numerically stable form of the quadratic formula. When A is tiny, q / A is huge and C / q is the linear root.
+	float q = -0.5f * (B + (B < 0.0f ? -sqrtf(disc) : sqrtf(disc)));
+	if (q == 0.0f) return -1.0f;
+	float s1 = A != 0.0f ? q / A : -1.0f;
+	float s2 = C / q;
+	float s = -1.0f;
+	if (s1 >= 0.0f && s1 <= L) s = s1;
+	if (s2 >= 0.0f && s2 <= L && (s < 0.0f || s2 < s)) s = s2;
+
+	return s < 0.0f ? -1.0f : t0 + s;
+}
+
+// Returns the first t in [t0, t1] where the ray reaches the surface, marching in steps of step world units,
+// or a negative value if it doesn't.
+float HeightfieldRayCaster::MarchSegment(const HeightfieldRay& ray, float t0, float t1, float step, bool useDisplacement) const {
+	float len = sqrtf(ray.direction.x * ray.direction.x + ray.direction.y * ray.direction.y + ray.direction.z * ray.direction.z);
+	if (len == 0.0f) return -1.0f;
+	float dt = step / len;
+
+	// how far the ray is above the surface at t.
+	auto above = [&](float t) {
+		float x = ray.origin.x + t * ray.direction.x;
+		float y = ray.origin.y + t * ray.direction.y;
+		float z = ray.origin.z + t * ray.direction.z;
+		return z - (useDisplacement ? m_pSurface->GetDisplacedHeight(x, y) : m_pSurface->GetHeight(x, y));
+	};
+
+	if (above(t0) <= 0.0f) return t0;
+
+	float t = t0;
+	while (t < t1) {
+		float tNext = fminf(t + dt, t1);
+		if (above(tNext) <= 0.0f) {
+			// somewhere between the last step and this one. Narrow it down, keeping the far end under the surface.
+			float lo = t;
+			float hi = tNext;
+			for (unsigned int i = 0; i < MARCH_REFINE_STEPS; ++i) {
+				float mid = 0.5f * (lo + hi);
+				if (above(mid) <= 0.0f) hi = mid;
+				else lo = mid;
+			}
+			return hi;
+		}
+		t = tNext;
+	}
+
+	return -1.0f;
+}
+
+// Fill in hit for a ray that hit at t, or missed if t is negative. Returns hit.isHit.
+bool HeightfieldRayCaster::MakeHit(const HeightfieldRay& ray, float t, HeightfieldHit& hit) const {
+	hit.isHit = t >= 0.0f;
+	hit.t = hit.isHit ? t : ray.tMax;
+	hit.position = XMFLOAT3(ray.origin.x + hit.t * ray.direction.x, ray.origin.y + hit.t * ray.direction.y,
+		ray.origin.z + hit.t * ray.direction.z);
+	return hit.isHit;
+}
+
+// Cast a single ray. Returns true if it hit the surface, with the hit in hit.
+bool HeightfieldRayCaster::CastRay(const HeightfieldRay& ray, bool useDisplacement, HeightfieldHit& hit) const {
+	LocalRay local;
+	if (!MakeLocalRay(ray, local)) return MakeHit(ray, -1.0f, hit);
+
+	float pad = useDisplacement ? SURFACE_MAX_DISPLACEMENT : 0.0f;
+	float tBest = local.tMax;
+	bool isFound = false;
+	// children are pushed far to near, so the nearest is looked at first. Blocks beyond the nearest hit so far are skipped.
+	unsigned int nx = local.direction[0] < 0.0f ? 1 : 0;
+	unsigned int ny = local.direction[1] < 0.0f ? 1 : 0;
+
+	PyramidNode stack[RAY_STACK_SIZE];
+	unsigned int numStack = 0;
+	stack[numStack++] = { (unsigned int)m_listLevels.size() - 1, 0, 0 };
+	while (numStack > 0) {
+		PyramidNode node = stack[--numStack];
+		const Level& level = m_listLevels[node.level];
+		const XMFLOAT2& bounds = level.listBounds[(size_t)node.y * level.numX + node.x];
+
+		// the block covers cells [x << level, (x + 1) << level), clipped to the edge of level 0.
+		float lo[3] = { (float)(node.x << node.level), (float)(node.y << node.level), bounds.x - pad };
+		float hi[3] = { fminf((float)((node.x + 1) << node.level), (float)m_listLevels[0].numX),
+			fminf((float)((node.y + 1) << node.level), (float)m_listLevels[0].numY), bounds.y + pad };
+		float t0 = local.tMin;
+		float t1 = tBest;
+		for (int i = 0; i < 3; ++i) {
+			float ta = (lo[i] - local.origin[i]) * local.invDirection[i];
+			float tb = (hi[i] - local.origin[i]) * local.invDirection[i];
+			t0 = fmaxf(t0, fminf(ta, tb));
+			t1 = fminf(t1, fmaxf(ta, tb));
+		}
+		if (t0 > t1) continue;
+
+		if (node.level == 0) {
+			float t = IntersectCell(ray, local, node.x, node.y, t0, t1, useDisplacement);
+			if (t >= 0.0f && (!isFound || t < tBest)) {
+				tBest = t;
+				isFound = true;
+			}
+			continue;
+		}
+
+		const Level& below = m_listLevels[node.level - 1];
+		for (unsigned int c = 0; c < 4; ++c) {
+			// c = 0 is the far child, c = 3 the near one. The two in between are never both crossed.
+			unsigned int cx = 2 * node.x + ((c & 1) ? nx : 1 - nx);
+			unsigned int cy = 2 * node.y + ((c & 2) ? ny : 1 - ny);
+			if (cx < below.numX && cy < below.numY) stack[numStack++] = { node.level - 1, cx, cy };
+		}
+	}
+
+	return MakeHit(ray, isFound ? tBest : -1.0f, hit);
+}
+
+// Cast up to RAY_PACKET_SIZE rays together through the pyramid.
+void HeightfieldRayCaster::CastPacket(const HeightfieldRay* rays, unsigned int num, bool useDisplacement, HeightfieldHit* hits) const {
+	LocalRay local[RAY_PACKET_SIZE];
+	alignas(16) float origin[3][RAY_PACKET_SIZE];
+	alignas(16) float invDirection[3][RAY_PACKET_SIZE];
+	alignas(16) float tMin[RAY_PACKET_SIZE];
+	alignas(16) float tBest[RAY_PACKET_SIZE];
+	bool isFound[RAY_PACKET_SIZE] = {};
+	int iFirst = -1;
+
+	for (unsigned int r = 0; r < RAY_PACKET_SIZE; ++r) {
+		// rays past the end of the batch, or missing the terrain, get an empty range so they never take part.
+		bool isActive = r < num && MakeLocalRay(rays[r], local[r]);
+		for (int i = 0; i < 3; ++i) {
+			origin[i][r] = isActive ? local[r].origin[i] : 0.0f;
+			invDirection[i][r] = isActive ? local[r].invDirection[i] : 1.0f;
+		}
+		tMin[r] = isActive ? local[r].tMin : 1.0f;
+		tBest[r] = isActive ? local[r].tMax : 0.0f;
+		if (isActive && iFirst < 0) iFirst = (int)r;
+	}
+
+	if (iFirst >= 0) {
+		__m128 o[3], inv[3];
+		for (int i = 0; i < 3; ++i) {
+			o[i] = _mm_load_ps(origin[i]);
+			inv[i] = _mm_load_ps(invDirection[i]);
+		}
+		__m128 vtMin = _mm_load_ps(tMin);
+		__m128 vtBest = _mm_load_ps(tBest);
+		float pad = useDisplacement ? SURFACE_MAX_DISPLACEMENT : 0.0f;
+		// the packet walks the pyramid in the order that suits its first ray.
+		unsigned int nx = local[iFirst].direction[0] < 0.0f ? 1 : 0;
+		unsigned int ny = local[iFirst].direction[1] < 0.0f ? 1 : 0;
+
+		PyramidNode stack[RAY_STACK_SIZE];
+		unsigned int numStack = 0;
+		stack[numStack++] = { (unsigned int)m_listLevels.size() - 1, 0, 0 };
+		while (numStack > 0) {
+			PyramidNode node = stack[--numStack];
+			const Level& level = m_listLevels[node.level];
+			const XMFLOAT2& bounds = level.listBounds[(size_t)node.y * level.numX + node.x];
+
+			float lo[3] = { (float)(node.x << node.level), (float)(node.y << node.level), bounds.x - pad };
+			float hi[3] = { fminf((float)((node.x + 1) << node.level), (float)m_listLevels[0].numX),
+				fminf((float)((node.y + 1) << node.level), (float)m_listLevels[0].numY), bounds.y + pad };
+			__m128 t0 = vtMin;
+			__m128 t1 = vtBest;
+			for (int i = 0; i < 3; ++i) {
+				__m128 ta = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(lo[i]), o[i]), inv[i]);
+				__m128 tb = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(hi[i]), o[i]), inv[i]);
+				t0 = _mm_max_ps(t0, _mm_min_ps(ta, tb));
+				t1 = _mm_min_ps(t1, _mm_max_ps(ta, tb));
+			}
+			int mask = _mm_movemask_ps(_mm_cmple_ps(t0, t1));
+			if (!mask) continue;
+
+			if (node.level == 0) {
+				alignas(16) float enter[RAY_PACKET_SIZE];
+				alignas(16) float exit[RAY_PACKET_SIZE];
+				_mm_store_ps(enter, t0);
+				_mm_store_ps(exit, t1);
+				for (unsigned int r = 0; r < RAY_PACKET_SIZE; ++r) {
+					if (!(mask & (1 << r))) continue;
+
+					float t = IntersectCell(rays[r], local[r], node.x, node.y, enter[r], exit[r], useDisplacement);
+					if (t >= 0.0f && (!isFound[r] || t < tBest[r])) {
+						tBest[r] = t;
+						isFound[r] = true;
+					}
+				}
+				vtBest = _mm_load_ps(tBest);
+				continue;
+			}
+
+			const Level& below = m_listLevels[node.level - 1];
+			for (unsigned int c = 0; c < 4; ++c) {
+				unsigned int cx = 2 * node.x + ((c & 1) ? nx : 1 - nx);
+				unsigned int cy = 2 * node.y + ((c & 2) ? ny : 1 - ny);
+				if (cx < below.numX && cy < below.numY) stack[numStack++] = { node.level - 1, cx, cy };
+			}
+		}
+	}
+
+	for (unsigned int r = 0; r < num; ++r) {
+		MakeHit(rays[r], isFound[r] ? tBest[r] : -1.0f, hits[r]);
+	}
+}
+
+// Cast num rays, filling in num hits. Runs on numThreads threads, or one per hardware thread if 0.
+void HeightfieldRayCaster::CastRays(const HeightfieldRay* rays, unsigned int num, bool useDisplacement, unsigned int numThreads,
+	HeightfieldHit* hits) const {
+	if (numThreads == 0) {
+		numThreads = std::thread::hardware_concurrency();
+	}
+
+	int numPackets = (int)((num + RAY_PACKET_SIZE - 1) / RAY_PACKET_SIZE);
+	ParallelForBands(numPackets, numThreads, [&](int p0, int p1) {
+		for (int p = p0; p < p1; ++p) {
+			unsigned int first = (unsigned int)p * RAY_PACKET_SIZE;
+			unsigned int count = num - first < RAY_PACKET_SIZE ? num - first : RAY_PACKET_SIZE;
+			CastPacket(rays + first, count, useDisplacement, hits + first);
+		}
+	});
+}
+
+// Find the hit by marching the ray in steps of step world units. Returns true if it hit the surface.
+bool HeightfieldRayCaster::MarchRay(const HeightfieldRay& ray, bool useDisplacement, float step, HeightfieldHit& hit) const {
+	LocalRay local;
+	if (!MakeLocalRay(ray, local)) return MakeHit(ray, -1.0f, hit);
+
+	return MakeHit(ray, MarchSegment(ray, local.tMin, local.tMax, step, useDisplacement), hit);
+}
@@ -0,0 +1,102 @@
+/*
+HeightfieldRayCast.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Casts rays against the terrain's heightfield for picking, line of sight and projectile hits.
+				Rays walk down a pyramid of min/max heights, skipping any block of the terrain they pass
+				over or under, and only test the bilinear cells at the bottom they actually touch. Batches
+				are cast in packets of four rays using SSE, and split across worker threads. Only depends on
+				DirectXMath and a TerrainSurface, so it can be run and timed without a Direct3D 12 device.
+
+Usage:			- Requires a TerrainSurface, which must outlive the HeightfieldRayCaster. The pyramid is built
+					from its heightmap in the constructor.
+				- A ray hits at origin + t * direction for the smallest t in [0, tMax] where it reaches the surface.
+					The direction doesn't need to be normalized, so a ray from a to b with a direction of b - a and
+					a tMax of 1 tests the line of sight between them.
+				- CastRay() casts a single ray. CastRays() casts a batch, in packets of RAY_PACKET_SIZE neighbouring
+					rays, on numThreads threads or one per hardware thread if 0. Neighbouring rays going the same way,
+					ie picking rays for neighbouring pixels, share most of their walk down the pyramid.
+				- Without displacement the surface is the bilinear heightmap as the GPU samples it and hits are exact.
+					With displacement the cells are marched in steps of half a displacement map texel, and the
+					displacement is taken as if it only moved the surface up or down. See TerrainSurface.h.
+				- Rays starting under the surface hit where they enter the terrain.
+				- MarchRay() finds the hit by marching the whole ray in small steps. It is slow and only there to
+					check the pyramid against, which the HeightfieldRayCast tests in Render Terrain Tests do.
+
+Future Work:	- Sort incoherent batches into packets of rays going the same way.
+*/
+#pragma once
+
+#include "TerrainSurface.h"
+#include <vector>
+
+// rays cast together through the pyramid by CastRays().
+static const unsigned int RAY_PACKET_SIZE = 4;
+
+struct HeightfieldRay {
+	XMFLOAT3	origin;
+	XMFLOAT3	direction;
+	float		tMax;		// furthest along the direction to look for a hit.
+};
+
+struct HeightfieldHit {
+	XMFLOAT3	position;	// origin + t * direction. Only valid if isHit.
+	float		t;
+	bool		isHit;
+};
+
+class HeightfieldRayCaster {
+public:
+	HeightfieldRayCaster(const TerrainSurface* surface);
+
+	// Cast a single ray. Returns true if it hit the surface, with the hit in hit.
+	bool CastRay(const HeightfieldRay& ray, bool useDisplacement, HeightfieldHit& hit) const;
+	// Cast num rays, filling in num hits. Runs on numThreads threads, or one per hardware thread if 0.
+	void CastRays(const HeightfieldRay* rays, unsigned int num, bool useDisplacement, unsigned int numThreads, HeightfieldHit* hits) const;
+	// Find the hit by marching the ray in steps of step world units. Returns true if it hit the surface.
+	bool MarchRay(const HeightfieldRay& ray, bool useDisplacement, float step, HeightfieldHit& hit) const;
+	// Reload heightmap texels [x0, x1) x [y0, y1) from the surface and update the pyramid above them.
+	void UpdateRegion(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
+
+	unsigned int GetNumLevels() const { return (unsigned int)m_listLevels.size(); }
+
+private:
+	// A ray moved into the space of the pyramid, where cell (i, j) covers [i, i + 1] x [j, j + 1].
+	// t is the same in both spaces.
+	struct LocalRay {
+		float	origin[3];
+		float	direction[3];
+		float	invDirection[3];
+		float	tMin;		// where the ray enters the terrain.
+		float	tMax;		// where it leaves, or its own tMax if sooner.
+	};
+
+	struct Level {
+		unsigned int			numX;
+		unsigned int			numY;
+		std::vector<XMFLOAT2>	listBounds;		// lowest and highest height of each block of cells.
+	};
+
+	// Move ray into the space of the pyramid and clip it to the terrain. Returns false if it misses the terrain entirely.
+	bool MakeLocalRay(const HeightfieldRay& ray, LocalRay& local) const;
+	// Returns the first t in [t0, t1] where the ray reaches the surface in cell (i, j), or a negative value if it doesn't.
+	float IntersectCell(const HeightfieldRay& ray, const LocalRay& local, unsigned int i, unsigned int j, float t0, float t1,
+		bool useDisplacement) const;
+	// Returns the first t in [t0, t1] where the ray reaches the surface, marching in steps of step world units,
+	// or a negative value if it doesn't.
+	float MarchSegment(const HeightfieldRay& ray, float t0, float t1, float step, bool useDisplacement) const;
+	// Cast up to RAY_PACKET_SIZE rays together through the pyramid.
+	void CastPacket(const HeightfieldRay* rays, unsigned int num, bool useDisplacement, HeightfieldHit* hits) const;
+	// Fill in hit for a ray that hit at t, or missed if t is negative. Returns hit.isHit.
+	bool MakeHit(const HeightfieldRay& ray, float t, HeightfieldHit& hit) const;
+
+	const TerrainSurface*	m_pSurface;
+	std::vector<float>		m_listHeights;		// the heightmap with an extra row of texels around the edge, as the sampler clamps.
+	std::vector<Level>		m_listLevels;		// level 0 holds a cell per set of 4 neighbouring heights. The last level is 1 x 1.
+	unsigned int			m_numHeightsX;
+	unsigned int			m_numHeightsY;
+	float					m_scaleY;			// heightmap rows per world unit along y.
+	float					m_stepDisplaced;	// world units between samples when marching the displaced surface.
+};
@@ -0,0 +1,178 @@
+/*
+HiZCulling.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Layout of the hierarchical depth (Hi-Z) pyramid used for occlusion culling, and a
+				software rasterized version of it for checking the GPU culling without a device.
+*/
+#include "HiZCulling.h"
+#include <algorithm>
+#include <cmath>
+
+// Returns the largest power of two no greater than v.
+static unsigned int FloorPow2(unsigned int v) {
+	unsigned int p = 1;
+	while (p * 2 <= v) {
+		p *= 2;
+	}
+	return p;
+}
+
+// Write the size of mip 0 of the Hi-Z pyramid for a depth buffer wDepth x hDepth to w and h.
+// Rounding down to a power of two means every mip after the first is an exact 2x2 reduction.
+void CalcHiZSize(unsigned int wDepth, unsigned int hDepth, unsigned int& w, unsigned int& h) {
+	w = FloorPow2(wDepth);
+	h = FloorPow2(hDepth);
+}
+
+// Returns the number of mips in a Hi-Z pyramid whose mip 0 is w x h. The last mip is 1 texel along its longest side.
+unsigned int CalcHiZMipCount(unsigned int w, unsigned int h) {
+	unsigned int num = 1;
+	while (w > 1 || h > 1) {
+		w = std::max(w / 2, 1u);
+		h = std::max(h / 2, 1u);
+		++num;
+	}
+	return num;
+}
+
+SoftwareHiZ::SoftwareHiZ(unsigned int wDepth, unsigned int hDepth) : m_wDepth(wDepth), m_hDepth(hDepth) {
+	m_listDepth.resize(m_wDepth * m_hDepth);
+	CalcHiZSize(m_wDepth, m_hDepth, m_wHiZ, m_hHiZ);
+	m_listMips.resize(CalcHiZMipCount(m_wHiZ, m_hHiZ));
+	for (unsigned int m = 0; m < m_listMips.size(); ++m) {
+		m_listMips[m].resize(std::max(m_wHiZ >> m, 1u) * std::max(m_hHiZ >> m, 1u));
+	}
+	Clear();
+}
+
+// Reset the depth buffer to the far plane.
+void SoftwareHiZ::Clear() {
+	std::fill(m_listDepth.begin(), m_listDepth.end(), 1.0f);
+}
+
+// Rasterize the world space triangle abc into the depth buffer. Counter-clockwise triangles are culled, as are
+// triangles crossing the near plane, which only ever makes the result less likely to occlude.
+void SoftwareHiZ::RasterizeTriangle(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c, FXMMATRIX viewProj) {
+	XMFLOAT3 world[3] = { a, b, c };
+	XMFLOAT3 screen[3];
+	for (int i = 0; i < 3; ++i) {
+		XMFLOAT4 p;
+		XMStoreFloat4(&p, XMVector4Transform(XMVectorSet(world[i].x, world[i].y, world[i].z, 1.0f), viewProj));
+		if (p.w <= 0.0f || p.z < 0.0f) return;
+
+		// NDC to pixels, with y pointing down as in the depth buffer.
+		screen[i].x = (p.x / p.w * 0.5f + 0.5f) * (float)m_wDepth;
+		screen[i].y = (-p.y / p.w * 0.5f + 0.5f) * (float)m_hDepth;
+		screen[i].z = p.z / p.w;
+	}
+
+	// twice the signed area. Clockwise on screen is front facing, as for the default D3D rasterizer state.
+	float area = (screen[1].x - screen[0].x) * (screen[2].y - screen[0].y) - (screen[1].y - screen[0].y) * (screen[2].x - screen[0].x);
+	if (area <= 0.0f) return;
+
+	int xMin = std::max((int)floorf(std::min(std::min(screen[0].x, screen[1].x), screen[2].x)), 0);
+	int xMax = std::min((int)ceilf(std::max(std::max(screen[0].x, screen[1].x), screen[2].x)), (int)m_wDepth - 1);
+	int yMin = std::max((int)floorf(std::min(std::min(screen[0].y, screen[1].y), screen[2].y)), 0);
+	int yMax = std::min((int)ceilf(std::max(std::max(screen[0].y, screen[1].y), screen[2].y)), (int)m_hDepth - 1);
+
+	// sample at pixel centres. Depth is affine in screen space, so it can be interpolated with the barycentrics directly.
+	for (int y = yMin; y <= yMax; ++y) {
+		for (int x = xMin; x <= xMax; ++x) {
+			float px = (float)x + 0.5f;
+			float py = (float)y + 0.5f;
+			float w0 = (screen[2].x - screen[1].x) * (py - screen[1].y) - (screen[2].y - screen[1].y) * (px - screen[1].x);
+			float w1 = (screen[0].x - screen[2].x) * (py - screen[2].y) - (screen[0].y - screen[2].y) * (px - screen[2].x);
+			float w2 = (screen[1].x - screen[0].x) * (py - screen[0].y) - (screen[1].y - screen[0].y) * (px - screen[0].x);
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+
+			float z = (w0 * screen[0].z + w1 * screen[1].z + w2 * screen[2].z) / area;
+			float& depth = m_listDepth[y * m_wDepth + x];
+			depth = std::min(depth, z);
+		}
+	}
+}
+
+// Build the Hi-Z pyramid from the depth buffer. Same footprints as BuildHiZCS.hlsl.
+void SoftwareHiZ::BuildPyramid() {
+	unsigned int wSrc = m_wDepth;
+	unsigned int hSrc = m_hDepth;
+	const float* src = &m_listDepth[0];
+	for (unsigned int m = 0; m < m_listMips.size(); ++m) {
+		unsigned int wDst = std::max(m_wHiZ >> m, 1u);
+		unsigned int hDst = std::max(m_hHiZ >> m, 1u);
+		for (unsigned int y = 0; y < hDst; ++y) {
+			for (unsigned int x = 0; x < wDst; ++x) {
+				// every source texel the destination texel overlaps, even partially.
+				unsigned int x0 = x * wSrc / wDst;
+				unsigned int x1 = ((x + 1) * wSrc + wDst - 1) / wDst;
+				unsigned int y0 = y * hSrc / hDst;
+				unsigned int y1 = ((y + 1) * hSrc + hDst - 1) / hDst;
+
+				float depth = 0.0f;
+				for (unsigned int sy = y0; sy < y1; ++sy) {
+					for (unsigned int sx = x0; sx < x1; ++sx) {
+						depth = std::max(depth, src[sy * wSrc + sx]);
+					}
+				}
+				m_listMips[m][y * wDst + x] = depth;
+			}
+		}
+
+		wSrc = wDst;
+		hSrc = hDst;
+		src = &m_listMips[m][0];
+	}
+}
+
+float SoftwareHiZ::GetHiZ(unsigned int mip, unsigned int x, unsigned int y) {
+	return m_listMips[mip][y * std::max(m_wHiZ >> mip, 1u) + x];
+}
+
+// Returns true if every point of the world space box from min to max is behind the depth in the pyramid.
+bool SoftwareHiZ::IsBoxOccluded(XMFLOAT3 min, XMFLOAT3 max, FXMMATRIX viewProj) {
+	XMFLOAT3 ndcMin(1.0f, 1.0f, 1.0f);
+	XMFLOAT3 ndcMax(-1.0f, -1.0f, -1.0f);
+	for (int i = 0; i < 8; ++i) {
+		XMVECTOR corner = XMVectorSet(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z, 1.0f);
+		XMFLOAT4 p;
+		XMStoreFloat4(&p, XMVector4Transform(corner, viewProj));
+		// part of the box is behind the camera, so it can't be behind anything else.
+		if (p.w <= 0.0f) return false;
+
+		ndcMin.x = std::min(ndcMin.x, p.x / p.w);
+		ndcMin.y = std::min(ndcMin.y, p.y / p.w);
+		ndcMin.z = std::min(ndcMin.z, p.z / p.w);
+		ndcMax.x = std::max(ndcMax.x, p.x / p.w);
+		ndcMax.y = std::max(ndcMax.y, p.y / p.w);
+		ndcMax.z = std::max(ndcMax.z, p.z / p.w);
+	}
+
+	// the rectangle the box covers in texture space. NDC y points up and texture v down.
+	float uMin = std::min(std::max(ndcMin.x * 0.5f + 0.5f, 0.0f), 1.0f);
+	float uMax = std::min(std::max(ndcMax.x * 0.5f + 0.5f, 0.0f), 1.0f);
+	float vMin = std::min(std::max(-ndcMax.y * 0.5f + 0.5f, 0.0f), 1.0f);
+	float vMax = std::min(std::max(-ndcMin.y * 0.5f + 0.5f, 0.0f), 1.0f);
+
+	// pick the mip where the rectangle is at most a texel across, so it touches no more than 2x2 texels.
+	float size = std::max((uMax - uMin) * (float)m_wHiZ, (vMax - vMin) * (float)m_hHiZ);
+	unsigned int mip = (unsigned int)std::min(std::max(ceilf(log2f(std::max(size, 1.0f))), 0.0f), (float)(m_listMips.size() - 1));
+	unsigned int w = std::max(m_wHiZ >> mip, 1u);
+	unsigned int h = std::max(m_hHiZ >> mip, 1u);
+
+	unsigned int x0 = std::min((unsigned int)(uMin * w), w - 1);
+	unsigned int x1 = std::min((unsigned int)(uMax * w), w - 1);
+	unsigned int y0 = std::min((unsigned int)(vMin * h), h - 1);
+	unsigned int y1 = std::min((unsigned int)(vMax * h), h - 1);
+
+	float depth = 0.0f;
+	for (unsigned int y = y0; y <= y1; ++y) {
+		for (unsigned int x = x0; x <= x1; ++x) {
+			depth = std::max(depth, GetHiZ(mip, x, y));
+		}
+	}
+
+	return ndcMin.z > depth;
+}
@@ -0,0 +1,59 @@
+/*
+HiZCulling.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Layout of the hierarchical depth (Hi-Z) pyramid used for occlusion culling, and a
+				software rasterized version of it for checking the GPU culling without a device.
+				Only depends on DirectXMath.
+
+Usage:			- Call CalcHiZSize() and CalcHiZMipCount() to get the pyramid for a depth buffer.
+					Mip 0 is the largest power of two that fits inside the depth buffer and every
+					texel holds the furthest depth of the depth buffer pixels it overlaps.
+				- SoftwareHiZ sw(w, h); sw.Clear(); then RasterizeTriangle() for every occluder
+					triangle, BuildPyramid(), and IsBoxOccluded() for each box to test.
+				- IsBoxOccluded() matches the test in CullPatchesCS.hlsl.
+
+Future Work:	- Clip triangles to the near plane rather than skipping them.
+				- SIMD rasterization.
+*/
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+using namespace DirectX;
+
+// Write the size of mip 0 of the Hi-Z pyramid for a depth buffer wDepth x hDepth to w and h.
+void CalcHiZSize(unsigned int wDepth, unsigned int hDepth, unsigned int& w, unsigned int& h);
+// Returns the number of mips in a Hi-Z pyramid whose mip 0 is w x h. The last mip is 1 texel along its longest side.
+unsigned int CalcHiZMipCount(unsigned int w, unsigned int h);
+
+class SoftwareHiZ {
+public:
+	SoftwareHiZ(unsigned int wDepth, unsigned int hDepth);
+	~SoftwareHiZ() {}
+
+	// Reset the depth buffer to the far plane.
+	void Clear();
+	// Rasterize the world space triangle abc into the depth buffer. Counter-clockwise triangles are culled, as are
+	// triangles crossing the near plane, which only ever makes the result less likely to occlude.
+	void RasterizeTriangle(XMFLOAT3 a, XMFLOAT3 b, XMFLOAT3 c, FXMMATRIX viewProj);
+	// Build the Hi-Z pyramid from the depth buffer.
+	void BuildPyramid();
+	// Returns true if every point of the world space box from min to max is behind the depth in the pyramid.
+	bool IsBoxOccluded(XMFLOAT3 min, XMFLOAT3 max, FXMMATRIX viewProj);
+
+	float GetDepth(unsigned int x, unsigned int y) { return m_listDepth[y * m_wDepth + x]; }
+	float GetHiZ(unsigned int mip, unsigned int x, unsigned int y);
+	unsigned int GetNumMips() { return (unsigned int)m_listMips.size(); }
+
+private:
+	std::vector<float>				m_listDepth;
+	std::vector<std::vector<float>>	m_listMips;
+	unsigned int					m_wDepth;
+	unsigned int					m_hDepth;
+	unsigned int					m_wHiZ;			// size of mip 0.
+	unsigned int					m_hHiZ;
+};
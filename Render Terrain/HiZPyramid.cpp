@@ -0,0 +1,152 @@
+/*
+HiZPyramid.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for building a hierarchical depth (Hi-Z) pyramid from a depth buffer with a compute shader.
+*/
+#include "HiZPyramid.h"
+#include <string>
+
+HiZPyramid::HiZPyramid(Device* dev, ResourceManager* rm, PipelineManager* pm, unsigned int hDepth, unsigned int wDepth,
+	unsigned int numSources) : m_pDev(dev), m_pResMgr(rm), m_pPSOMgr(pm), m_numSources(numSources), m_wDepth(wDepth), m_hDepth(hDepth) {
+	m_pRootSig = nullptr;
+	m_pHiZ = nullptr;
+	m_listSources.resize(m_numSources, nullptr);
+
+	CalcHiZSize(m_wDepth, m_hDepth, m_wHiZ, m_hHiZ);
+	m_numMips = CalcHiZMipCount(m_wHiZ, m_hHiZ);
+
+	InitPipeline(pm);
+
+	m_pResMgr->NewBuffer(m_pHiZ, &CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_FLOAT, m_wHiZ, m_hHiZ, 1, m_numMips, 1, 0,
+		D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS), &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, nullptr);
+	m_pHiZ->SetName(L"Hi-Z Pyramid");
+
+	// heap layout: an (SRV, UAV) pair for each source into mip 0, then one for each mip reading the one before it,
+	// then an SRV of the whole pyramid for culling.
+	m_iTable = m_pResMgr->ReserveCBVSRVUAVTable(CalcNumDescriptors(m_hDepth, m_wDepth, m_numSources));
+
+	D3D12_UNORDERED_ACCESS_VIEW_DESC descUAV = {};
+	descUAV.Format = DXGI_FORMAT_R32_FLOAT;
+	descUAV.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC	descSRV = {};
+	descSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	descSRV.Format = DXGI_FORMAT_R32_FLOAT;
+	descSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	descSRV.Texture2D.MipLevels = 1;
+
+	for (unsigned int m = 1; m < m_numMips; ++m) {
+		unsigned int i = m_iTable + m_numSources * 2 + (m - 1) * 2;
+		descSRV.Texture2D.MostDetailedMip = m - 1;
+		m_pResMgr->AddSRVAt(i, m_pHiZ, &descSRV);
+		descUAV.Texture2D.MipSlice = m;
+		m_pResMgr->AddUAVAt(i + 1, m_pHiZ, &descUAV);
+	}
+
+	descSRV.Texture2D.MostDetailedMip = 0;
+	descSRV.Texture2D.MipLevels = m_numMips;
+	m_pResMgr->AddSRVAt(m_iTable + m_numSources * 2 + (m_numMips - 1) * 2, m_pHiZ, &descSRV);
+}
+
+HiZPyramid::~HiZPyramid() {
+	// the pyramid is released by the resource manager and the root signature and PSO by the pipeline manager.
+	m_pHiZ = nullptr;
+	m_pDev = nullptr;
+	m_pResMgr = nullptr;
+	m_pPSOMgr = nullptr;
+}
+
+// Returns the number of CBV/SRV/UAV heap slots a pyramid for numSources depth buffers of size wDepth x hDepth reserves.
+unsigned int HiZPyramid::CalcNumDescriptors(unsigned int hDepth, unsigned int wDepth, unsigned int numSources) {
+	unsigned int w, h;
+	CalcHiZSize(wDepth, hDepth, w, h);
+	return numSources * 2 + (CalcHiZMipCount(w, h) - 1) * 2 + 1;
+}
+
+// Create the root signature and compute pipeline.
+void HiZPyramid::InitPipeline(PipelineManager* pm) {
+	CD3DX12_DESCRIPTOR_RANGE rangesRoot[2];
+	rangesRoot[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+	rangesRoot[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+
+	CD3DX12_ROOT_PARAMETER paramsRoot[NUM_HIZ_ROOT_PARAMS];
+	paramsRoot[HIZ_ROOT_CONSTANTS].InitAsConstants(4, 0);
+	paramsRoot[HIZ_ROOT_TABLE].InitAsDescriptorTable(_countof(rangesRoot), rangesRoot);
+
+	CD3DX12_ROOT_SIGNATURE_DESC	descRoot;
+	descRoot.Init(_countof(paramsRoot), paramsRoot, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+	m_pRootSig = pm->CreateRootSig(&descRoot);
+
+	D3D12_SHADER_BYTECODE bcCS = {};
+	CompileShader(L"BuildHiZCS.hlsl", COMPUTE_SHADER, bcCS);
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC descPSO = {};
+	descPSO.pRootSignature = m_pRootSig;
+	descPSO.CS = bcCS;
+	m_hdlPSO = pm->RequestComputePipeline(&descPSO);
+}
+
+// Create the view used to read depth buffer i.
+void HiZPyramid::SetSource(unsigned int i, ID3D12Resource* depth) {
+	if (i >= m_numSources) {
+		std::string msg = "HiZPyramid::SetSource failed due to index " + std::to_string(i) + " out of bounds.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	m_listSources[i] = depth;
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC	descSRV = {};
+	descSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	descSRV.Format = DXGI_FORMAT_R32_FLOAT;
+	descSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	descSRV.Texture2D.MipLevels = 1;
+	m_pResMgr->AddSRVAt(m_iTable + i * 2, depth, &descSRV);
+
+	D3D12_UNORDERED_ACCESS_VIEW_DESC descUAV = {};
+	descUAV.Format = DXGI_FORMAT_R32_FLOAT;
+	descUAV.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	descUAV.Texture2D.MipSlice = 0;
+	m_pResMgr->AddUAVAt(m_iTable + i * 2 + 1, m_pHiZ, &descUAV);
+}
+
+// Record the commands to rebuild the pyramid from depth buffer i. The depth buffer must be in the non-pixel shader resource state.
+void HiZPyramid::Build(ID3D12GraphicsCommandList* cmdList, unsigned int i) {
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_pHiZ, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+
+	ID3D12DescriptorHeap* heaps[] = { m_pResMgr->GetCBVSRVUAVHeap() };
+	cmdList->SetDescriptorHeaps(_countof(heaps), heaps);
+	cmdList->SetPipelineState(m_pPSOMgr->GetPipeline(m_hdlPSO));
+	cmdList->SetComputeRootSignature(m_pRootSig);
+
+	unsigned int wSrc = m_wDepth;
+	unsigned int hSrc = m_hDepth;
+	for (unsigned int m = 0; m < m_numMips; ++m) {
+		// non-square pyramids bottom out at 1 texel along the short side first.
+		unsigned int wDst = m_wHiZ >> m ? m_wHiZ >> m : 1;
+		unsigned int hDst = m_hHiZ >> m ? m_hHiZ >> m : 1;
+
+		if (m > 0) {
+			// the mip just written becomes the input for this one.
+			cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_pHiZ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+				D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, m - 1));
+		}
+
+		unsigned int iSlot = m == 0 ? m_iTable + i * 2 : m_iTable + m_numSources * 2 + (m - 1) * 2;
+		UINT constants[] = { wSrc, hSrc, wDst, hDst };
+		cmdList->SetComputeRoot32BitConstants(HIZ_ROOT_CONSTANTS, _countof(constants), constants, 0);
+		cmdList->SetComputeRootDescriptorTable(HIZ_ROOT_TABLE, m_pResMgr->GetCBVSRVUAVHandleGPU(iSlot));
+		cmdList->Dispatch((wDst + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (hDst + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+		wSrc = wDst;
+		hSrc = hDst;
+	}
+
+	// every mip but the last was moved back as it was read.
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_pHiZ, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, m_numMips - 1));
+}
@@ -0,0 +1,74 @@
+/*
+HiZPyramid.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for building a hierarchical depth (Hi-Z) pyramid from a depth buffer with a compute shader.
+				Every texel holds the furthest depth of the area it covers, so a box whose nearest point is
+				further away than the texels under it is hidden.
+
+Usage:			- Proper shutdown is handled by the destructor.
+				- Requires pointers to Device, ResourceManager, and PipelineManager objects, the size of the
+					depth buffers it will be built from, and the number of depth buffers.
+				- Reserves CalcNumDescriptors() slots in the CBV/SRV/UAV heap, so make room for them when
+					creating the ResourceManager.
+				- Call SetSource() once for each depth buffer. They must be R32_TYPELESS.
+				- Call Build() to rebuild the pyramid from one of the depth buffers. The depth buffer must be
+					in the non-pixel shader resource state.
+				- Bind GetSRVTable() to read the whole pyramid. It is left in the non-pixel shader resource state.
+				- See HiZCulling.h for the layout of the pyramid and a CPU version.
+
+Future Work:	- Build all mips in one dispatch.
+*/
+#pragma once
+
+#include "ResourceManager.h"
+#include "PipelineManager.h"
+#include "HiZCulling.h"
+
+using namespace graphics;
+
+// threads per group along each axis in BuildHiZCS.hlsl.
+static const unsigned int HIZ_GROUP_SIZE = 8;
+
+// the root parameters of the Hi-Z build root signature.
+enum HiZRootParam { HIZ_ROOT_CONSTANTS = 0, HIZ_ROOT_TABLE, NUM_HIZ_ROOT_PARAMS };
+
+class HiZPyramid {
+public:
+	HiZPyramid(Device* dev, ResourceManager* rm, PipelineManager* pm, unsigned int hDepth, unsigned int wDepth, unsigned int numSources);
+	~HiZPyramid();
+
+	// Returns the number of CBV/SRV/UAV heap slots a pyramid for numSources depth buffers of size wDepth x hDepth reserves.
+	static unsigned int CalcNumDescriptors(unsigned int hDepth, unsigned int wDepth, unsigned int numSources);
+
+	// Create the view used to read depth buffer i.
+	void SetSource(unsigned int i, ID3D12Resource* depth);
+	// Record the commands to rebuild the pyramid from depth buffer i. The depth buffer must be in the non-pixel shader resource state.
+	void Build(ID3D12GraphicsCommandList* cmdList, unsigned int i);
+
+	D3D12_GPU_DESCRIPTOR_HANDLE GetSRVTable() { return m_pResMgr->GetCBVSRVUAVHandleGPU(m_iTable + m_numSources * 2 + (m_numMips - 1) * 2); }
+	unsigned int GetWidth() { return m_wHiZ; }
+	unsigned int GetHeight() { return m_hHiZ; }
+	unsigned int GetNumMips() { return m_numMips; }
+
+private:
+	// Create the root signature and compute pipeline.
+	void InitPipeline(PipelineManager* pm);
+
+	Device*							m_pDev;
+	ResourceManager*				m_pResMgr;
+	PipelineManager*				m_pPSOMgr;
+	ID3D12RootSignature*			m_pRootSig;			// owned by m_pPSOMgr.
+	unsigned int					m_hdlPSO;
+	ID3D12Resource*					m_pHiZ;				// released by the resource manager.
+	std::vector<ID3D12Resource*>	m_listSources;
+	unsigned int					m_iTable;			// first reserved heap slot. See CalcNumDescriptors() for the layout.
+	unsigned int					m_numSources;
+	unsigned int					m_numMips;
+	unsigned int					m_wDepth;
+	unsigned int					m_hDepth;
+	unsigned int					m_wHiZ;				// size of mip 0.
+	unsigned int					m_hHiZ;
+};
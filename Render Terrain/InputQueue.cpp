@@ -0,0 +1,42 @@
+/*
+InputQueue.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	A lock-free queue carrying keyboard and mouse input from the window's thread to the
+				simulation thread.
+*/
+#include "InputQueue.h"
+
+InputQueue::InputQueue(unsigned int size) : m_iHead(0), m_iTail(0), m_numDropped(0) {
+	unsigned int sizePow2 = 1;
+	while (sizePow2 < size) sizePow2 <<= 1;
+	m_listEvents.resize(sizePow2);
+	m_mask = sizePow2 - 1;
+}
+
+// Add an event to the back of the queue. Producer thread only. Returns false, dropping the event, if the queue is full.
+bool InputQueue::Push(const InputEvent& e) {
+	unsigned int tail = m_iTail.load(std::memory_order_relaxed);
+	// acquire so the consumer is done reading the slot before it gets overwritten.
+	if (tail - m_iHead.load(std::memory_order_acquire) > m_mask) {
+		m_numDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	m_listEvents[tail & m_mask] = e;
+	// release so the event is written before the consumer can see it.
+	m_iTail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+// Take the event at the front of the queue. Consumer thread only. Returns false if the queue is empty.
+bool InputQueue::Pop(InputEvent& e) {
+	unsigned int head = m_iHead.load(std::memory_order_relaxed);
+	if (head == m_iTail.load(std::memory_order_acquire)) return false;
+
+	e = m_listEvents[head & m_mask];
+	m_iHead.store(head + 1, std::memory_order_release);
+	return true;
+}
@@ -0,0 +1,55 @@
+/*
+InputQueue.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	A lock-free queue carrying keyboard and mouse input from the window's thread to the
+				simulation thread. Only one thread may push and only one thread may pop.
+
+Usage:			- The window's message handler calls Push() for every key and mouse event.
+				- The simulation thread calls Pop() until it returns false at the start of every step.
+				- When the queue is full Push() drops the event and counts it. See GetNumDropped().
+
+Future Work:	- Merge mouse moves already in the queue instead of dropping them when it is full.
+*/
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+enum InputKeys { _0 = 0x30, _1, _2, _3, _4, _5, _6, _7, _8, _9, _A = 0x41, _B, _C, _D, _E, _F, _G, _H, _I, _J, _K, _L, _M, _N, _O, _P, _Q, _R, _S, _T, _U, _V, _W, _X, _Y, _Z };
+
+static const unsigned int INPUT_QUEUE_SIZE = 1024;	// events the queue can hold. Rounded up to a power of 2.
+
+enum InputEventType { INPUT_KEY_DOWN = 0, INPUT_KEY_UP, INPUT_MOUSE_MOVE };
+
+struct InputEvent {
+	InputEventType	type;
+	unsigned int	key;		// virtual key code. Key events only.
+	int				x;			// distance moved. Mouse moves only.
+	int				y;
+};
+
+class InputQueue {
+public:
+	InputQueue(unsigned int size = INPUT_QUEUE_SIZE);
+
+	// Add an event to the back of the queue. Producer thread only. Returns false, dropping the event, if the queue is full.
+	bool Push(const InputEvent& e);
+	// Take the event at the front of the queue. Consumer thread only. Returns false if the queue is empty.
+	bool Pop(InputEvent& e);
+
+	unsigned int GetSize() { return m_mask + 1; }
+	// Returns the number of events Push() has dropped.
+	unsigned int GetNumDropped() { return m_numDropped.load(std::memory_order_relaxed); }
+
+private:
+	std::vector<InputEvent>		m_listEvents;
+	unsigned int				m_mask;				// size - 1, for wrapping the indices.
+	// the indices only ever count up and are wrapped with m_mask when used. Kept on separate cache lines
+	// so the producer and consumer don't fight over one.
+	alignas(64) std::atomic<unsigned int>	m_iHead;		// next event to pop. Written by the consumer.
+	alignas(64) std::atomic<unsigned int>	m_iTail;		// next slot to push to. Written by the producer.
+	alignas(64) std::atomic<unsigned int>	m_numDropped;
+};
@@ -13,12 +13,12 @@ Usage:			- While you can instantiate a Light, it is better to
 #pragma once
 
 #include <DirectXMath.h>
-#include <Windows.h>
+#include <cstring>
 
 using namespace DirectX;
 
 struct LightSource {
-	LightSource() { ZeroMemory(this, sizeof(this)); }
+	LightSource() { memset(this, 0, sizeof(*this)); }
 
 	XMFLOAT4	pos;
 	XMFLOAT4	intensityAmbient;
@@ -36,6 +36,9 @@ static void KeyUp(UINT key) {
 			PostQuitMessage(0);
 			return;
 	}
+
+	// the simulation moves the camera for as long as a movement key is held down.
+	pScene->HandleKeyRelease(key);
 }
 
 static void KeyDown(UINT key) {
@@ -51,6 +54,12 @@ static void KeyDown(UINT key) {
 		case _2:
 		case _T:
 		case _L:
+		case _G:
+		case _H:
+		case _P:
+		case _B:
+		case _R:
+		case _F:
 			pScene->HandleKeyboardInput(key);
 			break;
 	}
@@ -112,13 +121,15 @@ int WINAPI WinMain(HINSTANCE instance, HINSTANCE prevInstance, PSTR cmdLine, int
 		ZeroMemory(&msg, sizeof(MSG));
 
 		while (1) {
-			if (PeekMessage(&msg, WIN.GetWindow(), 0, 0, PM_REMOVE)) {
+			// handle every message waiting before drawing the next frame. The input only gets queued for the
+			// simulation thread, so this is quick. WM_QUIT isn't sent to a window, so don't filter by window.
+			while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)) {
+				if (msg.message == WM_QUIT) {
+					pScene = nullptr;
+					return 1;
+				}
 				TranslateMessage(&msg);
 				DispatchMessage(&msg);
-			} 
-			if (msg.message == WM_QUIT) { 
-				pScene = nullptr;
-				return 1;
 			}
 
 			S.Update();
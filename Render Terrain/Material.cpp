@@ -36,10 +36,9 @@ TerrainMaterial::TerrainMaterial(ResourceManager* rm, const char* fnNormals1, co
 	descTex.SampleDesc.Quality = 0;
 	descTex.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
-	ID3D12Resource* textures;
-	unsigned int iBuffer = m_pResMgr->NewBuffer(textures, &descTex, &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+	unsigned int iBuffer = m_pResMgr->NewBuffer(m_pTextures, &descTex, &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
 		D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr);
-	textures->SetName(L"Texture Array Buffer");
+	m_pTextures->SetName(L"Texture Array Buffer");
 
 	D3D12_SUBRESOURCE_DATA dataTex[8];
 	// prepare detail map data for upload.
@@ -52,16 +51,6 @@ TerrainMaterial::TerrainMaterial(ResourceManager* rm, const char* fnNormals1, co
 
 	m_pResMgr->UploadToBuffer(iBuffer, 8, dataTex, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 
-	// Create the SRV for the detail map texture and save to Terrain object.
-	D3D12_SHADER_RESOURCE_VIEW_DESC	descSRV = {};
-	descSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	descSRV.Format = descTex.Format;
-	descSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
-	descSRV.Texture2DArray.ArraySize = descTex.DepthOrArraySize;
-	descSRV.Texture2DArray.MipLevels = descTex.MipLevels;
-
-	m_pResMgr->AddSRV(textures, &descSRV, m_hdlTextureSRV_CPU, m_hdlTextureSRV_GPU);
-
 	m_listColors[0] = colors[0];
 	m_listColors[1] = colors[1];
 	m_listColors[2] = colors[2];
@@ -70,9 +59,20 @@ TerrainMaterial::TerrainMaterial(ResourceManager* rm, const char* fnNormals1, co
 
 TerrainMaterial::~TerrainMaterial() {
 	m_pResMgr = nullptr;
+	m_pTextures = nullptr;
 }
 
-// Attach our SRV to the provided root descriptor table slot.
-void TerrainMaterial::Attach(ID3D12GraphicsCommandList* cmdList, unsigned int srvDescTableIndex) {
-	cmdList->SetGraphicsRootDescriptorTable(srvDescTableIndex, m_hdlTextureSRV_GPU);
+// Create our SRV in slot i of the CBV/SRV/UAV heap. Used to build descriptor tables.
+void TerrainMaterial::CreateResourceView(unsigned int i) {
+	D3D12_RESOURCE_DESC descTex = m_pTextures->GetDesc();
+
+	// Create the SRV for the detail map texture array.
+	D3D12_SHADER_RESOURCE_VIEW_DESC	descSRV = {};
+	descSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	descSRV.Format = descTex.Format;
+	descSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+	descSRV.Texture2DArray.ArraySize = descTex.DepthOrArraySize;
+	descSRV.Texture2DArray.MipLevels = descTex.MipLevels;
+
+	m_pResMgr->AddSRVAt(i, m_pTextures, &descSRV);
 }
\ No newline at end of file
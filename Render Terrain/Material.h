@@ -24,14 +24,13 @@ public:
 		XMFLOAT4 colors[4]);
 	~TerrainMaterial();
 
-	// Attach our SRV to the provided root descriptor table slot.
-	void Attach(ID3D12GraphicsCommandList* cmdList,	unsigned int srvDescTableIndex);
+	// Create our SRV in slot i of the CBV/SRV/UAV heap. Used to build descriptor tables.
+	void CreateResourceView(unsigned int i);
 	// return the array of colors.
 	XMFLOAT4* GetColors() { return m_listColors; }
 private:
 	ResourceManager*			m_pResMgr;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlTextureSRV_CPU;
-	D3D12_GPU_DESCRIPTOR_HANDLE m_hdlTextureSRV_GPU;
+	ID3D12Resource*				m_pTextures;
 	XMFLOAT4					m_listColors[4];
 };
 
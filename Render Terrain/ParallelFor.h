@@ -0,0 +1,41 @@
+/*
+ParallelFor.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Splits a range of work into bands and runs them on worker threads.
+
+Usage:			- Call ParallelForBands(count, numThreads, f) to call f(begin, end) once per band. The calling
+					thread takes the last band, and the call returns once every band is done.
+				- Every item is handled exactly once whatever the number of threads, so bands must not depend on each other.
+
+Future Work:	- Keep a pool of worker threads rather than starting new ones for every call.
+*/
+#pragma once
+
+#include <future>
+#include <vector>
+
+// Split [0, count) into one band per thread and call f(begin, end) for each. The calling thread takes the last band.
+// Every item is handled exactly once whatever the number of threads, so bands must not depend on each other.
+template<typename F>
+static void ParallelForBands(int count, unsigned int numThreads, F f) {
+	int numBands = (int)numThreads < count ? (int)numThreads : count;
+	if (numBands <= 1) {
+		if (count > 0) f(0, count);
+		return;
+	}
+
+	std::vector<std::future<void>> workers;
+	for (int b = 0; b < numBands - 1; ++b) {
+		int begin = (int)((long long)count * b / numBands);
+		int end = (int)((long long)count * (b + 1) / numBands);
+		workers.push_back(std::async(std::launch::async, f, begin, end));
+	}
+	f((int)((long long)count * (numBands - 1) / numBands), count);
+
+	for (auto& w : workers) {
+		w.get();
+	}
+}
@@ -0,0 +1,59 @@
+/*
+PatchChunks.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Splits the terrain patches of the grid into chunks with their own 16 bit index lists.
+*/
+#include "PatchChunks.h"
+#include "PatchGrid.h"
+
+// Returns the most rows of patches a chunk sizeChunk patches wide can hold while keeping its indices within MAX_CHUNK_INDEX,
+// in a grid numX control points wide. Never more than sizeChunk. Returns 0 if not even a single row fits.
+unsigned int CalcChunkRows(unsigned int numX, unsigned int sizeChunk) {
+	// a chunk of h rows and w columns reaches from its first vertex to h rows of the grid plus w vertices further on.
+	if (numX == 0 || sizeChunk > MAX_CHUNK_INDEX) return 0;
+
+	unsigned int rows = (MAX_CHUNK_INDEX - sizeChunk) / numX;
+	return rows < sizeChunk ? rows : sizeChunk;
+}
+
+// Split the terrain patches of a grid of numX x numY control points into chunks up to sizeChunk patches wide.
+// Chunks are appended to chunks, row by row, and their indices to indices. Returns false if the grid is too wide for 16 bit indices.
+bool BuildPatchChunks(unsigned int numX, unsigned int numY, unsigned int sizeChunk, std::vector<PatchChunk>& chunks,
+	std::vector<unsigned short>& indices) {
+	if (numX < 2 || numY < 2) return true;
+
+	unsigned int rows = CalcChunkRows(numX, sizeChunk);
+	if (rows == 0) return false;
+
+	unsigned int numPatchesX = numX - 1;
+	unsigned int numPatchesY = numY - 1;
+	for (unsigned int y = 0; y < numPatchesY; y += rows) {
+		for (unsigned int x = 0; x < numPatchesX; x += sizeChunk) {
+			PatchChunk chunk;
+			chunk.x = x;
+			chunk.y = y;
+			chunk.numPatchesX = numPatchesX - x < sizeChunk ? numPatchesX - x : sizeChunk;
+			chunk.numPatchesY = numPatchesY - y < rows ? numPatchesY - y : rows;
+			chunk.firstIndex = (unsigned int)indices.size();
+			chunk.numIndices = chunk.numPatchesX * chunk.numPatchesY * 4;
+			// the chunk's first patch starts with its lowest vertex.
+			chunk.baseVertex = CalcPatchControlPoint(numX, numY, y * numPatchesX + x, 0);
+
+			for (unsigned int py = y; py < y + chunk.numPatchesY; ++py) {
+				for (unsigned int px = x; px < x + chunk.numPatchesX; ++px) {
+					for (unsigned int c = 0; c < 4; ++c) {
+						unsigned int v = CalcPatchControlPoint(numX, numY, py * numPatchesX + px, c);
+						indices.push_back((unsigned short)(v - chunk.baseVertex));
+					}
+				}
+			}
+
+			chunks.push_back(chunk);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,49 @@
+/*
+PatchChunks.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Splits the terrain patches of the grid enumerated in PatchGrid.h into chunks
+				with their own 16 bit index lists. Each chunk's indices are relative to a base
+				vertex, so a chunk only needs its vertex span to fit in 16 bits, not the whole grid.
+
+Usage:			- Call CalcChunkRows() to find how many rows of patches a chunk can hold. Vertices are
+					laid out row by row, so a chunk spans a full row of the grid for every row of patches
+					it holds. Wide grids get chunks shorter than they are wide.
+				- Call BuildPatchChunks() to fill a list of chunks and the 16 bit indices they draw from.
+					Vertex c.baseVertex + i of the grid is drawn for local index i. SV_VertexID doesn't include the
+					base vertex of an indexed draw, so without a vertex buffer the shader has to add c.baseVertex itself,
+					ie from a root constant, and chunk c is drawn with DrawIndexedInstanced(c.numIndices, 1, c.firstIndex, 0, 0).
+				- Only the terrain patches are chunked. The skirts and bottom plane reach from the edge of
+					the grid to the base vertices after it, so they are left to the 32 bit index list.
+
+Future Work:	- Reorder vertices chunk by chunk so chunks can always be square.
+*/
+#pragma once
+
+#include <vector>
+
+// default number of patches along each side of a chunk.
+static const unsigned int PATCH_CHUNK_SIZE = 64;
+// the largest local index a 16 bit index buffer can hold. 0xffff is left free as the strip cut value.
+static const unsigned int MAX_CHUNK_INDEX = 0xfffe;
+
+// A rectangle of terrain patches drawn from the 16 bit index list.
+struct PatchChunk {
+	unsigned int	x;				// first patch column of the chunk.
+	unsigned int	y;				// first patch row of the chunk.
+	unsigned int	numPatchesX;
+	unsigned int	numPatchesY;
+	unsigned int	firstIndex;		// position of the chunk's first index in the 16 bit index list.
+	unsigned int	numIndices;
+	unsigned int	baseVertex;		// added to every index of the chunk to get the vertex in the grid, by the vertex shader.
+};
+
+// Returns the most rows of patches a chunk sizeChunk patches wide can hold while keeping its indices within MAX_CHUNK_INDEX,
+// in a grid numX control points wide. Never more than sizeChunk. Returns 0 if not even a single row fits.
+unsigned int CalcChunkRows(unsigned int numX, unsigned int sizeChunk);
+// Split the terrain patches of a grid of numX x numY control points into chunks up to sizeChunk patches wide.
+// Chunks are appended to chunks, row by row, and their indices to indices. Returns false if the grid is too wide for 16 bit indices.
+bool BuildPatchChunks(unsigned int numX, unsigned int numY, unsigned int sizeChunk, std::vector<PatchChunk>& chunks,
+	std::vector<unsigned short>& indices);
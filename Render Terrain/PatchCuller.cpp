@@ -0,0 +1,240 @@
+/*
+PatchCuller.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for culling terrain patches against the camera and shadow cascades in a compute
+				shader and drawing the patches that survive with ExecuteIndirect.
+*/
+#include "PatchCuller.h"
+
+// the draw arguments for every list start in the upload buffer right after the view planes.
+static const unsigned long long CULL_ARGS_UPLOAD_OFFSET = (sizeof(CullViewConstants) + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) &
+	~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+// the statistics follow the draw arguments so they are reset by the same copy.
+static const unsigned long long CULL_STATS_OFFSET = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS) * NUM_CULL_LISTS;
+static const unsigned long long CULL_ARGS_SIZE = CULL_STATS_OFFSET + sizeof(CullStats);
+
+PatchCuller::PatchCuller(Device* dev, ResourceManager* rm, PipelineManager* pm, HiZPyramid* hiz, const std::vector<PatchCullData>& patches,
+	unsigned int numFrames) : m_pDev(dev), m_pResMgr(rm), m_pPSOMgr(pm), m_pHiZ(hiz), m_numFrames(numFrames) {
+	m_pRootSig = nullptr;
+	m_pCmdSig = nullptr;
+	m_pPatches = nullptr;
+	m_pArgs = nullptr;
+	m_pLists = nullptr;
+	m_pUpload = nullptr;
+	m_pUploadMapped = nullptr;
+	m_pReadback = nullptr;
+	m_pReadbackMapped = nullptr;
+	m_listHasStats.resize(m_numFrames, false);
+	m_numPatches = (unsigned int)patches.size();
+	// every patch could be visible, so each list needs room for all of them.
+	m_maxIndicesPerList = m_numPatches * 4;
+
+	InitPipeline(pm);
+	InitBuffers(patches);
+}
+
+PatchCuller::~PatchCuller() {
+	// the buffers are released by the resource manager and the root signature and PSO by the pipeline manager.
+	if (m_pUpload) {
+		m_pUpload->Unmap(0, nullptr);
+		m_pUploadMapped = nullptr;
+	}
+
+	if (m_pReadback) {
+		m_pReadback->Unmap(0, &CD3DX12_RANGE(0, 0));
+		m_pReadbackMapped = nullptr;
+	}
+
+	if (m_pCmdSig) {
+		m_pCmdSig->Release();
+		m_pCmdSig = nullptr;
+	}
+
+	m_pDev = nullptr;
+	m_pResMgr = nullptr;
+	m_pPSOMgr = nullptr;
+}
+
+// Create the root signature, compute pipeline, and command signature.
+void PatchCuller::InitPipeline(PipelineManager* pm) {
+	// everything but the Hi-Z pyramid is bound directly from the root.
+	CD3DX12_DESCRIPTOR_RANGE rangesRoot[1];
+	rangesRoot[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
+
+	CD3DX12_ROOT_PARAMETER paramsRoot[NUM_CULL_ROOT_PARAMS];
+	paramsRoot[CULL_ROOT_CONSTANTS].InitAsConstants(4, 0);
+	paramsRoot[CULL_ROOT_VIEWS_CBV].InitAsConstantBufferView(1);
+	paramsRoot[CULL_ROOT_PATCHES_SRV].InitAsShaderResourceView(0);
+	paramsRoot[CULL_ROOT_ARGS_UAV].InitAsUnorderedAccessView(0);
+	paramsRoot[CULL_ROOT_LISTS_UAV].InitAsUnorderedAccessView(1);
+	paramsRoot[CULL_ROOT_HIZ_TABLE].InitAsDescriptorTable(1, &rangesRoot[0]);
+
+	CD3DX12_ROOT_SIGNATURE_DESC	descRoot;
+	descRoot.Init(_countof(paramsRoot), paramsRoot, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+	m_pRootSig = pm->CreateRootSig(&descRoot);
+
+	D3D12_SHADER_BYTECODE bcCS = {};
+	CompileShader(L"CullPatchesCS.hlsl", COMPUTE_SHADER, bcCS);
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC descPSO = {};
+	descPSO.pRootSignature = m_pRootSig;
+	descPSO.CS = bcCS;
+	m_hdlPSO = pm->RequestComputePipeline(&descPSO);
+
+	// the argument buffer only holds plain draws, so no root signature is needed.
+	D3D12_INDIRECT_ARGUMENT_DESC descArg = {};
+	descArg.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+	D3D12_COMMAND_SIGNATURE_DESC descSig = {};
+	descSig.ByteStride = sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+	descSig.NumArgumentDescs = 1;
+	descSig.pArgumentDescs = &descArg;
+	m_pDev->CreateCommandSignature(&descSig, nullptr, m_pCmdSig);
+}
+
+// Create the patch, argument, list, and per-frame upload buffers.
+void PatchCuller::InitBuffers(const std::vector<PatchCullData>& patches) {
+	// the patches only change when the terrain is edited, so they live in a default heap. See UpdatePatches().
+	unsigned long long sizeofBuffer = sizeof(PatchCullData) * m_numPatches;
+	m_iPatches = m_pResMgr->NewBuffer(m_pPatches, &CD3DX12_RESOURCE_DESC::Buffer(sizeofBuffer),
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, nullptr);
+	m_pPatches->SetName(L"Patch Cull Data Buffer");
+
+	D3D12_SUBRESOURCE_DATA dataPatches = {};
+	dataPatches.pData = &patches[0];
+	dataPatches.RowPitch = sizeofBuffer;
+	dataPatches.SlicePitch = sizeofBuffer;
+	m_pResMgr->UploadToBuffer(m_iPatches, 1, &dataPatches, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+	// the draw arguments rest in the state ExecuteIndirect needs between culling passes, which also allows copying out the statistics.
+	m_pResMgr->NewBuffer(m_pArgs, &CD3DX12_RESOURCE_DESC::Buffer(CULL_ARGS_SIZE, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, 
+		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT | D3D12_RESOURCE_STATE_COPY_SOURCE, nullptr);
+	m_pArgs->SetName(L"Patch Cull Draw Arguments");
+
+	sizeofBuffer = sizeof(UINT) * m_maxIndicesPerList * NUM_CULL_LISTS;
+	m_pResMgr->NewBuffer(m_pLists, &CD3DX12_RESOURCE_DESC::Buffer(sizeofBuffer, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS),
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, D3D12_RESOURCE_STATE_INDEX_BUFFER, nullptr);
+	m_pLists->SetName(L"Patch Cull Index Lists");
+
+	m_viewLists.BufferLocation = m_pLists->GetGPUVirtualAddress();
+	m_viewLists.Format = DXGI_FORMAT_R32_UINT;
+	m_viewLists.SizeInBytes = (UINT)sizeofBuffer;
+
+	// each frame gets its own view planes and initial draw arguments so the CPU never overwrites data the GPU hasn't read yet.
+	m_sizeUploadPerFrame = (CULL_ARGS_UPLOAD_OFFSET + CULL_ARGS_SIZE +
+		D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
+	sizeofBuffer = m_sizeUploadPerFrame * m_numFrames;
+	m_pResMgr->NewBuffer(m_pUpload, &CD3DX12_RESOURCE_DESC::Buffer(sizeofBuffer),
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
+	m_pUpload->SetName(L"Patch Cull Upload Buffer");
+
+	CD3DX12_RANGE rangeRead(0, 0);
+	if (FAILED(m_pUpload->Map(0, &rangeRead, reinterpret_cast<void**>(&m_pUploadMapped)))) {
+		throw GFX_Exception("PatchCuller::InitBuffers: Map failed on upload buffer.");
+	}
+	memset(m_pUploadMapped, 0, (size_t)sizeofBuffer);
+
+	sizeofBuffer = sizeof(CullStats) * m_numFrames;
+	m_pResMgr->NewBuffer(m_pReadback, &CD3DX12_RESOURCE_DESC::Buffer(sizeofBuffer),
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK), D3D12_HEAP_FLAG_NONE, D3D12_RESOURCE_STATE_COPY_DEST, nullptr);
+	m_pReadback->SetName(L"Patch Cull Statistics Readback");
+
+	// left mapped. Frames only read their own statistics after waiting on their fence.
+	if (FAILED(m_pReadback->Map(0, nullptr, reinterpret_cast<void**>(&m_pReadbackMapped)))) {
+		throw GFX_Exception("PatchCuller::InitBuffers: Map failed on readback buffer.");
+	}
+}
+
+// Set the planes of view i for frame iFrame. Any planes past numPlanes cull nothing.
+void PatchCuller::SetView(unsigned int iFrame, unsigned int i, const XMFLOAT4* planes, unsigned int numPlanes) {
+	CullViewConstants* views = reinterpret_cast<CullViewConstants*>(m_pUploadMapped + m_sizeUploadPerFrame * iFrame);
+	for (unsigned int p = 0; p < NUM_CULL_PLANES; ++p) {
+		// every point is in front of a plane with no normal and a positive distance.
+		views->planes[i][p] = p < numPlanes ? planes[p] : XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+}
+
+// Occlusion cull the first view in frame iFrame against the Hi-Z pyramid, whose depth was rendered with the (transposed) viewProj.
+// Pass nullptr to turn occlusion culling off, for instance when there is no usable depth buffer yet.
+void PatchCuller::SetOcclusion(unsigned int iFrame, const XMFLOAT4X4* viewProj) {
+	CullViewConstants* views = reinterpret_cast<CullViewConstants*>(m_pUploadMapped + m_sizeUploadPerFrame * iFrame);
+	if (viewProj) {
+		views->occlusionViewProj = *viewProj;
+	}
+	views->hizSize = XMFLOAT4((float)m_pHiZ->GetWidth(), (float)m_pHiZ->GetHeight(), (float)m_pHiZ->GetNumMips(), viewProj ? 1.0f : 0.0f);
+}
+
+// Copy the statistics from the last time frame iFrame was culled to stats. Returns false if it hasn't been culled since the last call.
+// Only call once the GPU has finished with the frame.
+bool PatchCuller::GetCullStats(unsigned int iFrame, CullStats& stats) {
+	if (!m_listHasStats[iFrame]) return false;
+
+	stats = m_pReadbackMapped[iFrame];
+	m_listHasStats[iFrame] = false;
+	return true;
+}
+
+// Replace the bounds and control points of num patches, starting at patch first, ie after the terrain was edited.
+void PatchCuller::UpdatePatches(const PatchCullData* patches, unsigned int first, unsigned int num) {
+	if (num == 0) return;
+	if (first + num > m_numPatches) {
+		throw GFX_Exception("PatchCuller::UpdatePatches: patches out of range.");
+	}
+
+	// the copy is queued ahead of the next culling pass, and after any still in flight.
+	m_pResMgr->UploadToBufferRegion(m_iPatches, (unsigned long long)first * sizeof(PatchCullData), patches,
+		(unsigned long long)num * sizeof(PatchCullData), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+}
+
+// Record the culling pass for frame iFrame against the first numViews views.
+// The union list collects the patches visible to views [firstUnionView, numViews) and is drawn numUnionInstances times.
+void PatchCuller::Cull(ID3D12GraphicsCommandList* cmdList, unsigned int iFrame, unsigned int numViews, unsigned int firstUnionView,
+	unsigned int numUnionInstances) {
+	unsigned long long offsetFrame = m_sizeUploadPerFrame * iFrame;
+
+	// every list starts out empty at its own fixed spot in the index buffer. The compute shader counts the indices up.
+	D3D12_DRAW_INDEXED_ARGUMENTS* args = reinterpret_cast<D3D12_DRAW_INDEXED_ARGUMENTS*>(m_pUploadMapped + offsetFrame + CULL_ARGS_UPLOAD_OFFSET);
+	for (unsigned int i = 0; i < NUM_CULL_LISTS; ++i) {
+		args[i].IndexCountPerInstance = 0;
+		args[i].InstanceCount = i == GetUnionList() ? numUnionInstances : 1;
+		args[i].StartIndexLocation = i * m_maxIndicesPerList;
+		args[i].BaseVertexLocation = 0;
+		args[i].StartInstanceLocation = 0;
+	}
+
+	D3D12_RESOURCE_BARRIER barriers[2];
+	barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_pArgs, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT | D3D12_RESOURCE_STATE_COPY_SOURCE,
+		D3D12_RESOURCE_STATE_COPY_DEST);
+	barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pLists, D3D12_RESOURCE_STATE_INDEX_BUFFER, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+	cmdList->ResourceBarrier(2, barriers);
+
+	cmdList->CopyBufferRegion(m_pArgs, 0, m_pUpload, offsetFrame + CULL_ARGS_UPLOAD_OFFSET, CULL_ARGS_SIZE);
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_pArgs, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_UNORDERED_ACCESS));
+
+	ID3D12DescriptorHeap* heaps[] = { m_pResMgr->GetCBVSRVUAVHeap() };
+	cmdList->SetDescriptorHeaps(_countof(heaps), heaps);
+	cmdList->SetPipelineState(m_pPSOMgr->GetPipeline(m_hdlPSO));
+	cmdList->SetComputeRootSignature(m_pRootSig);
+
+	UINT constants[] = { m_numPatches, numViews, firstUnionView, m_maxIndicesPerList };
+	cmdList->SetComputeRoot32BitConstants(CULL_ROOT_CONSTANTS, _countof(constants), constants, 0);
+	cmdList->SetComputeRootConstantBufferView(CULL_ROOT_VIEWS_CBV, m_pUpload->GetGPUVirtualAddress() + offsetFrame);
+	cmdList->SetComputeRootShaderResourceView(CULL_ROOT_PATCHES_SRV, m_pPatches->GetGPUVirtualAddress());
+	cmdList->SetComputeRootUnorderedAccessView(CULL_ROOT_ARGS_UAV, m_pArgs->GetGPUVirtualAddress());
+	cmdList->SetComputeRootUnorderedAccessView(CULL_ROOT_LISTS_UAV, m_pLists->GetGPUVirtualAddress());
+	cmdList->SetComputeRootDescriptorTable(CULL_ROOT_HIZ_TABLE, m_pHiZ->GetSRVTable());
+
+	cmdList->Dispatch((m_numPatches + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	barriers[0] = CD3DX12_RESOURCE_BARRIER::Transition(m_pArgs, D3D12_RESOURCE_STATE_UNORDERED_ACCESS,
+		D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT | D3D12_RESOURCE_STATE_COPY_SOURCE);
+	barriers[1] = CD3DX12_RESOURCE_BARRIER::Transition(m_pLists, D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+	cmdList->ResourceBarrier(2, barriers);
+
+	cmdList->CopyBufferRegion(m_pReadback, sizeof(CullStats) * iFrame, m_pArgs, CULL_STATS_OFFSET, sizeof(CullStats));
+	m_listHasStats[iFrame] = true;
+}
@@ -0,0 +1,103 @@
+/*
+PatchCuller.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for culling terrain patches against the camera and shadow cascades in a compute
+				shader and drawing the patches that survive with ExecuteIndirect.
+
+Usage:			- Proper shutdown is handled by the destructor.
+				- Requires pointers to Device, ResourceManager, and PipelineManager objects, the
+					patches to cull (see Terrain::GetPatchCullData()), and the number of frames in flight.
+				- Each frame, call SetView() for each view to cull against, then Cull() to record the
+					compute pass. Cull() must come before any of the draws that use its results.
+				- Each view gets its own list of patches. Patches visible to any view from firstUnionView
+					on are also written to the union list (GetUnionList()) for drawing every shadow
+					cascade with one instanced draw.
+				- Call SetOcclusion() each frame to also cull the first view's patches against the Hi-Z
+					pyramid, built from a depth buffer rendered with the provided view projection.
+				- GetCullStats() returns how many patches the first view's frustum kept and how many of
+					those were occluded, once the frame the numbers came from has finished on the GPU.
+				- Pass GetIndexView(), GetCommandSignature(), GetArgs(), and GetArgsOffset() to
+					Terrain::DrawPatchesIndirect() to draw a list.
+				- The lists are shared by all frames. Every frame renders on the same command queue,
+					so the barriers in Cull() are all that's needed to hand them between passes.
+				- Call UpdatePatches() when patches' bounds change. Only those patches are uploaded again.
+				- CullPatchesCPU() runs the same test on the CPU for checking the GPU results. See PatchCulling.h.
+
+Future Work:	- Run the culling on an async compute queue.
+				- Re-test occluded patches against the new depth buffer to catch disocclusions in the same frame.
+*/
+#pragma once
+
+#include "ResourceManager.h"
+#include "PipelineManager.h"
+#include "PatchCulling.h"
+#include "Terrain.h"
+#include "HiZPyramid.h"
+
+using namespace graphics;
+
+// threads per group in CullPatchesCS.hlsl.
+static const unsigned int CULL_GROUP_SIZE = 64;
+
+// the root parameters of the culling root signature.
+enum CullRootParam { CULL_ROOT_CONSTANTS = 0, CULL_ROOT_VIEWS_CBV, CULL_ROOT_PATCHES_SRV, CULL_ROOT_ARGS_UAV, CULL_ROOT_LISTS_UAV, CULL_ROOT_HIZ_TABLE,
+	NUM_CULL_ROOT_PARAMS };
+
+class PatchCuller {
+public:
+	PatchCuller(Device* dev, ResourceManager* rm, PipelineManager* pm, HiZPyramid* hiz, const std::vector<PatchCullData>& patches,
+		unsigned int numFrames);
+	~PatchCuller();
+
+	// Set the planes of view i for frame iFrame. Any planes past numPlanes cull nothing.
+	void SetView(unsigned int iFrame, unsigned int i, const XMFLOAT4* planes, unsigned int numPlanes);
+	// Occlusion cull the first view in frame iFrame against the Hi-Z pyramid, whose depth was rendered with the (transposed) viewProj.
+	// Pass nullptr to turn occlusion culling off, for instance when there is no usable depth buffer yet.
+	void SetOcclusion(unsigned int iFrame, const XMFLOAT4X4* viewProj);
+	// Copy the statistics from the last time frame iFrame was culled to stats. Returns false if it hasn't been culled since the last call.
+	// Only call once the GPU has finished with the frame.
+	bool GetCullStats(unsigned int iFrame, CullStats& stats);
+	// Replace the bounds and control points of num patches, starting at patch first, ie after the terrain was edited.
+	void UpdatePatches(const PatchCullData* patches, unsigned int first, unsigned int num);
+	// Record the culling pass for frame iFrame against the first numViews views.
+	// The union list collects the patches visible to views [firstUnionView, numViews) and is drawn numUnionInstances times.
+	void Cull(ID3D12GraphicsCommandList* cmdList, unsigned int iFrame, unsigned int numViews, unsigned int firstUnionView,
+		unsigned int numUnionInstances);
+
+	D3D12_INDEX_BUFFER_VIEW* GetIndexView() { return &m_viewLists; }
+	ID3D12CommandSignature* GetCommandSignature() { return m_pCmdSig; }
+	ID3D12Resource* GetArgs() { return m_pArgs; }
+	unsigned long long GetArgsOffset(unsigned int list) { return list * sizeof(D3D12_DRAW_INDEXED_ARGUMENTS); }
+	unsigned int GetUnionList() { return MAX_CULL_VIEWS; }
+
+private:
+	// Create the root signature, compute pipeline, and command signature.
+	void InitPipeline(PipelineManager* pm);
+	// Create the patch, argument, list, and per-frame upload buffers.
+	void InitBuffers(const std::vector<PatchCullData>& patches);
+
+	Device*						m_pDev;
+	ResourceManager*			m_pResMgr;
+	PipelineManager*			m_pPSOMgr;
+	HiZPyramid*					m_pHiZ;
+	ID3D12RootSignature*		m_pRootSig;			// owned by m_pPSOMgr.
+	unsigned int				m_hdlPSO;
+	ID3D12CommandSignature*		m_pCmdSig;
+	ID3D12Resource*				m_pPatches;			// the resources are released by the resource manager.
+	unsigned int				m_iPatches;			// index of m_pPatches in the resource manager.
+	ID3D12Resource*				m_pArgs;
+	ID3D12Resource*				m_pLists;
+	ID3D12Resource*				m_pUpload;			// view planes and initial draw arguments for each frame.
+	unsigned char*				m_pUploadMapped;
+	ID3D12Resource*				m_pReadback;		// each frame's culling statistics.
+	CullStats*					m_pReadbackMapped;
+	std::vector<bool>			m_listHasStats;		// has each frame been culled at least once?
+	D3D12_INDEX_BUFFER_VIEW		m_viewLists;
+	unsigned long long			m_sizeUploadPerFrame;
+	unsigned int				m_numFrames;
+	unsigned int				m_numPatches;
+	unsigned int				m_maxIndicesPerList;
+};
@@ -0,0 +1,48 @@
+/*
+PatchCulling.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	CPU version of the patch culling in CullPatchesCS.hlsl.
+*/
+#include "PatchCulling.h"
+#include "BoundingVolume.h"
+
+// CPU version of CullPatchesCS.hlsl. lists must hold NUM_CULL_LISTS lists and receives the indices of the visible patches.
+// If views turns on occlusion culling, hiz stands in for the GPU pyramid. Returns the statistics the GPU would write.
+// The GPU writes patches in whatever order its threads get to them, so sort both before comparing.
+CullStats CullPatchesCPU(const PatchCullData* patches, unsigned int numPatches, const CullViewConstants& views,
+	unsigned int numViews, unsigned int firstUnionView, std::vector<unsigned int>* lists, SoftwareHiZ* hiz) {
+	for (unsigned int i = 0; i < NUM_CULL_LISTS; ++i) {
+		lists[i].clear();
+	}
+
+	CullStats stats = {};
+	bool isOcclusion = hiz && views.hizSize.w != 0.0f;
+	XMMATRIX occlusionViewProj = XMMatrixTranspose(XMLoadFloat4x4(&views.occlusionViewProj));
+
+	for (unsigned int p = 0; p < numPatches; ++p) {
+		bool isInUnion = false;
+		for (unsigned int v = 0; v < numViews; ++v) {
+			if (!AABBIntersectsPlanes(patches[p].aabbmin, patches[p].aabbmax, views.planes[v], NUM_CULL_PLANES)) continue;
+
+			if (v == 0) {
+				++stats.numInFrustum;
+				if (isOcclusion && hiz->IsBoxOccluded(patches[p].aabbmin, patches[p].aabbmax, occlusionViewProj)) {
+					++stats.numOccluded;
+					continue;
+				}
+			}
+
+			lists[v].push_back(p);
+			isInUnion = isInUnion || v >= firstUnionView;
+		}
+
+		if (isInUnion) {
+			lists[MAX_CULL_VIEWS].push_back(p);
+		}
+	}
+
+	return stats;
+}
@@ -0,0 +1,57 @@
+/*
+PatchCulling.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Layout of the patches and views CullPatchesCS.hlsl culls, and a CPU version of the same
+				culling for checking the GPU results. Only depends on DirectXMath.
+
+Usage:			- Fill a CullViewConstants with the planes of up to MAX_CULL_VIEWS views and, to occlusion
+					cull the first view, the view projection of the Hi-Z pyramid's depth buffer.
+				- CullPatchesCPU() writes the patches each view keeps to a list per view, plus a union list of
+					the patches visible to any view from firstUnionView on. A SoftwareHiZ stands in for the
+					GPU pyramid.
+
+Future Work:	- Cull on the CPU with SIMD, 4 patches at a time.
+*/
+#pragma once
+
+#include "ShadowCascades.h"
+#include "HiZCulling.h"
+#include <vector>
+
+using namespace DirectX;
+
+// the camera plus one view per shadow cascade. Must match CullPatchesCS.hlsl.
+static const unsigned int MAX_CULL_VIEWS = 1 + MAX_SHADOW_CASCADES;
+// every view is described by this many planes. Views with fewer are padded with planes that cull nothing.
+static const unsigned int NUM_CULL_PLANES = 6;
+// one list per view plus the union list.
+static const unsigned int NUM_CULL_LISTS = MAX_CULL_VIEWS + 1;
+
+// The bounds and control point indices of a single patch. Matches the structured buffer read by CullPatchesCS.
+struct PatchCullData {
+	XMFLOAT3		aabbmin;
+	XMFLOAT3		aabbmax;
+	unsigned int	indices[4];
+};
+
+// the planes of every view and the occlusion settings, as read by CullPatchesCS.hlsl.
+struct CullViewConstants {
+	XMFLOAT4	planes[MAX_CULL_VIEWS][NUM_CULL_PLANES];
+	XMFLOAT4X4	occlusionViewProj;	// (transposed) view projection the Hi-Z pyramid's depth buffer was rendered with.
+	XMFLOAT4	hizSize;			// x, y = size of mip 0, z = number of mips, w = 1 to occlusion cull the first view.
+};
+
+// per-frame culling statistics for the first view, written by CullPatchesCS.hlsl after the draw arguments.
+struct CullStats {
+	unsigned int	numInFrustum;
+	unsigned int	numOccluded;
+};
+
+// CPU version of CullPatchesCS.hlsl. lists must hold NUM_CULL_LISTS lists and receives the indices of the visible patches.
+// If views turns on occlusion culling, hiz stands in for the GPU pyramid. Returns the statistics the GPU would write.
+// The GPU writes patches in whatever order its threads get to them, so sort both before comparing.
+CullStats CullPatchesCPU(const PatchCullData* patches, unsigned int numPatches, const CullViewConstants& views,
+	unsigned int numViews, unsigned int firstUnionView, std::vector<unsigned int>* lists, SoftwareHiZ* hiz = nullptr);
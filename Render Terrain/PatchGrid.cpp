@@ -0,0 +1,81 @@
+/*
+PatchGrid.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Enumerates the patches of the terrain grid without an index buffer.
+*/
+#include "PatchGrid.h"
+
+// Returns the number of patches in a grid of numX x numY terrain control points, including the skirts and bottom plane.
+unsigned int CalcNumGridPatches(unsigned int numX, unsigned int numY) {
+	return (numX - 1) * (numY - 1) + 2 * (numX - 1) + 2 * (numY - 1) + 1;
+}
+
+// Returns the range patch falls in and writes its position within that range to local.
+PatchRange GetPatchRange(unsigned int numX, unsigned int numY, unsigned int patch, unsigned int& local) {
+	unsigned int sizes[NUM_PATCH_RANGES] = { (numX - 1) * (numY - 1), numX - 1, numX - 1, numY - 1, numY - 1, 1 };
+
+	local = patch;
+	for (int r = 0; r < NUM_PATCH_RANGES - 1; ++r) {
+		if (local < sizes[r]) return (PatchRange)r;
+		local -= sizes[r];
+	}
+
+	return PATCH_RANGE_BOTTOM;
+}
+
+// Returns the index of the vertex used as control point corner (0 - 3) of patch.
+unsigned int CalcPatchControlPoint(unsigned int numX, unsigned int numY, unsigned int patch, unsigned int corner) {
+	unsigned int numTerrain = numX * numY;
+	unsigned int i;
+	PatchRange range = GetPatchRange(numX, numY, patch, i);
+
+	// the control points of each range, in corner order. Skirt patches start with their base vertices so that
+	// control point 0 is unique to the patch and can hold its bounds.
+	switch (range) {
+	case PATCH_RANGE_TERRAIN: {
+		unsigned int x = i % (numX - 1);
+		unsigned int y = i / (numX - 1);
+		unsigned int corners[] = { y * numX + x, y * numX + x + 1, (y + 1) * numX + x, (y + 1) * numX + x + 1 };
+		return corners[corner];
+	}
+	case PATCH_RANGE_SKIRT_1: {
+		unsigned int base = numTerrain + i;
+		unsigned int corners[] = { base, base + 1, i, i + 1 };
+		return corners[corner];
+	}
+	case PATCH_RANGE_SKIRT_2: {
+		unsigned int base = numTerrain + numX + i;
+		unsigned int offset = numX * (numY - 1);
+		unsigned int corners[] = { base + 1, base, offset + i + 1, offset + i };
+		return corners[corner];
+	}
+	case PATCH_RANGE_SKIRT_3: {
+		unsigned int base = numTerrain + 2 * numX + i;
+		unsigned int corners[] = { base + 1, base, (i + 1) * numX, i * numX };
+		return corners[corner];
+	}
+	case PATCH_RANGE_SKIRT_4: {
+		unsigned int base = numTerrain + 2 * numX + numY + i;
+		unsigned int corners[] = { base, base + 1, i * numX + numX - 1, (i + 1) * numX + numX - 1 };
+		return corners[corner];
+	}
+	default: {
+		// the bottom plane is drawn between the corners of the skirt.
+		unsigned int corners[] = { numTerrain + numX - 1, numTerrain, numTerrain + 2 * numX - 1, numTerrain + numX };
+		return corners[corner];
+	}
+	}
+}
+
+// Write the 4 control point indices of every patch to dst, which must have room for CalcNumGridPatches() * 4 indices.
+void WritePatchGridIndices(unsigned int numX, unsigned int numY, unsigned int* dst) {
+	unsigned int numPatches = CalcNumGridPatches(numX, numY);
+	for (unsigned int p = 0; p < numPatches; ++p) {
+		for (unsigned int c = 0; c < 4; ++c) {
+			dst[p * 4 + c] = CalcPatchControlPoint(numX, numY, p, c);
+		}
+	}
+}
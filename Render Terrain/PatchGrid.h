@@ -0,0 +1,34 @@
+/*
+PatchGrid.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Enumerates the patches of the terrain grid without an index buffer.
+				Mirrors the index buffer built by Terrain::CreateMesh3D() and the procedural
+				patch path of RenderTerrainTessVS.hlsl, so the two can be checked against each other.
+
+Usage:			- The grid has numX x numY terrain control points, followed by the skirt base
+					vertices: numX for side 1 (y = 0), numX for side 2 (far y), numY for side 3 (x = 0),
+					and numY for side 4 (far x).
+				- Patches come in ranges: the terrain patches, skirt sides 1 to 4, then the bottom plane.
+					Call GetPatchRange() to find which range a patch falls in.
+				- Call CalcPatchControlPoint() to get the vertex used by one corner of a patch.
+				- Call WritePatchGridIndices() to write the whole enumeration out as an index list.
+
+Future Work:	- Enumerate chunks of the grid instead of the whole thing.
+*/
+#pragma once
+
+// the ranges of patch ids, in the order they are enumerated.
+enum PatchRange { PATCH_RANGE_TERRAIN = 0, PATCH_RANGE_SKIRT_1, PATCH_RANGE_SKIRT_2, PATCH_RANGE_SKIRT_3, PATCH_RANGE_SKIRT_4,
+	PATCH_RANGE_BOTTOM, NUM_PATCH_RANGES };
+
+// Returns the number of patches in a grid of numX x numY terrain control points, including the skirts and bottom plane.
+unsigned int CalcNumGridPatches(unsigned int numX, unsigned int numY);
+// Returns the range patch falls in and writes its position within that range to local.
+PatchRange GetPatchRange(unsigned int numX, unsigned int numY, unsigned int patch, unsigned int& local);
+// Returns the index of the vertex used as control point corner (0 - 3) of patch.
+unsigned int CalcPatchControlPoint(unsigned int numX, unsigned int numY, unsigned int patch, unsigned int corner);
+// Write the 4 control point indices of every patch to dst, which must have room for CalcNumGridPatches() * 4 indices.
+void WritePatchGridIndices(unsigned int numX, unsigned int numY, unsigned int* dst);
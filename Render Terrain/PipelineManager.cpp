@@ -0,0 +1,424 @@
+/*
+PipelineManager.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for creating, caching, and persisting Direct3D 12 Pipeline State Objects.
+*/
+#include "PipelineManager.h"
+#include <fstream>
+#include <cstring>
+
+static const unsigned int PIPELINE_CACHE_MAGIC = 0x434F5350; // "PSOC"
+static const unsigned int PIPELINE_CACHE_VERSION = 1;
+
+// 64 bit FNV-1a hash. Used to key pipelines and root signatures by their description.
+unsigned long long HashBytes(const void* data, size_t size, unsigned long long hash) {
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+PipelineManager::PipelineManager(Device* dev, const char* fnCache) : m_pDev(dev), m_fnCache(fnCache) {
+	m_tStart = std::chrono::high_resolution_clock::now();
+	m_isCacheDirty = false;
+
+	LoadCache();
+}
+
+PipelineManager::~PipelineManager() {
+	WaitForPipelines();
+	SaveCache();
+
+	while (!m_listPipelines.empty()) {
+		PipelineEntry& entry = m_listPipelines.back();
+
+		if (entry.pPSO) entry.pPSO->Release();
+		if (entry.pDesc) delete entry.pDesc;
+
+		m_listPipelines.pop_back();
+	}
+
+	while (!m_listRootSigs.empty()) {
+		ID3D12RootSignature* sigRoot = m_listRootSigs.back().pRootSig;
+
+		if (sigRoot) sigRoot->Release();
+
+		m_listRootSigs.pop_back();
+	}
+
+	m_pDev = nullptr;
+}
+
+// Load the cache file into m_listCachedBlobs.
+void PipelineManager::LoadCache() {
+	std::ifstream file(m_fnCache, std::ios::binary);
+	if (!file) {
+		// no cache yet. Everything will be a cold build.
+		return;
+	}
+
+	unsigned int magic = 0, version = 0, count = 0;
+	file.read((char*)&magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&count, sizeof(count));
+	if (!file || magic != PIPELINE_CACHE_MAGIC || version != PIPELINE_CACHE_VERSION) {
+		// unknown or stale format. Ignore it and it will be overwritten on shutdown.
+		m_isCacheDirty = true;
+		return;
+	}
+
+	for (unsigned int i = 0; i < count; ++i) {
+		unsigned long long hash = 0, size = 0;
+		file.read((char*)&hash, sizeof(hash));
+		file.read((char*)&size, sizeof(size));
+		if (!file) break;
+
+		std::vector<unsigned char> blob((size_t)size);
+		file.read((char*)blob.data(), size);
+		if (!file) break;
+
+		m_listCachedBlobs.push_back(std::make_pair(hash, std::move(blob)));
+	}
+}
+
+// Write any newly compiled pipelines to the cache file.
+void PipelineManager::SaveCache() {
+	if (!m_isCacheDirty) {
+		return;
+	}
+
+	std::ofstream file(m_fnCache, std::ios::binary | std::ios::trunc);
+	if (!file) {
+		// not being able to write the cache shouldn't stop the application. We'll just be cold next time too.
+		OutputDebugStringA("PipelineManager::SaveCache: Unable to open pipeline cache file for writing.\n");
+		return;
+	}
+
+	unsigned int count = (unsigned int)m_listPipelines.size();
+	file.write((const char*)&PIPELINE_CACHE_MAGIC, sizeof(PIPELINE_CACHE_MAGIC));
+	file.write((const char*)&PIPELINE_CACHE_VERSION, sizeof(PIPELINE_CACHE_VERSION));
+	file.write((const char*)&count, sizeof(count));
+
+	for (auto i = 0u; i < count; ++i) {
+		ID3D12PipelineState* pso = GetPipeline(i);
+		ID3DBlob* blob = nullptr;
+		unsigned long long size = 0;
+		if (pso && SUCCEEDED(pso->GetCachedBlob(&blob))) {
+			size = blob->GetBufferSize();
+		}
+
+		file.write((const char*)&m_listPipelines[i].hash, sizeof(unsigned long long));
+		file.write((const char*)&size, sizeof(size));
+		if (blob) {
+			file.write((const char*)blob->GetBufferPointer(), size);
+			blob->Release();
+		}
+	}
+
+	m_isCacheDirty = false;
+}
+
+// Create a root signature matching the description, or return the existing one if it was already created.
+ID3D12RootSignature* PipelineManager::CreateRootSig(CD3DX12_ROOT_SIGNATURE_DESC* desc) {
+	// hash the serialized signature rather than the description, as the description is full of pointers.
+	ID3DBlob* sig;
+	ID3DBlob* err;
+	if (FAILED(D3D12SerializeRootSignature(desc, D3D_ROOT_SIGNATURE_VERSION_1, &sig, &err))) {
+		std::string msg((char *)err->GetBufferPointer());
+		msg = "In PipelineManager::CreateRootSig: " + msg;
+		throw GFX_Exception(msg.c_str());
+	}
+	unsigned long long hash = HashBytes(sig->GetBufferPointer(), sig->GetBufferSize());
+	sig->Release();
+
+	for (auto& entry : m_listRootSigs) {
+		if (entry.hash == hash) {
+			return entry.pRootSig;
+		}
+	}
+
+	RootSigEntry entry;
+	entry.hash = hash;
+	m_pDev->CreateRootSig(desc, entry.pRootSig);
+	m_listRootSigs.push_back(entry);
+
+	return entry.pRootSig;
+}
+
+// Hash all of the data that affects the compiled pipeline. Pointers are followed, not hashed.
+unsigned long long PipelineManager::HashPipelineDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc) {
+	unsigned long long hash = HashRootSig(desc->pRootSignature, HashBytes(nullptr, 0));
+
+	D3D12_SHADER_BYTECODE* shaders[] = { &desc->VS, &desc->PS, &desc->DS, &desc->HS, &desc->GS };
+	for (auto bc : shaders) {
+		hash = HashBytes(&bc->BytecodeLength, sizeof(bc->BytecodeLength), hash);
+		hash = HashBytes(bc->pShaderBytecode, bc->BytecodeLength, hash);
+	}
+
+	// D3D12_RENDER_TARGET_BLEND_DESC has padding after the write mask, so hash the blend state a field at a time as well.
+	D3D12_BLEND_DESC& blend = desc->BlendState;
+	hash = HashBytes(&blend.AlphaToCoverageEnable, sizeof(blend.AlphaToCoverageEnable), hash);
+	hash = HashBytes(&blend.IndependentBlendEnable, sizeof(blend.IndependentBlendEnable), hash);
+	for (auto& rt : blend.RenderTarget) {
+		hash = HashBytes(&rt.BlendEnable, sizeof(rt.BlendEnable), hash);
+		hash = HashBytes(&rt.LogicOpEnable, sizeof(rt.LogicOpEnable), hash);
+		hash = HashBytes(&rt.SrcBlend, sizeof(rt.SrcBlend), hash);
+		hash = HashBytes(&rt.DestBlend, sizeof(rt.DestBlend), hash);
+		hash = HashBytes(&rt.BlendOp, sizeof(rt.BlendOp), hash);
+		hash = HashBytes(&rt.SrcBlendAlpha, sizeof(rt.SrcBlendAlpha), hash);
+		hash = HashBytes(&rt.DestBlendAlpha, sizeof(rt.DestBlendAlpha), hash);
+		hash = HashBytes(&rt.BlendOpAlpha, sizeof(rt.BlendOpAlpha), hash);
+		hash = HashBytes(&rt.LogicOp, sizeof(rt.LogicOp), hash);
+		hash = HashBytes(&rt.RenderTargetWriteMask, sizeof(rt.RenderTargetWriteMask), hash);
+	}
+	hash = HashBytes(&desc->SampleMask, sizeof(desc->SampleMask), hash);
+	hash = HashBytes(&desc->RasterizerState, sizeof(desc->RasterizerState), hash);
+
+	// D3D12_DEPTH_STENCIL_DESC has padding after the stencil masks, so hash it a field at a time.
+	D3D12_DEPTH_STENCIL_DESC& ds = desc->DepthStencilState;
+	hash = HashBytes(&ds.DepthEnable, sizeof(ds.DepthEnable), hash);
+	hash = HashBytes(&ds.DepthWriteMask, sizeof(ds.DepthWriteMask), hash);
+	hash = HashBytes(&ds.DepthFunc, sizeof(ds.DepthFunc), hash);
+	hash = HashBytes(&ds.StencilEnable, sizeof(ds.StencilEnable), hash);
+	hash = HashBytes(&ds.StencilReadMask, sizeof(ds.StencilReadMask), hash);
+	hash = HashBytes(&ds.StencilWriteMask, sizeof(ds.StencilWriteMask), hash);
+	hash = HashBytes(&ds.FrontFace, sizeof(ds.FrontFace), hash);
+	hash = HashBytes(&ds.BackFace, sizeof(ds.BackFace), hash);
+
+	for (auto i = 0u; i < desc->InputLayout.NumElements; ++i) {
+		const D3D12_INPUT_ELEMENT_DESC& e = desc->InputLayout.pInputElementDescs[i];
+		hash = HashBytes(e.SemanticName, strlen(e.SemanticName), hash);
+		hash = HashBytes(&e.SemanticIndex, sizeof(e.SemanticIndex), hash);
+		hash = HashBytes(&e.Format, sizeof(e.Format), hash);
+		hash = HashBytes(&e.InputSlot, sizeof(e.InputSlot), hash);
+		hash = HashBytes(&e.AlignedByteOffset, sizeof(e.AlignedByteOffset), hash);
+		hash = HashBytes(&e.InputSlotClass, sizeof(e.InputSlotClass), hash);
+		hash = HashBytes(&e.InstanceDataStepRate, sizeof(e.InstanceDataStepRate), hash);
+	}
+
+	hash = HashBytes(&desc->IBStripCutValue, sizeof(desc->IBStripCutValue), hash);
+	hash = HashBytes(&desc->PrimitiveTopologyType, sizeof(desc->PrimitiveTopologyType), hash);
+	hash = HashBytes(&desc->NumRenderTargets, sizeof(desc->NumRenderTargets), hash);
+	hash = HashBytes(desc->RTVFormats, sizeof(desc->RTVFormats), hash);
+	hash = HashBytes(&desc->DSVFormat, sizeof(desc->DSVFormat), hash);
+	hash = HashBytes(&desc->SampleDesc, sizeof(desc->SampleDesc), hash);
+	hash = HashBytes(&desc->NodeMask, sizeof(desc->NodeMask), hash);
+	hash = HashBytes(&desc->Flags, sizeof(desc->Flags), hash);
+
+	return hash;
+}
+
+// Hash all of the data that affects the compiled compute pipeline.
+unsigned long long PipelineManager::HashPipelineDesc(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc) {
+	// tag compute pipelines so they can never collide with a graphics pipeline.
+	const char tag[] = "compute";
+	unsigned long long hash = HashRootSig(desc->pRootSignature, HashBytes(tag, sizeof(tag)));
+
+	hash = HashBytes(&desc->CS.BytecodeLength, sizeof(desc->CS.BytecodeLength), hash);
+	hash = HashBytes(desc->CS.pShaderBytecode, desc->CS.BytecodeLength, hash);
+	hash = HashBytes(&desc->NodeMask, sizeof(desc->NodeMask), hash);
+	hash = HashBytes(&desc->Flags, sizeof(desc->Flags), hash);
+
+	return hash;
+}
+
+// Look up the hash of the root signature, as its pointer changes from run to run.
+unsigned long long PipelineManager::HashRootSig(ID3D12RootSignature* root, unsigned long long hash) {
+	for (auto& entry : m_listRootSigs) {
+		if (entry.pRootSig == root) {
+			return HashBytes(&entry.hash, sizeof(entry.hash), hash);
+		}
+	}
+
+	return hash;
+}
+
+// Deep copy the description so that it can outlive the caller's stack.
+PipelineDesc* PipelineManager::CopyPipelineDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc) {
+	PipelineDesc* pDesc = new PipelineDesc;
+	pDesc->desc = *desc;
+	pDesc->descCompute = {};
+	pDesc->isCompute = false;
+	pDesc->fromCache = false;
+	pDesc->msBuild = 0.0;
+
+	// semantic names are expected to be string literals, so the pointers are safe to keep.
+	pDesc->elements.assign(desc->InputLayout.pInputElementDescs, desc->InputLayout.pInputElementDescs + desc->InputLayout.NumElements);
+	pDesc->desc.InputLayout.pInputElementDescs = pDesc->elements.empty() ? nullptr : pDesc->elements.data();
+
+	D3D12_SHADER_BYTECODE* shaders[] = { &pDesc->desc.VS, &pDesc->desc.PS, &pDesc->desc.DS, &pDesc->desc.HS, &pDesc->desc.GS };
+	for (int i = 0; i < 5; ++i) {
+		const unsigned char* bc = (const unsigned char*)shaders[i]->pShaderBytecode;
+		pDesc->bytecode[i].assign(bc, bc + shaders[i]->BytecodeLength);
+		shaders[i]->pShaderBytecode = pDesc->bytecode[i].empty() ? nullptr : pDesc->bytecode[i].data();
+	}
+
+	pDesc->desc.CachedPSO.pCachedBlob = nullptr;
+	pDesc->desc.CachedPSO.CachedBlobSizeInBytes = 0;
+
+	return pDesc;
+}
+
+// Deep copy the compute description so that it can outlive the caller's stack.
+PipelineDesc* PipelineManager::CopyPipelineDesc(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc) {
+	PipelineDesc* pDesc = new PipelineDesc;
+	pDesc->desc = {};
+	pDesc->descCompute = *desc;
+	pDesc->isCompute = true;
+	pDesc->fromCache = false;
+	pDesc->msBuild = 0.0;
+
+	const unsigned char* bc = (const unsigned char*)desc->CS.pShaderBytecode;
+	pDesc->bytecode[0].assign(bc, bc + desc->CS.BytecodeLength);
+	pDesc->descCompute.CS.pShaderBytecode = pDesc->bytecode[0].empty() ? nullptr : pDesc->bytecode[0].data();
+
+	pDesc->descCompute.CachedPSO.pCachedBlob = nullptr;
+	pDesc->descCompute.CachedPSO.CachedBlobSizeInBytes = 0;
+
+	return pDesc;
+}
+
+// Queue creation of a pipeline matching the description on a worker thread and return its handle.
+unsigned int PipelineManager::RequestPipeline(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc) {
+	unsigned long long hash = HashPipelineDesc(desc);
+
+	for (auto i = 0u; i < m_listPipelines.size(); ++i) {
+		if (m_listPipelines[i].hash == hash) {
+			return i;
+		}
+	}
+
+	return QueuePipeline(hash, CopyPipelineDesc(desc));
+}
+
+// Queue creation of a compute pipeline matching the description on a worker thread and return its handle.
+unsigned int PipelineManager::RequestComputePipeline(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc) {
+	unsigned long long hash = HashPipelineDesc(desc);
+
+	for (auto i = 0u; i < m_listPipelines.size(); ++i) {
+		if (m_listPipelines[i].hash == hash) {
+			return i;
+		}
+	}
+
+	return QueuePipeline(hash, CopyPipelineDesc(desc));
+}
+
+// Find a cached blob for the pipeline, start building it on a worker thread, and return its handle.
+unsigned int PipelineManager::QueuePipeline(unsigned long long hash, PipelineDesc* pDesc) {
+	PipelineEntry entry;
+	entry.hash = hash;
+	entry.pPSO = nullptr;
+	entry.pDesc = pDesc;
+
+	for (auto& blob : m_listCachedBlobs) {
+		if (blob.first == hash) {
+			entry.pDesc->cache = blob.second;
+			break;
+		}
+	}
+	if (entry.pDesc->cache.empty()) {
+		// this pipeline wasn't in the cache, so it will need to be saved on shutdown.
+		m_isCacheDirty = true;
+	}
+
+	entry.future = std::async(std::launch::async, &PipelineManager::BuildPipeline, m_pDev, entry.pDesc).share();
+	m_listPipelines.push_back(entry);
+
+	return (unsigned int)m_listPipelines.size() - 1;
+}
+
+// Runs on a worker thread. Attempts to build from the cached blob first and falls back to a full compile.
+ID3D12PipelineState* PipelineManager::BuildPipeline(Device* dev, PipelineDesc* pDesc) {
+	auto tStart = std::chrono::high_resolution_clock::now();
+	ID3D12PipelineState* pso = nullptr;
+
+	D3D12_CACHED_PIPELINE_STATE& cached = pDesc->isCompute ? pDesc->descCompute.CachedPSO : pDesc->desc.CachedPSO;
+
+	if (!pDesc->cache.empty()) {
+		cached.pCachedBlob = pDesc->cache.data();
+		cached.CachedBlobSizeInBytes = pDesc->cache.size();
+		try {
+			if (pDesc->isCompute) {
+				dev->CreateComputePSO(&pDesc->descCompute, pso);
+			} else {
+				dev->CreatePSO(&pDesc->desc, pso);
+			}
+			pDesc->fromCache = true;
+		} catch (GFX_Exception&) {
+			// the driver or adapter has changed since the blob was saved. Fall back to a full compile.
+			pso = nullptr;
+		}
+		cached.pCachedBlob = nullptr;
+		cached.CachedBlobSizeInBytes = 0;
+	}
+
+	if (!pso) {
+		if (pDesc->isCompute) {
+			dev->CreateComputePSO(&pDesc->descCompute, pso);
+		} else {
+			dev->CreatePSO(&pDesc->desc, pso);
+		}
+	}
+
+	pDesc->msBuild = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	return pso;
+}
+
+// Return the PSO for the provided handle. Blocks until the PSO is ready.
+ID3D12PipelineState* PipelineManager::GetPipeline(unsigned int handle) {
+	if (handle >= m_listPipelines.size()) {
+		std::string msg = "PipelineManager::GetPipeline failed due to handle " + std::to_string(handle) + " out of bounds.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	PipelineEntry& entry = m_listPipelines[handle];
+	if (!entry.pPSO) {
+		// rethrows any GFX_Exception thrown on the worker thread.
+		entry.pPSO = entry.future.get();
+		if (!entry.pDesc->fromCache) {
+			// cached blobs that failed to load need to be replaced.
+			m_isCacheDirty = true;
+		}
+	}
+
+	return entry.pPSO;
+}
+
+// Block until every requested PSO has been created.
+void PipelineManager::WaitForPipelines() {
+	for (auto i = 0u; i < m_listPipelines.size(); ++i) {
+		GetPipeline(i);
+	}
+}
+
+// Write cold/warm cache startup metrics to the debug output.
+void PipelineManager::ReportMetrics() {
+	WaitForPipelines();
+
+	double msTotal = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_tStart).count();
+	double msWarm = 0.0, msCold = 0.0;
+	unsigned int numWarm = 0, numCold = 0;
+	for (auto& entry : m_listPipelines) {
+		if (entry.pDesc->fromCache) {
+			++numWarm;
+			msWarm += entry.pDesc->msBuild;
+		} else {
+			++numCold;
+			msCold += entry.pDesc->msBuild;
+		}
+	}
+
+	std::string msg = "PipelineManager: " + std::to_string(m_listPipelines.size()) + " pipelines ready " +
+		std::to_string(msTotal) + " ms after startup. " +
+		std::to_string(numWarm) + " warm (" + std::to_string(msWarm) + " ms on workers), " +
+		std::to_string(numCold) + " cold (" + std::to_string(msCold) + " ms on workers).\n";
+	OutputDebugStringA(msg.c_str());
+}
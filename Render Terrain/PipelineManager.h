@@ -0,0 +1,109 @@
+/*
+PipelineManager.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for creating, caching, and persisting Direct3D 12 Pipeline State Objects.
+
+Usage:			- Proper shutdown is handled by the destructor.
+				- Requires a pointer to a Device object be passed in.
+				- Call RequestPipeline() with a filled in pipeline description. The description is
+					copied and the PSO is created on a worker thread. Returns a handle to the pipeline.
+				- Identical descriptions hash to the same handle, so the PSO is only ever built once.
+				- Call RequestComputePipeline() for compute pipelines. Handles are shared with graphics pipelines.
+				- Call GetPipeline() with a handle to retrieve the PSO. Blocks until it has been built.
+				- Call CreateRootSig() to create root signatures. Identical signatures are shared.
+				- Driver compiled pipelines are saved to the cache file by SaveCache() and the
+					destructor and are handed back to the driver on the next launch.
+				- Startup metrics are written to the debug output by ReportMetrics().
+
+Future Work:	- Replace the per-PSO cached blobs with ID3D12PipelineLibrary once the SDK supports it.
+*/
+#pragma once
+
+#include "Graphics.h"
+#include <vector>
+#include <string>
+#include <future>
+#include <chrono>
+
+using namespace graphics;
+
+static const char* DEFAULT_PIPELINE_CACHE_FILE = "PipelineCache.bin";
+
+// A deep copy of a graphics pipeline description.
+// D3D12_GRAPHICS_PIPELINE_STATE_DESC only holds pointers to shaders and input layouts, which usually
+// live on the caller's stack, so we need our own copy before handing it off to a worker thread.
+struct PipelineDesc {
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC		desc;
+	D3D12_COMPUTE_PIPELINE_STATE_DESC		descCompute;	// only used if isCompute is set.
+	bool									isCompute;
+	std::vector<D3D12_INPUT_ELEMENT_DESC>	elements;
+	std::vector<unsigned char>				bytecode[5];	// VS, PS, DS, HS, GS. Compute pipelines keep their CS in the first slot.
+	std::vector<unsigned char>				cache;			// driver compiled blob from a previous run, if any.
+	bool									fromCache;		// was the PSO built from the cached blob?
+	double									msBuild;		// how long it took the worker thread to build the PSO.
+};
+
+struct PipelineEntry {
+	unsigned long long						hash;
+	PipelineDesc*							pDesc;
+	ID3D12PipelineState*					pPSO;
+	std::shared_future<ID3D12PipelineState*> future;
+};
+
+struct RootSigEntry {
+	unsigned long long		hash;
+	ID3D12RootSignature*	pRootSig;
+};
+
+// 64 bit FNV-1a hash. Used to key pipelines and root signatures by their description.
+unsigned long long HashBytes(const void* data, size_t size, unsigned long long hash = 14695981039346656037ULL);
+
+class PipelineManager {
+public:
+	PipelineManager(Device* dev, const char* fnCache = DEFAULT_PIPELINE_CACHE_FILE);
+	~PipelineManager();
+
+	// Create a root signature matching the description, or return the existing one if it was already created.
+	ID3D12RootSignature* CreateRootSig(CD3DX12_ROOT_SIGNATURE_DESC* desc);
+	// Queue creation of a pipeline matching the description on a worker thread and return its handle.
+	unsigned int RequestPipeline(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc);
+	// Queue creation of a compute pipeline matching the description on a worker thread and return its handle.
+	unsigned int RequestComputePipeline(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc);
+	// Return the PSO for the provided handle. Blocks until the PSO is ready.
+	ID3D12PipelineState* GetPipeline(unsigned int handle);
+	// Block until every requested PSO has been created.
+	void WaitForPipelines();
+	// Write any newly compiled pipelines to the cache file.
+	void SaveCache();
+	// Write cold/warm cache startup metrics to the debug output.
+	void ReportMetrics();
+
+private:
+	// Load the cache file into m_listCachedBlobs.
+	void LoadCache();
+	// Hash all of the data that affects the compiled pipeline. Pointers are followed, not hashed.
+	unsigned long long HashPipelineDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc);
+	// Hash all of the data that affects the compiled compute pipeline.
+	unsigned long long HashPipelineDesc(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc);
+	// Look up the hash of the root signature, as its pointer changes from run to run.
+	unsigned long long HashRootSig(ID3D12RootSignature* root, unsigned long long hash);
+	// Deep copy the description so that it can outlive the caller's stack.
+	PipelineDesc* CopyPipelineDesc(D3D12_GRAPHICS_PIPELINE_STATE_DESC* desc);
+	// Deep copy the compute description so that it can outlive the caller's stack.
+	PipelineDesc* CopyPipelineDesc(D3D12_COMPUTE_PIPELINE_STATE_DESC* desc);
+	// Find a cached blob for the pipeline, start building it on a worker thread, and return its handle.
+	unsigned int QueuePipeline(unsigned long long hash, PipelineDesc* pDesc);
+	// Runs on a worker thread. Attempts to build from the cached blob first and falls back to a full compile.
+	static ID3D12PipelineState* BuildPipeline(Device* dev, PipelineDesc* pDesc);
+
+	Device*														m_pDev;
+	std::string													m_fnCache;
+	std::vector<PipelineEntry>									m_listPipelines;
+	std::vector<RootSigEntry>									m_listRootSigs;
+	std::vector<std::pair<unsigned long long, std::vector<unsigned char>>> m_listCachedBlobs;	// blobs loaded from disk.
+	std::chrono::time_point<std::chrono::high_resolution_clock>	m_tStart;
+	bool														m_isCacheDirty;
+};
@@ -0,0 +1,339 @@
+/*
+RenderGraph.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	A small render graph that orders passes, derives and batches their barriers, and aliases transient resources.
+*/
+#include "RenderGraph.h"
+#include <algorithm>
+
+RenderGraph::RenderGraph() {
+	m_stats = {};
+	m_sizeHeap = 0;
+	m_isPlaced = false;
+	m_listBatches.resize(1);
+}
+
+// Add a resource to the graph and return its index.
+unsigned int RenderGraph::AddResource(const RenderGraphResourceDesc& desc) {
+	Resource res;
+	res.desc = desc;
+	res.name = desc.name ? desc.name : "";
+	res.desc.name = nullptr;
+	res.offset = 0;
+	res.state = desc.initialState;
+	res.stateEnd = desc.initialState;
+	res.first = -1;
+	res.last = -1;
+
+	m_listResources.push_back(res);
+	return (unsigned int)m_listResources.size() - 1;
+}
+
+// Add a pass and return its index. execute is called by Execute() to record the pass.
+unsigned int RenderGraph::AddPass(const char* name, std::function<void()> execute) {
+	Pass pass;
+	pass.name = name ? name : "";
+	pass.execute = execute;
+
+	m_listPasses.push_back(pass);
+	return (unsigned int)m_listPasses.size() - 1;
+}
+
+// Declare that pass reads resource in state. Reads of the same resource by a pass are combined.
+void RenderGraph::Read(unsigned int pass, unsigned int resource, unsigned int state) {
+	AddUsage(pass, resource, state, false);
+}
+
+// Declare that pass writes resource in state.
+void RenderGraph::Write(unsigned int pass, unsigned int resource, unsigned int state) {
+	AddUsage(pass, resource, state, true);
+}
+
+// Add a use of resource by pass, combining it with any earlier use by the same pass.
+// Mistakes are remembered and reported by the next Compile().
+void RenderGraph::AddUsage(unsigned int pass, unsigned int resource, unsigned int state, bool isWrite) {
+	if (pass >= m_listPasses.size() || resource >= m_listResources.size()) {
+		if (m_strError.empty()) m_strError = "RenderGraph: pass or resource index out of bounds.";
+		return;
+	}
+
+	auto& usages = m_listPasses[pass].usages;
+	for (auto it = usages.begin(); it != usages.end(); ++it) {
+		if (it->resource != resource) continue;
+
+		// read states can be combined. Anything else has to match exactly.
+		if (!it->isWrite && !isWrite && !((it->state | state) & RG_STATE_WRITE_MASK)) {
+			it->state |= state;
+		} else if (it->state == state) {
+			it->isWrite = it->isWrite || isWrite;
+		} else if (m_strError.empty()) {
+			m_strError = "RenderGraph: pass " + m_listPasses[pass].name + " uses " + m_listResources[resource].name + " in two different states.";
+		}
+		return;
+	}
+
+	Usage use = { resource, state, isWrite };
+	usages.push_back(use);
+}
+
+// Remove every pass, keeping the resources, their states, and the placement of the transient resources.
+void RenderGraph::ResetPasses() {
+	m_listPasses.clear();
+	m_listOrder.clear();
+	m_listBatches.clear();
+	m_listBatches.resize(1);
+	m_strError.clear();
+}
+
+// Choose which passes run. Working back from the end, a pass runs if it writes nothing the graph tracks,
+// writes an imported resource, or writes a transient resource a later pass that runs reads.
+void RenderGraph::CullPasses() {
+	std::vector<bool> isNeeded(m_listResources.size(), false);
+	std::vector<bool> isKept(m_listPasses.size(), false);
+
+	for (unsigned int i = 0; i < m_listResources.size(); ++i) {
+		isNeeded[i] = !m_listResources[i].desc.isTransient;
+	}
+
+	for (int p = (int)m_listPasses.size() - 1; p >= 0; --p) {
+		auto& usages = m_listPasses[p].usages;
+		bool hasWrites = false;
+		for (auto it = usages.begin(); it != usages.end(); ++it) {
+			if (!it->isWrite) continue;
+			hasWrites = true;
+			if (isNeeded[it->resource]) isKept[p] = true;
+		}
+		if (!hasWrites) isKept[p] = true;
+		if (!isKept[p]) continue;
+
+		for (auto it = usages.begin(); it != usages.end(); ++it) {
+			if (!it->isWrite) isNeeded[it->resource] = true;
+		}
+	}
+
+	m_listOrder.clear();
+	for (unsigned int p = 0; p < m_listPasses.size(); ++p) {
+		if (isKept[p]) m_listOrder.push_back(p);
+	}
+}
+
+// Returns true if transient resources a and b are placed in overlapping memory.
+bool RenderGraph::IsMemoryShared(unsigned int a, unsigned int b) {
+	auto& ra = m_listResources[a];
+	auto& rb = m_listResources[b];
+	return ra.offset < rb.offset + rb.desc.size && rb.offset < ra.offset + ra.desc.size;
+}
+
+// Returns true if the lifetimes of a and b overlap in the current order. Unused resources never overlap.
+bool RenderGraph::IsLifetimeShared(unsigned int a, unsigned int b) {
+	auto& ra = m_listResources[a];
+	auto& rb = m_listResources[b];
+	if (ra.first < 0 || rb.first < 0) return false;
+	return ra.first <= rb.last && rb.first <= ra.last;
+}
+
+// Give every transient resource an offset in the shared heap, reusing memory between resources that are never live at the same time.
+// Biggest first, each resource goes at the lowest offset clear of everything already placed that it is live alongside.
+// Resources the graph doesn't use yet can't be checked, so they get memory of their own.
+void RenderGraph::PlaceTransientResources() {
+	std::vector<unsigned int> listTransient;
+	for (unsigned int i = 0; i < m_listResources.size(); ++i) {
+		if (m_listResources[i].desc.isTransient) listTransient.push_back(i);
+	}
+	std::stable_sort(listTransient.begin(), listTransient.end(), [this](unsigned int a, unsigned int b) {
+		return m_listResources[a].desc.size > m_listResources[b].desc.size;
+	});
+
+	m_sizeHeap = 0;
+	std::vector<unsigned int> listPlaced;
+	for (auto it = listTransient.begin(); it != listTransient.end(); ++it) {
+		Resource& res = m_listResources[*it];
+		unsigned long long alignment = res.desc.alignment ? res.desc.alignment : 1;
+
+		// resources can't share memory if they are live together, or if either of them isn't used yet.
+		std::vector<unsigned int> listConflicts;
+		for (auto itPlaced = listPlaced.begin(); itPlaced != listPlaced.end(); ++itPlaced) {
+			if (res.first < 0 || m_listResources[*itPlaced].first < 0 || IsLifetimeShared(*it, *itPlaced)) listConflicts.push_back(*itPlaced);
+		}
+
+		// the candidates are the start of the heap and the end of every resource it conflicts with.
+		std::vector<unsigned long long> listCandidates;
+		listCandidates.push_back(0);
+		for (auto itConflict = listConflicts.begin(); itConflict != listConflicts.end(); ++itConflict) {
+			listCandidates.push_back(m_listResources[*itConflict].offset + m_listResources[*itConflict].desc.size);
+		}
+		std::sort(listCandidates.begin(), listCandidates.end());
+
+		for (auto itCandidate = listCandidates.begin(); itCandidate != listCandidates.end(); ++itCandidate) {
+			res.offset = (*itCandidate + alignment - 1) / alignment * alignment;
+
+			bool isClear = true;
+			for (auto itConflict = listConflicts.begin(); itConflict != listConflicts.end(); ++itConflict) {
+				if (IsMemoryShared(*it, *itConflict)) {
+					isClear = false;
+					break;
+				}
+			}
+			if (isClear) break;
+		}
+
+		listPlaced.push_back(*it);
+		if (res.offset + res.desc.size > m_sizeHeap) m_sizeHeap = res.offset + res.desc.size;
+	}
+
+	m_isPlaced = true;
+}
+
+// Add the barriers that move resource i through its uses.
+void RenderGraph::DeriveBarriers(unsigned int i) {
+	Resource& res = m_listResources[i];
+
+	// positions in m_listOrder and states of each use, in order.
+	std::vector<std::pair<int, unsigned int>> listUses;
+	for (unsigned int o = 0; o < m_listOrder.size(); ++o) {
+		auto& usages = m_listPasses[m_listOrder[o]].usages;
+		for (auto it = usages.begin(); it != usages.end(); ++it) {
+			if (it->resource == i) listUses.push_back(std::make_pair((int)o, it->state));
+		}
+	}
+
+	// imported resources go back to their final state after the last pass.
+	int iEnd = (int)m_listOrder.size();
+	if (!res.desc.isTransient) listUses.push_back(std::make_pair(iEnd, res.desc.finalState));
+
+	// a transient resource sharing memory takes it over with an aliasing barrier, from whichever resource used it last.
+	// It can't be transitioned before then, as transitions may touch the memory.
+	bool isAliased = false;
+	if (res.desc.isTransient && res.first >= 0) {
+		unsigned int before = RG_NO_RESOURCE;
+		int lastBefore = -1;
+		for (unsigned int j = 0; j < m_listResources.size(); ++j) {
+			if (j == i || !m_listResources[j].desc.isTransient || !IsMemoryShared(i, j)) continue;
+			isAliased = true;
+			if (m_listResources[j].last >= 0 && m_listResources[j].last < res.first && m_listResources[j].last > lastBefore) {
+				lastBefore = m_listResources[j].last;
+				before = j;
+			}
+		}
+
+		if (isAliased) {
+			RenderGraphBarrier barrier = { RG_BARRIER_ALIASING, RG_SPLIT_NONE, i, before, 0, 0 };
+			auto& batch = m_listBatches[res.first];
+			batch.insert(batch.begin(), barrier);
+			++m_stats.numAliasingBarriers;
+		}
+	}
+
+	int iPrev = -1;
+	unsigned int statePrev = res.state;
+	for (auto it = listUses.begin(); it != listUses.end(); ++it) {
+		int iUse = it->first;
+		unsigned int state = it->second;
+
+		if (state != statePrev) {
+			RenderGraphBarrier barrier = { RG_BARRIER_TRANSITION, RG_SPLIT_NONE, i, RG_NO_RESOURCE, statePrev, state };
+			bool isSplit = iUse - iPrev > 1 && !(isAliased && iPrev < 0);
+			if (isSplit) {
+				barrier.split = RG_SPLIT_BEGIN;
+				m_listBatches[iPrev + 1].push_back(barrier);
+				barrier.split = RG_SPLIT_END;
+				++m_stats.numSplitBarriers;
+			}
+			m_listBatches[iUse].push_back(barrier);
+		} else if (state == RG_STATE_UNORDERED_ACCESS && iPrev >= 0 && iUse < iEnd) {
+			// back to back unordered access still has to wait for the earlier writes.
+			RenderGraphBarrier barrier = { RG_BARRIER_UAV, RG_SPLIT_NONE, i, RG_NO_RESOURCE, state, state };
+			m_listBatches[iUse].push_back(barrier);
+		}
+
+		iPrev = iUse;
+		statePrev = state;
+	}
+
+	res.stateEnd = statePrev;
+}
+
+// Work out the order of the passes, the barriers between them, and, the first time, the placement of the transient resources.
+// Returns false if the passes don't make sense together, ie a transient resource is read before it is written.
+// GetError() says why.
+bool RenderGraph::Compile() {
+	if (!m_strError.empty()) return false;
+
+	CullPasses();
+
+	// find the lifetime of every resource and check transient resources are written before they are read.
+	for (auto it = m_listResources.begin(); it != m_listResources.end(); ++it) {
+		it->first = -1;
+		it->last = -1;
+	}
+	for (unsigned int o = 0; o < m_listOrder.size(); ++o) {
+		auto& usages = m_listPasses[m_listOrder[o]].usages;
+		for (auto it = usages.begin(); it != usages.end(); ++it) {
+			Resource& res = m_listResources[it->resource];
+			if (res.first < 0) {
+				if (res.desc.isTransient && !it->isWrite) {
+					m_strError = "RenderGraph: transient resource " + res.name + " is read by pass " + m_listPasses[m_listOrder[o]].name +
+						" before anything writes it.";
+					return false;
+				}
+				res.first = o;
+			}
+			res.last = o;
+		}
+	}
+
+	if (!m_isPlaced) {
+		PlaceTransientResources();
+	} else {
+		// later graphs reuse the placement, which only holds if resources sharing memory are still never live together.
+		for (unsigned int i = 0; i < m_listResources.size(); ++i) {
+			for (unsigned int j = i + 1; j < m_listResources.size(); ++j) {
+				if (!m_listResources[i].desc.isTransient || !m_listResources[j].desc.isTransient) continue;
+				if (IsMemoryShared(i, j) && IsLifetimeShared(i, j)) {
+					m_strError = "RenderGraph: transient resources " + m_listResources[i].name + " and " + m_listResources[j].name +
+						" share memory but are live at the same time.";
+					return false;
+				}
+			}
+		}
+	}
+
+	m_stats = {};
+	m_listBatches.clear();
+	m_listBatches.resize(m_listOrder.size() + 1);
+	for (unsigned int i = 0; i < m_listResources.size(); ++i) {
+		DeriveBarriers(i);
+	}
+
+	m_stats.numPasses = (unsigned int)m_listOrder.size();
+	m_stats.numPassesCulled = (unsigned int)(m_listPasses.size() - m_listOrder.size());
+	for (auto it = m_listBatches.begin(); it != m_listBatches.end(); ++it) {
+		m_stats.numBarriers += (unsigned int)it->size();
+		if (!it->empty()) ++m_stats.numBatches;
+	}
+	for (auto it = m_listResources.begin(); it != m_listResources.end(); ++it) {
+		if (it->desc.isTransient) m_stats.sizeTransient += it->desc.size;
+	}
+	m_stats.sizeHeap = m_sizeHeap;
+
+	return true;
+}
+
+// Run the compiled passes in order, calling issue with each batch of barriers ahead of the pass it belongs to.
+// The last batch goes out after the last pass. The resources move on to the states they end the graph in.
+void RenderGraph::Execute(const std::function<void(const RenderGraphBarrier*, unsigned int)>& issue) {
+	for (unsigned int o = 0; o < m_listOrder.size(); ++o) {
+		if (!m_listBatches[o].empty()) issue(m_listBatches[o].data(), (unsigned int)m_listBatches[o].size());
+		if (m_listPasses[m_listOrder[o]].execute) m_listPasses[m_listOrder[o]].execute();
+	}
+
+	auto& batchEnd = m_listBatches[m_listOrder.size()];
+	if (!batchEnd.empty()) issue(batchEnd.data(), (unsigned int)batchEnd.size());
+
+	for (auto it = m_listResources.begin(); it != m_listResources.end(); ++it) {
+		it->state = it->stateEnd;
+	}
+}
@@ -0,0 +1,174 @@
+/*
+RenderGraph.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	A small render graph. Passes declare which resources they read and write and in which state,
+				and the graph works out the order to run them in, the barriers between them, and where
+				transient resources can share memory. Plain C++ so it can be used and checked without a
+				Direct3D 12 device. See RenderGraphResources.h for the Direct3D 12 side.
+
+Usage:			- Call AddResource() for every resource the graph tracks. Transient resources only live for
+					part of a frame and are given an offset in a shared heap. The rest are imported.
+				- Call AddPass() for every pass, in submission order, followed by Read() and Write() for
+					each resource it touches. A pass that writes nothing is assumed to have side effects
+					and always runs. A pass whose only writes are to transient resources nobody reads is culled.
+				- Call Compile() and then Execute(). Execute() runs the passes in order and hands each batch of
+					barriers to the provided function, so every batch can go out as a single ResourceBarrier().
+				- Barriers between uses that are more than one pass apart are split. The begin half goes out right
+					after the first use and the end half right before the second.
+				- Transient resources are placed by the first Compile(), so the first graph should declare every
+					pass a frame can have. Call ResetPasses() before declaring the next frame's passes.
+					Leaving passes out only shortens lifetimes, which never makes the placement invalid.
+				- Transient resources that share memory get an aliasing barrier before their first use, so that
+					first use must overwrite the whole resource, ie clear it.
+				- Resources keep their state from one graph to the next. Imported resources are returned to their
+					final state at the end of every graph. Transient resources are left in the state of their last use.
+				- GetStats() returns the barrier counts and how much memory aliasing saved.
+
+Future Work:	- Reorder passes to put more distance between split barriers.
+				- Place transient resources again when a frame needs a pass the first graph didn't have.
+*/
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// Resource states. The values match D3D12_RESOURCE_STATES so they can be passed straight through.
+enum RenderGraphState {
+	RG_STATE_COMMON = 0,
+	RG_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+	RG_STATE_INDEX_BUFFER = 0x2,
+	RG_STATE_RENDER_TARGET = 0x4,
+	RG_STATE_UNORDERED_ACCESS = 0x8,
+	RG_STATE_DEPTH_WRITE = 0x10,
+	RG_STATE_DEPTH_READ = 0x20,
+	RG_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	RG_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	RG_STATE_INDIRECT_ARGUMENT = 0x200,
+	RG_STATE_COPY_DEST = 0x400,
+	RG_STATE_COPY_SOURCE = 0x800,
+	RG_STATE_PRESENT = 0
+};
+
+// states that can't be combined with any other.
+static const unsigned int RG_STATE_WRITE_MASK = RG_STATE_RENDER_TARGET | RG_STATE_UNORDERED_ACCESS | RG_STATE_DEPTH_WRITE | RG_STATE_COPY_DEST;
+// stands in for "no resource", ie the resource before an aliasing barrier when it could be any of them.
+static const unsigned int RG_NO_RESOURCE = 0xffffffff;
+
+struct RenderGraphResourceDesc {
+	const char*			name;
+	unsigned long long	size;			// bytes. Only used for transient resources.
+	unsigned long long	alignment;
+	unsigned int		initialState;	// state the resource is in before the first graph.
+	unsigned int		finalState;		// state imported resources are returned to at the end of every graph.
+	bool				isTransient;
+};
+
+enum RenderGraphBarrierType { RG_BARRIER_TRANSITION = 0, RG_BARRIER_ALIASING, RG_BARRIER_UAV };
+enum RenderGraphBarrierSplit { RG_SPLIT_NONE = 0, RG_SPLIT_BEGIN, RG_SPLIT_END };
+
+struct RenderGraphBarrier {
+	RenderGraphBarrierType	type;
+	RenderGraphBarrierSplit	split;
+	unsigned int			resource;			// the resource after, for aliasing barriers.
+	unsigned int			resourceBefore;		// aliasing barriers only. May be RG_NO_RESOURCE.
+	unsigned int			stateBefore;		// transitions only.
+	unsigned int			stateAfter;
+};
+
+struct RenderGraphStats {
+	unsigned int		numPasses;				// passes run by the last Compile().
+	unsigned int		numPassesCulled;
+	unsigned int		numBarriers;
+	unsigned int		numBatches;				// ResourceBarrier() calls the barriers are grouped into.
+	unsigned int		numSplitBarriers;		// split transitions. Each is counted once, but issues a begin and an end.
+	unsigned int		numAliasingBarriers;
+	unsigned long long	sizeTransient;			// bytes the transient resources would take up on their own.
+	unsigned long long	sizeHeap;				// bytes they take up sharing the heap.
+};
+
+class RenderGraph {
+public:
+	RenderGraph();
+
+	// Add a resource to the graph and return its index.
+	unsigned int AddResource(const RenderGraphResourceDesc& desc);
+	// Add a pass and return its index. execute is called by Execute() to record the pass.
+	unsigned int AddPass(const char* name, std::function<void()> execute);
+	// Declare that pass reads resource in state. Reads of the same resource by a pass are combined.
+	void Read(unsigned int pass, unsigned int resource, unsigned int state);
+	// Declare that pass writes resource in state.
+	void Write(unsigned int pass, unsigned int resource, unsigned int state);
+	// Remove every pass, keeping the resources, their states, and the placement of the transient resources.
+	void ResetPasses();
+
+	// Work out the order of the passes, the barriers between them, and, the first time, the placement of the transient resources.
+	// Returns false if the passes don't make sense together, ie a transient resource is read before it is written. GetError() says why.
+	bool Compile();
+	// Run the compiled passes in order, calling issue with each batch of barriers ahead of the pass it belongs to.
+	// The last batch goes out after the last pass. The resources move on to the states they end the graph in.
+	void Execute(const std::function<void(const RenderGraphBarrier*, unsigned int)>& issue);
+
+	// Returns the passes that survived culling, in the order they run.
+	const std::vector<unsigned int>& GetPassOrder() { return m_listOrder; }
+	// Returns the barriers issued ahead of the i'th pass in GetPassOrder(). i == GetPassOrder().size() is the batch after the last pass.
+	const std::vector<RenderGraphBarrier>& GetBarriers(unsigned int i) { return m_listBatches[i]; }
+	// Returns the offset in the shared heap of transient resource i.
+	unsigned long long GetResourceOffset(unsigned int i) { return m_listResources[i].offset; }
+	// Returns the size the shared heap for the transient resources needs to be.
+	unsigned long long GetHeapSize() { return m_sizeHeap; }
+	unsigned int GetNumResources() { return (unsigned int)m_listResources.size(); }
+	const RenderGraphResourceDesc& GetResourceDesc(unsigned int i) { return m_listResources[i].desc; }
+	const char* GetResourceName(unsigned int i) { return m_listResources[i].name.c_str(); }
+	const char* GetPassName(unsigned int i) { return m_listPasses[i].name.c_str(); }
+	const std::string& GetError() { return m_strError; }
+	RenderGraphStats GetStats() { return m_stats; }
+
+private:
+	struct Usage {
+		unsigned int	resource;
+		unsigned int	state;
+		bool			isWrite;
+	};
+
+	struct Pass {
+		std::string				name;
+		std::function<void()>	execute;
+		std::vector<Usage>		usages;
+	};
+
+	struct Resource {
+		RenderGraphResourceDesc	desc;
+		std::string				name;			// copied from desc, whose name is cleared.
+		unsigned long long		offset;			// in the shared heap. Transient resources only.
+		unsigned int			state;			// current state, carried from one graph to the next.
+		unsigned int			stateEnd;		// state at the end of the compiled graph.
+		int						first;			// position in m_listOrder of the first and last use. -1 if unused.
+		int						last;
+	};
+
+	// Add a use of resource by pass, combining it with any earlier use by the same pass.
+	void AddUsage(unsigned int pass, unsigned int resource, unsigned int state, bool isWrite);
+	// Choose which passes run.
+	void CullPasses();
+	// Give every transient resource an offset in the shared heap, reusing memory between resources that are never live at the same time.
+	void PlaceTransientResources();
+	// Returns true if transient resources a and b are placed in overlapping memory.
+	bool IsMemoryShared(unsigned int a, unsigned int b);
+	// Returns true if the lifetimes of a and b overlap in the current order. Unused resources never overlap.
+	bool IsLifetimeShared(unsigned int a, unsigned int b);
+	// Add the barriers that move resource i through its uses.
+	void DeriveBarriers(unsigned int i);
+
+	std::vector<Resource>							m_listResources;
+	std::vector<Pass>								m_listPasses;
+	std::vector<unsigned int>						m_listOrder;
+	std::vector<std::vector<RenderGraphBarrier>>	m_listBatches;		// one per pass in m_listOrder, plus one for the end.
+	std::string										m_strError;
+	RenderGraphStats								m_stats;
+	unsigned long long								m_sizeHeap;
+	bool											m_isPlaced;			// true once the transient resources have offsets.
+};
@@ -0,0 +1,130 @@
+/*
+RenderGraphResources.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	The Direct3D 12 resources behind a RenderGraph.
+*/
+#include "RenderGraphResources.h"
+#include <string>
+
+// the graph's states are passed straight through to Direct3D 12.
+static_assert(RG_STATE_RENDER_TARGET == D3D12_RESOURCE_STATE_RENDER_TARGET && RG_STATE_UNORDERED_ACCESS == D3D12_RESOURCE_STATE_UNORDERED_ACCESS &&
+	RG_STATE_DEPTH_WRITE == D3D12_RESOURCE_STATE_DEPTH_WRITE && RG_STATE_DEPTH_READ == D3D12_RESOURCE_STATE_DEPTH_READ &&
+	RG_STATE_NON_PIXEL_SHADER_RESOURCE == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE &&
+	RG_STATE_PIXEL_SHADER_RESOURCE == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE && RG_STATE_INDEX_BUFFER == D3D12_RESOURCE_STATE_INDEX_BUFFER &&
+	RG_STATE_VERTEX_AND_CONSTANT_BUFFER == D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER &&
+	RG_STATE_INDIRECT_ARGUMENT == D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT && RG_STATE_COPY_DEST == D3D12_RESOURCE_STATE_COPY_DEST &&
+	RG_STATE_COPY_SOURCE == D3D12_RESOURCE_STATE_COPY_SOURCE && RG_STATE_PRESENT == D3D12_RESOURCE_STATE_PRESENT,
+	"RenderGraphState must match D3D12_RESOURCE_STATES.");
+
+RenderGraphResources::RenderGraphResources(Device* dev, RenderGraph* graph) : m_pDev(dev), m_pGraph(graph) {
+	m_pHeap = nullptr;
+	m_sizeHeap = 0;
+	m_listResources.resize(m_pGraph->GetNumResources(), nullptr);
+	m_listIsOwned.resize(m_pGraph->GetNumResources(), false);
+}
+
+RenderGraphResources::~RenderGraphResources() {
+	// the placed resources go before the heap they live in.
+	for (unsigned int i = 0; i < m_listResources.size(); ++i) {
+		if (m_listIsOwned[i] && m_listResources[i]) {
+			m_listResources[i]->Release();
+		}
+		m_listResources[i] = nullptr;
+	}
+
+	if (m_pHeap) {
+		m_pHeap->Release();
+		m_pHeap = nullptr;
+	}
+
+	m_pDev = nullptr;
+	m_pGraph = nullptr;
+}
+
+// Create the heap the graph's transient resources share. flags must allow every kind of transient resource in the graph.
+void RenderGraphResources::CreateHeap(D3D12_HEAP_FLAGS flags) {
+	if (m_pHeap) {
+		throw GFX_Exception("RenderGraphResources::CreateHeap: the heap already exists.");
+	}
+
+	m_sizeHeap = m_pGraph->GetHeapSize();
+	if (m_sizeHeap == 0) return;
+
+	D3D12_HEAP_DESC descHeap = {};
+	descHeap.SizeInBytes = m_sizeHeap;
+	descHeap.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	descHeap.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	descHeap.Flags = flags;
+	m_pDev->CreateHeap(&descHeap, m_pHeap);
+	m_pHeap->SetName(L"Render Graph Transient Heap");
+}
+
+// Create transient resource i of the graph in the heap and return it. desc must match the size the graph was given.
+ID3D12Resource* RenderGraphResources::CreateTransient(unsigned int i, D3D12_RESOURCE_DESC* desc, D3D12_CLEAR_VALUE* clear) {
+	if (i >= m_listResources.size() || !m_pGraph->GetResourceDesc(i).isTransient) {
+		std::string msg = "RenderGraphResources::CreateTransient: resource " + std::to_string(i) + " isn't a transient resource of the graph.";
+		throw GFX_Exception(msg.c_str());
+	}
+	if (!m_pHeap) {
+		throw GFX_Exception("RenderGraphResources::CreateTransient: CreateHeap() must be called first.");
+	}
+	if (m_pDev->GetResourceAllocationSize(desc) > m_pGraph->GetResourceDesc(i).size) {
+		std::string msg = "RenderGraphResources::CreateTransient: resource " + std::string(m_pGraph->GetResourceName(i)) + " is larger than the graph was told.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	ID3D12Resource* res = nullptr;
+	m_pDev->CreatePlacedResource(m_pHeap, m_pGraph->GetResourceOffset(i), desc,
+		(D3D12_RESOURCE_STATES)m_pGraph->GetResourceDesc(i).initialState, clear, res);
+
+	if (m_listIsOwned[i] && m_listResources[i]) {
+		m_listResources[i]->Release();
+	}
+	m_listResources[i] = res;
+	m_listIsOwned[i] = true;
+
+	return res;
+}
+
+// Point imported resource i of the graph at res.
+void RenderGraphResources::Import(unsigned int i, ID3D12Resource* res) {
+	if (i >= m_listResources.size() || m_pGraph->GetResourceDesc(i).isTransient) {
+		std::string msg = "RenderGraphResources::Import: resource " + std::to_string(i) + " isn't an imported resource of the graph.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	m_listResources[i] = res;
+}
+
+// Record a batch of the graph's barriers with a single ResourceBarrier() call.
+void RenderGraphResources::IssueBarriers(ID3D12GraphicsCommandList* cmdList, const RenderGraphBarrier* barriers, unsigned int num) {
+	m_listBarriers.clear();
+	for (unsigned int i = 0; i < num; ++i) {
+		const RenderGraphBarrier& b = barriers[i];
+		ID3D12Resource* res = m_listResources[b.resource];
+
+		switch (b.type) {
+			case RG_BARRIER_TRANSITION: {
+				D3D12_RESOURCE_BARRIER_FLAGS flags = b.split == RG_SPLIT_BEGIN ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY :
+					b.split == RG_SPLIT_END ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY : D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				m_listBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(res, (D3D12_RESOURCE_STATES)b.stateBefore,
+					(D3D12_RESOURCE_STATES)b.stateAfter, D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, flags));
+				break;
+			}
+			case RG_BARRIER_ALIASING:
+				m_listBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(
+					b.resourceBefore == RG_NO_RESOURCE ? nullptr : m_listResources[b.resourceBefore], res));
+				break;
+			case RG_BARRIER_UAV:
+				m_listBarriers.push_back(CD3DX12_RESOURCE_BARRIER::UAV(res));
+				break;
+		}
+	}
+
+	if (!m_listBarriers.empty()) {
+		cmdList->ResourceBarrier((UINT)m_listBarriers.size(), m_listBarriers.data());
+	}
+}
@@ -0,0 +1,53 @@
+/*
+RenderGraphResources.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	The Direct3D 12 resources behind a RenderGraph. Imported resources are pointed at
+				existing ID3D12Resources. Transient resources are created in a heap shared between
+				them, at the offsets the graph placed them at.
+
+Usage:			- Proper shutdown is handled by the destructor. It releases the transient resources and the heap.
+				- Requires a pointer to a Device and to the RenderGraph it holds resources for.
+				- Compile the graph once with every pass a frame can have, then call CreateHeap() and
+					CreateTransient() for each transient resource.
+				- Call Import() for each imported resource. It can be changed between graphs, ie for the back buffer.
+				- Pass IssueBarriers() to RenderGraph::Execute() to record each batch of barriers as a single ResourceBarrier().
+
+Future Work:	- Create the heap again when the graph's placement changes.
+*/
+#pragma once
+
+#include "Graphics.h"
+#include "RenderGraph.h"
+#include <vector>
+
+using namespace graphics;
+
+class RenderGraphResources {
+public:
+	RenderGraphResources(Device* dev, RenderGraph* graph);
+	~RenderGraphResources();
+
+	// Create the heap the graph's transient resources share. flags must allow every kind of transient resource in the graph.
+	void CreateHeap(D3D12_HEAP_FLAGS flags);
+	// Create transient resource i of the graph in the heap and return it. desc must match the size the graph was given.
+	ID3D12Resource* CreateTransient(unsigned int i, D3D12_RESOURCE_DESC* desc, D3D12_CLEAR_VALUE* clear);
+	// Point imported resource i of the graph at res.
+	void Import(unsigned int i, ID3D12Resource* res);
+	// Record a batch of the graph's barriers with a single ResourceBarrier() call.
+	void IssueBarriers(ID3D12GraphicsCommandList* cmdList, const RenderGraphBarrier* barriers, unsigned int num);
+
+	// Returns the number of bytes in the shared heap.
+	unsigned long long GetHeapSize() { return m_sizeHeap; }
+
+private:
+	Device*							m_pDev;
+	RenderGraph*					m_pGraph;
+	ID3D12Heap*						m_pHeap;
+	std::vector<ID3D12Resource*>	m_listResources;		// indexed as per the graph's resources.
+	std::vector<bool>				m_listIsOwned;			// the transient resources created here.
+	std::vector<D3D12_RESOURCE_BARRIER>	m_listBarriers;		// kept between calls to IssueBarriers() to save allocating.
+	unsigned long long				m_sizeHeap;
+};
@@ -1,12 +1,26 @@
+#include "ShadowCascadeLimits.h"
+
 cbuffer TerrainData : register(b0) {
 	float scale;
 	float width;
 	float depth;
 	float base;
+	float spacing;
+	float boundsmin;
+	float boundsrange;
+	float padding;
+	float2 offset;		// world position of the tile's first control point. See TerrainTiles.h.
+	uint skirts;		// the sides of the skirt along the edge of the world. Bit n is set for side n.
 }
 
-cbuffer ShadowConstants : register(b1) {
+struct CascadeData {
 	float4x4 shadowmatrix;
+	float4 eye;
+	float4 frustum[4];
+};
+
+cbuffer ShadowConstants : register(b1) {
+	CascadeData cascades[SHADOW_CASCADE_LIMIT];
 }
 
 Texture2D<float4> heightmap : register(t0);
@@ -17,6 +31,9 @@ SamplerState displacementsampler : register(s1);
 struct DS_OUTPUT
 {
 	float4 pos : SV_POSITION;
+#ifdef SINGLE_PASS_CASCADES
+	uint viewport : SV_ViewportArrayIndex;	// routes the triangle to the cascade's quadrant of the atlas.
+#endif
 };
 
 // Output control point
@@ -31,6 +48,7 @@ struct HS_CONSTANT_DATA_OUTPUT
 	float EdgeTessFactor[4]			: SV_TessFactor; // e.g. would be [4] for a quad domain
 	float InsideTessFactor[2]		: SV_InsideTessFactor; // e.g. would be Inside[2] for a quad domain
 	uint skirt						: SKIRT;
+	uint cascade					: CASCADE;
 };
 
 float3 estimateNormal(float2 texcoord) {
@@ -69,19 +87,24 @@ DS_OUTPUT main(
 {
 	DS_OUTPUT output;
 	float3 worldpos = lerp(lerp(patch[0].worldpos, patch[1].worldpos, domain.x), lerp(patch[2].worldpos, patch[3].worldpos, domain.x), domain.y);
+	// the heightmap covers the tile. The displacement map repeats across the whole world.
+	float2 texcoord = (worldpos.xy - offset) / width;
 
 	if (input.skirt < 5) {
 		if (input.skirt > 0 && domain.y == 1) {
-			worldpos.z = heightmap.SampleLevel(hmsampler, worldpos / width, 0.0f).x * scale;
+			worldpos.z = heightmap.SampleLevel(hmsampler, texcoord, 0.0f).x * scale;
 		}
 	} else {
-		worldpos.z = heightmap.SampleLevel(hmsampler, worldpos / width, 0.0f).x * scale;
+		worldpos.z = heightmap.SampleLevel(hmsampler, texcoord, 0.0f).x * scale;
 	}
 
-	float3 norm = estimateNormal(worldpos / width);
+	float3 norm = estimateNormal(texcoord);
 	worldpos += norm * 0.5f * (2.0f * displacementmap.SampleLevel(displacementsampler, worldpos / 32, 0.0f).w - 1.0f);
 
 	output.pos = float4(worldpos, 1.0f);
-	output.pos = mul(output.pos, shadowmatrix);
+	output.pos = mul(output.pos, cascades[input.cascade].shadowmatrix);
+#ifdef SINGLE_PASS_CASCADES
+	output.viewport = input.cascade;
+#endif
 	return output;
 }
@@ -1,17 +1,39 @@
-cbuffer ShadowConstants : register(b1)
+#include "ShadowCascadeLimits.h"
+
+cbuffer TerrainData : register(b0)
+{
+	float scale;
+	float width;
+	float depth;
+	float base;
+	float spacing;
+	float boundsmin;
+	float boundsrange;
+	float padding;
+	float2 offset;		// world position of the tile's first control point. See TerrainTiles.h.
+	uint skirts;		// the sides of the skirt along the edge of the world. Bit n is set for side n.
+}
+
+struct CascadeData
 {
 	float4x4 shadowmatrix;
 	float4 eye;
 	float4 frustum[4];
+};
+
+// the constants for every cascade are bound at once. The vertex shader picks the cascade being drawn.
+cbuffer ShadowConstants : register(b1)
+{
+	CascadeData cascades[SHADOW_CASCADE_LIMIT];
 }
 
 // Input control point
 struct VS_OUTPUT
 {
 	float3 worldpos : POSITION0;
-	float3 aabbmin : POSITION1;
-	float3 aabbmax : POSITION2;
+	float2 zbounds : BOUNDS;	// z bounds of the patch starting at this control point.
 	uint skirt : SKIRT;
+	uint cascade : CASCADE;
 };
 // Output control point
 struct HS_CONTROL_POINT_OUTPUT
@@ -25,6 +47,7 @@ struct HS_CONSTANT_DATA_OUTPUT
 	float EdgeTessFactor[4]			: SV_TessFactor; // e.g. would be [4] for a quad domain
 	float InsideTessFactor[2]		: SV_InsideTessFactor; // e.g. would be Inside[2] for a quad domain
 	uint skirt						: SKIRT;
+	uint cascade					: CASCADE;
 };
 
 #define NUM_CONTROL_POINTS 4
@@ -56,8 +79,8 @@ bool aabbOutsideFrustumTest(float3 center, float3 extents, float4 frustumPlanes[
 	return false;
 }
 
-float CalcTessFactor(float3 p) {
-	float d = distance(p, eye);
+float CalcTessFactor(float3 p, uint cascade) {
+	float d = distance(p, cascades[cascade].eye.xyz);
 
 	float s = saturate((d - 128.0f) / (256.0f - 128.0f));
 	return pow(2, (lerp(4, 0, s)));
@@ -70,19 +93,26 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(
 {
 	HS_CONSTANT_DATA_OUTPUT output;
 	output.skirt = ip[0].skirt;
+	output.cascade = ip[0].cascade;
+	uint cascade = output.cascade;
 
 	// build axis-aligned bounding box. 
-	// ip[0] is lower left corner
-	// ip[3] is upper right corner
-	// get z value from boundsZ variable. Correct value will be in ip[0].
-	float3 vMin = ip[0].aabbmin;
-	float3 vMax = ip[0].aabbmax;
+	// x and y come from the control points, padded by the reach of the displacement map on terrain patches.
+	// the z bounds of the patch are stored with ip[0].
+	float pad = output.skirt == 5 ? 0.5f : 0.0f;
+	float2 xyMin = min(min(ip[0].worldpos.xy, ip[1].worldpos.xy), min(ip[2].worldpos.xy, ip[3].worldpos.xy)) - pad;
+	float2 xyMax = max(max(ip[0].worldpos.xy, ip[1].worldpos.xy), max(ip[2].worldpos.xy, ip[3].worldpos.xy)) + pad;
+	float3 vMin = float3(xyMin, ip[0].zbounds.x);
+	float3 vMax = float3(xyMax, ip[0].zbounds.y);
 
 	// center/extents representation.
 	float3 boxCenter = 0.5f * (vMin + vMax);
 	float3 boxExtents = 0.5f * (vMax - vMin);
 
-	if (aabbOutsideFrustumTest(boxCenter, boxExtents, frustum)) {
+	// the skirts between neighbouring tiles are hidden by the terrain either side of them.
+	bool isInnerSkirt = output.skirt > 0 && output.skirt < 5 && (skirts & (1u << output.skirt)) == 0;
+
+	if (isInnerSkirt || aabbOutsideFrustumTest(boxCenter, boxExtents, cascades[cascade].frustum)) {
 		output.EdgeTessFactor[0] = 0.0f;
 		output.EdgeTessFactor[1] = 0.0f;
 		output.EdgeTessFactor[2] = 0.0f;
@@ -110,7 +140,7 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(
 			output.EdgeTessFactor[0] = 1.0f;
 			output.EdgeTessFactor[1] = 1.0f;
 			output.EdgeTessFactor[2] = 1.0f;
-			output.EdgeTessFactor[3] = CalcTessFactor(e3);
+			output.EdgeTessFactor[3] = CalcTessFactor(e3, cascade);
 			output.InsideTessFactor[0] = 1.0f;
 			output.InsideTessFactor[1] = 1.0f;
 
@@ -126,11 +156,11 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(
 		float3 e3 = 0.5f * (ip[2].worldpos + ip[3].worldpos);
 		float3 c = 0.25f * (ip[0].worldpos + ip[1].worldpos + ip[2].worldpos + ip[3].worldpos);
 
-		output.EdgeTessFactor[0] = CalcTessFactor(e0);
-		output.EdgeTessFactor[1] = CalcTessFactor(e1);
-		output.EdgeTessFactor[2] = CalcTessFactor(e2);
-		output.EdgeTessFactor[3] = CalcTessFactor(e3);
-		output.InsideTessFactor[0] = CalcTessFactor(c);
+		output.EdgeTessFactor[0] = CalcTessFactor(e0, cascade);
+		output.EdgeTessFactor[1] = CalcTessFactor(e1, cascade);
+		output.EdgeTessFactor[2] = CalcTessFactor(e2, cascade);
+		output.EdgeTessFactor[3] = CalcTessFactor(e3, cascade);
+		output.InsideTessFactor[0] = CalcTessFactor(c, cascade);
 		output.InsideTessFactor[1] = output.InsideTessFactor[0];
 
 		return output;
@@ -0,0 +1,5 @@
+// Domain shader for rendering every shadow cascade in a single instanced draw.
+// Identical to RenderShadowMapDS.hlsl except that each triangle is routed to its cascade's viewport.
+// Requires VPAndRTArrayIndexFromAnyShaderFeedingRasterizer support.
+#define SINGLE_PASS_CASCADES
+#include "RenderShadowMapDS.hlsl"
@@ -0,0 +1,78 @@
+#include "ShadowCascadeLimits.h"
+
+// the cascades drawn by this draw call, packed SHADOW_CASCADE_MAP_BITS per instance. See PackCascadeMap() in ShadowCascades.h.
+// Lets a single instanced draw skip cascades that don't need to be redrawn.
+// SV_VertexID doesn't include the base vertex of an indexed draw, so chunks of 16 bit indices pass theirs in baseVertex.
+cbuffer DrawConstants : register(b2)
+{
+	uint cascadeMap;
+	uint baseVertex;
+}
+
+cbuffer TerrainData : register(b0)
+{
+	float scale;
+	float width;
+	float depth;
+	float base;
+	float spacing;		// distance between neighbouring control points, in heightmap texels.
+	float boundsmin;	// bottom of the height range patch bounds are quantized over.
+	float boundsrange;	// size of the height range patch bounds are quantized over.
+	float padding;
+	float2 offset;		// world position of the tile's first control point. See TerrainTiles.h.
+}
+
+// must match PackedVertex in Terrain.h.
+struct PackedVertex
+{
+	uint bounds;	// z bounds of the patch starting at this vertex. 16 bit min in the low half, max in the high half.
+	uint data;		// half float error in the low 16 bits, skirt in the high 16 bits.
+};
+
+Texture2D<float4> heightmap : register(t0);
+StructuredBuffer<PackedVertex> vertices : register(t4);
+
+struct VS_OUTPUT
+{
+	float3 worldpos : POSITION0;
+	float2 zbounds : BOUNDS;
+	uint skirt : SKIRT;
+	uint cascade : CASCADE;
+};
+
+// rebuild the position of control point id from its place in the grid. Must match Terrain::CreateMesh3D().
+float3 CalcControlPointPosition(uint id) {
+	uint s = (uint)spacing;
+	uint numX = (uint)width / s;
+	uint numY = (uint)depth / s;
+	uint numTerrain = numX * numY;
+
+	if (id < numTerrain) {
+		uint2 xy = uint2(id % numX, id / numX) * s;
+		return float3((float2)xy, heightmap.Load(int3(xy, 0)).x * scale);
+	}
+
+	// the base vertices of the skirt follow the terrain. One row for each side.
+	uint i = id - numTerrain;
+	if (i < numX) return float3((float)(i * s), 0.0f, base);
+	i -= numX;
+	if (i < numX) return float3((float)(i * s), depth - spacing, base);
+	i -= numX;
+	if (i < numY) return float3(0.0f, (float)(i * s), base);
+	i -= numY;
+	return float3(width - spacing, (float)(i * s), base);
+}
+
+VS_OUTPUT main(uint id : SV_VertexID, uint instance : SV_InstanceID) {
+	VS_OUTPUT output;
+	id += baseVertex;
+	PackedVertex v = vertices[id];
+
+	// the tile's vertices are in its own coordinates.
+	output.worldpos = CalcControlPointPosition(id) + float3(offset, 0.0f);
+	output.zbounds = boundsmin + float2(v.bounds & 0xffff, v.bounds >> 16) * (boundsrange / 65535.0f);
+	output.skirt = v.data >> 16;
+	output.cascade = (cascadeMap >> (instance * SHADOW_CASCADE_MAP_BITS)) & ((1u << SHADOW_CASCADE_MAP_BITS) - 1);
+
+	return output;
+}
@@ -1,17 +1,28 @@
+#include "ShadowCascadeLimits.h"
+
 cbuffer TerrainData : register(b0)
 {
 	float scale;
 	float width;
 	float depth;
 	float base;
+	float spacing;
+	float boundsmin;
+	float boundsrange;
+	float padding;
+	float2 offset;		// world position of the tile's first control point. See TerrainTiles.h.
+	uint skirts;		// the sides of the skirt along the edge of the world. Bit n is set for side n.
 }
 
 cbuffer PerFrameData : register(b1)
 {
 	float4x4 viewproj;
-	float4x4 shadowtexmatrices[4];
+	float4x4 shadowtexmatrices[SHADOW_CASCADE_LIMIT];
+	float4 shadowcascaderects[SHADOW_CASCADE_LIMIT];	// region of the atlas each cascade may be sampled from.
+	float4 shadowatlassize;			// x = size in texels, y = size of a texel, z = number of cascades.
 	float4 eye;
 	float4 frustum[6];
+	float4 tessparams;				// x = pixels per world unit at a distance of 1, y = target error in pixels, z = max tess factor.
 }
 
 Texture2D<float4> heightmap : register(t0);
@@ -24,7 +35,7 @@ SamplerState displacementsampler : register(s3);
 struct DS_OUTPUT
 {
 	float4 pos : SV_POSITION;
-	float4 shadowpos[4] : TEXCOORD0;
+	float4 shadowpos[SHADOW_CASCADE_LIMIT] : TEXCOORD0;
 	float3 worldpos : POSITION;
 };
 
@@ -79,19 +90,21 @@ DS_OUTPUT main(
 	DS_OUTPUT output;
 
 	output.worldpos = lerp(lerp(patch[0].worldpos, patch[1].worldpos, domain.x), lerp(patch[2].worldpos, patch[3].worldpos, domain.x), domain.y);
+	// the heightmap covers the tile. The displacement map repeats across the whole world.
+	float2 texcoord = (output.worldpos.xy - offset) / width;
 	
 	float h;
 	if (input.skirt < 5) {
 		if (input.skirt > 0 && domain.y == 1) {
-			h = heightmap.SampleLevel(hmsampler, output.worldpos / width, 0.0f).x;
+			h = heightmap.SampleLevel(hmsampler, texcoord, 0.0f).x;
 			output.worldpos.z = h * scale;
 		}
 	} else {
-		h = heightmap.SampleLevel(hmsampler, output.worldpos / width, 0.0f).x;
+		h = heightmap.SampleLevel(hmsampler, texcoord, 0.0f).x;
 		output.worldpos.z = h * scale;
 	}
 	
-	float3 norm = estimateNormal(output.worldpos / width);
+	float3 norm = estimateNormal(texcoord);
 	output.worldpos += norm * 0.5f * (2.0f * displacementmap.SampleLevel(displacementsampler, output.worldpos / 32, 0.0f).w - 1.0f);
 
 	// generate coordinates transformed into view/projection space.
@@ -99,7 +112,7 @@ DS_OUTPUT main(
 	output.pos = mul(output.pos, viewproj);
 
 	[unroll]
-	for (int i = 0; i < 4; ++i) {
+	for (int i = 0; i < SHADOW_CASCADE_LIMIT; ++i) {
 		// generate projective tex-coords to project shadow map onto scene.
 		output.shadowpos[i] = float4(output.worldpos, 1.0f);
 
@@ -1,18 +1,37 @@
+#include "ShadowCascadeLimits.h"
+
+cbuffer TerrainData : register(b0)
+{
+	float scale;
+	float width;
+	float depth;
+	float base;
+	float spacing;
+	float boundsmin;
+	float boundsrange;
+	float padding;
+	float2 offset;		// world position of the tile's first control point. See TerrainTiles.h.
+	uint skirts;		// the sides of the skirt along the edge of the world. Bit n is set for side n.
+}
+
 cbuffer PerFrameData : register(b1)
 {
 	float4x4 viewproj;
-	float4x4 shadowtexmatrices[4];
+	float4x4 shadowtexmatrices[SHADOW_CASCADE_LIMIT];
+	float4 shadowcascaderects[SHADOW_CASCADE_LIMIT];	// region of the atlas each cascade may be sampled from.
+	float4 shadowatlassize;			// x = size in texels, y = size of a texel, z = number of cascades.
 	float4 eye;
 	float4 frustum[6];
+	float4 tessparams;				// x = pixels per world unit at a distance of 1, y = target error in pixels, z = max tess factor.
 }
 
 // Input control point
 struct VS_OUTPUT
 {
 	float3 worldpos : POSITION0;
-	float3 aabbmin : POSITION1;
-	float3 aabbmax : POSITION2;
+	float2 zbounds : BOUNDS;	// z bounds of the patch starting at this control point.
 	uint skirt : SKIRT;
+	float error : ERROR;	// largest world space height error of the patches sharing this control point.
 };
 // Output control point
 struct HS_CONTROL_POINT_OUTPUT
@@ -59,11 +78,12 @@ bool aabbOutsideFrustumTest(float3 center, float3 extents, float4 frustumPlanes[
 	return false;
 }
 
-float CalcTessFactor(float3 p) {
-	float d = distance(p, eye.xyz);
+// returns the factor that keeps the on-screen size of a world space error seen from p at or below the target error.
+// The error left after splitting an edge into f pieces is taken to fall off as error / f. Matches CalcTessFactor() in TessFactors.cpp.
+float CalcTessFactor(float3 p, float error) {
+	float d = max(distance(p, eye.xyz), 1.0f);
 
-	float s = saturate((d - 16.0f) / (256.0f - 16.0f));
-	return pow(2, (lerp(6, 0, s)));
+	return clamp(error * tessparams.x / (d * tessparams.y), 1.0f, tessparams.z);
 }
 
 // Patch Constant Function
@@ -75,14 +95,22 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(
 	output.skirt = ip[0].skirt;
 
 	// build axis-aligned bounding box. 
-	float3 vMin = ip[0].aabbmin;
-	float3 vMax = ip[0].aabbmax;
+	// x and y come from the control points, padded by the reach of the displacement map on terrain patches.
+	// the z bounds of the patch are stored with ip[0].
+	float pad = output.skirt == 5 ? 0.5f : 0.0f;
+	float2 xyMin = min(min(ip[0].worldpos.xy, ip[1].worldpos.xy), min(ip[2].worldpos.xy, ip[3].worldpos.xy)) - pad;
+	float2 xyMax = max(max(ip[0].worldpos.xy, ip[1].worldpos.xy), max(ip[2].worldpos.xy, ip[3].worldpos.xy)) + pad;
+	float3 vMin = float3(xyMin, ip[0].zbounds.x);
+	float3 vMax = float3(xyMax, ip[0].zbounds.y);
 	
 	// center/extents representation.
 	float3 boxCenter = 0.5f * (vMin + vMax);
 	float3 boxExtents = 0.5f * (vMax - vMin);
 
-	if (aabbOutsideFrustumTest(boxCenter, boxExtents, frustum)) {
+	// the skirts between neighbouring tiles are hidden by the terrain either side of them.
+	bool isInnerSkirt = output.skirt > 0 && output.skirt < 5 && (skirts & (1u << output.skirt)) == 0;
+
+	if (isInnerSkirt || aabbOutsideFrustumTest(boxCenter, boxExtents, frustum)) {
 		output.EdgeTessFactor[0] = 0.0f;
 		output.EdgeTessFactor[1] = 0.0f;
 		output.EdgeTessFactor[2] = 0.0f;
@@ -108,14 +136,14 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(
 			output.EdgeTessFactor[0] = 1.0f;
 			output.EdgeTessFactor[1] = 1.0f;
 			output.EdgeTessFactor[2] = 1.0f;
-			output.EdgeTessFactor[3] = CalcTessFactor(e3);
+			output.EdgeTessFactor[3] = CalcTessFactor(e3, max(ip[2].error, ip[3].error));
 			output.InsideTessFactor[0] = 1.0f;
 			output.InsideTessFactor[1] = 1.0f;
 
 			return output;
 		}
-		// tessellate based on distance from the camera.
-		// compute tess factor based on edges.
+		// tessellate based on the projected error of each edge.
+		// edges use the larger error of their two ends, so the patches on either side always agree and never crack.
 		// compute midpoint of edges.
 		float3 e0 = 0.5f * (ip[0].worldpos + ip[2].worldpos);
 		float3 e1 = 0.5f * (ip[0].worldpos + ip[1].worldpos);
@@ -123,11 +151,11 @@ HS_CONSTANT_DATA_OUTPUT CalcHSPatchConstants(
 		float3 e3 = 0.5f * (ip[2].worldpos + ip[3].worldpos);
 		float3 c = 0.25f * (ip[0].worldpos + ip[1].worldpos + ip[2].worldpos + ip[3].worldpos);
 
-		output.EdgeTessFactor[0] = CalcTessFactor(e0);
-		output.EdgeTessFactor[1] = CalcTessFactor(e1);
-		output.EdgeTessFactor[2] = CalcTessFactor(e2);
-		output.EdgeTessFactor[3] = CalcTessFactor(e3);
-		output.InsideTessFactor[0] = CalcTessFactor(c);
+		output.EdgeTessFactor[0] = CalcTessFactor(e0, max(ip[0].error, ip[2].error));
+		output.EdgeTessFactor[1] = CalcTessFactor(e1, max(ip[0].error, ip[1].error));
+		output.EdgeTessFactor[2] = CalcTessFactor(e2, max(ip[1].error, ip[3].error));
+		output.EdgeTessFactor[3] = CalcTessFactor(e3, max(ip[2].error, ip[3].error));
+		output.InsideTessFactor[0] = CalcTessFactor(c, max(max(ip[0].error, ip[1].error), max(ip[2].error, ip[3].error)));
 		output.InsideTessFactor[1] = output.InsideTessFactor[0];
 
 		return output;
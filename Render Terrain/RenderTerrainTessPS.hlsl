@@ -1,3 +1,5 @@
+#include "ShadowCascadeLimits.h"
+
 struct LightData {
 	float4 pos;
 	float4 amb;
@@ -15,14 +17,23 @@ cbuffer TerrainData : register(b0)
 	float width;
 	float depth;
 	float base;
+	float spacing;
+	float boundsmin;
+	float boundsrange;
+	float padding;
+	float2 offset;		// world position of the tile's first control point. See TerrainTiles.h.
+	uint skirts;		// the sides of the skirt along the edge of the world. Bit n is set for side n.
 }
 
 cbuffer PerFrameData : register(b1)
 {
 	float4x4 viewproj;
-	float4x4 shadowtexmatrices[4];
+	float4x4 shadowtexmatrices[SHADOW_CASCADE_LIMIT];
+	float4 shadowcascaderects[SHADOW_CASCADE_LIMIT];	// region of the atlas each cascade may be sampled from.
+	float4 shadowatlassize;			// x = size in texels, y = size of a texel, z = number of cascades.
 	float4 eye;
 	float4 frustum[6];
+	float4 tessparams;				// x = pixels per world unit at a distance of 1, y = target error in pixels, z = max tess factor.
 	LightData light;
 	bool useTextures;
 }
@@ -39,13 +50,10 @@ SamplerState displacementsampler : register(s3);
 struct DS_OUTPUT
 {
 	float4 pos : SV_POSITION;
-	float4 shadowpos[4] : TEXCOORD0;
+	float4 shadowpos[SHADOW_CASCADE_LIMIT] : TEXCOORD0;
 	float3 worldpos : POSITION;
 };
 
-// shadow map constants
-static const float SMAP_SIZE = 4096.0f;
-static const float SMAP_DX = 1.0f / SMAP_SIZE;
 static const float4 colors[] = { { 0.35f, 0.5f, 0.18f, 1.0f },{ 0.89f, 0.89f, 0.89f, 1.0f },{ 0.31f, 0.25f, 0.2f, 1.0f },{ 0.39f, 0.37f, 0.38f, 1.0f } };
 
 // code for putting together cotangent frame and perturbing normal from normal map.
@@ -304,7 +312,7 @@ float calcShadowFactor(float4 shadowPosH) {
 	float depth = shadowPosH.z;
 
 	// Texel size.
-	const float dx = SMAP_DX;
+	const float dx = shadowatlassize.y;
 
 	float percentLit = 0.0f;
 	
@@ -324,27 +332,24 @@ float calcShadowFactor(float4 shadowPosH) {
 	return percentLit / 9.0f;
 }
 
-float decideOnCascade(float4 shadowpos[4]) {
-	// if shadowpos[0].xy is in the range [0, 0.5], then this point is in the first cascade
-	if (max(abs(shadowpos[0].x - 0.25), abs(shadowpos[0].y - 0.25)) < 0.247) {
-		return calcShadowFactor(shadowpos[0]);
-	}
-
-	if (max(abs(shadowpos[1].x - 0.25), abs(shadowpos[1].y - 0.75)) < 0.247) {
-		return calcShadowFactor(shadowpos[1]);
-	}
-
-	if (max(abs(shadowpos[2].x - 0.75), abs(shadowpos[2].y - 0.25)) < 0.247) {
-		return calcShadowFactor(shadowpos[2]);
+float decideOnCascade(float4 shadowpos[SHADOW_CASCADE_LIMIT]) {
+	// use the first cascade this point falls inside of. The cascades are ordered from nearest to farthest,
+	// and the last one covers the whole scene.
+	uint last = (uint)shadowatlassize.z - 1;
+	for (uint i = 0; i < last; ++i) {
+		float4 rect = shadowcascaderects[i];
+		if (all(shadowpos[i].xy > rect.xy) && all(shadowpos[i].xy < rect.zw)) {
+			return calcShadowFactor(shadowpos[i]);
+		}
 	}
 	
-	return calcShadowFactor(shadowpos[3]);
+	return calcShadowFactor(shadowpos[last]);
 }
 
 // basic diffuse/ambient lighting
 float4 main(DS_OUTPUT input) : SV_TARGET
 {
-	float3 norm = estimateNormal(input.worldpos / width);
+	float3 norm = estimateNormal((input.worldpos.xy - offset) / width);
 	float3 viewvector = eye.xyz - input.worldpos;
 	
 	norm = dist_based_normal(input.worldpos.z, acos(norm.z), norm, viewvector, input.worldpos / 2);
@@ -0,0 +1,4 @@
+// Vertex shader for drawing the whole terrain without an index buffer.
+// Identical to RenderTerrainTessVS.hlsl except that the control points of each patch are worked out from SV_VertexID.
+#define PROCEDURAL_PATCHES
+#include "RenderTerrainTessVS.hlsl"
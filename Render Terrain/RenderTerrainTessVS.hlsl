@@ -1,25 +1,120 @@
+cbuffer TerrainData : register(b0)
+{
+	float scale;
+	float width;
+	float depth;
+	float base;
+	float spacing;		// distance between neighbouring control points, in heightmap texels.
+	float boundsmin;	// bottom of the height range patch bounds are quantized over.
+	float boundsrange;	// size of the height range patch bounds are quantized over.
+	float padding;
+	float2 offset;		// world position of the tile's first control point. See TerrainTiles.h.
+}
+
+// must match PackedVertex in Terrain.h.
+struct PackedVertex
+{
+	uint bounds;	// z bounds of the patch starting at this vertex. 16 bit min in the low half, max in the high half.
+	uint data;		// half float error in the low 16 bits, skirt in the high 16 bits.
+};
+
+// SV_VertexID doesn't include the base vertex of an indexed draw, so chunks of 16 bit indices pass theirs in baseVertex.
+// cascadeMap is only read by the shadow pass. Must match Scene::InitRootSignature().
+cbuffer DrawConstants : register(b2)
+{
+	uint cascadeMap;
+	uint baseVertex;
+}
+
+Texture2D<float4> heightmap : register(t0);
+StructuredBuffer<PackedVertex> vertices : register(t4);
+
 struct VS_OUTPUT
 {
 	float3 worldpos : POSITION0;
-	float3 aabbmin : POSITION1;
-	float3 aabbmax : POSITION2;
+	float2 zbounds : BOUNDS;
 	uint skirt : SKIRT;
+	float error : ERROR;
 };
 
-struct VS_INPUT {
-	float3 pos : POSITION0;
-	float3 aabbmin : POSITION1;
-	float3 aabbmax : POSITION2;
-	uint skirt : SKIRT;
-};
+// rebuild the position of control point id from its place in the grid. Must match Terrain::CreateMesh3D().
+float3 CalcControlPointPosition(uint id) {
+	uint s = (uint)spacing;
+	uint numX = (uint)width / s;
+	uint numY = (uint)depth / s;
+	uint numTerrain = numX * numY;
+
+	if (id < numTerrain) {
+		uint2 xy = uint2(id % numX, id / numX) * s;
+		return float3((float2)xy, heightmap.Load(int3(xy, 0)).x * scale);
+	}
+
+	// the base vertices of the skirt follow the terrain. One row for each side.
+	uint i = id - numTerrain;
+	if (i < numX) return float3((float)(i * s), 0.0f, base);
+	i -= numX;
+	if (i < numX) return float3((float)(i * s), depth - spacing, base);
+	i -= numX;
+	if (i < numY) return float3(0.0f, (float)(i * s), base);
+	i -= numY;
+	return float3(width - spacing, (float)(i * s), base);
+}
+
+#ifdef PROCEDURAL_PATCHES
+// returns the vertex used as control point corner of patch. Must match CalcPatchControlPoint() in PatchGrid.cpp.
+// Patches come in ranges: the terrain, skirt sides 1 to 4, then the bottom plane.
+uint CalcPatchControlPoint(uint patch, uint corner) {
+	uint s = (uint)spacing;
+	uint numX = (uint)width / s;
+	uint numY = (uint)depth / s;
+	uint numTerrain = numX * numY;
+	// corners 0 and 1 are the first and second vertices along a patch's first edge. 2 and 3 are along the opposite edge.
+	uint second = corner & 1;
+	uint far = corner >> 1;
+
+	uint i = patch;
+	if (i < (numX - 1) * (numY - 1)) {
+		uint x = i % (numX - 1) + second;
+		uint y = i / (numX - 1) + far;
+		return y * numX + x;
+	}
+	i -= (numX - 1) * (numY - 1);
+	if (i < numX - 1) {
+		return far ? i + second : numTerrain + i + second;
+	}
+	i -= numX - 1;
+	if (i < numX - 1) {
+		return far ? numX * (numY - 1) + i + 1 - second : numTerrain + numX + i + 1 - second;
+	}
+	i -= numX - 1;
+	if (i < numY - 1) {
+		return far ? (i + 1 - second) * numX : numTerrain + 2 * numX + i + 1 - second;
+	}
+	i -= numY - 1;
+	if (i < numY - 1) {
+		return far ? (i + second) * numX + numX - 1 : numTerrain + 2 * numX + numY + i + second;
+	}
+
+	// the bottom plane is drawn between the corners of the skirt.
+	return numTerrain + (far ? numX : 0) + (second ? 0 : numX - 1);
+}
+#endif
 
-VS_OUTPUT main(VS_INPUT input) {
+VS_OUTPUT main(uint id : SV_VertexID) {
 	VS_OUTPUT output;
+#ifdef PROCEDURAL_PATCHES
+	// drawn without an index buffer, so every 4 vertices make up the next patch of the grid.
+	id = CalcPatchControlPoint(id / 4, id % 4);
+#else
+	id += baseVertex;
+#endif
+	PackedVertex v = vertices[id];
 
-	output.worldpos = input.pos;
-	output.aabbmin = input.aabbmin;
-	output.aabbmax = input.aabbmax;
-	output.skirt = input.skirt;
+	// the tile's vertices are in its own coordinates.
+	output.worldpos = CalcControlPointPosition(id) + float3(offset, 0.0f);
+	output.zbounds = boundsmin + float2(v.bounds & 0xffff, v.bounds >> 16) * (boundsrange / 65535.0f);
+	output.skirt = v.data >> 16;
+	output.error = f16tof32(v.data);
 
 	return output;
-}
\ No newline at end of file
+}
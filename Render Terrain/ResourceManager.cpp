@@ -9,29 +9,19 @@ Description:	Class for creating and managing a Direct3D 12 Resource Maanager.
 
 #include "ResourceManager.h"
 #include "lodepng.h"
+#include <cstring>
 #include <string>
 
-ResourceManager::ResourceManager(Device* d, unsigned int numRTVs, unsigned int numDSVs, unsigned int numCBVSRVUAVs,
-	unsigned int numSamplers) :	m_pDev(d), m_numRTVs(numRTVs), m_numDSVs(numDSVs), m_numCBVSRVUAVs(numCBVSRVUAVs),
+ResourceManager::ResourceManager(Device* d, CommandListPool* pool, unsigned int numRTVs, unsigned int numDSVs, unsigned int numCBVSRVUAVs,
+	unsigned int numSamplers) :	m_pDev(d), m_pCmdPool(pool), m_ringUpload(DEFAULT_UPLOAD_BUFFER_SIZE), m_numRTVs(numRTVs), m_numDSVs(numDSVs), m_numCBVSRVUAVs(numCBVSRVUAVs),
 	m_numSamplers(numSamplers) {
 	m_pheapRTV = nullptr;
 	m_pheapDSV = nullptr;
 	m_pheapCBVSRVUAV = nullptr;
 	m_pheapSampler = nullptr;
-	m_pCmdAllocator = nullptr;
-	m_pCmdList = nullptr;
-	m_pFence = nullptr;
-
-	m_pDev->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, m_pCmdAllocator);
-	m_pDev->CreateGraphicsCommandList(D3D12_COMMAND_LIST_TYPE_DIRECT, m_pCmdAllocator, m_pCmdList);
-	m_pCmdList->Close();
-
 	m_valFence = 0;
-	m_pDev->CreateFence(m_valFence, D3D12_FENCE_FLAG_NONE, m_pFence);
-	m_hdlFenceEvent = CreateEvent(NULL, false, false, NULL);
-	if (!m_hdlFenceEvent) {
-		throw GFX_Exception("ResourceManager::ResourceManager: Create Fence Event failed on init.");
-	}
+	m_numUploadStalls = 0;
+	m_sizeUploadPow2 = 0;
 
 	// initialize the descriptor heaps.
 	D3D12_DESCRIPTOR_HEAP_DESC descHeap = {};
@@ -87,7 +77,7 @@ ResourceManager::ResourceManager(Device* d, unsigned int numRTVs, unsigned int n
 	// Create an upload buffer.
 	m_pDev->CreateCommittedResource(m_pUpload, &CD3DX12_RESOURCE_DESC::Buffer(DEFAULT_UPLOAD_BUFFER_SIZE), &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
 		D3D12_HEAP_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
-	m_iUpload = 0;
+	m_sizeUpload = m_pDev->GetResourceAllocationSize(&CD3DX12_RESOURCE_DESC::Buffer(DEFAULT_UPLOAD_BUFFER_SIZE));
 }
 
 ResourceManager::~ResourceManager() {	
@@ -99,23 +89,7 @@ ResourceManager::~ResourceManager() {
 	}
 
 	m_pDev = nullptr;
-
-	CloseHandle(m_hdlFenceEvent);
-
-	if (m_pFence) {
-		m_pFence->Release();
-		m_pFence = nullptr;
-	}
-
-	if (m_pCmdAllocator) {
-		m_pCmdAllocator->Release();
-		m_pCmdAllocator = nullptr;
-	}
-
-	if (m_pCmdList) {
-		m_pCmdList->Release();
-		m_pCmdList = nullptr;
-	}
+	m_pCmdPool = nullptr;
 
 	while (!m_listFileData.empty()) {
 		unsigned char* tmp = m_listFileData.back();
@@ -216,9 +190,60 @@ void ResourceManager::AddSampler(D3D12_SAMPLER_DESC* desc, D3D12_CPU_DESCRIPTOR_
 	++m_indexFirstFreeSlotSampler;
 }
 
+// Reserve num contiguous slots in the CBV/SRV/UAV heap for use as a descriptor table. Returns the index of the first slot.
+unsigned int ResourceManager::ReserveCBVSRVUAVTable(unsigned int num) {
+	if (m_indexFirstFreeSlotCBVSRVUAV + num > m_numCBVSRVUAVs || m_indexFirstFreeSlotCBVSRVUAV < 0) {
+		throw GFX_Exception("Error reserving descriptor table in CBV/SRV/UAV Heap. No space remaining.");
+	}
+
+	unsigned int i = m_indexFirstFreeSlotCBVSRVUAV;
+	m_indexFirstFreeSlotCBVSRVUAV += num;
+
+	return i;
+}
+
+// Create an SRV in slot i of the CBV/SRV/UAV heap. The slot must have been reserved with ReserveCBVSRVUAVTable().
+void ResourceManager::AddSRVAt(unsigned int i, ID3D12Resource* tex, D3D12_SHADER_RESOURCE_VIEW_DESC* desc) {
+	if (i >= m_indexFirstFreeSlotCBVSRVUAV) {
+		std::string msg = "ResourceManager::AddSRVAt failed due to unreserved index " + std::to_string(i) + ".";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handleCPU = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pheapCBVSRVUAV->GetCPUDescriptorHandleForHeapStart(),
+		i, m_sizeCBVSRVUAVHeapDesc);
+	m_pDev->CreateSRV(tex, desc, handleCPU);
+}
+
+// Create a UAV in slot i of the CBV/SRV/UAV heap. The slot must have been reserved with ReserveCBVSRVUAVTable().
+void ResourceManager::AddUAVAt(unsigned int i, ID3D12Resource* tex, D3D12_UNORDERED_ACCESS_VIEW_DESC* desc) {
+	if (i >= m_indexFirstFreeSlotCBVSRVUAV) {
+		std::string msg = "ResourceManager::AddUAVAt failed due to unreserved index " + std::to_string(i) + ".";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	D3D12_CPU_DESCRIPTOR_HANDLE handleCPU = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_pheapCBVSRVUAV->GetCPUDescriptorHandleForHeapStart(),
+		i, m_sizeCBVSRVUAVHeapDesc);
+	m_pDev->CreateUAV(tex, desc, handleCPU);
+}
+
+// return the GPU handle for slot i of the CBV/SRV/UAV heap.
+D3D12_GPU_DESCRIPTOR_HANDLE ResourceManager::GetCBVSRVUAVHandleGPU(unsigned int i) {
+	if (i >= m_numCBVSRVUAVs) {
+		std::string msg = "ResourceManager::GetCBVSRVUAVHandleGPU failed due to index " + std::to_string(i) + " out of bounds.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(m_pheapCBVSRVUAV->GetGPUDescriptorHandleForHeapStart(), i, m_sizeCBVSRVUAVHeapDesc);
+}
+
 // takes a pointer to the existing resource, adds it to the list of resources, and returns the index to that resource.
 unsigned int ResourceManager::AddExistingResource(ID3D12Resource* tex) {
+	// we don't know where existing resources were created, but they are almost always swap chain buffers, so assume video memory.
+	D3D12_RESOURCE_DESC desc = tex->GetDesc();
+	ResourceAllocation alloc = { m_pDev->GetResourceAllocationSize(&desc), D3D12_HEAP_TYPE_DEFAULT };
+
 	m_listResources.push_back(tex);
+	m_listAllocations.push_back(alloc);
 	return (unsigned int)m_listResources.size() - 1;
 }
 
@@ -226,8 +251,10 @@ unsigned int ResourceManager::AddExistingResource(ID3D12Resource* tex) {
 unsigned int ResourceManager::NewBuffer(ID3D12Resource*& buffer, D3D12_RESOURCE_DESC* descBuffer,
 	D3D12_HEAP_PROPERTIES* props, D3D12_HEAP_FLAGS flags, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clear) {
 	m_pDev->CreateCommittedResource(buffer, descBuffer, props, flags, state, clear);
+	ResourceAllocation alloc = { m_pDev->GetResourceAllocationSize(descBuffer), props->Type };
 
 	m_listResources.push_back(buffer);
+	m_listAllocations.push_back(alloc);
 	return (unsigned int)m_listResources.size() - 1;
 }
 
@@ -240,8 +267,10 @@ unsigned int ResourceManager::NewBufferAt(unsigned int i, ID3D12Resource*& buffe
 		throw GFX_Exception(msg.c_str());
 	}
 	m_pDev->CreateCommittedResource(buffer, descBuffer, props, flags, state, clear);
+	ResourceAllocation alloc = { m_pDev->GetResourceAllocationSize(descBuffer), props->Type };
 
 	m_listResources[i] = buffer;
+	m_listAllocations[i] = alloc;
 
 	return i;
 }
@@ -253,84 +282,153 @@ void ResourceManager::UploadToBuffer(unsigned int i, unsigned int numSubResource
 		throw GFX_Exception(msg.c_str());
 	}
 
-	if (FAILED(m_pCmdList->Reset(m_pCmdAllocator, NULL))) {
-		throw GFX_Exception("ResourceManager::UploadToBuffer: CommandList Reset failed.");
-	}
+	unsigned int entry = m_pCmdPool->Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT, COMMAND_THREAD_MAIN);
+	ID3D12GraphicsCommandList* cmdList = m_pCmdPool->GetList(entry);
 
-	m_pCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i],
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i],
 		initialState, D3D12_RESOURCE_STATE_COPY_DEST));
 
+	// GetRequiredIntermediateSize() is the exact size, with every subresource on a 512 byte boundary and every row on 256.
 	auto size = GetRequiredIntermediateSize(m_listResources[i], 0, numSubResources);
-	size = (UINT64)pow(2.0, ceil(log(size) / log(2))); // round size up to the next power of 2 to ensure good alignment in upload buffer.
 
-	if (size > DEFAULT_UPLOAD_BUFFER_SIZE) {
+	// what the upload would have taken when sizes were rounded up to the next power of 2.
+	unsigned long long sizePow2 = 1;
+	while (sizePow2 < size) sizePow2 <<= 1;
+	m_sizeUploadPow2 += sizePow2;
+
+	unsigned long long offset = 0;
+	bool isPlaced = PlaceUpload(size, offset);
+
+	if (!isPlaced) {
 		// then we're going to have to create a new temporary buffer.
 		ID3D12Resource* tmpUpload;
 		m_pDev->CreateCommittedResource(tmpUpload, &CD3DX12_RESOURCE_DESC::Buffer(size), &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
 			D3D12_HEAP_FLAG_NONE, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr);
 
-		UpdateSubresources(m_pCmdList, m_listResources[i], tmpUpload, 0, 0, numSubResources, data);
+		UpdateSubresources(cmdList, m_listResources[i], tmpUpload, 0, 0, numSubResources, data);
 
 		// set resource barriers to inform GPU that data is ready for use.
-		m_pCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i],
-			initialState, D3D12_RESOURCE_STATE_COPY_DEST));
-
-		// close the command list.
-		if (FAILED(m_pCmdList->Close())) {
-			throw GFX_Exception("ResourceManager::UploadToBuffer: CommandList Close failed.");
-		}
-
-		// load the command list.
-		ID3D12CommandList* lCmds[] = { m_pCmdList };
-		m_pDev->ExecuteCommandLists(lCmds, __crt_countof(lCmds));
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i],
+			D3D12_RESOURCE_STATE_COPY_DEST, initialState));
 
-		// add fence signal.
-		++m_valFence;
-		m_pDev->SetFence(m_pFence, m_valFence);
+		// close and run the command list.
+		m_valFence = m_pCmdPool->Execute(&entry, 1);
 
 		WaitForGPU();
+		++m_numUploadStalls;
 		tmpUpload->Release();
 	} else {
-		if (size > DEFAULT_UPLOAD_BUFFER_SIZE - m_iUpload) {
-			// then we need to wait for the GPU to finish with whatever it is currently uploading.
-			// check to see if it is already done.
-			if (m_pFence->GetCompletedValue() < m_valFence) {
-				// then we're not done, so wait.
-				WaitForGPU();
-				
-			}
-			m_iUpload = 0;
-		}
-
-		UpdateSubresources(m_pCmdList, m_listResources[i], m_pUpload, m_iUpload, 0, numSubResources, data);
-		m_iUpload += size;
+		UpdateSubresources(cmdList, m_listResources[i], m_pUpload, offset, 0, numSubResources, data);
 
 		// set resource barriers to inform GPU that data is ready for use.
-		m_pCmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i],
+		cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i],
 			D3D12_RESOURCE_STATE_COPY_DEST, initialState));
 
-		// close the command list.
-		if (FAILED(m_pCmdList->Close())) {
-			throw GFX_Exception("ResourceManager::UploadToBuffer: CommandList Close failed.");
-		}
+		// close and run the command list.
+		m_valFence = m_pCmdPool->Execute(&entry, 1);
+	}
+}
 
-		// load the command list.
-		ID3D12CommandList* lCmds[] = { m_pCmdList };
-		m_pDev->ExecuteCommandLists(lCmds, __crt_countof(lCmds));
+// Upload size bytes from data to the buffer stored at index i, starting offset bytes in. The rest of the buffer is left as it was.
+void ResourceManager::UploadToBufferRegion(unsigned int i, unsigned long long offset, const void* data, unsigned long long size,
+	D3D12_RESOURCE_STATES initialState) {
+	if (i >= m_listResources.size()) {
+		std::string msg = "ResourceManager::UploadToBufferRegion failed due to index " + std::to_string(i) + " out of bounds.";
+		throw GFX_Exception(msg.c_str());
+	}
+	if (offset + size > m_listResources[i]->GetDesc().Width) {
+		throw GFX_Exception("ResourceManager::UploadToBufferRegion failed due to the region running past the end of the buffer.");
+	}
 
-		// add fence signal.
-		++m_valFence;
-		m_pDev->SetFence(m_pFence, m_valFence);
+	unsigned long long offsetUpload = 0;
+	if (!PlaceUpload(size, offsetUpload)) {
+		throw GFX_Exception("ResourceManager::UploadToBufferRegion failed due to the region not fitting in the upload buffer.");
 	}
+	WriteUpload(offsetUpload, data, size, size, 1);
+
+	unsigned int entry = m_pCmdPool->Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT, COMMAND_THREAD_MAIN);
+	ID3D12GraphicsCommandList* cmdList = m_pCmdPool->GetList(entry);
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i], initialState, D3D12_RESOURCE_STATE_COPY_DEST));
+	cmdList->CopyBufferRegion(m_listResources[i], offset, m_pUpload, offsetUpload, size);
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i], D3D12_RESOURCE_STATE_COPY_DEST, initialState));
+	m_valFence = m_pCmdPool->Execute(&entry, 1);
 }
 
-// Wait for GPU to signal it has completed with the previous iteration of this frame.
-void ResourceManager::WaitForGPU() {
-	if (FAILED(m_pFence->SetEventOnCompletion(m_valFence, m_hdlFenceEvent))) {
-		throw GFX_Exception("ResourceManager::WaitForGPU failed to SetEventOnCompletion.");
+// Upload the texels inside box of subresource sub of the texture stored at index i. data holds just the texels in the box,
+// rowPitch bytes from one row to the next, bytesPerTexel bytes per texel. The rest of the texture is left as it was.
+void ResourceManager::UploadToTextureRegion(unsigned int i, unsigned int sub, const D3D12_BOX& box, const void* data,
+	unsigned long long rowPitch, unsigned int bytesPerTexel, D3D12_RESOURCE_STATES initialState) {
+	if (i >= m_listResources.size()) {
+		std::string msg = "ResourceManager::UploadToTextureRegion failed due to index " + std::to_string(i) + " out of bounds.";
+		throw GFX_Exception(msg.c_str());
+	}
+	if (box.right <= box.left || box.bottom <= box.top || box.back <= box.front) return;
+
+	// rows in the upload buffer have to start 256 bytes apart.
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+	footprint.Footprint.Format = m_listResources[i]->GetDesc().Format;
+	footprint.Footprint.Width = box.right - box.left;
+	footprint.Footprint.Height = box.bottom - box.top;
+	footprint.Footprint.Depth = box.back - box.front;
+	unsigned long long sizeRow = (unsigned long long)footprint.Footprint.Width * bytesPerTexel;
+	footprint.Footprint.RowPitch = (UINT)AlignUploadOffset(sizeRow, UPLOAD_ROW_PITCH_ALIGNMENT);
+	unsigned int numRows = footprint.Footprint.Height * footprint.Footprint.Depth;
+	unsigned long long size = (unsigned long long)footprint.Footprint.RowPitch * (numRows - 1) + sizeRow;
+
+	if (!PlaceUpload(size, footprint.Offset)) {
+		throw GFX_Exception("ResourceManager::UploadToTextureRegion failed due to the region not fitting in the upload buffer.");
+	}
+	WriteUpload(footprint.Offset, data, sizeRow, rowPitch, numRows, footprint.Footprint.RowPitch);
+
+	unsigned int entry = m_pCmdPool->Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT, COMMAND_THREAD_MAIN);
+	ID3D12GraphicsCommandList* cmdList = m_pCmdPool->GetList(entry);
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i], initialState, D3D12_RESOURCE_STATE_COPY_DEST, sub));
+	CD3DX12_TEXTURE_COPY_LOCATION dst(m_listResources[i], sub);
+	CD3DX12_TEXTURE_COPY_LOCATION src(m_pUpload, footprint);
+	cmdList->CopyTextureRegion(&dst, box.left, box.top, box.front, &src, nullptr);
+	cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(m_listResources[i], D3D12_RESOURCE_STATE_COPY_DEST, initialState, sub));
+	m_valFence = m_pCmdPool->Execute(&entry, 1);
+}
+
+// Find room for size bytes in the upload buffer, waiting for the GPU to finish with it if it's full.
+// Returns false if it can't hold size bytes even when empty.
+bool ResourceManager::PlaceUpload(unsigned long long size, unsigned long long& offset) {
+	bool isPlaced = m_ringUpload.Allocate(size, UPLOAD_PLACEMENT_ALIGNMENT, offset);
+	if (!isPlaced && m_ringUpload.Fits(size)) {
+		// then we need to wait for the GPU to finish with whatever it is currently uploading.
+		// check to see if it is already done.
+		if (!m_pCmdPool->IsComplete(m_valFence)) {
+			// then we're not done, so wait.
+			WaitForGPU();
+			++m_numUploadStalls;
+		}
+		m_ringUpload.Reset();
+		isPlaced = m_ringUpload.Allocate(size, UPLOAD_PLACEMENT_ALIGNMENT, offset);
+	}
+
+	return isPlaced;
+}
+
+// Copy numRows rows of sizeRow bytes, pitchSrc bytes apart in src, to the upload buffer at offset, pitchDst bytes apart.
+void ResourceManager::WriteUpload(unsigned long long offset, const void* src, unsigned long long sizeRow, unsigned long long pitchSrc,
+	unsigned int numRows, unsigned long long pitchDst) {
+	if (pitchDst == 0) pitchDst = sizeRow;
+
+	unsigned char* mapped = nullptr;
+	CD3DX12_RANGE rangeRead(0, 0);	// the CPU never reads the upload buffer.
+	if (FAILED(m_pUpload->Map(0, &rangeRead, reinterpret_cast<void**>(&mapped)))) {
+		throw GFX_Exception("ResourceManager::WriteUpload failed to map the upload buffer.");
 	}
+	for (unsigned int r = 0; r < numRows; ++r) {
+		memcpy(mapped + offset + r * pitchDst, (const unsigned char*)src + r * pitchSrc, (size_t)sizeRow);
+	}
+	CD3DX12_RANGE rangeWritten((SIZE_T)offset, (SIZE_T)(offset + (numRows - 1) * pitchDst + sizeRow));
+	m_pUpload->Unmap(0, &rangeWritten);
+}
 
-	WaitForSingleObject(m_hdlFenceEvent, INFINITE);
+// Wait for the GPU to finish the last upload.
+void ResourceManager::WaitForGPU() {
+	m_pCmdPool->WaitForFence(m_valFence);
 }
 
 // return a pointer to the resource at the provided index
@@ -343,6 +441,48 @@ ID3D12Resource* ResourceManager::GetResource(unsigned int index) {
 	return m_listResources[index];
 }
 
+// return the number of bytes allocated for the resource at the provided index.
+unsigned long long ResourceManager::GetResourceSize(unsigned int index) {
+	if (index >= m_listAllocations.size()) {
+		std::string msg = "ResourceManager::GetResourceSize failed due to index " + std::to_string(index) + " out of bounds.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	return m_listAllocations[index].size;
+}
+
+// return the number of bytes allocated in heaps of the provided type, including the internal upload buffer.
+unsigned long long ResourceManager::GetMemoryUsage(D3D12_HEAP_TYPE type) {
+	unsigned long long total = type == D3D12_HEAP_TYPE_UPLOAD ? m_sizeUpload : 0;
+	for (auto it = m_listAllocations.begin(); it != m_listAllocations.end(); ++it) {
+		if (it->heap == type) total += it->size;
+	}
+
+	return total;
+}
+
+// write a summary of the memory allocated by heap type to the debug output.
+void ResourceManager::ReportMemoryUsage() {
+	char msg[256];
+	sprintf_s(msg, "ResourceManager: %u resources. default heap %.2f MB, upload heap %.2f MB, readback heap %.2f MB.\n",
+		(unsigned int)m_listResources.size(), (double)GetMemoryUsage(D3D12_HEAP_TYPE_DEFAULT) / 1048576.0,
+		(double)GetMemoryUsage(D3D12_HEAP_TYPE_UPLOAD) / 1048576.0, (double)GetMemoryUsage(D3D12_HEAP_TYPE_READBACK) / 1048576.0);
+	OutputDebugStringA(msg);
+}
+
+// write a summary of how the upload buffer has been used to the debug output.
+void ResourceManager::ReportUploadUsage() {
+	auto stats = m_ringUpload.GetStats();
+	char msg[512];
+	sprintf_s(msg, "ResourceManager: %llu uploads placed in the upload buffer. %.2f MB requested, %.2f KB of alignment padding, "
+		"high water mark %.2f MB of %.2f MB, %llu resets. %llu uploads too large for the buffer, %llu stalls waiting on the GPU. "
+		"Rounding to powers of 2 would have used %.2f MB.\n",
+		stats.numAllocations, (double)stats.bytesRequested / 1048576.0, (double)stats.bytesPadding / 1024.0,
+		(double)stats.bytesHighWater / 1048576.0, (double)m_ringUpload.GetSize() / 1048576.0, stats.numResets, stats.numTooLarge,
+		m_numUploadStalls, (double)m_sizeUploadPow2 / 1048576.0);
+	OutputDebugStringA(msg);
+}
+
 // load a file and return the index of the data loaded in m_listFileData.
 unsigned int ResourceManager::LoadFile(const char* fn, unsigned int& h, unsigned int& w) {
 	unsigned char* data;
@@ -10,6 +10,13 @@ Usage:			- Proper shutdown is handled by the destructor.
 				- Handles loading file data (LoadFile(), GetFileData())
 				- Manages all resource heaps.
 				- Manages all ID3D12Resources.
+				- Tracks how much memory its resources take up. See GetMemoryUsage() and ReportMemoryUsage().
+				- Uploads are placed in the upload buffer as per UploadPlacement.h and take exactly the space
+					GetCopyableFootprints() says they need, which the UploadPlacement tests check on odd sized textures.
+					ReportUploadUsage() prints how well the upload buffer is used.
+				- UploadToBufferRegion() and UploadToTextureRegion() update part of a resource in place, ie the texels
+					of a heightmap that were edited, copying only that part through the upload buffer.
+				- Uploads are recorded on command lists from the CommandListPool passed in, which must outlive the ResourceManager.
 
 Future Work:	- Add and remove resources dynamically.
 				- Add support for loading different file types. Currently only supports PNG.
@@ -18,15 +25,23 @@ Future Work:	- Add and remove resources dynamically.
 #pragma once
 
 #include "Graphics.h"
+#include "CommandListPool.h"
+#include "UploadPlacement.h"
 #include <vector>
 
 using namespace graphics;
 
 static const unsigned long long DEFAULT_UPLOAD_BUFFER_SIZE = 100000000;
 
+// How much memory a resource takes up and which type of heap it lives in.
+struct ResourceAllocation {
+	unsigned long long	size;
+	D3D12_HEAP_TYPE		heap;
+};
+
 class ResourceManager {
 public:
-	ResourceManager(Device* d, unsigned int numRTVs, unsigned int numDSVs, unsigned int numCBVSRVUAVs, 
+	ResourceManager(Device* d, CommandListPool* pool, unsigned int numRTVs, unsigned int numDSVs, unsigned int numCBVSRVUAVs, 
 		unsigned int numSamplers);
 	~ResourceManager();
 
@@ -39,6 +54,14 @@ public:
 	void AddSRV(ID3D12Resource* tex, D3D12_SHADER_RESOURCE_VIEW_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE& handleCPU,
 		D3D12_GPU_DESCRIPTOR_HANDLE& handleGPU);
 	void AddSampler(D3D12_SAMPLER_DESC* desc, D3D12_CPU_DESCRIPTOR_HANDLE& handleCPU);
+	// Reserve num contiguous slots in the CBV/SRV/UAV heap for use as a descriptor table. Returns the index of the first slot.
+	unsigned int ReserveCBVSRVUAVTable(unsigned int num);
+	// Create an SRV in slot i of the CBV/SRV/UAV heap. The slot must have been reserved with ReserveCBVSRVUAVTable().
+	void AddSRVAt(unsigned int i, ID3D12Resource* tex, D3D12_SHADER_RESOURCE_VIEW_DESC* desc);
+	// Create a UAV in slot i of the CBV/SRV/UAV heap. The slot must have been reserved with ReserveCBVSRVUAVTable().
+	void AddUAVAt(unsigned int i, ID3D12Resource* tex, D3D12_UNORDERED_ACCESS_VIEW_DESC* desc);
+	// return the GPU handle for slot i of the CBV/SRV/UAV heap.
+	D3D12_GPU_DESCRIPTOR_HANDLE GetCBVSRVUAVHandleGPU(unsigned int i);
 
 	// takes a pointer to the existing resource, adds it to the list of resources, and returns the index to that resource.
 	unsigned int AddExistingResource(ID3D12Resource* tex);
@@ -51,9 +74,24 @@ public:
 		D3D12_HEAP_PROPERTIES* props, D3D12_HEAP_FLAGS flags, D3D12_RESOURCE_STATES state, D3D12_CLEAR_VALUE* clear);
 	// Upload to the buffer stored at index i.
 	void UploadToBuffer(unsigned int i, unsigned int numSubResources, D3D12_SUBRESOURCE_DATA* data, D3D12_RESOURCE_STATES initialState);
+	// Upload size bytes from data to the buffer stored at index i, starting offset bytes in. The rest of the buffer is left as it was.
+	void UploadToBufferRegion(unsigned int i, unsigned long long offset, const void* data, unsigned long long size,
+		D3D12_RESOURCE_STATES initialState);
+	// Upload the texels inside box of subresource sub of the texture stored at index i. data holds just the texels in the box,
+	// rowPitch bytes from one row to the next, bytesPerTexel bytes per texel. The rest of the texture is left as it was.
+	void UploadToTextureRegion(unsigned int i, unsigned int sub, const D3D12_BOX& box, const void* data, unsigned long long rowPitch,
+		unsigned int bytesPerTexel, D3D12_RESOURCE_STATES initialState);
 
 	// return a pointer to the resource at the provided index
 	ID3D12Resource* GetResource(unsigned int index);
+	// return the number of bytes allocated for the resource at the provided index.
+	unsigned long long GetResourceSize(unsigned int index);
+	// return the number of bytes allocated in heaps of the provided type, including the internal upload buffer.
+	unsigned long long GetMemoryUsage(D3D12_HEAP_TYPE type);
+	// write a summary of the memory allocated by heap type to the debug output.
+	void ReportMemoryUsage();
+	// write a summary of how the upload buffer has been used to the debug output.
+	void ReportUploadUsage();
 
 	// load a file and return the index of the data loaded in m_listFileData.
 	unsigned int LoadFile(const char* fn, unsigned int& h, unsigned int& w);
@@ -62,24 +100,33 @@ public:
 	// tell the ResourceManager that you are done with the data saved at index i in m_listFileData.
 	// it will delete that data. Leaves a NULL pointer in the list so as not to mess with other indices.
 	void UnloadFileData(unsigned int i);
-	// Wait for GPU to signal it has completed with the previous iteration of this frame.
+	// Wait for the GPU to finish the last upload.
 	void WaitForGPU();
 
 private:
+	// Find room for size bytes in the upload buffer, waiting for the GPU to finish with it if it's full.
+	// Returns false if it can't hold size bytes even when empty.
+	bool PlaceUpload(unsigned long long size, unsigned long long& offset);
+	// Copy numRows rows of sizeRow bytes, pitchSrc bytes apart in src, to the upload buffer at offset, pitchDst bytes apart.
+	// pitchDst defaults to sizeRow.
+	void WriteUpload(unsigned long long offset, const void* src, unsigned long long sizeRow, unsigned long long pitchSrc,
+		unsigned int numRows, unsigned long long pitchDst = 0);
+
 	Device*							m_pDev;
-	ID3D12CommandAllocator*			m_pCmdAllocator;
-	ID3D12GraphicsCommandList*		m_pCmdList;
-	ID3D12Fence*					m_pFence;
-	HANDLE							m_hdlFenceEvent;
+	CommandListPool*				m_pCmdPool;
 	ID3D12DescriptorHeap*			m_pheapRTV;						// Render Target View Heap.
 	ID3D12DescriptorHeap*			m_pheapDSV;						// Depth Stencil View Heap.
 	ID3D12DescriptorHeap*			m_pheapCBVSRVUAV;				// Constant Buffer View, Shader Resource View, and Unordered Access View heap.
 	ID3D12DescriptorHeap*			m_pheapSampler;					// Sampler heap.
 	std::vector<ID3D12Resource*>	m_listResources;
+	std::vector<ResourceAllocation>	m_listAllocations;				// memory used by each resource in m_listResources.
 	std::vector<unsigned char*>		m_listFileData;					// Any data loaded from files.
 	ID3D12Resource*					m_pUpload;
-	unsigned long long				m_iUpload;						// index into upload buffer where free space starts.
-	unsigned long long				m_valFence;						// Value to check fence against to confirm GPU is done.
+	UploadRing						m_ringUpload;					// hands out space in m_pUpload.
+	unsigned long long				m_sizeUpload;					// memory used by the upload buffer.
+	unsigned long long				m_valFence;						// the pool's fence value of the last upload.
+	unsigned long long				m_numUploadStalls;				// uploads that had to wait for the GPU to finish with the upload buffer.
+	unsigned long long				m_sizeUploadPow2;				// space the uploads would have taken rounded up to powers of 2.
 	unsigned int					m_numRTVs;
 	unsigned int					m_numDSVs;
 	unsigned int					m_numCBVSRVUAVs;
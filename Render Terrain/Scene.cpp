@@ -8,26 +8,79 @@ Description:	Class for creating, managing, and rendering a scene.
 */
 #include "Scene.h"
 #include <stdlib.h>
+#include <chrono>
+#include <string>
 
-Scene::Scene(int height, int width, Device* DEV) : 
-	m_ResMgr(DEV, FRAME_BUFFER_COUNT, 6, 23, 0), m_Cam(height, width), m_DNC(6000, 4096) {
+Scene::Scene(int height, int width, Device* DEV) : m_CmdPool(DEV, 1),
+	m_ResMgr(DEV, &m_CmdPool, FRAME_BUFFER_COUNT, 2, NUM_TERRAIN_SRV_SLOTS * WORLD_TILES_X * WORLD_TILES_Y +
+		HiZPyramid::CalcNumDescriptors(height, width, 1), 0), m_PSOMgr(DEV), m_Cam(height, width),
+	m_DNC(6000, ShadowAtlas::CalcCascadeSize(SHADOW_ATLAS_SIZE, SHADOW_CASCADE_COUNT), SHADOW_CASCADE_COUNT, SHADOW_SPLIT_LAMBDA) {
 	m_pDev = DEV;
+	m_pWorld = nullptr;
 	m_pT = nullptr;
+	m_pShadowAtlas = nullptr;
+	m_pCuller = nullptr;
+	m_pHiZ = nullptr;
+	m_pGraphRes = nullptr;
+	m_pDepthBuffer = nullptr;
+	m_pCmdList = nullptr;
+	m_pSim = nullptr;
+	// routing each instance to its own viewport from the domain shader needs hardware support. 
+	// Otherwise fall back to one draw per cascade.
+	m_isSinglePassShadows = m_pDev->SupportsViewportIndexFromAnyShader();
+	for (int i = 0; i < MAX_SHADOW_CASCADES; ++i) {
+		m_numCascadesRendered[i] = 0;
+		m_sumTexelDensity[i] = 0.0f;
+		m_sumTexelDensitySphere[i] = 0.0f;
+	}
 
 	for (int i = 0; i < FRAME_BUFFER_COUNT; ++i) {
-		m_pFrames[i] = new Frame(i, m_pDev, &m_ResMgr, height, width, 4096);
+		m_pFrames[i] = new Frame(i, m_pDev, &m_ResMgr, &m_CmdPool, height, width);
 	}
+	// every frame renders on the same queue, so they can all share one shadow atlas.
+	m_pShadowAtlas = new ShadowAtlas(&m_ResMgr, SHADOW_ATLAS_SIZE, SHADOW_CASCADE_COUNT);
+	// for the same reason they can share one depth buffer.
+	InitRenderGraph(height, width);
 
 	XMFLOAT4 colors[] = { XMFLOAT4(0.35f, 0.5f, 0.18f, 1.0f), XMFLOAT4(0.89f, 0.89f, 0.89f, 1.0f),
 		XMFLOAT4(0.31f, 0.25f, 0.2f, 1.0f), XMFLOAT4(0.39f, 0.37f, 0.38f, 1.0f) };
-	m_pT = new Terrain(&m_ResMgr, new TerrainMaterial(&m_ResMgr, "grassnormals.png", "snownormals.png",
+	// there's only the one heightmap so far. The tiles' seams are matched when the world is built.
+	const char* fnHeightMaps[WORLD_TILES_X * WORLD_TILES_Y];
+	for (unsigned int t = 0; t < WORLD_TILES_X * WORLD_TILES_Y; ++t) {
+		fnHeightMaps[t] = "heightmap6.png";
+	}
+	m_pWorld = new TerrainWorld(&m_ResMgr, new TerrainMaterial(&m_ResMgr, "grassnormals.png", "snownormals.png",
 		"dirtnormals.png", "rocknormals.png", "grassdiffuse.png", "snowdiffuse.png", "dirtdiffuse.png",
-		"rockdiffuse.png", colors), "heightmap6.png", "displacement.png");
+		"rockdiffuse.png", colors), WORLD_TILES_X, WORLD_TILES_Y, fnHeightMaps, "displacement.png");
+	m_pT = m_pWorld->GetTile(0);
+	// fit the shadow cascades to the height of the terrain in view rather than the height range of the whole terrain.
+	m_DNC.SetSceneBlocks(m_pWorld->GetBlockBounds(), m_pWorld->GetNumBlocks());
+
+	std::vector<PatchCullData> patches;
+	m_pT->GetPatchCullData(patches);
+	// occlusion culling tests against the pyramid built from the previous frame's depth buffer.
+	m_pHiZ = new HiZPyramid(m_pDev, &m_ResMgr, &m_PSOMgr, height, width, 1);
+	m_pHiZ->SetSource(0, m_pDepthBuffer);
+	m_pCuller = new PatchCuller(m_pDev, &m_ResMgr, &m_PSOMgr, m_pHiZ, patches, FRAME_BUFFER_COUNT);
+
+	// build one contiguous SRV table per tile so each tile binds with a single descriptor table.
+	// The shadow atlas is shared, so the tables are the same for every frame.
+	m_pWorld->CreateResourceViews();
+	for (unsigned int t = 0; t < m_pWorld->GetNumTiles(); ++t) {
+		m_pShadowAtlas->CreateResourceView(m_pWorld->GetSRVTableIndex(t) + SRV_SLOT_SHADOWATLAS);
+	}
+	m_hdlTerrainSRVTable = m_pWorld->GetSRVTable(0);
 
-	m_ResMgr.WaitForGPU();
+	for (int i = 0; i < FRAME_BUFFER_COUNT; ++i) {
+		// the single pass draws the union of the cascades' patch lists. Drawing one cascade at a time needs room for every list.
+		m_pFrames[i]->InitShadowPatchBuffer(m_pT->GetNumIndices() * (m_isSinglePassShadows ? 1 : m_pShadowAtlas->GetNumCascades()));
+	}
 
-	m_pDev->CreateGraphicsCommandList(D3D12_COMMAND_LIST_TYPE_DIRECT, m_pFrames[0]->GetAllocator(), m_pCmdList);
-	CloseCommandLists();
+	m_ResMgr.WaitForGPU();
+	m_ResMgr.ReportMemoryUsage();
+	m_ResMgr.ReportUploadUsage();
+	m_pT->ReportBufferSizes();
+	ReportRenderGraph();
 
 	// create a viewport and scissor rectangle.
 	m_vpMain.TopLeftX = 0;
@@ -43,30 +96,60 @@ Scene::Scene(int height, int width, Device* DEV) :
 	m_srMain.bottom = height;
 
 	// Initialize Graphics Pipelines for 2D and 3D rendering.
+	// The PSOs are built on worker threads, so wait for them before reporting how long startup took.
+	InitRootSignature();
 	InitPipelineTerrain2D();
 	InitPipelineTerrain3D();
 	InitPipelineShadowMap();
+	m_PSOMgr.ReportMetrics();
+
+	// from here on the camera and the day/night cycle belong to the simulation thread. The scene draws copies of them.
+	SimSnapshot initial = { m_Cam, m_DNC, 0, 0, m_drawMode, m_UseTextures, m_isGPUCulling, m_isOcclusionCulling, m_isProceduralPatches, true };
+	m_pSim = new Simulation(initial, m_pWorld, &m_Input);
+	if (SIM_CAMERA_PATH_FILE) {
+		m_pSim->SetPathRecording(SIM_CAMERA_PATH_FILE);
+	}
+	if (SIM_LOCKSTEP) {
+		// morning to evening over two minutes of simulated time.
+		m_curveBenchmark.AddKey(0.0, 60.0f);
+		m_curveBenchmark.AddKey(60000.0, 180.0f);
+		m_curveBenchmark.AddKey(120000.0, 300.0f);
+		m_pSim->SetTimeOfDayCurve(&m_curveBenchmark);
+	} else {
+		m_pSim->Start();
+	}
 }
 
 Scene::~Scene() {
-	while (!m_listRootSigs.empty()) {
-		ID3D12RootSignature* sigRoot = m_listRootSigs.back();
+	// the simulation reads the terrain, so it has to stop first.
+	if (m_pSim) {
+		delete m_pSim;
+	}
 
-		if (sigRoot) sigRoot->Release();
+	// up to FRAME_BUFFER_COUNT frames can still be in flight.
+	m_CmdPool.WaitForIdle();
 
-		m_listRootSigs.pop_back();
+	// root signatures and PSOs are owned and released by m_PSOMgr.
+	// the first tile belongs to the world.
+	m_pT = nullptr;
+	if (m_pWorld) {
+		delete m_pWorld;
 	}
 
-	while (!m_listPSOs.empty()) {
-		ID3D12PipelineState* pso = m_listPSOs.back();
+	if (m_pShadowAtlas) {
+		delete m_pShadowAtlas;
+	}
 
-		if (pso) pso->Release();
+	if (m_pCuller) {
+		delete m_pCuller;
+	}
 
-		m_listPSOs.pop_back();
+	if (m_pHiZ) {
+		delete m_pHiZ;
 	}
 
-	if (m_pT) {
-		delete m_pT;
+	if (m_pGraphRes) {
+		delete m_pGraphRes;
 	}
 
 	for (int i = 0; i < FRAME_BUFFER_COUNT; ++i) {
@@ -76,44 +159,133 @@ Scene::~Scene() {
 	m_pDev = nullptr;
 }
 
-// Close all command lists. Currently there is only the one.
-void Scene::CloseCommandLists() {
-	// close the command list.
-	if (FAILED(m_pCmdList->Close())) {
-		throw GFX_Exception("Scene::CloseCommandLists failed.");
+// Add the resources of the frame's render graph, place its transient resources, and create them.
+// The back buffers and the shadow atlas live on from frame to frame, so they are imported. The depth buffer is only needed
+// from the render pass to the Hi-Z build, so it is transient.
+void Scene::InitRenderGraph(int height, int width) {
+	RenderGraphResourceDesc descBackBuffer = { "Back Buffer", 0, 0, RG_STATE_PRESENT, RG_STATE_PRESENT, false };
+	m_iGraphBackBuffer = m_Graph.AddResource(descBackBuffer);
+	RenderGraphResourceDesc descAtlas = { "Shadow Atlas", 0, 0, RG_STATE_PIXEL_SHADER_RESOURCE, RG_STATE_PIXEL_SHADER_RESOURCE, false };
+	m_iGraphShadowAtlas = m_Graph.AddResource(descAtlas);
+
+	// typeless so the depth can also be read as R32_FLOAT when building the Hi-Z pyramid.
+	auto descDepth = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_TYPELESS, width, height, 1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+	RenderGraphResourceDesc descGraphDepth = { "Depth Buffer", m_pDev->GetResourceAllocationSize(&descDepth), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT,
+		RG_STATE_DEPTH_WRITE, RG_STATE_DEPTH_WRITE, true };
+	m_iGraphDepthBuffer = m_Graph.AddResource(descGraphDepth);
+
+	// place the transient resources with every pass a frame can have.
+	unsigned int listCascades[MAX_SHADOW_CASCADES] = {};
+	DeclareFramePasses(listCascades, 1, true, true);
+	if (!m_Graph.Compile()) {
+		std::string msg = "Scene::InitRenderGraph: " + m_Graph.GetError();
+		throw GFX_Exception(msg.c_str());
 	}
+
+	m_pGraphRes = new RenderGraphResources(m_pDev, &m_Graph);
+	m_pGraphRes->CreateHeap(D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES);
+	m_pGraphRes->Import(m_iGraphShadowAtlas, m_pShadowAtlas->GetAtlas());
+
+	D3D12_CLEAR_VALUE clearDepth = {};
+	clearDepth.Format = DXGI_FORMAT_D32_FLOAT;
+	clearDepth.DepthStencil.Depth = 1.0f;
+	clearDepth.DepthStencil.Stencil = 0;
+	m_pDepthBuffer = m_pGraphRes->CreateTransient(m_iGraphDepthBuffer, &descDepth, &clearDepth);
+	m_pDepthBuffer->SetName(L"Depth/Stencil Buffer");
+
+	D3D12_DEPTH_STENCIL_VIEW_DESC descDSV = {};
+	descDSV.Format = DXGI_FORMAT_D32_FLOAT;
+	descDSV.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+	descDSV.Flags = D3D12_DSV_FLAG_NONE;
+	m_ResMgr.AddDSV(m_pDepthBuffer, &descDSV, m_hdlDSV);
 }
 
-// Initialize the root signature and pipeline state object for rendering the terrain in 2D.
-void Scene::InitPipelineTerrain2D() {
-	// set up the Root Signature.
-	// create a descriptor table with 1 entry for the descriptor heap containing our SRV to the heightmap.
-	CD3DX12_DESCRIPTOR_RANGE rangesRoot[3];
-	CD3DX12_ROOT_PARAMETER paramsRoot[3];
-	// height map
-	rangesRoot[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
-	paramsRoot[0].InitAsDescriptorTable(1, &rangesRoot[0]);
-	// displacement map
-	rangesRoot[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
-	paramsRoot[1].InitAsDescriptorTable(1, &rangesRoot[1]);
+// Declare the passes of a frame in the render graph. The shadow pass is left out when no cascades are listed.
+// The passes record into m_pCmdList when the graph is executed, so cascades must still be around then.
+void Scene::DeclareFramePasses(const unsigned int* cascades, unsigned int numCascades, bool isCulling, bool isBuildingHiZ) {
+	m_Graph.ResetPasses();
+
+	// the culling pass builds the patch lists for both the shadow and render passes. The culler handles its own buffers.
+	if (isCulling) {
+		m_Graph.AddPass("Cull Patches", [this, cascades, numCascades]() { CullPatchesGPU(m_pCmdList, cascades, numCascades); });
+	}
+
+	unsigned int pass;
+	if (numCascades > 0) {
+		pass = m_Graph.AddPass("Shadow Map", [this, cascades, numCascades]() { DrawShadowMap(m_pCmdList, cascades, numCascades); });
+		m_Graph.Write(pass, m_iGraphShadowAtlas, RG_STATE_DEPTH_WRITE);
+	}
+
+	pass = m_Graph.AddPass("Terrain", [this]() { DrawTerrain(m_pCmdList); });
+	m_Graph.Read(pass, m_iGraphShadowAtlas, RG_STATE_PIXEL_SHADER_RESOURCE);
+	m_Graph.Write(pass, m_iGraphBackBuffer, RG_STATE_RENDER_TARGET);
+	m_Graph.Write(pass, m_iGraphDepthBuffer, RG_STATE_DEPTH_WRITE);
+
+	// build the pyramid for the next frame's occlusion culling while this frame's depth buffer is still around.
+	if (isBuildingHiZ) {
+		pass = m_Graph.AddPass("Hi-Z Pyramid", [this]() { m_pHiZ->Build(m_pCmdList, 0); });
+		m_Graph.Read(pass, m_iGraphDepthBuffer, RG_STATE_NON_PIXEL_SHADER_RESOURCE);
+	}
+}
+
+// Write the render graph's barrier counts and memory use to the debug output.
+// Before the graph, every frame had a depth buffer of its own.
+void Scene::ReportRenderGraph() {
+	auto stats = m_Graph.GetStats();
+	unsigned long long sizePerFrame = m_Graph.GetResourceDesc(m_iGraphDepthBuffer).size * FRAME_BUFFER_COUNT;
+
+	char msg[512];
+	sprintf_s(msg, "Render graph: %u passes, %u barriers in %u batches, %u split, %u aliasing. Transient resources %.2f MB "
+		"in a %.2f MB heap (%.2f MB saved by aliasing). Per frame depth buffers took %.2f MB.\n",
+		stats.numPasses, stats.numBarriers, stats.numBatches, stats.numSplitBarriers, stats.numAliasingBarriers,
+		(double)stats.sizeTransient / 1048576.0, (double)m_pGraphRes->GetHeapSize() / 1048576.0,
+		(double)(stats.sizeTransient - stats.sizeHeap) / 1048576.0, (double)sizePerFrame / 1048576.0);
+	OutputDebugStringA(msg);
+}
+
+// Initialize the root signature shared by all of the terrain pipelines.
+// Sharing a single root signature means switching between the shadow and render passes never invalidates
+// the root arguments and the driver only has to deal with one layout.
+void Scene::InitRootSignature() {
+	CD3DX12_ROOT_PARAMETER paramsRoot[NUM_ROOT_PARAMS];
+	CD3DX12_DESCRIPTOR_RANGE rangesRoot[1];
+
+	// cascade map for the shadow pass, and the base vertex of the chunk being drawn. See Terrain::DrawChunks().
+	paramsRoot[ROOT_PARAM_CONSTANTS].InitAsConstants(2, 2);
 	// terrain constants
-	rangesRoot[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-	paramsRoot[2].InitAsDescriptorTable(1, &rangesRoot[2]);
+	paramsRoot[ROOT_PARAM_TERRAIN_CBV].InitAsConstantBufferView(0);
+	// frame constants or shadow constants
+	paramsRoot[ROOT_PARAM_FRAME_CBV].InitAsConstantBufferView(1);
+	// height map, displacement map, shadow atlas, and material in one table.
+	rangesRoot[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, NUM_TERRAIN_SRV_SLOTS, 0);
+	paramsRoot[ROOT_PARAM_SRV_TABLE].InitAsDescriptorTable(1, &rangesRoot[0]);
 
-	// create our texture sampler for the heightmap.
-	CD3DX12_STATIC_SAMPLER_DESC	descSamplers[1];
+	// create our texture samplers for the heightmap.
+	CD3DX12_STATIC_SAMPLER_DESC	descSamplers[4];
 	descSamplers[0].Init(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
+	descSamplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
+	descSamplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	descSamplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	descSamplers[1].Init(1, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
+	descSamplers[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_DOMAIN;
+	descSamplers[2].Init(2, D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT);
+	descSamplers[2].AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER; 
+	descSamplers[2].AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+	descSamplers[2].MaxAnisotropy = 1;
+	descSamplers[2].ComparisonFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	descSamplers[2].BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+	descSamplers[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+	descSamplers[3].Init(3, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
+	descSamplers[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
 
 	// It isn't really necessary to deny the other shaders access, but it does technically allow the GPU to optimize more.
 	CD3DX12_ROOT_SIGNATURE_DESC	descRoot;
-	descRoot.Init(_countof(paramsRoot), paramsRoot, 1, descSamplers, D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS |
-		D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
-		D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
-		D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS);
-	ID3D12RootSignature* sigRoot;
-	m_pDev->CreateRootSig(&descRoot, sigRoot);
-	m_listRootSigs.push_back(sigRoot); // save a copy of the pointer to the root signature.
+	descRoot.Init(_countof(paramsRoot), paramsRoot, _countof(descSamplers), descSamplers, D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS);
+	m_pRootSig = m_PSOMgr.CreateRootSig(&descRoot);
+}
 
+// Initialize the pipeline state object for rendering the terrain in 2D.
+void Scene::InitPipelineTerrain2D() {
 	D3D12_SHADER_BYTECODE bcPS = {};
 	D3D12_SHADER_BYTECODE bcVS = {};
 	CompileShader(L"RenderTerrain2dVS.hlsl", VERTEX_SHADER, bcVS);
@@ -124,7 +296,7 @@ void Scene::InitPipelineTerrain2D() {
 	
 	// create the pipeline state object
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC descPSO = {};
-	descPSO.pRootSignature = sigRoot;
+	descPSO.pRootSignature = m_pRootSig;
 	descPSO.VS = bcVS;
 	descPSO.PS = bcPS;
 	descPSO.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
@@ -138,63 +310,11 @@ void Scene::InitPipelineTerrain2D() {
 	descPSO.DepthStencilState.DepthEnable = false;
 	descPSO.DepthStencilState.StencilEnable = false;
 	
-	ID3D12PipelineState* pso;
-	m_pDev->CreatePSO(&descPSO, pso);
-	m_listPSOs.push_back(pso); // save a copy of the pointer to the PSO.
+	m_listPSOs[PIPELINE_TERRAIN_2D] = m_PSOMgr.RequestPipeline(&descPSO); // save the handle to the PSO.
 }
 
-// Initialize the root signature and pipeline state object for rendering the terrain in 3D.
+// Initialize the pipeline state object for rendering the terrain in 3D.
 void Scene::InitPipelineTerrain3D() {
-	// set up the Root Signature.
-	// create a descriptor table.
-	CD3DX12_ROOT_PARAMETER paramsRoot[6];
-	CD3DX12_DESCRIPTOR_RANGE rangesRoot[6];
-	
-	// height map
-	rangesRoot[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
-	paramsRoot[0].InitAsDescriptorTable(1, &rangesRoot[0]);
-	// displacement map
-	rangesRoot[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
-	paramsRoot[1].InitAsDescriptorTable(1, &rangesRoot[1]);
-	// terrain constants
-	rangesRoot[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-	paramsRoot[2].InitAsDescriptorTable(1, &rangesRoot[2]);
-	// frame constants
-	rangesRoot[3].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1);
-	paramsRoot[3].InitAsDescriptorTable(1, &rangesRoot[3]);
-	// shadow atlas
-	rangesRoot[4].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2);
-	paramsRoot[4].InitAsDescriptorTable(1, &rangesRoot[4]);
-	// material
-	rangesRoot[5].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 3);
-	paramsRoot[5].InitAsDescriptorTable(1, &rangesRoot[5], D3D12_SHADER_VISIBILITY_PIXEL);
-
-	// create our texture samplers for the heightmap.
-	CD3DX12_STATIC_SAMPLER_DESC	descSamplers[4];
-	descSamplers[0].Init(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
-	descSamplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-	descSamplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-	descSamplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-	descSamplers[1].Init(1, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
-	descSamplers[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_DOMAIN;
-	descSamplers[2].Init(2, D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT);
-	descSamplers[2].AddressU = D3D12_TEXTURE_ADDRESS_MODE_BORDER; 
-	descSamplers[2].AddressV = D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-	descSamplers[2].MaxAnisotropy = 1;
-	descSamplers[2].ComparisonFunc = D3D12_COMPARISON_FUNC_LESS_EQUAL;
-	descSamplers[2].BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
-	descSamplers[2].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
-	descSamplers[3].Init(3, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
-	descSamplers[3].ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL;
-
-	// It isn't really necessary to deny the other shaders access, but it does technically allow the GPU to optimize more.
-	CD3DX12_ROOT_SIGNATURE_DESC	descRoot;
-	descRoot.Init(_countof(paramsRoot), paramsRoot, 4, descSamplers, D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS |
-		D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
-	ID3D12RootSignature* sigRoot;
-	m_pDev->CreateRootSig(&descRoot, sigRoot);
-	m_listRootSigs.push_back(sigRoot);
-
 	D3D12_SHADER_BYTECODE bcPS = {};
 	D3D12_SHADER_BYTECODE bcVS = {};
 	D3D12_SHADER_BYTECODE bcHS = {};
@@ -208,21 +328,9 @@ void Scene::InitPipelineTerrain3D() {
 	descSample.Count = 1; // turns multi-sampling off. Not supported feature for my card.
 	
 	// create the pipeline state object
-	// create input layout.
-	D3D12_INPUT_LAYOUT_DESC	descInputLayout = {};
-	D3D12_INPUT_ELEMENT_DESC descElementLayout[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "POSITION", 1, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "POSITION", 2, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "SKIRT", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-	};
-
-	descInputLayout.NumElements = sizeof(descElementLayout) / sizeof(D3D12_INPUT_ELEMENT_DESC);
-	descInputLayout.pInputElementDescs = descElementLayout;
-
+	// there's no input layout. The vertex shader builds each control point from SV_VertexID and the terrain's structured buffer of PackedVertex.
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC descPSO = {};
-	descPSO.pRootSignature = sigRoot;
-	descPSO.InputLayout = descInputLayout;
+	descPSO.pRootSignature = m_pRootSig;
 	descPSO.VS = bcVS;
 	descPSO.PS = bcPS;
 	descPSO.HS = bcHS;
@@ -239,52 +347,20 @@ void Scene::InitPipelineTerrain3D() {
 	descPSO.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 	descPSO.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
 
-	ID3D12PipelineState* pso;
-	m_pDev->CreatePSO(&descPSO, pso);
-	m_listPSOs.push_back(pso);
+	m_listPSOs[PIPELINE_TERRAIN_3D] = m_PSOMgr.RequestPipeline(&descPSO);
+
+	// the same pipeline, but with the control points of each patch generated from SV_VertexID.
+	CompileShader(L"RenderTerrainTessProceduralVS.hlsl", VERTEX_SHADER, descPSO.VS);
+	m_listPSOs[PIPELINE_TERRAIN_3D_PROCEDURAL] = m_PSOMgr.RequestPipeline(&descPSO);
 }
 
-// Initialize the root signature and pipeline state object for rendering to the shadow map.
+// Initialize the pipeline state objects for rendering to the shadow map, one cascade at a time and all at once.
 void Scene::InitPipelineShadowMap() {
-	// set up the Root Signature.
-	// create a descriptor table with 2 entries for the descriptor heap containing our SRV to the heightmap and our CBV.
-	CD3DX12_ROOT_PARAMETER paramsRoot[4];
-	CD3DX12_DESCRIPTOR_RANGE rangesRoot[4];
-	
-	// heightmap
-	rangesRoot[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
-	paramsRoot[0].InitAsDescriptorTable(1, &rangesRoot[0]);
-	// displacement map
-	rangesRoot[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 1);
-	paramsRoot[1].InitAsDescriptorTable(1, &rangesRoot[1]);
-	// terrain constants
-	rangesRoot[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
-	paramsRoot[2].InitAsDescriptorTable(1, &rangesRoot[2]);
-	// shadow constants
-	rangesRoot[3].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1);
-	paramsRoot[3].InitAsDescriptorTable(1, &rangesRoot[3]);
-
-	// create our texture samplers for the heightmap.
-	CD3DX12_STATIC_SAMPLER_DESC	descSamplers[2];
-	descSamplers[0].Init(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
-	descSamplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_DOMAIN;
-	descSamplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-	descSamplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
-	descSamplers[1].Init(1, D3D12_FILTER_MIN_MAG_MIP_LINEAR);
-	descSamplers[1].ShaderVisibility = D3D12_SHADER_VISIBILITY_DOMAIN;
-
-	// It isn't really necessary to deny the other shaders access, but it does technically allow the GPU to optimize more.
-	CD3DX12_ROOT_SIGNATURE_DESC	descRoot;
-	descRoot.Init(_countof(paramsRoot), paramsRoot, 2, descSamplers, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT | D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS);
-	ID3D12RootSignature* sigRoot;
-	m_pDev->CreateRootSig(&descRoot, sigRoot);
-	m_listRootSigs.push_back(sigRoot);
-
 	D3D12_SHADER_BYTECODE bcVS = {};
 	D3D12_SHADER_BYTECODE bcHS = {};
 	D3D12_SHADER_BYTECODE bcDS = {};
 
-	CompileShader(L"RenderTerrainTessVS.hlsl", VERTEX_SHADER, bcVS);
+	CompileShader(L"RenderShadowMapVS.hlsl", VERTEX_SHADER, bcVS);
 	CompileShader(L"RenderShadowMapHS.hlsl", HULL_SHADER, bcHS);
 	CompileShader(L"RenderShadowMapDS.hlsl", DOMAIN_SHADER, bcDS);
 
@@ -292,21 +368,9 @@ void Scene::InitPipelineShadowMap() {
 	descSample.Count = 1; // turns multi-sampling off. Not supported feature for my card.
 						  
 	// create the pipeline state object
-	// create input layout.
-	D3D12_INPUT_LAYOUT_DESC	descInputLayout = {};
-	D3D12_INPUT_ELEMENT_DESC descElementLayout[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "POSITION", 1, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "POSITION", 2, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "SKIRT", 0, DXGI_FORMAT_R32_UINT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-	};
-
-	descInputLayout.NumElements = sizeof(descElementLayout) / sizeof(D3D12_INPUT_ELEMENT_DESC);
-	descInputLayout.pInputElementDescs = descElementLayout;
-
+	// no input layout, as for the 3D pipeline.
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC descPSO = {};
-	descPSO.pRootSignature = sigRoot;
-	descPSO.InputLayout = descInputLayout;
+	descPSO.pRootSignature = m_pRootSig;
 	descPSO.VS = bcVS;
 	descPSO.HS = bcHS;
 	descPSO.DS = bcDS;
@@ -325,9 +389,15 @@ void Scene::InitPipelineShadowMap() {
 	descPSO.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
 	descPSO.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
 
-	ID3D12PipelineState* pso;
-	m_pDev->CreatePSO(&descPSO, pso);
-	m_listPSOs.push_back(pso);
+	m_listPSOs[PIPELINE_SHADOW_MAP] = m_PSOMgr.RequestPipeline(&descPSO);
+
+	// the single pass version only differs by writing SV_ViewportArrayIndex from the domain shader.
+	if (m_isSinglePassShadows) {
+		CompileShader(L"RenderShadowMapSinglePassDS.hlsl", DOMAIN_SHADER, bcDS);
+		descPSO.DS = bcDS;
+
+		m_listPSOs[PIPELINE_SHADOW_MAP_SINGLE_PASS] = m_PSOMgr.RequestPipeline(&descPSO);
+	}
 }
 
 void Scene::SetViewport(ID3D12GraphicsCommandList* cmdList) {
@@ -335,40 +405,298 @@ void Scene::SetViewport(ID3D12GraphicsCommandList* cmdList) {
 	cmdList->RSSetScissorRects(1, &m_srMain);
 }
 
-void Scene::DrawShadowMap(ID3D12GraphicsCommandList* cmdList) {
-	m_pFrames[m_iFrame]->BeginShadowPass(cmdList);
+// Write the cascades whose matrices changed since the atlas was last drawn to cascades. Returns the number written.
+// The matrices are texel snapped, so a static camera and paused sun produce the same matrices every frame.
+unsigned int Scene::FindDirtyCascades(unsigned int* cascades) {
+	unsigned int numCascades = 0;
+	unsigned int iFarCascade = m_pShadowAtlas->GetNumCascades() - 1;
+	for (unsigned int i = 0; i <= iFarCascade; ++i) {
+		if (m_pShadowAtlas->IsCascadeCurrent(i, m_DNC.GetShadowViewProjMatrix(i))) continue;
+		// the far cascade covers the whole scene and barely changes from frame to frame, so refresh it at a reduced rate.
+		if (i == iFarCascade && m_pShadowAtlas->GetCascadeAge(i, m_numFramesDrawn) < SHADOW_FAR_CASCADE_INTERVAL) continue;
+
+		cascades[numCascades++] = i;
+		++m_numCascadesRendered[i];
+	}
+
+	return numCascades;
+}
+
+// Cull the terrain's patches against the camera and the numCascades listed cascades on the GPU.
+// Every cascade is also merged into the union list for the single pass shadow draw.
+void Scene::CullPatchesGPU(ID3D12GraphicsCommandList* cmdList, const unsigned int* cascades, unsigned int numCascades) {
+	XMFLOAT4 frustum[6];
+	m_Cam.GetViewFrustum(frustum);
+	m_pCuller->SetView(m_iFrame, CULL_VIEW_CAMERA, frustum, 6);
+
+	for (unsigned int c = 0; c < numCascades; ++c) {
+		m_DNC.GetShadowFrustum(cascades[c], frustum);
+		m_pCuller->SetView(m_iFrame, CULL_VIEW_FIRST_CASCADE + c, frustum, 4);
+	}
+
+	// the terrain never moves, so the previous frame's depth buffer is a good guess at what hides what this frame.
+	// Only the camera is occlusion culled. What hides a patch from the camera says nothing about the light.
+	if (m_isOcclusionCulling && m_hasPrevDepth && m_drawMode) {
+		m_pCuller->SetOcclusion(m_iFrame, &m_matPrevViewProj);
+	} else {
+		m_pCuller->SetOcclusion(m_iFrame, nullptr);
+	}
+
+	m_pCuller->Cull(cmdList, m_iFrame, CULL_VIEW_FIRST_CASCADE + numCascades, CULL_VIEW_FIRST_CASCADE, numCascades);
+}
+
+// Add the culling statistics of the frame about to be reused to the totals.
+// The frame has just been reset, so the GPU is done with it and its statistics can be read.
+void Scene::GatherCullStats() {
+	CullStats stats;
+	if (!m_pCuller->GetCullStats(m_iFrame, stats)) return;
+
+	m_numPatchesInFrustum += stats.numInFrustum;
+	m_numPatchesOccluded += stats.numOccluded;
+	++m_numFramesCulled;
+}
+
+// Write an estimate of how many triangles the terrain in view tessellates into to the debug output.
+void Scene::ReportTriangleEstimate() {
+	XMFLOAT4 frustum[6];
+	m_Cam.GetViewFrustum(frustum);
+
+	XMFLOAT4 eye = m_Cam.GetEyePosition();
+	TessFactorParams params = { XMFLOAT3(eye.x, eye.y, eye.z), m_Cam.GetPixelsPerUnit(), TESS_TARGET_PIXEL_ERROR, TESS_MAX_FACTOR };
+	unsigned long long numDistanceRamp;
+	unsigned long long num = m_pT->EstimateTriangleCount(frustum, params, numDistanceRamp);
+
+	char msg[256];
+	sprintf_s(msg, "Estimated terrain triangles in view: %llu at %.1f pixel error, %llu with the distance ramp (%.2fx).\n",
+		num, TESS_TARGET_PIXEL_ERROR, numDistanceRamp, numDistanceRamp ? (double)num / (double)numDistanceRamp : 0.0);
+	OutputDebugStringA(msg);
+}
+
+// Apply num strokes from snap, oldest first, to the terrain and upload what they changed, including the patches the culler reads.
+// The uploads go on the queue ahead of this frame's command list, so the frame already draws the edited terrain.
+void Scene::ApplyBrushStrokes(const SimSnapshot& snap, unsigned int num) {
+	auto tStart = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = snap.numBrushStrokes - num; i != snap.numBrushStrokes; ++i) {
+		m_pWorld->Edit(0, snap.brushStrokes[i % SIM_MAX_BRUSH_STROKES]);
+	}
+
+	unsigned long firstPatch[2], numPatches[2];
+	unsigned int numRanges = m_pT->UploadEdits(firstPatch, numPatches);
+	m_pWorld->UploadSeamErrors();
+	std::vector<PatchCullData> patches;
+	for (unsigned int r = 0; r < numRanges; ++r) {
+		m_pT->GetPatchCullData(patches, firstPatch[r], numPatches[r]);
+		m_pCuller->UpdatePatches(patches.data(), firstPatch[r], numPatches[r]);
+	}
+	{
+		// the simulation fits the shadow cascades to the world's copy of the block bounds.
+		std::lock_guard<std::mutex> lock(m_pT->GetEditLock());
+		m_pWorld->UpdateTileBounds(0);
+	}
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+	m_numStrokesApplied += num;
+	m_msEditing += ms;
+	m_msEditingWorst = ms > m_msEditingWorst ? ms : m_msEditingWorst;
+}
+
+// Write how long brush strokes took to apply and upload since the last report to the debug output.
+void Scene::ReportEditStats() {
+	if (m_numStrokesApplied == 0) return;
+
+	char msg[256];
+	sprintf_s(msg, "Terrain edits: %u brush strokes, %.3f ms per stroke to apply and upload, %.3f ms at worst in one frame. %u strokes lost.\n",
+		m_numStrokesApplied, m_msEditing / m_numStrokesApplied, m_msEditingWorst, m_numStrokesLost);
+	OutputDebugStringA(msg);
+
+	m_numStrokesApplied = 0;
+	m_numStrokesLost = 0;
+	m_msEditing = 0.0;
+	m_msEditingWorst = 0.0;
+}
+
+// Write the occlusion culling statistics to the debug output every CULL_STATS_INTERVAL frames.
+void Scene::ReportCullStats() {
+	if (m_numFramesDrawn % CULL_STATS_INTERVAL != 0 || m_numFramesCulled == 0) return;
+
+	char msg[256];
+	sprintf_s(msg, "Patches culled over the last %llu frames: %.1f per frame in the view frustum, %.1f of them occluded (%.1f%%).\n",
+		m_numFramesCulled, (double)m_numPatchesInFrustum / (double)m_numFramesCulled, (double)m_numPatchesOccluded / (double)m_numFramesCulled,
+		m_numPatchesInFrustum ? 100.0 * (double)m_numPatchesOccluded / (double)m_numPatchesInFrustum : 0.0);
+	OutputDebugStringA(msg);
+
+	m_numPatchesInFrustum = 0;
+	m_numPatchesOccluded = 0;
+	m_numFramesCulled = 0;
+}
+
+// Render the numCascades listed cascades of the shadow map.
+void Scene::DrawShadowMap(ID3D12GraphicsCommandList* cmdList, const unsigned int* listCascades, unsigned int numCascades) {
+	Frame* frame = m_pFrames[m_iFrame];
 
-	cmdList->SetPipelineState(m_listPSOs[2]);
-	cmdList->SetGraphicsRootSignature(m_listRootSigs[2]);
+	// nothing changed, so the atlas can be used as is.
+	if (numCascades == 0) return;
+
+	m_pShadowAtlas->BeginShadowPass(cmdList, listCascades, numCascades);
+
+	int pipeline = m_isSinglePassShadows ? PIPELINE_SHADOW_MAP_SINGLE_PASS : PIPELINE_SHADOW_MAP;
+	cmdList->SetPipelineState(m_PSOMgr.GetPipeline(m_listPSOs[pipeline]));
+	cmdList->SetGraphicsRootSignature(m_pRootSig);
+	// only chunked draws move the base vertex off 0.
+	const UINT constantsRoot[] = { 0, 0 };
+	cmdList->SetGraphicsRoot32BitConstants(ROOT_PARAM_CONSTANTS, _countof(constantsRoot), constantsRoot, 0);
 
 	ID3D12DescriptorHeap* heaps[] = { m_ResMgr.GetCBVSRVUAVHeap() };
 	cmdList->SetDescriptorHeaps(_countof(heaps), heaps);
 
 	// Tell the terrain to attach its resources.
-	m_pT->AttachTerrainResources(cmdList, 0, 1, 2);
+	m_pT->AttachTerrainResources(cmdList, ROOT_PARAM_TERRAIN_CBV);
+	cmdList->SetGraphicsRootDescriptorTable(ROOT_PARAM_SRV_TABLE, m_hdlTerrainSRVTable);
 
-	for (int i = 0; i < 4; ++i) {
-		// fill in this cascade's shadow constants.
+	// fill in the shadow constants for every cascade and bind them all at once.
+	XMFLOAT4 frustums[MAX_SHADOW_CASCADES][4];
+	for (unsigned int c = 0; c < numCascades; ++c) {
+		unsigned int i = listCascades[c];
 		ShadowMapShaderConstants constants;
 		constants.shadowViewProj = m_DNC.GetShadowViewProjMatrix(i);
 		constants.eye = m_Cam.GetEyePosition();
 		m_DNC.GetShadowFrustum(i, constants.frustum);
-		m_pFrames[m_iFrame]->SetShadowConstants(constants, i);
-		m_pFrames[m_iFrame]->AttachShadowPassResources(i, cmdList, 3);
+		memcpy(frustums[c], constants.frustum, sizeof(frustums[c]));
+		frame->SetShadowConstants(constants, i);
+	}
+	frame->AttachShadowPassResources(cmdList, ROOT_PARAM_FRAME_CBV);
+
+	if (m_isGPUCulling) {
+		// the patch lists were built by the culling pass, so the draws only need to point at them.
+		if (m_isSinglePassShadows) {
+			UINT cascadeMap = PackCascadeMap(listCascades, numCascades);
+
+			m_pShadowAtlas->SetCascadeViewports(cmdList);
+			cmdList->SetGraphicsRoot32BitConstant(ROOT_PARAM_CONSTANTS, cascadeMap, 0);
+			m_pT->DrawPatchesIndirect(cmdList, m_pCuller->GetIndexView(), m_pCuller->GetCommandSignature(), m_pCuller->GetArgs(),
+				m_pCuller->GetArgsOffset(m_pCuller->GetUnionList()));
+		} else {
+			for (unsigned int c = 0; c < numCascades; ++c) {
+				m_pShadowAtlas->SetCascadeViewport(listCascades[c], cmdList);
+				cmdList->SetGraphicsRoot32BitConstant(ROOT_PARAM_CONSTANTS, listCascades[c], 0);
+				m_pT->DrawPatchesIndirect(cmdList, m_pCuller->GetIndexView(), m_pCuller->GetCommandSignature(), m_pCuller->GetArgs(),
+					m_pCuller->GetArgsOffset(CULL_VIEW_FIRST_CASCADE + c));
+			}
+		}
+
+		DrawWorldShadows(cmdList, listCascades, numCascades, frustums);
+		for (unsigned int c = 0; c < numCascades; ++c) {
+			unsigned int i = listCascades[c];
+			m_pShadowAtlas->SetCascadeRendered(i, m_DNC.GetShadowViewProjMatrix(i), m_numFramesDrawn);
+		}
+		return;
+	}
+
+	// build the list of patches visible to each cascade so patches outside every cascade never reach the GPU.
+	m_pT->CullPatches(frustums, numCascades, m_listShadowPatches, m_listShadowPatchesVisible);
+	UINT* indices = frame->GetShadowPatchIndices();
+	D3D12_INDEX_BUFFER_VIEW* view = frame->GetShadowPatchIndexView();
+
+	if (m_isSinglePassShadows) {
+		// draw every out of date cascade with one instanced draw. The instance selects the cascade and its viewport in the atlas.
+		// The hull shader still culls each instance's patches against its own cascade.
+		UINT cascadeMap = PackCascadeMap(listCascades, numCascades);
+
+		unsigned int numIndices = m_pT->WritePatchIndices(m_listShadowPatchesVisible, indices);
+		m_pShadowAtlas->SetCascadeViewports(cmdList);
+		cmdList->SetGraphicsRoot32BitConstant(ROOT_PARAM_CONSTANTS, cascadeMap, 0);
+		m_pT->DrawPatches(cmdList, view, 0, numIndices, numCascades);
+	} else {
+		// draw each cascade's own patch list. The lists are packed one after the other in the index buffer.
+		unsigned int iStart = 0;
+		for (unsigned int c = 0; c < numCascades; ++c) {
+			unsigned int numIndices = m_pT->WritePatchIndices(m_listShadowPatches[c], &indices[iStart]);
+			// only the viewport and a single root constant change between cascades.
+			m_pShadowAtlas->SetCascadeViewport(listCascades[c], cmdList);
+			cmdList->SetGraphicsRoot32BitConstant(ROOT_PARAM_CONSTANTS, listCascades[c], 0);
+			m_pT->DrawPatches(cmdList, view, iStart, numIndices);
+			iStart += numIndices;
+		}
+	}
 
-		// mDrawMode = 0/false for 2D rendering and 1/true for 3D rendering
-		m_pT->Draw(cmdList, true);
+	DrawWorldShadows(cmdList, listCascades, numCascades, frustums);
+
+	// remember what each cascade now holds so the render pass samples it with matching matrices.
+	for (unsigned int c = 0; c < numCascades; ++c) {
+		unsigned int i = listCascades[c];
+		m_pShadowAtlas->SetCascadeRendered(i, m_DNC.GetShadowViewProjMatrix(i), m_numFramesDrawn);
+	}
+}
+
+// Render the tiles of the world other than the first into the numCascades listed cascades, whose frustums are in frustums.
+// The shadow constants of every cascade must already be bound.
+void Scene::DrawWorldShadows(ID3D12GraphicsCommandList* cmdList, const unsigned int* listCascades, unsigned int numCascades,
+	const XMFLOAT4 (*frustums)[4]) {
+	if (m_pWorld->GetNumTiles() == 1) return;
+
+	XMFLOAT4 eye = m_Cam.GetEyePosition();
+	if (m_isSinglePassShadows) {
+		// a tile in any of the cascades is drawn into all of them, one instance each, as for the first tile.
+		UINT cascadeMap = PackCascadeMap(listCascades, numCascades);
+
+		m_pShadowAtlas->SetCascadeViewports(cmdList);
+		cmdList->SetGraphicsRoot32BitConstant(ROOT_PARAM_CONSTANTS, cascadeMap, 0);
+		m_pWorld->Draw(cmdList, frustums[0], 4, numCascades, XMFLOAT3(eye.x, eye.y, eye.z), ROOT_PARAM_TERRAIN_CBV,
+			ROOT_PARAM_SRV_TABLE, ROOT_PARAM_CONSTANTS, 0, numCascades);
+	} else {
+		for (unsigned int c = 0; c < numCascades; ++c) {
+			m_pShadowAtlas->SetCascadeViewport(listCascades[c], cmdList);
+			cmdList->SetGraphicsRoot32BitConstant(ROOT_PARAM_CONSTANTS, listCascades[c], 0);
+			m_pWorld->Draw(cmdList, frustums[c], 4, 1, XMFLOAT3(eye.x, eye.y, eye.z), ROOT_PARAM_TERRAIN_CBV,
+				ROOT_PARAM_SRV_TABLE, ROOT_PARAM_CONSTANTS, 0);
+		}
 	}
+}
 
-	m_pFrames[m_iFrame]->EndShadowPass(cmdList);
+// Write the shadow cache and texel density statistics to the debug output every SHADOW_STATS_INTERVAL frames.
+void Scene::ReportShadowStats() {
+	if (m_numFramesDrawn % SHADOW_STATS_INTERVAL != 0) return;
+
+	unsigned int num = m_pShadowAtlas->GetNumCascades();
+	unsigned int total = 0;
+	char perCascade[16 * MAX_SHADOW_CASCADES];
+	int len = 0;
+	for (unsigned int i = 0; i < num; ++i) {
+		total += m_numCascadesRendered[i];
+		len += sprintf_s(perCascade + len, sizeof(perCascade) - len, i > 0 ? ", %u" : "%u", m_numCascadesRendered[i]);
+	}
+	char msg[256];
+	sprintf_s(msg, "Shadow cascades re-rendered over the last %llu frames: %u of %llu (%.2f per frame). Per cascade: %s.\n",
+		SHADOW_STATS_INTERVAL, total, SHADOW_STATS_INTERVAL * num, (float)total / (float)SHADOW_STATS_INTERVAL, perCascade);
+	OutputDebugStringA(msg);
+
+	// average shadow texels per world unit, compared to fitting each cascade to a sphere around its slice.
+	for (unsigned int i = 0; i < num; ++i) {
+		float density = m_sumTexelDensity[i] / (float)SHADOW_STATS_INTERVAL;
+		float densitySphere = m_sumTexelDensitySphere[i] / (float)SHADOW_STATS_INTERVAL;
+		sprintf_s(msg, "Shadow cascade %u texel density: %.2f texels/unit (sphere fit %.2f, %.2fx).\n",
+			i, density, densitySphere, densitySphere > 0.0f ? density / densitySphere : 0.0f);
+		OutputDebugStringA(msg);
+	}
+
+	for (int i = 0; i < MAX_SHADOW_CASCADES; ++i) {
+		m_numCascadesRendered[i] = 0;
+		m_sumTexelDensity[i] = 0.0f;
+		m_sumTexelDensitySphere[i] = 0.0f;
+	}
 }
 
 void Scene::DrawTerrain(ID3D12GraphicsCommandList* cmdList) {
 	const float clearColor[] = { 0.2f, 0.6f, 1.0f, 1.0f };
-	m_pFrames[m_iFrame]->BeginRenderPass(cmdList, clearColor);
+	m_pFrames[m_iFrame]->BeginRenderPass(cmdList, clearColor, m_hdlDSV);
 
-	cmdList->SetPipelineState(m_listPSOs[m_drawMode]);
-	cmdList->SetGraphicsRootSignature(m_listRootSigs[m_drawMode]);
+	bool isProcedural = m_drawMode && !m_isGPUCulling && m_isProceduralPatches;
+	int pipeline = isProcedural ? PIPELINE_TERRAIN_3D_PROCEDURAL : m_drawMode ? PIPELINE_TERRAIN_3D : PIPELINE_TERRAIN_2D;
+	cmdList->SetPipelineState(m_PSOMgr.GetPipeline(m_listPSOs[pipeline]));
+	cmdList->SetGraphicsRootSignature(m_pRootSig);
+	// only chunked draws move the base vertex off 0.
+	const UINT constantsRoot[] = { 0, 0 };
+	cmdList->SetGraphicsRoot32BitConstants(ROOT_PARAM_CONSTANTS, _countof(constantsRoot), constantsRoot, 0);
 
 	SetViewport(cmdList);
 
@@ -376,18 +704,23 @@ void Scene::DrawTerrain(ID3D12GraphicsCommandList* cmdList) {
 	cmdList->SetDescriptorHeaps(_countof(heaps), heaps);
 
 	// Tell the terrain to attach its resources.
-	m_pT->AttachTerrainResources(cmdList, 0, 1, 2);
+	m_pT->AttachTerrainResources(cmdList, ROOT_PARAM_TERRAIN_CBV);
+	cmdList->SetGraphicsRootDescriptorTable(ROOT_PARAM_SRV_TABLE, m_hdlTerrainSRVTable);
 
+	XMFLOAT4 frustum[6];
 	if (m_drawMode) {
 		// set the constant buffers.
-		XMFLOAT4 frustum[6];
 		m_Cam.GetViewFrustum(frustum);
 
 		PerFrameConstantBuffer constants;
 		constants.viewproj = m_Cam.GetViewProjectionMatrixTransposed();
-		for (int i = 0; i < 4; ++i) {
-			constants.shadowtexmatrices[i] = m_DNC.GetShadowViewProjTexMatrix(i);
+		for (unsigned int i = 0; i < m_pShadowAtlas->GetNumCascades(); ++i) {
+			// use the matrices the atlas was actually rendered with, as cached cascades may lag behind the sun.
+			constants.shadowtexmatrices[i] = m_pShadowAtlas->GetCascadeTexMatrix(i);
+			constants.shadowcascaderects[i] = m_pShadowAtlas->GetCascadeRect(i);
 		}
+		float sizeAtlas = (float)m_pShadowAtlas->GetSize();
+		constants.shadowatlassize = XMFLOAT4(sizeAtlas, 1.0f / sizeAtlas, (float)m_pShadowAtlas->GetNumCascades(), 0.0f);
 		constants.eye = m_Cam.GetEyePosition();
 		constants.frustum[0] = frustum[0];
 		constants.frustum[1] = frustum[1];
@@ -395,90 +728,131 @@ void Scene::DrawTerrain(ID3D12GraphicsCommandList* cmdList) {
 		constants.frustum[3] = frustum[3];
 		constants.frustum[4] = frustum[4];
 		constants.frustum[5] = frustum[5];
+		constants.tessparams = XMFLOAT4(m_Cam.GetPixelsPerUnit(), TESS_TARGET_PIXEL_ERROR, TESS_MAX_FACTOR, 0.0f);
 		constants.light = m_DNC.GetLight();
 		constants.useTextures = m_UseTextures;
 		m_pFrames[m_iFrame]->SetFrameConstants(constants);
-		m_pFrames[m_iFrame]->AttachFrameResources(cmdList, 4, 3);
-
-		m_pT->AttachMaterialResources(cmdList, 5);
+		m_pFrames[m_iFrame]->AttachFrameResources(cmdList, ROOT_PARAM_FRAME_CBV);
 	}
 	
 	// mDrawMode = 0/false for 2D rendering and 1/true for 3D rendering
-	m_pT->Draw(cmdList, (bool)m_drawMode);
+	if (m_drawMode && m_isGPUCulling) {
+		m_pT->DrawPatchesIndirect(cmdList, m_pCuller->GetIndexView(), m_pCuller->GetCommandSignature(), m_pCuller->GetArgs(),
+			m_pCuller->GetArgsOffset(CULL_VIEW_CAMERA));
+	} else if (isProcedural) {
+		m_pT->DrawProcedural(cmdList);
+	} else {
+		m_pT->Draw(cmdList, ROOT_PARAM_CONSTANTS, (bool)m_drawMode);
+	}
 
-	m_pFrames[m_iFrame]->EndRenderPass(cmdList);
+	// the rest of the world is drawn chunk by chunk, so it needs the index buffer pipeline.
+	if (m_drawMode && m_pWorld->GetNumTiles() > 1) {
+		if (isProcedural) {
+			cmdList->SetPipelineState(m_PSOMgr.GetPipeline(m_listPSOs[PIPELINE_TERRAIN_3D]));
+		}
+		XMFLOAT4 eye = m_Cam.GetEyePosition();
+		m_pWorld->Draw(cmdList, frustum, 6, 1, XMFLOAT3(eye.x, eye.y, eye.z), ROOT_PARAM_TERRAIN_CBV, ROOT_PARAM_SRV_TABLE,
+			ROOT_PARAM_CONSTANTS, 0);
+	}
 }
 
 void Scene::Draw() {
 	m_pFrames[m_iFrame]->Reset();
-	m_pFrames[m_iFrame]->AttachCommandList(m_pCmdList);
+	unsigned int entry = m_CmdPool.Acquire(D3D12_COMMAND_LIST_TYPE_DIRECT, COMMAND_THREAD_MAIN);
+	m_pCmdList = m_CmdPool.GetList(entry);
+	GatherCullStats();
+
+	// work out which cascades of the atlas are out of date.
+	unsigned int listCascades[MAX_SHADOW_CASCADES];
+	unsigned int numCascades = FindDirtyCascades(listCascades);
+
+	// the back buffer is the only resource of the graph that changes from frame to frame.
+	m_pGraphRes->Import(m_iGraphBackBuffer, m_pFrames[m_iFrame]->GetBackBuffer());
+	bool isBuildingHiZ = m_isGPUCulling && m_isOcclusionCulling && m_drawMode;
+	DeclareFramePasses(listCascades, numCascades, m_isGPUCulling, isBuildingHiZ);
+	if (!m_Graph.Compile()) {
+		std::string msg = "Scene::Draw: " + m_Graph.GetError();
+		throw GFX_Exception(msg.c_str());
+	}
+	m_Graph.Execute([this](const RenderGraphBarrier* barriers, unsigned int num) {
+		m_pGraphRes->IssueBarriers(m_pCmdList, barriers, num);
+	});
 
-	DrawShadowMap(m_pCmdList);
-	
-	DrawTerrain(m_pCmdList);
+	// remember what the Hi-Z pyramid now holds for occlusion culling the next frame.
+	m_hasPrevDepth = isBuildingHiZ;
+	m_matPrevViewProj = m_Cam.GetViewProjectionMatrixTransposed();
 
-	CloseCommandLists();
-	ID3D12CommandList* lCmds[] = { m_pCmdList };
-	m_pDev->ExecuteCommandLists(lCmds, __crt_countof(lCmds));
+	m_pFrames[m_iFrame]->SetFenceValue(m_CmdPool.Execute(&entry, 1));
+	m_pCmdList = nullptr;
 	m_pDev->Present();
+
+	++m_numFramesDrawn;
+	ReportShadowStats();
+	ReportCullStats();
+	if (m_numFramesDrawn % CULL_STATS_INTERVAL == 0) {
+		m_CmdPool.ReportUsage();
+		m_pSim->ReportStats();
+		ReportEditStats();
+		m_pWorld->ReportDrawStats();
+	}
 }
 
+// Draw the newest snapshot the simulation has published. The snapshot is copied so the whole frame sees the same
+// camera and sun, however many steps the simulation takes meanwhile.
 void Scene::Update() {
-	if (m_LockToTerrain) {
-		XMFLOAT4 eye = m_Cam.GetEyePosition();
-		float h = m_pT->GetHeightAtPoint(eye.x, eye.y) + 2;
-		m_Cam.LockPosition(XMFLOAT4(eye.x, eye.y, h, 1.0f));
+	if (SIM_LOCKSTEP) {
+		m_pSim->Advance();
 	}
 
-	m_DNC.Update(m_pT->GetBoundingSphere(), &m_Cam);
+	SnapshotExchange<SimSnapshot>* snapshots = m_pSim->GetSnapshots();
+	snapshots->Acquire();
+	const SimSnapshot& snap = snapshots->GetReadSlot();
+	m_Cam = snap.cam;
+	m_DNC = snap.dnc;
+	m_drawMode = snap.drawMode;
+	m_UseTextures = snap.useTextures;
+	m_isGPUCulling = snap.isGPUCulling;
+	m_isOcclusionCulling = snap.isOcclusionCulling;
+	m_isProceduralPatches = snap.isProceduralPatches;
+	if (snap.numTriangleReports != m_numTriangleReports) {
+		m_numTriangleReports = snap.numTriangleReports;
+		ReportTriangleEstimate();
+	}
+	// every stroke since the last snapshot is applied where it was made, as long as the snapshot still holds it.
+	if (snap.numBrushStrokes != m_numBrushStrokes) {
+		unsigned int num = snap.numBrushStrokes - m_numBrushStrokes;
+		if (num > SIM_MAX_BRUSH_STROKES) {
+			m_numStrokesLost += num - SIM_MAX_BRUSH_STROKES;
+			num = SIM_MAX_BRUSH_STROKES;
+		}
+		m_numBrushStrokes = snap.numBrushStrokes;
+		ApplyBrushStrokes(snap, num);
+	}
+
+	for (unsigned int i = 0; i < m_DNC.GetNumCascades(); ++i) {
+		m_sumTexelDensity[i] += m_DNC.GetCascadeTexelDensity(i);
+		m_sumTexelDensitySphere[i] += m_DNC.GetCascadeSphereTexelDensity(i);
+	}
 
 	m_iFrame = m_pDev->GetCurrentBackBuffer();
 	Draw();
 }
 
 // function allowing the main program to pass keyboard input to the scene.
+// Input is queued for the simulation thread rather than applied here.
 void Scene::HandleKeyboardInput(UINT key) {
-	switch (key) {
-		case _W:
-			if (m_drawMode > 0) m_Cam.Translate(XMFLOAT3(MOVE_STEP, 0.0f, 0.0f));
-			break;
-		case _S:
-			if (m_drawMode > 0) m_Cam.Translate(XMFLOAT3(-MOVE_STEP, 0.0f, 0.0f));
-			break;
-		case _A:
-			if (m_drawMode > 0) m_Cam.Translate(XMFLOAT3(0.0f, MOVE_STEP, 0.0f));
-			break;
-		case _D:
-			if (m_drawMode > 0) m_Cam.Translate(XMFLOAT3(0.0f, -MOVE_STEP, 0.0f));
-			break;
-		case _Q:
-			if (m_drawMode > 0) m_Cam.Translate(XMFLOAT3(0.0f, 0.0f, MOVE_STEP));
-			break;
-		case _Z:
-			if (m_drawMode > 0) m_Cam.Translate(XMFLOAT3(0.0f, 0.0f, -MOVE_STEP));
-			break;
-		case _1: // draw in 2D. draw heightmap.
-			m_drawMode = 0;
-			break;
-		case _2: // draw in 3D.
-			m_drawMode = 1;
-			break;
-		case _T:
-			m_UseTextures = !m_UseTextures;
-			break;
-		case _L:
-			m_LockToTerrain = !m_LockToTerrain;
-			break;
-		case VK_SPACE:
-			m_DNC.TogglePause();
-			break;
-	}
+	InputEvent e = { INPUT_KEY_DOWN, key, 0, 0 };
+	m_Input.Push(e);
+}
+
+// function allowing the main program to tell the scene a key was released.
+void Scene::HandleKeyRelease(UINT key) {
+	InputEvent e = { INPUT_KEY_UP, key, 0, 0 };
+	m_Input.Push(e);
 }
 
 // function allowing the main program to pass mouse input to the scene.
 void Scene::HandleMouseInput(int x, int y) {
-	if (m_drawMode > 0) {
-		m_Cam.Pitch(ROT_ANGLE * y);
-		m_Cam.Yaw(-ROT_ANGLE * x);
-	}
-}
\ No newline at end of file
+	InputEvent e = { INPUT_MOUSE_MOVE, 0, x, y };
+	m_Input.Push(e);
+}
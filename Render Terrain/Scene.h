@@ -10,7 +10,18 @@ Usage:			- Proper shutdown is handled by the destructor.
 				- Requires a pointer to a Device object be passed in.
 				- Is hard-coded for Direct3D 12.
 				- Call Update() in the main loop to render the scene.
+				- The camera and the day/night cycle are moved by a Simulation on a thread of its own.
+					Input is queued for it, and every frame draws the newest snapshot it has published.
 				- Press T to toggle between textured or coloured.
+				- Press G to toggle between culling patches on the GPU and the CPU.
+				- Press B to write an estimate of the terrain triangles in view to the debug output.
+				- Press H to toggle occlusion culling against the previous frame's depth buffer. GPU culling only.
+				- Each frame is declared as a RenderGraph of passes, which works out the barriers between them.
+					The depth buffer is a transient resource of the graph, shared by every frame.
+				- Press P to toggle drawing the terrain without an index buffer. CPU culling only.
+				- The terrain is a TerrainWorld of WORLD_TILES_X x WORLD_TILES_Y tiles. The first tile is the one culled
+					patch by patch, edited, and collided with. The rest are culled a tile at a time on the CPU and drawn
+					whole, in 3D only.
 				- Press 1 for 2D view.
 				- Press 2 for 3D view.
 				
@@ -19,25 +30,49 @@ Future Work:	- Add support for multi-threaded rendering.
 				- Add sky box.
 				- Add atmospheric scattering.
 				- Add dynamic terrain mesh, ie geometry clipmapping.
-				- Add support for loading multiple terrains.
 				- Add support for other objects.
-				- Add support to lock camera to terrain.
 */
 #pragma once
 
 #include "Frame.h"
+#include "RenderGraphResources.h"
+#include "ShadowAtlas.h"
+#include "PatchCuller.h"
 #include "ResourceManager.h"
-#include "Terrain.h"
+#include "PipelineManager.h"
+#include "TerrainWorld.h"
 #include "Camera.h"
 #include "DayNightCycle.h"
+#include "Simulation.h"
 
 using namespace graphics;
 
-enum InputKeys { _0 = 0x30, _1, _2, _3, _4, _5, _6, _7, _8, _9, _A = 0x41, _B, _C, _D, _E, _F, _G, _H, _I, _J, _K, _L, _M, _N, _O, _P, _Q, _R, _S, _T, _U, _V, _W, _X, _Y, _Z };
-#define MOVE_STEP 1.0f
-#define ROT_ANGLE 0.75f
-
 static const int FRAME_BUFFER_COUNT = 3; // triple buffering.
+static const unsigned long long SHADOW_FAR_CASCADE_INTERVAL = 8;	// minimum number of frames between updates of the far cascade.
+static const unsigned long long SHADOW_STATS_INTERVAL = 600;		// number of frames between shadow cache reports.
+static const unsigned int SHADOW_ATLAS_SIZE = 4096;					// width and height of the shadow atlas in texels.
+static const unsigned int SHADOW_CASCADE_COUNT = 4;					// number of cascades packed into the shadow atlas.
+static const float SHADOW_SPLIT_LAMBDA = 0.5f;						// blend between uniform (0) and logarithmic (1) cascade splits.
+static const unsigned long long CULL_STATS_INTERVAL = 600;			// number of frames between patch culling reports.
+static const unsigned int WORLD_TILES_X = 2;						// terrain tiles along x and y. See TerrainWorld.h.
+static const unsigned int WORLD_TILES_Y = 2;
+// take exactly one simulation step per frame on the render thread, with the sun on a fixed path, so that every run
+// draws exactly the same frames. For benchmarks. Otherwise the simulation runs on a thread of its own in real time.
+static const bool SIM_LOCKSTEP = false;
+// record the camera's path to this file, for replaying with the TerrainPrefetch benchmark. nullptr records nothing.
+static const char* SIM_CAMERA_PATH_FILE = nullptr;
+
+// the views the patch culler culls against. The camera comes first, followed by each out of date cascade.
+static const unsigned int CULL_VIEW_CAMERA = 0;
+static const unsigned int CULL_VIEW_FIRST_CASCADE = 1;
+
+// the pipelines used by the scene. m_drawMode doubles as an index into the first two.
+enum ScenePipeline { PIPELINE_TERRAIN_2D = 0, PIPELINE_TERRAIN_3D, PIPELINE_SHADOW_MAP, PIPELINE_SHADOW_MAP_SINGLE_PASS,
+	PIPELINE_TERRAIN_3D_PROCEDURAL, NUM_SCENE_PIPELINES };
+
+// the root parameters of the root signature shared by every terrain pipeline.
+// ROOT_PARAM_FRAME_CBV holds the per-frame constants in the render pass and the cascade constants in the shadow pass.
+enum TerrainRootParam { ROOT_PARAM_CONSTANTS = 0, ROOT_PARAM_TERRAIN_CBV, ROOT_PARAM_FRAME_CBV, ROOT_PARAM_SRV_TABLE, NUM_ROOT_PARAMS };
 
 class Scene {
 public:
@@ -48,40 +83,104 @@ public:
 	void Draw();
 	// function allowing the main program to pass keyboard input to the scene.
 	void HandleKeyboardInput(UINT key);
+	// function allowing the main program to tell the scene a key was released.
+	void HandleKeyRelease(UINT key);
 	// function allowing the main program to pass mouse input to the scene.
 	void HandleMouseInput(int x, int y);
 
 private:
-	// Close all command lists. Currently there is only the one.
-	void CloseCommandLists();
 	// Set the viewport and scissor rectangle for the scene.
 	void SetViewport(ID3D12GraphicsCommandList* cmdList);
 
-	// Initialize the root signature and pipeline state object for rendering the terrain in 2D.
+	// Initialize the root signature shared by all of the terrain pipelines.
+	void InitRootSignature();
+	// Initialize the pipeline state object for rendering the terrain in 2D.
 	void InitPipelineTerrain2D();
-	// Initialize the root signature and pipeline state object for rendering the terrain in 3D.
+	// Initialize the pipeline state object for rendering the terrain in 3D.
 	void InitPipelineTerrain3D();
-	// Initialize the root signature and pipeline state object for rendering to the shadow map.
+	// Initialize the pipeline state objects for rendering to the shadow map, one cascade at a time and all at once.
 	void InitPipelineShadowMap();
 	// Draw the terrain in both 3D and 2D
 	void DrawTerrain(ID3D12GraphicsCommandList* cmdList);
-	// Render the shadow map
-	void DrawShadowMap(ID3D12GraphicsCommandList* cmdList);
+	// Write the cascades whose matrices changed since the atlas was last drawn to cascades. Returns the number written.
+	unsigned int FindDirtyCascades(unsigned int* cascades);
+	// Cull the terrain's patches against the camera and the numCascades listed cascades on the GPU.
+	void CullPatchesGPU(ID3D12GraphicsCommandList* cmdList, const unsigned int* cascades, unsigned int numCascades);
+	// Render the numCascades listed cascades of the shadow map.
+	void DrawShadowMap(ID3D12GraphicsCommandList* cmdList, const unsigned int* cascades, unsigned int numCascades);
+	// Render the tiles of the world other than the first into the numCascades listed cascades, whose frustums are in frustums.
+	void DrawWorldShadows(ID3D12GraphicsCommandList* cmdList, const unsigned int* cascades, unsigned int numCascades,
+		const XMFLOAT4 (*frustums)[4]);
+	// Write the shadow cache and texel density statistics to the debug output every SHADOW_STATS_INTERVAL frames.
+	void ReportShadowStats();
+	// Add the culling statistics of the frame about to be reused to the totals.
+	void GatherCullStats();
+	// Write the occlusion culling statistics to the debug output every CULL_STATS_INTERVAL frames.
+	void ReportCullStats();
+	// Write an estimate of how many triangles the terrain in view tessellates into to the debug output.
+	void ReportTriangleEstimate();
+	// Apply num strokes from snap, oldest first, to the terrain and upload what they changed, including the patches the culler reads.
+	void ApplyBrushStrokes(const SimSnapshot& snap, unsigned int num);
+	// Write how long brush strokes took to apply and upload since the last report to the debug output.
+	void ReportEditStats();
+	// Add the resources of the frame's render graph, place its transient resources, and create them.
+	void InitRenderGraph(int height, int width);
+	// Declare the passes of a frame in the render graph. The shadow pass is left out when no cascades are listed.
+	void DeclareFramePasses(const unsigned int* cascades, unsigned int numCascades, bool isCulling, bool isBuildingHiZ);
+	// Write the render graph's barrier counts and memory use to the debug output.
+	void ReportRenderGraph();
 
 	Device*								m_pDev;
+	CommandListPool						m_CmdPool;							// declared first so it outlives everything that records commands.
 	ResourceManager						m_ResMgr;
+	PipelineManager						m_PSOMgr;
 	Frame*								m_pFrames[::FRAME_BUFFER_COUNT];
-	ID3D12GraphicsCommandList*			m_pCmdList;
-	Terrain*							m_pT;
-	Camera								m_Cam;
+	ID3D12GraphicsCommandList*			m_pCmdList;							// the pool's command list being recorded this frame.
+	TerrainWorld*						m_pWorld;
+	Terrain*							m_pT;								// the world's first tile. Owned by m_pWorld.
+	Camera								m_Cam;								// copied from the simulation's snapshot every frame.
 	DayNightCycle						m_DNC;
+	InputQueue							m_Input;							// from the window's thread to the simulation's.
+	Simulation*							m_pSim;
+	TimeOfDayCurve						m_curveBenchmark;					// the sun's path when SIM_LOCKSTEP is set.
+	ShadowAtlas*						m_pShadowAtlas;						// shared by all frames.
+	PatchCuller*						m_pCuller;							// shared by all frames.
+	HiZPyramid*							m_pHiZ;								// built from the depth buffer at the end of the frame, for culling the next.
+	RenderGraph							m_Graph;							// the passes of the current frame.
+	RenderGraphResources*				m_pGraphRes;
+	ID3D12Resource*						m_pDepthBuffer;						// transient. Shared by all frames.
+	D3D12_CPU_DESCRIPTOR_HANDLE			m_hdlDSV;
+	unsigned int						m_iGraphBackBuffer;					// indices of the render graph's resources.
+	unsigned int						m_iGraphShadowAtlas;
+	unsigned int						m_iGraphDepthBuffer;
 	D3D12_VIEWPORT						m_vpMain;
 	D3D12_RECT							m_srMain;
 	int									m_drawMode = 0;
-	std::vector<ID3D12RootSignature*>	m_listRootSigs;
-	std::vector<ID3D12PipelineState*>	m_listPSOs;
+	ID3D12RootSignature*				m_pRootSig;							// shared by all pipelines.
+	D3D12_GPU_DESCRIPTOR_HANDLE			m_hdlTerrainSRVTable;				// shared by all frames. See TerrainSRVSlot.
+	unsigned int						m_listPSOs[NUM_SCENE_PIPELINES];	// handles into m_PSOMgr.
+	std::vector<UINT>					m_listShadowPatches[MAX_SHADOW_CASCADES];	// patches visible to each cascade this frame.
+	std::vector<UINT>					m_listShadowPatchesVisible;			// patches visible to at least one cascade.
+	bool								m_isSinglePassShadows;				// render all cascades with one instanced draw.
+	bool								m_isGPUCulling = true;				// cull patches in a compute shader and draw them with ExecuteIndirect.
+	bool								m_isOcclusionCulling = true;		// also cull patches hidden in the previous frame's depth buffer.
+	bool								m_isProceduralPatches = false;		// without GPU culling, draw the terrain without an index buffer.
+	bool								m_hasPrevDepth = false;				// does the Hi-Z pyramid hold the previous frame's depth?
+	XMFLOAT4X4							m_matPrevViewProj;					// the (transposed) view projection the previous frame was rendered with.
+	unsigned long long					m_numPatchesInFrustum = 0;			// culling totals since the last report.
+	unsigned long long					m_numPatchesOccluded = 0;
+	unsigned long long					m_numFramesCulled = 0;
+	unsigned long long					m_numFramesDrawn = 0;
+	unsigned int						m_numCascadesRendered[MAX_SHADOW_CASCADES];	// per cascade re-render counts since the last report.
+	float								m_sumTexelDensity[MAX_SHADOW_CASCADES];		// per cascade texel densities summed since the last report.
+	float								m_sumTexelDensitySphere[MAX_SHADOW_CASCADES];	// same, for a bounding sphere fit.
 	int									m_iFrame = 0;
+	unsigned int						m_numTriangleReports = 0;			// triangle estimates asked for by the simulation so far.
+	unsigned int						m_numBrushStrokes = 0;				// brush strokes made in the simulation so far.
+	unsigned int						m_numStrokesApplied = 0;			// brush strokes applied since the last report.
+	unsigned int						m_numStrokesLost = 0;				// brush strokes the snapshots no longer held when they were read.
+	double								m_msEditing = 0.0;					// time spent applying and uploading them.
+	double								m_msEditingWorst = 0.0;				// the slowest batch of strokes applied in one frame.
 	bool								m_UseTextures = false;
-	bool								m_LockToTerrain = true;
 };
 
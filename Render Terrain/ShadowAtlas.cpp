@@ -0,0 +1,170 @@
+/*
+ShadowAtlas.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for creating and managing the shadow atlas shared by every frame.
+*/
+#include "ShadowAtlas.h"
+#include <climits>
+#include <string>
+
+ShadowAtlas::ShadowAtlas(ResourceManager* rm, unsigned int dim, unsigned int numCascades) : m_pResMgr(rm),
+	m_dimAtlas(dim), m_numCascades(numCascades) {
+	m_pAtlas = nullptr;
+
+	if (m_numCascades == 0 || m_numCascades > MAX_SHADOW_CASCADES) {
+		std::string msg = "ShadowAtlas::ShadowAtlas: cascade count of " + std::to_string(m_numCascades) + " is not supported.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	// lay the cascades out in the smallest square grid that holds all of them.
+	m_numColumns = (unsigned int)ceilf(sqrtf((float)m_numCascades));
+	m_sizeCascade = CalcCascadeSize(m_dimAtlas, m_numCascades);
+	for (unsigned int i = 0; i < m_numCascades; ++i) {
+		unsigned int x = (i % m_numColumns) * m_sizeCascade;
+		unsigned int y = (i / m_numColumns) * m_sizeCascade;
+
+		m_vpCascades[i].TopLeftX = (float)x;
+		m_vpCascades[i].TopLeftY = (float)y;
+		m_vpCascades[i].Width = (float)m_sizeCascade;
+		m_vpCascades[i].Height = (float)m_sizeCascade;
+		m_vpCascades[i].MinDepth = 0;
+		m_vpCascades[i].MaxDepth = 1;
+
+		m_srCascades[i].left = x;
+		m_srCascades[i].top = y;
+		m_srCascades[i].right = x + m_sizeCascade;
+		m_srCascades[i].bottom = y + m_sizeCascade;
+
+		m_listCascades[i] = {};
+		m_listCascades[i].isValid = false;
+	}
+
+	// Create the shadow map texture buffer.
+	D3D12_RESOURCE_DESC	descTex = {};
+	descTex.Alignment = 0;
+	descTex.MipLevels = 1;
+	descTex.Format = DXGI_FORMAT_R24G8_TYPELESS;
+	descTex.Width = m_dimAtlas;
+	descTex.Height = m_dimAtlas;
+	descTex.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+	descTex.DepthOrArraySize = 1;
+	descTex.SampleDesc.Count = 1;
+	descTex.SampleDesc.Quality = 0;
+	descTex.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	descTex.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+
+	D3D12_CLEAR_VALUE clearValue;	// Performance tip: Tell the runtime at resource creation the desired clear value. (per microsoft examples)
+	clearValue.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	clearValue.DepthStencil.Depth = 1.0f;
+	clearValue.DepthStencil.Stencil = 0;
+
+	D3D12_DEPTH_STENCIL_VIEW_DESC descDSV = {};
+	descDSV.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+	descDSV.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+	descDSV.Texture2D.MipSlice = 0;
+	descDSV.Flags = D3D12_DSV_FLAG_NONE;
+
+	m_pResMgr->NewBuffer(m_pAtlas, &descTex, &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, &clearValue);
+	m_pAtlas->SetName(L"Shadow Atlas Texture");
+	m_pResMgr->AddDSV(m_pAtlas, &descDSV, m_hdlDSV);
+}
+
+ShadowAtlas::~ShadowAtlas() {
+	// the atlas itself is released by the resource manager.
+	m_pAtlas = nullptr;
+	m_pResMgr = nullptr;
+}
+
+// Returns the size in texels of a single cascade in an atlas of size dim holding numCascades cascades.
+unsigned int ShadowAtlas::CalcCascadeSize(unsigned int dim, unsigned int numCascades) {
+	unsigned int columns = (unsigned int)ceilf(sqrtf((float)numCascades));
+	return dim / (columns ? columns : 1);
+}
+
+// Call at the start of rendering the shadow passes to make the shadow atlas the depth target. It must already be in the depth write state.
+// Only the numCascades cascades listed in cascades are cleared. The rest keep their cached contents.
+void ShadowAtlas::BeginShadowPass(ID3D12GraphicsCommandList* cmdList, const unsigned int* cascades, unsigned int numCascades) {
+	D3D12_RECT rects[MAX_SHADOW_CASCADES];
+	for (unsigned int i = 0; i < numCascades; ++i) {
+		rects[i] = m_srCascades[cascades[i]];
+	}
+	cmdList->ClearDepthStencilView(m_hdlDSV, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, numCascades, rects);
+	cmdList->OMSetRenderTargets(0, nullptr, false, &m_hdlDSV);
+}
+
+// Set the viewport and scissor rectangle for cascade i.
+void ShadowAtlas::SetCascadeViewport(unsigned int i, ID3D12GraphicsCommandList* cmdList) {
+	cmdList->RSSetViewports(1, &m_vpCascades[i]);
+	cmdList->RSSetScissorRects(1, &m_srCascades[i]);
+}
+
+// Set the viewports for all cascades at once, for shaders that select the viewport with SV_ViewportArrayIndex.
+void ShadowAtlas::SetCascadeViewports(ID3D12GraphicsCommandList* cmdList) {
+	cmdList->RSSetViewports(m_numCascades, m_vpCascades);
+	cmdList->RSSetScissorRects(m_numCascades, m_srCascades);
+}
+
+// Write the shadow atlas SRV into slot i of the CBV/SRV/UAV heap. Used to build descriptor tables.
+void ShadowAtlas::CreateResourceView(unsigned int i) {
+	D3D12_SHADER_RESOURCE_VIEW_DESC	descSRV = {};
+	descSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	descSRV.Format = DXGI_FORMAT_R24_UNORM_X8_TYPELESS;
+	descSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	descSRV.Texture2D.MipLevels = 1;
+	descSRV.Texture2D.MostDetailedMip = 0;
+	descSRV.Texture2D.ResourceMinLODClamp = 0.0f;
+	descSRV.Texture2D.PlaneSlice = 0;
+
+	m_pResMgr->AddSRVAt(i, m_pAtlas, &descSRV);
+}
+
+// Returns true if cascade i was rendered with a view projection matching viewProj.
+bool ShadowAtlas::IsCascadeCurrent(unsigned int i, const XMFLOAT4X4& viewProj) {
+	if (!m_listCascades[i].isValid) return false;
+
+	for (int r = 0; r < 4; ++r) {
+		for (int c = 0; c < 4; ++c) {
+			if (fabsf(m_listCascades[i].viewProj(r, c) - viewProj(r, c)) > SHADOW_CASCADE_EPSILON) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// Returns the number of scene frames since cascade i was last rendered. Never rendered cascades are infinitely old.
+unsigned long long ShadowAtlas::GetCascadeAge(unsigned int i, unsigned long long frameNumber) {
+	if (!m_listCascades[i].isValid) return ULLONG_MAX;
+
+	return frameNumber - m_listCascades[i].frameRendered;
+}
+
+// Record that cascade i was rendered on scene frame frameNumber with the provided (transposed) view projection.
+void ShadowAtlas::SetCascadeRendered(unsigned int i, const XMFLOAT4X4& viewProj, unsigned long long frameNumber) {
+	m_listCascades[i].viewProj = viewProj;
+	m_listCascades[i].frameRendered = frameNumber;
+	m_listCascades[i].isValid = true;
+
+	// transform NDC space [-1, +1]^2 to the cascade's cell in texture space [0, 1]^2
+	float s = (float)m_sizeCascade / (float)m_dimAtlas;
+	float x = (float)(i % m_numColumns) * s + 0.5f * s;
+	float y = (float)(i / m_numColumns) * s + 0.5f * s;
+	XMMATRIX T(0.5f * s, 0.0f, 0.0f, 0.0f,
+		0.0f, -0.5f * s, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		x, y, 0.0f, 1.0f);
+
+	XMMATRIX S = XMMatrixTranspose(XMLoadFloat4x4(&viewProj));
+	XMStoreFloat4x4(&m_listCascades[i].viewProjTex, XMMatrixTranspose(S * T));
+}
+
+// Returns the region of the atlas cascade i may be sampled from as (u min, v min, u max, v max).
+XMFLOAT4 ShadowAtlas::GetCascadeRect(unsigned int i) {
+	float border = (float)SHADOW_CASCADE_BORDER / (float)m_dimAtlas;
+	return XMFLOAT4((float)m_srCascades[i].left / (float)m_dimAtlas + border, (float)m_srCascades[i].top / (float)m_dimAtlas + border,
+		(float)m_srCascades[i].right / (float)m_dimAtlas - border, (float)m_srCascades[i].bottom / (float)m_dimAtlas - border);
+}
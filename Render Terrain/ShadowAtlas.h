@@ -0,0 +1,93 @@
+/*
+ShadowAtlas.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for creating and managing the shadow atlas shared by every frame.
+				The atlas is split into a grid of square cells, one per shadow cascade.
+
+Usage:			- Proper shutdown is handled by the destructor.
+				- Requires a pointer to a ResourceManager object be passed in, along with
+					the size of the atlas in texels and the number of cascades to fit in it.
+				- All frames render on the same command queue, so work on the atlas is always
+					executed in submission order and a single atlas can be shared by all frames
+					in flight. The scene's render graph moves the atlas between the depth write state
+					for the shadow pass and the pixel shader resource state for the render pass.
+				- Call IsCascadeCurrent() to find out if a cascade needs to be redrawn, then
+					SetCascadeRendered() once it has been. GetCascadeTexMatrix() returns the
+					matrix matching what the cascade holds.
+				- Call CreateResourceView() to write the atlas SRV into a descriptor table.
+				- Holds at most MAX_SHADOW_CASCADES (4) cascades. The shaders size their cascade arrays with
+					SHADOW_CASCADE_LIMIT, and the single pass draw packs each instance's cascade into 2 bits of one
+					root constant, so going past 4 means changing the root signature. See ShadowCascadeLimits.h.
+
+Future Work:	- Add support for cascades of different sizes.
+*/
+#pragma once
+
+#include "ResourceManager.h"
+#include "ShadowCascades.h"
+
+using namespace graphics;
+
+// What each cascade of the shadow atlas currently holds.
+struct ShadowCascadeState {
+	XMFLOAT4X4			viewProj;		// the (texel snapped) view projection the cascade was rendered with.
+	XMFLOAT4X4			viewProjTex;	// matching matrix for sampling the cascade.
+	unsigned long long	frameRendered;	// scene frame number the cascade was rendered on.
+	bool				isValid;		// false until the cascade has been rendered at least once.
+};
+
+// Snapped matrices either match up to float noise or differ by at least a texel, so a loose tolerance is safe.
+static const float SHADOW_CASCADE_EPSILON = 0.0001f;
+// Cascades are inset by this many texels when choosing which one to sample, leaving room for PCF.
+static const unsigned int SHADOW_CASCADE_BORDER = 12;
+
+class ShadowAtlas {
+public:
+	ShadowAtlas(ResourceManager* rm, unsigned int dim, unsigned int numCascades);
+	~ShadowAtlas();
+
+	// Returns the size in texels of a single cascade in an atlas of size dim holding numCascades cascades.
+	static unsigned int CalcCascadeSize(unsigned int dim, unsigned int numCascades);
+
+	// Call at the start of rendering the shadow passes to make the shadow atlas the depth target. It must already be in the depth write state.
+	// Only the numCascades cascades listed in cascades are cleared. The rest keep their cached contents.
+	void BeginShadowPass(ID3D12GraphicsCommandList* cmdList, const unsigned int* cascades, unsigned int numCascades);
+	// Set the viewport and scissor rectangle for cascade i.
+	void SetCascadeViewport(unsigned int i, ID3D12GraphicsCommandList* cmdList);
+	// Set the viewports for all cascades at once, for shaders that select the viewport with SV_ViewportArrayIndex.
+	void SetCascadeViewports(ID3D12GraphicsCommandList* cmdList);
+	// Write the shadow atlas SRV into slot i of the CBV/SRV/UAV heap. Used to build descriptor tables.
+	void CreateResourceView(unsigned int i);
+
+	// Returns true if cascade i was rendered with a view projection matching viewProj.
+	bool IsCascadeCurrent(unsigned int i, const XMFLOAT4X4& viewProj);
+	// Returns the number of scene frames since cascade i was last rendered. Never rendered cascades are infinitely old.
+	unsigned long long GetCascadeAge(unsigned int i, unsigned long long frameNumber);
+	// Record that cascade i was rendered on scene frame frameNumber with the provided (transposed) view projection.
+	void SetCascadeRendered(unsigned int i, const XMFLOAT4X4& viewProj, unsigned long long frameNumber);
+	// Returns the (transposed) matrix to sample cascade i with. Matches whatever the cascade was last rendered with.
+	XMFLOAT4X4 GetCascadeTexMatrix(unsigned int i) { return m_listCascades[i].viewProjTex; }
+	// Returns the region of the atlas cascade i may be sampled from as (u min, v min, u max, v max).
+	XMFLOAT4 GetCascadeRect(unsigned int i);
+
+	// Returns the atlas texture. It is in the pixel shader resource state outside of the shadow pass.
+	ID3D12Resource* GetAtlas() { return m_pAtlas; }
+	unsigned int GetNumCascades() { return m_numCascades; }
+	unsigned int GetCascadeSize() { return m_sizeCascade; }
+	unsigned int GetSize() { return m_dimAtlas; }
+
+private:
+	ResourceManager*			m_pResMgr;
+	ID3D12Resource*				m_pAtlas;
+	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlDSV;
+	D3D12_VIEWPORT				m_vpCascades[MAX_SHADOW_CASCADES];
+	D3D12_RECT					m_srCascades[MAX_SHADOW_CASCADES];
+	ShadowCascadeState			m_listCascades[MAX_SHADOW_CASCADES];
+	unsigned int				m_dimAtlas;
+	unsigned int				m_numCascades;
+	unsigned int				m_numColumns;		// cascades are laid out left to right, top to bottom.
+	unsigned int				m_sizeCascade;
+};
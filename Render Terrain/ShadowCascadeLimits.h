@@ -0,0 +1,22 @@
+/*
+ShadowCascadeLimits.h
+
+Author:			Chris Serson
+Last Edited:	October 19, 2026
+
+Description:	The number of shadow cascades the shaders are built for. Included by both the C++ and the
+				HLSL, so it only holds preprocessor definitions.
+
+Usage:			- SHADOW_CASCADE_LIMIT sizes every per cascade array in the shaders' constant buffers and
+					is MAX_SHADOW_CASCADES on the CPU.
+				- The single pass shadow draw packs the cascade each instance renders into the one
+					cascadeMap root constant, SHADOW_CASCADE_MAP_BITS per instance. Raising the limit past
+					what those bits can address means changing the root signature's constants.
+*/
+#ifndef SHADOW_CASCADE_LIMITS_H
+#define SHADOW_CASCADE_LIMITS_H
+
+#define SHADOW_CASCADE_LIMIT 4
+#define SHADOW_CASCADE_MAP_BITS 2
+
+#endif
@@ -0,0 +1,283 @@
+/*
+ShadowCascades.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Math for splitting the view frustum into shadow cascades and fitting an
+				orthographic light projection to each of them.
+*/
+#include "ShadowCascades.h"
+#include <cmath>
+#include <cfloat>
+
+// Return the view matrix of a light shining along lightdir onto bbScene, from far enough back to see all of it.
+XMMATRIX CalcLightView(AxisAlignedBoundingBox& bbScene, FXMVECTOR lightdir) {
+	XMFLOAT3 vCenterScene = bbScene.GetCenter();
+	XMVECTOR targetpos = XMLoadFloat3(&vCenterScene);
+	float radiusScene = ceilf(bbScene.GetRadius());
+
+	XMVECTOR lightpos = targetpos - 2.0f * radiusScene * lightdir;
+	XMVECTOR up = XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f);
+	up = XMVector3Cross(up, lightdir);
+
+	return XMMatrixLookAtLH(lightpos, targetpos, up);
+}
+
+// Write numCascades + 1 view distances to splits. Cascade i runs from splits[i] to splits[i + 1].
+// lambda blends between a uniform (0) and logarithmic (1) distribution of the splits.
+void CalcCascadeSplits(float zNear, float zFar, unsigned int numCascades, float lambda, float* splits) {
+	splits[0] = zNear;
+	for (unsigned int i = 1; i < numCascades; ++i) {
+		float t = (float)i / (float)numCascades;
+		float splitLog = zNear * powf(zFar / zNear, t);
+		float splitUniform = zNear + (zFar - zNear) * t;
+		splits[i] = lambda * splitLog + (1.0f - lambda) * splitUniform;
+	}
+	splits[numCascades] = zFar;
+}
+
+// Clip the frustum slice with the provided corners to the world space height range [zMin, zMax].
+// Writes the points bounding what is left to points, which must have room for MAX_CLIPPED_SLICE_POINTS. Returns the number written.
+unsigned int ClipSliceToHeightRange(const XMFLOAT3 corners[8], float zMin, float zMax, XMFLOAT3* points) {
+	unsigned int numPoints = 0;
+
+	// corners that are already inside of the range.
+	for (int i = 0; i < 8; ++i) {
+		if (corners[i].z >= zMin && corners[i].z <= zMax) {
+			points[numPoints++] = corners[i];
+		}
+	}
+
+	// the two planes are parallel, so the only new vertices are where the slice's edges cross them.
+	// Corners joined by an edge differ by exactly one bit of their index.
+	float planes[] = { zMin, zMax };
+	for (int a = 0; a < 8; ++a) {
+		for (int bit = 1; bit < 8; bit <<= 1) {
+			int b = a | bit;
+			if (b == a) continue;
+
+			for (int p = 0; p < 2; ++p) {
+				float da = corners[a].z - planes[p];
+				float db = corners[b].z - planes[p];
+				if ((da < 0.0f) == (db < 0.0f)) continue;
+
+				float t = da / (da - db);
+				points[numPoints++] = XMFLOAT3(corners[a].x + (corners[b].x - corners[a].x) * t,
+					corners[a].y + (corners[b].y - corners[a].y) * t, planes[p]);
+			}
+		}
+	}
+
+	return numPoints;
+}
+
+// Return the light space box around the provided world space points.
+CascadeBox CalcLightSpaceBounds(const XMFLOAT3* points, unsigned int numPoints, FXMMATRIX V) {
+	XMVECTOR vMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+	for (unsigned int i = 0; i < numPoints; ++i) {
+		XMVECTOR p = XMVector3TransformCoord(XMLoadFloat3(&points[i]), V);
+		vMin = XMVectorMin(vMin, p);
+		vMax = XMVectorMax(vMax, p);
+	}
+
+	CascadeBox box;
+	XMStoreFloat3(&box.min, vMin);
+	XMStoreFloat3(&box.max, vMax);
+
+	return box;
+}
+
+// Make a light space box square, snap it to the texel grid of a cascade sizeCascade texels wide, and round its depth range out.
+CascadeBox SnapCascadeBox(CascadeBox box, unsigned int sizeCascade) {
+	// pad for PCF, then round the width up to one of a few steps per power of two.
+	// Rotating the camera changes the slice's footprint a little every frame. Quantizing the width keeps the texel size
+	// constant through those changes, which both stops the shadows from shimmering and lets cached cascades be reused.
+	float extent = fmaxf(box.max.x - box.min.x, box.max.y - box.min.y);
+	extent *= (float)(sizeCascade + CASCADE_PADDING_TEXELS) / (float)sizeCascade;
+	extent = fmaxf(extent, 1.0f);
+	float step = powf(2.0f, ceilf(log2f(extent))) / CASCADE_EXTENT_STEPS;
+	extent = ceilf(extent / step) * step;
+
+	// snap the corner of the box to a whole texel so the shadow map moves in texel sized increments.
+	float texel = extent / (float)sizeCascade;
+	float cx = (box.min.x + box.max.x) / 2.0f;
+	float cy = (box.min.y + box.max.y) / 2.0f;
+
+	CascadeBox snapped;
+	snapped.min.x = floorf((cx - extent / 2.0f) / texel) * texel;
+	snapped.min.y = floorf((cy - extent / 2.0f) / texel) * texel;
+	snapped.max.x = snapped.min.x + extent;
+	snapped.max.y = snapped.min.y + extent;
+	snapped.min.z = floorf(box.min.z / CASCADE_DEPTH_STEP) * CASCADE_DEPTH_STEP;
+	snapped.max.z = ceilf(box.max.z / CASCADE_DEPTH_STEP) * CASCADE_DEPTH_STEP;
+	if (snapped.max.z <= snapped.min.z) snapped.max.z = snapped.min.z + CASCADE_DEPTH_STEP;
+
+	return snapped;
+}
+
+// Returns the unsnapped light space box FitCascadeToSlice() is built from.
+static CascadeBox CalcSliceBounds(const XMFLOAT3 corners[8], AxisAlignedBoundingBox& bbScene, FXMMATRIX V) {
+	// only the part of the slice between the lowest and highest points of the scene can receive shadows.
+	XMFLOAT3 points[MAX_CLIPPED_SLICE_POINTS];
+	unsigned int numPoints = ClipSliceToHeightRange(corners, bbScene.GetMin().z, bbScene.GetMax().z, points);
+	// the slice is entirely above or below the scene. Fall back to the whole slice so the projection stays valid.
+	CascadeBox box = numPoints ? CalcLightSpaceBounds(points, numPoints, V) : CalcLightSpaceBounds(corners, 8, V);
+
+	XMFLOAT3 cornersScene[8];
+	bbScene.GetCorners(cornersScene);
+	CascadeBox boxScene = CalcLightSpaceBounds(cornersScene, 8, V);
+
+	// nothing outside of the scene's footprint can be shadowed, so clamp to it unless that leaves nothing behind.
+	if (box.min.x < boxScene.max.x && box.max.x > boxScene.min.x && box.min.y < boxScene.max.y && box.max.y > boxScene.min.y) {
+		box.min.x = fmaxf(box.min.x, boxScene.min.x);
+		box.min.y = fmaxf(box.min.y, boxScene.min.y);
+		box.max.x = fminf(box.max.x, boxScene.max.x);
+		box.max.y = fminf(box.max.y, boxScene.max.y);
+	}
+	box.min.z = boxScene.min.z;
+	box.max.z = fminf(box.max.z, boxScene.max.z);
+
+	return box;
+}
+
+// Fit a snapped light space box around the part of the frustum slice with the provided corners that lies within bbScene.
+// The near plane is pulled back to the edge of bbScene so that anything between the light and the slice still casts shadows.
+CascadeBox FitCascadeToSlice(const XMFLOAT3 corners[8], AxisAlignedBoundingBox& bbScene, FXMMATRIX V, unsigned int sizeCascade) {
+	return SnapCascadeBox(CalcSliceBounds(corners, bbScene, V), sizeCascade);
+}
+
+// Fit a snapped light space box around the part of the frustum slice with the provided corners covered by the numBlocks blocks.
+// Blocks must all lie within bbScene. Only blocks behind receiving blocks, as seen from the light, are kept as shadow casters.
+// Falls back to FitCascadeToSlice() if the slice doesn't touch any of the blocks.
+CascadeBox FitCascadeToBlocks(const XMFLOAT3 corners[8], AxisAlignedBoundingBox* blocks, unsigned int numBlocks,
+	AxisAlignedBoundingBox& bbScene, FXMMATRIX V, unsigned int sizeCascade) {
+	XMFLOAT4 planes[6];
+	CalcSlicePlanes(corners, planes);
+
+	// world space box around the slice, used to trim the blocks down to the part inside the slice.
+	XMFLOAT3 sliceMin = corners[0];
+	XMFLOAT3 sliceMax = corners[0];
+	for (int i = 1; i < 8; ++i) {
+		sliceMin = XMFLOAT3(fminf(sliceMin.x, corners[i].x), fminf(sliceMin.y, corners[i].y), fminf(sliceMin.z, corners[i].z));
+		sliceMax = XMFLOAT3(fmaxf(sliceMax.x, corners[i].x), fmaxf(sliceMax.y, corners[i].y), fmaxf(sliceMax.z, corners[i].z));
+	}
+
+	// the receivers are every block touching the slice, trimmed to the slice's box.
+	CascadeBox box;
+	box.min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	box.max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	bool isEmpty = true;
+	for (unsigned int b = 0; b < numBlocks; ++b) {
+		XMFLOAT3 bmin = blocks[b].GetMin();
+		XMFLOAT3 bmax = blocks[b].GetMax();
+
+		// same box vs plane test as the patch culling.
+		if (!AABBIntersectsPlanes(bmin, bmax, planes, 6)) continue;
+
+		XMFLOAT3 tmin(fmaxf(bmin.x, sliceMin.x), fmaxf(bmin.y, sliceMin.y), fmaxf(bmin.z, sliceMin.z));
+		XMFLOAT3 tmax(fminf(bmax.x, sliceMax.x), fminf(bmax.y, sliceMax.y), fminf(bmax.z, sliceMax.z));
+		// the plane test is conservative, so a block can pass it without actually overlapping the slice.
+		if (tmin.x > tmax.x || tmin.y > tmax.y || tmin.z > tmax.z) continue;
+
+		AxisAlignedBoundingBox trimmed(tmin, tmax);
+		XMFLOAT3 cornersBlock[8];
+		trimmed.GetCorners(cornersBlock);
+		CascadeBox boxBlock = CalcLightSpaceBounds(cornersBlock, 8, V);
+		box.min = XMFLOAT3(fminf(box.min.x, boxBlock.min.x), fminf(box.min.y, boxBlock.min.y), fminf(box.min.z, boxBlock.min.z));
+		box.max = XMFLOAT3(fmaxf(box.max.x, boxBlock.max.x), fmaxf(box.max.y, boxBlock.max.y), fmaxf(box.max.z, boxBlock.max.z));
+		isEmpty = false;
+	}
+
+	if (isEmpty) {
+		return FitCascadeToSlice(corners, bbScene, V, sizeCascade);
+	}
+
+	// both boxes are conservative, so their overlap is too.
+	CascadeBox boxSlice = CalcSliceBounds(corners, bbScene, V);
+	if (box.min.x < boxSlice.max.x && box.max.x > boxSlice.min.x && box.min.y < boxSlice.max.y && box.max.y > boxSlice.min.y) {
+		box.min.x = fmaxf(box.min.x, boxSlice.min.x);
+		box.min.y = fmaxf(box.min.y, boxSlice.min.y);
+		box.max.x = fminf(box.max.x, boxSlice.max.x);
+		box.max.y = fminf(box.max.y, boxSlice.max.y);
+	}
+
+	// the casters are every block that overlaps the receivers when seen from the light. Only their near side matters.
+	for (unsigned int b = 0; b < numBlocks; ++b) {
+		XMFLOAT3 cornersBlock[8];
+		blocks[b].GetCorners(cornersBlock);
+		CascadeBox boxBlock = CalcLightSpaceBounds(cornersBlock, 8, V);
+		if (boxBlock.min.x < box.max.x && boxBlock.max.x > box.min.x && boxBlock.min.y < box.max.y && boxBlock.max.y > box.min.y) {
+			box.min.z = fminf(box.min.z, boxBlock.min.z);
+		}
+	}
+
+	return SnapCascadeBox(box, sizeCascade);
+}
+
+// Fit a snapped light space box around all of bbScene.
+CascadeBox FitCascadeToBox(AxisAlignedBoundingBox& bbScene, FXMMATRIX V, unsigned int sizeCascade) {
+	XMFLOAT3 corners[8];
+	bbScene.GetCorners(corners);
+
+	return SnapCascadeBox(CalcLightSpaceBounds(corners, 8, V), sizeCascade);
+}
+
+// Return the orthographic projection matching the light space box.
+XMMATRIX CalcCascadeProjection(CascadeBox box) {
+	return XMMatrixOrthographicOffCenterLH(box.min.x, box.max.x, box.min.y, box.max.y, box.min.z, box.max.z);
+}
+
+// Return the number of shadow map texels per world unit for a box covered by a cascade sizeCascade texels wide.
+float CalcTexelDensity(CascadeBox box, unsigned int sizeCascade) {
+	float extent = fmaxf(box.max.x - box.min.x, box.max.y - box.min.y);
+	return extent > 0.0f ? (float)sizeCascade / extent : 0.0f;
+}
+
+// Return the number of shadow map texels per world unit for a padded sphere of radius covered by a cascade sizeCascade texels wide.
+float CalcSphereTexelDensity(float radius, unsigned int sizeCascade) {
+	return (float)sizeCascade / (2.0f * ceilf(radius) * (float)(sizeCascade + CASCADE_PADDING_TEXELS) / (float)sizeCascade);
+}
+
+// Write the 6 inward facing planes of the frustum slice with the provided corners to planes. Corners are ordered as for ClipSliceToHeightRange().
+void CalcSlicePlanes(const XMFLOAT3 corners[8], XMFLOAT4 planes[6]) {
+	XMVECTOR centroid = XMVectorZero();
+	for (int i = 0; i < 8; ++i) {
+		centroid += XMLoadFloat3(&corners[i]);
+	}
+	centroid /= 8.0f;
+
+	// each face holds the 4 corners sharing the same value for one bit of their index.
+	for (int bit = 0; bit < 3; ++bit) {
+		for (int side = 0; side < 2; ++side) {
+			XMVECTOR face[4];
+			int n = 0;
+			for (int i = 0; i < 8 && n < 4; ++i) {
+				if (((i >> bit) & 1) == side) face[n++] = XMLoadFloat3(&corners[i]);
+			}
+
+			// the first three corners of a face are never on one line.
+			XMVECTOR plane = XMPlaneNormalize(XMPlaneFromPoints(face[0], face[1], face[2]));
+			// point the plane towards the inside of the slice.
+			if (XMVectorGetX(XMPlaneDotCoord(plane, centroid)) < 0.0f) {
+				plane = -plane;
+			}
+			XMStoreFloat4(&planes[bit * 2 + side], plane);
+		}
+	}
+}
+
+// every cascade must fit in SHADOW_CASCADE_MAP_BITS, and every instance's bits in the one 32 bit root constant.
+static_assert(MAX_SHADOW_CASCADES <= (1u << SHADOW_CASCADE_MAP_BITS) && MAX_SHADOW_CASCADES * SHADOW_CASCADE_MAP_BITS <= 32,
+	"MAX_SHADOW_CASCADES can't be packed into the cascadeMap root constant.");
+
+// Return the cascadeMap root constant for a single pass shadow draw of num instances, where instance i renders cascades[i].
+unsigned int PackCascadeMap(const unsigned int* cascades, unsigned int num) {
+	unsigned int cascadeMap = 0;
+	for (unsigned int i = 0; i < num; ++i) {
+		cascadeMap |= cascades[i] << (i * SHADOW_CASCADE_MAP_BITS);
+	}
+
+	return cascadeMap;
+}
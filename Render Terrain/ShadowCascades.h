@@ -0,0 +1,89 @@
+/*
+ShadowCascades.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Math for splitting the view frustum into shadow cascades and fitting an
+				orthographic light projection to each of them. Only depends on DirectXMath
+				so it can be used and checked without a Direct3D 12 device.
+
+Usage:			- Call CalcCascadeSplits() to find where each cascade starts and ends along
+					the view direction. lambda blends between uniform (0) and logarithmic (1) splits.
+				- Call FitCascadeToSlice() with the world space corners of a frustum slice to
+					get a light space box around the part of the slice the scene can occupy.
+				- Call FitCascadeToBlocks() instead when the scene is broken up into blocks with their own
+					height bounds. Only blocks touching the slice count as receivers, which fits much tighter
+					over uneven terrain than the height range of the whole scene.
+				- Call FitCascadeToBox() to get a light space box around a whole bounding box.
+				- Both return boxes that are square, texel snapped, and quantized so that small
+					camera movements produce exactly the same box.
+				- Call CalcCascadeProjection() to turn a box into an orthographic projection.
+				- Call CalcLightView() for the light's view of the scene the boxes are fitted in.
+				- Call PackCascadeMap() to pack the cascades drawn by a single pass shadow draw into its root constant.
+				- Call CalcTexelDensity() to measure how many shadow texels a box spends per world unit, and
+					CalcSphereTexelDensity() for what fitting a padded sphere around the slice would have given.
+
+Future Work:	- Take the camera's far plane into account for the scene cascade.
+*/
+#pragma once
+
+#include "BoundingVolume.h"
+#include "ShadowCascadeLimits.h"
+
+using namespace DirectX;
+
+// the shaders hold fixed size arrays of this many cascades.
+static const unsigned int MAX_SHADOW_CASCADES = SHADOW_CASCADE_LIMIT;
+// texels of padding added around each cascade for PCF and for snapping.
+static const unsigned int CASCADE_PADDING_TEXELS = 8;
+// cascade widths are rounded up to one of this many steps per power of two.
+static const float CASCADE_EXTENT_STEPS = 8.0f;
+// light space near and far planes are rounded out to multiples of this.
+static const float CASCADE_DEPTH_STEP = 16.0f;
+// view distance the first cascade starts at.
+static const float CASCADE_NEAR_PLANE = 0.1f;
+// view distance the last split cascade ends at. Past this only the scene cascade is used.
+static const float CASCADE_FAR_PLANE = 256.0f;
+// the most points a frustum slice can have after being clipped to a height range. 8 corners + 12 edges * 2 planes.
+static const unsigned int MAX_CLIPPED_SLICE_POINTS = 32;
+
+// A box in light space. x and y are in the light's view plane, z is the distance from the light.
+struct CascadeBox {
+	XMFLOAT3 min;
+	XMFLOAT3 max;
+};
+
+// Return the view matrix of a light shining along lightdir onto bbScene, from far enough back to see all of it.
+XMMATRIX CalcLightView(AxisAlignedBoundingBox& bbScene, FXMVECTOR lightdir);
+// Write numCascades + 1 view distances to splits. Cascade i runs from splits[i] to splits[i + 1].
+// lambda blends between a uniform (0) and logarithmic (1) distribution of the splits.
+void CalcCascadeSplits(float zNear, float zFar, unsigned int numCascades, float lambda, float* splits);
+// Clip the frustum slice with the provided corners to the world space height range [zMin, zMax].
+// Corners are ordered so that bit 0 of the index picks left/right, bit 1 bottom/top, and bit 2 near/far, as per AxisAlignedBoundingBox::GetCorners().
+// Writes the points bounding what is left to points, which must have room for MAX_CLIPPED_SLICE_POINTS. Returns the number written.
+unsigned int ClipSliceToHeightRange(const XMFLOAT3 corners[8], float zMin, float zMax, XMFLOAT3* points);
+// Return the light space box around the provided world space points.
+CascadeBox CalcLightSpaceBounds(const XMFLOAT3* points, unsigned int numPoints, FXMMATRIX V);
+// Make a light space box square, snap it to the texel grid of a cascade sizeCascade texels wide, and round its depth range out.
+CascadeBox SnapCascadeBox(CascadeBox box, unsigned int sizeCascade);
+// Fit a snapped light space box around the part of the frustum slice with the provided corners that lies within bbScene.
+// The near plane is pulled back to the edge of bbScene so that anything between the light and the slice still casts shadows.
+CascadeBox FitCascadeToSlice(const XMFLOAT3 corners[8], AxisAlignedBoundingBox& bbScene, FXMMATRIX V, unsigned int sizeCascade);
+// Fit a snapped light space box around the part of the frustum slice with the provided corners covered by the numBlocks blocks.
+// Blocks must all lie within bbScene. Only blocks behind receiving blocks, as seen from the light, are kept as shadow casters.
+// Falls back to FitCascadeToSlice() if the slice doesn't touch any of the blocks.
+CascadeBox FitCascadeToBlocks(const XMFLOAT3 corners[8], AxisAlignedBoundingBox* blocks, unsigned int numBlocks,
+	AxisAlignedBoundingBox& bbScene, FXMMATRIX V, unsigned int sizeCascade);
+// Fit a snapped light space box around all of bbScene.
+CascadeBox FitCascadeToBox(AxisAlignedBoundingBox& bbScene, FXMMATRIX V, unsigned int sizeCascade);
+// Return the orthographic projection matching the light space box.
+XMMATRIX CalcCascadeProjection(CascadeBox box);
+// Return the number of shadow map texels per world unit for a box covered by a cascade sizeCascade texels wide.
+float CalcTexelDensity(CascadeBox box, unsigned int sizeCascade);
+// Return the number of shadow map texels per world unit for a padded sphere of radius covered by a cascade sizeCascade texels wide.
+float CalcSphereTexelDensity(float radius, unsigned int sizeCascade);
+// Write the 6 inward facing planes of the frustum slice with the provided corners to planes. Corners are ordered as for ClipSliceToHeightRange().
+void CalcSlicePlanes(const XMFLOAT3 corners[8], XMFLOAT4 planes[6]);
+// Return the cascadeMap root constant for a single pass shadow draw of num instances, where instance i renders cascades[i].
+unsigned int PackCascadeMap(const unsigned int* cascades, unsigned int num);
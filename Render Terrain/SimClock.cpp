@@ -0,0 +1,73 @@
+/*
+SimClock.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Clocks that tell the simulation how much time has passed, and a time of day curve.
+*/
+#include "SimClock.h"
+#include <cmath>
+
+// Returns the milliseconds that really passed since the last tick.
+double RealTimeClock::Advance() {
+	auto now = std::chrono::steady_clock::now();
+	double elapsed = std::chrono::duration<double, std::milli>(now - m_tLast).count();
+	m_tLast = now;
+
+	return elapsed;
+}
+
+ScriptedClock::ScriptedClock(const double* steps, unsigned int num, bool isLooping) : m_listSteps(steps, steps + num), m_iNext(0),
+	m_isLooping(isLooping) {
+}
+
+// Returns the next step in the list.
+double ScriptedClock::Advance() {
+	if (m_listSteps.empty()) return 0.0;
+
+	if (m_iNext >= m_listSteps.size()) {
+		if (!m_isLooping) return m_listSteps.back();
+		m_iNext = 0;
+	}
+
+	return m_listSteps[m_iNext++];
+}
+
+// Add a key putting the sun at angle degrees at time milliseconds. Keys must be added in time order.
+// Returns false if time is before the last key.
+bool TimeOfDayCurve::AddKey(double time, float angle) {
+	if (!m_listKeys.empty() && time < m_listKeys.back().time) return false;
+
+	Key k = { time, angle };
+	m_listKeys.push_back(k);
+	return true;
+}
+
+// Returns the sun angle in degrees, [0, 360), at time milliseconds. Before the first key and after the last the curve is flat.
+float TimeOfDayCurve::Evaluate(double time) {
+	if (m_listKeys.empty()) return 0.0f;
+
+	float angle;
+	if (time <= m_listKeys.front().time) {
+		angle = m_listKeys.front().angle;
+	} else if (time >= m_listKeys.back().time) {
+		angle = m_listKeys.back().angle;
+	} else {
+		// find the first key after time. There are rarely more than a handful, so a linear search does.
+		unsigned int i = 1;
+		while (m_listKeys[i].time <= time) ++i;
+		const Key& k0 = m_listKeys[i - 1];
+		const Key& k1 = m_listKeys[i];
+
+		// go the short way around, ie from 350 to 10 through 0 rather than 180.
+		float delta = fmodf(k1.angle - k0.angle, 360.0f);
+		if (delta > 180.0f) delta -= 360.0f;
+		if (delta < -180.0f) delta += 360.0f;
+		float s = (float)((time - k0.time) / (k1.time - k0.time));
+		angle = k0.angle + s * delta;
+	}
+
+	angle = fmodf(angle, 360.0f);
+	return angle < 0.0f ? angle + 360.0f : angle;
+}
@@ -0,0 +1,106 @@
+/*
+SimClock.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Clocks that tell the simulation how much time has passed. The real time clock follows the
+				wall clock. The fixed step and scripted clocks move on by set amounts each tick, so a run
+				repeats exactly no matter how fast the machine is. Also a time of day curve, for replaying
+				the sun along a fixed path instead of letting it move with time.
+
+Usage:			- Call Tick() once per update. It returns the milliseconds that passed since the last tick.
+					GetTime() returns the total since the clock was created.
+				- RealTimeClock: the time that really passed between ticks.
+				- FixedStepClock: the same step every tick. Use with a fixed time step simulation.
+				- ScriptedClock: steps taken from a list, one per tick. Once the list runs out it starts
+					over if looping, or keeps repeating the last step.
+				- TimeOfDayCurve: add keys of time in milliseconds and sun angle in degrees, in time order.
+					Evaluate() interpolates between them, taking the short way around the circle, so keys
+					further apart than 180 degrees need a key between them.
+				- Clocks are plain C++ and can be shared, but only one object should call Tick().
+
+Future Work:	- Load scripted steps and time of day curves from a file.
+*/
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+class SimClock {
+public:
+	SimClock() : m_time(0.0) {}
+	virtual ~SimClock() {}
+
+	// Move the clock on by one update. Returns the milliseconds that passed.
+	double Tick() {
+		double elapsed = Advance();
+		m_time += elapsed;
+		return elapsed;
+	}
+	// Returns the milliseconds that have passed over every tick so far.
+	double GetTime() { return m_time; }
+
+protected:
+	// Returns the milliseconds that pass in this tick.
+	virtual double Advance() = 0;
+
+private:
+	double m_time;
+};
+
+class RealTimeClock : public SimClock {
+public:
+	RealTimeClock() : m_tLast(std::chrono::steady_clock::now()) {}
+
+protected:
+	// Returns the milliseconds that really passed since the last tick.
+	double Advance();
+
+private:
+	std::chrono::steady_clock::time_point	m_tLast;
+};
+
+class FixedStepClock : public SimClock {
+public:
+	FixedStepClock(double msStep) : m_msStep(msStep) {}
+
+protected:
+	double Advance() { return m_msStep; }
+
+private:
+	double	m_msStep;
+};
+
+class ScriptedClock : public SimClock {
+public:
+	// Copies num steps, in milliseconds.
+	ScriptedClock(const double* steps, unsigned int num, bool isLooping);
+
+protected:
+	// Returns the next step in the list.
+	double Advance();
+
+private:
+	std::vector<double>	m_listSteps;
+	unsigned int		m_iNext;
+	bool				m_isLooping;
+};
+
+class TimeOfDayCurve {
+public:
+	// Add a key putting the sun at angle degrees at time milliseconds. Keys must be added in time order.
+	// Returns false if time is before the last key.
+	bool AddKey(double time, float angle);
+	// Returns the sun angle in degrees, [0, 360), at time milliseconds. Before the first key and after the last the curve is flat.
+	float Evaluate(double time);
+	unsigned int GetNumKeys() { return (unsigned int)m_listKeys.size(); }
+
+private:
+	struct Key {
+		double	time;
+		float	angle;
+	};
+
+	std::vector<Key>	m_listKeys;
+};
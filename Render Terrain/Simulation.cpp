@@ -0,0 +1,229 @@
+/*
+Simulation.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Runs everything that moves in the scene on a thread of its own, in fixed time steps.
+*/
+#include "Simulation.h"
+
+Simulation::Simulation(const SimSnapshot& initial, TerrainWorld* world, InputQueue* input) : m_Clock(SIM_STEP_SECONDS * 1000.0),
+	m_State(initial), m_Snapshots(initial), m_pWorld(world), m_pT(world->GetTile(0)), m_pInput(input),
+	m_Collision(m_pT->GetSurface(), SIM_COLLISION_LOD, 0), m_isRunning(false), m_numStepsSkipped(0) {
+	// every step is the same length, so the day/night cycle moves on by the same amount every step.
+	m_State.dnc.SetClock(&m_Clock);
+	m_bbScene = m_pWorld->GetBoundingBox();
+	for (int i = 0; i < 256; ++i) {
+		m_isKeyDown[i] = false;
+	}
+	m_mouseX = 0;
+	m_mouseY = 0;
+}
+
+Simulation::~Simulation() {
+	Stop();
+	if (!m_fnPath.empty() && !SaveCameraPath(m_fnPath.c_str(), m_listPath)) {
+		OutputDebugStringA(("Simulation: couldn't write the camera path to " + m_fnPath + ".\n").c_str());
+	}
+	m_pT = nullptr;
+	m_pWorld = nullptr;
+	m_pInput = nullptr;
+}
+
+// Start running steps on the simulation thread.
+void Simulation::Start() {
+	if (m_isRunning) return;
+
+	m_isRunning = true;
+	m_Thread = std::thread(&Simulation::Run, this);
+}
+
+// Stop the simulation thread and wait for it to finish.
+void Simulation::Stop() {
+	m_isRunning = false;
+	if (m_Thread.joinable()) {
+		m_Thread.join();
+	}
+}
+
+// The simulation thread. Takes as many steps as real time has passed and publishes the result.
+// Steps are a fixed length so the camera moves the same distance however fast the frames are drawn.
+void Simulation::Run() {
+	auto tLast = steady_clock::now();
+	double timeBehind = 0.0;
+
+	while (m_isRunning) {
+		auto tNow = steady_clock::now();
+		timeBehind += duration<double>(tNow - tLast).count();
+		tLast = tNow;
+
+		unsigned int numSteps = 0;
+		while (timeBehind >= SIM_STEP_SECONDS && numSteps < SIM_MAX_STEPS_PER_UPDATE) {
+			Step();
+			timeBehind -= SIM_STEP_SECONDS;
+			++numSteps;
+		}
+
+		// rather than spend ever longer catching up, let the simulation run slow for a moment.
+		if (timeBehind >= SIM_STEP_SECONDS) {
+			m_numStepsSkipped += (unsigned long long)(timeBehind / SIM_STEP_SECONDS);
+			timeBehind = 0.0;
+		}
+
+		if (numSteps > 0) {
+			Publish();
+		} else {
+			std::this_thread::sleep_for(milliseconds(1));
+		}
+	}
+}
+
+// Take a single step. Called by the thread, or directly when the thread isn't running.
+void Simulation::Step() {
+	// the render thread may be editing the terrain.
+	std::lock_guard<std::mutex> lock(m_pT->GetEditLock());
+
+	// rebuild the collision mesh wherever the terrain changed.
+	m_listEditedRegions.clear();
+	m_pT->TakeEditedRegions(m_listEditedRegions);
+	for (auto& r : m_listEditedRegions) {
+		m_Collision.Invalidate(r.x, r.y, r.z, r.w);
+	}
+	// the render thread copies the edited tile's bounds into the world's after uploading the edits, which may be after
+	// their regions were taken, so fit the shadows to the world's bounds every step. There are only a few tiles.
+	m_bbScene = m_pWorld->GetBoundingBox();
+
+	InputEvent e;
+	while (m_pInput->Pop(e)) {
+		HandleEvent(e);
+	}
+
+	// the camera only moves in 3D.
+	if (m_State.drawMode > 0) {
+		float dist = SIM_MOVE_SPEED * (float)SIM_STEP_SECONDS;
+		XMFLOAT3 move(0.0f, 0.0f, 0.0f);
+		if (m_isKeyDown[_W]) move.x += dist;
+		if (m_isKeyDown[_S]) move.x -= dist;
+		if (m_isKeyDown[_A]) move.y += dist;
+		if (m_isKeyDown[_D]) move.y -= dist;
+		if (m_isKeyDown[_Q]) move.z += dist;
+		if (m_isKeyDown[_Z]) move.z -= dist;
+		if (move.x != 0.0f || move.y != 0.0f || move.z != 0.0f) {
+			m_State.cam.Translate(move);
+		}
+
+		if (m_mouseY != 0) m_State.cam.Pitch(ROT_ANGLE * m_mouseY);
+		if (m_mouseX != 0) m_State.cam.Yaw(-ROT_ANGLE * m_mouseX);
+	}
+	m_mouseX = 0;
+	m_mouseY = 0;
+
+	if (m_State.isLockedToTerrain) {
+		XMFLOAT4 eye = m_State.cam.GetEyePosition();
+		float h = m_pWorld->GetHeightAtPoint(eye.x, eye.y) + 2;
+		m_State.cam.LockPosition(XMFLOAT4(eye.x, eye.y, h, 1.0f));
+	}
+
+	XMFLOAT4 eye = m_State.cam.GetEyePosition();
+	XMFLOAT3 body(eye.x, eye.y, eye.z);
+	m_Collision.Update(&body, 1, SIM_COLLISION_RADIUS);
+	m_State.collision = m_Collision.GetStats();
+
+	m_State.dnc.Update(m_bbScene, &m_State.cam);
+	++m_State.numSteps;
+
+	if (!m_fnPath.empty()) {
+		XMFLOAT4 look = m_State.cam.GetLookDirection();
+		m_listPath.push_back({ m_State.numSteps * SIM_STEP_SECONDS, body, XMFLOAT3(look.x, look.y, look.z) });
+	}
+}
+
+// Take a single step and publish the result. Only call when the thread isn't running.
+void Simulation::Advance() {
+	Step();
+	Publish();
+}
+
+// Apply a single input event to the state.
+void Simulation::HandleEvent(const InputEvent& e) {
+	switch (e.type) {
+		case INPUT_KEY_UP:
+			if (e.key < 256) m_isKeyDown[e.key] = false;
+			break;
+		case INPUT_MOUSE_MOVE:
+			m_mouseX += e.x;
+			m_mouseY += e.y;
+			break;
+		case INPUT_KEY_DOWN:
+			if (e.key < 256) m_isKeyDown[e.key] = true;
+			switch (e.key) {
+				case _1: // draw in 2D. draw heightmap.
+					m_State.drawMode = 0;
+					break;
+				case _2: // draw in 3D.
+					m_State.drawMode = 1;
+					break;
+				case _T:
+					m_State.useTextures = !m_State.useTextures;
+					break;
+				case _L:
+					m_State.isLockedToTerrain = !m_State.isLockedToTerrain;
+					break;
+				case _G:
+					m_State.isGPUCulling = !m_State.isGPUCulling;
+					break;
+				case _H:
+					m_State.isOcclusionCulling = !m_State.isOcclusionCulling;
+					break;
+				case _P:
+					m_State.isProceduralPatches = !m_State.isProceduralPatches;
+					break;
+				case _B:
+					++m_State.numTriangleReports;
+					break;
+				case _R:
+					Paint(BRUSH_RAISE);
+					break;
+				case _F:
+					Paint(BRUSH_LOWER);
+					break;
+				case VK_SPACE:
+					m_State.dnc.TogglePause();
+					break;
+			}
+			break;
+	}
+}
+
+// Make a brush stroke where the camera is looking, if it's looking at the terrain.
+void Simulation::Paint(TerrainBrushMode mode) {
+	XMFLOAT4 eye = m_State.cam.GetEyePosition();
+	XMFLOAT4 look = m_State.cam.GetLookDirection();
+	HeightfieldRay ray = { XMFLOAT3(eye.x, eye.y, eye.z), XMFLOAT3(look.x, look.y, look.z), SIM_BRUSH_REACH };
+	HeightfieldHit hit;
+	if (!m_pT->CastRay(ray, hit)) return;
+
+	TerrainBrush brush = { mode, hit.position.x, hit.position.y, SIM_BRUSH_RADIUS, SIM_BRUSH_STRENGTH, hit.position.z };
+	m_State.brushStrokes[m_State.numBrushStrokes % SIM_MAX_BRUSH_STROKES] = brush;
+	++m_State.numBrushStrokes;
+}
+
+// Copy the state to the snapshot exchange.
+void Simulation::Publish() {
+	m_Snapshots.GetWriteSlot() = m_State;
+	m_Snapshots.Publish();
+}
+
+// write the number of steps taken and skipped, and the input dropped, to the debug output. Render thread only.
+void Simulation::ReportStats() {
+	char msg[256];
+	sprintf_s(msg, "Simulation: %llu steps of %.2f ms, %llu skipped falling behind. %u input events dropped.\n",
+		m_Snapshots.GetReadSlot().numSteps, SIM_STEP_SECONDS * 1000.0, m_numStepsSkipped.load(), m_pInput->GetNumDropped());
+	OutputDebugStringA(msg);
+
+	const CollisionCacheStats& collision = m_Snapshots.GetReadSlot().collision;
+	sprintf_s(msg, "Collision: %u chunks cached with %llu triangles. %llu built, %llu dropped. last build took %.2f ms.\n",
+		collision.numChunks, collision.numTriangles, collision.numBuilt, collision.numDropped, collision.msLastBuild);
+	OutputDebugStringA(msg);
+}
@@ -0,0 +1,127 @@
+/*
+Simulation.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Runs everything that moves in the scene on a thread of its own, in fixed time steps:
+				the camera, locking it to the terrain, and the day/night cycle. Input arrives through an
+				InputQueue and the state after each batch of steps is published as a SimSnapshot for the
+				render thread to draw.
+
+Usage:			- Requires the snapshot to start from, a pointer to the TerrainWorld the camera can be locked to,
+					and a pointer to the InputQueue the window pushes its input to. Both must outlive the Simulation.
+				- Call Start() to start the thread. The destructor stops it.
+				- Keys held down move the camera SIM_MOVE_SPEED world units a second. Mouse movement is added
+					up between steps and applied once per step.
+				- The render thread calls GetSnapshots()->Acquire() once per frame and draws GetReadSlot().
+				- The simulation only reads the world, and holds the edit lock of its first tile while it steps, so the
+					render thread can keep drawing it and apply brush strokes with Terrain::Edit() meanwhile. Only the
+					first tile can be edited and collided with. The camera is locked to every tile.
+				- R and F raise and lower the terrain where the camera is looking. The snapshot keeps the last
+					SIM_MAX_BRUSH_STROKES strokes, each with its own brush, and counts them, for the render thread to
+					apply in order. Collision chunks under the parts of the terrain that were edited are rebuilt on the next step.
+				- When the thread falls more than SIM_MAX_STEPS_PER_UPDATE steps behind, the rest are skipped.
+				- The day/night cycle runs on a FixedStepClock that moves on by SIM_STEP_SECONDS every step, so the
+					sun is always in the same place after the same number of steps.
+				- The camera is the only body that needs collision so far. The collision mesh around it is kept
+					cached in a CollisionMeshCache, rebuilt on the simulation thread as it moves.
+				- For runs that repeat exactly, ie benchmarks, don't call Start(). Call Advance() once per frame
+					instead, so frame N always draws step N. SetTimeOfDayCurve() can fix the sun's path as well.
+				- SetPathRecording() records the camera's state every step and writes the path out when the
+					Simulation is destroyed, for measuring terrain prefetching against. See TerrainPrefetch.h.
+
+Future Work:	- Interpolate between the last two snapshots on the render thread.
+*/
+#pragma once
+
+#include "InputQueue.h"
+#include "SnapshotExchange.h"
+#include "TerrainWorld.h"
+#include "Camera.h"
+#include "DayNightCycle.h"
+#include "CollisionMesh.h"
+#include "TerrainPrefetch.h"
+#include <string>
+#include <thread>
+
+#define MOVE_STEP 1.0f
+#define ROT_ANGLE 0.75f
+
+static const double SIM_STEP_SECONDS = 1.0 / 120.0;			// length of a simulation step.
+static const unsigned int SIM_MAX_STEPS_PER_UPDATE = 8;		// steps taken at most before publishing a snapshot.
+static const float SIM_MOVE_SPEED = 30.0f * MOVE_STEP;		// world units a second. About what key repeat used to give.
+static const unsigned int SIM_COLLISION_LOD = 2;			// LOD of the collision mesh kept around the camera. See CollisionMesh.h.
+static const float SIM_COLLISION_RADIUS = 48.0f;			// world units around the camera the collision mesh covers.
+static const float SIM_BRUSH_RADIUS = 16.0f;				// world units the brush reaches from where the camera is looking.
+static const float SIM_BRUSH_STRENGTH = 1.0f;				// world units a stroke moves the terrain under the centre of the brush.
+static const float SIM_BRUSH_REACH = 2000.0f;				// how far from the camera the brush can be used.
+static const unsigned int SIM_MAX_BRUSH_STROKES = 64;		// strokes a snapshot keeps. Older ones are lost if the render thread falls this far behind.
+
+// Everything the render thread needs from the simulation for one frame.
+struct SimSnapshot {
+	Camera			cam;
+	DayNightCycle	dnc;
+	unsigned long long	numSteps;				// steps simulated up to this snapshot.
+	unsigned int	numTriangleReports;			// times a triangle estimate was asked for. Reported by the render thread.
+	int				drawMode;
+	bool			useTextures;
+	bool			isGPUCulling;
+	bool			isOcclusionCulling;
+	bool			isProceduralPatches;
+	bool			isLockedToTerrain;
+	CollisionCacheStats	collision;				// the collision mesh cached around the camera.
+	TerrainBrush	brushStrokes[SIM_MAX_BRUSH_STROKES];	// the last strokes made. Stroke n is at n % SIM_MAX_BRUSH_STROKES.
+	unsigned int	numBrushStrokes;			// brush strokes made so far. Applied by the render thread.
+};
+
+class Simulation {
+public:
+	Simulation(const SimSnapshot& initial, TerrainWorld* world, InputQueue* input);
+	~Simulation();
+
+	// Start running steps on the simulation thread.
+	void Start();
+	// Stop the simulation thread and wait for it to finish.
+	void Stop();
+	// Take a single step. Called by the thread, or directly when the thread isn't running.
+	void Step();
+	// Take a single step and publish the result. Only call when the thread isn't running.
+	void Advance();
+	// Make the sun follow curve over the simulation's time. Only call before Start(). curve must outlive the Simulation.
+	void SetTimeOfDayCurve(TimeOfDayCurve* curve) { m_State.dnc.SetTimeOfDayCurve(curve); }
+	// Record the camera's state every step and write it to fn when the Simulation is destroyed. Only call before Start().
+	void SetPathRecording(const char* fn) { m_fnPath = fn; }
+
+	SnapshotExchange<SimSnapshot>* GetSnapshots() { return &m_Snapshots; }
+	// write the number of steps taken and skipped, and the input dropped, to the debug output. Render thread only.
+	void ReportStats();
+
+private:
+	// The simulation thread. Takes as many steps as real time has passed and publishes the result.
+	void Run();
+	// Apply a single input event to the state.
+	void HandleEvent(const InputEvent& e);
+	// Make a brush stroke where the camera is looking, if it's looking at the terrain.
+	void Paint(TerrainBrushMode mode);
+	// Copy the state to the snapshot exchange.
+	void Publish();
+
+	FixedStepClock					m_Clock;				// the day/night cycle's clock.
+	SimSnapshot						m_State;
+	SnapshotExchange<SimSnapshot>	m_Snapshots;
+	TerrainWorld*					m_pWorld;
+	Terrain*						m_pT;					// the world's first tile, the one that can be edited.
+	InputQueue*						m_pInput;
+	AxisAlignedBoundingBox			m_bbScene;
+	CollisionMeshCache				m_Collision;
+	std::vector<XMFLOAT4>			m_listEditedRegions;	// see Terrain::TakeEditedRegions().
+	std::thread						m_Thread;
+	std::atomic<bool>				m_isRunning;
+	std::atomic<unsigned long long>	m_numStepsSkipped;		// steps dropped because the thread fell too far behind.
+	bool							m_isKeyDown[256];		// indexed by virtual key code.
+	int								m_mouseX;				// mouse movement since the last step.
+	int								m_mouseY;
+	std::string						m_fnPath;				// where to write the camera's path. Empty if it isn't recorded.
+	std::vector<CameraSample>		m_listPath;
+};
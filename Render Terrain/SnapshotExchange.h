@@ -0,0 +1,61 @@
+/*
+SnapshotExchange.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Hands complete snapshots of state from one thread to another without locking, using three
+				copies of the state. The writer always has a copy of its own to fill, the reader always has
+				a copy of its own to read, and the third holds the newest finished snapshot between them.
+				Neither side ever waits on the other.
+
+Usage:			- Construct with the state both sides start from. It is copied into all three slots.
+				- The writer fills the copy returned by GetWriteSlot() and then calls Publish().
+				- The reader calls Acquire() once per frame. It returns true if there was a newer snapshot, and
+					either way GetReadSlot() returns the newest snapshot the reader has, which won't change
+					until the next Acquire().
+				- Snapshots the reader didn't get to in time are skipped, never queued.
+				- Only one thread may write and only one thread may read.
+
+Future Work:	- Keep the last two snapshots so the reader can interpolate between simulation steps.
+*/
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+template <typename T>
+class SnapshotExchange {
+public:
+	SnapshotExchange(const T& initial) : m_listSlots(3, initial), m_iWrite(0), m_iShared(1), m_iRead(2) {}
+
+	// Returns the writer's copy to fill in. Writer thread only.
+	T& GetWriteSlot() { return m_listSlots[m_iWrite]; }
+	// Make the writer's copy the newest snapshot and give the writer the copy it replaced. Writer thread only.
+	void Publish() {
+		// release so the reader sees everything written to the slot. acquire so the writer doesn't touch
+		// the slot it gets back before the reader is done with it.
+		unsigned int prev = m_iShared.exchange(m_iWrite | FLAG_NEW, std::memory_order_acq_rel);
+		m_iWrite = prev & MASK_INDEX;
+	}
+
+	// Take the newest snapshot if there is one the reader hasn't seen. Returns true if there was. Reader thread only.
+	bool Acquire() {
+		if (!(m_iShared.load(std::memory_order_relaxed) & FLAG_NEW)) return false;
+
+		unsigned int prev = m_iShared.exchange(m_iRead, std::memory_order_acq_rel);
+		m_iRead = prev & MASK_INDEX;
+		return true;
+	}
+	// Returns the reader's copy. Reader thread only.
+	const T& GetReadSlot() { return m_listSlots[m_iRead]; }
+
+private:
+	static const unsigned int FLAG_NEW = 4;			// set in m_iShared when the writer has published since the reader last looked.
+	static const unsigned int MASK_INDEX = 3;
+
+	std::vector<T>				m_listSlots;
+	unsigned int				m_iWrite;			// only touched by the writer.
+	alignas(64) std::atomic<unsigned int>	m_iShared;
+	alignas(64) unsigned int	m_iRead;			// only touched by the reader.
+};
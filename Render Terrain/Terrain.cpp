@@ -9,40 +9,96 @@ Description:	Class for loading a heightmap and rendering as a terrain.
 #include "lodepng.h"
 #include "Terrain.h"
 #include "Common.h"
+#include "PatchGrid.h"
+#include <DirectXPackedVector.h>
+#include <cfloat>
+#include <chrono>
+#include <string>
+#include <thread>
 
 Terrain::Terrain(ResourceManager* rm, TerrainMaterial* mat, const char* fnHeightmap, const char* fnDisplacementMap) : 
-	m_pMat(mat), m_pResMgr(rm) {
+	m_pMat(mat), m_pResMgr(rm), m_vOrigin(0.0f, 0.0f), m_skirts(TERRAIN_SKIRT_ALL) {
+	unsigned int index = m_pResMgr->LoadFile(fnHeightmap, m_hHeightMap, m_wHeightMap);
+	Init(index, fnDisplacementMap, nullptr);
+}
+
+// Create a tile of a TerrainWorld from the heightmap data loaded into rm at iHeightMapData, placed at origin, with the
+// skirts listed as TERRAIN_SKIRT_* bits. If shared isn't null, its displacement map and index buffers are used rather than new ones.
+Terrain::Terrain(ResourceManager* rm, TerrainMaterial* mat, unsigned int iHeightMapData, unsigned int wHeightMap, unsigned int hHeightMap,
+	XMFLOAT2 origin, unsigned int skirts, const char* fnDisplacementMap, Terrain* shared) : m_pMat(mat), m_pResMgr(rm),
+	m_wHeightMap(wHeightMap), m_hHeightMap(hHeightMap), m_vOrigin(origin), m_skirts(skirts) {
+	if (shared && (shared->m_wHeightMap != m_wHeightMap || shared->m_hHeightMap != m_hHeightMap)) {
+		throw GFX_Exception("Terrain::Terrain: can't share the index buffers of a terrain of a different size.");
+	}
+
+	Init(iHeightMapData, fnDisplacementMap, shared);
+}
+
+// Load everything from the heightmap data loaded into the resource manager at iHeightMapData. See the constructors.
+void Terrain::Init(unsigned int iHeightMapData, const char* fnDisplacementMap, Terrain* shared) {
 	m_dataHeightMap = nullptr;
 	m_dataDisplacementMap = nullptr;
 	m_dataVertices = nullptr;
 	m_dataIndices = nullptr;
 	m_pConstants = nullptr;
+	m_pHeightMap = nullptr;
+	m_pDisplacementMap = nullptr;
+	m_pConstantBuffer = nullptr;
+	m_pVertexBuffer = nullptr;
+	m_pSurface = nullptr;
+	m_pRayCaster = nullptr;
+	m_rectEditedTexels = {};
+	m_regionEdited = {};
+
+	m_dataHeightMap = m_pResMgr->GetFileData(iHeightMapData);
+	CreateHeightMap();
+	if (shared) {
+		m_pDisplacementMap = shared->m_pDisplacementMap;
+		m_dataDisplacementMap = shared->m_dataDisplacementMap;
+		m_wDisplacementMap = shared->m_wDisplacementMap;
+		m_hDisplacementMap = shared->m_hDisplacementMap;
+	} else {
+		LoadDisplacementMap(fnDisplacementMap);
+	}
 
-	LoadHeightMap(fnHeightmap);
-	LoadDisplacementMap(fnDisplacementMap);
+	CreateMesh3D(shared);
 
-	CreateMesh3D();
+	// the ray caster's pyramid is built from the same heightmap, on the CPU.
+	m_pSurface = new TerrainSurface(m_dataHeightMap, m_wHeightMap, m_hHeightMap, m_scaleHeightMap, m_dataDisplacementMap,
+		m_wDisplacementMap, m_hDisplacementMap);
+	m_pSurface->SetOrigin(m_vOrigin.x, m_vOrigin.y);
+	m_pRayCaster = new HeightfieldRayCaster(m_pSurface);
 }
 
 Terrain::~Terrain() {
 	// The order resources are released appears to matter. I haven't tested all possible orders, but at least releasing the heap
 	// and resources after the pso and rootsig was causing my GPU to hang on shutdown. Using the current order resolved that issue.
+	delete m_pRayCaster;
+	m_pRayCaster = nullptr;
+	delete m_pSurface;
+	m_pSurface = nullptr;
 	m_dataHeightMap = nullptr;
 	m_dataDisplacementMap = nullptr;
 
 	DeleteVertexAndIndexArrays();
 
+	// the material is shared, so whoever created it deletes it.
 	m_pResMgr = nullptr;
-	delete m_pMat;
+	m_pMat = nullptr;
 }
 
-void Terrain::Draw(ID3D12GraphicsCommandList* cmdList, bool Draw3D) {
+// Draw the terrain. The base vertex of each chunk is set in the root constants at constantsRootIndex.
+void Terrain::Draw(ID3D12GraphicsCommandList* cmdList, unsigned int constantsRootIndex, bool Draw3D) {
 	if (Draw3D) {
-		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST); // describe how to read the vertex buffer.
-		cmdList->IASetVertexBuffers(0, 1, &m_viewVertexBuffer);
-		cmdList->IASetIndexBuffer(&m_viewIndexBuffer);
+		// there's no vertex buffer. The vertex shader builds each control point from SV_VertexID.
+		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+
+		cmdList->IASetIndexBuffer(&m_viewChunkIndexBuffer);
+		DrawChunks(cmdList, constantsRootIndex);
 
-		cmdList->DrawIndexedInstanced(m_numIndices, 1, 0, 0, 0);
+		// the skirts and bottom plane reach across the whole vertex range, so they keep 32 bit indices.
+		cmdList->IASetIndexBuffer(&m_viewIndexBuffer);
+		DrawSkirts(cmdList);
 	} else {
 		// draw in 2D
 		cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); // describe how to read the vertex buffer.
@@ -50,219 +106,484 @@ void Terrain::Draw(ID3D12GraphicsCommandList* cmdList, bool Draw3D) {
 	}
 }
 
-// Clean up array data.
-void Terrain::DeleteVertexAndIndexArrays() {
-	if (m_dataVertices) {
-		delete[] m_dataVertices;
-		m_dataVertices = nullptr;
+// Draw the terrain patches, chunk by chunk, from the index buffer GetChunkIndexView() returns, which must be bound.
+// Each chunk's base vertex is set in the root constants at constantsRootIndex, and put back to 0 afterwards.
+void Terrain::DrawChunks(ID3D12GraphicsCommandList* cmdList, unsigned int constantsRootIndex, unsigned int numInstances) {
+	// the terrain patches are drawn one chunk at a time from 16 bit indices. There's no vertex buffer for BaseVertexLocation
+	// to offset, and SV_VertexID is only the index fetched, so the vertex shaders add the base vertex from the root constant.
+	for (auto& chunk : m_listChunks) {
+		cmdList->SetGraphicsRoot32BitConstant(constantsRootIndex, chunk.baseVertex, TERRAIN_BASE_VERTEX_CONSTANT);
+		cmdList->DrawIndexedInstanced(chunk.numIndices, numInstances, chunk.firstIndex, 0, 0);
 	}
+	cmdList->SetGraphicsRoot32BitConstant(constantsRootIndex, 0, TERRAIN_BASE_VERTEX_CONSTANT);
+}
 
-	if (m_dataIndices) {
-		delete[] m_dataIndices;
-		m_dataIndices = nullptr;
+// Draw the sides of the skirt to be drawn and the bottom plane from the index buffer GetSkirtIndexView() returns, which must be bound.
+void Terrain::DrawSkirts(ID3D12GraphicsCommandList* cmdList, unsigned int numInstances) {
+	// the sides of the skirt come one after the other, followed by the bottom plane. Neighbouring sides are drawn together.
+	unsigned int numSideIndices[4] = { (unsigned int)(m_infoMesh.numX - 1) * 4, (unsigned int)(m_infoMesh.numX - 1) * 4,
+		(unsigned int)(m_infoMesh.numY - 1) * 4, (unsigned int)(m_infoMesh.numY - 1) * 4 };
+	unsigned int iStart = 0;
+	unsigned int iFirst = 0;
+	unsigned int numIndices = 0;
+	for (int side = 0; side < 4; ++side) {
+		if (m_skirts & (1 << (side + 1))) {
+			if (numIndices == 0) iFirst = iStart;
+			numIndices += numSideIndices[side];
+		} else if (numIndices > 0) {
+			cmdList->DrawIndexedInstanced(numIndices, numInstances, iFirst, 0, 0);
+			numIndices = 0;
+		}
+		iStart += numSideIndices[side];
 	}
 
-	if (m_pConstants) {
-		delete m_pConstants;
-		m_pConstants = nullptr;
+	// the bottom plane closes off the terrain from below, so it's always drawn.
+	if (numIndices == 0) iFirst = iStart;
+	numIndices += 4;
+	cmdList->DrawIndexedInstanced(numIndices, numInstances, iFirst, 0, 0);
+}
+
+// Draw the whole terrain without an index buffer. The vertex shader works out each patch's control points from SV_VertexID.
+// Requires a pipeline built with RenderTerrainTessProceduralVS.hlsl.
+void Terrain::DrawProcedural(ID3D12GraphicsCommandList* cmdList) {
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+	cmdList->DrawInstanced(m_numIndices, 1, 0, 0);
+}
+
+// Draw numIndices indices, starting at startIndex, from the provided patch index buffer. Draws numInstances instances.
+void Terrain::DrawPatches(ID3D12GraphicsCommandList* cmdList, D3D12_INDEX_BUFFER_VIEW* view, unsigned int startIndex, 
+	unsigned int numIndices, unsigned int numInstances) {
+	if (numIndices == 0) return;
+
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+	cmdList->IASetIndexBuffer(view);
+
+	cmdList->DrawIndexedInstanced(numIndices, numInstances, startIndex, 0, 0);
+}
+
+// Draw the patches in the provided index buffer with ExecuteIndirect, using the draw arguments at offsetArgs in args.
+// sig must describe a single DrawIndexedInstanced.
+void Terrain::DrawPatchesIndirect(ID3D12GraphicsCommandList* cmdList, D3D12_INDEX_BUFFER_VIEW* view, ID3D12CommandSignature* sig,
+	ID3D12Resource* args, unsigned long long offsetArgs) {
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+	cmdList->IASetIndexBuffer(view);
+
+	cmdList->ExecuteIndirect(sig, 1, args, offsetArgs, nullptr, 0);
+}
+
+// Fill list with the bounds and control point indices of every patch, in the same order as the index buffer.
+void Terrain::GetPatchCullData(std::vector<PatchCullData>& list) {
+	unsigned long numPatches = m_numIndices / 4;
+	list.resize(numPatches);
+	for (unsigned long p = 0; p < numPatches; ++p) {
+		// the bounds of each patch are stored in its first control point.
+		Vertex& v = m_dataVertices[m_dataIndices[p * 4]];
+		list[p].aabbmin = v.aabbmin;
+		list[p].aabbmax = v.aabbmax;
+		memcpy(list[p].indices, &m_dataIndices[p * 4], 4 * sizeof(UINT));
 	}
 }
 
-// generate vertex and index buffers for 3D mesh of terrain
-void Terrain::CreateMesh3D() {
-	// Create a vertex buffer
-	m_scaleHeightMap = (float)m_wHeightMap / 16.0f;
-	int tessFactor = 8;
-	int scalePatchX = m_wHeightMap / tessFactor;
-	int scalePatchY = m_hHeightMap / tessFactor;
-	int numVertsInTerrain = scalePatchX * scalePatchY;
-	// number of vertices needed for terrain + base vertices for skirt.
-	m_numVertices = numVertsInTerrain + scalePatchX * 4;
-
-	// create a vertex array 1/4 the size of the height map in each dimension,
-	// to be stretched over the height map
-	int arrSize = (int)(m_numVertices);
-	m_dataVertices = new Vertex[arrSize];
-	for (int y = 0; y < scalePatchY; ++y) {
-		for (int x = 0; x < scalePatchX; ++x) {
-			m_dataVertices[y * scalePatchX + x].position = XMFLOAT3((float)x * tessFactor, (float)y * tessFactor, ((float)m_dataHeightMap[((y * m_wHeightMap + x) * 4) * tessFactor] / 255.0f) * m_scaleHeightMap);
-			m_dataVertices[y * scalePatchX + x].skirt = 5;
-		}
+// Fill list with the bounds and control point indices of num patches, starting at patch first.
+void Terrain::GetPatchCullData(std::vector<PatchCullData>& list, unsigned long first, unsigned long num) {
+	list.resize(num);
+	for (unsigned long p = 0; p < num; ++p) {
+		// the bounds of each patch are stored in its first control point.
+		Vertex& v = m_dataVertices[m_dataIndices[(first + p) * 4]];
+		list[p].aabbmin = v.aabbmin;
+		list[p].aabbmax = v.aabbmax;
+		memcpy(list[p].indices, &m_dataIndices[(first + p) * 4], 4 * sizeof(UINT));
 	}
+}
 
-	XMFLOAT2 zBounds = CalcZBounds(m_dataVertices[0], m_dataVertices[numVertsInTerrain - 1]);
-	m_hBase = zBounds.x - 10;
+// Apply a single stroke of brush to the heightmap and update the mesh, the ray casting pyramid, and the bounds around it.
+// Returns true if the heightmap changed. Render thread only.
+bool Terrain::Edit(const TerrainBrush& brush) {
+	std::lock_guard<std::mutex> lock(m_mutexEdit);
 
-	// create base vertices for side 1 of skirt. y = 0.
-	int iVertex = numVertsInTerrain;
-	for (int x = 0; x < scalePatchX; ++x) {
-		m_dataVertices[iVertex].position = XMFLOAT3((float)(x * tessFactor), 0.0f, m_hBase);
-		m_dataVertices[iVertex++].skirt = 1;
+	TexelRect dirty;
+	if (!ApplyTerrainBrush(m_dataHeightMap, m_wHeightMap, m_hHeightMap, m_scaleHeightMap, brush, dirty)) return false;
+
+	// the surface reads the heightmap directly, so only the pyramid and the mesh need updating.
+	m_pRayCaster->UpdateRegion(dirty.x0, dirty.y0, dirty.x1, dirty.y1);
+	TerrainMeshRegion changed;
+	UpdateTerrainMeshRegion(m_dataHeightMap, m_wHeightMap, m_hHeightMap, m_scaleHeightMap, m_infoMesh, dirty.x0, dirty.y0, dirty.x1, dirty.y1,
+		m_dataVertices, changed);
+	UpdateBlockBounds(changed.x0, changed.y0, changed.x1 - 1, changed.y1 - 1);
+
+	m_rectEditedTexels.Merge(dirty);
+	if (m_regionEdited.x0 >= m_regionEdited.x1) {
+		m_regionEdited = changed;
+	} else {
+		m_regionEdited.x0 = changed.x0 < m_regionEdited.x0 ? changed.x0 : m_regionEdited.x0;
+		m_regionEdited.y0 = changed.y0 < m_regionEdited.y0 ? changed.y0 : m_regionEdited.y0;
+		m_regionEdited.x1 = changed.x1 > m_regionEdited.x1 ? changed.x1 : m_regionEdited.x1;
+		m_regionEdited.y1 = changed.y1 > m_regionEdited.y1 ? changed.y1 : m_regionEdited.y1;
+		m_regionEdited.isSkirtChanged = m_regionEdited.isSkirtChanged || changed.isSkirtChanged;
 	}
 
-	// create base vertices for side 2 of skirt. y = m_hHeightMap - tessFactor.
-	for (int x = 0; x < scalePatchX; ++x) {
-		m_dataVertices[iVertex].position = XMFLOAT3((float)(x * tessFactor), (float)(m_hHeightMap - tessFactor), m_hBase);
-		m_dataVertices[iVertex++].skirt = 2;
+	// the normals are filtered from the texels around each point and the displacement pushes the surface sideways,
+	// so the surface changes a little beyond the texels themselves.
+	float scaleY = (float)m_wHeightMap / (float)m_hHeightMap;
+	m_listEditedRegions.push_back(XMFLOAT4((float)dirty.x0 - 1.5f, (float)dirty.y0 * scaleY - 1.5f,
+		(float)dirty.x1 + 1.5f, (float)dirty.y1 * scaleY + 1.5f));
+
+	return true;
+}
+
+// Upload the texels and vertices changed by Edit() since the last call. Render thread only.
+// Returns the number of ranges of patches whose bounds changed, at most 2, with the first patch and number of patches of each.
+unsigned int Terrain::UploadEdits(unsigned long firstPatch[2], unsigned long numPatches[2]) {
+	if (m_rectEditedTexels.IsEmpty()) return 0;
+
+	// only the box of texels that changed is copied to the heightmap.
+	TexelRect& r = m_rectEditedTexels;
+	D3D12_BOX box = { r.x0, r.y0, 0, r.x1, r.y1, 1 };
+	m_pResMgr->UploadToTextureRegion(m_iHeightMap, 0, box, &m_dataHeightMap[((size_t)r.y0 * m_wHeightMap + r.x0) * 4], m_wHeightMap * 4, 4,
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+	// whole rows of control points, so the vertices go up in one piece, then the base vertices of the skirts if they changed.
+	std::vector<PackedVertex> packed;
+	unsigned long firstVertex = (unsigned long)m_regionEdited.y0 * m_infoMesh.numX;
+	unsigned long lastVertex = (unsigned long)m_regionEdited.y1 * m_infoMesh.numX;
+	for (unsigned long i = firstVertex; i < lastVertex; ++i) {
+		packed.push_back(PackVertex(m_dataVertices[i]));
 	}
+	m_pResMgr->UploadToBufferRegion(m_iVertexBuffer, firstVertex * sizeof(PackedVertex), packed.data(), packed.size() * sizeof(PackedVertex),
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+	int numPatchesX = m_infoMesh.numX - 1;
+	int numPatchesY = m_infoMesh.numY - 1;
+	unsigned int numRanges = 0;
+	firstPatch[numRanges] = (unsigned long)m_regionEdited.y0 * numPatchesX;
+	int lastPatchRow = m_regionEdited.y1 < numPatchesY ? m_regionEdited.y1 : numPatchesY;
+	numPatches[numRanges++] = (unsigned long)(lastPatchRow - m_regionEdited.y0) * numPatchesX;
+
+	if (m_regionEdited.isSkirtChanged) {
+		unsigned long firstBase = (unsigned long)m_infoMesh.numX * m_infoMesh.numY;
+		packed.clear();
+		for (unsigned long i = firstBase; i < m_numVertices; ++i) {
+			packed.push_back(PackVertex(m_dataVertices[i]));
+		}
+		m_pResMgr->UploadToBufferRegion(m_iVertexBuffer, firstBase * sizeof(PackedVertex), packed.data(), packed.size() * sizeof(PackedVertex),
+			D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
-	// create base vertices for side 3 of skirt. x = 0.
-	for (int y = 0; y < scalePatchY; ++y) {
-		m_dataVertices[iVertex].position = XMFLOAT3(0.0f, (float)(y * tessFactor), m_hBase);
-		m_dataVertices[iVertex++].skirt = 3;
+		// the skirt patches and the bottom plane follow the terrain patches.
+		firstPatch[numRanges] = (unsigned long)numPatchesX * numPatchesY;
+		numPatches[numRanges] = m_numIndices / 4 - firstPatch[numRanges];
+		++numRanges;
 	}
 
-	// create base vertices for side 4 of skirt. x = m_wHeightMap - tessFactor.
-	for (int y = 0; y < scalePatchY; ++y) {
-		m_dataVertices[iVertex].position = XMFLOAT3((float)(m_wHeightMap - tessFactor), (float)(y * tessFactor), m_hBase);
-		m_dataVertices[iVertex++].skirt = 4;
+	m_rectEditedTexels = {};
+	m_regionEdited = {};
+	return numRanges;
+}
+
+// Move the world space rectangles (min x, min y, max x, max y) changed by Edit() since the last call to list.
+// They include how far the displacement and normals reach. Hold GetEditLock() while calling.
+void Terrain::TakeEditedRegions(std::vector<XMFLOAT4>& list) {
+	list.insert(list.end(), m_listEditedRegions.begin(), m_listEditedRegions.end());
+	m_listEditedRegions.clear();
+}
+
+// Estimate how many triangles the tessellator produces for the patches inside the frustum, using the CPU version of the
+// hull shader's factors. numDistanceRamp receives the count for the old distance based factors.
+unsigned long long Terrain::EstimateTriangleCount(const XMFLOAT4 frustum[6], const TessFactorParams& params, unsigned long long& numDistanceRamp) {
+	unsigned long long num = 0;
+	numDistanceRamp = 0;
+
+	unsigned long numPatches = m_numIndices / 4;
+	for (unsigned long p = 0; p < numPatches; ++p) {
+		// the bounds of each patch are stored in its first control point.
+		Vertex& v = m_dataVertices[m_dataIndices[p * 4]];
+		if (!AABBIntersectsPlanes(v.aabbmin, v.aabbmax, frustum, 6)) continue;
+
+		XMFLOAT3 corners[4];
+		float errors[4];
+		for (int c = 0; c < 4; ++c) {
+			corners[c] = m_dataVertices[m_dataIndices[p * 4 + c]].position;
+			errors[c] = m_dataVertices[m_dataIndices[p * 4 + c]].error;
+		}
+
+		num += CalcTessTriangleCount(CalcPatchTessFactors(corners, errors, v.skirt, params));
+		numDistanceRamp += CalcTessTriangleCount(CalcPatchDistanceTessFactors(corners, v.skirt, params.eye));
 	}
 
-	// create an index buffer
-	// our grid is scalePatchX * scalePatchY in size.
-	// the vertices are oriented like so:
-	//  0,  1,  2,  3,  4,
-	//  5,  6,  7,  8,  9,
-	// 10, 11, 12, 13, 14
-	// need to add indices for 4 edge skirts (2 x-aligned, 2 y-aligned, 4 indices per patch).
-	// + 4 indices for patch representing bottom plane.
-	arrSize = (scalePatchX - 1) * (scalePatchY - 1) * 4 + 2 * 4 * (scalePatchX - 1) + 2 * 4 * (scalePatchY - 1) + 4;
-	m_dataIndices = new UINT[arrSize];
-	int i = 0;
-	for (int y = 0; y < scalePatchY - 1; ++y) {
-		for (int x = 0; x < scalePatchX - 1; ++x) {
-			UINT vert0 = x + y * scalePatchX;
-			UINT vert1 = x + 1 + y * scalePatchX;
-			UINT vert2 = x + (y + 1) * scalePatchX;
-			UINT vert3 = x + 1 + (y + 1) * scalePatchX;
-			m_dataIndices[i++] = vert0;
-			m_dataIndices[i++] = vert1;
-			m_dataIndices[i++] = vert2;
-			m_dataIndices[i++] = vert3;
-			
-			// now that we have the indices for our patch, we need to calculate the bounding box.
-			// z bounds is a bit harder as we need to find the max and min y values in the heightmap for the patch range.
-			// store it in the first vertex
-			// subtract one from coords of min and add one to coords of max to take into account
-			// the offsets caused by displacement, which should always be between -1 and 1.
-			XMFLOAT2 bz = CalcZBounds(m_dataVertices[vert0], m_dataVertices[vert3]);
-			m_dataVertices[vert0].aabbmin = XMFLOAT3(m_dataVertices[vert0].position.x - 0.5f, m_dataVertices[vert0].position.y - 0.5f, bz.x - 0.5f);
-			m_dataVertices[vert0].aabbmax = XMFLOAT3(m_dataVertices[vert3].position.x + 0.5f, m_dataVertices[vert3].position.y + 0.5f, bz.y + 0.5f);
+	return num;
+}
+
+// Cull every patch against each of the numFrustums 4 plane frustums using the same test as the hull shaders.
+// lists[i] receives the patches inside frustum i. visible receives the patches inside at least one frustum.
+void Terrain::CullPatches(const XMFLOAT4 (*frustums)[4], unsigned int numFrustums, std::vector<UINT>* lists, std::vector<UINT>& visible) {
+	visible.clear();
+	for (unsigned int f = 0; f < numFrustums; ++f) {
+		lists[f].clear();
+	}
+
+	unsigned long numPatches = m_numIndices / 4;
+	for (unsigned long p = 0; p < numPatches; ++p) {
+		// the bounds of each patch are stored in its first control point.
+		Vertex& v = m_dataVertices[m_dataIndices[p * 4]];
+
+		bool isVisible = false;
+		for (unsigned int f = 0; f < numFrustums; ++f) {
+			if (AABBIntersectsPlanes(v.aabbmin, v.aabbmax, frustums[f], 4)) {
+				lists[f].push_back((UINT)p);
+				isVisible = true;
+			}
+		}
+
+		if (isVisible) {
+			visible.push_back((UINT)p);
 		}
 	}
+}
 
-	// so as not to interfere with the terrain wrt bounds for frustum culling, we need the 0th control point of each skirt patch to be a base vertex as defined above.
-	// add indices for side 1 of skirt. y = 0.
-	iVertex = numVertsInTerrain;
-	for (int x = 0; x < scalePatchX - 1; ++x) {
-		m_dataIndices[i++] = iVertex;		// control point 0
-		m_dataIndices[i++] = iVertex + 1;	// control point 1
-		m_dataIndices[i++] = x;				// control point 2
-		m_dataIndices[i++] = x + 1;			// control point 3
-		XMFLOAT2 bz = CalcZBounds(m_dataVertices[x], m_dataVertices[x + 1]);
-		m_dataVertices[iVertex].aabbmin = XMFLOAT3((float)(x * tessFactor), 0.0f, m_hBase);
-		m_dataVertices[iVertex++].aabbmax = XMFLOAT3((float)((x + 1) * tessFactor), 0.0f, bz.y);
+// Write the control point indices of the listed patches to dst. Returns the number of indices written.
+unsigned int Terrain::WritePatchIndices(const std::vector<UINT>& patches, UINT* dst) {
+	for (size_t i = 0; i < patches.size(); ++i) {
+		memcpy(&dst[i * 4], &m_dataIndices[patches[i] * 4], 4 * sizeof(UINT));
 	}
-	// add indices for side 2 of skirt. y = m_hHeightMap - tessFactor.
-	++iVertex;
-	for (int x = 0; x < scalePatchX - 1; ++x) {
-		m_dataIndices[i++] = iVertex + 1;
-		m_dataIndices[i++] = iVertex;
-		int offset = scalePatchX * (scalePatchY - 1);
-		m_dataIndices[i++] = x + offset + 1;
-		m_dataIndices[i++] = x + offset;
-		XMFLOAT2 bz = CalcZBounds(m_dataVertices[x + offset], m_dataVertices[x + offset + 1]);
-		m_dataVertices[++iVertex].aabbmin = XMFLOAT3((float)(x * tessFactor), (float)(m_hHeightMap - tessFactor), m_hBase);
-		m_dataVertices[iVertex].aabbmax = XMFLOAT3((float)((x + 1) * tessFactor), (float)(m_hHeightMap - tessFactor), bz.y);
+
+	return (unsigned int)patches.size() * 4;
+}
+
+// Clean up array data.
+void Terrain::DeleteVertexAndIndexArrays() {
+	if (m_dataVertices) {
+		delete[] m_dataVertices;
+		m_dataVertices = nullptr;
 	}
-	// add indices for side 3 of skirt. x = 0.
-	++iVertex;
-	for (int y = 0; y < scalePatchY - 1; ++y) {
-		m_dataIndices[i++] = iVertex + 1;
-		m_dataIndices[i++] = iVertex;
-		m_dataIndices[i++] = (y + 1) * scalePatchX;
-		m_dataIndices[i++] = y * scalePatchX;
-		XMFLOAT2 bz = CalcZBounds(m_dataVertices[y * scalePatchX], m_dataVertices[(y + 1) * scalePatchX]);
-		m_dataVertices[++iVertex].aabbmin = XMFLOAT3(0.0f, (float)(y * tessFactor), m_hBase);
-		m_dataVertices[iVertex].aabbmax = XMFLOAT3(0.0f, (float)((y + 1) * tessFactor), bz.y);
+
+	if (m_dataIndices) {
+		delete[] m_dataIndices;
+		m_dataIndices = nullptr;
 	}
-	// add indices for side 4 of skirt. x = m_wHeightMap - tessFactor.
-	++iVertex;
-	for (int y = 0; y < scalePatchY - 1; ++y) {
-		m_dataIndices[i++] = iVertex;
-		m_dataIndices[i++] = iVertex + 1;
-		m_dataIndices[i++] = y * scalePatchX + scalePatchX - 1;
-		m_dataIndices[i++] = (y + 1) * scalePatchX + scalePatchX - 1;
-		XMFLOAT2 bz = CalcZBounds(m_dataVertices[y * scalePatchX + scalePatchX - 1], m_dataVertices[(y + 1) * scalePatchX + scalePatchX - 1]);
-		m_dataVertices[iVertex].aabbmin = XMFLOAT3((float)(m_wHeightMap - tessFactor), (float)(y * tessFactor), m_hBase);
-		m_dataVertices[iVertex++].aabbmax = XMFLOAT3((float)(m_wHeightMap - tessFactor), (float)((y + 1) * tessFactor), bz.y);
+
+	if (m_pConstants) {
+		delete m_pConstants;
+		m_pConstants = nullptr;
 	}
-	// add indices for bottom plane.
-	m_dataIndices[i++] = numVertsInTerrain + scalePatchX - 1;
-	m_dataIndices[i++] = numVertsInTerrain;
-	m_dataIndices[i++] = numVertsInTerrain + scalePatchX + scalePatchX - 1;
-	m_dataIndices[i++] = numVertsInTerrain + scalePatchX;
-	m_dataVertices[numVertsInTerrain + scalePatchX - 1].aabbmin = XMFLOAT3(0.0f, 0.0f, m_hBase);
-	m_dataVertices[numVertsInTerrain + scalePatchX - 1].aabbmax = XMFLOAT3((float)m_wHeightMap, (float)m_hHeightMap, m_hBase);
-	m_dataVertices[numVertsInTerrain + scalePatchX - 1].skirt = 0;
-	
-	m_numIndices = arrSize;
+}
+
+// generate vertex and index buffers for 3D mesh of terrain
+void Terrain::CreateMesh3D(Terrain* shared) {
+	m_scaleHeightMap = (float)m_wHeightMap / 16.0f;
+
+	// the vertices, indices, and patch bounds are built on worker threads. See TerrainMesh.h.
+	TerrainMeshInfo& info = m_infoMesh;
+	info = CalcTerrainMeshInfo(m_wHeightMap, m_hHeightMap);
+	int scalePatchX = info.numX;
+	int scalePatchY = info.numY;
+	m_numVertices = info.numVertices;
+	m_numIndices = info.numIndices;
+	m_dataVertices = new Vertex[m_numVertices];
+	m_dataIndices = new UINT[m_numIndices];
+
+	auto tStart = std::chrono::high_resolution_clock::now();
+	BuildTerrainMesh(m_dataHeightMap, m_wHeightMap, m_hHeightMap, m_scaleHeightMap, 0, info, m_dataVertices, m_dataIndices);
+	double msBuild = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	char stats[256];
+	sprintf_s(stats, "Terrain: built a %d x %d mesh on %u threads in %.2f ms.\n", scalePatchX, scalePatchY,
+		std::thread::hardware_concurrency(), msBuild);
+	OutputDebugStringA(stats);
+
+	XMFLOAT2 zBounds = info.zBounds;
+	m_hBase = info.hBase;
+
+	// the procedural vertex shader and PatchGrid.h have to enumerate exactly the same patches as the index buffer.
+	// The TerrainMesh tests check every index. Only the count is checked here.
+	if (CalcNumGridPatches(scalePatchX, scalePatchY) * 4 != m_numIndices) {
+		throw GFX_Exception("Terrain::CreateMesh3D: patch grid doesn't match the index buffer size.");
+	}
+
+	// every patch's z bounds lie between the bottom of the skirt and the top of the terrain plus displacement.
+	// Edit() can move the terrain anywhere the heightmap can hold, so leave room for all of it.
+	m_zBoundsMin = fminf(m_hBase, -0.5f);
+	m_zBoundsRange = m_scaleHeightMap + 0.5f - m_zBoundsMin;
 
 	CreateVertexBuffer();
-	CreateIndexBuffer();
+	if (shared) {
+		// tiles the same size have exactly the same patches.
+		m_viewChunkIndexBuffer = shared->m_viewChunkIndexBuffer;
+		m_viewIndexBuffer = shared->m_viewIndexBuffer;
+		m_listChunks = shared->m_listChunks;
+		m_numSkirtIndices = shared->m_numSkirtIndices;
+	} else {
+		CreateIndexBuffers(scalePatchX, scalePatchY);
+	}
 	CreateConstantBuffer();
+	CreateBlockBounds(scalePatchX - 1, scalePatchY - 1);
 
 	// Create a bounding sphere for the height map.
 	float w = (float)m_wHeightMap / 2.0f;
 	float h = (float)m_hHeightMap / 2.0f;
 	m_BoundingSphere.SetCenter(w, h, (zBounds.y + zBounds.x) / 2.0f);
 	m_BoundingSphere.SetRadius(sqrtf(w * w + h * h));
+
+	// Create a bounding box for the height map. The skirts hang down to the base and the displacement map adds up to half a unit.
+	m_BoundingBox.SetMin(XMFLOAT3(0.0f, 0.0f, m_hBase));
+	m_BoundingBox.SetMax(XMFLOAT3((float)m_wHeightMap, (float)m_hHeightMap, zBounds.y + 0.5f));
+}
+
+// Merge the bounds of the numPatchesX x numPatchesY terrain patches into blocks of TERRAIN_BLOCK_PATCHES x TERRAIN_BLOCK_PATCHES.
+void Terrain::CreateBlockBounds(int numPatchesX, int numPatchesY) {
+	int numBlocksX = (numPatchesX + TERRAIN_BLOCK_PATCHES - 1) / TERRAIN_BLOCK_PATCHES;
+	int numBlocksY = (numPatchesY + TERRAIN_BLOCK_PATCHES - 1) / TERRAIN_BLOCK_PATCHES;
+
+	m_listBlockBounds.clear();
+	m_listBlockBounds.reserve(numBlocksX * numBlocksY);
+	for (int by = 0; by < numBlocksY; ++by) {
+		for (int bx = 0; bx < numBlocksX; ++bx) {
+			m_listBlockBounds.push_back(CalcBlockBounds(bx, by, numPatchesX, numPatchesY));
+		}
+	}
+}
+
+// Recalculate the blocks holding patches [x0, x1) x [y0, y1) and grow the bounding box to take them in.
+// The blocks are updated in place, so pointers from GetBlockBounds() stay valid.
+void Terrain::UpdateBlockBounds(int x0, int y0, int x1, int y1) {
+	int numPatchesX = m_infoMesh.numX - 1;
+	int numPatchesY = m_infoMesh.numY - 1;
+	int numBlocksX = (numPatchesX + TERRAIN_BLOCK_PATCHES - 1) / TERRAIN_BLOCK_PATCHES;
+	x1 = x1 < numPatchesX ? x1 : numPatchesX;
+	y1 = y1 < numPatchesY ? y1 : numPatchesY;
+
+	XMFLOAT3 bbmin = m_BoundingBox.GetMin();
+	XMFLOAT3 bbmax = m_BoundingBox.GetMax();
+	for (int by = y0 / TERRAIN_BLOCK_PATCHES; by * TERRAIN_BLOCK_PATCHES < y1; ++by) {
+		for (int bx = x0 / TERRAIN_BLOCK_PATCHES; bx * TERRAIN_BLOCK_PATCHES < x1; ++bx) {
+			AxisAlignedBoundingBox& block = m_listBlockBounds[by * numBlocksX + bx];
+			block = CalcBlockBounds(bx, by, numPatchesX, numPatchesY);
+			bbmin.z = fminf(bbmin.z, block.GetMin().z);
+			bbmax.z = fmaxf(bbmax.z, block.GetMax().z);
+		}
+	}
+	m_BoundingBox.SetMin(bbmin);
+	m_BoundingBox.SetMax(bbmax);
+}
+
+// Returns the box bounding block (bx, by) of the numPatchesX x numPatchesY terrain patches.
+AxisAlignedBoundingBox Terrain::CalcBlockBounds(int bx, int by, int numPatchesX, int numPatchesY) {
+	XMFLOAT3 bmin(FLT_MAX, FLT_MAX, FLT_MAX);
+	XMFLOAT3 bmax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int y = by * TERRAIN_BLOCK_PATCHES; y < (by + 1) * TERRAIN_BLOCK_PATCHES && y < numPatchesY; ++y) {
+		for (int x = bx * TERRAIN_BLOCK_PATCHES; x < (bx + 1) * TERRAIN_BLOCK_PATCHES && x < numPatchesX; ++x) {
+			// the bounds of each patch are stored in its first control point.
+			Vertex& v = m_dataVertices[m_dataIndices[(y * numPatchesX + x) * 4]];
+			bmin = XMFLOAT3(fminf(bmin.x, v.aabbmin.x), fminf(bmin.y, v.aabbmin.y), fminf(bmin.z, v.aabbmin.z));
+			bmax = XMFLOAT3(fmaxf(bmax.x, v.aabbmax.x), fmaxf(bmax.y, v.aabbmax.y), fmaxf(bmax.z, v.aabbmax.z));
+		}
+	}
+
+	return AxisAlignedBoundingBox(bmin, bmax);
 }
 
-// Create the vertex buffer view
+// Pack the vertices and upload them to the structured buffer the vertex shaders read.
 void Terrain::CreateVertexBuffer() {
-	// Create the vertex buffer
-	ID3D12Resource* buffer;
-	auto iBuffer = m_pResMgr->NewBuffer(buffer, &CD3DX12_RESOURCE_DESC::Buffer(m_numVertices * sizeof(Vertex)),
+	std::vector<PackedVertex> packed(m_numVertices);
+	for (unsigned long i = 0; i < m_numVertices; ++i) {
+		packed[i] = PackVertex(m_dataVertices[i]);
+	}
+
+	// Create the vertex buffer. The vertex, hull, and domain shaders all run before any pixel shader.
+	m_iVertexBuffer = m_pResMgr->NewBuffer(m_pVertexBuffer, &CD3DX12_RESOURCE_DESC::Buffer(m_numVertices * sizeof(PackedVertex)),
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
-		D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, nullptr);
-	buffer->SetName(L"Terrain Vertex Buffer");
-	auto sizeofVertexBuffer = GetRequiredIntermediateSize(buffer, 0, 1);
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, nullptr);
+	m_pVertexBuffer->SetName(L"Terrain Vertex Buffer");
+	auto sizeofVertexBuffer = GetRequiredIntermediateSize(m_pVertexBuffer, 0, 1);
 
 	// prepare vertex data for upload.
 	D3D12_SUBRESOURCE_DATA dataVB = {};
-	dataVB.pData = m_dataVertices;
+	dataVB.pData = packed.data();
 	dataVB.RowPitch = sizeofVertexBuffer;
 	dataVB.SlicePitch = sizeofVertexBuffer;
 
-	m_pResMgr->UploadToBuffer(iBuffer, 1, &dataVB, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
+	m_pResMgr->UploadToBuffer(m_iVertexBuffer, 1, &dataVB, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
 
-	// create and save vertex buffer view to Terrain object.
-	m_viewVertexBuffer = {};
-	m_viewVertexBuffer.BufferLocation = buffer->GetGPUVirtualAddress();
-	m_viewVertexBuffer.StrideInBytes = sizeof(Vertex);
-	m_viewVertexBuffer.SizeInBytes = (UINT)sizeofVertexBuffer;
+	// The vertex buffer is read through an SRV in the terrain's descriptor table. See CreateResourceViews().
 }
 
-// Create the index buffer view
-void Terrain::CreateIndexBuffer() {
-	// Create the index buffer
+// Pack the vertices and upload them over the structured buffer's contents.
+void Terrain::UploadVertices() {
+	std::vector<PackedVertex> packed(m_numVertices);
+	for (unsigned long i = 0; i < m_numVertices; ++i) {
+		packed[i] = PackVertex(m_dataVertices[i]);
+	}
+
+	m_pResMgr->UploadToBufferRegion(m_iVertexBuffer, 0, packed.data(), packed.size() * sizeof(PackedVertex),
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+}
+
+// Returns the compact form of a vertex the vertex shaders read.
+PackedVertex Terrain::PackVertex(const Vertex& v) {
+	// only the first control point of each patch has bounds. The rest are never read.
+	PackedVertex packed;
+	packed.bounds = PackZBounds(v.aabbmin, v.aabbmax);
+	packed.data = (UINT)PackedVector::XMConvertFloatToHalf(v.error) | (v.skirt << 16);
+	return packed;
+}
+
+// Quantize a patch's z bounds to 16 bits each, rounding outwards so the result still holds the patch.
+UINT Terrain::PackZBounds(XMFLOAT3 aabbmin, XMFLOAT3 aabbmax) {
+	float zmin = (aabbmin.z - m_zBoundsMin) / m_zBoundsRange * 65535.0f;
+	float zmax = (aabbmax.z - m_zBoundsMin) / m_zBoundsRange * 65535.0f;
+	zmin = zmin < 0.0f ? 0.0f : zmin > 65535.0f ? 65535.0f : floorf(zmin);
+	zmax = zmax < 0.0f ? 0.0f : zmax > 65535.0f ? 65535.0f : ceilf(zmax);
+
+	return (UINT)zmin | ((UINT)zmax << 16);
+}
+
+// Split the terrain patches of the numX x numY grid into chunks with 16 bit indices and create their index buffer,
+// along with a 32 bit index buffer for the skirts and bottom plane.
+void Terrain::CreateIndexBuffers(int numX, int numY) {
+	std::vector<unsigned short> indices;
+	m_listChunks.clear();
+	if (!BuildPatchChunks(numX, numY, PATCH_CHUNK_SIZE, m_listChunks, indices)) {
+		std::string msg = "Terrain::CreateIndexBuffers: a grid " + std::to_string(numX) + " vertices wide is too wide for 16 bit indices.";
+		throw GFX_Exception(msg.c_str());
+	}
+
+	// Create the chunk index buffer
 	ID3D12Resource* buffer;
-	auto iBuffer = m_pResMgr->NewBuffer(buffer, &CD3DX12_RESOURCE_DESC::Buffer(m_numIndices * sizeof(UINT)),
+	auto iBuffer = m_pResMgr->NewBuffer(buffer, &CD3DX12_RESOURCE_DESC::Buffer(indices.size() * sizeof(unsigned short)),
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
 		D3D12_RESOURCE_STATE_INDEX_BUFFER, nullptr);
-	buffer->SetName(L"Terrain Index Buffer");
+	buffer->SetName(L"Terrain Chunk Index Buffer");
 	auto sizeofIndexBuffer = GetRequiredIntermediateSize(buffer, 0, 1);
 
 	// prepare index data for upload.
 	D3D12_SUBRESOURCE_DATA dataIB = {};
-	dataIB.pData = m_dataIndices;
+	dataIB.pData = indices.data();
 	dataIB.RowPitch = sizeofIndexBuffer;
 	dataIB.SlicePitch = sizeofIndexBuffer;
 
 	m_pResMgr->UploadToBuffer(iBuffer, 1, &dataIB, D3D12_RESOURCE_STATE_INDEX_BUFFER);
 
 	// create and save index buffer view to Terrain object.
+	m_viewChunkIndexBuffer = {};
+	m_viewChunkIndexBuffer.BufferLocation = buffer->GetGPUVirtualAddress();
+	m_viewChunkIndexBuffer.Format = DXGI_FORMAT_R16_UINT;
+	m_viewChunkIndexBuffer.SizeInBytes = (UINT)sizeofIndexBuffer;
+
+	// the skirts and bottom plane follow the terrain patches in the index array.
+	unsigned long firstSkirtIndex = (numX - 1) * (numY - 1) * 4;
+	m_numSkirtIndices = m_numIndices - firstSkirtIndex;
+
+	// Create the skirt index buffer
+	iBuffer = m_pResMgr->NewBuffer(buffer, &CD3DX12_RESOURCE_DESC::Buffer(m_numSkirtIndices * sizeof(UINT)),
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+		D3D12_RESOURCE_STATE_INDEX_BUFFER, nullptr);
+	buffer->SetName(L"Terrain Skirt Index Buffer");
+	sizeofIndexBuffer = GetRequiredIntermediateSize(buffer, 0, 1);
+
+	dataIB.pData = &m_dataIndices[firstSkirtIndex];
+	dataIB.RowPitch = sizeofIndexBuffer;
+	dataIB.SlicePitch = sizeofIndexBuffer;
+
+	m_pResMgr->UploadToBuffer(iBuffer, 1, &dataIB, D3D12_RESOURCE_STATE_INDEX_BUFFER);
+
 	m_viewIndexBuffer = {};
 	m_viewIndexBuffer.BufferLocation = buffer->GetGPUVirtualAddress();
 	m_viewIndexBuffer.Format = DXGI_FORMAT_R32_UINT;
@@ -272,15 +593,15 @@ void Terrain::CreateIndexBuffer() {
 // Create the constant buffer for terrain shader constants
 void Terrain::CreateConstantBuffer() {
 	// Create the constant buffer
-	ID3D12Resource* buffer;
-	auto iBuffer = m_pResMgr->NewBuffer(buffer, &CD3DX12_RESOURCE_DESC::Buffer(sizeof(TerrainShaderConstants)),
+	auto iBuffer = m_pResMgr->NewBuffer(m_pConstantBuffer, &CD3DX12_RESOURCE_DESC::Buffer(sizeof(TerrainShaderConstants)),
 		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
 		D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, nullptr);
-	buffer->SetName(L"Terrain Shader Constants Buffer");
-	auto sizeofBuffer = GetRequiredIntermediateSize(buffer, 0, 1);
+	m_pConstantBuffer->SetName(L"Terrain Shader Constants Buffer");
+	auto sizeofBuffer = GetRequiredIntermediateSize(m_pConstantBuffer, 0, 1);
 
 	// prepare constant buffer data for upload.
-	m_pConstants = new TerrainShaderConstants(m_scaleHeightMap, (float)m_wHeightMap, (float)m_hHeightMap, m_hBase);
+	m_pConstants = new TerrainShaderConstants(m_scaleHeightMap, (float)m_wHeightMap, (float)m_hHeightMap, m_hBase,
+		(float)TERRAIN_GRID_SPACING, m_zBoundsMin, m_zBoundsRange, m_vOrigin, m_skirts);
 	D3D12_SUBRESOURCE_DATA dataCB = {};
 	dataCB.pData = m_pConstants;
 	dataCB.RowPitch = sizeofBuffer;
@@ -288,41 +609,11 @@ void Terrain::CreateConstantBuffer() {
 
 	m_pResMgr->UploadToBuffer(iBuffer, 1, &dataCB, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER);
 
-	// Create a constant buffer view.
-	D3D12_CONSTANT_BUFFER_VIEW_DESC descCBV = {};
-	descCBV.BufferLocation = buffer->GetGPUVirtualAddress();
-	descCBV.SizeInBytes = (sizeof(TerrainShaderConstants) + 255) & ~255; // CB size is required to be 256-byte aligned.
-
-	m_pResMgr->AddCBV(&descCBV, m_hdlConstantsCBV_CPU, m_hdlConstantsCBV_GPU);
-}
-
-// calculate the minimum and maximum z values for vertices between the provided bounds.
-XMFLOAT2 Terrain::CalcZBounds(Vertex bottomLeft, Vertex topRight) {
-	float max = -100000;
-	float min = 100000;
-	int bottomLeftX = bottomLeft.position.x == 0 ? (int)bottomLeft.position.x: (int)bottomLeft.position.x - 1;
-	int bottomLeftY = bottomLeft.position.y == 0 ? (int)bottomLeft.position.y : (int)bottomLeft.position.y - 1;
-	int topRightX = topRight.position.x >= m_wHeightMap ? (int)topRight.position.x : (int)topRight.position.x + 1;
-	int topRightY = topRight.position.y >= m_wHeightMap ? (int)topRight.position.y : (int)topRight.position.y + 1;
-
-	for (int y = bottomLeftY; y <= topRightY; ++y) {
-		for (int x = bottomLeftX; x <= topRightX; ++x) {
-			float z = ((float)m_dataHeightMap[(x + y * m_wHeightMap) * 4] / 255.0f) * m_scaleHeightMap;
-
-			if (z > max) max = z;
-			if (z < min) min = z;
-		}
-	}
-
-	return XMFLOAT2(min, max);
+	// The constant buffer is bound as a root CBV, so it doesn't need a view.
 }
 
-// load the specified file containing the heightmap data.
-void Terrain::LoadHeightMap(const char* fnHeightMap) {
-	unsigned int index;
-	index = m_pResMgr->LoadFile(fnHeightMap, m_hHeightMap, m_wHeightMap);
-	m_dataHeightMap = m_pResMgr->GetFileData(index);
-
+// Create the heightmap texture and upload m_dataHeightMap to it.
+void Terrain::CreateHeightMap() {
 	// Create the texture buffers.
 	D3D12_RESOURCE_DESC	descTex = {};
 	descTex.MipLevels = 1;
@@ -335,10 +626,9 @@ void Terrain::LoadHeightMap(const char* fnHeightMap) {
 	descTex.SampleDesc.Quality = 0;
 	descTex.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 	
-	ID3D12Resource* hm;
-	unsigned int iBuffer = m_pResMgr->NewBuffer(hm, &descTex, &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+	m_iHeightMap = m_pResMgr->NewBuffer(m_pHeightMap, &descTex, &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr);
-	hm->SetName(L"Height Map");
+	m_pHeightMap->SetName(L"Height Map");
 
 	// prepare height map data for upload.
 	D3D12_SUBRESOURCE_DATA dataTex = {};
@@ -346,16 +636,7 @@ void Terrain::LoadHeightMap(const char* fnHeightMap) {
 	dataTex.RowPitch = m_wHeightMap * 4 * sizeof(unsigned char);
 	dataTex.SlicePitch = m_hHeightMap * m_wHeightMap * 4 * sizeof(unsigned char);	
 	
-	m_pResMgr->UploadToBuffer(iBuffer, 1, &dataTex, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-
-	// Create the SRV for the detail map texture and save to Terrain object.
-	D3D12_SHADER_RESOURCE_VIEW_DESC	descSRV = {};
-	descSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	descSRV.Format = descTex.Format;
-	descSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-	descSRV.Texture2D.MipLevels = 1;
-
-	m_pResMgr->AddSRV(hm, &descSRV, m_hdlHeightMapSRV_CPU, m_hdlHeightMapSRV_GPU);
+	m_pResMgr->UploadToBuffer(m_iHeightMap, 1, &dataTex, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void Terrain::LoadDisplacementMap(const char* fnMap) {
@@ -375,10 +656,9 @@ void Terrain::LoadDisplacementMap(const char* fnMap) {
 	descTex.SampleDesc.Quality = 0;
 	descTex.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
-	ID3D12Resource* dm;
-	unsigned int iBuffer = m_pResMgr->NewBuffer(dm, &descTex, &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+	unsigned int iBuffer = m_pResMgr->NewBuffer(m_pDisplacementMap, &descTex, &CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
 		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, nullptr);
-	dm->SetName(L"Displacement Map");
+	m_pDisplacementMap->SetName(L"Displacement Map");
 
 	D3D12_SUBRESOURCE_DATA dataTex = {};
 	// prepare height map data for upload.
@@ -387,111 +667,69 @@ void Terrain::LoadDisplacementMap(const char* fnMap) {
 	dataTex.SlicePitch = m_hDisplacementMap * m_wDisplacementMap * 4 * sizeof(unsigned char);
 
 	m_pResMgr->UploadToBuffer(iBuffer, 1, &dataTex, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
 
-	// Create the SRV for the detail map texture and save to Terrain object.
+// Attach the resources needed for rendering terrain.
+// Requires the index of the root CBV to attach the terrain constant buffer to.
+void Terrain::AttachTerrainResources(ID3D12GraphicsCommandList* cmdList, unsigned int cbvRootIndex) {
+	cmdList->SetGraphicsRootConstantBufferView(cbvRootIndex, m_pConstantBuffer->GetGPUVirtualAddress());
+}
+
+// Write the heightmap, displacement map, and material SRVs into the descriptor table starting at slot iTable.
+void Terrain::CreateResourceViews(unsigned int iTable) {
+	// the height map and displacement map share a format, so they can share a view description.
 	D3D12_SHADER_RESOURCE_VIEW_DESC	descSRV = {};
 	descSRV.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	descSRV.Format = descTex.Format;
+	descSRV.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
 	descSRV.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
 	descSRV.Texture2D.MipLevels = 1;
 
-	m_pResMgr->AddSRV(dm, &descSRV, m_hdlDisplacementMapSRV_CPU, m_hdlDisplacementMapSRV_GPU);
+	m_pResMgr->AddSRVAt(iTable + SRV_SLOT_HEIGHTMAP, m_pHeightMap, &descSRV);
+	m_pResMgr->AddSRVAt(iTable + SRV_SLOT_DISPLACEMENTMAP, m_pDisplacementMap, &descSRV);
+	m_pMat->CreateResourceView(iTable + SRV_SLOT_MATERIAL);
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC	descVertices = {};
+	descVertices.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	descVertices.Format = DXGI_FORMAT_UNKNOWN;
+	descVertices.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+	descVertices.Buffer.FirstElement = 0;
+	descVertices.Buffer.NumElements = m_numVertices;
+	descVertices.Buffer.StructureByteStride = sizeof(PackedVertex);
+	descVertices.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+	m_pResMgr->AddSRVAt(iTable + SRV_SLOT_CONTROLPOINTS, m_pVertexBuffer, &descVertices);
 }
 
-// Attach the resources needed for rendering terrain.
-// Requires the indices into the root descriptor table to attach the heightmap and displacement map SRVs and constant buffer CBV to.
-void Terrain::AttachTerrainResources(ID3D12GraphicsCommandList* cmdList, unsigned int srvDescTableIndexHeightMap,
-	unsigned int srvDescTableIndexDisplacementMap, unsigned int cbvDescTableIndex) {
-	cmdList->SetGraphicsRootDescriptorTable(srvDescTableIndexHeightMap, m_hdlHeightMapSRV_GPU);
-	cmdList->SetGraphicsRootDescriptorTable(srvDescTableIndexDisplacementMap, m_hdlDisplacementMapSRV_GPU);
-	cmdList->SetGraphicsRootDescriptorTable(cbvDescTableIndex, m_hdlConstantsCBV_GPU);
-}
-
-// Attach the material resources. Requires root descriptor table index.
-void Terrain::AttachMaterialResources(ID3D12GraphicsCommandList* cmdList, unsigned int srvDescTableIndex) {
-	m_pMat->Attach(cmdList, srvDescTableIndex);
-}
-
-float Terrain::GetHeightMapValueAtPoint(float x, float y) {
-	// use bilinear interpolation to calculate the height of the base terrain at point (x, y).
-	float x1 = floorf(x);
-	x1 = x1 < 0.0f ? 0.0f : x1 > m_wHeightMap ? m_wHeightMap : x1;
-	float x2 = ceilf(x);
-	x2 = x2 < 0.0f ? 0.0f : x2 > m_wHeightMap ? m_wHeightMap : x2;
-	float dx = x - x1;
-	float y1 = floorf(y);
-	y1 = y1 < 0.0f ? 0.0f : y1 > m_hHeightMap ? m_hHeightMap : y1;
-	float y2 = ceilf(y);
-	y2 = y2 < 0.0f ? 0.0f : y2 > m_hHeightMap ? m_hHeightMap : y2;
-	float dy = y - y1;
-	
-	float a = (float)m_dataHeightMap[(int)(y1 * m_wHeightMap + x1) * 4] / 255.0f;
-	float b = (float)m_dataHeightMap[(int)(y1 * m_wHeightMap + x2) * 4] / 255.0f;
-	float c = (float)m_dataHeightMap[(int)(y2 * m_wHeightMap + x1) * 4] / 255.0f;
-	float d = (float)m_dataHeightMap[(int)(y2 * m_wHeightMap + x2) * 4] / 255.0f;
-
-	return bilerp(a, b, c, d, dx, dy);
-}
-
-float Terrain::GetDisplacementMapValueAtPoint(float x, float y) {
-	float _x = x / m_wDisplacementMap / 32;
-	float _y = y / m_hDisplacementMap / 32;
-	// use bilinear interpolation to calculate the height of the base terrain at point (x, y).
-	float x1 = floorf(_x);
-	float x2 = ceilf(_x);
-	float dx = _x - x1;
-	float y1 = floorf(_y);
-	float y2 = ceilf(_y);
-	float dy = _y - y1;
-
-	float a = (float)m_dataDisplacementMap[(int)(y1 * m_wDisplacementMap + x1) * 4 + 3] / 255.0f;
-	float b = (float)m_dataDisplacementMap[(int)(y1 * m_wDisplacementMap + x2) * 4 + 3] / 255.0f;
-	float c = (float)m_dataDisplacementMap[(int)(y2 * m_wDisplacementMap + x1) * 4 + 3] / 255.0f;
-	float d = (float)m_dataDisplacementMap[(int)(y2 * m_wDisplacementMap + x2) * 4 + 3] / 255.0f;
-
-	return bilerp(a, b, c, d, dx, dy);
-}
-
-XMFLOAT3 Terrain::CalculateNormalAtPoint(float x, float y) {
-	XMFLOAT2 b(x, y - 0.3f / m_hHeightMap);
-	XMFLOAT2 c(x + 0.3f / m_wHeightMap, y - 0.3f / m_hHeightMap);
-	XMFLOAT2 d(x + 0.3f / m_wHeightMap, y);
-	XMFLOAT2 e(x + 0.3f / m_wHeightMap, y + 0.3f / m_hHeightMap);
-	XMFLOAT2 f(x, y +  0.3f / m_hHeightMap);
-	XMFLOAT2 g(x - 0.3f / m_wHeightMap, y + 0.3f / m_hHeightMap);
-	XMFLOAT2 h(x - 0.3f / m_wHeightMap, y);
-	XMFLOAT2 i(x - 0.3f / m_wHeightMap, y - 0.3f / m_hHeightMap);
-
-	float zb = GetHeightMapValueAtPoint(b.x, b.y) * m_scaleHeightMap;
-	float zc = GetHeightMapValueAtPoint(c.x, c.y) * m_scaleHeightMap;
-	float zd = GetHeightMapValueAtPoint(d.x, d.y) * m_scaleHeightMap;
-	float ze = GetHeightMapValueAtPoint(e.x, e.y) * m_scaleHeightMap;
-	float zf = GetHeightMapValueAtPoint(f.x, f.y) * m_scaleHeightMap;
-	float zg = GetHeightMapValueAtPoint(g.x, g.y) * m_scaleHeightMap;
-	float zh = GetHeightMapValueAtPoint(h.x, h.y) * m_scaleHeightMap;
-	float zi = GetHeightMapValueAtPoint(i.x, i.y) * m_scaleHeightMap;
-
-	float u = zg + 2 * zh + zi - zc - 2 * zd - ze;
-	float v = 2 * zb + zc + zi - ze - 2 * zf - zg;
-	float w = 8.0f;
-
-	XMFLOAT3 norm(u, v, w);
-	XMVECTOR normalized = XMVector3Normalize(XMLoadFloat3(&norm));
-	XMStoreFloat3(&norm, normalized);
-
-	return norm;
+// Print the size of the vertex and index data on the GPU, and how many bytes the input assembler reads per patch,
+// next to what the full Vertex layout would need.
+void Terrain::ReportBufferSizes() {
+	unsigned long long sizeVertices = (unsigned long long)m_numVertices * sizeof(PackedVertex);
+	unsigned long long sizeVerticesFull = (unsigned long long)m_numVertices * sizeof(Vertex);
+	unsigned long long sizeIndices = (unsigned long long)(m_numIndices - m_numSkirtIndices) * sizeof(unsigned short) +
+		(unsigned long long)m_numSkirtIndices * sizeof(UINT);
+	unsigned long long sizeIndicesFull = (unsigned long long)m_numIndices * sizeof(UINT);
+	// without a vertex buffer the input assembler only reads the 4 (16 bit) indices of each patch.
+	// The vertex shader fetches a PackedVertex and a heightmap texel per control point instead.
+	unsigned int iaPerPatch = 4 * sizeof(unsigned short);
+	unsigned int iaPerPatchFull = 4 * (sizeof(UINT) + sizeof(Vertex));
+	unsigned int vsPerPatch = 4 * (sizeof(PackedVertex) + 4);
+
+	char msg[512];
+	sprintf_s(msg, "Terrain: %lu vertices, %lu patches in %u chunks. vertex data %.2f KB (%.2f KB as %u byte vertices), "
+		"index data %.2f KB (%.2f KB as 32 bit). input assembler reads %u bytes per terrain patch (%u with a vertex buffer), "
+		"vertex shader fetches %u.\n",
+		m_numVertices, m_numIndices / 4, (unsigned int)m_listChunks.size(), (double)sizeVertices / 1024.0, (double)sizeVerticesFull / 1024.0,
+		(unsigned int)sizeof(Vertex), (double)sizeIndices / 1024.0, (double)sizeIndicesFull / 1024.0, iaPerPatch, iaPerPatchFull, vsPerPatch);
+	OutputDebugStringA(msg);
+}
+
+// Give the control points shared with next, the following tile along x if isAlongX, otherwise along y, the larger error
+// of the two tiles'. Returns the number of control points changed. Call UploadVertices() on both afterwards.
+unsigned int Terrain::MatchEdgeErrors(Terrain* next, bool isAlongX) {
+	return MatchTileEdgeErrors(m_dataVertices, next->m_dataVertices, m_infoMesh, isAlongX);
 }
 
+// Returns the height of the displaced terrain at (x, y), as the domain shader draws it. See TerrainSurface.h.
 float Terrain::GetHeightAtPoint(float x, float y) {
-	float z = GetHeightMapValueAtPoint(x, y) * m_scaleHeightMap;
-	float d = 2.0f * GetDisplacementMapValueAtPoint(x, y) - 1.0f;
-	XMFLOAT3 norm = CalculateNormalAtPoint(x, y);
-	XMFLOAT3 pos(x, y, z);
-	XMVECTOR normal = XMLoadFloat3(&norm);
-	XMVECTOR position = XMLoadFloat3(&pos);
-	XMVECTOR posFinal = position + normal * 0.5f * d;
-	XMFLOAT3 fp;
-	XMStoreFloat3(&fp, posFinal);
-
-	return fp.z;
+	return m_pSurface->GetDisplacedHeight(x, y);
 }
\ No newline at end of file
@@ -9,14 +9,45 @@ Description:	Class for loading height map and displacement map data
 				to a TerrainMaterial object containing diffuse and
 				normal maps to texture the terrain with.
 
-Usage:			- Proper shutdown is handled by the destructor.
+Usage:			- Proper shutdown is handled by the destructor. The TerrainMaterial isn't owned by the Terrain,
+				as the tiles of a TerrainWorld share one.
 				- Is hard-coded for Direct3D 12.
-				- Call AttachTerrainResources() to load the appropriate 
-					buffer/resource views to render the terrain.
-				- Call AttachMaterialResources() to load the material
-					SRVs in order to texture the terrain.
+				- Call CreateResourceViews() to write the heightmap, displacement
+					map, and material SRVs into a descriptor table laid out as per
+					TerrainSRVSlot.
+				- Call AttachTerrainResources() to load the terrain constant buffer
+					needed to render the terrain.
 				- Call Draw() and pass a Command List to load the set of
 				commands necessary to render the terrain.
+				- Call CullPatches() to find the patches inside a set of frustums,
+				WritePatchIndices() to turn them into an index list, and
+				DrawPatches() to draw from that index list instead of the full mesh.
+				- Every vertex carries the height error of the patches around it, which the hull shader
+				turns into tessellation factors. EstimateTriangleCount() runs the same calculation on the CPU.
+				- Call GetPatchCullData() to get the bounds and control points of every
+				patch for culling on the GPU, and DrawPatchesIndirect() to draw the result.
+				- The GPU copy of the vertices is a structured buffer of PackedVertex, bound at SRV_SLOT_CONTROLPOINTS.
+				There is no vertex buffer. The vertex shaders rebuild each control point's position from
+				SV_VertexID and the heightmap. ReportBufferSizes() compares it to the old vertex buffer.
+				- Call DrawProcedural() to draw the whole terrain without the index buffer either. The patches
+				are enumerated as per PatchGrid.h, which the TerrainMesh tests check against the index buffer.
+				- Draw() draws the terrain patches in chunks with 16 bit indices, as per PatchChunks.h.
+				The index lists used for culling keep 32 bit indices into the whole grid. SV_VertexID doesn't include
+				the base vertex of an indexed draw, so each chunk's base vertex goes to the vertex shaders as the
+				root constant at TERRAIN_BASE_VERTEX_CONSTANT. Every other draw leaves it at 0.
+				- Call Edit() to apply a brush stroke to the heightmap, as per TerrainEdit.h. The mesh, the ray
+				casting pyramid, and the block bounds are updated on the CPU right away, only around the stroke.
+				Call UploadEdits() before drawing to copy just the changed texels and vertices to the GPU. It
+				returns the patches whose bounds changed, for updating the PatchCuller.
+				- Edit() and UploadEdits() must be called from the render thread. Other threads reading the
+				heightmap, ie through GetHeightAtPoint(), GetSurface(), or CastRay(), must hold GetEditLock().
+				TakeEditedRegions() tells them which parts of the terrain changed.
+				- A Terrain can also be a tile of a TerrainWorld, placed at an origin in the world. The shaders add the
+				origin to every position. GetHeightAtPoint() and GetSurface() take world positions too, but everything else
+				on the CPU, the bounds, the patches, Edit(), and CastRay(), stays in the tile's own coordinates, so casting
+				rays against the displacement is only exact for a tile at the world origin. A tile can share the
+				displacement map and index buffers of another the same size.
+				- Only the sides of the skirt along the edge of the world are drawn. See TerrainTiles.h.
 
 Future Work:	- Add a colour palette.
 				- Add bounding sphere code.
@@ -27,74 +58,178 @@ Future Work:	- Add a colour palette.
 #include "Graphics.h"
 #include "Material.h"
 #include "BoundingVolume.h"
+#include "TerrainMesh.h"
+#include "PatchChunks.h"
+#include "HeightfieldRayCast.h"
+#include "TerrainEdit.h"
+#include "TerrainTiles.h"
+#include "PatchCulling.h"
+#include <mutex>
 #include <vector>
 
 using namespace graphics;
 
-struct Vertex {
-	XMFLOAT3 position;
-	XMFLOAT3 aabbmin;
-	XMFLOAT3 aabbmax;
-	UINT skirt;
+// number of patches along each side of a block in the coarse grid of height bounds returned by GetBlockBounds().
+static const int TERRAIN_BLOCK_PATCHES = 16;
+// the 32 bit root constant the vertex shaders add to SV_VertexID, after the shadow pass's cascade map. See DrawChunks().
+static const unsigned int TERRAIN_BASE_VERTEX_CONSTANT = 1;
+
+// The compact form of Vertex read by the terrain vertex shaders. Matches the structured buffer at SRV_SLOT_CONTROLPOINTS.
+// The position isn't stored. It follows from the vertex's place in the grid, and the height from the heightmap.
+struct PackedVertex {
+	UINT bounds;	// z bounds of the patch starting at this vertex, quantized to 16 bits over the terrain's height range. min in the low half.
+	UINT data;		// error as a half float in the low 16 bits, skirt in the high 16 bits.
 };
 
+// Layout of the SRV descriptor table shared by all of the terrain pipelines.
+enum TerrainSRVSlot { SRV_SLOT_HEIGHTMAP = 0, SRV_SLOT_DISPLACEMENTMAP, SRV_SLOT_SHADOWATLAS, SRV_SLOT_MATERIAL, SRV_SLOT_CONTROLPOINTS, NUM_TERRAIN_SRV_SLOTS };
+
 struct TerrainShaderConstants {
 	float scale;
 	float width;
 	float depth;
 	float base;
+	float spacing;		// TERRAIN_GRID_SPACING.
+	float boundsmin;	// bottom of the height range PackedVertex::bounds is quantized over.
+	float boundsrange;	// size of the height range PackedVertex::bounds is quantized over.
+	float padding;
+	XMFLOAT2 offset;	// world position of the terrain's first control point.
+	UINT skirts;		// TERRAIN_SKIRT_* bits of the sides of the skirt to draw.
+	UINT padding2;
 
-	TerrainShaderConstants(float s, float w, float d, float b) : scale(s), width(w), depth(d), base(b) {}
+	TerrainShaderConstants(float s, float w, float d, float b, float sp, float bmin, float brange, XMFLOAT2 o, UINT sk) : scale(s), width(w),
+		depth(d), base(b), spacing(sp), boundsmin(bmin), boundsrange(brange), padding(0.0f), offset(o), skirts(sk), padding2(0) {}
 };
 
 class Terrain {
 public:
+	// Load a terrain on its own, at the world origin.
 	Terrain(ResourceManager* rm, TerrainMaterial* mat, const char* fnHeightmap, const char* fnDisplacementMap);
+	// Create a tile of a TerrainWorld from the heightmap data loaded into rm at iHeightMapData, placed at origin, with the
+	// skirts listed as TERRAIN_SKIRT_* bits. If shared isn't null, its displacement map and index buffers are used rather than new ones.
+	Terrain(ResourceManager* rm, TerrainMaterial* mat, unsigned int iHeightMapData, unsigned int wHeightMap, unsigned int hHeightMap,
+		XMFLOAT2 origin, unsigned int skirts, const char* fnDisplacementMap, Terrain* shared);
 	~Terrain();
 
-	void Draw(ID3D12GraphicsCommandList* cmdList, bool Draw3D = true);
+	// Draw the terrain. The base vertex of each chunk is set in the root constants at constantsRootIndex.
+	void Draw(ID3D12GraphicsCommandList* cmdList, unsigned int constantsRootIndex, bool Draw3D = true);
+	// Draw the terrain patches, chunk by chunk, from the index buffer GetChunkIndexView() returns, which must be bound.
+	// Each chunk's base vertex is set in the root constants at constantsRootIndex, and put back to 0 afterwards.
+	void DrawChunks(ID3D12GraphicsCommandList* cmdList, unsigned int constantsRootIndex, unsigned int numInstances = 1);
+	// Draw the sides of the skirt to be drawn and the bottom plane from the index buffer GetSkirtIndexView() returns, which must be bound.
+	void DrawSkirts(ID3D12GraphicsCommandList* cmdList, unsigned int numInstances = 1);
+	// Draw the whole terrain without an index buffer. The vertex shader works out each patch's control points from SV_VertexID.
+	// Requires a pipeline built with RenderTerrainTessProceduralVS.hlsl.
+	void DrawProcedural(ID3D12GraphicsCommandList* cmdList);
+	// Draw numIndices indices, starting at startIndex, from the provided patch index buffer. Draws numInstances instances.
+	void DrawPatches(ID3D12GraphicsCommandList* cmdList, D3D12_INDEX_BUFFER_VIEW* view, unsigned int startIndex, 
+		unsigned int numIndices, unsigned int numInstances = 1);
+	// Cull every patch against each of the numFrustums 4 plane frustums using the same test as the hull shaders.
+	// lists[i] receives the patches inside frustum i. visible receives the patches inside at least one frustum.
+	void CullPatches(const XMFLOAT4 (*frustums)[4], unsigned int numFrustums, std::vector<UINT>* lists, std::vector<UINT>& visible);
+	// Write the control point indices of the listed patches to dst. Returns the number of indices written.
+	unsigned int WritePatchIndices(const std::vector<UINT>& patches, UINT* dst);
+	// Draw the patches in the provided index buffer with ExecuteIndirect, using the draw arguments at offsetArgs in args.
+	// sig must describe a single DrawIndexedInstanced.
+	void DrawPatchesIndirect(ID3D12GraphicsCommandList* cmdList, D3D12_INDEX_BUFFER_VIEW* view, ID3D12CommandSignature* sig,
+		ID3D12Resource* args, unsigned long long offsetArgs);
+	// Fill list with the bounds and control point indices of every patch, in the same order as the index buffer.
+	void GetPatchCullData(std::vector<PatchCullData>& list);
+	// Fill list with the bounds and control point indices of num patches, starting at patch first.
+	void GetPatchCullData(std::vector<PatchCullData>& list, unsigned long first, unsigned long num);
+	// Estimate how many triangles the tessellator produces for the patches inside the frustum, using the CPU version of the
+	// hull shader's factors. numDistanceRamp receives the count for the old distance based factors.
+	unsigned long long EstimateTriangleCount(const XMFLOAT4 frustum[6], const TessFactorParams& params, unsigned long long& numDistanceRamp);
 	// Attach the resources needed for rendering terrain.
-	// Requires the indices into the root descriptor table to attach the heightmap and displacement map SRVs and constant buffer CBV to.
-	void AttachTerrainResources(ID3D12GraphicsCommandList* cmdList, unsigned int srvDescTableIndexHeightMap,
-		unsigned int srvDescTableIndexDisplacementMap, unsigned int cbvDescTableIndex);
-	// Attach the material resources. Requires root descriptor table index.
-	void AttachMaterialResources(ID3D12GraphicsCommandList* cmdList, unsigned int srvDescTableIndex);
+	// Requires the index of the root CBV to attach the terrain constant buffer to.
+	void AttachTerrainResources(ID3D12GraphicsCommandList* cmdList, unsigned int cbvRootIndex);
+	// Write the heightmap, displacement map, material, and control point SRVs into the descriptor table starting at slot iTable.
+	void CreateResourceViews(unsigned int iTable);
+	// Print the size of the vertex and index data on the GPU, and how many bytes the input assembler reads per patch,
+	// next to what the full Vertex layout would need.
+	void ReportBufferSizes();
+	// Give the control points shared with next, the following tile along x if isAlongX, otherwise along y, the larger error
+	// of the two tiles'. Returns the number of control points changed. Call UploadVertices() on both afterwards.
+	unsigned int MatchEdgeErrors(Terrain* next, bool isAlongX);
+	// Pack the vertices and upload them over the structured buffer's contents.
+	void UploadVertices();
 
 	BoundingSphere GetBoundingSphere() { return m_BoundingSphere; }
+	// Returns a box bounding the terrain, including the skirts and the displacement map.
+	AxisAlignedBoundingBox GetBoundingBox() { return m_BoundingBox; }
+	// Returns a coarse grid of boxes bounding blocks of TERRAIN_BLOCK_PATCHES x TERRAIN_BLOCK_PATCHES patches.
+	// Used to fit shadow cascades to the height of the terrain actually in view.
+	AxisAlignedBoundingBox* GetBlockBounds() { return m_listBlockBounds.data(); }
+	unsigned int GetNumBlocks() { return (unsigned int)m_listBlockBounds.size(); }
+	unsigned long GetNumIndices() { return m_numIndices; }
+	D3D12_INDEX_BUFFER_VIEW* GetChunkIndexView() { return &m_viewChunkIndexBuffer; }
+	D3D12_INDEX_BUFFER_VIEW* GetSkirtIndexView() { return &m_viewIndexBuffer; }
+	// Returns the world position of the terrain's first control point.
+	XMFLOAT2 GetOrigin() { return m_vOrigin; }
+	unsigned long GetNumPatches() { return m_numIndices / 4; }
+	// Returns the height of the displaced terrain at (x, y), as the domain shader draws it. See TerrainSurface.h.
 	float GetHeightAtPoint(float x, float y);
+	// Returns the CPU copy of the surface the domain shader draws, for building collision meshes.
+	const TerrainSurface* GetSurface() { return m_pSurface; }
+	// Cast a single ray against the terrain. Returns true if it hit. See HeightfieldRayCast.h.
+	bool CastRay(const HeightfieldRay& ray, HeightfieldHit& hit, bool useDisplacement = false) {
+		return m_pRayCaster->CastRay(ray, useDisplacement, hit);
+	}
+	// Cast num rays against the terrain in packets, on one thread per hardware thread.
+	void CastRays(const HeightfieldRay* rays, unsigned int num, HeightfieldHit* hits, bool useDisplacement = false) {
+		m_pRayCaster->CastRays(rays, num, useDisplacement, 0, hits);
+	}
+	// Apply a single stroke of brush to the heightmap and update the mesh, the ray casting pyramid, and the bounds around it.
+	// Returns true if the heightmap changed. Render thread only.
+	bool Edit(const TerrainBrush& brush);
+	// Upload the texels and vertices changed by Edit() since the last call. Render thread only.
+	// Returns the number of ranges of patches whose bounds changed, at most 2, with the first patch and number of patches of each.
+	unsigned int UploadEdits(unsigned long firstPatch[2], unsigned long numPatches[2]);
+	// Move the world space rectangles (min x, min y, max x, max y) changed by Edit() since the last call to list.
+	// They include how far the displacement and normals reach. Hold GetEditLock() while calling.
+	void TakeEditedRegions(std::vector<XMFLOAT4>& list);
+	// Held by Edit() while it changes the heightmap.
+	std::mutex& GetEditLock() { return m_mutexEdit; }
 	
 private:
+	// Load everything from the heightmap data loaded into the resource manager at iHeightMapData. See the constructors.
+	void Init(unsigned int iHeightMapData, const char* fnDisplacementMap, Terrain* shared);
 	// Generates an array of vertices and an array of indices.
-	void CreateMesh3D();
-	// Create the vertex buffer view
+	void CreateMesh3D(Terrain* shared);
+	// Pack the vertices and upload them to the structured buffer the vertex shaders read.
 	void CreateVertexBuffer();
-	// Create the index buffer view
-	void CreateIndexBuffer();
+	// Split the terrain patches of the numX x numY grid into chunks with 16 bit indices and create their index buffer,
+	// along with a 32 bit index buffer for the skirts and bottom plane.
+	void CreateIndexBuffers(int numX, int numY);
 	// Create the constant buffer for terrain shader constants
 	void CreateConstantBuffer();
-	// load the specified file containing the heightmap data.
-	void LoadHeightMap(const char* fnHeightMap);
+	// Merge the bounds of the numPatchesX x numPatchesY terrain patches into blocks of TERRAIN_BLOCK_PATCHES x TERRAIN_BLOCK_PATCHES.
+	void CreateBlockBounds(int numPatchesX, int numPatchesY);
+	// Recalculate the blocks holding patches [x0, x1) x [y0, y1) and grow the bounding box to take them in.
+	void UpdateBlockBounds(int x0, int y0, int x1, int y1);
+	// Returns the box bounding block (bx, by) of the numPatchesX x numPatchesY terrain patches.
+	AxisAlignedBoundingBox CalcBlockBounds(int bx, int by, int numPatchesX, int numPatchesY);
+	// Create the heightmap texture and upload m_dataHeightMap to it.
+	void CreateHeightMap();
 	// load the specified file containing a displacement map used for smaller geometry detail.
 	void LoadDisplacementMap(const char* fnMap);
-	// calculate the minimum and maximum z values for vertices between the provide bounds.
-	XMFLOAT2 CalcZBounds(Vertex topLeft, Vertex bottomRight);
+	// Quantize a patch's z bounds to 16 bits each, rounding outwards so the result still holds the patch.
+	UINT PackZBounds(XMFLOAT3 aabbmin, XMFLOAT3 aabbmax);
+	// Returns the compact form of a vertex the vertex shaders read.
+	PackedVertex PackVertex(const Vertex& v);
 	// Clean up array data
 	void DeleteVertexAndIndexArrays();
 
-	float GetHeightMapValueAtPoint(float x, float y);
-	float GetDisplacementMapValueAtPoint(float x, float y);
-	XMFLOAT3 CalculateNormalAtPoint(float x, float y);
-
 	TerrainMaterial*			m_pMat;
 	ResourceManager*			m_pResMgr;
-	D3D12_VERTEX_BUFFER_VIEW	m_viewVertexBuffer;
-	D3D12_INDEX_BUFFER_VIEW		m_viewIndexBuffer;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlHeightMapSRV_CPU;
-	D3D12_GPU_DESCRIPTOR_HANDLE m_hdlHeightMapSRV_GPU;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlDisplacementMapSRV_CPU;
-	D3D12_GPU_DESCRIPTOR_HANDLE m_hdlDisplacementMapSRV_GPU;
-	D3D12_CPU_DESCRIPTOR_HANDLE m_hdlConstantsCBV_CPU;
-	D3D12_GPU_DESCRIPTOR_HANDLE m_hdlConstantsCBV_GPU;
+	D3D12_INDEX_BUFFER_VIEW		m_viewIndexBuffer;		// 32 bit indices of the skirts and bottom plane.
+	D3D12_INDEX_BUFFER_VIEW		m_viewChunkIndexBuffer;	// 16 bit indices of the terrain patches, relative to each chunk's base vertex.
+	ID3D12Resource*				m_pHeightMap;
+	ID3D12Resource*				m_pDisplacementMap;
+	ID3D12Resource*				m_pConstantBuffer;
+	ID3D12Resource*				m_pVertexBuffer;	// structured buffer of PackedVertex.
+	unsigned int				m_iHeightMap;		// index of m_pHeightMap in the resource manager.
+	unsigned int				m_iVertexBuffer;
 	unsigned char*				m_dataHeightMap;
 	unsigned char*				m_dataDisplacementMap;
 	unsigned int				m_wHeightMap;
@@ -102,12 +237,27 @@ private:
 	unsigned int				m_wDisplacementMap;
 	unsigned int				m_hDisplacementMap;
 	float						m_hBase;
+	float						m_zBoundsMin;		// height range PackedVertex::bounds is quantized over.
+	float						m_zBoundsRange;
 	unsigned long				m_numVertices;
 	unsigned long				m_numIndices;
+	unsigned long				m_numSkirtIndices;
 	float						m_scaleHeightMap;
 	Vertex*						m_dataVertices;		// buffer to contain vertex array prior to upload.
 	UINT*						m_dataIndices;		// buffer to contain index array prior to upload.
+	TerrainMeshInfo				m_infoMesh;
+	XMFLOAT2					m_vOrigin;				// world position of the first control point.
+	unsigned int				m_skirts;				// TERRAIN_SKIRT_* bits of the sides of the skirt drawn.
 	TerrainShaderConstants*		m_pConstants;
 	BoundingSphere				m_BoundingSphere;
+	AxisAlignedBoundingBox		m_BoundingBox;
+	std::vector<AxisAlignedBoundingBox>	m_listBlockBounds;
+	std::vector<PatchChunk>		m_listChunks;			// see PatchChunks.h.
+	TerrainSurface*				m_pSurface;				// the displaced surface as the domain shader draws it.
+	HeightfieldRayCaster*		m_pRayCaster;
+	std::mutex					m_mutexEdit;			// held while Edit() changes the heightmap.
+	TexelRect					m_rectEditedTexels;		// changed by Edit() and not uploaded yet.
+	TerrainMeshRegion			m_regionEdited;			// control points changed by Edit() and not uploaded yet.
+	std::vector<XMFLOAT4>		m_listEditedRegions;	// see TakeEditedRegions().
 };
 
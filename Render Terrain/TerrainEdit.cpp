@@ -0,0 +1,100 @@
+/*
+TerrainEdit.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Brushes for editing the terrain's heightmap while it runs.
+*/
+#include "TerrainEdit.h"
+#include <cmath>
+#include <vector>
+
+// Returns the height of texel (x, y), clamped to the edges of the heightmap.
+static float GetTexelHeight(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale, int x, int y) {
+	x = x < 0 ? 0 : x >= (int)wHeightMap ? (int)wHeightMap - 1 : x;
+	y = y < 0 ? 0 : y >= (int)hHeightMap ? (int)hHeightMap - 1 : y;
+	return ((float)heightmap[((size_t)y * wHeightMap + x) * 4] / 255.0f) * scale;
+}
+
+// Apply a single stroke of brush to the w x h heightmap. Returns true if any texel changed, with the texels that did in dirty.
+bool ApplyTerrainBrush(unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale, const TerrainBrush& brush,
+	TexelRect& dirty) {
+	dirty = {};
+	if (brush.radius <= 0.0f || brush.strength <= 0.0f) return false;
+
+	// texel (x, y) has its centre at world (x + 0.5, (y + 0.5) * w / h).
+	float scaleY = (float)hHeightMap / (float)wHeightMap;
+	int x0 = (int)floorf(brush.x - brush.radius - 0.5f);
+	int x1 = (int)ceilf(brush.x + brush.radius - 0.5f) + 1;
+	int y0 = (int)floorf((brush.y - brush.radius) * scaleY - 0.5f);
+	int y1 = (int)ceilf((brush.y + brush.radius) * scaleY - 0.5f) + 1;
+	x0 = x0 < 0 ? 0 : x0;
+	y0 = y0 < 0 ? 0 : y0;
+	x1 = x1 > (int)wHeightMap ? (int)wHeightMap : x1;
+	y1 = y1 > (int)hHeightMap ? (int)hHeightMap : y1;
+	if (x0 >= x1 || y0 >= y1) return false;
+
+	// smoothing reads the neighbours of every texel it changes, so it works from a copy of the heights as they were.
+	int numSrcX = x1 - x0 + 2;
+	std::vector<float> listSrc;
+	if (brush.mode == BRUSH_SMOOTH) {
+		listSrc.resize((size_t)numSrcX * (y1 - y0 + 2));
+		for (int y = y0 - 1; y <= y1; ++y) {
+			for (int x = x0 - 1; x <= x1; ++x) {
+				listSrc[(size_t)(y - y0 + 1) * numSrcX + x - x0 + 1] = GetTexelHeight(heightmap, wHeightMap, hHeightMap, scale, x, y);
+			}
+		}
+	}
+
+	unsigned int dx0 = wHeightMap, dy0 = hHeightMap, dx1 = 0, dy1 = 0;
+	float rr = brush.radius * brush.radius;
+	for (int y = y0; y < y1; ++y) {
+		float dy = ((float)y + 0.5f) / scaleY - brush.y;
+		for (int x = x0; x < x1; ++x) {
+			float dx = (float)x + 0.5f - brush.x;
+			float d = (dx * dx + dy * dy) / rr;
+			if (d >= 1.0f) continue;
+
+			// a smooth falloff with no crease at the centre or the edge.
+			float step = brush.strength * (1.0f - d) * (1.0f - d);
+			unsigned char& texel = heightmap[((size_t)y * wHeightMap + x) * 4];
+			float z = ((float)texel / 255.0f) * scale;
+			float target;
+			switch (brush.mode) {
+			case BRUSH_RAISE: target = z + step; break;
+			case BRUSH_LOWER: target = z - step; break;
+			case BRUSH_FLATTEN: target = brush.height; break;
+			default: {
+				float sum = 0.0f;
+				for (int ny = -1; ny <= 1; ++ny) {
+					for (int nx = -1; nx <= 1; ++nx) {
+						sum += listSrc[(size_t)(y - y0 + 1 + ny) * numSrcX + x - x0 + 1 + nx];
+					}
+				}
+				target = sum / 9.0f;
+				break;
+			}
+			}
+			z += fmaxf(fminf(target - z, step), -step);
+
+			float value = floorf(z / scale * 255.0f + 0.5f);
+			value = value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : value;
+			if ((unsigned char)value == texel) continue;
+
+			texel = (unsigned char)value;
+			dx0 = (unsigned int)x < dx0 ? (unsigned int)x : dx0;
+			dy0 = (unsigned int)y < dy0 ? (unsigned int)y : dy0;
+			dx1 = (unsigned int)x + 1 > dx1 ? (unsigned int)x + 1 : dx1;
+			dy1 = (unsigned int)y + 1 > dy1 ? (unsigned int)y + 1 : dy1;
+		}
+	}
+
+	if (dx0 >= dx1) return false;
+
+	dirty.x0 = dx0;
+	dirty.y0 = dy0;
+	dirty.x1 = dx1;
+	dirty.y1 = dy1;
+	return true;
+}
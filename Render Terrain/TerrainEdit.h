@@ -0,0 +1,69 @@
+/*
+TerrainEdit.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Brushes for editing the terrain's heightmap while it runs: raise, lower, flatten, and smooth.
+				Each stroke changes the heightmap in place and reports the rectangle of texels it changed,
+				so the mesh, the ray casting pyramid, and the GPU copy of the heightmap only need updating
+				there. Only depends on DirectXMath, so strokes can be applied and timed without a Direct3D 12 device.
+
+Usage:			- Fill in a TerrainBrush and call ApplyTerrainBrush() with the heightmap, 4 bytes per texel with the
+					height in the first byte, scaled by scale / 255, as per TerrainMesh.h.
+				- The brush is centred at world (x, y) and reaches radius world units. World x and y are in heightmap
+					texels, and y is scaled by width / depth as the shaders sample it. See TerrainSurface.h.
+				- Each stroke moves the surface under the centre of the brush by up to strength world units, falling
+					off smoothly to nothing at the edge. Raise and lower move it up or down. Flatten moves it towards
+					height. Smooth moves it towards the average of each texel and its 8 neighbours.
+				- Heights are stored in 8 bits, so each texel moves in steps of scale / 255. Near the edge of the brush,
+					where the stroke would move it less than half a step, it isn't changed at all.
+				- dirty receives the texels that actually changed. It is empty if the stroke changed nothing.
+				- The TerrainEdit tests in Render Terrain Tests check the incremental mesh and pyramid updates after
+					strokes against rebuilding them from scratch, and the TerrainEdit benchmark times them.
+
+Future Work:	- Add a brush that paints the displacement map.
+				- Keep an undo buffer of the texels each stroke changed.
+*/
+#pragma once
+
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+enum TerrainBrushMode { BRUSH_RAISE = 0, BRUSH_LOWER, BRUSH_FLATTEN, BRUSH_SMOOTH };
+
+struct TerrainBrush {
+	TerrainBrushMode	mode;
+	float				x;			// centre of the brush, in world units.
+	float				y;
+	float				radius;		// world units.
+	float				strength;	// world units the centre moves per stroke, at most.
+	float				height;		// height BRUSH_FLATTEN moves the surface towards.
+};
+
+// A rectangle of heightmap texels, [x0, x1) x [y0, y1).
+struct TexelRect {
+	unsigned int	x0;
+	unsigned int	y0;
+	unsigned int	x1;
+	unsigned int	y1;
+
+	bool IsEmpty() const { return x0 >= x1 || y0 >= y1; }
+	// Grow the rectangle to take in r as well.
+	void Merge(const TexelRect& r) {
+		if (r.IsEmpty()) return;
+		if (IsEmpty()) {
+			*this = r;
+			return;
+		}
+		x0 = x0 < r.x0 ? x0 : r.x0;
+		y0 = y0 < r.y0 ? y0 : r.y0;
+		x1 = x1 > r.x1 ? x1 : r.x1;
+		y1 = y1 > r.y1 ? y1 : r.y1;
+	}
+};
+
+// Apply a single stroke of brush to the w x h heightmap. Returns true if any texel changed, with the texels that did in dirty.
+bool ApplyTerrainBrush(unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale, const TerrainBrush& brush,
+	TexelRect& dirty);
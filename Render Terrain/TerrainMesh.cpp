@@ -0,0 +1,394 @@
+/*
+TerrainMesh.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Builds the CPU side of the terrain mesh.
+*/
+#include "TerrainMesh.h"
+#include "ParallelFor.h"
+#include <DirectXPackedVector.h>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+// Returns the lowest and highest heights of the texels in the inclusive rectangle [x0, x1] x [y0, y1].
+static XMFLOAT2 CalcHeightRange(const unsigned char* heightmap, unsigned int wHeightMap, float scale, int x0, int y0, int x1, int y1) {
+	float max = -100000;
+	float min = 100000;
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			float z = ((float)heightmap[(x + y * wHeightMap) * 4] / 255.0f) * scale;
+
+			if (z > max) max = z;
+			if (z < min) min = z;
+		}
+	}
+
+	return XMFLOAT2(min, max);
+}
+
+// Returns the lowest and highest heights of the texels between the provided points, widened by a texel on each side.
+XMFLOAT2 CalcZBounds(const unsigned char* heightmap, unsigned int wHeightMap, float scale, XMFLOAT3 bottomLeft, XMFLOAT3 topRight) {
+	int bottomLeftX = bottomLeft.x == 0 ? (int)bottomLeft.x : (int)bottomLeft.x - 1;
+	int bottomLeftY = bottomLeft.y == 0 ? (int)bottomLeft.y : (int)bottomLeft.y - 1;
+	int topRightX = topRight.x >= wHeightMap ? (int)topRight.x : (int)topRight.x + 1;
+	int topRightY = topRight.y >= wHeightMap ? (int)topRight.y : (int)topRight.y + 1;
+
+	return CalcHeightRange(heightmap, wHeightMap, scale, bottomLeftX, bottomLeftY, topRightX, topRightY);
+}
+
+// Returns the height error of patch (x, y) of the grid. See TessFactors.h.
+static float CalcPatchError(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale, int x, int y) {
+	return CalcPatchHeightError(heightmap, wHeightMap, hHeightMap, x * TERRAIN_GRID_SPACING, y * TERRAIN_GRID_SPACING,
+		TERRAIN_GRID_SPACING, scale) + TESS_DISPLACEMENT_ERROR;
+}
+
+// Returns the largest error of the patches sharing control point (x, y), rounded to a half float as the GPU gets it.
+// errors holds numPatchesX errors per row, starting at patch (xErrors, yErrors).
+static float CalcVertexError(const float* errors, int numErrorsX, int xErrors, int yErrors, int numPatchesX, int numPatchesY, int x, int y) {
+	float error = 0.0f;
+	for (int py = y - 1; py <= y; ++py) {
+		for (int px = x - 1; px <= x; ++px) {
+			if (px < 0 || py < 0 || px >= numPatchesX || py >= numPatchesY) continue;
+			error = fmaxf(error, errors[(py - yErrors) * numErrorsX + px - xErrors]);
+		}
+	}
+
+	return PackedVector::XMConvertHalfToFloat(PackedVector::XMConvertFloatToHalf(error));
+}
+
+// Store the bounds of the patch from control point v0 to v3 in v0.
+// subtract one from coords of min and add one to coords of max to take into account
+// the offsets caused by displacement, which should always be between -1 and 1.
+static void SetPatchBounds(const unsigned char* heightmap, unsigned int wHeightMap, float scale, Vertex& v0, const Vertex& v3) {
+	XMFLOAT2 bz = CalcZBounds(heightmap, wHeightMap, scale, v0.position, v3.position);
+	v0.aabbmin = XMFLOAT3(v0.position.x - 0.5f, v0.position.y - 0.5f, bz.x - 0.5f);
+	v0.aabbmax = XMFLOAT3(v3.position.x + 0.5f, v3.position.y + 0.5f, bz.y + 0.5f);
+}
+
+// Returns the height of control point (x, y) of the grid.
+static float CalcControlPointHeight(const unsigned char* heightmap, unsigned int wHeightMap, float scale, int x, int y) {
+	return ((float)heightmap[((y * wHeightMap + x) * 4) * TERRAIN_GRID_SPACING] / 255.0f) * scale;
+}
+
+// Returns the index of the first base vertex of each side of the skirt. Sides 1 and 2 run along x, sides 3 and 4 along y.
+static void CalcFirstBaseVertices(const TerrainMeshInfo& info, int firstBase[4]) {
+	int numVertsInTerrain = info.numX * info.numY;
+	firstBase[0] = numVertsInTerrain;
+	firstBase[1] = numVertsInTerrain + info.numX;
+	firstBase[2] = numVertsInTerrain + 2 * info.numX;
+	firstBase[3] = numVertsInTerrain + 2 * info.numX + info.numY;
+}
+
+// Store the bounds of patch i along side (0 to 3) of the skirt in its first control point, which is a base vertex.
+// They reach from the bottom of the skirt to the top of the terrain along that edge.
+static void SetSkirtBounds(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale,
+	const TerrainMeshInfo& info, int side, int i, Vertex* vertices) {
+	int tessFactor = TERRAIN_GRID_SPACING;
+	int scalePatchX = info.numX;
+	int firstBase[4];
+	CalcFirstBaseVertices(info, firstBase);
+	int offset = scalePatchX * (info.numY - 1);
+	float hBase = info.hBase;
+
+	if (side == 0) {
+		// side 1 of skirt. y = 0.
+		XMFLOAT2 bz = CalcZBounds(heightmap, wHeightMap, scale, vertices[i].position, vertices[i + 1].position);
+		vertices[firstBase[0] + i].aabbmin = XMFLOAT3((float)(i * tessFactor), 0.0f, hBase);
+		vertices[firstBase[0] + i].aabbmax = XMFLOAT3((float)((i + 1) * tessFactor), 0.0f, bz.y);
+	} else if (side == 1) {
+		// side 2 of skirt. y = hHeightMap - tessFactor.
+		XMFLOAT2 bz = CalcZBounds(heightmap, wHeightMap, scale, vertices[i + offset].position, vertices[i + offset + 1].position);
+		vertices[firstBase[1] + i + 1].aabbmin = XMFLOAT3((float)(i * tessFactor), (float)(hHeightMap - tessFactor), hBase);
+		vertices[firstBase[1] + i + 1].aabbmax = XMFLOAT3((float)((i + 1) * tessFactor), (float)(hHeightMap - tessFactor), bz.y);
+	} else if (side == 2) {
+		// side 3 of skirt. x = 0.
+		XMFLOAT2 bz = CalcZBounds(heightmap, wHeightMap, scale, vertices[i * scalePatchX].position, vertices[(i + 1) * scalePatchX].position);
+		vertices[firstBase[2] + i + 1].aabbmin = XMFLOAT3(0.0f, (float)(i * tessFactor), hBase);
+		vertices[firstBase[2] + i + 1].aabbmax = XMFLOAT3(0.0f, (float)((i + 1) * tessFactor), bz.y);
+	} else {
+		// side 4 of skirt. x = wHeightMap - tessFactor.
+		XMFLOAT2 bz = CalcZBounds(heightmap, wHeightMap, scale, vertices[i * scalePatchX + scalePatchX - 1].position,
+			vertices[(i + 1) * scalePatchX + scalePatchX - 1].position);
+		vertices[firstBase[3] + i].aabbmin = XMFLOAT3((float)(wHeightMap - tessFactor), (float)(i * tessFactor), hBase);
+		vertices[firstBase[3] + i].aabbmax = XMFLOAT3((float)(wHeightMap - tessFactor), (float)((i + 1) * tessFactor), bz.y);
+	}
+}
+
+// Returns the grid size and the number of vertices and indices needed for a heightmap of w x h texels.
+TerrainMeshInfo CalcTerrainMeshInfo(unsigned int wHeightMap, unsigned int hHeightMap) {
+	TerrainMeshInfo info = {};
+	info.numX = wHeightMap / TERRAIN_GRID_SPACING;
+	info.numY = hHeightMap / TERRAIN_GRID_SPACING;
+	// a base vertex under every control point along the edges. Sides 1 and 2 run along x, sides 3 and 4 along y.
+	info.numVertices = info.numX * info.numY + 2 * info.numX + 2 * info.numY;
+	// 4 indices per terrain patch, per skirt patch along each side, and for the bottom plane.
+	info.numIndices = (info.numX - 1) * (info.numY - 1) * 4 + 2 * 4 * (info.numX - 1) + 2 * 4 * (info.numY - 1) + 4;
+
+	return info;
+}
+
+// Build the mesh for the heightmap into vertices and indices, which must have room for info.numVertices and info.numIndices.
+// heightmap is 4 bytes per texel with the height in the first byte, scaled by scale / 255.
+// Runs on numThreads threads, or one per hardware thread if 0. Also fills in info.zBounds and info.hBase.
+void BuildTerrainMesh(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale,
+	unsigned int numThreads, TerrainMeshInfo& info, Vertex* vertices, unsigned int* indices) {
+	if (numThreads == 0) {
+		numThreads = std::thread::hardware_concurrency();
+	}
+
+	int tessFactor = TERRAIN_GRID_SPACING;
+	int scalePatchX = info.numX;
+	int scalePatchY = info.numY;
+	int numVertsInTerrain = scalePatchX * scalePatchY;
+
+	// create a vertex array 1/tessFactor the size of the height map in each dimension, to be stretched over the height map.
+	// Only the first control point of each patch gets bounds. The rest are left empty.
+	ParallelForBands(scalePatchY, numThreads, [&](int y0, int y1) {
+		for (int y = y0; y < y1; ++y) {
+			for (int x = 0; x < scalePatchX; ++x) {
+				Vertex& v = vertices[y * scalePatchX + x];
+				v.position = XMFLOAT3((float)x * tessFactor, (float)y * tessFactor, CalcControlPointHeight(heightmap, wHeightMap, scale, x, y));
+				v.aabbmin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+				v.aabbmax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+				v.skirt = 5;
+				v.error = 0.0f;
+			}
+		}
+	});
+
+	// measure how far the heightmap strays from each flat patch. See TessFactors.h.
+	int numPatchesX = scalePatchX - 1;
+	int numPatchesY = scalePatchY - 1;
+	std::vector<float> listErrors(numPatchesX > 0 && numPatchesY > 0 ? numPatchesX * numPatchesY : 0);
+	ParallelForBands(numPatchesY, numThreads, [&](int y0, int y1) {
+		for (int y = y0; y < y1; ++y) {
+			for (int x = 0; x < numPatchesX; ++x) {
+				listErrors[y * numPatchesX + x] = CalcPatchError(heightmap, wHeightMap, hHeightMap, scale, x, y);
+			}
+		}
+	});
+
+	// give every vertex the largest error of the patches around it. Gathering per vertex keeps bands from writing to the same vertex,
+	// and the max doesn't depend on the order the patches are visited in.
+	// The GPU only gets half float errors, so round them here too. EstimateTriangleCount() then sees the same values as the hull shader.
+	ParallelForBands(scalePatchY, numThreads, [&](int y0, int y1) {
+		for (int y = y0; y < y1; ++y) {
+			for (int x = 0; x < scalePatchX; ++x) {
+				vertices[y * scalePatchX + x].error = CalcVertexError(listErrors.data(), numPatchesX, 0, 0, numPatchesX, numPatchesY, x, y);
+			}
+		}
+	});
+
+	// the height range of the whole heightmap, reduced row by row.
+	XMFLOAT3 cornerMin = vertices[0].position;
+	XMFLOAT3 cornerMax = vertices[numVertsInTerrain - 1].position;
+	int x0 = cornerMin.x == 0 ? (int)cornerMin.x : (int)cornerMin.x - 1;
+	int y0 = cornerMin.y == 0 ? (int)cornerMin.y : (int)cornerMin.y - 1;
+	int x1 = cornerMax.x >= wHeightMap ? (int)cornerMax.x : (int)cornerMax.x + 1;
+	int y1 = cornerMax.y >= wHeightMap ? (int)cornerMax.y : (int)cornerMax.y + 1;
+	std::vector<XMFLOAT2> listRowBounds(y1 - y0 + 1);
+	ParallelForBands((int)listRowBounds.size(), numThreads, [&](int r0, int r1) {
+		for (int r = r0; r < r1; ++r) {
+			listRowBounds[r] = CalcHeightRange(heightmap, wHeightMap, scale, x0, y0 + r, x1, y0 + r);
+		}
+	});
+	XMFLOAT2 zBounds(100000, -100000);
+	for (auto& b : listRowBounds) {
+		if (b.y > zBounds.y) zBounds.y = b.y;
+		if (b.x < zBounds.x) zBounds.x = b.x;
+	}
+	float hBase = zBounds.x - 10;
+	info.zBounds = zBounds;
+	info.hBase = hBase;
+
+	// each side of the skirt gets a row of base vertices. Side 1 is at y = 0, side 2 at y = hHeightMap - tessFactor,
+	// side 3 at x = 0, and side 4 at x = wHeightMap - tessFactor.
+	int firstBase[4];
+	CalcFirstBaseVertices(info, firstBase);
+	ParallelForBands(4, numThreads, [&](int s0, int s1) {
+		for (int side = s0; side < s1; ++side) {
+			int num = side < 2 ? scalePatchX : scalePatchY;
+			for (int i = 0; i < num; ++i) {
+				Vertex& v = vertices[firstBase[side] + i];
+				switch (side) {
+				case 0: v.position = XMFLOAT3((float)(i * tessFactor), 0.0f, hBase); break;
+				case 1: v.position = XMFLOAT3((float)(i * tessFactor), (float)(hHeightMap - tessFactor), hBase); break;
+				case 2: v.position = XMFLOAT3(0.0f, (float)(i * tessFactor), hBase); break;
+				default: v.position = XMFLOAT3((float)(wHeightMap - tessFactor), (float)(i * tessFactor), hBase); break;
+				}
+				v.aabbmin = XMFLOAT3(0.0f, 0.0f, 0.0f);
+				v.aabbmax = XMFLOAT3(0.0f, 0.0f, 0.0f);
+				v.error = 0.0f;
+				v.skirt = side + 1;
+			}
+		}
+	});
+
+	// the terrain patches come first in the index list.
+	// our grid is scalePatchX * scalePatchY in size.
+	// the vertices are oriented like so:
+	//  0,  1,  2,  3,  4,
+	//  5,  6,  7,  8,  9,
+	// 10, 11, 12, 13, 14
+	ParallelForBands(numPatchesY, numThreads, [&](int py0, int py1) {
+		for (int y = py0; y < py1; ++y) {
+			for (int x = 0; x < numPatchesX; ++x) {
+				int i = (y * numPatchesX + x) * 4;
+				unsigned int vert0 = x + y * scalePatchX;
+				unsigned int vert1 = x + 1 + y * scalePatchX;
+				unsigned int vert2 = x + (y + 1) * scalePatchX;
+				unsigned int vert3 = x + 1 + (y + 1) * scalePatchX;
+				indices[i++] = vert0;
+				indices[i++] = vert1;
+				indices[i++] = vert2;
+				indices[i++] = vert3;
+
+				// now that we have the indices for our patch, we need to calculate the bounding box.
+				// z bounds is a bit harder as we need to find the max and min y values in the heightmap for the patch range.
+				// store it in the first vertex
+				SetPatchBounds(heightmap, wHeightMap, scale, vertices[vert0], vertices[vert3]);
+			}
+		}
+	});
+
+	// so as not to interfere with the terrain wrt bounds for frustum culling, we need the 0th control point of each skirt patch
+	// to be a base vertex as defined above. Each side writes its own run of indices and its own base vertices, so they can be built at once.
+	int firstSkirtIndex = numPatchesX * numPatchesY * 4;
+	int firstSideIndex[] = { firstSkirtIndex, firstSkirtIndex + 4 * numPatchesX, firstSkirtIndex + 8 * numPatchesX,
+		firstSkirtIndex + 8 * numPatchesX + 4 * numPatchesY };
+	ParallelForBands(4, numThreads, [&](int s0, int s1) {
+		for (int side = s0; side < s1; ++side) {
+			int i = firstSideIndex[side];
+			int offset = scalePatchX * (scalePatchY - 1);
+			if (side == 0) {
+				// side 1 of skirt. y = 0.
+				int iVertex = firstBase[0];
+				for (int x = 0; x < numPatchesX; ++x) {
+					indices[i++] = iVertex;		// control point 0
+					indices[i++] = iVertex + 1;	// control point 1
+					indices[i++] = x;			// control point 2
+					indices[i++] = x + 1;		// control point 3
+					SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, side, x, vertices);
+					++iVertex;
+				}
+			} else if (side == 1) {
+				// side 2 of skirt. y = hHeightMap - tessFactor.
+				for (int x = 0; x < numPatchesX; ++x) {
+					int iVertex = firstBase[1] + x + 1;
+					indices[i++] = iVertex;
+					indices[i++] = iVertex - 1;
+					indices[i++] = x + offset + 1;
+					indices[i++] = x + offset;
+					SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, side, x, vertices);
+				}
+			} else if (side == 2) {
+				// side 3 of skirt. x = 0.
+				for (int y = 0; y < numPatchesY; ++y) {
+					int iVertex = firstBase[2] + y + 1;
+					indices[i++] = iVertex;
+					indices[i++] = iVertex - 1;
+					indices[i++] = (y + 1) * scalePatchX;
+					indices[i++] = y * scalePatchX;
+					SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, side, y, vertices);
+				}
+			} else {
+				// side 4 of skirt. x = wHeightMap - tessFactor.
+				int iVertex = firstBase[3];
+				for (int y = 0; y < numPatchesY; ++y) {
+					indices[i++] = iVertex;
+					indices[i++] = iVertex + 1;
+					indices[i++] = y * scalePatchX + scalePatchX - 1;
+					indices[i++] = (y + 1) * scalePatchX + scalePatchX - 1;
+					SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, side, y, vertices);
+					++iVertex;
+				}
+			}
+		}
+	});
+
+	// add indices for bottom plane. Its bounds go in the last base vertex of side 1, which no side 1 patch starts with.
+	int i = firstSideIndex[3] + 4 * numPatchesY;
+	indices[i++] = numVertsInTerrain + scalePatchX - 1;
+	indices[i++] = numVertsInTerrain;
+	indices[i++] = numVertsInTerrain + scalePatchX + scalePatchX - 1;
+	indices[i++] = numVertsInTerrain + scalePatchX;
+	vertices[numVertsInTerrain + scalePatchX - 1].aabbmin = XMFLOAT3(0.0f, 0.0f, hBase);
+	vertices[numVertsInTerrain + scalePatchX - 1].aabbmax = XMFLOAT3((float)wHeightMap, (float)hHeightMap, hBase);
+	vertices[numVertsInTerrain + scalePatchX - 1].skirt = 0;
+}
+
+// Update the mesh built by BuildTerrainMesh() after the heightmap texels in [x0, x1) x [y0, y1) changed. See TerrainMesh.h.
+void UpdateTerrainMeshRegion(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale,
+	const TerrainMeshInfo& info, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, Vertex* vertices,
+	TerrainMeshRegion& changed) {
+	changed = {};
+	int numPatchesX = info.numX - 1;
+	int numPatchesY = info.numY - 1;
+	if (x0 >= x1 || y0 >= y1 || numPatchesX <= 0 || numPatchesY <= 0) return;
+
+	// the control points sitting on a changed texel.
+	int tessFactor = TERRAIN_GRID_SPACING;
+	for (int y = ((int)y0 + tessFactor - 1) / tessFactor; y <= ((int)y1 - 1) / tessFactor && y < info.numY; ++y) {
+		for (int x = ((int)x0 + tessFactor - 1) / tessFactor; x <= ((int)x1 - 1) / tessFactor && x < info.numX; ++x) {
+			vertices[y * info.numX + x].position.z = CalcControlPointHeight(heightmap, wHeightMap, scale, x, y);
+		}
+	}
+
+	// a patch's bounds take in a texel beyond each of its edges, so any patch within a texel of the change is affected.
+	// Errors only look at the patch's own texels.
+	int px0 = (int)x0 / tessFactor - 2;
+	int py0 = (int)y0 / tessFactor - 2;
+	int px1 = (int)x1 / tessFactor + 1;
+	int py1 = (int)y1 / tessFactor + 1;
+	px0 = px0 < 0 ? 0 : px0;
+	py0 = py0 < 0 ? 0 : py0;
+	px1 = px1 > numPatchesX ? numPatchesX : px1;
+	py1 = py1 > numPatchesY ? numPatchesY : py1;
+
+	for (int y = py0; y < py1; ++y) {
+		for (int x = px0; x < px1; ++x) {
+			SetPatchBounds(heightmap, wHeightMap, scale, vertices[y * info.numX + x], vertices[(y + 1) * info.numX + x + 1]);
+		}
+	}
+
+	// the control points along the edge of the changed patches share patches that didn't change, so take in a ring of those too.
+	int ex0 = px0 > 0 ? px0 - 1 : 0;
+	int ey0 = py0 > 0 ? py0 - 1 : 0;
+	int ex1 = px1 < numPatchesX ? px1 + 1 : numPatchesX;
+	int ey1 = py1 < numPatchesY ? py1 + 1 : numPatchesY;
+	std::vector<float> listErrors((size_t)(ex1 - ex0) * (ey1 - ey0));
+	for (int y = ey0; y < ey1; ++y) {
+		for (int x = ex0; x < ex1; ++x) {
+			listErrors[(y - ey0) * (ex1 - ex0) + x - ex0] = CalcPatchError(heightmap, wHeightMap, hHeightMap, scale, x, y);
+		}
+	}
+	for (int y = py0; y <= py1; ++y) {
+		for (int x = px0; x <= px1; ++x) {
+			vertices[y * info.numX + x].error = CalcVertexError(listErrors.data(), ex1 - ex0, ex0, ey0, numPatchesX, numPatchesY, x, y);
+		}
+	}
+
+	// the skirts hang from the patches along the edges.
+	if (py0 == 0) {
+		for (int x = px0; x < px1; ++x) SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, 0, x, vertices);
+	}
+	if (py1 == numPatchesY) {
+		for (int x = px0; x < px1; ++x) SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, 1, x, vertices);
+	}
+	if (px0 == 0) {
+		for (int y = py0; y < py1; ++y) SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, 2, y, vertices);
+	}
+	if (px1 == numPatchesX) {
+		for (int y = py0; y < py1; ++y) SetSkirtBounds(heightmap, wHeightMap, hHeightMap, scale, info, 3, y, vertices);
+	}
+
+	changed.x0 = px0;
+	changed.y0 = py0;
+	changed.x1 = px1 + 1;
+	changed.y1 = py1 + 1;
+	changed.isSkirtChanged = py0 == 0 || py1 == numPatchesY || px0 == 0 || px1 == numPatchesX;
+}
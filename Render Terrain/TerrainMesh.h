@@ -0,0 +1,69 @@
+/*
+TerrainMesh.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Builds the CPU side of the terrain mesh: the control point grid, the skirts, the
+				patch index list, and the bounds of every patch. Only depends on DirectXMath, so
+				the build can be run and timed without a Direct3D 12 device.
+
+Usage:			- Call CalcTerrainMeshInfo() to find how many vertices and indices a heightmap needs.
+				- Call BuildTerrainMesh() to fill arrays of that size. The grid is split into bands of rows
+					which are built on worker threads. The result is the same for any number of threads.
+				- After editing the heightmap, call UpdateTerrainMeshRegion() with the texels that changed. Only the
+					patches within reach of them are recomputed, and the result is the same as a full rebuild apart
+					from the height range and base of the skirts, which are kept.
+				- The TerrainMesh benchmark in Render Terrain Tests times the build serially and on worker threads.
+
+Future Work:	- Only build the heights and errors of a tile of a TerrainWorld, as the rest of its mesh is the same as every other tile's.
+*/
+#pragma once
+
+#include "TessFactors.h"
+
+// distance between neighbouring control points, in heightmap texels.
+static const int TERRAIN_GRID_SPACING = 8;
+
+struct Vertex {
+	XMFLOAT3 position;
+	XMFLOAT3 aabbmin;
+	XMFLOAT3 aabbmax;
+	unsigned int skirt;
+	float error;	// largest world space height error of the patches sharing this vertex. See TessFactors.h.
+};
+
+// The size of the mesh for a heightmap and, once built, its height range.
+struct TerrainMeshInfo {
+	int				numX;			// terrain control points along each side of the grid.
+	int				numY;
+	unsigned long	numVertices;	// terrain control points followed by the base vertices of the skirts.
+	unsigned long	numIndices;		// 4 per patch. Terrain patches, skirt sides 1 to 4, then the bottom plane.
+	XMFLOAT2		zBounds;		// lowest and highest point of the heightmap. Filled in by BuildTerrainMesh().
+	float			hBase;			// height of the bottom of the skirts. Filled in by BuildTerrainMesh().
+};
+
+// The part of a mesh UpdateTerrainMeshRegion() changed.
+struct TerrainMeshRegion {
+	int		x0;				// control points [x0, x1) x [y0, y1) of the grid.
+	int		y0;
+	int		x1;
+	int		y1;
+	bool	isSkirtChanged;	// did the bounds of any of the skirt's base vertices change?
+};
+
+// Returns the grid size and the number of vertices and indices needed for a heightmap of w x h texels.
+TerrainMeshInfo CalcTerrainMeshInfo(unsigned int wHeightMap, unsigned int hHeightMap);
+// Build the mesh for the heightmap into vertices and indices, which must have room for info.numVertices and info.numIndices.
+// heightmap is 4 bytes per texel with the height in the first byte, scaled by scale / 255.
+// Runs on numThreads threads, or one per hardware thread if 0. Also fills in info.zBounds and info.hBase.
+void BuildTerrainMesh(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale,
+	unsigned int numThreads, TerrainMeshInfo& info, Vertex* vertices, unsigned int* indices);
+// Update the mesh built by BuildTerrainMesh() after the heightmap texels in [x0, x1) x [y0, y1) changed: the heights of the control
+// points, the bounds and errors of the patches, and the bounds of the skirts. changed receives the control points that may have
+// changed. info.zBounds and info.hBase are left as they were, so the skirts keep their base.
+void UpdateTerrainMeshRegion(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale,
+	const TerrainMeshInfo& info, unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1, Vertex* vertices,
+	TerrainMeshRegion& changed);
+// Returns the lowest and highest heights of the texels between the provided points, widened by a texel on each side.
+XMFLOAT2 CalcZBounds(const unsigned char* heightmap, unsigned int wHeightMap, float scale, XMFLOAT3 bottomLeft, XMFLOAT3 topRight);
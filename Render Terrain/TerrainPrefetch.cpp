@@ -0,0 +1,397 @@
+/*
+TerrainPrefetch.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Forecasts the camera's path and loads the terrain regions along it before they're needed.
+*/
+#include "TerrainPrefetch.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+
+// Returns a wrapped into [-pi, pi].
+static float WrapAngle(float a) {
+	while (a > XM_PI) a -= 2.0f * XM_PI;
+	while (a < -XM_PI) a += 2.0f * XM_PI;
+	return a;
+}
+
+// Returns the yaw of look about z, in radians from the x axis.
+static float CalcYaw(const XMFLOAT3& look) {
+	return atan2f(look.y, look.x);
+}
+
+// Returns the pitch of look, in radians above the xy plane.
+static float CalcPitch(const XMFLOAT3& look) {
+	return asinf(look.z < -1.0f ? -1.0f : look.z > 1.0f ? 1.0f : look.z);
+}
+
+// Returns the look direction for yaw and pitch.
+static XMFLOAT3 CalcLook(float yaw, float pitch) {
+	return XMFLOAT3(cosf(pitch) * cosf(yaw), cosf(pitch) * sinf(yaw), sinf(pitch));
+}
+
+// Returns the PrefetchParams the Scene streams with, for regions of regionSize world units.
+PrefetchParams GetDefaultPrefetchParams(float regionSize) {
+	PrefetchParams params;
+	// the heightmap is needed out to the far distance the terrain is drawn at. Materials only matter up close,
+	// and without them the terrain still draws, so they wait behind the heightmaps.
+	params.radius[PREFETCH_LAYER_HEIGHTMAP] = 4.0f * regionSize;
+	params.radius[PREFETCH_LAYER_MATERIAL] = 1.5f * regionSize;
+	params.priority[PREFETCH_LAYER_HEIGHTMAP] = 1.0f;
+	params.priority[PREFETCH_LAYER_MATERIAL] = 0.5f;
+	params.nearRadius = 0.75f * regionSize;
+	params.halfAngle = 0.6f;	// the Camera's horizontal field of view is a little over 60 degrees.
+	params.lookAhead = 1.0f;
+	params.numHorizons = 4;
+	params.maxInFlight = 16;
+	params.maxResident = 160;
+
+	return params;
+}
+
+CameraPredictor::CameraPredictor(double history) : m_history(history), m_vVelocity(0.0f, 0.0f, 0.0f), m_yawRate(0.0f), m_pitchRate(0.0f) {
+}
+
+// Add the camera's state. Samples must come in order of time.
+void CameraPredictor::AddSample(const CameraSample& s) {
+	m_listSamples.push_back(s);
+
+	// keep one sample older than the history so the fit always spans all of it.
+	unsigned int numOld = 0;
+	while (numOld + 2 < m_listSamples.size() && s.t - m_listSamples[numOld + 1].t >= m_history) {
+		++numOld;
+	}
+	if (numOld > 0) m_listSamples.erase(m_listSamples.begin(), m_listSamples.begin() + numOld);
+
+	Fit();
+}
+
+// Fit the velocity and turn rates to the samples by least squares.
+// Key repeat and mouse movement arrive in bursts, so a line through every sample in the history follows the camera
+// far better than the difference between the last two.
+void CameraPredictor::Fit() {
+	unsigned int num = (unsigned int)m_listSamples.size();
+	if (num < 2) {
+		m_vVelocity = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		m_yawRate = 0.0f;
+		m_pitchRate = 0.0f;
+		return;
+	}
+
+	// everything relative to the last sample, so the sums stay small. The yaw is unwrapped so a turn through
+	// pi doesn't look like a turn back the other way.
+	const CameraSample& last = m_listSamples.back();
+	double sumT = 0.0, sumTT = 0.0;
+	double sumX = 0.0, sumY = 0.0, sumZ = 0.0, sumYaw = 0.0, sumPitch = 0.0;
+	double sumTX = 0.0, sumTY = 0.0, sumTZ = 0.0, sumTYaw = 0.0, sumTPitch = 0.0;
+	float yaw = CalcYaw(m_listSamples[0].look);
+	float yawPrev = yaw;
+	for (unsigned int i = 0; i < num; ++i) {
+		const CameraSample& s = m_listSamples[i];
+		float yawSample = CalcYaw(s.look);
+		yaw += WrapAngle(yawSample - yawPrev);
+		yawPrev = yawSample;
+
+		double t = s.t - last.t;
+		sumT += t;
+		sumTT += t * t;
+		sumX += s.eye.x - last.eye.x;
+		sumY += s.eye.y - last.eye.y;
+		sumZ += s.eye.z - last.eye.z;
+		sumYaw += yaw;
+		sumPitch += CalcPitch(s.look);
+		sumTX += t * (s.eye.x - last.eye.x);
+		sumTY += t * (s.eye.y - last.eye.y);
+		sumTZ += t * (s.eye.z - last.eye.z);
+		sumTYaw += t * yaw;
+		sumTPitch += t * CalcPitch(s.look);
+	}
+
+	double denom = num * sumTT - sumT * sumT;
+	if (denom <= 1e-12) return;
+	auto slope = [&](double sum, double sumTV) { return (float)((num * sumTV - sumT * sum) / denom); };
+	m_vVelocity = XMFLOAT3(slope(sumX, sumTX), slope(sumY, sumTY), slope(sumZ, sumTZ));
+	m_yawRate = slope(sumYaw, sumTYaw);
+	m_pitchRate = slope(sumPitch, sumTPitch);
+}
+
+// Forecast the camera's state dt seconds after the last sample.
+CameraSample CameraPredictor::Predict(double dt) const {
+	if (m_listSamples.empty()) return CameraSample{ dt, XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) };
+
+	const CameraSample& last = m_listSamples.back();
+	CameraSample s;
+	s.t = last.t + dt;
+	s.eye = XMFLOAT3(last.eye.x + m_vVelocity.x * (float)dt, last.eye.y + m_vVelocity.y * (float)dt, last.eye.z + m_vVelocity.z * (float)dt);
+
+	// a turn is more likely to stop than to keep going all the way round.
+	float turn = m_yawRate * (float)dt;
+	turn = turn < -XM_PI ? -XM_PI : turn > XM_PI ? XM_PI : turn;
+	float pitch = CalcPitch(last.look) + m_pitchRate * (float)dt;
+	pitch = pitch < -1.5f ? -1.5f : pitch > 1.5f ? 1.5f : pitch;
+	s.look = CalcLook(CalcYaw(last.look) + turn, pitch);
+
+	return s;
+}
+
+RegionPrefetcher::RegionPrefetcher(unsigned int numX, unsigned int numY, float regionSize, const PrefetchParams& params, bool isPredictive) :
+	m_numX(numX), m_numY(numY), m_numRegions(numX * numY), m_regionSize(regionSize), m_Params(params), m_isPredictive(isPredictive),
+	m_numUpdates(0), m_Stats() {
+	unsigned int num = m_numRegions * NUM_PREFETCH_LAYERS;
+	m_listState.resize(num, REGION_EMPTY);
+	m_listPriority.resize(num, 0.0f);
+	m_listLastWanted.resize(num, 0);
+	m_listIsUsed.resize(num, false);
+}
+
+// Call f(region, priority) for every region of every layer the camera at s needs. urgency scales the priorities.
+// A region is needed if it's within the layer's radius and either close or inside the view cone, which is widened by
+// the angle the region itself covers. Nearer regions get higher priorities.
+template <typename F> void RegionPrefetcher::ForEachInView(const CameraSample& s, float urgency, F f) {
+	float lenLook = sqrtf(s.look.x * s.look.x + s.look.y * s.look.y);
+	// looking straight up or down, everything around is in view.
+	bool isLookingDown = lenLook < 0.1f;
+	float lookX = isLookingDown ? 0.0f : s.look.x / lenLook;
+	float lookY = isLookingDown ? 0.0f : s.look.y / lenLook;
+	float halfDiagonal = 0.7071f * m_regionSize;
+
+	for (unsigned int l = 0; l < NUM_PREFETCH_LAYERS; ++l) {
+		float radius = m_Params.radius[l];
+		int x0 = (int)floorf((s.eye.x - radius) / m_regionSize);
+		int x1 = (int)floorf((s.eye.x + radius) / m_regionSize);
+		int y0 = (int)floorf((s.eye.y - radius) / m_regionSize);
+		int y1 = (int)floorf((s.eye.y + radius) / m_regionSize);
+		x0 = x0 < 0 ? 0 : x0;
+		y0 = y0 < 0 ? 0 : y0;
+		x1 = x1 >= (int)m_numX ? (int)m_numX - 1 : x1;
+		y1 = y1 >= (int)m_numY ? (int)m_numY - 1 : y1;
+
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x) {
+				// distance to the nearest point of the region.
+				float xMin = x * m_regionSize, yMin = y * m_regionSize;
+				float dx = s.eye.x < xMin ? xMin - s.eye.x : s.eye.x > xMin + m_regionSize ? s.eye.x - xMin - m_regionSize : 0.0f;
+				float dy = s.eye.y < yMin ? yMin - s.eye.y : s.eye.y > yMin + m_regionSize ? s.eye.y - yMin - m_regionSize : 0.0f;
+				float dist = sqrtf(dx * dx + dy * dy);
+				if (dist > radius) continue;
+
+				if (dist > m_Params.nearRadius && !isLookingDown) {
+					float cx = xMin + 0.5f * m_regionSize - s.eye.x;
+					float cy = yMin + 0.5f * m_regionSize - s.eye.y;
+					float distCentre = sqrtf(cx * cx + cy * cy);
+					float cosAngle = (cx * lookX + cy * lookY) / distCentre;
+					float angle = acosf(cosAngle < -1.0f ? -1.0f : cosAngle > 1.0f ? 1.0f : cosAngle);
+					float angleRegion = atanf(halfDiagonal / distCentre);
+					if (angle > m_Params.halfAngle + angleRegion) continue;
+				}
+
+				unsigned int region = l * m_numRegions + y * m_numX + x;
+				f(region, m_Params.priority[l] * urgency * (2.0f - dist / radius));
+			}
+		}
+	}
+}
+
+// Add the camera's state and work out what to load. Appends the regions to request to requests, most urgent first,
+// and the requests to drop to cancels.
+void RegionPrefetcher::Update(const CameraSample& s, std::vector<PrefetchRequest>& requests, std::vector<unsigned int>& cancels) {
+	++m_numUpdates;
+	m_Predictor.AddSample(s);
+
+	// take what's in view now and at each forecast along the look ahead. A region gets the priority of the soonest it's
+	// needed, so what's needed now always comes before what might be needed in a second.
+	m_listWanted.clear();
+	unsigned int numHorizons = m_isPredictive ? m_Params.numHorizons : 0;
+	for (unsigned int i = 0; i <= numHorizons; ++i) {
+		double dt = numHorizons > 0 ? m_Params.lookAhead * i / numHorizons : 0.0;
+		CameraSample forecast = i == 0 ? s : m_Predictor.Predict(dt);
+		float urgency = 1.0f / (0.25f + (float)dt);
+		ForEachInView(forecast, urgency, [&](unsigned int region, float priority) {
+			if (m_listLastWanted[region] != m_numUpdates) {
+				m_listLastWanted[region] = m_numUpdates;
+				m_listPriority[region] = priority;
+				m_listWanted.push_back(region);
+			} else if (priority > m_listPriority[region]) {
+				m_listPriority[region] = priority;
+			}
+		});
+	}
+
+	// drop the requests the camera no longer needs, so they don't hold up the ones it does.
+	for (unsigned int r = 0; r < m_listState.size(); ++r) {
+		if (m_listState[r] != REGION_REQUESTED || m_listLastWanted[r] == m_numUpdates) continue;
+
+		m_listState[r] = REGION_EMPTY;
+		--m_Stats.numInFlight;
+		++m_Stats.numCancelled;
+		cancels.push_back(r);
+	}
+
+	unsigned int first = (unsigned int)requests.size();
+	for (auto r : m_listWanted) {
+		if (m_listState[r] == REGION_EMPTY) requests.push_back({ r, m_listPriority[r] });
+	}
+	std::sort(requests.begin() + first, requests.end(), [](const PrefetchRequest& a, const PrefetchRequest& b) {
+		return a.priority > b.priority;
+	});
+	unsigned int numFree = m_Params.maxInFlight > m_Stats.numInFlight ? m_Params.maxInFlight - m_Stats.numInFlight : 0;
+	if (requests.size() - first > numFree) requests.resize(first + numFree);
+	for (unsigned int i = first; i < requests.size(); ++i) {
+		m_listState[requests[i].region] = REGION_REQUESTED;
+	}
+	m_Stats.numInFlight += (unsigned int)requests.size() - first;
+	m_Stats.numRequested += requests.size() - first;
+}
+
+// Mark region as loaded. Appends the regions evicted to make room to evicted.
+// A request cancelled after its read started still arrives, and is kept like any other.
+void RegionPrefetcher::SetLoaded(unsigned int region, std::vector<unsigned int>& evicted) {
+	if (m_listState[region] == REGION_LOADED) return;
+	if (m_listState[region] == REGION_REQUESTED) --m_Stats.numInFlight;
+	m_listState[region] = REGION_LOADED;
+	m_listIsUsed[region] = false;
+	++m_Stats.numLoaded;
+	++m_Stats.numResident;
+
+	// evict whatever was wanted longest ago, or failing that, whatever is wanted least.
+	while (m_Stats.numResident > m_Params.maxResident) {
+		unsigned int victim = region;
+		double scoreVictim = 0.0;
+		for (unsigned int r = 0; r < m_listState.size(); ++r) {
+			if (m_listState[r] != REGION_LOADED || r == region) continue;
+
+			double score = m_listLastWanted[r] == m_numUpdates ? m_listPriority[r] : -(double)(m_numUpdates - m_listLastWanted[r]);
+			if (victim == region || score < scoreVictim) {
+				victim = r;
+				scoreVictim = score;
+			}
+		}
+		if (victim == region) break;
+
+		m_listState[victim] = REGION_EMPTY;
+		--m_Stats.numResident;
+		++m_Stats.numEvicted;
+		evicted.push_back(victim);
+	}
+}
+
+// Mark a request as failed, so it's asked for again.
+void RegionPrefetcher::SetFailed(unsigned int region) {
+	if (m_listState[region] != REGION_REQUESTED) return;
+
+	m_listState[region] = REGION_EMPTY;
+	--m_Stats.numInFlight;
+}
+
+// Count the regions the renderer needs to draw from s and which of them are loaded. Returns the number missing.
+unsigned int RegionPrefetcher::CheckNeeded(const CameraSample& s) {
+	unsigned int numMisses = 0;
+	ForEachInView(s, 1.0f, [&](unsigned int region, float) {
+		++m_Stats.numNeeded;
+		if (m_listState[region] != REGION_LOADED) {
+			++numMisses;
+		} else if (!m_listIsUsed[region]) {
+			m_listIsUsed[region] = true;
+			++m_Stats.numUsed;
+		}
+	});
+	m_Stats.numMisses += numMisses;
+
+	return numMisses;
+}
+
+PrefetchStats RegionPrefetcher::GetStats() {
+	return m_Stats;
+}
+
+// Write path to fn, a sample per line. Returns false if it couldn't.
+bool SaveCameraPath(const char* fn, const std::vector<CameraSample>& path) {
+	std::ofstream file(fn);
+	if (!file) return false;
+
+	file << "# t eye.x eye.y eye.z look.x look.y look.z\n";
+	file.precision(9);
+	for (auto& s : path) {
+		file << s.t << " " << s.eye.x << " " << s.eye.y << " " << s.eye.z << " " << s.look.x << " " << s.look.y << " " << s.look.z << "\n";
+	}
+
+	return (bool)file;
+}
+
+// Read a path written by SaveCameraPath(). Returns false if fn couldn't be read.
+bool LoadCameraPath(const char* fn, std::vector<CameraSample>& path) {
+	std::ifstream file(fn);
+	if (!file) return false;
+
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#') continue;
+
+		std::istringstream in(line);
+		CameraSample s;
+		if (in >> s.t >> s.eye.x >> s.eye.y >> s.eye.z >> s.look.x >> s.look.y >> s.look.z) path.push_back(s);
+	}
+
+	return true;
+}
+
+// Build one of the paths prefetching is measured on. See TerrainPrefetch.h.
+void BuildCameraPath(unsigned int kind, float size, double seconds, double fps, std::vector<CameraSample>& path) {
+	std::mt19937 rng(1234 + kind);
+	std::uniform_real_distribution<float> random(-1.0f, 1.0f);
+	float x = 0.5f * size, y = 0.5f * size, yaw = 0.0f, pitch = -0.1f;
+	float turnRate = 0.0f;
+	double tNextChange = 0.0;
+	bool isMoving = true;
+
+	unsigned int num = (unsigned int)(seconds * fps);
+	for (unsigned int i = 0; i < num; ++i) {
+		double t = i / fps;
+		float dt = (float)(1.0 / fps);
+		float speed = 0.0f;
+
+		switch (kind) {
+			case 0:
+				// a fast fly-through, turning in long curves.
+				speed = 200.0f;
+				turnRate = 0.5f * sinf(0.35f * (float)t) + 0.25f * sinf(1.1f * (float)t);
+				break;
+			case 1:
+				// walking with the keys held down, stopping now and then, and glancing around with the mouse.
+				if (t >= tNextChange) {
+					isMoving = random(rng) > -0.6f;
+					turnRate = random(rng) > 0.0f ? 1.5f * random(rng) : 0.0f;
+					tNextChange = t + 1.0 + 1.5 * (random(rng) + 1.0);
+				}
+				speed = isMoving ? 30.0f : 0.0f;
+				break;
+			default:
+				// turning on the spot to look around, then heading off somewhere new.
+				if (t >= tNextChange) {
+					isMoving = !isMoving;
+					turnRate = isMoving ? 0.0f : (random(rng) > 0.0f ? 1.2f : -1.2f);
+					tNextChange = t + (isMoving ? 2.0 : 3.0);
+				}
+				speed = isMoving ? 150.0f : 0.0f;
+				break;
+		}
+
+		// steer back towards the middle of the world before reaching the edge.
+		float cx = 0.5f * size - x, cy = 0.5f * size - y;
+		if (speed > 0.0f && cx * cx + cy * cy > 0.35f * 0.35f * size * size) {
+			float turn = WrapAngle(atan2f(cy, cx) - yaw);
+			turnRate = turn > 0.0f ? 1.0f : -1.0f;
+		}
+
+		yaw = WrapAngle(yaw + turnRate * dt);
+		x += speed * cosf(yaw) * dt;
+		y += speed * sinf(yaw) * dt;
+		path.push_back({ t, XMFLOAT3(x, y, 60.0f), CalcLook(yaw, pitch) });
+	}
+}
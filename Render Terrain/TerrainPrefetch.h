@@ -0,0 +1,161 @@
+/*
+TerrainPrefetch.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Works out which regions of streamed terrain data to load before the renderer needs them, from
+				where the camera is going. A CameraPredictor fits the camera's velocity and turn rate to its recent
+				states and forecasts where it will be and what it will see. A RegionPrefetcher turns the forecasts
+				into requests for heightmap and material regions, most urgent first, cancels requests the camera has
+				turned away from, and evicts what it won't need. Only depends on DirectXMath, so paths can be
+				replayed and measured without a Direct3D 12 device.
+
+Usage:			- The world is split into numX x numY square regions of regionSize world units, starting at the world
+					origin. Each region has a heightmap and a material layer, loaded separately. Region r of layer l
+					is numbered l * numX * numY + r.
+				- Create a RegionPrefetcher with the layout and a PrefetchParams, ie GetDefaultPrefetchParams().
+					With isPredictive false it only asks for what is needed where the camera is now, for comparison.
+				- Call Update() once per frame with the camera's state. It returns the regions to request with their
+					priorities and the requests to cancel. Pass them to a TileStreamer per layer, ie
+					TileStreamer::Request() and TileStreamer::Cancel().
+				- Call SetLoaded() for each region the streamer hands over. It returns the regions evicted to stay
+					within PrefetchParams::maxResident, whose memory can be reused.
+				- Call CheckNeeded() with the camera's state when drawing. It counts the regions in view that
+					weren't loaded in time, for the miss rate, and which loaded regions were used, for the accuracy.
+				- SaveCameraPath() and LoadCameraPath() write and read a recorded path, one CameraSample per line.
+					The Simulation records one when asked. See Simulation::SetPathRecording().
+				- BuildCameraPath() makes paths to measure against without a recording. The TerrainPrefetch tests and
+					benchmark in Render Terrain Tests replay them against a loader of fixed latency and bandwidth, with
+					and without prediction, and measure the miss rate and accuracy of each.
+
+Future Work:	- Learn the delay from request to upload from the streamer instead of taking it as a parameter.
+				- Weight material regions by the screen area they cover rather than distance alone.
+*/
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+using namespace DirectX;
+
+enum PrefetchLayer { PREFETCH_LAYER_HEIGHTMAP = 0, PREFETCH_LAYER_MATERIAL, NUM_PREFETCH_LAYERS };
+
+static const double PREFETCH_HISTORY_SECONDS = 0.5;		// camera states the velocity and turn rate are fitted to.
+
+// The camera's state at one moment.
+struct CameraSample {
+	double		t;		// seconds.
+	XMFLOAT3	eye;
+	XMFLOAT3	look;	// normalized.
+};
+
+// How far ahead and around the camera a RegionPrefetcher looks.
+struct PrefetchParams {
+	float			radius[NUM_PREFETCH_LAYERS];	// world units from the camera a layer's regions are needed within.
+	float			priority[NUM_PREFETCH_LAYERS];	// how much a layer's requests are weighted.
+	float			nearRadius;						// world units within which regions are needed whichever way the camera looks.
+	float			halfAngle;						// half the view cone's angle, in radians. About half the horizontal field of view.
+	float			lookAhead;						// seconds ahead the camera's path is forecast.
+	unsigned int	numHorizons;					// forecasts taken along the look ahead, not counting now.
+	unsigned int	maxInFlight;					// requests outstanding at most.
+	unsigned int	maxResident;					// regions loaded at most, over every layer.
+};
+
+// A region to load, and how urgently. Higher priorities are more urgent.
+struct PrefetchRequest {
+	unsigned int	region;
+	float			priority;
+};
+
+// What a RegionPrefetcher has done so far.
+struct PrefetchStats {
+	unsigned long long	numNeeded;		// regions CheckNeeded() found in view, summed over every call.
+	unsigned long long	numMisses;		// of those, regions that weren't loaded.
+	unsigned long long	numRequested;
+	unsigned long long	numCancelled;
+	unsigned long long	numLoaded;
+	unsigned long long	numUsed;		// loaded regions needed at least once before being evicted.
+	unsigned long long	numEvicted;
+	unsigned int		numResident;
+	unsigned int		numInFlight;
+};
+
+// Returns the PrefetchParams the Scene streams with, for regions of regionSize world units.
+PrefetchParams GetDefaultPrefetchParams(float regionSize);
+
+class CameraPredictor {
+public:
+	CameraPredictor(double history = PREFETCH_HISTORY_SECONDS);
+
+	// Add the camera's state. Samples must come in order of time.
+	void AddSample(const CameraSample& s);
+	// Forecast the camera's state dt seconds after the last sample.
+	CameraSample Predict(double dt) const;
+	// Forget every sample, ie after the camera jumps.
+	void Reset() { m_listSamples.clear(); m_vVelocity = XMFLOAT3(0.0f, 0.0f, 0.0f); m_yawRate = 0.0f; m_pitchRate = 0.0f; }
+
+	XMFLOAT3 GetVelocity() const { return m_vVelocity; }
+	float GetYawRate() const { return m_yawRate; }
+	float GetPitchRate() const { return m_pitchRate; }
+
+private:
+	// Fit the velocity and turn rates to the samples by least squares.
+	void Fit();
+
+	double						m_history;
+	std::vector<CameraSample>	m_listSamples;		// oldest first.
+	XMFLOAT3					m_vVelocity;		// world units a second.
+	float						m_yawRate;			// radians a second, about z.
+	float						m_pitchRate;
+};
+
+class RegionPrefetcher {
+public:
+	RegionPrefetcher(unsigned int numX, unsigned int numY, float regionSize, const PrefetchParams& params, bool isPredictive = true);
+
+	// Add the camera's state and work out what to load. Appends the regions to request to requests, most urgent first,
+	// and the requests to drop to cancels.
+	void Update(const CameraSample& s, std::vector<PrefetchRequest>& requests, std::vector<unsigned int>& cancels);
+	// Mark region as loaded. Appends the regions evicted to make room to evicted.
+	void SetLoaded(unsigned int region, std::vector<unsigned int>& evicted);
+	// Mark a request as failed, so it's asked for again.
+	void SetFailed(unsigned int region);
+	// Count the regions the renderer needs to draw from s and which of them are loaded. Returns the number missing.
+	unsigned int CheckNeeded(const CameraSample& s);
+
+	bool IsLoaded(unsigned int region) { return m_listState[region] == REGION_LOADED; }
+	unsigned int GetNumRegions() { return m_numRegions * NUM_PREFETCH_LAYERS; }
+	const CameraPredictor& GetPredictor() { return m_Predictor; }
+	PrefetchStats GetStats();
+
+private:
+	enum RegionState { REGION_EMPTY = 0, REGION_REQUESTED, REGION_LOADED };
+
+	// Call f(region, priority) for every region of every layer the camera at s needs. urgency scales the priorities.
+	template <typename F> void ForEachInView(const CameraSample& s, float urgency, F f);
+
+	unsigned int				m_numX;
+	unsigned int				m_numY;
+	unsigned int				m_numRegions;		// per layer.
+	float						m_regionSize;
+	PrefetchParams				m_Params;
+	bool						m_isPredictive;
+	CameraPredictor				m_Predictor;
+	unsigned long long			m_numUpdates;
+	std::vector<unsigned char>	m_listState;		// per region, a RegionState.
+	std::vector<float>			m_listPriority;		// per region, its priority at the last update.
+	std::vector<unsigned long long>	m_listLastWanted;	// per region, the last update it was wanted by.
+	std::vector<bool>			m_listIsUsed;		// per region, needed since it was loaded.
+	std::vector<unsigned int>	m_listWanted;		// regions wanted at the last update.
+	PrefetchStats				m_Stats;
+};
+
+// Write path to fn, a sample per line. Returns false if it couldn't.
+bool SaveCameraPath(const char* fn, const std::vector<CameraSample>& path);
+// Read a path written by SaveCameraPath(). Returns false if fn couldn't be read.
+bool LoadCameraPath(const char* fn, std::vector<CameraSample>& path);
+// Build one of the paths prefetching is measured on, of seconds at fps samples a second, over a world of size
+// world units square. 0 flies fast through the world turning in long curves, 1 walks with the keys at SIM_MOVE_SPEED
+// looking around with the mouse, 2 turns on the spot and moves off in a new direction now and then.
+void BuildCameraPath(unsigned int kind, float size, double seconds, double fps, std::vector<CameraSample>& path);
@@ -0,0 +1,131 @@
+/*
+TerrainSurface.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	CPU copy of the surface RenderTerrainTessDS.hlsl produces.
+*/
+#include "TerrainSurface.h"
+#include "Common.h"
+#include <cmath>
+
+TerrainSurface::TerrainSurface(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale,
+	const unsigned char* displacementmap, unsigned int wDisplacementMap, unsigned int hDisplacementMap) : m_dataHeightMap(heightmap),
+	m_dataDisplacementMap(displacementmap), m_wHeightMap(wHeightMap), m_hHeightMap(hHeightMap), m_wDisplacementMap(wDisplacementMap),
+	m_hDisplacementMap(hDisplacementMap), m_scale(scale), m_vOrigin(0.0f, 0.0f) {
+	if (!m_wDisplacementMap || !m_hDisplacementMap) m_dataDisplacementMap = nullptr;
+}
+
+// Returns the heightmap at texture coordinates (u, v) as hmsampler returns it: bilinear, clamped at the edges, in [0, 1].
+float TerrainSurface::SampleHeightMap(float u, float v) const {
+	// texel centres are at half texels, so texel i covers [i, i + 1) and is sampled exactly at i + 0.5.
+	float tx = u * m_wHeightMap - 0.5f;
+	float ty = v * m_hHeightMap - 0.5f;
+	float x1 = floorf(tx);
+	float y1 = floorf(ty);
+	float dx = tx - x1;
+	float dy = ty - y1;
+
+	int maxX = (int)m_wHeightMap - 1;
+	int maxY = (int)m_hHeightMap - 1;
+	int ix1 = (int)x1 < 0 ? 0 : (int)x1 > maxX ? maxX : (int)x1;
+	int ix2 = (int)x1 + 1 < 0 ? 0 : (int)x1 + 1 > maxX ? maxX : (int)x1 + 1;
+	int iy1 = (int)y1 < 0 ? 0 : (int)y1 > maxY ? maxY : (int)y1;
+	int iy2 = (int)y1 + 1 < 0 ? 0 : (int)y1 + 1 > maxY ? maxY : (int)y1 + 1;
+
+	float a = (float)m_dataHeightMap[(iy1 * m_wHeightMap + ix1) * 4] / 255.0f;
+	float b = (float)m_dataHeightMap[(iy1 * m_wHeightMap + ix2) * 4] / 255.0f;
+	float c = (float)m_dataHeightMap[(iy2 * m_wHeightMap + ix1) * 4] / 255.0f;
+	float d = (float)m_dataHeightMap[(iy2 * m_wHeightMap + ix2) * 4] / 255.0f;
+
+	return bilerp(a, b, c, d, dx, dy);
+}
+
+// Returns the displacement map at texture coordinates (u, v) as displacementsampler returns it: bilinear, wrapped, in [0, 1].
+float TerrainSurface::SampleDisplacementMap(float u, float v) const {
+	if (!m_dataDisplacementMap) return 0.5f;
+
+	float tx = u * m_wDisplacementMap - 0.5f;
+	float ty = v * m_hDisplacementMap - 0.5f;
+	float x1 = floorf(tx);
+	float y1 = floorf(ty);
+	float dx = tx - x1;
+	float dy = ty - y1;
+
+	// wrap into [0, size). The result of % keeps the sign of the dividend, so negative coordinates need moving up.
+	int w = (int)m_wDisplacementMap;
+	int h = (int)m_hDisplacementMap;
+	int ix1 = (int)x1 % w;
+	ix1 = ix1 < 0 ? ix1 + w : ix1;
+	int ix2 = ix1 + 1 == w ? 0 : ix1 + 1;
+	int iy1 = (int)y1 % h;
+	iy1 = iy1 < 0 ? iy1 + h : iy1;
+	int iy2 = iy1 + 1 == h ? 0 : iy1 + 1;
+
+	float a = (float)m_dataDisplacementMap[(iy1 * w + ix1) * 4 + 3] / 255.0f;
+	float b = (float)m_dataDisplacementMap[(iy1 * w + ix2) * 4 + 3] / 255.0f;
+	float c = (float)m_dataDisplacementMap[(iy2 * w + ix1) * 4 + 3] / 255.0f;
+	float d = (float)m_dataDisplacementMap[(iy2 * w + ix2) * 4 + 3] / 255.0f;
+
+	return bilerp(a, b, c, d, dx, dy);
+}
+
+// Returns the size of a displacement map texel in world units, along whichever side has more texels.
+float TerrainSurface::GetDisplacementTexelSize() const {
+	// the displacement map repeats every 32 world units.
+	unsigned int size = m_wDisplacementMap > m_hDisplacementMap ? m_wDisplacementMap : m_hDisplacementMap;
+	return size ? 32.0f / size : 32.0f;
+}
+
+// Returns the height of the surface at (x, y) before displacement.
+float TerrainSurface::GetHeight(float x, float y) const {
+	// the domain shader divides both coordinates by the width.
+	return SampleHeightMap((x - m_vOrigin.x) / m_wHeightMap, (y - m_vOrigin.y) / m_wHeightMap) * m_scale;
+}
+
+// Returns the unit normal the domain shader estimates at (x, y).
+XMFLOAT3 TerrainSurface::EstimateNormal(float x, float y) const {
+	// same as estimateNormal(): the texture coordinates are both divided by the width, the offsets by the width and depth.
+	float u = (x - m_vOrigin.x) / m_wHeightMap;
+	float v = (y - m_vOrigin.y) / m_wHeightMap;
+	float du = 0.3f / m_wHeightMap;
+	float dv = 0.3f / m_hHeightMap;
+
+	float zb = SampleHeightMap(u, v - dv) * m_scale;
+	float zc = SampleHeightMap(u + du, v - dv) * m_scale;
+	float zd = SampleHeightMap(u + du, v) * m_scale;
+	float ze = SampleHeightMap(u + du, v + dv) * m_scale;
+	float zf = SampleHeightMap(u, v + dv) * m_scale;
+	float zg = SampleHeightMap(u - du, v + dv) * m_scale;
+	float zh = SampleHeightMap(u - du, v) * m_scale;
+	float zi = SampleHeightMap(u - du, v - dv) * m_scale;
+
+	float nx = zg + 2 * zh + zi - zc - 2 * zd - ze;
+	float ny = 2 * zb + zc + zi - ze - 2 * zf - zg;
+	float nz = 8.0f;
+	float len = sqrtf(nx * nx + ny * ny + nz * nz);
+
+	return XMFLOAT3(nx / len, ny / len, nz / len);
+}
+
+// Returns the displacement the domain shader applies along the normal at (x, y), [-SURFACE_MAX_DISPLACEMENT, SURFACE_MAX_DISPLACEMENT].
+float TerrainSurface::GetDisplacement(float x, float y) const {
+	return SURFACE_MAX_DISPLACEMENT * (2.0f * SampleDisplacementMap(x / 32.0f, y / 32.0f) - 1.0f);
+}
+
+// Returns where the domain shader moves the point on the surface at (x, y).
+XMFLOAT3 TerrainSurface::GetDisplacedPosition(float x, float y) const {
+	float z = GetHeight(x, y);
+	if (!m_dataDisplacementMap) return XMFLOAT3(x, y, z);
+
+	XMFLOAT3 norm = EstimateNormal(x, y);
+	float d = GetDisplacement(x, y);
+
+	return XMFLOAT3(x + norm.x * d, y + norm.y * d, z + norm.z * d);
+}
+
+// Returns the height of the displaced surface at (x, y), ignoring how far displacement moves the point sideways.
+float TerrainSurface::GetDisplacedHeight(float x, float y) const {
+	return GetDisplacedPosition(x, y).z;
+}
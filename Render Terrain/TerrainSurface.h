@@ -0,0 +1,76 @@
+/*
+TerrainSurface.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	CPU copy of the surface RenderTerrainTessDS.hlsl produces. The heightmap is sampled the way the
+				GPU's linear clamp sampler does, the normal is estimated from it with the same Sobel filter, and
+				the displacement map, sampled with wrapping, pushes the point out along that normal. Only depends
+				on DirectXMath, so the surface can be queried without a Direct3D 12 device.
+
+Usage:			- Requires the heightmap and displacement map data, 4 bytes per texel, which must outlive the
+					TerrainSurface. The height is in the first byte, scaled by scale / 255. The displacement is in the fourth.
+				- World x and y are in heightmap texels, so the heightmap covers [0, width] x [0, depth]. Texel centres
+					are at half texels, as on the GPU.
+				- GetHeight() returns the height before displacement. GetDisplacedPosition() returns where the domain
+					shader moves the point at (x, y) on that surface.
+				- GetDisplacedHeight() returns the height of the displaced surface at (x, y), treating the displacement
+					as if it only moved the point up or down. It moves the point sideways by at most half a world unit.
+				- A TerrainSurface without a displacement map has no displacement.
+				- For a tile of a TerrainWorld, call SetOrigin() with the tile's place in the world. x and y are then world
+					coordinates. The heightmap is sampled relative to the origin and the displacement map isn't, as in the shaders.
+
+Future Work:	- Match the GPU's 8 bit filtering weights rather than interpolating at full precision.
+*/
+#pragma once
+
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+// the displacement moves the surface at most this far along the normal. Matches RenderTerrainTessDS.hlsl.
+static const float SURFACE_MAX_DISPLACEMENT = 0.5f;
+
+class TerrainSurface {
+public:
+	TerrainSurface(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, float scale,
+		const unsigned char* displacementmap, unsigned int wDisplacementMap, unsigned int hDisplacementMap);
+
+	// Returns the heightmap at texture coordinates (u, v) as hmsampler returns it: bilinear, clamped at the edges, in [0, 1].
+	float SampleHeightMap(float u, float v) const;
+	// Returns the displacement map at texture coordinates (u, v) as displacementsampler returns it: bilinear, wrapped, in [0, 1].
+	float SampleDisplacementMap(float u, float v) const;
+	// Returns the height of the surface at (x, y) before displacement.
+	float GetHeight(float x, float y) const;
+	// Returns the unit normal the domain shader estimates at (x, y).
+	XMFLOAT3 EstimateNormal(float x, float y) const;
+	// Returns where the domain shader moves the point on the surface at (x, y).
+	XMFLOAT3 GetDisplacedPosition(float x, float y) const;
+	// Returns the height of the displaced surface at (x, y), ignoring how far displacement moves the point sideways.
+	float GetDisplacedHeight(float x, float y) const;
+	// Place the first texel of the heightmap at world (x, y) rather than (0, 0).
+	void SetOrigin(float x, float y) { m_vOrigin = XMFLOAT2(x, y); }
+	XMFLOAT2 GetOrigin() const { return m_vOrigin; }
+
+	const unsigned char* GetHeightMap() const { return m_dataHeightMap; }
+	unsigned int GetWidth() const { return m_wHeightMap; }
+	unsigned int GetDepth() const { return m_hHeightMap; }
+	float GetScale() const { return m_scale; }
+	bool HasDisplacement() const { return m_dataDisplacementMap != nullptr; }
+	// Returns the size of a displacement map texel in world units, along whichever side has more texels.
+	float GetDisplacementTexelSize() const;
+
+private:
+	// Returns the displacement the domain shader applies along the normal at (x, y), [-SURFACE_MAX_DISPLACEMENT, SURFACE_MAX_DISPLACEMENT].
+	float GetDisplacement(float x, float y) const;
+
+	const unsigned char*	m_dataHeightMap;
+	const unsigned char*	m_dataDisplacementMap;
+	unsigned int			m_wHeightMap;
+	unsigned int			m_hHeightMap;
+	unsigned int			m_wDisplacementMap;
+	unsigned int			m_hDisplacementMap;
+	float					m_scale;
+	XMFLOAT2				m_vOrigin;	// world position of the heightmap's corner.
+};
@@ -0,0 +1,229 @@
+/*
+TerrainTiles.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	The layout, seams, and culling of a world made of a grid of terrain tiles.
+*/
+#include "TerrainTiles.h"
+#include "BoundingVolume.h"
+#include "Common.h"
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+
+TerrainTileGrid::TerrainTileGrid(unsigned int numX, unsigned int numY, unsigned int wHeightMap, unsigned int hHeightMap) : m_numX(numX),
+	m_numY(numY), m_wHeightMap(wHeightMap), m_hHeightMap(hHeightMap) {
+	// the mesh's last control point is a grid step short of the edge of the heightmap. See CalcTerrainMeshInfo().
+	m_strideX = (m_wHeightMap / TERRAIN_GRID_SPACING - 1) * TERRAIN_GRID_SPACING;
+	m_strideY = (m_hHeightMap / TERRAIN_GRID_SPACING - 1) * TERRAIN_GRID_SPACING;
+
+	m_listMin.resize(GetNumTiles());
+	m_listMax.resize(GetNumTiles());
+	for (unsigned int t = 0; t < GetNumTiles(); ++t) {
+		XMFLOAT2 origin = GetOrigin(t);
+		m_listMin[t] = XMFLOAT3(origin.x, origin.y, 0.0f);
+		m_listMax[t] = XMFLOAT3(origin.x + (float)m_wHeightMap, origin.y + (float)m_hHeightMap, 0.0f);
+	}
+}
+
+// Returns the world position of the first control point of tile t.
+XMFLOAT2 TerrainTileGrid::GetOrigin(unsigned int t) const {
+	return XMFLOAT2((float)(t % m_numX * m_strideX), (float)(t / m_numX * m_strideY));
+}
+
+// Returns the TERRAIN_SKIRT_* bits of tile t's sides that lie along the edge of the world.
+unsigned int TerrainTileGrid::GetExposedSkirts(unsigned int t) const {
+	unsigned int x = t % m_numX;
+	unsigned int y = t / m_numX;
+	unsigned int skirts = TERRAIN_SKIRT_ALL;
+	if (x > 0) skirts &= ~TERRAIN_SKIRT_X0;
+	if (x + 1 < m_numX) skirts &= ~TERRAIN_SKIRT_X1;
+	if (y > 0) skirts &= ~TERRAIN_SKIRT_Y0;
+	if (y + 1 < m_numY) skirts &= ~TERRAIN_SKIRT_Y1;
+
+	return skirts;
+}
+
+// Returns the tile whose mesh covers world (x, y), or -1 if none does.
+int TerrainTileGrid::FindTile(float x, float y) const {
+	if (x < 0.0f || y < 0.0f) return -1;
+
+	unsigned int tx = (unsigned int)(x / (float)m_strideX);
+	unsigned int ty = (unsigned int)(y / (float)m_strideY);
+	// the far edge of the world belongs to the last tile.
+	if (tx == m_numX && x <= (float)(m_numX * m_strideX)) --tx;
+	if (ty == m_numY && y <= (float)(m_numY * m_strideY)) --ty;
+	if (tx >= m_numX || ty >= m_numY) return -1;
+
+	return (int)(ty * m_numX + tx);
+}
+
+// Set the box bounding tile t, in the tile's own coordinates.
+void TerrainTileGrid::SetBounds(unsigned int t, XMFLOAT3 min, XMFLOAT3 max) {
+	XMFLOAT2 origin = GetOrigin(t);
+	m_listMin[t] = XMFLOAT3(min.x + origin.x, min.y + origin.y, min.z);
+	m_listMax[t] = XMFLOAT3(max.x + origin.x, max.y + origin.y, max.z);
+}
+
+// Returns the box bounding every tile in world coordinates.
+void TerrainTileGrid::GetWorldBounds(XMFLOAT3& min, XMFLOAT3& max) const {
+	min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (unsigned int t = 0; t < GetNumTiles(); ++t) {
+		min = XMFLOAT3(fminf(min.x, m_listMin[t].x), fminf(min.y, m_listMin[t].y), fminf(min.z, m_listMin[t].z));
+		max = XMFLOAT3(fmaxf(max.x, m_listMax[t].x), fmaxf(max.y, m_listMax[t].y), fmaxf(max.z, m_listMax[t].z));
+	}
+}
+
+// Write the tiles inside any of numFrustums frustums to visible, nearest to eye first. Returns how many there are.
+// planes holds numPlanes planes for each frustum, one frustum after the other.
+unsigned int TerrainTileGrid::Cull(const XMFLOAT4* planes, unsigned int numPlanes, unsigned int numFrustums, XMFLOAT3 eye,
+	unsigned int* visible) const {
+	// there are rarely more than a few dozen tiles, so an insertion sort does.
+	std::vector<float> listDistance;
+	listDistance.reserve(GetNumTiles());
+	unsigned int num = 0;
+	for (unsigned int t = 0; t < GetNumTiles(); ++t) {
+		bool isVisible = false;
+		for (unsigned int f = 0; f < numFrustums && !isVisible; ++f) {
+			isVisible = AABBIntersectsPlanes(m_listMin[t], m_listMax[t], &planes[f * numPlanes], numPlanes);
+		}
+		if (!isVisible) continue;
+
+		// squared distance from the eye to the nearest point of the box, which is 0 inside it.
+		float dx = fmaxf(fmaxf(m_listMin[t].x - eye.x, eye.x - m_listMax[t].x), 0.0f);
+		float dy = fmaxf(fmaxf(m_listMin[t].y - eye.y, eye.y - m_listMax[t].y), 0.0f);
+		float dz = fmaxf(fmaxf(m_listMin[t].z - eye.z, eye.z - m_listMax[t].z), 0.0f);
+		float d = dx * dx + dy * dy + dz * dz;
+
+		unsigned int i = num++;
+		listDistance.push_back(d);
+		for (; i > 0 && listDistance[i - 1] > d; --i) {
+			listDistance[i] = listDistance[i - 1];
+			visible[i] = visible[i - 1];
+		}
+		listDistance[i] = d;
+		visible[i] = t;
+	}
+
+	return num;
+}
+
+// Set a heightmap texel to height, counting it if it changed.
+static void SetTexel(unsigned char& texel, unsigned char height, TileEdgeStats& stats) {
+	if (texel == height) return;
+	texel = height;
+	++stats.numTexelsChanged;
+}
+
+// Match the seam between tiles a and b, where b follows a along x if isAlongX, otherwise along y.
+// stride is the texel of a's last control point across the seam, which is b's first.
+static void MatchTileEdge(unsigned char* a, unsigned char* b, unsigned int wHeightMap, unsigned int hHeightMap, unsigned int stride,
+	bool isAlongX, unsigned int band, TileEdgeStats& stats) {
+	unsigned int numAlong = isAlongX ? hHeightMap : wHeightMap;
+	unsigned int numAcross = isAlongX ? wHeightMap : hHeightMap;
+	size_t stepAlong = isAlongX ? (size_t)wHeightMap * 4 : 4;
+	size_t stepAcross = isAlongX ? 4 : (size_t)wHeightMap * 4;
+
+	for (unsigned int i = 0; i < numAlong; ++i) {
+		unsigned char* lineA = &a[i * stepAlong];
+		unsigned char* lineB = &b[i * stepAlong];
+		int ha = lineA[stride * stepAcross];
+		int hb = lineB[0];
+		unsigned int step = (unsigned int)abs(ha - hb);
+		stats.maxStep = step > stats.maxStep ? step : stats.maxStep;
+		unsigned char seam = (unsigned char)((ha + hb + 1) / 2);
+
+		// the shaders sample the heightmap bilinearly and estimate normals from up to a texel and a half away.
+		// Flattening the seam over the texels read either side of it gives both tiles the same heights and normals there.
+		for (unsigned int j = stride - 2; j < numAcross; ++j) {
+			SetTexel(lineA[j * stepAcross], seam, stats);
+		}
+		for (unsigned int j = 0; j < 3; ++j) {
+			SetTexel(lineB[j * stepAcross], seam, stats);
+		}
+
+		// then ease each side back into its own heights.
+		for (unsigned int k = 1; k <= band; ++k) {
+			float t = (float)k / (float)(band + 1);
+			unsigned char& texelA = lineA[(stride - 2 - k) * stepAcross];
+			unsigned char& texelB = lineB[(2 + k) * stepAcross];
+			SetTexel(texelA, (unsigned char)floorf(lerp((float)seam, (float)texelA, t) + 0.5f), stats);
+			SetTexel(texelB, (unsigned char)floorf(lerp((float)seam, (float)texelB, t) + 0.5f), stats);
+		}
+	}
+	++stats.numEdges;
+}
+
+// Make the heightmaps of neighbouring tiles meet. heightmaps holds one per tile, 4 bytes per texel with the height in the first.
+// band texels either side of each seam are blended towards it.
+TileEdgeStats MatchTileEdges(unsigned char** heightmaps, const TerrainTileGrid& grid, unsigned int band) {
+	TileEdgeStats stats = {};
+	unsigned int numX = grid.GetNumTilesX();
+	unsigned int numY = grid.GetNumTilesY();
+	unsigned int strideX = (unsigned int)grid.GetStrideX();
+	unsigned int strideY = (unsigned int)grid.GetStrideY();
+
+	// keep the bands of a tile's two seams apart.
+	unsigned int stride = strideX < strideY ? strideX : strideY;
+	unsigned int maxBand = stride / 2 > 3 ? stride / 2 - 3 : 0;
+	band = band < maxBand ? band : maxBand;
+
+	// the seams along x first. The seams along y then flatten the corners the same way in every tile meeting there,
+	// as the texels they start from already match.
+	for (unsigned int y = 0; y < numY; ++y) {
+		for (unsigned int x = 0; x + 1 < numX; ++x) {
+			MatchTileEdge(heightmaps[y * numX + x], heightmaps[y * numX + x + 1], grid.GetWidth(), grid.GetDepth(), strideX, true, band, stats);
+		}
+	}
+	for (unsigned int y = 0; y + 1 < numY; ++y) {
+		for (unsigned int x = 0; x < numX; ++x) {
+			MatchTileEdge(heightmaps[y * numX + x], heightmaps[(y + 1) * numX + x], grid.GetWidth(), grid.GetDepth(), strideY, false, band, stats);
+		}
+	}
+
+	return stats;
+}
+
+// Give the control points tiles a and b share the larger of their two errors. b is the next tile along x if isAlongX,
+// otherwise along y. Returns the number of control points whose error changed.
+unsigned int MatchTileEdgeErrors(Vertex* a, Vertex* b, const TerrainMeshInfo& info, bool isAlongX) {
+	int num = isAlongX ? info.numY : info.numX;
+	unsigned int numChanged = 0;
+	for (int i = 0; i < num; ++i) {
+		// a's last column or row against b's first.
+		Vertex& va = isAlongX ? a[i * info.numX + info.numX - 1] : a[(info.numY - 1) * info.numX + i];
+		Vertex& vb = isAlongX ? b[i * info.numX] : b[i];
+		float error = fmaxf(va.error, vb.error);
+		numChanged += (va.error != error) + (vb.error != error);
+		va.error = error;
+		vb.error = error;
+	}
+
+	return numChanged;
+}
+
+// Returns brush, in tile t's own coordinates, with its radius shrunk so that it doesn't change any of the texels
+// MatchTileEdges() set along the tile's seams. The radius is 0 if the centre is too close to a seam.
+TerrainBrush ClampTileBrush(const TerrainBrush& brush, const TerrainTileGrid& grid, unsigned int t) {
+	TerrainBrush clamped = brush;
+	unsigned int x = t % grid.GetNumTilesX();
+	unsigned int y = t / grid.GetNumTilesX();
+	unsigned int strideX = (unsigned int)grid.GetStrideX();
+	unsigned int strideY = (unsigned int)grid.GetStrideY();
+
+	// a stroke only changes texels whose centres are closer than its radius. MatchTileEdge() sets the texels from 2 before
+	// a tile's last control point to the edge of its heightmap, and the first 3 of the next tile. Texel (x, y) has its centre
+	// at world (x + 0.5, (y + 0.5) * w / h).
+	float scaleY = (float)grid.GetWidth() / (float)grid.GetDepth();
+	float r = clamped.radius;
+	if (x + 1 < grid.GetNumTilesX()) r = fminf(r, (float)(strideX - 2) + 0.5f - brush.x);
+	if (x > 0) r = fminf(r, brush.x - 2.5f);
+	if (y + 1 < grid.GetNumTilesY()) r = fminf(r, ((float)(strideY - 2) + 0.5f) * scaleY - brush.y);
+	if (y > 0) r = fminf(r, brush.y - 2.5f * scaleY);
+	clamped.radius = fmaxf(r, 0.0f);
+
+	return clamped;
+}
@@ -0,0 +1,106 @@
+/*
+TerrainTiles.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	The layout of a world made of a grid of terrain tiles, each with a heightmap of its own.
+				Places the tiles so neighbours share their edge control points, makes the heightmaps and
+				tessellation errors along those edges agree so the seams don't show, and culls the tiles
+				against a frustum. Only depends on DirectXMath, so layouts can be built and checked without
+				a Direct3D 12 device.
+
+Usage:			- Create a TerrainTileGrid with the number of tiles along x and y and the size of their heightmaps,
+					which must all be the same. Tiles are numbered row by row, starting at the world origin.
+				- A tile's mesh ends a grid step short of the edge of its heightmap, so tile (x, y) starts at world
+					(x * GetStrideX(), y * GetStrideY()) and its last column of control points is the next tile's first.
+				- Call MatchTileEdges() on the heightmaps before building the meshes. Along every shared edge it sets
+					the texels both tiles read at the seam to the same heights, and blends band texels either side
+					towards them. Heightmaps must be square, as the shaders sample them.
+				- Call MatchTileEdgeErrors() for each pair of neighbouring meshes once built. The control points
+					they share get the larger error of the two, so both tiles tessellate the seam the same.
+				- Only the sides of the skirt along the edge of the world are needed. GetExposedSkirts() returns
+					them as TERRAIN_SKIRT_* bits.
+				- Call SetBounds() with each tile's bounding box, in its own coordinates, then Cull() returns the
+					tiles in view of any of a set of frustums, eg the shadow cascades, nearest first.
+				- Brush strokes must not change the texels either side of a seam. ClampTileBrush() shrinks a stroke on
+					a tile until it doesn't reach them. The errors of the control points near the stroke are computed again
+					from the tile alone, so call MatchTileEdgeErrors() with its neighbours again afterwards.
+				- The TerrainTiles tests in Render Terrain Tests build a world of synthetic tiles and check the seams meet,
+					and the TerrainTiles benchmark times matching and culling them.
+
+Future Work:	- Allow tiles of different sizes, stitched with transition patches.
+				- Stream tiles in and out around the camera.
+*/
+#pragma once
+
+#include "TerrainMesh.h"
+#include "TerrainEdit.h"
+#include <vector>
+
+// bits for the sides of a tile's skirt, one per side as numbered by Vertex::skirt.
+static const unsigned int TERRAIN_SKIRT_Y0 = 1 << 1;		// side 1, y = 0.
+static const unsigned int TERRAIN_SKIRT_Y1 = 1 << 2;		// side 2, the far edge in y.
+static const unsigned int TERRAIN_SKIRT_X0 = 1 << 3;		// side 3, x = 0.
+static const unsigned int TERRAIN_SKIRT_X1 = 1 << 4;		// side 4, the far edge in x.
+static const unsigned int TERRAIN_SKIRT_ALL = TERRAIN_SKIRT_Y0 | TERRAIN_SKIRT_Y1 | TERRAIN_SKIRT_X0 | TERRAIN_SKIRT_X1;
+// texels either side of a seam blended towards it by default.
+static const unsigned int TERRAIN_TILE_BLEND_BAND = 24;
+
+// What MatchTileEdges() did.
+struct TileEdgeStats {
+	unsigned int		numEdges;			// shared edges matched.
+	unsigned long long	numTexelsChanged;
+	unsigned int		maxStep;			// largest difference between the heights either side of a seam before matching, out of 255.
+};
+
+class TerrainTileGrid {
+public:
+	// numX x numY tiles, each with a wHeightMap x hHeightMap heightmap.
+	TerrainTileGrid(unsigned int numX, unsigned int numY, unsigned int wHeightMap, unsigned int hHeightMap);
+
+	// Returns the world position of the first control point of tile t.
+	XMFLOAT2 GetOrigin(unsigned int t) const;
+	// Returns the TERRAIN_SKIRT_* bits of tile t's sides that lie along the edge of the world.
+	unsigned int GetExposedSkirts(unsigned int t) const;
+	// Returns the tile whose mesh covers world (x, y), or -1 if none does.
+	int FindTile(float x, float y) const;
+	// Set the box bounding tile t, in the tile's own coordinates.
+	void SetBounds(unsigned int t, XMFLOAT3 min, XMFLOAT3 max);
+	// Returns the box bounding tile t in world coordinates.
+	void GetBounds(unsigned int t, XMFLOAT3& min, XMFLOAT3& max) const { min = m_listMin[t]; max = m_listMax[t]; }
+	// Returns the box bounding every tile in world coordinates.
+	void GetWorldBounds(XMFLOAT3& min, XMFLOAT3& max) const;
+	// Write the tiles inside any of numFrustums frustums to visible, nearest to eye first. Returns how many there are.
+	// planes holds numPlanes planes for each frustum, one frustum after the other.
+	unsigned int Cull(const XMFLOAT4* planes, unsigned int numPlanes, unsigned int numFrustums, XMFLOAT3 eye, unsigned int* visible) const;
+
+	unsigned int GetNumTiles() const { return m_numX * m_numY; }
+	unsigned int GetNumTilesX() const { return m_numX; }
+	unsigned int GetNumTilesY() const { return m_numY; }
+	unsigned int GetWidth() const { return m_wHeightMap; }
+	unsigned int GetDepth() const { return m_hHeightMap; }
+	// world units from one tile to the next.
+	float GetStrideX() const { return (float)m_strideX; }
+	float GetStrideY() const { return (float)m_strideY; }
+
+private:
+	unsigned int			m_numX;
+	unsigned int			m_numY;
+	unsigned int			m_wHeightMap;
+	unsigned int			m_hHeightMap;
+	unsigned int			m_strideX;		// in heightmap texels, which are world units.
+	unsigned int			m_strideY;
+	std::vector<XMFLOAT3>	m_listMin;		// world space bounds of each tile.
+	std::vector<XMFLOAT3>	m_listMax;
+};
+
+// Make the heightmaps of neighbouring tiles meet. heightmaps holds one per tile, 4 bytes per texel with the height in the first.
+// band texels either side of each seam are blended towards it.
+TileEdgeStats MatchTileEdges(unsigned char** heightmaps, const TerrainTileGrid& grid, unsigned int band);
+// Give the control points tiles a and b share the larger of their two errors. b is the next tile along x if isAlongX,
+// otherwise along y. Returns the number of control points whose error changed.
+unsigned int MatchTileEdgeErrors(Vertex* a, Vertex* b, const TerrainMeshInfo& info, bool isAlongX);
+// Returns brush, in tile t's own coordinates, with its radius shrunk so that it doesn't change any of the texels
+// MatchTileEdges() set along the tile's seams. The radius is 0 if the centre is too close to a seam.
+TerrainBrush ClampTileBrush(const TerrainBrush& brush, const TerrainTileGrid& grid, unsigned int t);
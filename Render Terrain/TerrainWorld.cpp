@@ -0,0 +1,239 @@
+/*
+TerrainWorld.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for loading and drawing a world made of a grid of terrain tiles.
+*/
+#include "TerrainWorld.h"
+#include <chrono>
+#include <string>
+
+TerrainWorld::TerrainWorld(ResourceManager* rm, TerrainMaterial* mat, unsigned int numX, unsigned int numY, const char** fnHeightMaps,
+	const char* fnDisplacementMap) : m_pMat(mat), m_pResMgr(rm), m_pGrid(nullptr), m_numDraws(0), m_numTilesDrawn(0), m_numIndexBufferBinds(0) {
+	unsigned int numTiles = numX * numY;
+	if (numTiles == 0) {
+		throw GFX_Exception("TerrainWorld::TerrainWorld: a world needs at least one tile.");
+	}
+
+	// every tile shares the index buffers, so every heightmap has to be the same size.
+	std::vector<unsigned int> listFiles(numTiles);
+	std::vector<unsigned char*> listData(numTiles);
+	unsigned int w = 0, h = 0;
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		unsigned int wTile, hTile;
+		listFiles[t] = m_pResMgr->LoadFile(fnHeightMaps[t], hTile, wTile);
+		listData[t] = m_pResMgr->GetFileData(listFiles[t]);
+		if (t == 0) {
+			w = wTile;
+			h = hTile;
+		} else if (wTile != w || hTile != h) {
+			std::string msg = "TerrainWorld::TerrainWorld: " + std::string(fnHeightMaps[t]) + " isn't the same size as " + std::string(fnHeightMaps[0]);
+			throw GFX_Exception(msg.c_str());
+		}
+	}
+	if (numTiles > 1 && w != h) {
+		throw GFX_Exception("TerrainWorld::TerrainWorld: the heightmaps of a world of more than one tile must be square.");
+	}
+
+	m_pGrid = new TerrainTileGrid(numX, numY, w, h);
+
+	// the heightmaps have to meet before the meshes and their errors are built from them.
+	auto tStart = std::chrono::high_resolution_clock::now();
+	TileEdgeStats stats = MatchTileEdges(listData.data(), *m_pGrid, TERRAIN_TILE_BLEND_BAND);
+	double msMatch = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+	// the first tile creates the displacement map and index buffers the rest share.
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		m_listTiles.push_back(new Terrain(m_pResMgr, m_pMat, listFiles[t], w, h, m_pGrid->GetOrigin(t), m_pGrid->GetExposedSkirts(t),
+			fnDisplacementMap, t == 0 ? nullptr : m_listTiles[0]));
+	}
+
+	// each tile's errors came from its own heightmap, so the control points along a seam can still disagree.
+	std::vector<bool> listChanged(numTiles, false);
+	unsigned int numErrorsMatched = 0;
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		unsigned int x = t % numX;
+		unsigned int y = t / numX;
+		unsigned int num;
+		if (x + 1 < numX && (num = m_listTiles[t]->MatchEdgeErrors(m_listTiles[t + 1], true)) > 0) {
+			listChanged[t] = listChanged[t + 1] = true;
+			numErrorsMatched += num;
+		}
+		if (y + 1 < numY && (num = m_listTiles[t]->MatchEdgeErrors(m_listTiles[t + numX], false)) > 0) {
+			listChanged[t] = listChanged[t + numX] = true;
+			numErrorsMatched += num;
+		}
+	}
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		if (listChanged[t]) m_listTiles[t]->UploadVertices();
+	}
+
+	// the world's block bounds are every tile's, moved to where the tile is.
+	unsigned int numBlocks = 0;
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		m_listFirstBlock.push_back(numBlocks);
+		numBlocks += m_listTiles[t]->GetNumBlocks();
+	}
+	m_listBlockBounds.resize(numBlocks);
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		UpdateTileBounds(t);
+	}
+	m_listVisible.resize(numTiles);
+	m_listSeamErrorsChanged.resize(numTiles, false);
+
+	char msg[256];
+	sprintf_s(msg, "Terrain world: %u x %u tiles of %u x %u. %u seams matched in %.2f ms, %llu texels changed, largest step %u. %u control point errors raised.\n",
+		numX, numY, w, h, stats.numEdges, msMatch, stats.numTexelsChanged, stats.maxStep, numErrorsMatched);
+	OutputDebugStringA(msg);
+}
+
+TerrainWorld::~TerrainWorld() {
+	// the tiles share the material, and the first tile's displacement map and index buffers, which the resource manager releases.
+	for (auto t : m_listTiles) {
+		delete t;
+	}
+	m_listTiles.clear();
+
+	delete m_pGrid;
+	m_pGrid = nullptr;
+	delete m_pMat;
+	m_pMat = nullptr;
+	m_pResMgr = nullptr;
+}
+
+// Reserve a descriptor table for every tile and write the tile's SRVs into it.
+void TerrainWorld::CreateResourceViews() {
+	m_listSRVTables.clear();
+	m_listSRVHandles.clear();
+	for (auto t : m_listTiles) {
+		unsigned int iTable = m_pResMgr->ReserveCBVSRVUAVTable(NUM_TERRAIN_SRV_SLOTS);
+		t->CreateResourceViews(iTable);
+		m_listSRVTables.push_back(iTable);
+		m_listSRVHandles.push_back(m_pResMgr->GetCBVSRVUAVHandleGPU(iTable));
+	}
+}
+
+// Draw the tiles inside any of numFrustums frustums of numPlanes planes each, nearest to eye first, except tile skip, if not -1.
+// The terrain constant buffer is bound to root parameter cbvRootIndex, the SRV table to srvRootIndex, and each chunk's base vertex
+// to the root constants at constantsRootIndex. See Terrain::DrawChunks().
+void TerrainWorld::Draw(ID3D12GraphicsCommandList* cmdList, const XMFLOAT4* planes, unsigned int numPlanes, unsigned int numFrustums,
+	XMFLOAT3 eye, unsigned int cbvRootIndex, unsigned int srvRootIndex, unsigned int constantsRootIndex, int skip, unsigned int numInstances) {
+	++m_numDraws;
+	unsigned int numVisible = m_pGrid->Cull(planes, numPlanes, numFrustums, eye, m_listVisible.data());
+	if (numVisible == 0) return;
+
+	cmdList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_4_CONTROL_POINT_PATCHLIST);
+
+	// every tile draws from the same two index buffers. Each tile starts with whichever the last one finished with,
+	// so the index buffer only changes once per tile.
+	D3D12_INDEX_BUFFER_VIEW* viewBound = nullptr;
+	for (unsigned int i = 0; i < numVisible; ++i) {
+		unsigned int t = m_listVisible[i];
+		if ((int)t == skip) continue;
+
+		Terrain* tile = m_listTiles[t];
+		tile->AttachTerrainResources(cmdList, cbvRootIndex);
+		cmdList->SetGraphicsRootDescriptorTable(srvRootIndex, m_listSRVHandles[t]);
+
+		bool isSkirtFirst = viewBound == m_listTiles[0]->GetSkirtIndexView();
+		for (int pass = 0; pass < 2; ++pass) {
+			bool isSkirt = (pass == 0) == isSkirtFirst;
+			D3D12_INDEX_BUFFER_VIEW* view = isSkirt ? m_listTiles[0]->GetSkirtIndexView() : m_listTiles[0]->GetChunkIndexView();
+			if (view != viewBound) {
+				cmdList->IASetIndexBuffer(view);
+				viewBound = view;
+				++m_numIndexBufferBinds;
+			}
+
+			if (isSkirt) {
+				tile->DrawSkirts(cmdList, numInstances);
+			} else {
+				tile->DrawChunks(cmdList, constantsRootIndex, numInstances);
+			}
+		}
+		++m_numTilesDrawn;
+	}
+}
+
+// Apply a single stroke of brush to tile t, in the tile's own coordinates, keeping the seams matched. Render thread only.
+// Returns true if the heightmap changed.
+bool TerrainWorld::Edit(unsigned int t, const TerrainBrush& brush) {
+	if (!m_listTiles[t]->Edit(ClampTileBrush(brush, *m_pGrid, t))) return false;
+
+	// the stroke left the texels along the seams alone, but the errors of the control points near it were computed again from
+	// this tile alone. Those on a seam go back to the larger of theirs and the neighbour's. The tile's own changes are within
+	// the control points it uploads anyway, so only the neighbours need uploading.
+	unsigned int numX = m_pGrid->GetNumTilesX();
+	unsigned int numY = m_pGrid->GetNumTilesY();
+	unsigned int x = t % numX;
+	unsigned int y = t / numX;
+	Terrain* tile = m_listTiles[t];
+	if (x > 0 && m_listTiles[t - 1]->MatchEdgeErrors(tile, true) > 0) m_listSeamErrorsChanged[t - 1] = true;
+	if (x + 1 < numX && tile->MatchEdgeErrors(m_listTiles[t + 1], true) > 0) m_listSeamErrorsChanged[t + 1] = true;
+	if (y > 0 && m_listTiles[t - numX]->MatchEdgeErrors(tile, false) > 0) m_listSeamErrorsChanged[t - numX] = true;
+	if (y + 1 < numY && tile->MatchEdgeErrors(m_listTiles[t + numX], false) > 0) m_listSeamErrorsChanged[t + numX] = true;
+
+	return true;
+}
+
+// Upload the vertices of the tiles whose errors Edit() raised to match a neighbour's since the last call. Render thread only.
+void TerrainWorld::UploadSeamErrors() {
+	for (unsigned int t = 0; t < m_listTiles.size(); ++t) {
+		if (!m_listSeamErrorsChanged[t]) continue;
+		m_listTiles[t]->UploadVertices();
+		m_listSeamErrorsChanged[t] = false;
+	}
+}
+
+// Copy tile t's bounds and block bounds into the world's, after it was edited.
+void TerrainWorld::UpdateTileBounds(unsigned int t) {
+	Terrain* tile = m_listTiles[t];
+	XMFLOAT2 origin = m_pGrid->GetOrigin(t);
+
+	AxisAlignedBoundingBox bb = tile->GetBoundingBox();
+	m_pGrid->SetBounds(t, bb.GetMin(), bb.GetMax());
+
+	AxisAlignedBoundingBox* blocks = tile->GetBlockBounds();
+	for (unsigned int b = 0; b < tile->GetNumBlocks(); ++b) {
+		XMFLOAT3 min = blocks[b].GetMin();
+		XMFLOAT3 max = blocks[b].GetMax();
+		m_listBlockBounds[m_listFirstBlock[t] + b] = AxisAlignedBoundingBox(XMFLOAT3(min.x + origin.x, min.y + origin.y, min.z),
+			XMFLOAT3(max.x + origin.x, max.y + origin.y, max.z));
+	}
+}
+
+// Print how many tiles were drawn and how often the index buffer changed since the last report.
+void TerrainWorld::ReportDrawStats() {
+	if (m_numDraws == 0) return;
+
+	char msg[256];
+	sprintf_s(msg, "Terrain world: %.2f of %u tiles drawn per pass, %.2f index buffer changes per pass.\n",
+		(double)m_numTilesDrawn / (double)m_numDraws, GetNumTiles(), (double)m_numIndexBufferBinds / (double)m_numDraws);
+	OutputDebugStringA(msg);
+
+	m_numDraws = 0;
+	m_numTilesDrawn = 0;
+	m_numIndexBufferBinds = 0;
+}
+
+// Returns a box bounding every tile, in world coordinates.
+AxisAlignedBoundingBox TerrainWorld::GetBoundingBox() {
+	XMFLOAT3 min, max;
+	m_pGrid->GetWorldBounds(min, max);
+
+	return AxisAlignedBoundingBox(min, max);
+}
+
+// Returns the height of the displaced terrain at world (x, y), clamped to the edge of the world.
+float TerrainWorld::GetHeightAtPoint(float x, float y) {
+	float xMax = m_pGrid->GetStrideX() * m_pGrid->GetNumTilesX();
+	float yMax = m_pGrid->GetStrideY() * m_pGrid->GetNumTilesY();
+	x = x < 0.0f ? 0.0f : x > xMax ? xMax : x;
+	y = y < 0.0f ? 0.0f : y > yMax ? yMax : y;
+
+	// each tile's surface takes world positions. See Terrain::GetSurface().
+	int t = m_pGrid->FindTile(x, y);
+	return m_listTiles[t < 0 ? 0 : t]->GetHeightAtPoint(x, y);
+}
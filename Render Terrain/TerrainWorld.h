@@ -0,0 +1,91 @@
+/*
+TerrainWorld.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Class for loading and drawing a world made of a grid of terrain tiles, laid out as per
+				TerrainTiles.h. Every tile shares one material, one displacement map, and one set of index
+				buffers, and is drawn with the same pipelines as a single Terrain.
+
+Usage:			- Proper shutdown is handled by the destructor. The TerrainWorld owns the TerrainMaterial and the tiles.
+				- Is hard-coded for Direct3D 12.
+				- Requires numX x numY heightmaps, row by row, all the same size. The seams between them are matched
+					before the tiles are built, so the heightmaps don't need to meet already.
+				- Tile 0 is at the world origin. GetTile() returns the tiles for anything that only needs one of them,
+					ie culling its patches on the GPU.
+				- Call Edit() rather than the tile's own to apply a brush stroke to a tile. The stroke is kept away from
+					the seams, as per ClampTileBrush(), and the errors along them are matched again. Call UploadEdits() on
+					the tile as usual, then UploadSeamErrors() for the neighbours whose errors changed.
+					Errors along a seam only ever rise, as a neighbour keeps the larger of the two from before.
+				- Call CreateResourceViews() to give every tile a descriptor table of its own, laid out as per
+					TerrainSRVSlot. Anything shared, ie the shadow atlas, has to be written into each of them using
+					GetSRVTableIndex().
+				- Call Draw() with the pipeline and per-frame constants already set. It culls the tiles against a set of
+					frustums and draws the ones left, nearest first, binding each tile's constant buffer and table.
+				- GetBlockBounds() returns the block bounds of every tile in world coordinates, for fitting the shadow
+					cascades. Call UpdateTileBounds() after a tile is edited, holding the tile's edit lock.
+				- GetHeightAtPoint() and GetBoundingBox() cover the whole world.
+
+Future Work:	- Cull the patches of every tile on the GPU, not just the first.
+				- Stream tiles in and out around the camera.
+				- Allow strokes across the seams, editing the tiles either side and matching their heightmaps again.
+*/
+#pragma once
+
+#include "Terrain.h"
+#include "TerrainTiles.h"
+#include <vector>
+
+class TerrainWorld {
+public:
+	// Load a numX x numY world from the heightmaps listed in fnHeightMaps, row by row. Takes ownership of mat.
+	TerrainWorld(ResourceManager* rm, TerrainMaterial* mat, unsigned int numX, unsigned int numY, const char** fnHeightMaps,
+		const char* fnDisplacementMap);
+	~TerrainWorld();
+
+	// Reserve a descriptor table for every tile and write the tile's SRVs into it.
+	void CreateResourceViews();
+	// Draw the tiles inside any of numFrustums frustums of numPlanes planes each, nearest to eye first, except tile skip, if not -1.
+	// The terrain constant buffer is bound to root parameter cbvRootIndex, the SRV table to srvRootIndex, and each chunk's base vertex
+	// to the root constants at constantsRootIndex. See Terrain::DrawChunks().
+	void Draw(ID3D12GraphicsCommandList* cmdList, const XMFLOAT4* planes, unsigned int numPlanes, unsigned int numFrustums,
+		XMFLOAT3 eye, unsigned int cbvRootIndex, unsigned int srvRootIndex, unsigned int constantsRootIndex, int skip,
+		unsigned int numInstances = 1);
+	// Apply a single stroke of brush to tile t, in the tile's own coordinates, keeping the seams matched. Render thread only.
+	// Returns true if the heightmap changed.
+	bool Edit(unsigned int t, const TerrainBrush& brush);
+	// Upload the vertices of the tiles whose errors Edit() raised to match a neighbour's since the last call. Render thread only.
+	void UploadSeamErrors();
+	// Copy tile t's bounds and block bounds into the world's, after it was edited.
+	void UpdateTileBounds(unsigned int t);
+	// Print how many tiles were drawn and how often the index buffer changed since the last report.
+	void ReportDrawStats();
+
+	Terrain* GetTile(unsigned int t) { return m_listTiles[t]; }
+	unsigned int GetNumTiles() { return (unsigned int)m_listTiles.size(); }
+	unsigned int GetSRVTableIndex(unsigned int t) { return m_listSRVTables[t]; }
+	D3D12_GPU_DESCRIPTOR_HANDLE GetSRVTable(unsigned int t) { return m_listSRVHandles[t]; }
+	// Returns a box bounding every tile, in world coordinates.
+	AxisAlignedBoundingBox GetBoundingBox();
+	// Returns the block bounds of every tile, in world coordinates. See Terrain::GetBlockBounds().
+	AxisAlignedBoundingBox* GetBlockBounds() { return m_listBlockBounds.data(); }
+	unsigned int GetNumBlocks() { return (unsigned int)m_listBlockBounds.size(); }
+	// Returns the height of the displaced terrain at world (x, y), clamped to the edge of the world.
+	float GetHeightAtPoint(float x, float y);
+
+private:
+	TerrainMaterial*					m_pMat;
+	ResourceManager*					m_pResMgr;
+	TerrainTileGrid*					m_pGrid;
+	std::vector<Terrain*>				m_listTiles;
+	std::vector<unsigned int>			m_listSRVTables;		// index of each tile's descriptor table.
+	std::vector<D3D12_GPU_DESCRIPTOR_HANDLE>	m_listSRVHandles;
+	std::vector<AxisAlignedBoundingBox>	m_listBlockBounds;		// every tile's, one after the other.
+	std::vector<unsigned int>			m_listFirstBlock;		// where each tile's blocks start in m_listBlockBounds.
+	std::vector<unsigned int>			m_listVisible;			// tiles Draw() found in view, nearest first.
+	std::vector<bool>					m_listSeamErrorsChanged;	// tiles whose errors Edit() changed and not uploaded yet.
+	unsigned long long					m_numDraws;				// calls to Draw() since the last report.
+	unsigned long long					m_numTilesDrawn;
+	unsigned long long					m_numIndexBufferBinds;
+};
@@ -0,0 +1,124 @@
+/*
+TessFactors.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	CPU versions of the terrain tessellation factor calculations, driven by the projected
+				screen space error of each patch rather than by distance alone.
+*/
+#include "TessFactors.h"
+#include <cmath>
+
+// Returns the height of texel (x, y), clamped to the edge of the heightmap.
+static float SampleHeight(const unsigned char* heightmap, unsigned int w, unsigned int h, unsigned int x, unsigned int y, float scale) {
+	x = x < w ? x : w - 1;
+	y = y < h ? y : h - 1;
+	return (float)heightmap[(y * w + x) * 4] / 255.0f * scale;
+}
+
+// Returns the largest height difference between the heightmap and the bilinear surface between the heights at the corners of the
+// size x size texel region starting at (x0, y0). heightmap is 4 bytes per texel with the height in the first byte, scaled by scale / 255.
+float CalcPatchHeightError(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, unsigned int x0,
+	unsigned int y0, unsigned int size, float scale) {
+	float h00 = SampleHeight(heightmap, wHeightMap, hHeightMap, x0, y0, scale);
+	float h10 = SampleHeight(heightmap, wHeightMap, hHeightMap, x0 + size, y0, scale);
+	float h01 = SampleHeight(heightmap, wHeightMap, hHeightMap, x0, y0 + size, scale);
+	float h11 = SampleHeight(heightmap, wHeightMap, hHeightMap, x0 + size, y0 + size, scale);
+
+	float error = 0.0f;
+	for (unsigned int y = 0; y <= size; ++y) {
+		for (unsigned int x = 0; x <= size; ++x) {
+			float u = (float)x / (float)size;
+			float v = (float)y / (float)size;
+			float flat = (h00 * (1.0f - u) + h10 * u) * (1.0f - v) + (h01 * (1.0f - u) + h11 * u) * v;
+			error = fmaxf(error, fabsf(SampleHeight(heightmap, wHeightMap, hHeightMap, x0 + x, y0 + y, scale) - flat));
+		}
+	}
+
+	return error;
+}
+
+// Returns the factor that keeps the on-screen size of a world space error seen from distance at or below the target.
+// The error left after splitting an edge into f pieces is taken to fall off as error / f.
+float CalcTessFactor(float error, float distance, const TessFactorParams& params) {
+	float f = error * params.pixelsPerUnit / (fmaxf(distance, 1.0f) * params.targetPixelError);
+	return fminf(fmaxf(f, 1.0f), params.maxFactor);
+}
+
+static float Distance(XMFLOAT3 a, XMFLOAT3 b) {
+	return XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&a), XMLoadFloat3(&b))));
+}
+
+static XMFLOAT3 Midpoint(XMFLOAT3 a, XMFLOAT3 b) {
+	return XMFLOAT3(0.5f * (a.x + b.x), 0.5f * (a.y + b.y), 0.5f * (a.z + b.z));
+}
+
+// the control points at either end of each edge, in SV_TessFactor order.
+static const int EDGE_POINTS[4][2] = { { 0, 2 }, { 0, 1 }, { 1, 3 }, { 2, 3 } };
+
+// Returns the factors the hull shader produces for a patch with the provided control points and per control point errors.
+// Edges use the larger error of their two ends, so the patches on either side of an edge always agree and never crack.
+PatchTessFactors CalcPatchTessFactors(const XMFLOAT3 corners[4], const float errors[4], unsigned int skirt, const TessFactorParams& params) {
+	PatchTessFactors factors = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f } };
+	// the bottom doesn't touch the terrain and the skirts only along their top edge.
+	if (skirt == 0) return factors;
+
+	for (int e = (skirt < 5 ? 3 : 0); e < 4; ++e) {
+		XMFLOAT3 a = corners[EDGE_POINTS[e][0]];
+		XMFLOAT3 b = corners[EDGE_POINTS[e][1]];
+		float error = fmaxf(errors[EDGE_POINTS[e][0]], errors[EDGE_POINTS[e][1]]);
+		factors.edges[e] = CalcTessFactor(error, Distance(Midpoint(a, b), params.eye), params);
+	}
+	if (skirt < 5) return factors;
+
+	XMFLOAT3 c = Midpoint(Midpoint(corners[0], corners[1]), Midpoint(corners[2], corners[3]));
+	float error = fmaxf(fmaxf(errors[0], errors[1]), fmaxf(errors[2], errors[3]));
+	factors.inside[0] = CalcTessFactor(error, Distance(c, params.eye), params);
+	factors.inside[1] = factors.inside[0];
+
+	return factors;
+}
+
+// The old distance ramp: 64 up to 16 units away, falling to 1 at 256 units.
+float CalcDistanceTessFactor(float distance) {
+	float s = fminf(fmaxf((distance - 16.0f) / (256.0f - 16.0f), 0.0f), 1.0f);
+	return powf(2.0f, 6.0f * (1.0f - s));
+}
+
+// Returns the factors the old distance ramp produced for the same patch.
+PatchTessFactors CalcPatchDistanceTessFactors(const XMFLOAT3 corners[4], unsigned int skirt, XMFLOAT3 eye) {
+	PatchTessFactors factors = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 1.0f, 1.0f } };
+	if (skirt == 0) return factors;
+
+	for (int e = (skirt < 5 ? 3 : 0); e < 4; ++e) {
+		factors.edges[e] = CalcDistanceTessFactor(Distance(Midpoint(corners[EDGE_POINTS[e][0]], corners[EDGE_POINTS[e][1]]), eye));
+	}
+	if (skirt < 5) return factors;
+
+	XMFLOAT3 c = Midpoint(Midpoint(corners[0], corners[1]), Midpoint(corners[2], corners[3]));
+	factors.inside[0] = CalcDistanceTessFactor(Distance(c, eye));
+	factors.inside[1] = factors.inside[0];
+
+	return factors;
+}
+
+// fractional_even partitioning rounds every factor up to an even number of segments, with a minimum of 2.
+static unsigned int EvenSegments(float f) {
+	unsigned int n = (unsigned int)ceilf(f * 0.5f) * 2;
+	return n < 2 ? 2 : n;
+}
+
+// Returns an estimate of the number of triangles fractional_even partitioning of a quad produces for the factors.
+// The inside grid gives two triangles per cell, minus the outer ring, which is stitched to the edges with one triangle
+// per segment on either side.
+unsigned int CalcTessTriangleCount(const PatchTessFactors& factors) {
+	unsigned int u = EvenSegments(factors.inside[0]);
+	unsigned int v = EvenSegments(factors.inside[1]);
+	unsigned int count = 2 * (u - 2) * (v - 2);
+	unsigned int ring = 2 * (u - 2) + 2 * (v - 2);
+	for (int e = 0; e < 4; ++e) {
+		count += EvenSegments(factors.edges[e]);
+	}
+	return count + ring;
+}
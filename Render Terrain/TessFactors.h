@@ -0,0 +1,63 @@
+/*
+TessFactors.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	CPU versions of the terrain tessellation factor calculations, driven by the projected
+				screen space error of each patch rather than by distance alone. Only depends on DirectXMath,
+				so triangle counts can be measured without a Direct3D 12 device.
+
+Usage:			- Call CalcPatchHeightError() when building the mesh to measure how far the heightmap
+					strays from the flat patch between its corners.
+				- Call CalcPatchTessFactors() with the control points of a patch to get the same factors
+					RenderTerrainTessHS.hlsl would produce, and CalcTessTriangleCount() to estimate how many
+					triangles the tessellator turns them into.
+				- CalcDistanceTessFactor() is the old fixed distance ramp, kept for comparison.
+
+Future Work:	- Store errors for several tessellation levels rather than assuming error / factor.
+				- Take the displacement map into account per patch rather than as a constant.
+*/
+#pragma once
+
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+// the largest factor the tessellator accepts.
+static const float TESS_MAX_FACTOR = 64.0f;
+// the displacement map moves the surface up to this far, which the heightmap error doesn't see.
+static const float TESS_DISPLACEMENT_ERROR = 0.5f;
+// default largest error allowed on screen, in pixels.
+static const float TESS_TARGET_PIXEL_ERROR = 1.0f;
+
+// what the tessellation factors depend on besides the patch itself. Matches tessparams in the shaders.
+struct TessFactorParams {
+	XMFLOAT3	eye;
+	float		pixelsPerUnit;		// screen height in pixels of one world unit at a distance of one.
+	float		targetPixelError;
+	float		maxFactor;
+};
+
+// the factors for one quad patch, in the order the hull shader outputs them.
+struct PatchTessFactors {
+	float edges[4];
+	float inside[2];
+};
+
+// Returns the largest height difference between the heightmap and the bilinear surface between the heights at the corners of the
+// size x size texel region starting at (x0, y0). heightmap is 4 bytes per texel with the height in the first byte, scaled by scale / 255.
+float CalcPatchHeightError(const unsigned char* heightmap, unsigned int wHeightMap, unsigned int hHeightMap, unsigned int x0,
+	unsigned int y0, unsigned int size, float scale);
+// Returns the factor that keeps the on-screen size of a world space error seen from distance at or below the target.
+// Same as CalcTessFactor() in RenderTerrainTessHS.hlsl.
+float CalcTessFactor(float error, float distance, const TessFactorParams& params);
+// Returns the factors the hull shader produces for a patch with the provided control points and per control point errors.
+// skirt is as in Terrain's Vertex. Doesn't frustum cull.
+PatchTessFactors CalcPatchTessFactors(const XMFLOAT3 corners[4], const float errors[4], unsigned int skirt, const TessFactorParams& params);
+// Returns the factors the old distance ramp produced for the same patch.
+PatchTessFactors CalcPatchDistanceTessFactors(const XMFLOAT3 corners[4], unsigned int skirt, XMFLOAT3 eye);
+// The old distance ramp: 64 up to 16 units away, falling to 1 at 256 units.
+float CalcDistanceTessFactor(float distance);
+// Returns an estimate of the number of triangles fractional_even partitioning of a quad produces for the factors.
+unsigned int CalcTessTriangleCount(const PatchTessFactors& factors);
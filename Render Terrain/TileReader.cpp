@@ -0,0 +1,439 @@
+/*
+TileReader.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Reads blocks of files asynchronously, through io_uring on Linux or a pool of threads elsewhere.
+*/
+#include "TileReader.h"
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+// Read size bytes at offset of file fd into dst. Returns the number of bytes read, or -errno.
+static int ReadAt(int fd, unsigned char* dst, unsigned int size, unsigned long long offset) {
+#ifdef _WIN32
+	// ReadFile with an offset doesn't move the file pointer, so any number of threads can read the same file.
+	OVERLAPPED ov = {};
+	ov.Offset = (DWORD)offset;
+	ov.OffsetHigh = (DWORD)(offset >> 32);
+	DWORD num = 0;
+	if (!ReadFile((HANDLE)_get_osfhandle(fd), dst, size, &num, &ov)) {
+		return GetLastError() == ERROR_HANDLE_EOF ? 0 : -EIO;
+	}
+	return (int)num;
+#else
+	ssize_t num = pread(fd, dst, size, (off_t)offset);
+	return num < 0 ? -errno : (int)num;
+#endif
+}
+
+TileReader::TileReader(TileReaderBackend backend, unsigned int queueDepth, unsigned int numThreads) : m_backend(backend),
+	m_queueDepth(queueDepth ? queueDepth : 1), m_numInFlight(0), m_fdRing(-1), m_pSQRing(nullptr), m_pCQRing(nullptr), m_pSQEs(nullptr),
+	m_sizeSQRing(0), m_sizeCQRing(0), m_sizeSQEs(0), m_pSQTail(nullptr), m_pSQMask(nullptr), m_pSQArray(nullptr), m_pCQHead(nullptr),
+	m_pCQTail(nullptr), m_pCQMask(nullptr), m_pCQEs(nullptr), m_pIovecs(nullptr), m_isStopping(false), m_Stats() {
+	m_listSlots.resize(m_queueDepth);
+	for (unsigned int i = 0; i < m_queueDepth; ++i) {
+		m_listFreeSlots.push_back(m_queueDepth - 1 - i);
+	}
+
+	// io_uring may be missing from the kernel or blocked by a sandbox. Either way the thread pool still works.
+	if (m_backend != TILE_READER_THREAD_POOL) {
+		m_backend = InitIoUring() ? TILE_READER_IO_URING : TILE_READER_THREAD_POOL;
+	}
+
+	if (m_backend == TILE_READER_THREAD_POOL) {
+		if (numThreads == 0) numThreads = 1;
+		for (unsigned int i = 0; i < numThreads; ++i) {
+			m_listWorkers.push_back(std::thread(&TileReader::RunWorker, this));
+		}
+	}
+}
+
+TileReader::~TileReader() {
+	// the reads in flight are writing to their callers' buffers, so let them finish.
+	std::vector<TileReadCompletion> listDrain(m_queueDepth);
+	while (m_numInFlight > 0) {
+		Poll(listDrain.data(), m_queueDepth, true);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutexPool);
+		m_isStopping = true;
+	}
+	m_cvRequests.notify_all();
+	for (auto& t : m_listWorkers) {
+		t.join();
+	}
+	m_listWorkers.clear();
+
+#ifdef __linux__
+	if (m_pSQEs) munmap(m_pSQEs, m_sizeSQEs);
+	if (m_pCQRing && m_pCQRing != m_pSQRing) munmap(m_pCQRing, m_sizeCQRing);
+	if (m_pSQRing) munmap(m_pSQRing, m_sizeSQRing);
+	if (m_fdRing >= 0) close(m_fdRing);
+	delete[] (iovec*)m_pIovecs;
+#endif
+	m_pSQEs = nullptr;
+	m_pCQRing = nullptr;
+	m_pSQRing = nullptr;
+	m_pIovecs = nullptr;
+
+	for (auto fd : m_listFiles) {
+#ifdef _WIN32
+		_close(fd);
+#else
+		close(fd);
+#endif
+	}
+	m_listFiles.clear();
+}
+
+// Open fn for reading. Returns its index for TileReadRequest::file, or -1 if it couldn't be opened.
+int TileReader::Open(const char* fn) {
+#ifdef _WIN32
+	int fd = _open(fn, _O_RDONLY | _O_BINARY);
+#else
+	int fd = open(fn, O_RDONLY);
+#endif
+	if (fd < 0) return -1;
+
+	m_listFiles.push_back(fd);
+	return (int)m_listFiles.size() - 1;
+}
+
+// Start reading up to num requests. Returns the number taken, fewer than num if the queue fills up.
+unsigned int TileReader::Submit(const TileReadRequest* requests, unsigned int num) {
+	if (m_backend == TILE_READER_IO_URING) {
+		return SubmitIoUring(requests, num);
+	}
+
+	unsigned int numTaken = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutexPool);
+		for (; numTaken < num && !m_listFreeSlots.empty(); ++numTaken) {
+			unsigned int slot = m_listFreeSlots.back();
+			m_listFreeSlots.pop_back();
+			m_listSlots[slot].id = requests[numTaken].id;
+			m_listSlots[slot].tSubmit = std::chrono::high_resolution_clock::now();
+			m_queueRequests.push_back(std::make_pair(requests[numTaken], slot));
+		}
+	}
+	if (numTaken == 1) {
+		m_cvRequests.notify_one();
+	} else if (numTaken > 1) {
+		m_cvRequests.notify_all();
+	}
+
+	m_numInFlight += numTaken;
+	m_Stats.numSubmitted += numTaken;
+	return numTaken;
+}
+
+// Write up to max completed reads to completions. Returns the number written.
+// If isWaiting, waits until at least one read completes, unless none are in flight.
+unsigned int TileReader::Poll(TileReadCompletion* completions, unsigned int max, bool isWaiting) {
+	if (m_backend == TILE_READER_IO_URING) {
+		return PollIoUring(completions, max, isWaiting);
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutexPool);
+	if (isWaiting && m_numInFlight > 0) {
+		m_cvCompletions.wait(lock, [this]() { return !m_listDone.empty(); });
+	}
+
+	unsigned int num = 0;
+	auto tNow = std::chrono::high_resolution_clock::now();
+	for (; num < max && !m_listDone.empty(); ++num) {
+		PoolResult done = m_listDone.back();
+		m_listDone.pop_back();
+		Slot& slot = m_listSlots[done.slot];
+		completions[num].id = slot.id;
+		completions[num].result = done.result;
+		completions[num].msLatency = std::chrono::duration<double, std::milli>(tNow - slot.tSubmit).count();
+		m_listFreeSlots.push_back(done.slot);
+
+		m_Stats.numSystemCalls += done.numReads;
+		if (done.result < 0) {
+			++m_Stats.numFailed;
+		} else {
+			m_Stats.numBytesRead += done.result;
+		}
+	}
+
+	m_numInFlight -= num;
+	m_Stats.numCompleted += num;
+	return num;
+}
+
+// The thread pool's worker threads. Each takes a request, reads it, and queues the completion.
+void TileReader::RunWorker() {
+	std::unique_lock<std::mutex> lock(m_mutexPool);
+	for (;;) {
+		m_cvRequests.wait(lock, [this]() { return m_isStopping || !m_queueRequests.empty(); });
+		if (m_queueRequests.empty()) return;
+
+		TileReadRequest request = m_queueRequests.front().first;
+		unsigned int slot = m_queueRequests.front().second;
+		m_queueRequests.pop_front();
+		lock.unlock();
+
+		// keep reading until the whole block is in, the file ends, or a read fails.
+		PoolResult done = { slot, 0, 0 };
+		while ((unsigned int)done.result < request.size) {
+			int num = ReadAt(m_listFiles[request.file], request.dst + done.result, request.size - done.result,
+				request.offset + done.result);
+			++done.numReads;
+			if (num < 0) {
+				done.result = num;
+				break;
+			}
+			if (num == 0) break;
+			done.result += num;
+		}
+
+		lock.lock();
+		m_listDone.push_back(done);
+		m_cvCompletions.notify_one();
+	}
+}
+
+// Ask the kernel to drop the cached pages of file. Returns false if it can't.
+bool TileReader::DropPageCache(unsigned int file) {
+#ifdef __linux__
+	// only clean pages are dropped, so anything just written has to reach the disk first.
+	int fd = m_listFiles[file];
+	return fdatasync(fd) == 0 && posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+#else
+	return false;
+#endif
+}
+
+#ifdef __linux__
+// Set up the io_uring queues. Returns false if the kernel won't allow it.
+bool TileReader::InitIoUring() {
+	// liburing isn't needed for something this small. The queues are set up with the system calls directly.
+	io_uring_params params = {};
+	int fd = (int)syscall(__NR_io_uring_setup, m_queueDepth, &params);
+	if (fd < 0) return false;
+	m_fdRing = fd;
+
+	m_sizeSQRing = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	m_sizeCQRing = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	// newer kernels map both rings with one call.
+	bool isSingleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (isSingleMap) {
+		m_sizeSQRing = m_sizeSQRing > m_sizeCQRing ? m_sizeSQRing : m_sizeCQRing;
+		m_sizeCQRing = m_sizeSQRing;
+	}
+
+	void* sq = mmap(nullptr, m_sizeSQRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (sq == MAP_FAILED) return false;
+	m_pSQRing = sq;
+
+	void* cq = sq;
+	if (!isSingleMap) {
+		cq = mmap(nullptr, m_sizeCQRing, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+		if (cq == MAP_FAILED) return false;
+	}
+	m_pCQRing = cq;
+
+	m_sizeSQEs = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = mmap(nullptr, m_sizeSQEs, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) return false;
+	m_pSQEs = sqes;
+
+	m_pSQTail = (unsigned int*)((char*)sq + params.sq_off.tail);
+	m_pSQMask = (unsigned int*)((char*)sq + params.sq_off.ring_mask);
+	m_pSQArray = (unsigned int*)((char*)sq + params.sq_off.array);
+	m_pCQHead = (unsigned int*)((char*)cq + params.cq_off.head);
+	m_pCQTail = (unsigned int*)((char*)cq + params.cq_off.tail);
+	m_pCQMask = (unsigned int*)((char*)cq + params.cq_off.ring_mask);
+	m_pCQEs = (char*)cq + params.cq_off.cqes;
+	m_pIovecs = new iovec[m_queueDepth];
+
+	return true;
+}
+
+// Submit up to num requests to io_uring. Returns the number taken.
+unsigned int TileReader::SubmitIoUring(const TileReadRequest* requests, unsigned int num) {
+	auto tNow = std::chrono::high_resolution_clock::now();
+
+	unsigned int numTaken = 0;
+	for (; numTaken < num && !m_listFreeSlots.empty(); ++numTaken) {
+		unsigned int slot = m_listFreeSlots.back();
+		m_listFreeSlots.pop_back();
+		m_listSlots[slot].id = requests[numTaken].id;
+		m_listSlots[slot].tSubmit = tNow;
+		m_listSlots[slot].request = requests[numTaken];
+		m_listSlots[slot].numRead = 0;
+		PrepareIoUringRead(slot);
+	}
+	if (numTaken == 0) return 0;
+
+	m_numInFlight += numTaken;
+	m_Stats.numSubmitted += numTaken;
+	EnterIoUring();
+	return numTaken;
+}
+
+// Fill the next submission queue entry with what's left of slot's read. The kernel is told by EnterIoUring().
+void TileReader::PrepareIoUringRead(unsigned int slot) {
+	io_uring_sqe* sqes = (io_uring_sqe*)m_pSQEs;
+	iovec* iovecs = (iovec*)m_pIovecs;
+	const TileReadRequest& r = m_listSlots[slot].request;
+	unsigned int numRead = m_listSlots[slot].numRead;
+	iovecs[slot].iov_base = r.dst + numRead;
+	iovecs[slot].iov_len = r.size - numRead;
+
+	// only this thread writes the tail, so it can be read plainly. Entries already prepared come before it.
+	unsigned int i = (*m_pSQTail + (unsigned int)m_listPrepared.size()) & *m_pSQMask;
+	// READV rather than READ, which needs a 5.6 kernel.
+	io_uring_sqe* sqe = &sqes[i];
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = IORING_OP_READV;
+	sqe->fd = m_listFiles[r.file];
+	sqe->off = r.offset + numRead;
+	sqe->addr = (unsigned long long)&iovecs[slot];
+	sqe->len = 1;
+	sqe->user_data = slot;
+	m_pSQArray[i] = i;
+	m_listPrepared.push_back(slot);
+}
+
+// Hand the prepared entries to the kernel. Any it won't take are taken back and fail when next polled.
+void TileReader::EnterIoUring() {
+	unsigned int num = (unsigned int)m_listPrepared.size();
+	if (num == 0) return;
+
+	// release so the kernel sees the entries before the new tail.
+	unsigned int tail = *m_pSQTail + num;
+	__atomic_store_n(m_pSQTail, tail, __ATOMIC_RELEASE);
+	unsigned int numLeft = num;
+	int err = 0;
+	while (numLeft > 0) {
+		int ret = (int)syscall(__NR_io_uring_enter, m_fdRing, numLeft, 0, 0, nullptr, 0);
+		++m_Stats.numSystemCalls;
+		if (ret < 0) {
+			if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+			err = errno;
+			break;
+		}
+		numLeft -= (unsigned int)ret;
+	}
+
+	// the kernel takes entries in order and only looks at the tail inside io_uring_enter, so the ones it didn't
+	// take are the last numLeft, and can be taken back by moving the tail back over them.
+	if (numLeft > 0) {
+		__atomic_store_n(m_pSQTail, tail - numLeft, __ATOMIC_RELEASE);
+		for (unsigned int i = num - numLeft; i < num; ++i) {
+			m_listDone.push_back({ m_listPrepared[i], -err, 0 });
+		}
+	}
+	m_listPrepared.clear();
+}
+
+// Move completed reads out of io_uring's completion queue. Returns the number written.
+// Reads that came back short are submitted again for the rest, as the thread pool does, and only complete once they're done.
+unsigned int TileReader::PollIoUring(TileReadCompletion* completions, unsigned int max, bool isWaiting) {
+	io_uring_cqe* cqes = (io_uring_cqe*)m_pCQEs;
+	unsigned int mask = *m_pCQMask;
+	unsigned int num = 0;
+	auto complete = [&](unsigned int slot, int result) {
+		completions[num].id = m_listSlots[slot].id;
+		completions[num].result = result;
+		completions[num].msLatency = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+			m_listSlots[slot].tSubmit).count();
+		m_listFreeSlots.push_back(slot);
+		if (result < 0) ++m_Stats.numFailed;
+		++num;
+	};
+
+	// the reads the kernel wouldn't take come first, as they'll never reach the completion queue.
+	while (num < max && !m_listDone.empty()) {
+		PoolResult done = m_listDone.back();
+		m_listDone.pop_back();
+		complete(done.slot, done.result);
+	}
+
+	for (;;) {
+		unsigned int head = *m_pCQHead;
+		// acquire so the entries are read after the kernel wrote them.
+		unsigned int tail = __atomic_load_n(m_pCQTail, __ATOMIC_ACQUIRE);
+		while (head == tail && num == 0 && isWaiting && m_numInFlight > 0) {
+			syscall(__NR_io_uring_enter, m_fdRing, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			++m_Stats.numSystemCalls;
+			tail = __atomic_load_n(m_pCQTail, __ATOMIC_ACQUIRE);
+		}
+
+		for (; num < max && head != tail; ++head) {
+			const io_uring_cqe& cqe = cqes[head & mask];
+			unsigned int slot = (unsigned int)cqe.user_data;
+			Slot& s = m_listSlots[slot];
+			if (cqe.res < 0) {
+				complete(slot, cqe.res);
+				continue;
+			}
+
+			m_Stats.numBytesRead += cqe.res;
+			s.numRead += (unsigned int)cqe.res;
+			// nothing read means the end of the file.
+			if (cqe.res > 0 && s.numRead < s.request.size) {
+				PrepareIoUringRead(slot);
+			} else {
+				complete(slot, (int)s.numRead);
+			}
+		}
+		// release so the kernel doesn't reuse the entries before they were read.
+		__atomic_store_n(m_pCQHead, head, __ATOMIC_RELEASE);
+
+		bool isResubmitting = !m_listPrepared.empty();
+		EnterIoUring();
+		// if everything that came back was short, there's nothing to return yet, so wait for the rest.
+		if (!isResubmitting || num > 0 || !isWaiting || m_numInFlight == 0) break;
+	}
+
+	m_numInFlight -= num;
+	m_Stats.numCompleted += num;
+	return num;
+}
+#else
+// io_uring is Linux only.
+bool TileReader::InitIoUring() {
+	return false;
+}
+
+// io_uring is Linux only.
+unsigned int TileReader::SubmitIoUring(const TileReadRequest*, unsigned int) {
+	return 0;
+}
+
+// io_uring is Linux only.
+void TileReader::PrepareIoUringRead(unsigned int) {
+}
+
+// io_uring is Linux only.
+void TileReader::EnterIoUring() {
+}
+
+// io_uring is Linux only.
+unsigned int TileReader::PollIoUring(TileReadCompletion*, unsigned int, bool) {
+	return 0;
+}
+#endif
@@ -0,0 +1,152 @@
+/*
+TileReader.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Reads blocks of files asynchronously, for streaming terrain tiles without a thread blocked
+				on every read. On Linux the reads are batched through io_uring. Elsewhere, or where io_uring
+				isn't available, a pool of threads reads with pread (ReadFile on Windows). Doesn't depend on
+				Direct3D 12, so tools and build servers can use it.
+
+Usage:			- Create a TileReader with the backend to use, the most reads it can have in flight, and the
+					number of threads for the thread pool. TILE_READER_AUTO picks io_uring when the kernel allows it.
+					GetBackend() says which one was picked.
+				- Call Open() for each file to read from. It returns the index to put in TileReadRequest::file,
+					or -1 if the file can't be opened.
+				- Call Submit() with a batch of requests. It returns how many it took, which is fewer than asked when
+					the queue is full. The rest have to be submitted again once reads have completed. With io_uring
+					the whole batch costs one system call.
+				- Call Poll() to collect completed reads, in any order. With isWaiting set it waits for at least one
+					if any are in flight. TileReadCompletion::result is the number of bytes read, which is only short at
+					the end of a file, or -errno if the read failed. Both backends read again for the rest of a block
+					that comes back short. A read io_uring won't take fails with the error it gave.
+				- dst must stay valid until its read completes. Submit() and Poll() must be called from the same
+					thread. The destructor waits for the reads in flight.
+				- DropPageCache() asks the kernel to drop a file's cached pages, for measuring reads from a cold cache.
+				- The TileReader tests in Render Terrain Tests check both backends read back what was written, and the
+					TileReader benchmark measures their throughput and latency from a cold or warm page cache.
+
+Future Work:	- Register the files and buffers with io_uring to save the kernel looking them up on every read.
+				- Use O_DIRECT for large tiles, so reads don't push everything else out of the page cache.
+*/
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum TileReaderBackend { TILE_READER_AUTO = 0, TILE_READER_IO_URING, TILE_READER_THREAD_POOL };
+
+static const unsigned int TILE_READER_QUEUE_DEPTH = 64;		// reads in flight at most, by default.
+
+struct TileReadRequest {
+	unsigned int		id;			// returned with the completion.
+	unsigned int		file;		// index returned by Open().
+	unsigned long long	offset;		// bytes from the start of the file.
+	unsigned int		size;		// bytes to read.
+	unsigned char*		dst;
+};
+
+struct TileReadCompletion {
+	unsigned int		id;
+	int					result;		// bytes read, or -errno.
+	double				msLatency;	// from Submit() to the read completing.
+};
+
+// What a TileReader has done so far.
+struct TileReaderStats {
+	unsigned long long	numSubmitted;
+	unsigned long long	numCompleted;
+	unsigned long long	numFailed;			// completions with a negative result.
+	unsigned long long	numSystemCalls;		// io_uring_enter calls, or reads made by the thread pool.
+	unsigned long long	numBytesRead;
+};
+
+class TileReader {
+public:
+	TileReader(TileReaderBackend backend = TILE_READER_AUTO, unsigned int queueDepth = TILE_READER_QUEUE_DEPTH, unsigned int numThreads = 4);
+	~TileReader();
+
+	// Open fn for reading. Returns its index for TileReadRequest::file, or -1 if it couldn't be opened.
+	int Open(const char* fn);
+	// Start reading up to num requests. Returns the number taken, fewer than num if the queue fills up.
+	unsigned int Submit(const TileReadRequest* requests, unsigned int num);
+	// Write up to max completed reads to completions. Returns the number written.
+	// If isWaiting, waits until at least one read completes, unless none are in flight.
+	unsigned int Poll(TileReadCompletion* completions, unsigned int max, bool isWaiting);
+	// Returns the number of reads submitted and not yet returned by Poll().
+	unsigned int GetNumInFlight() const { return m_numInFlight; }
+	unsigned int GetQueueDepth() const { return m_queueDepth; }
+	TileReaderBackend GetBackend() const { return m_backend; }
+	TileReaderStats GetStats() const { return m_Stats; }
+	// Ask the kernel to drop the cached pages of file. Returns false if it can't.
+	bool DropPageCache(unsigned int file);
+
+private:
+	// a read that has been submitted. With io_uring, its index is the read's user data.
+	struct Slot {
+		unsigned int	id;
+		std::chrono::high_resolution_clock::time_point	tSubmit;
+		TileReadRequest	request;	// io_uring only. The rest of a read that came back short is submitted again from here.
+		unsigned int	numRead;	// bytes read so far.
+	};
+	// a read the thread pool has finished, or one io_uring wouldn't take.
+	struct PoolResult {
+		unsigned int	slot;
+		int				result;
+		unsigned int	numReads;	// reads it took, as a read can come back short.
+	};
+
+	// Set up the io_uring queues. Returns false if the kernel won't allow it.
+	bool InitIoUring();
+	// Submit up to num requests to io_uring. Returns the number taken.
+	unsigned int SubmitIoUring(const TileReadRequest* requests, unsigned int num);
+	// Fill the next submission queue entry with what's left of slot's read. The kernel is told by EnterIoUring().
+	void PrepareIoUringRead(unsigned int slot);
+	// Hand the prepared entries to the kernel. Any it won't take are taken back and fail when next polled.
+	void EnterIoUring();
+	// Move completed reads out of io_uring's completion queue. Returns the number written.
+	unsigned int PollIoUring(TileReadCompletion* completions, unsigned int max, bool isWaiting);
+	// The thread pool's worker threads. Each takes a request, reads it, and queues the completion.
+	void RunWorker();
+
+	TileReaderBackend				m_backend;
+	unsigned int					m_queueDepth;
+	unsigned int					m_numInFlight;
+	std::vector<int>				m_listFiles;
+	std::vector<Slot>				m_listSlots;
+	std::vector<unsigned int>		m_listFreeSlots;
+
+	// io_uring.
+	int								m_fdRing;
+	void*							m_pSQRing;
+	void*							m_pCQRing;
+	void*							m_pSQEs;
+	unsigned long long				m_sizeSQRing;
+	unsigned long long				m_sizeCQRing;
+	unsigned long long				m_sizeSQEs;
+	unsigned int*					m_pSQTail;
+	unsigned int*					m_pSQMask;
+	unsigned int*					m_pSQArray;
+	unsigned int*					m_pCQHead;
+	unsigned int*					m_pCQTail;
+	unsigned int*					m_pCQMask;
+	void*							m_pCQEs;
+	void*							m_pIovecs;		// a struct iovec per slot, which has to outlive the submission.
+	std::vector<unsigned int>		m_listPrepared;	// slots with entries in the submission queue the kernel hasn't been told about.
+
+	// thread pool. Requests and completions are handed over under m_mutexPool.
+	std::vector<std::thread>		m_listWorkers;
+	std::mutex						m_mutexPool;
+	std::condition_variable			m_cvRequests;
+	std::condition_variable			m_cvCompletions;
+	std::deque<std::pair<TileReadRequest, unsigned int>>	m_queueRequests;	// with the slot each was given.
+	std::vector<PoolResult>			m_listDone;		// with io_uring, the reads it wouldn't take.
+	bool							m_isStopping;
+
+	TileReaderStats					m_Stats;
+};
@@ -0,0 +1,269 @@
+/*
+TileStreamer.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Streams terrain tiles from a tile pack, reading through a TileReader and decoding on worker threads.
+*/
+#include "TileStreamer.h"
+#include "lodepng.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+// the first 4 bytes of a tile pack, followed by the number of tiles and the index.
+static const char TILE_PACK_MAGIC[4] = { 'T', 'P', 'A', 'K' };
+
+// Write numTiles tiles of width x height texels, 4 bytes per texel, to a tile pack. Returns false if it couldn't.
+bool WriteTilePack(const char* fn, const unsigned char* const* tiles, unsigned int numTiles, unsigned int width, unsigned int height) {
+	std::vector<unsigned char*> listPNG(numTiles, nullptr);
+	std::vector<TilePackEntry> listEntries(numTiles);
+	bool isEncoded = true;
+	unsigned long long offset = sizeof(TILE_PACK_MAGIC) + sizeof(unsigned int) + numTiles * sizeof(TilePackEntry);
+	for (unsigned int t = 0; t < numTiles; ++t) {
+		size_t size = 0;
+		isEncoded = isEncoded && lodepng_encode32(&listPNG[t], &size, tiles[t], width, height) == 0;
+		listEntries[t] = { offset, (unsigned int)size, width, height };
+		offset += size;
+	}
+
+	bool isWritten = false;
+	if (isEncoded) {
+		std::ofstream file(fn, std::ios::binary | std::ios::trunc);
+		file.write(TILE_PACK_MAGIC, sizeof(TILE_PACK_MAGIC));
+		file.write((const char*)&numTiles, sizeof(numTiles));
+		file.write((const char*)listEntries.data(), numTiles * sizeof(TilePackEntry));
+		for (unsigned int t = 0; t < numTiles; ++t) {
+			file.write((const char*)listPNG[t], listEntries[t].size);
+		}
+		isWritten = file.good();
+	}
+
+	// lodepng allocates with malloc.
+	for (auto png : listPNG) {
+		free(png);
+	}
+	return isWritten;
+}
+
+// Read the index of a tile pack. Returns false if fn isn't one.
+bool ReadTilePackIndex(const char* fn, std::vector<TilePackEntry>& list) {
+	std::ifstream file(fn, std::ios::binary);
+	char magic[sizeof(TILE_PACK_MAGIC)];
+	unsigned int numTiles = 0;
+	file.read(magic, sizeof(magic));
+	file.read((char*)&numTiles, sizeof(numTiles));
+	if (!file.good() || memcmp(magic, TILE_PACK_MAGIC, sizeof(magic)) != 0) return false;
+
+	list.resize(numTiles);
+	file.read((char*)list.data(), numTiles * sizeof(TilePackEntry));
+	return file.good();
+}
+
+TileStreamer::TileStreamer(const char* fn, TileReaderBackend backend, unsigned int queueDepth, unsigned int numDecodeThreads) :
+	m_pReader(nullptr), m_iFile(-1), m_numDecodeThreads(numDecodeThreads ? numDecodeThreads : 1), m_numOutstanding(0), m_Stats(),
+	m_isStopping(false) {
+	m_pReader = new TileReader(backend, queueDepth);
+	if (!ReadTilePackIndex(fn, m_listEntries)) {
+		m_listEntries.clear();
+		return;
+	}
+	m_iFile = m_pReader->Open(fn);
+	if (m_iFile < 0) {
+		m_listEntries.clear();
+		return;
+	}
+
+	// one job per read the reader can have in flight.
+	m_listJobs.resize(m_pReader->GetQueueDepth());
+	for (unsigned int j = 0; j < m_listJobs.size(); ++j) {
+		m_listFreeJobs.push_back((unsigned int)m_listJobs.size() - 1 - j);
+	}
+	m_listIsQueued.resize(m_listEntries.size(), false);
+
+	m_Thread = std::thread(&TileStreamer::Run, this);
+	for (unsigned int i = 0; i < m_numDecodeThreads; ++i) {
+		m_listDecoders.push_back(std::thread(&TileStreamer::RunDecoder, this));
+	}
+}
+
+TileStreamer::~TileStreamer() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isStopping = true;
+	}
+	m_cvWork.notify_all();
+	m_cvDecode.notify_all();
+	if (m_Thread.joinable()) {
+		m_Thread.join();
+	}
+	for (auto& t : m_listDecoders) {
+		t.join();
+	}
+	m_listDecoders.clear();
+
+	// waits for the reads still in flight.
+	delete m_pReader;
+	m_pReader = nullptr;
+}
+
+// Ask for tile t, ahead of pending tiles of a lower priority. Any thread.
+void TileStreamer::Request(unsigned int t, float priority) {
+	if (t >= m_listEntries.size()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_listIsQueued[t]) {
+			// still pending, so it can move up or down the queue.
+			for (auto& p : m_listPending) {
+				if (p.tile == t) p.priority = priority;
+			}
+			return;
+		}
+		m_listIsQueued[t] = true;
+		m_listPending.push_back({ t, priority, std::chrono::high_resolution_clock::now() });
+		++m_numOutstanding;
+		++m_Stats.numRequested;
+	}
+	m_cvWork.notify_one();
+}
+
+// Drop the request for tile t if it hasn't been read yet. Returns true if it was dropped. Any thread.
+bool TileStreamer::Cancel(unsigned int t) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (unsigned int i = 0; i < m_listPending.size(); ++i) {
+		if (m_listPending[i].tile != t) continue;
+
+		m_listPending.erase(m_listPending.begin() + i);
+		m_listIsQueued[t] = false;
+		--m_numOutstanding;
+		++m_Stats.numCancelled;
+		m_cvIdle.notify_all();
+		return true;
+	}
+
+	return false;
+}
+
+// Move the tiles decoded since the last call to the end of list.
+void TileStreamer::TakeReady(std::vector<StreamedTile>& list) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto& tile : m_listReady) {
+		m_listIsQueued[tile.tile] = false;
+		list.push_back(std::move(tile));
+	}
+	m_listReady.clear();
+	m_cvIdle.notify_all();
+}
+
+// Wait until every tile requested is ready for TakeReady().
+void TileStreamer::WaitIdle() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cvIdle.wait(lock, [this]() { return m_numOutstanding == 0; });
+}
+
+TileStreamStats TileStreamer::GetStats() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_Stats;
+}
+
+// The streaming thread. Submits the requests and passes completed reads on to be decoded.
+void TileStreamer::Run() {
+	std::vector<TileReadRequest> listRequests;
+	std::vector<TileReadCompletion> listCompleted(m_listJobs.size());
+
+	for (;;) {
+		// take as many pending tiles as there are free jobs.
+		listRequests.clear();
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_pReader->GetNumInFlight() == 0) {
+				m_cvWork.wait(lock, [this]() { return m_isStopping || (!m_listPending.empty() && !m_listFreeJobs.empty()); });
+				if (m_isStopping) break;
+			}
+
+			// highest priority first. Ties keep the order they were requested in.
+			std::stable_sort(m_listPending.begin(), m_listPending.end(), [](const PendingTile& a, const PendingTile& b) {
+				return a.priority > b.priority;
+			});
+			unsigned int num = (unsigned int)(m_listPending.size() < m_listFreeJobs.size() ? m_listPending.size() : m_listFreeJobs.size());
+			for (unsigned int i = 0; i < num; ++i) {
+				unsigned int j = m_listFreeJobs.back();
+				m_listFreeJobs.pop_back();
+				Job& job = m_listJobs[j];
+				job.tile = m_listPending[i].tile;
+				job.tRequest = m_listPending[i].tRequest;
+				listRequests.push_back({ j, (unsigned int)m_iFile, m_listEntries[job.tile].offset, m_listEntries[job.tile].size, nullptr });
+			}
+			m_listPending.erase(m_listPending.begin(), m_listPending.begin() + num);
+		}
+
+		// the buffers are sized outside the lock, then the whole batch is submitted at once.
+		for (auto& r : listRequests) {
+			m_listJobs[r.id].data.resize(r.size);
+			r.dst = m_listJobs[r.id].data.data();
+		}
+		if (!listRequests.empty()) {
+			m_pReader->Submit(listRequests.data(), (unsigned int)listRequests.size());
+		}
+
+		// new requests are only picked up between completions, which are milliseconds apart at worst.
+		unsigned int numCompleted = m_pReader->Poll(listCompleted.data(), (unsigned int)listCompleted.size(), true);
+		if (numCompleted == 0) continue;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_listCompleted.insert(m_listCompleted.end(), listCompleted.begin(), listCompleted.begin() + numCompleted);
+			m_Stats.reader = m_pReader->GetStats();
+		}
+		if (numCompleted == 1) {
+			m_cvDecode.notify_one();
+		} else {
+			m_cvDecode.notify_all();
+		}
+	}
+}
+
+// The decode threads. Each takes a completed read, decodes it, and adds the tile to the ready list.
+void TileStreamer::RunDecoder() {
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;) {
+		m_cvDecode.wait(lock, [this]() { return m_isStopping || !m_listCompleted.empty(); });
+		if (m_listCompleted.empty()) return;
+
+		TileReadCompletion done = m_listCompleted.back();
+		m_listCompleted.pop_back();
+		lock.unlock();
+
+		// the job is this thread's until it goes back on the free list.
+		auto tStart = std::chrono::high_resolution_clock::now();
+		Job& job = m_listJobs[done.id];
+		StreamedTile tile = {};
+		tile.tile = job.tile;
+		tile.msRead = done.msLatency;
+		unsigned char* texels = nullptr;
+		unsigned int w = 0, h = 0;
+		if (done.result == (int)job.data.size() && lodepng_decode32(&texels, &w, &h, job.data.data(), job.data.size()) == 0) {
+			tile.width = w;
+			tile.height = h;
+			tile.texels.assign(texels, texels + (size_t)w * h * 4);
+			tile.isValid = true;
+		}
+		// lodepng allocates with malloc.
+		free(texels);
+		auto tEnd = std::chrono::high_resolution_clock::now();
+		tile.msTotal = std::chrono::duration<double, std::milli>(tEnd - job.tRequest).count();
+
+		lock.lock();
+		m_listFreeJobs.push_back(done.id);
+		if (!tile.isValid) ++m_Stats.numFailed;
+		m_listReady.push_back(std::move(tile));
+		--m_numOutstanding;
+		++m_Stats.numReady;
+		m_Stats.msDecoding += std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+		m_cvWork.notify_one();
+		m_cvIdle.notify_all();
+	}
+}
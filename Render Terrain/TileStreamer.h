@@ -0,0 +1,134 @@
+/*
+TileStreamer.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Streams terrain tiles from a tile pack on a thread of its own. Reads go through a TileReader,
+				and every completed read is passed on to worker threads to decode and hand over ready to upload.
+				Doesn't depend on Direct3D 12, so tools and build servers can use it.
+
+Usage:			- A tile pack is a single file of PNG compressed tiles with an index in front. Write one with
+					WriteTilePack() from tiles of 4 bytes per texel, ie heightmap data as ResourceManager::LoadFile()
+					returns it.
+				- Create a TileStreamer with the pack, the TileReader backend, the reads to keep in flight, and the
+					number of threads to decode on. IsOpen() is false if the pack couldn't be read.
+				- Call Request() from any thread for each tile needed. Tiles with a higher priority are read first.
+					Tiles already requested and not yet taken aren't read again, but a pending one takes the new priority.
+				- Cancel() drops a request that hasn't been read yet, ie because the camera turned away. A tile whose
+					read has started is still handed over.
+				- The render thread calls TakeReady() once per frame and uploads the tiles it returns, ie with
+					ResourceManager::UploadToTextureRegion(). StreamedTile::isValid is false if the read or decode failed.
+				- WaitIdle() waits until every tile requested is ready to take. The destructor stops the thread
+					once the reads in flight have completed.
+				- The TileStreamer tests in Render Terrain Tests check packs stream back what was written, and the
+					TileStreamer benchmark measures the throughput and latency of streaming a pack from a cold or warm page cache.
+
+Future Work:	- Store tiles in a format the GPU reads directly, so they don't need decoding.
+				- Wake the streaming thread for new requests while it waits on reads, ie with an eventfd registered
+					with io_uring.
+*/
+#pragma once
+
+#include "TileReader.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// the index of a tile pack, one per tile, following the header.
+struct TilePackEntry {
+	unsigned long long	offset;		// bytes from the start of the file to the tile's PNG data.
+	unsigned int		size;		// bytes of PNG data.
+	unsigned int		width;
+	unsigned int		height;
+};
+
+// A tile decoded and ready to upload.
+struct StreamedTile {
+	unsigned int				tile;
+	unsigned int				width;
+	unsigned int				height;
+	std::vector<unsigned char>	texels;		// 4 bytes per texel, row by row.
+	bool						isValid;
+	double						msRead;		// from the read being submitted to it completing.
+	double						msTotal;	// from Request() to the tile being decoded.
+};
+
+// What a TileStreamer has done so far.
+struct TileStreamStats {
+	unsigned long long	numRequested;
+	unsigned long long	numReady;		// handed over, whether valid or not.
+	unsigned long long	numFailed;
+	unsigned long long	numCancelled;	// requests dropped by Cancel() before being read.
+	double				msDecoding;		// spent decoding, summed over the decode threads.
+	TileReaderStats		reader;
+};
+
+// Write numTiles tiles of width x height texels, 4 bytes per texel, to a tile pack. Returns false if it couldn't.
+bool WriteTilePack(const char* fn, const unsigned char* const* tiles, unsigned int numTiles, unsigned int width, unsigned int height);
+// Read the index of a tile pack. Returns false if fn isn't one.
+bool ReadTilePackIndex(const char* fn, std::vector<TilePackEntry>& list);
+
+class TileStreamer {
+public:
+	// Stream tiles from the pack fn. Reads go through a TileReader with backend and queueDepth, and are decoded on numDecodeThreads.
+	TileStreamer(const char* fn, TileReaderBackend backend, unsigned int queueDepth, unsigned int numDecodeThreads);
+	~TileStreamer();
+
+	// Ask for tile t, ahead of pending tiles of a lower priority. Any thread.
+	void Request(unsigned int t, float priority = 0.0f);
+	// Drop the request for tile t if it hasn't been read yet. Returns true if it was dropped. Any thread.
+	bool Cancel(unsigned int t);
+	// Move the tiles decoded since the last call to the end of list.
+	void TakeReady(std::vector<StreamedTile>& list);
+	// Wait until every tile requested is ready for TakeReady().
+	void WaitIdle();
+	// Ask the kernel to drop the pack's cached pages, before anything is requested. Returns false if it can't.
+	bool DropPageCache() { return m_pReader->DropPageCache((unsigned int)m_iFile); }
+
+	bool IsOpen() { return m_iFile >= 0; }
+	unsigned int GetNumTiles() { return (unsigned int)m_listEntries.size(); }
+	const TilePackEntry& GetEntry(unsigned int t) { return m_listEntries[t]; }
+	TileReaderBackend GetBackend() { return m_pReader->GetBackend(); }
+	TileStreamStats GetStats();
+
+private:
+	// a tile requested and not yet being read.
+	struct PendingTile {
+		unsigned int	tile;
+		float			priority;
+		std::chrono::high_resolution_clock::time_point	tRequest;
+	};
+	// a tile from being read to being decoded.
+	struct Job {
+		unsigned int				tile;
+		std::vector<unsigned char>	data;		// the PNG data read from the pack.
+		std::chrono::high_resolution_clock::time_point	tRequest;
+	};
+
+	// The streaming thread. Submits the requests and passes completed reads on to be decoded.
+	void Run();
+	// The decode threads. Each takes a completed read, decodes it, and adds the tile to the ready list.
+	void RunDecoder();
+
+	std::vector<TilePackEntry>		m_listEntries;
+	TileReader*						m_pReader;
+	int								m_iFile;			// the pack's index in m_pReader.
+	unsigned int					m_numDecodeThreads;
+	std::vector<Job>				m_listJobs;			// indexed by TileReadRequest::id. A job belongs to whoever holds its index.
+	std::mutex						m_mutex;			// guards everything below.
+	std::vector<unsigned int>		m_listFreeJobs;
+	std::condition_variable			m_cvWork;			// new requests or free jobs for the streaming thread.
+	std::condition_variable			m_cvDecode;			// completed reads for the decode threads.
+	std::condition_variable			m_cvIdle;
+	std::vector<TileReadCompletion>	m_listCompleted;	// reads waiting to be decoded.
+	std::vector<PendingTile>		m_listPending;		// requested, not yet read.
+	std::vector<bool>				m_listIsQueued;		// per tile, requested and not yet taken.
+	std::vector<StreamedTile>		m_listReady;
+	unsigned long long				m_numOutstanding;	// requested and not yet ready.
+	TileStreamStats					m_Stats;
+	bool							m_isStopping;
+	std::thread						m_Thread;
+	std::vector<std::thread>		m_listDecoders;
+};
@@ -0,0 +1,102 @@
+/*
+UploadPlacement.cpp
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Placement of subresources in upload buffers and a ring allocator for upload memory.
+*/
+#include "UploadPlacement.h"
+
+// Round value up to a multiple of alignment, which must be a power of two.
+unsigned long long AlignUploadOffset(unsigned long long value, unsigned long long alignment) {
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Write the placement of numSubresources subresources, starting at firstSubresource, to footprints, as if placed at baseOffset.
+// footprints may be null. Returns the total number of bytes needed, not counting baseOffset, or 0 if the description is invalid.
+unsigned long long CalcUploadFootprints(const UploadTextureDesc& desc, unsigned int firstSubresource, unsigned int numSubresources,
+	unsigned long long baseOffset, UploadFootprint* footprints) {
+	if (desc.width == 0 || desc.height == 0 || desc.depthOrArraySize == 0 || desc.mipLevels == 0 || desc.bytesPerBlock == 0 ||
+		desc.blockDim == 0) {
+		return 0;
+	}
+
+	unsigned int numArraySlices = desc.isVolume ? 1 : desc.depthOrArraySize;
+	if (firstSubresource + numSubresources > desc.mipLevels * numArraySlices) return 0;
+
+	unsigned long long total = 0;
+	unsigned long long lastRowPadding = 0;
+	for (unsigned int i = 0; i < numSubresources; ++i) {
+		unsigned int sub = firstSubresource + i;
+		unsigned int mip = sub % desc.mipLevels;
+
+		UploadFootprint fp;
+		fp.width = desc.width >> mip;
+		fp.height = desc.height >> mip;
+		fp.depth = desc.isVolume ? desc.depthOrArraySize >> mip : 1;
+		if (fp.width == 0) fp.width = 1;
+		if (fp.height == 0) fp.height = 1;
+		if (fp.depth == 0) fp.depth = 1;
+
+		// block compressed footprints are always whole blocks.
+		unsigned int blocksX = (fp.width + desc.blockDim - 1) / desc.blockDim;
+		unsigned int blocksY = (fp.height + desc.blockDim - 1) / desc.blockDim;
+		fp.width = blocksX * desc.blockDim;
+		fp.height = blocksY * desc.blockDim;
+		fp.numRows = blocksY;
+		fp.rowSizeInBytes = (unsigned long long)blocksX * desc.bytesPerBlock;
+
+		if (desc.isBuffer) {
+			// buffers are copied as is, with no alignment of their own.
+			fp.rowPitch = (unsigned int)fp.rowSizeInBytes;
+			fp.offset = total;
+		} else {
+			fp.rowPitch = (unsigned int)AlignUploadOffset(fp.rowSizeInBytes, UPLOAD_ROW_PITCH_ALIGNMENT);
+			fp.offset = AlignUploadOffset(total, UPLOAD_PLACEMENT_ALIGNMENT);
+		}
+
+		total = fp.offset + (unsigned long long)fp.rowPitch * fp.numRows * fp.depth;
+		lastRowPadding = fp.rowPitch - fp.rowSizeInBytes;
+
+		fp.offset += baseOffset;
+		if (footprints) footprints[i] = fp;
+	}
+
+	// nothing is copied from the padding at the end of the very last row, so it isn't needed.
+	return total - lastRowPadding;
+}
+
+UploadRing::UploadRing(unsigned long long size) {
+	m_size = size;
+	m_iFree = 0;
+	m_stats = {};
+}
+
+// Reserve size bytes starting on a multiple of alignment. Returns false if there isn't room left in the ring.
+// offset receives the start of the reserved space.
+bool UploadRing::Allocate(unsigned long long size, unsigned long long alignment, unsigned long long& offset) {
+	if (!Fits(size)) {
+		++m_stats.numTooLarge;
+		return false;
+	}
+
+	unsigned long long start = AlignUploadOffset(m_iFree, alignment);
+	if (start > m_size || size > m_size - start) return false;
+
+	++m_stats.numAllocations;
+	m_stats.bytesRequested += size;
+	m_stats.bytesPadding += start - m_iFree;
+
+	offset = start;
+	m_iFree = start + size;
+	if (m_iFree > m_stats.bytesHighWater) m_stats.bytesHighWater = m_iFree;
+
+	return true;
+}
+
+// Start handing out space from the beginning of the ring again. Only call once the GPU is done with everything allocated so far.
+void UploadRing::Reset() {
+	m_iFree = 0;
+	++m_stats.numResets;
+}
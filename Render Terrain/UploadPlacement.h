@@ -0,0 +1,91 @@
+/*
+UploadPlacement.h
+
+Author:			Chris Serson
+Last Edited:	October 18, 2026
+
+Description:	Works out where each subresource of an upload lands in an upload buffer, following the
+				same rules as ID3D12Device::GetCopyableFootprints(), and hands out space in a ring of
+				upload memory. Plain C++ so it can be used and checked without a Direct3D 12 device.
+
+Usage:			- Fill in an UploadTextureDesc and call CalcUploadFootprints() to get the placement of each
+					subresource and the total number of bytes the upload needs. Every subresource starts on
+					UPLOAD_PLACEMENT_ALIGNMENT and every row on UPLOAD_ROW_PITCH_ALIGNMENT. The last row
+					of the last subresource isn't padded.
+				- Buffers are a single row, UploadTextureDesc::width bytes long, with bytesPerBlock = 1.
+				- Create an UploadRing the size of the upload buffer and call Allocate() for each upload.
+					When it returns false, wait for the GPU to finish with the buffer and call Reset().
+				- GetStats() returns how much of the ring the uploads asked for and how much was lost
+					to alignment, along with how many times the ring had to be reset.
+
+Future Work:	- Support planar formats.
+				- Let the ring wrap around to space the GPU is already done with instead of resetting.
+*/
+#pragma once
+
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT. Every subresource in an upload buffer starts on a multiple of this.
+static const unsigned long long UPLOAD_PLACEMENT_ALIGNMENT = 512;
+// D3D12_TEXTURE_DATA_PITCH_ALIGNMENT. Every row of a texture in an upload buffer starts on a multiple of this.
+static const unsigned long long UPLOAD_ROW_PITCH_ALIGNMENT = 256;
+
+// The parts of a resource description that decide its layout in an upload buffer.
+struct UploadTextureDesc {
+	unsigned int width;				// in texels, or bytes for a buffer.
+	unsigned int height;
+	unsigned int depthOrArraySize;
+	unsigned int mipLevels;
+	unsigned int bytesPerBlock;		// bytes per texel, or per 4x4 block for block compressed formats.
+	unsigned int blockDim;			// 1, or 4 for block compressed formats.
+	bool isVolume;					// depthOrArraySize is a depth rather than an array size.
+	bool isBuffer;
+};
+
+// Where a single subresource lives in an upload buffer. Matches D3D12_PLACED_SUBRESOURCE_FOOTPRINT, plus the row count and size.
+struct UploadFootprint {
+	unsigned long long	offset;
+	unsigned int		width;
+	unsigned int		height;
+	unsigned int		depth;
+	unsigned int		rowPitch;
+	unsigned int		numRows;
+	unsigned long long	rowSizeInBytes;
+};
+
+// How an UploadRing has been used.
+struct UploadRingStats {
+	unsigned long long	numAllocations;
+	unsigned long long	bytesRequested;		// bytes asked for by the uploads.
+	unsigned long long	bytesPadding;		// bytes skipped to align the start of each upload.
+	unsigned long long	bytesHighWater;		// furthest into the ring any upload reached.
+	unsigned long long	numResets;
+	unsigned long long	numTooLarge;		// uploads that could never fit in the ring.
+};
+
+// Round value up to a multiple of alignment, which must be a power of two.
+unsigned long long AlignUploadOffset(unsigned long long value, unsigned long long alignment);
+// Write the placement of numSubresources subresources, starting at firstSubresource, to footprints, as if placed at baseOffset.
+// footprints may be null. Returns the total number of bytes needed, not counting baseOffset, or 0 if the description is invalid.
+unsigned long long CalcUploadFootprints(const UploadTextureDesc& desc, unsigned int firstSubresource, unsigned int numSubresources,
+	unsigned long long baseOffset, UploadFootprint* footprints);
+
+class UploadRing {
+public:
+	UploadRing(unsigned long long size);
+
+	// Reserve size bytes starting on a multiple of alignment. Returns false if there isn't room left in the ring.
+	// offset receives the start of the reserved space.
+	bool Allocate(unsigned long long size, unsigned long long alignment, unsigned long long& offset);
+	// Start handing out space from the beginning of the ring again. Only call once the GPU is done with everything allocated so far.
+	void Reset();
+	// Returns true if an upload of size bytes can fit in the ring at all.
+	bool Fits(unsigned long long size) { return size <= m_size; }
+
+	unsigned long long GetSize() { return m_size; }
+	unsigned long long GetUsed() { return m_iFree; }
+	UploadRingStats GetStats() { return m_stats; }
+
+private:
+	unsigned long long	m_size;
+	unsigned long long	m_iFree;		// where free space starts.
+	UploadRingStats		m_stats;
+};